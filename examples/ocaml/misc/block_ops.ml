@@ -0,0 +1,109 @@
+(* Check the vector array operations of Nvector_serial.wrap_block against
+   the standard serial ones (N_V*VectorArray_Serial).
+
+   Each operation is applied through the operations of a block nvector to
+   arrays of vectors that are blocks, to arrays of separately allocated
+   vectors (for which the block kernels fall back to the standard ones),
+   and to empty arrays.  The same operation is applied to copies of the
+   arguments with the standard functions.  The results, return values, and
+   arguments must agree, up to rounding for the linear sums, whose standard
+   version handles some coefficients specially.  *)
+
+module RealArray = Sundials.RealArray
+
+type proto = Nvector_serial.t option
+
+external linear_sum : proto -> float -> Nvector_serial.t array -> float
+                      -> Nvector_serial.t array -> Nvector_serial.t array
+                      -> int
+  = "block_ops_linearsum_byte" "block_ops_linearsum"
+
+external scale : proto -> float array -> Nvector_serial.t array
+                 -> Nvector_serial.t array -> int
+  = "block_ops_scale"
+
+external const : proto -> float -> Nvector_serial.t array -> int
+  = "block_ops_const"
+
+external wrms_norm : proto -> Nvector_serial.t array
+                     -> Nvector_serial.t array -> float array -> int
+  = "block_ops_wrmsnorm"
+
+external linear_combination : proto -> float array
+                              -> Nvector_serial.t array array
+                              -> Nvector_serial.t array -> int
+  = "block_ops_linearcombination"
+
+let ns = 5
+let n = 1000
+
+type inputs = {
+  x : Nvector_serial.t array;
+  y : Nvector_serial.t array;
+  z : Nvector_serial.t array;
+  w : Nvector_serial.t array;
+  nrm : float array;
+}
+
+let fill seed vs =
+  Array.iteri (fun j v ->
+      let d = Nvector.unwrap v in
+      for i = 0 to n - 1 do d.{i} <- sin (float (i + 7 * j + 31 * seed)) done)
+    vs;
+  vs
+
+let blocks seed = fill seed (Nvector_serial.make_block ns n 0.0)
+let separate seed =
+  fill seed (Array.init ns (fun _ -> Nvector_serial.make n 0.0))
+let empty _ = [||]
+
+let inputs make =
+  let x = make 1 in
+  { x; y = make 2; z = make 3; w = make 4;
+    nrm = Array.make (Array.length x) 0.0 }
+
+let ops = [
+  "linear_sum", (fun p i -> linear_sum p 2.0 i.x (-0.5) i.y i.z);
+  "linear_sum in place", (fun p i -> linear_sum p 1.0 i.x 1.0 i.y i.x);
+  "scale", (fun p i ->
+      scale p (Array.init (Array.length i.z) (fun j -> 0.5 +. float j))
+        i.x i.z);
+  "const", (fun p i -> const p 3.25 i.z);
+  "wrms_norm", (fun p i -> wrms_norm p i.x i.w i.nrm);
+  "linear_combination", (fun p i ->
+      linear_combination p [| 1.5; -2.0; 0.25 |] [| i.x; i.y; i.w |] i.z);
+  "linear_combination in place", (fun p i ->
+      linear_combination p [| 1.5; -2.0 |] [| i.z; i.x |] i.z);
+]
+
+let close a b = abs_float (a -. b) <= 1e-15 *. (1.0 +. abs_float b)
+
+let same_vectors vs1 vs2 =
+  Array.length vs1 = Array.length vs2
+  && List.for_all2 (fun v1 v2 ->
+         List.for_all2 close (RealArray.to_list (Nvector.unwrap v1))
+                             (RealArray.to_list (Nvector.unwrap v2)))
+       (Array.to_list vs1) (Array.to_list vs2)
+
+let same i1 i2 =
+  same_vectors i1.x i2.x && same_vectors i1.y i2.y
+  && same_vectors i1.z i2.z && same_vectors i1.w i2.w
+  && List.for_all2 close (Array.to_list i1.nrm) (Array.to_list i2.nrm)
+
+let () =
+  try
+    let proto = Some (Nvector_serial.make_block 1 n 0.0).(0) in
+    let bad = ref 0 in
+    List.iter (fun (name, op) ->
+        List.iter (fun (layout, make) ->
+            let i1 = inputs make and i2 = inputs make in
+            let r1 = op proto i1 and r2 = op None i2 in
+            let ok = r1 = r2 && same i1 i2 in
+            Printf.printf "%-28s %-9s %s\n" name layout
+              (if ok then "ok" else "DIFFERENT");
+            if not ok then incr bad)
+          ["blocks", blocks; "separate", separate; "empty", empty])
+      ops;
+    if !bad > 0 then exit 1
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 4.0.0"
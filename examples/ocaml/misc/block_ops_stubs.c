@@ -0,0 +1,127 @@
+/* Vector array operations called through the operations of a given
+   nvector, or the standard serial ones, for block_ops.ml.  */
+
+#include <stdlib.h>
+
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <caml/fail.h>
+#include <sundials/sundials_nvector.h>
+#include <nvector/nvector_serial.h>
+
+#include "sundials/sundials_ml.h"
+#include "nvectors/nvector_ml.h"
+
+/* The operations of vproto (Some nv), or NULL for the serial ones (None).  */
+static N_Vector_Ops ops_of(value vproto)
+{
+    return Is_block(vproto) ? NVEC_VAL(Field(vproto, 0))->ops : NULL;
+}
+
+/* A C array of the nvectors of an OCaml array, with at least one slot.  */
+static N_Vector *nvectors(value va)
+{
+    mlsize_t n = Wosize_val(va), i;
+    N_Vector *r = malloc((n > 0 ? n : 1) * sizeof(N_Vector));
+
+    if (r == NULL) caml_raise_out_of_memory();
+    for (i = 0; i < n; ++i) r[i] = NVEC_VAL(Field(va, i));
+    return r;
+}
+
+/* A C copy of an OCaml float array, with at least one slot.  */
+static realtype *reals(value va)
+{
+    mlsize_t n = Wosize_val(va) / Double_wosize, i;
+    realtype *r = malloc((n > 0 ? n : 1) * sizeof(realtype));
+
+    if (r == NULL) caml_raise_out_of_memory();
+    for (i = 0; i < n; ++i) r[i] = Double_field(va, i);
+    return r;
+}
+
+value block_ops_linearsum(value vproto, value va, value vx, value vb,
+			  value vy, value vz)
+{
+    CAMLparam5(vproto, va, vx, vb, vy);
+    CAMLxparam1(vz);
+    N_Vector_Ops ops = ops_of(vproto);
+    int nvec = Wosize_val(vz), r;
+    N_Vector *x = nvectors(vx), *y = nvectors(vy), *z = nvectors(vz);
+
+    r = (ops ? ops->nvlinearsumvectorarray : N_VLinearSumVectorArray_Serial)
+	    (nvec, Double_val(va), x, Double_val(vb), y, z);
+    free(x); free(y); free(z);
+    CAMLreturn(Val_int(r));
+}
+
+value block_ops_linearsum_byte(value *argv, int argn)
+{
+    return block_ops_linearsum(argv[0], argv[1], argv[2], argv[3], argv[4],
+			       argv[5]);
+}
+
+value block_ops_scale(value vproto, value vc, value vx, value vz)
+{
+    CAMLparam4(vproto, vc, vx, vz);
+    N_Vector_Ops ops = ops_of(vproto);
+    int nvec = Wosize_val(vz), r;
+    N_Vector *x = nvectors(vx), *z = nvectors(vz);
+    realtype *c = reals(vc);
+
+    r = (ops ? ops->nvscalevectorarray : N_VScaleVectorArray_Serial)
+	    (nvec, c, x, z);
+    free(x); free(z); free(c);
+    CAMLreturn(Val_int(r));
+}
+
+value block_ops_const(value vproto, value vc, value vz)
+{
+    CAMLparam3(vproto, vc, vz);
+    N_Vector_Ops ops = ops_of(vproto);
+    int nvec = Wosize_val(vz), r;
+    N_Vector *z = nvectors(vz);
+
+    r = (ops ? ops->nvconstvectorarray : N_VConstVectorArray_Serial)
+	    (nvec, Double_val(vc), z);
+    free(z);
+    CAMLreturn(Val_int(r));
+}
+
+/* Stores the norms in vnrm, which has one element per vector.  */
+value block_ops_wrmsnorm(value vproto, value vx, value vw, value vnrm)
+{
+    CAMLparam4(vproto, vx, vw, vnrm);
+    N_Vector_Ops ops = ops_of(vproto);
+    int nvec = Wosize_val(vx), r, j;
+    N_Vector *x = nvectors(vx), *w = nvectors(vw);
+    realtype *nrm = reals(vnrm);
+
+    r = (ops ? ops->nvwrmsnormvectorarray : N_VWrmsNormVectorArray_Serial)
+	    (nvec, x, w, nrm);
+    for (j = 0; j < nvec; ++j) Store_double_field(vnrm, j, nrm[j]);
+    free(x); free(w); free(nrm);
+    CAMLreturn(Val_int(r));
+}
+
+/* vxx is an array of nsum arrays of nvectors.  */
+value block_ops_linearcombination(value vproto, value vc, value vxx,
+				  value vz)
+{
+    CAMLparam4(vproto, vc, vxx, vz);
+    N_Vector_Ops ops = ops_of(vproto);
+    int nvec = Wosize_val(vz), nsum = Wosize_val(vxx), r, j;
+    N_Vector **xx = malloc((nsum > 0 ? nsum : 1) * sizeof(N_Vector *));
+    N_Vector *z = nvectors(vz);
+    realtype *c = reals(vc);
+
+    if (xx == NULL) caml_raise_out_of_memory();
+    for (j = 0; j < nsum; ++j) xx[j] = nvectors(Field(vxx, j));
+    r = (ops ? ops->nvlinearcombinationvectorarray
+	     : N_VLinearCombinationVectorArray_Serial)
+	    (nvec, nsum, c, xx, z);
+    for (j = 0; j < nsum; ++j) free(xx[j]);
+    free(xx); free(z); free(c);
+    CAMLreturn(Val_int(r));
+}
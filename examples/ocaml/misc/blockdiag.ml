@@ -0,0 +1,86 @@
+(* Solve an ensemble of decoupled Robertson chemistry cells with the
+   block-diagonal matrix and linear solver, and check each cell against the
+   same cell solved alone with a dense matrix.
+
+   Cell c has the species y_3c, y_3c+1 and y_3c+2, and its first rate
+   constant is scaled by 1 + c / ncells.  *)
+
+module RealArray = Sundials.RealArray
+module RealArray2 = Sundials.RealArray2
+module Matrix = Sundials.Matrix
+module LinearSolver = Sundials.LinearSolver
+
+let ncells = 200
+let tend = 40.0
+
+let k1 c = 0.04 *. (1.0 +. float c /. float ncells)
+let k2, k3 = 1.0e4, 3.0e7
+
+let cell_rhs k1 y o yd =
+  let y1, y2, y3 = y.{o}, y.{o + 1}, y.{o + 2} in
+  yd.{o}     <- -. k1 *. y1 +. k2 *. y2 *. y3;
+  yd.{o + 2} <- k3 *. y2 *. y2;
+  yd.{o + 1} <- -. yd.{o} -. yd.{o + 2}
+
+(* Fills the Jacobian of a cell through set i j v *)
+let cell_jac k1 y o set =
+  let y2, y3 = y.{o + 1}, y.{o + 2} in
+  set 0 0 (-. k1);  set 0 1 (k2 *. y3);  set 0 2 (k2 *. y2);
+  set 2 0 0.0;      set 2 1 (2.0 *. k3 *. y2);  set 2 2 0.0;
+  set 1 0 k1;
+  set 1 1 (-. k2 *. y3 -. 2.0 *. k3 *. y2);
+  set 1 2 (-. k2 *. y2)
+
+let f _ y yd =
+  for c = 0 to ncells - 1 do cell_rhs (k1 c) y (3 * c) yd done
+
+let jac { Cvode.jac_y = y } a =
+  for c = 0 to ncells - 1 do
+    let b = Matrix.BlockDiag.block a c in
+    cell_jac (k1 c) y (3 * c) (RealArray2.set b)
+  done
+
+let init_cell y o = y.{o} <- 1.0; y.{o + 1} <- 0.0; y.{o + 2} <- 0.0
+
+let tol = Cvode.SStolerances (1e-8, 1e-12)
+
+let solve_alone c =
+  let y = RealArray.create 3 in
+  init_cell y 0;
+  let y_nv = Nvector_serial.wrap y in
+  let m = Matrix.dense 3 in
+  let jac { Cvode.jac_y = y } a =
+    cell_jac (k1 c) y 0 (Matrix.Dense.set a)
+  in
+  let s = Cvode.(init BDF tol
+                  ~lsolver:Dls.(solver ~jac (LinearSolver.Direct.dense y_nv m))
+                  (fun _ y yd -> cell_rhs (k1 c) y 0 yd) 0.0 y_nv)
+  in
+  ignore (Cvode.solve_normal s tend y_nv);
+  y
+
+let main () =
+  let y = RealArray.create (3 * ncells) in
+  for c = 0 to ncells - 1 do init_cell y (3 * c) done;
+  let y_nv = Nvector_serial.wrap y in
+  let m = Matrix.blockdiag ncells 3 in
+  let ls = LinearSolver.Direct.blockdiag y_nv m in
+  let s = Cvode.(init BDF tol ~lsolver:Dls.(solver ~jac ls) f 0.0 y_nv) in
+  ignore (Cvode.solve_normal s tend y_nv);
+
+  let maxerr = ref 0.0 in
+  for c = 0 to ncells - 1 do
+    let ya = solve_alone c in
+    for i = 0 to 2 do
+      let err = abs_float (y.{3 * c + i} -. ya.{i}) in
+      maxerr := max !maxerr (err /. (1e-6 +. abs_float ya.{i}))
+    done
+  done;
+  Printf.printf "%d cells: %d steps, %d Jacobians, max relative gap %.2e\n"
+    ncells (Cvode.get_num_steps s) (Cvode.Dls.get_num_jac_evals s) !maxerr;
+  if !maxerr > 1e-3 then (print_endline "TOO INACCURATE"; exit 1)
+
+let () =
+  try main ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 3.0.0"
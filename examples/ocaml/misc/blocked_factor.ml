@@ -0,0 +1,87 @@
+(* Check Matrix.ArrayDense.getrf and potrf against denseGETRF and densePOTRF.
+
+   The matrices are larger than the panels (64 columns) and strips (256
+   rows) of the blocked kernels, and their size is not a multiple of
+   either.  Without Lapack, the blocked kernels must give bitwise identical
+   results.  With Lapack, dgetrf and dpotrf are used instead and the
+   results need only agree to rounding.  *)
+
+module RealArray2 = Sundials.RealArray2
+module LintArray = Sundials.LintArray
+module ArrayDense = Sundials.Matrix.ArrayDense
+
+external dense_getrf : RealArray2.t -> LintArray.t -> int
+  = "blocked_factor_dense_getrf"
+
+external dense_potrf : RealArray2.t -> int
+  = "blocked_factor_dense_potrf"
+
+let n = 300
+
+let exact = not Sundials.Config.lapack_enabled
+
+(* A deterministic pseudo-random value in [-1, 1).  *)
+let entry i j =
+  let h = (i * 7919 + j * 104729 + i * j * 31) mod 65536 in
+  float h /. 32768.0 -. 1.0
+
+let general () =
+  let a = ArrayDense.create n n in
+  for i = 0 to n - 1 do
+    for j = 0 to n - 1 do ArrayDense.set a i j (entry i j) done
+  done;
+  a
+
+(* B * B^T + n I, which is symmetric positive definite.  *)
+let spd () =
+  let b = general () in
+  let a = ArrayDense.make n n 0.0 in
+  for i = 0 to n - 1 do
+    for j = 0 to i do
+      let s = ref (if i = j then float n else 0.0) in
+      for k = 0 to n - 1 do
+        s := !s +. ArrayDense.get b i k *. ArrayDense.get b j k
+      done;
+      ArrayDense.set a i j !s;
+      ArrayDense.set a j i !s
+    done
+  done;
+  a
+
+let same x y =
+  if exact then Int64.bits_of_float x = Int64.bits_of_float y
+  else abs_float (x -. y) <= 1e-10 *. (1.0 +. abs_float y)
+
+(* Compares the elements (i, j) for which keep i j holds.  *)
+let check name keep a r =
+  let bad = ref 0 in
+  for i = 0 to n - 1 do
+    for j = 0 to n - 1 do
+      if keep i j && not (same (ArrayDense.get a i j) (ArrayDense.get r i j))
+      then incr bad
+    done
+  done;
+  Printf.printf "%s: %d differences\n" name !bad;
+  !bad = 0
+
+let getrf () =
+  let a = general () in
+  let r = RealArray2.copy a in
+  let p = LintArray.make n 0 and pr = LintArray.make n 0 in
+  ArrayDense.getrf a p;
+  if dense_getrf r pr <> 0 then failwith "denseGETRF failed";
+  let pivots = p = pr in
+  if not pivots then print_endline "getrf: pivots differ";
+  check "getrf" (fun _ _ -> true) a r && pivots
+
+let potrf () =
+  let a = spd () in
+  let r = RealArray2.copy a in
+  ArrayDense.potrf a;
+  if dense_potrf r <> 0 then failwith "densePOTRF failed";
+  check "potrf" (fun i j -> i >= j) a r
+
+let () =
+  let ok_getrf = getrf () in
+  let ok_potrf = potrf () in
+  if not (ok_getrf && ok_potrf) then exit 1
@@ -0,0 +1,24 @@
+/* The unblocked Sundials factorizations, for blocked_factor.ml.  */
+
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <sundials/sundials_types.h>
+#include <sundials/sundials_dense.h>
+
+#include "sundials/sundials_ml.h"
+
+value blocked_factor_dense_getrf(value va, value vp)
+{
+    CAMLparam2(va, vp);
+    sundials_ml_index r = denseGETRF(ARRAY2_ACOLS(va), ARRAY2_NROWS(va),
+				     ARRAY2_NCOLS(va), INDEX_ARRAY(vp));
+    CAMLreturn(Val_long(r));
+}
+
+value blocked_factor_dense_potrf(value va)
+{
+    CAMLparam1(va);
+    sundials_ml_index r = densePOTRF(ARRAY2_ACOLS(va), ARRAY2_NROWS(va));
+    CAMLreturn(Val_long(r));
+}
@@ -0,0 +1,317 @@
+(* Measure the cost of calling OCaml callbacks from the solvers.
+
+   Each measurement integrates the same small problem twice, once with an
+   OCaml callback and once with a C one that does the same work (a native
+   function, see native_rhs.ml, a native preconditioner, see
+   native_prec.ml, a native Jacobian installed directly in the session, or
+   no callback at all for root functions), and reports the elapsed time of
+   each run divided by the number of callbacks in the OCaml run.  The
+   difference, overhead_ns, estimates the time spent crossing between C
+   and OCaml per callback.  The C functions are defined in
+   callperf_stubs.c.
+
+   Results are written as JSON with one measurement per line:
+
+     callperf [-repeats n] [-inner n] [-o results.json]
+
+   Two result files are compared with
+
+     callperf -compare old.json new.json [-threshold 0.25] [-slack 5.0]
+
+   which exits with status 1 if any overhead in new.json exceeds the one
+   in old.json by more than the given fraction plus an absolute slack in
+   nanoseconds.  *)
+
+module RealArray = Sundials.RealArray
+module Matrix = Sundials.Matrix
+module LinearSolver = Sundials.LinearSolver
+
+external now : unit -> float = "callperf_now"
+external decay : unit -> Sundials.cfun = "callperf_decay"
+external decay_res : unit -> Sundials.cfun = "callperf_decay_res"
+external cvode_native_jac : ('d, 'k) Cvode.session -> unit
+  = "callperf_cvode_native_jac"
+external nvop : int -> ('d, 'k) Nvector.t -> ('d, 'k) Nvector.t
+                    -> ('d, 'k) Nvector.t -> int -> float
+  = "callperf_nvop"
+
+let neqs = 10
+let tend = 20.0
+
+let repeats = ref 5
+let inner = ref 20
+let nvreps = ref 100000
+
+(* The system y_i' = -k_i y_i *)
+
+let k i = 1.0 +. float i
+
+let f _ y yd =
+  for i = 0 to neqs - 1 do
+    yd.{i} <- -. k i *. y.{i}
+  done
+
+let res _ y yp r =
+  for i = 0 to neqs - 1 do
+    r.{i} <- yp.{i} +. k i *. y.{i}
+  done
+
+let g _ _ gout = gout.{0} <- 1.0
+
+let jac _ m =
+  for i = 0 to neqs - 1 do
+    Matrix.Dense.set m i i (-. k i)
+  done
+
+(* Jacobi preconditioning of P = I - gamma J *)
+
+let psetup d _ _ gamma =
+  for i = 0 to neqs - 1 do
+    d.{i} <- 1.0 +. gamma *. k i
+  done;
+  true
+
+let psolve d _ { Cvode.Spils.rhs = r; _ } z =
+  for i = 0 to neqs - 1 do
+    z.{i} <- r.{i} /. d.{i}
+  done
+
+let native_psetup _ _ gamma d = psetup d () () gamma
+
+(* Timing *)
+
+type result = {
+  name : string;
+  calls : int;
+  ocaml_ns : float;
+  c_ns : float;
+}
+
+let overhead r = r.ocaml_ns -. r.c_ns
+
+(* The best time over !repeats of !inner calls to step, which returns
+   the number of callbacks of one run. *)
+let time step =
+  let calls = step () in
+  let best = ref infinity in
+  for _i = 1 to !repeats do
+    let t0 = now () in
+    for _j = 1 to !inner do ignore (step ()) done;
+    best := min !best ((now () -. t0) /. float !inner)
+  done;
+  !best, calls
+
+let pair name ocaml_step c_step =
+  let t_ocaml, calls = time ocaml_step in
+  let t_c, _ = time c_step in
+  let per_call t = t *. 1e9 /. float (max calls 1) in
+  { name; calls; ocaml_ns = per_call t_ocaml; c_ns = per_call t_c }
+
+let cvode init count =
+  let y = RealArray.make neqs 1.0 in
+  let y_nvec = Nvector_serial.wrap y in
+  let s = init y_nvec in
+  fun () ->
+    RealArray.fill y 1.0;
+    Cvode.reinit s 0.0 y_nvec;
+    ignore (Cvode.solve_normal s tend y_nvec);
+    count s
+
+let ida init count =
+  let y = RealArray.make neqs 1.0 in
+  let yp = RealArray.make neqs 0.0 in
+  let y_nvec = Nvector_serial.wrap y in
+  let yp_nvec = Nvector_serial.wrap yp in
+  let reset () =
+    RealArray.fill y 1.0;
+    for i = 0 to neqs - 1 do yp.{i} <- -. k i done
+  in
+  reset ();
+  let s = init y_nvec yp_nvec in
+  fun () ->
+    reset ();
+    Ida.reinit s 0.0 y_nvec yp_nvec;
+    ignore (Ida.solve_normal s tend y_nvec yp_nvec);
+    count s
+
+let erkstep init =
+  let y = RealArray.make neqs 1.0 in
+  let y_nvec = Nvector_serial.wrap y in
+  let s = init y_nvec in
+  fun () ->
+    RealArray.fill y 1.0;
+    Arkode.ERKStep.reinit s 0.0 y_nvec;
+    ignore (Arkode.ERKStep.solve_normal s tend y_nvec);
+    Arkode.ERKStep.get_num_rhs_evals s
+
+let cvode_tol = Cvode.SStolerances (1e-8, 1e-10)
+
+let cvode_rhs () =
+  let nfe = Cvode.get_num_rhs_evals in
+  pair "cvode.rhs"
+    (cvode (Cvode.init Cvode.Adams cvode_tol f 0.0) nfe)
+    (cvode (Cvode.init_cfun Cvode.Adams cvode_tol (decay ()) 0.0) nfe)
+
+let cvode_roots () =
+  pair "cvode.roots"
+    (cvode (Cvode.init_cfun Cvode.Adams cvode_tol (decay ()) ~roots:(1, g) 0.0)
+           Cvode.get_num_g_evals)
+    (cvode (Cvode.init_cfun Cvode.Adams cvode_tol (decay ()) 0.0)
+           Cvode.get_num_g_evals)
+
+(* Both runs register the OCaml Jacobian, which the C run then replaces
+   with an equivalent native one. *)
+let cvode_jac () =
+  let init native y =
+    let lsolver = Cvode.Dls.(solver ~jac (dense y (Matrix.dense neqs))) in
+    let s = Cvode.init_cfun Cvode.BDF cvode_tol ~lsolver (decay ()) 0.0 y in
+    if native then cvode_native_jac s;
+    s
+  in
+  pair "cvode.jac"
+    (cvode (init false) Cvode.Dls.get_num_jac_evals)
+    (cvode (init true) Cvode.Dls.get_num_jac_evals)
+
+let cvode_prec () =
+  let init prec y =
+    let lsolver = Cvode.Spils.(solver (spgmr y) (prec ())) in
+    Cvode.init_cfun Cvode.BDF cvode_tol ~lsolver (decay ()) 0.0 y
+  in
+  let ocaml_prec () =
+    let d = RealArray.make neqs 1.0 in
+    Cvode.Spils.prec_left ~setup:(psetup d) (psolve d)
+  in
+  let native_prec () =
+    Cvode.Spils.Native.prec_left native_psetup
+      (LinearSolver.Native.jacobi neqs)
+  in
+  pair "cvode.prec_solve"
+    (cvode (init ocaml_prec) Cvode.Spils.get_num_prec_solves)
+    (cvode (init native_prec) Cvode.Spils.get_num_prec_solves)
+
+let ida_res () =
+  let tol = Ida.SStolerances (1e-8, 1e-10) in
+  let lsolver y = Ida.Dls.(solver (dense y (Matrix.dense neqs))) in
+  pair "ida.res"
+    (ida (fun y yp -> Ida.init tol ~lsolver:(lsolver y) res 0.0 y yp)
+         Ida.get_num_res_evals)
+    (ida (fun y yp ->
+           Ida.init_cfun tol ~lsolver:(lsolver y) (decay_res ()) 0.0 y yp)
+         Ida.get_num_res_evals)
+
+let arkode_erk_rhs () =
+  let tol = Arkode.SStolerances (1e-8, 1e-10) in
+  pair "arkode.erkstep.rhs"
+    (erkstep (Arkode.ERKStep.init tol f 0.0))
+    (erkstep (Arkode.ERKStep.init_cfun tol (decay ()) 0.0))
+
+(* Nvector operations called through the generic interface: a custom
+   nvector (Nvector_array) calls back into OCaml whereas a serial one
+   does not. *)
+let nvector_ops () =
+  let custom = Array.init 3 (fun _ -> Nvector_array.wrap (Array.make neqs 1.0))
+  and serial = Array.init 3 (fun _ -> Nvector_serial.make neqs 1.0) in
+  let best v op =
+    let best = ref infinity in
+    for _i = 1 to !repeats do
+      best := min !best (nvop op v.(0) v.(1) v.(2) !nvreps)
+    done;
+    !best *. 1e9 /. float !nvreps
+  in
+  List.map (fun (op, name) ->
+      { name = "nvector." ^ name; calls = !nvreps;
+        ocaml_ns = best custom op; c_ns = best serial op })
+    [ 0, "linearsum"; 1, "const"; 2, "scale";
+      3, "dotprod"; 4, "wrmsnorm"; 5, "maxnorm" ]
+
+let measurements = [
+  cvode_rhs; cvode_roots; cvode_jac; cvode_prec; ida_res; arkode_erk_rhs
+]
+
+let run out =
+  let results =
+    List.fold_left (fun rs m ->
+        try m () :: rs
+        with Sundials.Config.NotImplementedBySundialsVersion -> rs)
+      [] measurements
+  in
+  let results = List.rev results @ nvector_ops () in
+  let (a, b, c) = Sundials.Config.sundials_version in
+  Printf.fprintf out "{\n  \"sundials\": \"%d.%d.%d\",\n" a b c;
+  Printf.fprintf out "  \"ocaml\": \"%s\",\n  \"results\": {\n"
+    Sys.ocaml_version;
+  let n = List.length results in
+  List.iteri (fun i r ->
+      Printf.fprintf out
+        "    \"%s\": {\"calls\": %d, \"ocaml_ns\": %.2f, \"c_ns\": %.2f, \
+         \"overhead_ns\": %.2f}%s\n"
+        r.name r.calls r.ocaml_ns r.c_ns (overhead r)
+        (if i < n - 1 then "," else ""))
+    results;
+  Printf.fprintf out "  }\n}\n"
+
+(* Comparison of result files *)
+
+let read_overheads file =
+  let ic = open_in file in
+  let rec loop acc =
+    match input_line ic with
+    | line ->
+        let acc =
+          try
+            Scanf.sscanf line
+              " \"%s@\": {\"calls\": %d, \"ocaml_ns\": %f, \"c_ns\": %f, \
+               \"overhead_ns\": %f}"
+              (fun name _ _ _ d -> (name, d) :: acc)
+          with Scanf.Scan_failure _ | Failure _ | End_of_file -> acc
+        in
+        loop acc
+    | exception End_of_file -> close_in ic; List.rev acc
+  in
+  loop []
+
+let compare_files threshold slack oldfile newfile =
+  let olds = read_overheads oldfile in
+  let news = read_overheads newfile in
+  let regressions = ref 0 in
+  List.iter (fun (name, d) ->
+      match List.assoc name olds with
+      | d0 ->
+          let bad = d > d0 *. (1.0 +. threshold) +. slack in
+          if bad then incr regressions;
+          Printf.printf "%-24s %10.2f %10.2f%s\n" name d0 d
+            (if bad then "  REGRESSION" else "")
+      | exception Not_found ->
+          Printf.printf "%-24s %10s %10.2f\n" name "-" d)
+    news;
+  if !regressions > 0 then exit 1
+
+let () =
+  let output = ref ""
+  and comparing = ref false
+  and threshold = ref 0.25
+  and slack = ref 5.0
+  and files = ref [] in
+  Arg.parse [
+      "-o", Arg.Set_string output, "file  write the results to file";
+      "-repeats", Arg.Set_int repeats, "n  keep the best of n timings";
+      "-inner", Arg.Set_int inner, "n  integrations per timing";
+      "-nvreps", Arg.Set_int nvreps, "n  nvector operations per timing";
+      "-compare", Arg.Set comparing, " compare two result files";
+      "-threshold", Arg.Set_float threshold,
+        "r  tolerated relative increase in overhead";
+      "-slack", Arg.Set_float slack,
+        "ns  tolerated absolute increase in overhead";
+    ]
+    (fun file -> files := file :: !files)
+    "callperf [-o file] | callperf -compare old.json new.json";
+  match !comparing, List.rev !files with
+  | false, [] ->
+      if !output = "" then run stdout
+      else begin
+        let oc = open_out !output in
+        run oc;
+        close_out oc
+      end
+  | true, [oldfile; newfile] -> compare_files !threshold !slack oldfile newfile
+  | _ -> prerr_endline "callperf: bad arguments"; exit 2
@@ -0,0 +1,141 @@
+/* C callbacks and timers for callperf.ml.
+ *
+ * The systems are y_i' = -k_i y_i (CVODE, ARKODE) and
+ * y_i' + k_i y_i = 0 (IDA) with k_i = 1 + i, as in native_rhs_stubs.c.  */
+
+#include <time.h>
+
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <sundials/sundials_types.h>
+#include <sundials/sundials_nvector.h>
+#include <nvector/nvector_serial.h>
+
+#include "sundials/sundials_ml.h"
+#include "nvectors/nvector_ml.h"
+#include "cvode/cvode_ml.h"
+
+#if 400 <= SUNDIALS_LIB_VERSION
+#include <sunmatrix/sunmatrix_dense.h>
+#include <cvode/cvode_ls.h>
+#elif 300 <= SUNDIALS_LIB_VERSION
+#include <sunmatrix/sunmatrix_dense.h>
+#include <cvode/cvode_direct.h>
+#endif
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+value callperf_now(value unit)
+{
+    return caml_copy_double(now());
+}
+
+static int decay(realtype t, N_Vector y, N_Vector ydot, void *data)
+{
+    realtype *yd  = NV_DATA_S(y);
+    realtype *ydd = NV_DATA_S(ydot);
+    sunindextype i, n = NV_LENGTH_S(y);
+
+    for (i = 0; i < n; ++i)
+	ydd[i] = -(1.0 + i) * yd[i];
+
+    return 0;
+}
+
+static int decay_res(realtype t, N_Vector y, N_Vector yp, N_Vector r,
+		     void *data)
+{
+    realtype *yd  = NV_DATA_S(y);
+    realtype *ypd = NV_DATA_S(yp);
+    realtype *rd  = NV_DATA_S(r);
+    sunindextype i, n = NV_LENGTH_S(y);
+
+    for (i = 0; i < n; ++i)
+	rd[i] = ypd[i] + (1.0 + i) * yd[i];
+
+    return 0;
+}
+
+value callperf_decay(value unit)
+{
+    return sunml_sundials_wrap_cfun(decay, NULL);
+}
+
+value callperf_decay_res(value unit)
+{
+    return sunml_sundials_wrap_cfun(decay_res, NULL);
+}
+
+#if 300 <= SUNDIALS_LIB_VERSION
+/* The same work as jac in callperf.ml: CVODE zeroes J before each call.  */
+static int decay_jac(realtype t, N_Vector y, N_Vector fy, SUNMatrix J,
+		     void *data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+    sunindextype i, n = SUNDenseMatrix_Columns(J);
+
+    for (i = 0; i < n; ++i)
+	SM_ELEMENT_D(J, i, i) = -(1.0 + i);
+
+    return 0;
+}
+#endif
+
+/* Replace the Jacobian function of a Cvode session with a dense direct
+ * linear solver by decay_jac.  */
+value callperf_cvode_native_jac(value vsession)
+{
+    CAMLparam1(vsession);
+#if 400 <= SUNDIALS_LIB_VERSION
+    CVodeSetJacFn(CVODE_MEM_FROM_ML(vsession), decay_jac);
+#elif 300 <= SUNDIALS_LIB_VERSION
+    CVDlsSetJacFn(CVODE_MEM_FROM_ML(vsession), decay_jac);
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn(Val_unit);
+}
+
+/* Apply the nvector operation op to x, y, and z reps times, through the
+ * generic N_V* interface so that custom nvectors call back into OCaml,
+ * and return the elapsed time in seconds.  */
+value callperf_nvop(value vop, value vx, value vy, value vz, value vreps)
+{
+    CAMLparam5(vop, vx, vy, vz, vreps);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector y = NVEC_VAL(vy);
+    N_Vector z = NVEC_VAL(vz);
+    long i, reps = Long_val(vreps);
+    volatile realtype r = 0.0;
+    double t0;
+
+    t0 = now();
+    switch (Int_val(vop)) {
+    case 0:
+	for (i = 0; i < reps; ++i) N_VLinearSum(0.5, x, 0.5, y, z);
+	break;
+    case 1:
+	for (i = 0; i < reps; ++i) N_VConst(1.0, z);
+	break;
+    case 2:
+	for (i = 0; i < reps; ++i) N_VScale(2.0, x, z);
+	break;
+    case 3:
+	for (i = 0; i < reps; ++i) r = N_VDotProd(x, y);
+	break;
+    case 4:
+	for (i = 0; i < reps; ++i) r = N_VWrmsNorm(x, y);
+	break;
+    case 5:
+	for (i = 0; i < reps; ++i) r = N_VMaxNorm(x);
+	break;
+    }
+    (void)r;
+
+    CAMLreturn(caml_copy_double(now() - t0));
+}
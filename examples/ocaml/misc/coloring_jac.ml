@@ -0,0 +1,83 @@
+(* Check Matrix.Coloring.jacobian and dae_jacobian against dense difference
+   quotients.
+
+   The residual of a banded DAE, with one subdiagonal and two
+   superdiagonals, is differentiated with a coloring of the band (four
+   colors), and then column by column, perturbing one variable at a time by
+   the increment documented for the coloring.  Since each row only depends
+   on the variables in the band, and the variables of a color are further
+   apart than the band is wide, the two must agree bitwise.  Outside the
+   band, the dense difference quotients must be zero.  The ODE variant
+   (jacobian) is checked in the same way with cj = 0.  *)
+
+module RealArray = Sundials.RealArray
+module Band = Sundials.Matrix.Band
+module Coloring = Sundials.Matrix.Coloring
+
+let n = 50
+let mu, ml = 2, 1
+let relinc = sqrt Sundials.Config.unit_roundoff
+let cj = 7.5
+
+(* F(y, y')_i = y'_i - (y_i-1 - 2 y_i^2 + 0.5 y_i+1 y_i+2 + sin y_i) *)
+let res (y : RealArray.t) (yp : RealArray.t) (r : RealArray.t) =
+  let get i = if i < 0 || i >= n then 0.0 else y.{i} in
+  for i = 0 to n - 1 do
+    r.{i} <- yp.{i} -. (get (i - 1) -. 2.0 *. y.{i} *. y.{i}
+                        +. 0.5 *. get (i + 1) *. get (i + 2) +. sin y.{i})
+  done
+
+(* f(y) = -F(y, 0) *)
+let fode y fy =
+  res y (RealArray.make n 0.0) fy;
+  for i = 0 to n - 1 do fy.{i} <- -. fy.{i} done
+
+(* The increment of Coloring.sparse and Coloring.band, before rounding.  *)
+let increment yj =
+  let inc = relinc *. max 1.0 (abs_float yj) in
+  if yj < 0.0 then -. inc else inc
+
+(* The column-by-column difference quotients of dF/dy + cj dF/dy'.  *)
+let dense_dq f cj y yp r =
+  let jac = Array.make_matrix n n 0.0 in
+  let rpert = RealArray.create n in
+  for j = 0 to n - 1 do
+    let ypert = RealArray.copy y and yppert = RealArray.copy yp in
+    ypert.{j} <- y.{j} +. increment y.{j};
+    let inc = ypert.{j} -. y.{j} in
+    yppert.{j} <- yp.{j} +. cj *. inc;
+    f ypert yppert rpert;
+    for i = 0 to n - 1 do jac.(i).(j) <- (rpert.{i} -. r.{i}) /. inc done
+  done;
+  jac
+
+let check name a jac =
+  let bad = ref 0 in
+  for i = 0 to n - 1 do
+    for j = 0 to n - 1 do
+      if j - i <= mu && i - j <= ml then begin
+        if Int64.bits_of_float (Band.get a i j)
+           <> Int64.bits_of_float jac.(i).(j) then incr bad
+      end else if jac.(i).(j) <> 0.0 then incr bad
+    done
+  done;
+  Printf.printf "%s: %d mismatches\n" name !bad;
+  if !bad > 0 then exit 1
+
+let () =
+  let y = RealArray.init n (fun i -> sin (float i) *. (1.0 +. float i)) in
+  let yp = RealArray.init n (fun i -> cos (float i)) in
+  let a = Band.make { Band.n; mu; smu = mu; ml } 0.0 in
+  let c = Coloring.band ~relinc a in
+  Printf.printf "%d colors\n" (Coloring.num_colors c);
+  if Coloring.num_colors c <> mu + ml + 1 then exit 1;
+
+  let r = RealArray.create n in
+  res y yp r;
+  Coloring.dae_jacobian c res cj y yp r a;
+  check "dae_jacobian" a (dense_dq res cj y yp r);
+
+  let fy = RealArray.create n in
+  fode y fy;
+  Coloring.jacobian c fode y fy a;
+  check "jacobian" a (dense_dq (fun y _ fy -> fode y fy) 0.0 y yp fy)
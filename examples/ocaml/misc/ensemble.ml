@@ -0,0 +1,53 @@
+(* Solve a parameter sweep of the logistic equation y' = r y (1 - y) with
+   Cvode.Ensemble and ARKStep.Ensemble, reusing one session for all of the
+   members, and compare the results against the exact solution.
+
+   Member j has the rate r_j = 0.5 + j / nmembers and starts from
+   y0_j = 0.1 + 0.8 j / nmembers.  *)
+
+module RealArray = Sundials.RealArray
+module RealArray2 = Sundials.RealArray2
+
+let nmembers = 100
+let tend = 3.0
+
+let rate = ref 0.0
+let rate_of j = 0.5 +. float j /. float nmembers
+let y0_of j = 0.1 +. 0.8 *. float j /. float nmembers
+
+let f _ y yd = yd.{0} <- !rate *. y.{0} *. (1.0 -. y.{0})
+
+let exact j =
+  let y0, r = y0_of j, rate_of j in
+  y0 /. (y0 +. (1.0 -. y0) *. exp (-. r *. tend))
+
+let y0 =
+  let a = RealArray2.create 1 nmembers in
+  for j = 0 to nmembers - 1 do RealArray2.set a 0 j (y0_of j) done;
+  a
+
+let prepare j = rate := rate_of j
+
+let check name yout =
+  let maxerr = ref 0.0 in
+  for j = 0 to nmembers - 1 do
+    maxerr := max !maxerr (abs_float (RealArray2.get yout 0 j -. exact j))
+  done;
+  Printf.printf "%s: max error over %d members = %.2e\n"
+    name nmembers !maxerr;
+  if !maxerr > 1e-5 then (print_endline "TOO INACCURATE"; exit 1)
+
+let () =
+  let tol = Cvode.SStolerances (1e-8, 1e-10) in
+  let y = Nvector_serial.make 1 0.0 in
+  let yout = RealArray2.create 1 nmembers in
+  let s = Cvode.(init Adams tol f 0.0 y) in
+  Cvode.Ensemble.solve ~prepare s ~t0:0.0 ~y0 ~tout:tend y yout;
+  check "Cvode" yout;
+
+  let tol = Arkode.SStolerances (1e-8, 1e-10) in
+  let y = Nvector_serial.make 1 0.0 in
+  let yout = RealArray2.create 1 nmembers in
+  let s = Arkode.ARKStep.(init (explicit f) tol 0.0 y) in
+  Arkode.ARKStep.Ensemble.solve ~prepare s ~t0:0.0 ~y0 ~tout:tend y yout;
+  check "ARKStep" yout
@@ -0,0 +1,137 @@
+(* Check Matrix.Sparse.freeze_pattern: set_to_zero, blit, resize, and
+   LinearSolver.Direct.Klu.reinit on a matrix with a frozen pattern.
+
+   The Robertson problem is integrated twice with the KLU solver: once with
+   a matrix whose Jacobian function sets the pattern and the values at each
+   call, and once with a matrix whose complete pattern is set and frozen
+   before the integration, and whose Jacobian function only updates the
+   values, through Matrix.Sparse.unwrap_data.  Midway, both solvers are
+   reinitialized with more room for nonzeros (Klu.reinit ~nnz); the frozen
+   pattern must survive, and the symbolic analysis with it.  The results of
+   the two runs must agree.  Then, on a frozen matrix,
+   - set_to_zero must clear the values but keep the pattern,
+   - blit from a matrix with the same pattern must copy the values,
+   - blit from a matrix with another pattern must copy that pattern, and
+   - thaw_pattern must restore the usual set_to_zero.  *)
+
+module RealArray = Sundials.RealArray
+module Index = Sundials.Index
+module Sparse = Matrix.Sparse
+module Klu = Sundials.LinearSolver.Direct.Klu
+
+let neq = 3
+let touts = Array.to_list (Array.init 11 (fun i -> 0.4 *. 10.0 ** float i))
+
+let f _ (y : RealArray.t) (yd : RealArray.t) =
+  let yd1 = -0.04 *. y.{0} +. 1.0e4 *. y.{1} *. y.{2}
+  and yd3 = 3.0e7 *. y.{1} *. y.{1} in
+  yd.{0} <- yd1;
+  yd.{1} <- (-. yd1 -. yd3);
+  yd.{2} <- yd3
+
+(* The Jacobian is stored as a full 3x3 matrix in column order.  *)
+let jac_values (y : RealArray.t) =
+  [| -0.04; 0.04; 0.0;
+     1.0e4 *. y.{2}; -1.0e4 *. y.{2} -. 6.0e7 *. y.{1}; 6.0e7 *. y.{1};
+     1.0e4 *. y.{1}; -1.0e4 *. y.{1}; 0.0 |]
+
+let set_pattern smat values =
+  for j = 0 to neq do Sparse.set_col smat j (neq * j) done;
+  Array.iteri (fun idx v -> Sparse.set smat idx (idx mod neq) v) values
+
+let jac_thawed { Cvode.jac_y = (y : RealArray.t) } smat =
+  set_pattern smat (jac_values y)
+
+let jac_frozen { Cvode.jac_y = (y : RealArray.t) } smat =
+  let data = Sparse.unwrap_data smat in
+  Array.iteri (fun idx v -> data.{idx} <- v) (jac_values y)
+
+let session jac smat =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0; 0.0]) in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-14; 1.0e-6] in
+  let mat = Matrix.wrap_sparse smat in
+  let ls = Sundials.LinearSolver.Direct.klu y mat in
+  let s = Cvode.(init BDF ~lsolver:Dls.(solver ~jac ls)
+                   (SVtolerances (1.0e-4, Nvector_serial.wrap abstol)) f
+                   0.0 y)
+  in
+  (fun tout -> ignore (Cvode.solve_normal s tout y);
+               RealArray.copy (Nvector.unwrap y)),
+  (fun () -> Klu.reinit ls mat ~nnz:(2 * neq * neq) ())
+
+let close a b = abs_float (a -. b) <= 1.0e-10 *. (abs_float a +. 1.0e-12)
+
+let agree y1 y2 =
+  List.for_all2 close (RealArray.to_list y1) (RealArray.to_list y2)
+
+let pattern smat =
+  let idxvals, idxptrs, _ = Sparse.unwrap smat in
+  let nnz = Index.to_int idxptrs.{neq} in
+  Array.init (neq + 1) (fun j -> Index.to_int idxptrs.{j}),
+  Array.init nnz (fun k -> Index.to_int idxvals.{k})
+
+let values smat =
+  let _, idxptrs, _ = Sparse.unwrap smat in
+  Array.init (Index.to_int idxptrs.{neq}) (Sparse.get_data smat)
+
+let fail msg = print_endline msg; exit 1
+
+let integrate () =
+  let thawed = Sparse.make Sparse.CSC neq neq (neq * neq) in
+  let frozen = Sparse.make Sparse.CSC neq neq (neq * neq) in
+  set_pattern frozen (Array.make (neq * neq) 0.0);
+  Sparse.freeze_pattern frozen;
+  let full = pattern frozen in
+  let solve_t, reinit_t = session jac_thawed thawed
+  and solve_f, reinit_f = session jac_frozen frozen in
+  List.iteri (fun i tout ->
+      if i = 5 then begin
+        reinit_t ();
+        reinit_f ();
+        if not (Sparse.is_frozen frozen) || pattern frozen <> full
+        then fail "PATTERN LOST BY REINIT"
+      end;
+      let yt = solve_t tout and yf = solve_f tout in
+      Printf.printf "t = %8.2e  y = %12.5e %12.5e %12.5e\n"
+        tout yf.{0} yf.{1} yf.{2};
+      if not (agree yt yf) then fail "FROZEN AND THAWED SESSIONS DIFFER")
+    touts
+
+let operations () =
+  let make values =
+    let a = Sparse.make Sparse.CSC neq neq (neq * neq) in
+    set_pattern a values;
+    a
+  in
+  let full = Array.init (neq * neq) (fun k -> float (k + 1)) in
+  let a = make full in
+  Sparse.freeze_pattern a;
+  let p = pattern a in
+  Sparse.set_to_zero a;
+  if pattern a <> p || Array.exists (( <> ) 0.0) (values a)
+  then fail "SET_TO_ZERO CHANGED THE PATTERN";
+  Sparse.blit ~src:(make (Array.map (( *. ) 2.0) full)) ~dst:a;
+  if pattern a <> p || values a <> Array.map (( *. ) 2.0) full
+  then fail "BLIT OF THE SAME PATTERN";
+  (* A diagonal matrix *)
+  let d = Sparse.make Sparse.CSC neq neq neq in
+  for j = 0 to neq - 1 do
+    Sparse.set_col d j j;
+    Sparse.set d j j 5.0
+  done;
+  Sparse.set_col d neq neq;
+  Sparse.blit ~src:d ~dst:a;
+  if pattern a <> pattern d || values a <> values d
+  then fail "BLIT OF ANOTHER PATTERN";
+  Sparse.thaw_pattern a;
+  Sparse.set_to_zero a;
+  if Sparse.is_frozen a || snd (pattern a) <> [||]
+  then fail "THAW";
+  print_endline "frozen operations ok"
+
+let () =
+  try
+    integrate ();
+    operations ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 3.0.0 and KLU"
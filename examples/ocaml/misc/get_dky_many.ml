@@ -0,0 +1,81 @@
+(* Check Cvode.get_dky_many and Ida.get_dky_many against get_dky.
+
+   A harmonic oscillator is integrated for a few internal steps, and the
+   interpolant and its first derivative are evaluated at several times
+   within the last step, once with a single call to get_dky_many and once
+   with a call to get_dky per time.  Each column of the array filled by
+   get_dky_many must be bitwise identical to the corresponding result of
+   get_dky.  Badly sized result arrays must be rejected with
+   Invalid_argument and times outside the last step with BadT.  *)
+
+module RealArray = Sundials.RealArray
+module RealArray2 = Sundials.RealArray2
+
+let neq = 2
+let nt = 17
+
+(* x'' = -x, as x' = v, v' = -x *)
+let f _ (y : RealArray.t) (yd : RealArray.t) =
+  yd.{0} <- y.{1};
+  yd.{1} <- -. y.{0}
+
+let res t y (yp : RealArray.t) (r : RealArray.t) =
+  f t y r;
+  for i = 0 to neq - 1 do r.{i} <- yp.{i} -. r.{i} done
+
+let rejects f = try f (); false with Invalid_argument _ -> true
+
+let check name ~get_dky ~get_dky_many ~badt ~t ~h =
+  let ts = RealArray.init nt
+             (fun i -> t -. h *. float i /. float (nt - 1)) in
+  let dky = Nvector_serial.make neq 0.0 in
+  let bad = ref 0 in
+  for k = 0 to 1 do
+    let dkys = RealArray2.make neq nt nan in
+    get_dky_many dky ts k dkys;
+    for j = 0 to nt - 1 do
+      get_dky dky ts.{j} k;
+      let d = Nvector.unwrap dky in
+      for i = 0 to neq - 1 do
+        if Int64.bits_of_float (RealArray2.get dkys i j)
+           <> Int64.bits_of_float d.{i} then incr bad
+      done
+    done
+  done;
+  Printf.printf "%s: %d times, %d mismatches\n" name nt !bad;
+  if !bad > 0 then exit 1;
+  if not (rejects (fun () ->
+            get_dky_many dky ts 0 (RealArray2.create neq (nt - 1))))
+     || not (rejects (fun () ->
+               get_dky_many dky ts 0 (RealArray2.create (neq + 1) nt)))
+  then (print_endline "BAD SIZES NOT REJECTED"; exit 1);
+  let late = RealArray.of_list [t; t +. 10.0 *. h] in
+  if not (badt (fun () ->
+            get_dky_many dky late 0 (RealArray2.create neq 2)))
+  then (print_endline "BAD TIME NOT REJECTED"; exit 1)
+
+let cvode () =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0]) in
+  let s = Cvode.(init Adams (SStolerances (1e-8, 1e-10)) f 0.0 y) in
+  for _ = 1 to 20 do ignore (Cvode.solve_one_step s 10.0 y) done;
+  check "Cvode"
+    ~get_dky:(Cvode.get_dky s) ~get_dky_many:(Cvode.get_dky_many s)
+    ~badt:(fun f -> try f (); false with Cvode.BadT -> true)
+    ~t:(Cvode.get_current_time s) ~h:(Cvode.get_last_step s)
+
+let ida () =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0]) in
+  let yp = Nvector_serial.wrap (RealArray.of_list [0.0; -1.0]) in
+  let s = Ida.(init (SStolerances (1e-8, 1e-10))
+                 ~lsolver:Dls.(solver (dense y (Matrix.dense neq)))
+                 res 0.0 y yp)
+  in
+  for _ = 1 to 20 do ignore (Ida.solve_one_step s 10.0 y yp) done;
+  check "Ida"
+    ~get_dky:(Ida.get_dky s) ~get_dky_many:(Ida.get_dky_many s)
+    ~badt:(fun f -> try f (); false with Ida.BadT -> true)
+    ~t:(Ida.get_current_time s) ~h:(Ida.get_last_step s)
+
+let () =
+  cvode ();
+  ida ()
@@ -0,0 +1,59 @@
+(* Check Iterative.spgmr_lowsync against spgmr.
+
+   A 1D reaction-diffusion equation, u_t = u_xx - u^2, is integrated twice
+   without preconditioning, once with each solver, and with a Krylov
+   subspace deep enough for the orthogonalization to matter.  The two
+   solvers compute the same iterates in exact arithmetic; in floating
+   point, their numbers of steps and linear iterations must be close, and
+   their solutions must agree to the integration tolerance.  *)
+
+module RealArray = Sundials.RealArray
+
+let n = 50
+let dx = 1.0 /. float (n + 1)
+let c = 1.0 /. (dx *. dx)
+let tend = 0.5
+let maxl = 20
+
+let f _ u ud =
+  for i = 0 to n - 1 do
+    let ul = if i = 0 then 0.0 else u.{i - 1}
+    and ur = if i = n - 1 then 0.0 else u.{i + 1} in
+    ud.{i} <- c *. (ul -. 2.0 *. u.{i} +. ur) -. u.{i} *. u.{i}
+  done
+
+let run name lsolver =
+  let u = RealArray.init n (fun i ->
+              let x = float (i + 1) *. dx in
+              16.0 *. x *. x *. (1.0 -. x) *. (1.0 -. x)) in
+  let u_nv = Nvector_serial.wrap u in
+  let s = Cvode.(init BDF (SStolerances (1e-8, 1e-10))
+                  ~lsolver:Spils.(solver (lsolver u_nv) prec_none)
+                  f 0.0 u_nv) in
+  ignore (Cvode.solve_normal s tend u_nv);
+  let steps = Cvode.get_num_steps s
+  and iters = Cvode.Spils.get_num_lin_iters s in
+  Printf.printf "%-14s %d steps, %d linear iterations, %d failures\n"
+    name steps iters (Cvode.Spils.get_num_lin_conv_fails s);
+  u, steps, iters
+
+let near a b = abs_float (float (a - b)) <= 0.05 *. float (max a b)
+
+let main () =
+  let u1, steps1, iters1 =
+    run "spgmr" (Cvode.Spils.spgmr ~maxl) in
+  let u2, steps2, iters2 =
+    run "spgmr_lowsync" (Cvode.Spils.spgmr_lowsync ~maxl) in
+  let maxerr = ref 0.0 in
+  for i = 0 to n - 1 do
+    maxerr := max !maxerr (abs_float (u1.{i} -. u2.{i}))
+  done;
+  Printf.printf "max gap %.2e\n" !maxerr;
+  if not (near steps1 steps2 && near iters1 iters2)
+  then (print_endline "ITERATION COUNTS DIFFER"; exit 1);
+  if !maxerr > 1e-6 then (print_endline "SOLUTIONS DIFFER"; exit 1)
+
+let () =
+  try main ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 4.0.0"
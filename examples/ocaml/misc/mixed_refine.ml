@@ -0,0 +1,119 @@
+(* Check the mixed-precision direct solvers against their double-precision
+   counterparts.
+
+   Each system is solved with LinearSolver.Direct.lapack_dense_mixed (or
+   lapack_band_mixed) and with lapack_dense (or lapack_band), and the
+   solutions must agree to rounding.  The systems are
+   - well conditioned, so that the single-precision factorization is refined,
+   - badly scaled, with an element beyond the range of single precision,
+   - singular in single precision but not in double precision, because
+     1 + 1e-10 rounds to 1, and
+   - singular in double precision, where both solvers must fail.
+   In the second and third cases, the mixed solvers must fall back to a
+   double-precision factorization at setup.  *)
+
+module RealArray = Sundials.RealArray
+module Matrix = Sundials.Matrix
+module LinearSolver = Sundials.LinearSolver
+module Direct = LinearSolver.Direct
+
+let n = 40
+let mu, ml = 2, 3
+
+(* A deterministic pseudo-random value in [-1, 1).  *)
+let entry i j =
+  let h = (i * 7919 + j * 104729 + i * j * 31) mod 65536 in
+  float h /. 32768.0 -. 1.0
+
+type case = Conditioned | OutOfRange | SingleSingular | Singular
+
+let case_name = function
+  | Conditioned -> "well conditioned"
+  | OutOfRange -> "out of range"
+  | SingleSingular -> "singular in single precision"
+  | Singular -> "singular"
+
+let in_band i j = j - i <= mu && i - j <= ml
+
+(* The matrices are banded, also when stored densely.  In the singular
+   cases, row 1 is a copy of row 0, but for a perturbation of 1e-10 that
+   is lost in single precision.  *)
+let value case i j =
+  let i' = if (case = SingleSingular || case = Singular) && i = 1 then 0
+           else i in
+  if not (in_band i' j) then 0.0
+  else
+    let v = if i' = j then 8.0 +. entry i' j else entry i' j in
+    match case, i, j with
+    | OutOfRange, 2, 2 -> 1e40
+    | SingleSingular, 1, 1 -> v +. 1e-10
+    | _ -> v
+
+let solve_with ls m =
+  let b = RealArray.init n (fun i -> 1.0 +. entry i 0) in
+  let b = Nvector_serial.wrap b in
+  let x = Nvector_serial.make n 0.0 in
+  LinearSolver.init ls;
+  LinearSolver.setup ls m;
+  LinearSolver.solve ls m x b 0.0;
+  Some (Nvector.unwrap x)
+
+let outcome ls m =
+  try solve_with ls m with LinearSolver.LUfactFailure -> None
+
+let compare_outcomes name case r1 r2 =
+  let ok =
+    match r1, r2 with
+    | None, None -> case = Singular
+    | Some x1, Some x2 ->
+        case <> Singular
+        && (let worst = ref 0.0 in
+            for i = 0 to n - 1 do
+              let d = abs_float (x1.{i} -. x2.{i})
+                      /. (1e-30 +. abs_float x2.{i}) in
+              worst := max !worst d
+            done;
+            !worst <= 1e-9)
+    | _ -> false
+  in
+  Printf.printf "%s, %s: %s\n" name (case_name case)
+    (match r1 with None -> "factorization failed" | Some _ -> "solved");
+  if not ok then (print_endline "MIXED AND DOUBLE SOLUTIONS DIFFER"; exit 1)
+
+let dense case =
+  let make () =
+    let m = Matrix.dense n in
+    let a = Matrix.unwrap m in
+    for i = 0 to n - 1 do
+      for j = 0 to n - 1 do Matrix.Dense.set a i j (value case i j) done
+    done;
+    m
+  in
+  let y = Nvector_serial.make n 0.0 in
+  let mm = make () and md = make () in
+  compare_outcomes "dense" case
+    (outcome (Direct.lapack_dense_mixed y mm) mm)
+    (outcome (Direct.lapack_dense y md) md)
+
+let band case =
+  let make () =
+    let m = Matrix.band ~mu ~smu:(mu + ml) ~ml n in
+    let a = Matrix.unwrap m in
+    for i = 0 to n - 1 do
+      for j = 0 to n - 1 do
+        if in_band i j then Matrix.Band.set a i j (value case i j)
+      done
+    done;
+    m
+  in
+  let y = Nvector_serial.make n 0.0 in
+  let mm = make () and md = make () in
+  compare_outcomes "band" case
+    (outcome (Direct.lapack_band_mixed y mm) mm)
+    (outcome (Direct.lapack_band y md) md)
+
+let () =
+  let cases = [Conditioned; OutOfRange; SingleSingular; Singular] in
+  try List.iter dense cases; List.iter band cases
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 3.0.0, double precision, and Lapack"
@@ -0,0 +1,100 @@
+(* Check the native operations of custom matrices (Matrix.wrap_custom
+   ~natives) against the OCaml ones.
+
+   The matrices are tridiagonal stencils stored as three coefficients per
+   row.  Their operations are written in OCaml (below) and in C
+   (native_matrix_stubs.c).  The same sequence of generic Matrix operations,
+   which go through the SUNMatrix operations, is applied to matrices that
+   use only the OCaml operations and to matrices that use the native ones
+   for every operation but the clone.  The results must agree, and none of
+   the OCaml operations replaced by a native one may be called.  *)
+
+module RealArray = Sundials.RealArray
+
+external c_zero : unit -> Sundials.cfun = "native_matrix_zero"
+external c_copy : unit -> Sundials.cfun = "native_matrix_copy"
+external c_scale_add : unit -> Sundials.cfun = "native_matrix_scale_add"
+external c_scale_addi : unit -> Sundials.cfun = "native_matrix_scale_addi"
+external c_matvec : unit -> Sundials.cfun = "native_matrix_matvec"
+external c_space : unit -> Sundials.cfun = "native_matrix_space"
+
+let n = 50
+
+(* The number of calls to the OCaml operations other than the clone.  *)
+let calls = ref 0
+
+let ops = Matrix.{
+  m_clone = (fun a -> RealArray.make (RealArray.length a) 0.0);
+  m_zero = (fun a -> incr calls; RealArray.fill a 0.0);
+  m_copy = (fun a b -> incr calls; RealArray.blit ~src:a ~dst:b);
+  m_scale_add = (fun c a b ->
+      incr calls;
+      for k = 0 to RealArray.length a - 1 do
+        a.{k} <- c *. a.{k} +. b.{k}
+      done);
+  m_scale_addi = (fun c a ->
+      incr calls;
+      for k = 0 to RealArray.length a - 1 do a.{k} <- c *. a.{k} done;
+      for i = 0 to RealArray.length a / 3 - 1 do
+        a.{3 * i + 1} <- a.{3 * i + 1} +. 1.0
+      done);
+  m_matvec = (fun a x y ->
+      incr calls;
+      let n = RealArray.length x in
+      for i = 0 to n - 1 do
+        y.{i} <- a.{3 * i + 1} *. x.{i};
+        if i > 0 then y.{i} <- y.{i} +. a.{3 * i} *. x.{i - 1};
+        if i < n - 1 then y.{i} <- y.{i} +. a.{3 * i + 2} *. x.{i + 1}
+      done);
+  m_space = (fun a -> incr calls; (RealArray.length a, 0));
+}
+
+let natives () = Matrix.[
+  Zero (c_zero ()); Copy (c_copy ()); ScaleAdd (c_scale_add ());
+  ScaleAddI (c_scale_addi ()); Matvec (c_matvec ()); Space (c_space ());
+]
+
+let stencil seed =
+  RealArray.init (3 * n) (fun k -> sin (float (k + 17 * seed)))
+
+(* Apply a sequence of operations and return the final matrices, the
+   product of the last one with a vector, and the storage sizes.  *)
+let run wrap =
+  let a = wrap (stencil 1) and b = wrap (stencil 2) in
+  let x = Nvector_serial.wrap (RealArray.init n (fun i -> cos (float i))) in
+  let y = Nvector_serial.make n 0.0 in
+  Matrix.scale_add 0.75 a b;
+  Matrix.scale_addi (-0.5) a;
+  Matrix.blit ~src:a ~dst:b;
+  Matrix.scale_addi 2.0 b;
+  Matrix.matvec b x y;
+  let space = Matrix.space a in
+  Matrix.set_to_zero a;
+  Matrix.(unwrap a, unwrap b), Nvector.unwrap y, space
+
+let close u v =
+  let ok = ref true in
+  for k = 0 to RealArray.length u - 1 do
+    if abs_float (u.{k} -. v.{k}) > 1e-14 *. (1.0 +. abs_float v.{k})
+    then ok := false
+  done;
+  !ok
+
+let () =
+  match Sundials.Config.sundials_version with
+  | 2, _, _ -> print_endline "requires Sundials >= 3.0.0"
+  | _ ->
+    calls := 0;
+    let (ao, bo), yo, so = run (Matrix.wrap_custom ops) in
+    let ocaml_calls = !calls in
+    calls := 0;
+    let (an, bn), yn, sn =
+      run (Matrix.wrap_custom ~natives:(natives ()) ops) in
+    let native_calls = !calls in
+    Printf.printf "OCaml operations called: %d (OCaml)  %d (native)\n"
+      ocaml_calls native_calls;
+    if native_calls <> 0 || ocaml_calls = 0
+    then (print_endline "OCAML OPERATIONS CALLED"; exit 1);
+    if not (close ao an && close bo bn && close yo yn) || so <> sn
+    then (print_endline "RESULTS DIFFER"; exit 1);
+    print_endline "native and OCaml operations agree"
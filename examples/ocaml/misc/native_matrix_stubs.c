@@ -0,0 +1,103 @@
+/* Native operations on the tridiagonal stencil matrices of native_matrix.ml.
+ *
+ * The payload of a matrix is a RealArray with three coefficients per row:
+ * a.{3i} = A(i, i-1), a.{3i+1} = A(i, i), and a.{3i+2} = A(i, i+1).  */
+
+#include <caml/mlvalues.h>
+#include <caml/bigarray.h>
+#include <sundials/sundials_types.h>
+#include <nvector/nvector_serial.h>
+
+#include "sundials/sundials_ml.h"
+
+#define COEFFS(v) ((realtype *)Caml_ba_data_val(v))
+#define NCOEFFS(v) (Caml_ba_array_val(v)->dim[0])
+
+static int stencil_zero(value va, void *data)
+{
+    realtype *a = COEFFS(va);
+    intnat k, len = NCOEFFS(va);
+
+    for (k = 0; k < len; ++k) a[k] = 0.0;
+    return 0;
+}
+
+static int stencil_copy(value va, value vb, void *data)
+{
+    realtype *a = COEFFS(va), *b = COEFFS(vb);
+    intnat k, len = NCOEFFS(va);
+
+    for (k = 0; k < len; ++k) b[k] = a[k];
+    return 0;
+}
+
+static int stencil_scale_add(realtype c, value va, value vb, void *data)
+{
+    realtype *a = COEFFS(va), *b = COEFFS(vb);
+    intnat k, len = NCOEFFS(va);
+
+    for (k = 0; k < len; ++k) a[k] = c * a[k] + b[k];
+    return 0;
+}
+
+static int stencil_scale_addi(realtype c, value va, void *data)
+{
+    realtype *a = COEFFS(va);
+    intnat k, len = NCOEFFS(va);
+
+    for (k = 0; k < len; ++k) a[k] *= c;
+    for (k = 1; k < len; k += 3) a[k] += 1.0;
+    return 0;
+}
+
+static int stencil_matvec(value va, N_Vector x, N_Vector y, void *data)
+{
+    realtype *a = COEFFS(va);
+    realtype *xd = NV_DATA_S(x), *yd = NV_DATA_S(y);
+    sunindextype i, n = NV_LENGTH_S(x);
+
+    for (i = 0; i < n; ++i) {
+	yd[i] = a[3 * i + 1] * xd[i];
+	if (i > 0)     yd[i] += a[3 * i] * xd[i - 1];
+	if (i < n - 1) yd[i] += a[3 * i + 2] * xd[i + 1];
+    }
+    return 0;
+}
+
+static int stencil_space(value va, long int *lenrw, long int *leniw,
+			 void *data)
+{
+    *lenrw = NCOEFFS(va);
+    *leniw = 0;
+    return 0;
+}
+
+value native_matrix_zero(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_zero, NULL);
+}
+
+value native_matrix_copy(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_copy, NULL);
+}
+
+value native_matrix_scale_add(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_scale_add, NULL);
+}
+
+value native_matrix_scale_addi(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_scale_addi, NULL);
+}
+
+value native_matrix_matvec(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_matvec, NULL);
+}
+
+value native_matrix_space(value unit)
+{
+    return sunml_sundials_wrap_cfun(stencil_space, NULL);
+}
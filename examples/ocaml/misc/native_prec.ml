@@ -0,0 +1,71 @@
+(* Integrate a 1D reaction-diffusion equation, u_t = u_xx - u^2, with the
+   SPGMR linear solver and native (C) preconditioners built from
+   P = I - gamma J: an ILU(0) factorization of the tridiagonal P, which is
+   exact here, and the Jacobi (diagonal) approximation.  Both runs must
+   agree.  *)
+
+module RealArray = Sundials.RealArray
+module Matrix = Sundials.Matrix
+module LinearSolver = Sundials.LinearSolver
+module Native = LinearSolver.Native
+
+let n = 200
+let dx = 1.0 /. float (n + 1)
+let c = 1.0 /. (dx *. dx)
+let tend = 0.5
+
+let f _ u ud =
+  for i = 0 to n - 1 do
+    let ul = if i = 0 then 0.0 else u.{i - 1}
+    and ur = if i = n - 1 then 0.0 else u.{i + 1} in
+    ud.{i} <- c *. (ul -. 2.0 *. u.{i} +. ur) -. u.{i} *. u.{i}
+  done
+
+let diag gamma u i = 1.0 -. gamma *. (-2.0 *. c -. 2.0 *. u.{i})
+
+(* P = I - gamma J in compressed rows *)
+let setup_ilu { Cvode.jac_y = u } _ gamma p =
+  let idx = ref 0 in
+  let add i j v = Matrix.Sparse.set p !idx j v; incr idx in
+  for i = 0 to n - 1 do
+    Matrix.Sparse.set_row p i !idx;
+    if i > 0 then add i (i - 1) (-. gamma *. c);
+    add i i (diag gamma u i);
+    if i < n - 1 then add i (i + 1) (-. gamma *. c)
+  done;
+  Matrix.Sparse.set_row p n !idx;
+  true
+
+let setup_jacobi { Cvode.jac_y = u } _ gamma d =
+  for i = 0 to n - 1 do d.{i} <- diag gamma u i done;
+  true
+
+let run prec =
+  let u = RealArray.init n (fun i ->
+              let x = float (i + 1) *. dx in
+              16.0 *. x *. x *. (1.0 -. x) *. (1.0 -. x)) in
+  let u_nv = Nvector_serial.wrap u in
+  let s = Cvode.(init BDF (SStolerances (1e-8, 1e-10))
+                  ~lsolver:Spils.(solver (spgmr u_nv) prec) f 0.0 u_nv) in
+  ignore (Cvode.solve_normal s tend u_nv);
+  Printf.printf "%d steps, %d linear iterations, %d preconditioner setups\n"
+    (Cvode.get_num_steps s) (Cvode.Spils.get_num_lin_iters s)
+    (Cvode.Spils.get_num_prec_evals s);
+  u
+
+let main () =
+  let p = Matrix.Sparse.make Matrix.Sparse.CSR n n (3 * n - 2) in
+  let u_ilu = run (Cvode.Spils.Native.prec_left setup_ilu (Native.ilu0 p)) in
+  let u_jac =
+    run (Cvode.Spils.Native.prec_left setup_jacobi (Native.jacobi n)) in
+  let maxerr = ref 0.0 in
+  for i = 0 to n - 1 do
+    maxerr := max !maxerr (abs_float (u_ilu.{i} -. u_jac.{i}))
+  done;
+  Printf.printf "max gap %.2e\n" !maxerr;
+  if !maxerr > 1e-5 then (print_endline "TOO INACCURATE"; exit 1)
+
+let () =
+  try main ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 2.7.0"
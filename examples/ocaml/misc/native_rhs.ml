@@ -0,0 +1,35 @@
+(* Solve the same system with an OCaml and a native right-hand side
+   function and check that the results agree.  The C function is defined in
+   native_rhs_stubs.c.
+
+   The system is y_i' = -k_i y_i with k_i = 1 + i.  *)
+
+module RealArray = Sundials.RealArray
+
+external decay : unit -> Sundials.cfun = "native_rhs_decay"
+
+let neqs = 10
+let tend = 2.0
+
+let f _ y yd =
+  for i = 0 to neqs - 1 do
+    yd.{i} <- -. (1.0 +. float i) *. y.{i}
+  done
+
+let run init =
+  let y = RealArray.make neqs 1.0 in
+  let y_nvec = Nvector_serial.wrap y in
+  let s = init y_nvec in
+  let _ = Cvode.solve_normal s tend y_nvec in
+  y, Cvode.get_num_rhs_evals s
+
+let () =
+  let tol = Cvode.SStolerances (1e-8, 1e-10) in
+  let yo, nfo = run (Cvode.init Cvode.Adams tol f 0.0) in
+  let yc, nfc = run (Cvode.init_cfun Cvode.Adams tol (decay ()) 0.0) in
+  for i = 0 to neqs - 1 do
+    Printf.printf "y[%d] = % e (OCaml)  % e (C)  exact % e\n"
+      i yo.{i} yc.{i} (exp (-. (1.0 +. float i) *. tend))
+  done;
+  Printf.printf "rhs evaluations: %d (OCaml)  %d (C)\n" nfo nfc;
+  if yo <> yc || nfo <> nfc then (print_endline "MISMATCH"; exit 1)
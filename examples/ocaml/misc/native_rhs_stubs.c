@@ -0,0 +1,26 @@
+/* A right-hand side function written in C for native_rhs.ml.
+ *
+ * The system is y_i' = -k_i y_i with k_i = 1 + i.  */
+
+#include <caml/mlvalues.h>
+#include <sundials/sundials_types.h>
+#include <nvector/nvector_serial.h>
+
+#include "sundials/sundials_ml.h"
+
+static int decay(realtype t, N_Vector y, N_Vector ydot, void *data)
+{
+    realtype *yd  = NV_DATA_S(y);
+    realtype *ydd = NV_DATA_S(ydot);
+    sunindextype i, n = NV_LENGTH_S(y);
+
+    for (i = 0; i < n; ++i)
+	ydd[i] = -(1.0 + i) * yd[i];
+
+    return 0;
+}
+
+value native_rhs_decay(value unit)
+{
+    return sunml_sundials_wrap_cfun(decay, NULL);
+}
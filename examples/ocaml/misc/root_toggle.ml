@@ -0,0 +1,72 @@
+(* Check that toggling masked root functions reports no spurious roots.
+
+   The state is y = t and there are three root functions:
+   - g0 = sin (pi y), always active, with zero-crossings at the integers,
+   - g1 = y - 1.5, inactive on [1, 2] where it crosses zero, and
+   - g2 = y - 4.5, inactive on [4.2, 4.8] where it crosses zero.
+   g1 is deactivated and reactivated just after RootsFound returns for g0.
+   g2 is deactivated and reactivated after Success returns, and the session
+   is reinitialized after its reactivation.  Neither g1 nor g2 may be
+   reported, while g0 must be reported at every integer.  A fourth root
+   function, g3 = y - 3.5, is deactivated before the first evaluation and
+   reactivated at 3, and must be reported at 3.5.  *)
+
+module RealArray = Sundials.RealArray
+module RootMask = Sundials.RootMask
+module Roots = Sundials.Roots
+
+let pi = 4.0 *. atan 1.0
+let tend = 6.0
+
+let g _ (y : RealArray.t) = function
+  | 0 -> sin (pi *. y.{0})
+  | 1 -> y.{0} -. 1.5
+  | 2 -> y.{0} -. 4.5
+  | _ -> y.{0} -. 3.5
+
+let fail msg t = Printf.printf "%s at t = %g\n" msg t; exit 1
+
+let () =
+  let m = RootMask.create 4 in
+  RootMask.set m 3 false;
+  let y = Nvector_serial.make 1 0.0 in
+  let s = Cvode.(init Adams (SStolerances (1e-10, 1e-12))
+                   (fun _ _ yd -> yd.{0} <- 1.0)
+                   ~roots:(masked_roots m g) 0.0 y)
+  in
+  let roots = Roots.create 4 in
+  let found = ref [] in
+  let rec go tout =
+    match Cvode.solve_normal s tout y with
+    | t, Cvode.RootsFound ->
+        Cvode.get_root_info s roots;
+        Printf.printf "roots at t = %.6f: %s\n" t
+          (String.concat " " (List.map (fun i ->
+               if Roots.detected roots i then string_of_int i else "-")
+               [0; 1; 2; 3]));
+        if Roots.detected roots 1 || Roots.detected roots 2
+        then fail "SPURIOUS ROOT" t;
+        found := t :: !found;
+        (* switch modes at the roots of g0 *)
+        if Roots.detected roots 0 then begin
+          let k = int_of_float (t +. 0.5) in
+          if k = 1 then RootMask.set m 1 false;
+          if k = 2 then RootMask.set m 1 true;
+          if k = 3 then RootMask.set m 3 true
+        end;
+        go tout
+    | t, _ -> t
+  in
+  ignore (go 4.2);
+  RootMask.set m 2 false;
+  let t = go 4.8 in
+  RootMask.set m 2 true;
+  Cvode.reinit s t y;
+  ignore (go tend);
+  let expected = [1.0; 2.0; 3.0; 3.5; 4.0; 5.0] in
+  let found = List.rev !found in
+  if List.length found <> List.length expected
+     || not (List.for_all2 (fun t e -> abs_float (t -. e) < 1e-6)
+               found expected)
+  then fail "WRONG ROOTS" t;
+  print_endline "no spurious roots"
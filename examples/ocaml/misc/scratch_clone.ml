@@ -0,0 +1,56 @@
+(* Check the scratch clones of Nvector_serial.wrap_with_scratch.
+
+   Vectors are cloned through their C operations, as by a solver.  While a
+   scratch directory is set, the payload of a clone must be mapped from a
+   file, must hold the values written into it across Nvector_serial.sync,
+   and it and its sub-arrays must be released safely by the garbage
+   collector once the clone is destroyed.  Without a directory, the clones
+   are allocated in memory.  *)
+
+module RealArray = Sundials.RealArray
+
+external clone_with : Nvector_serial.t -> (RealArray.t -> unit) -> bool
+  = "scratch_clone_with"
+
+let n = 100_000
+
+let dir = Filename.get_temp_dir_name ()
+
+(* Writes to the payload, flushes it, and reads it back, also through a
+   sub-array that outlives the clone.  *)
+let subs = ref []
+
+let round_trip a =
+  if RealArray.length a <> n then (print_endline "WRONG LENGTH"; exit 1);
+  for i = 0 to n - 1 do a.{i} <- float i done;
+  Nvector_serial.sync (Nvector_serial.wrap a);
+  let sub = Bigarray.Array1.sub a (n / 2) 10 in
+  subs := sub :: !subs;
+  for i = 0 to n - 1 do
+    if a.{i} <> float i then (print_endline "ROUND TRIP FAILED"; exit 1)
+  done;
+  if sub.{0} <> float (n / 2) then (print_endline "SUB-ARRAY WRONG"; exit 1)
+
+let check name expect_mapped nv =
+  let mapped = clone_with nv round_trip in
+  Printf.printf "%s: %s\n" name (if mapped then "mapped" else "in memory");
+  if mapped <> expect_mapped then (print_endline "UNEXPECTED STORAGE"; exit 1)
+
+let main () =
+  let nv = Nvector_serial.make_with_scratch dir n 0.0 in
+  check "scratch" true nv;
+  Nvector_serial.set_scratch_dir nv None;
+  check "no directory" false nv;
+  Nvector_serial.set_scratch_dir nv (Some dir);
+  for _ = 1 to 20 do check "again" true nv done;
+  (* the sub-arrays keep the mappings alive past the clones *)
+  let lost sub = sub.{9} <> float (n / 2 + 9) in
+  if List.exists lost !subs then (print_endline "SUB-ARRAY LOST"; exit 1);
+  subs := [];
+  Gc.full_major ();
+  Gc.full_major ();
+  print_endline "scratch clones released"
+
+let () =
+  try main ()
+  with Failure msg -> print_endline msg
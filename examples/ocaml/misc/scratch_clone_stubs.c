@@ -0,0 +1,33 @@
+/* Clones of nvectors through their C operations, for scratch_clone.ml.  */
+
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <caml/callback.h>
+#include <caml/fail.h>
+#include <caml/bigarray.h>
+#include <sundials/sundials_nvector.h>
+
+#include "sundials/sundials_ml.h"
+#include "nvectors/nvector_ml.h"
+
+/* Clones nv with N_VClone, passes the payload of the clone to f, and
+   destroys the clone.  Returns whether the payload was mapped from a
+   file.  */
+value scratch_clone_with(value vnv, value vf)
+{
+    CAMLparam2(vnv, vf);
+    CAMLlocal1(vpayload);
+    N_Vector c = N_VClone(NVEC_VAL(vnv));
+    int mapped;
+
+    if (c == NULL) caml_failwith("N_VClone");
+    vpayload = NVEC_BACKLINK(c);
+    mapped = (Caml_ba_array_val(vpayload)->flags & CAML_BA_MANAGED_MASK)
+		== CAML_BA_MAPPED_FILE;
+
+    caml_callback(vf, vpayload);
+    N_VDestroy(c);
+
+    CAMLreturn(Val_bool(mapped));
+}
@@ -0,0 +1,100 @@
+(* Check that two sessions can share a sparsity pattern and its KLU symbolic
+   analysis, and that the shared pattern cannot be written.
+
+   The Robertson problem is integrated three times with the KLU solver: once
+   with a matrix of its own, whose Jacobian function sets the pattern and the
+   values at each call, and twice, in alternation, with two matrices that
+   share the pattern of a common template.  The Jacobian function of the
+   latter only updates the values, through Matrix.Sparse.unwrap_data.  The
+   two sessions with a shared pattern must give bitwise identical results,
+   and these must agree with the first run.  Finally, every function that
+   writes the pattern must raise Invalid_argument on a shared matrix.  *)
+
+module RealArray = Sundials.RealArray
+module Sparse = Matrix.Sparse
+
+let neq = 3
+let touts = Array.to_list (Array.init 11 (fun i -> 0.4 *. 10.0 ** float i))
+
+let f _ (y : RealArray.t) (yd : RealArray.t) =
+  let yd1 = -0.04 *. y.{0} +. 1.0e4 *. y.{1} *. y.{2}
+  and yd3 = 3.0e7 *. y.{1} *. y.{1} in
+  yd.{0} <- yd1;
+  yd.{1} <- (-. yd1 -. yd3);
+  yd.{2} <- yd3
+
+(* The Jacobian is stored as a full 3x3 matrix in column order.  *)
+let jac_values (y : RealArray.t) =
+  [| -0.04; 0.04; 0.0;
+     1.0e4 *. y.{2}; -1.0e4 *. y.{2} -. 6.0e7 *. y.{1}; 6.0e7 *. y.{1};
+     1.0e4 *. y.{1}; -1.0e4 *. y.{1}; 0.0 |]
+
+let set_pattern smat values =
+  for j = 0 to neq do Sparse.set_col smat j (neq * j) done;
+  Array.iteri (fun idx v -> Sparse.set smat idx (idx mod neq) v) values
+
+let jac_own { Cvode.jac_y = (y : RealArray.t) } smat =
+  set_pattern smat (jac_values y)
+
+let jac_shared { Cvode.jac_y = (y : RealArray.t) } smat =
+  let data = Sparse.unwrap_data smat in
+  Array.iteri (fun idx v -> data.{idx} <- v) (jac_values y)
+
+let session jac smat =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0; 0.0]) in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-14; 1.0e-6] in
+  let s = Cvode.(init BDF
+                   ~lsolver:Dls.(solver ~jac (klu y (Matrix.wrap_sparse smat)))
+                   (SVtolerances (1.0e-4, Nvector_serial.wrap abstol)) f
+                   0.0 y)
+  in
+  fun tout -> ignore (Cvode.solve_normal s tout y);
+              RealArray.copy (Nvector.unwrap y)
+
+let same_bits a b = Int64.bits_of_float a = Int64.bits_of_float b
+
+let close a b = abs_float (a -. b) <= 1.0e-10 *. (abs_float a +. 1.0e-12)
+
+let agree p y1 y2 =
+  List.for_all2 p (RealArray.to_list y1) (RealArray.to_list y2)
+
+let rejects f = try f (); false with Invalid_argument _ -> true
+
+let () =
+  try
+    let own = Sparse.make Sparse.CSC neq neq (neq * neq) in
+    let template = Sparse.make Sparse.CSC neq neq (neq * neq) in
+    set_pattern template (Array.make (neq * neq) 0.0);
+    let a = Sparse.share_pattern template
+    and b = Sparse.share_pattern template in
+    let solve_own = session jac_own own
+    and solve_a = session jac_shared a
+    and solve_b = session jac_shared b in
+    let check tout =
+      let ya = solve_a tout in
+      let yb = solve_b tout in
+      let yo = solve_own tout in
+      Printf.printf "t = %8.2e  y = %12.5e %12.5e %12.5e\n"
+        tout ya.{0} ya.{1} ya.{2};
+      if not (agree same_bits ya yb)
+      then (print_endline "SHARED SESSIONS DIFFER"; exit 1);
+      if not (agree close ya yo)
+      then (print_endline "SHARED AND UNSHARED SESSIONS DIFFER"; exit 1)
+    in
+    List.iter check touts;
+    let writes = [
+      "unwrap",     (fun () -> ignore (Sparse.unwrap a));
+      "set",        (fun () -> Sparse.set a 0 0 1.0);
+      "set_col",    (fun () -> Sparse.set_col a 0 0);
+      "set_rowval", (fun () -> Sparse.set_rowval a 0 0);
+      "resize",     (fun () -> Sparse.resize ~nnz:16 a);
+    ] in
+    List.iter (fun (name, w) ->
+        if not (rejects w)
+        then (Printf.printf "%s NOT REJECTED\n" name; exit 1)) writes;
+    Sparse.set_data b 0 1.0;
+    if (Sparse.unwrap_data b).{0} <> 1.0 || Sparse.get_data a 0 = 1.0
+    then (print_endline "VALUES NOT SEPARATE"; exit 1);
+    print_endline "pattern writes rejected"
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 3.0.0 and KLU"
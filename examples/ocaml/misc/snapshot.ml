@@ -0,0 +1,114 @@
+(* Check that Cvode.restore and Ida.restore make an integration reproducible.
+
+   The Robertson problem is integrated, with two root functions and a dense
+   direct solver, to t = 0.4 where a snapshot is taken.  The integration is
+   continued for a while, then the snapshot is restored twice and the
+   problem is integrated to t = 4e10 after each restoration.  The two runs
+   must give bitwise identical results, even though the linear solver has
+   seen other Jacobians in between.  Finally, changing an optional input
+   after the snapshot must make restore fail.  *)
+
+module RealArray = Sundials.RealArray
+
+let nroots = 2
+let tsnap = 0.4
+let touts = Array.to_list (Array.init 11 (fun i -> 4.0 *. 10.0 ** float i))
+
+(* The times, flags, and solutions returned by the solver.  *)
+let run solve y =
+  let out = ref [] in
+  let rec go tout =
+    let t, roots = solve tout in
+    out := (t, roots, RealArray.copy y) :: !out;
+    if roots then go tout
+  in
+  List.iter go touts;
+  List.rev !out
+
+let same_bits a b = Int64.bits_of_float a = Int64.bits_of_float b
+
+let same (t1, r1, y1) (t2, r2, y2) =
+  same_bits t1 t2 && r1 = r2
+  && List.for_all2 same_bits (RealArray.to_list y1) (RealArray.to_list y2)
+
+let check name run1 run2 rejected =
+  let nroots = List.length (List.filter (fun (_, r, _) -> r) run1) in
+  Printf.printf "%s: %d outputs, %d with roots\n" name
+    (List.length run1) nroots;
+  if List.length run1 <> List.length run2 || not (List.for_all2 same run1 run2)
+  then (print_endline "RUNS DIFFER"; exit 1);
+  if nroots = 0 then (print_endline "NO ROOTS FOUND"; exit 1);
+  if not rejected then (print_endline "CHANGED OPTION NOT REJECTED"; exit 1)
+
+let rejects f = try f (); false with Invalid_argument _ -> true
+
+let g _ (y : RealArray.t) (gout : RealArray.t) =
+  gout.{0} <- y.{0} -. 0.0001;
+  gout.{1} <- y.{2} -. 0.01
+
+let cvode () =
+  let f _ (y : RealArray.t) (yd : RealArray.t) =
+    let yd1 = -0.04 *. y.{0} +. 1.0e4 *. y.{1} *. y.{2}
+    and yd3 = 3.0e7 *. y.{1} *. y.{1} in
+    yd.{0} <- yd1;
+    yd.{1} <- (-. yd1 -. yd3);
+    yd.{2} <- yd3
+  in
+  let y = Nvector_serial.make 3 0.0 in
+  let ydata = Nvector.unwrap y in
+  ydata.{0} <- 1.0;
+  let m = Matrix.dense 3 in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-14; 1.0e-6] in
+  let s = Cvode.(init BDF ~lsolver:Dls.(solver (dense y m))
+                   (SVtolerances (1.0e-4, Nvector_serial.wrap abstol)) f
+                   ~roots:(nroots, g) 0.0 y)
+  in
+  let solve tout =
+    let t, r = Cvode.solve_normal s tout y in
+    t, (r = Cvode.RootsFound)
+  in
+  ignore (Cvode.solve_normal s tsnap y);
+  let snap = Cvode.snapshot s in
+  for _ = 1 to 50 do ignore (Cvode.solve_one_step s 4.0e10 y) done;
+  Cvode.restore s snap;
+  let run1 = run solve ydata in
+  Cvode.restore s snap;
+  let run2 = run solve ydata in
+  Cvode.set_max_num_steps s 1000;
+  check "Cvode" run1 run2 (rejects (fun () -> Cvode.restore s snap))
+
+let ida () =
+  let res _ (y : RealArray.t) (yp : RealArray.t) (rr : RealArray.t) =
+    rr.{0} <- -.0.04*.y.{0} +. 1.0e4*.y.{1}*.y.{2};
+    rr.{1} <- -.rr.{0} -. 3.0e7*.y.{1}*.y.{1} -. yp.{1};
+    rr.{0} <-  rr.{0} -. yp.{0};
+    rr.{2} <-  y.{0} +. y.{1} +. y.{2} -. 1.0
+  in
+  let g t y _ gout = g t y gout in
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0; 0.0]) in
+  let y' = Nvector_serial.wrap (RealArray.of_list [-0.04; 0.04; 0.0]) in
+  let ydata = Nvector.unwrap y in
+  let m = Matrix.dense 3 in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-6; 1.0e-6] in
+  let s = Ida.(init (SVtolerances (1.0e-4, Nvector_serial.wrap abstol))
+                 ~lsolver:Dls.(solver (dense y m))
+                 res ~roots:(nroots, g) 0.0 y y')
+  in
+  let solve tout =
+    let t, r = Ida.solve_normal s tout y y' in
+    t, (r = Ida.RootsFound)
+  in
+  ignore (Ida.solve_normal s tsnap y y');
+  let snap = Ida.snapshot s in
+  for _ = 1 to 50 do ignore (Ida.solve_one_step s 4.0e10 y y') done;
+  Ida.restore s snap;
+  let run1 = run solve ydata in
+  Ida.restore s snap;
+  let run2 = run solve ydata in
+  Ida.set_max_num_steps s 1000;
+  check "Ida" run1 run2 (rejects (fun () -> Ida.restore s snap))
+
+let () =
+  try cvode (); ida ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials < 4.1.0"
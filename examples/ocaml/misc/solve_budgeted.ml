@@ -0,0 +1,81 @@
+(* Check that Cvode.solve_budgeted, suspended and resumed, gives the same
+   integration as Cvode.solve_normal.
+
+   The Robertson problem is integrated over eleven output times three times:
+   with solve_normal, with solve_budgeted and a budget of seven steps, and
+   with solve_budgeted and a budget of a microsecond.  The budgeted runs
+   must be suspended and resumed many times, and, since CVODE takes the
+   same steps in both modes, they must give bitwise identical outputs after
+   the same number of steps as the uninterrupted run.  Negative budgets,
+   and releasing the runtime lock for a session with an OCaml right-hand
+   side, must be rejected with Invalid_argument.  *)
+
+module RealArray = Sundials.RealArray
+
+let touts = Array.to_list (Array.init 11 (fun i -> 0.4 *. 10.0 ** float i))
+
+let f _ (y : RealArray.t) (yd : RealArray.t) =
+  let yd1 = -0.04 *. y.{0} +. 1.0e4 *. y.{1} *. y.{2}
+  and yd3 = 3.0e7 *. y.{1} *. y.{1} in
+  yd.{0} <- yd1;
+  yd.{1} <- (-. yd1 -. yd3);
+  yd.{2} <- yd3
+
+let session () =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0; 0.0]) in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-14; 1.0e-6] in
+  let s = Cvode.(init BDF ~lsolver:Dls.(solver (dense y (Matrix.dense 3)))
+                   (SVtolerances (1.0e-4, Nvector_serial.wrap abstol)) f
+                   0.0 y)
+  in
+  s, y
+
+(* Run a solve function over the output times and return the outputs, the
+   number of steps, and the number of suspensions.  *)
+let run solve =
+  let s, y = session () in
+  let suspensions = ref 0 in
+  let outputs = List.map (fun tout ->
+      solve s tout y suspensions;
+      RealArray.copy (Nvector.unwrap y)) touts
+  in
+  outputs, Cvode.get_num_steps s, !suspensions
+
+let normal s tout y _ =
+  match Cvode.solve_normal s tout y with
+  | _, Cvode.Success -> ()
+  | _ -> print_endline "UNEXPECTED RESULT"; exit 1
+
+let rec budgeted ?max_steps ?max_time s tout y suspensions =
+  match Cvode.solve_budgeted ?max_steps ?max_time s tout y with
+  | _, Cvode.Suspended ->
+      incr suspensions;
+      budgeted ?max_steps ?max_time s tout y suspensions
+  | tret, Cvode.Finished Cvode.Success when tret = tout -> ()
+  | _ -> print_endline "UNEXPECTED RESULT"; exit 1
+
+let same_bits y1 y2 =
+  List.for_all2 (fun a b -> Int64.bits_of_float a = Int64.bits_of_float b)
+    (RealArray.to_list y1) (RealArray.to_list y2)
+
+let rejects f = try ignore (f ()); false with Invalid_argument _ -> true
+
+let () =
+  let outputs, steps, _ = run normal in
+  List.iter (fun (name, solve) ->
+      let outputs', steps', suspensions = run solve in
+      Printf.printf "%-16s %d steps, %d suspensions\n"
+        name steps' suspensions;
+      if suspensions = 0 then (print_endline "NEVER SUSPENDED"; exit 1);
+      if steps' <> steps || not (List.for_all2 same_bits outputs outputs')
+      then (print_endline "RESULTS DIFFER"; exit 1))
+    [ "seven steps", budgeted ~max_steps:7 ~max_time:0.0;
+      "one microsecond", budgeted ~max_steps:0 ~max_time:1e-6 ];
+  Printf.printf "solve_normal     %d steps\n" steps;
+  let s, y = session () in
+  if not (rejects (fun () -> Cvode.solve_budgeted ~max_steps:(-1) s 1.0 y))
+     || not (rejects (fun () ->
+               Cvode.solve_budgeted ~max_time:(-1.0) s 1.0 y))
+     || not (rejects (fun () ->
+               Cvode.solve_budgeted ~release_runtime:true s 1.0 y))
+  then (print_endline "BAD CALL NOT REJECTED"; exit 1)
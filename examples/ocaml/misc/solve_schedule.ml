@@ -0,0 +1,81 @@
+(* Check Cvode.solve_schedule against a loop over Cvode.solve_normal.
+
+   The decay y' = -y, y(0) = 1, is integrated over twenty output times with
+   a root function, y - 0.5, that vanishes at ln 2, between the sixth and
+   seventh output times.  One session runs the schedule with solve_schedule,
+   which must stop at the root after filling six columns, and then resumes
+   it with the remaining times.  Another session makes the same calls to
+   CVode with solve_normal from OCaml.  Both must report the root at the
+   same time and give bitwise identical outputs, which must also agree with
+   exp(-t).  *)
+
+module RealArray = Sundials.RealArray
+module RealArray2 = Sundials.RealArray2
+
+let nt = 20
+let ts = RealArray.init nt (fun i -> 0.1 *. float (i + 1))
+
+let f _ (y : RealArray.t) (yd : RealArray.t) = yd.{0} <- -. y.{0}
+let g _ (y : RealArray.t) (gout : RealArray.t) = gout.{0} <- y.{0} -. 0.5
+
+let session () =
+  let y = Nvector_serial.make 1 1.0 in
+  y, Cvode.(init Adams (SStolerances (1e-10, 1e-12)) ~roots:(1, g) f 0.0 y)
+
+let with_schedule () =
+  let y, s = session () in
+  let yout = RealArray2.make 1 nt nan in
+  let roots = ref [] in
+  let rec go first =
+    let left = nt - first in
+    let ts' = RealArray.init left (fun i -> ts.{first + i}) in
+    let yout' = RealArray2.make 1 left nan in
+    let n, tret, r = Cvode.solve_schedule s ts' y yout' in
+    for j = 0 to n - 1 do
+      RealArray2.set yout 0 (first + j) (RealArray2.get yout' 0 j)
+    done;
+    match r with
+    | Cvode.RootsFound ->
+        Printf.printf "solve_schedule: root at t = %.10f after %d columns\n"
+          tret (first + n);
+        roots := (tret, first + n) :: !roots;
+        go (first + n)
+    | _ ->
+        if first + n <> nt then begin
+          Printf.printf "STOPPED AFTER %d COLUMNS\n" (first + n); exit 1
+        end
+  in
+  go 0;
+  yout, List.rev !roots
+
+let with_solve_normal () =
+  let y, s = session () in
+  let yout = RealArray2.make 1 nt nan in
+  let roots = ref [] in
+  for i = 0 to nt - 1 do
+    let rec go () =
+      match Cvode.solve_normal s ts.{i} y with
+      | tret, Cvode.RootsFound -> roots := (tret, i) :: !roots; go ()
+      | _ -> RealArray2.set yout 0 i (Nvector.unwrap y).{0}
+    in
+    go ()
+  done;
+  yout, List.rev !roots
+
+let same_bits a b = Int64.bits_of_float a = Int64.bits_of_float b
+
+let () =
+  let yout1, roots1 = with_schedule () in
+  let yout2, roots2 = with_solve_normal () in
+  (match roots1, roots2 with
+   | [t1, 6], [t2, 6] when same_bits t1 t2 -> ()
+   | _ -> print_endline "ROOTS DIFFER"; exit 1);
+  let worst = ref 0.0 in
+  for i = 0 to nt - 1 do
+    let y1 = RealArray2.get yout1 0 i and y2 = RealArray2.get yout2 0 i in
+    if not (same_bits y1 y2)
+    then (Printf.printf "OUTPUTS DIFFER AT t = %g\n" ts.{i}; exit 1);
+    worst := max !worst (abs_float (y1 -. exp (-. ts.{i})))
+  done;
+  Printf.printf "%d outputs identical, max error %.2e\n" nt !worst;
+  if !worst > 1e-8 then (print_endline "TOO INACCURATE"; exit 1)
@@ -0,0 +1,116 @@
+(* Check Matrix.Sparse.make_pattern and assemble against a dense sum.
+
+   A list of triplets, in no particular order and with many repeated
+   entries, is assembled into a matrix that can initially hold a single
+   nonzero, and thus must grow, and then, with other values, into the same
+   matrix, which must not grow again.  This is done for both the CSC and the
+   CSR formats.  Each time, the compressed storage must be well formed: the
+   pointers must be nondecreasing and the indices strictly increasing within
+   each column or row, so that duplicates are merged, and the number of
+   nonzeros must be that of the pattern.  The values must equal those of a
+   dense matrix into which the triplets are summed; they are small integers,
+   so that the sums are exact whatever their order.  Indices out of range
+   and arrays of different lengths must be rejected.  *)
+
+module RealArray = Sundials.RealArray
+module Index = Sundials.Index
+module Sparse = Matrix.Sparse
+
+let m, n = 30, 20
+let ntrip = 400
+
+(* An index array of the element kind configured for Sundials.  *)
+let index_array len =
+  let vals, _, _ = Sparse.unwrap (Sparse.make Sparse.CSC 1 1 1) in
+  Bigarray.Array1.(create (kind vals) c_layout len)
+
+let index_of_list l =
+  let a = index_array (List.length l) in
+  List.iteri (fun k i -> a.{k} <- Index.of_int i) l;
+  a
+
+(* Deterministic, unordered, and heavily repeated entries.  *)
+let rows = index_array ntrip
+let cols = index_array ntrip
+let () =
+  for k = 0 to ntrip - 1 do
+    rows.{k} <- Index.of_int ((k * 7 + k * k) mod m);
+    cols.{k} <- Index.of_int ((k * 13 + 5) mod n)
+  done
+
+let values seed = RealArray.init ntrip (fun k -> float ((k * seed) mod 7 - 3))
+
+let dense_sum vals =
+  let d = Array.make_matrix m n 0.0 in
+  for k = 0 to ntrip - 1 do
+    let i = Index.to_int rows.{k} and j = Index.to_int cols.{k} in
+    d.(i).(j) <- d.(i).(j) +. vals.{k}
+  done;
+  d
+
+let distinct () =
+  let seen = Hashtbl.create ntrip in
+  for k = 0 to ntrip - 1 do
+    Hashtbl.replace seen (Index.to_int rows.{k}, Index.to_int cols.{k}) ()
+  done;
+  Hashtbl.length seen
+
+let fail name msg = Printf.printf "%s: %s\n" name msg; exit 1
+
+(* [outer] is the number of columns (CSC) or rows (CSR), and [entry o i]
+   maps an outer and an inner index to a row and a column.  *)
+let check name ~outer ~entry a p vals =
+  let idxvals, idxptrs, data = Sparse.unwrap a in
+  let nnz = Sparse.pattern_nnz p in
+  if nnz <> distinct () then fail name "wrong pattern_nnz";
+  if Index.to_int idxptrs.{0} <> 0 || Index.to_int idxptrs.{outer} <> nnz
+  then fail name "wrong pointers";
+  let d = dense_sum vals in
+  let found = Array.make_matrix m n false in
+  for o = 0 to outer - 1 do
+    let first = Index.to_int idxptrs.{o}
+    and last = Index.to_int idxptrs.{o + 1} in
+    if last < first then fail name "decreasing pointers";
+    for k = first to last - 1 do
+      let inner = Index.to_int idxvals.{k} in
+      if k > first && inner <= Index.to_int idxvals.{k - 1}
+      then fail name "unsorted or duplicate indices";
+      let i, j = entry o inner in
+      if data.{k} <> d.(i).(j) then fail name "wrong value";
+      found.(i).(j) <- true
+    done
+  done;
+  Array.iteri (fun i row ->
+      Array.iteri (fun j f ->
+          if not f && d.(i).(j) <> 0.0 then fail name "missing entry") row)
+    found
+
+let run (type s) name (fmt : s Sparse.sformat) ~outer ~entry =
+  let p = Sparse.make_pattern fmt m n rows cols in
+  let a = Sparse.make fmt m n 1 in
+  let vals1 = values 3 in
+  Sparse.assemble a p vals1;
+  check name ~outer ~entry a p vals1;
+  let space = Sparse.space a in
+  let vals2 = values 5 in
+  Sparse.assemble a p vals2;
+  check name ~outer ~entry a p vals2;
+  if Sparse.space a <> space then fail name "grew again";
+  Printf.printf "%s: %d triplets, %d nonzeros\n"
+    name ntrip (Sparse.pattern_nnz p)
+
+let rejects f = try ignore (f ()); false with Invalid_argument _ -> true
+
+let () =
+  try
+    run "CSC" Sparse.CSC ~outer:n ~entry:(fun j i -> i, j);
+    run "CSR" Sparse.CSR ~outer:m ~entry:(fun i j -> i, j);
+    if not (rejects (fun () ->
+              Sparse.make_pattern Sparse.CSC m n
+                (index_of_list [0; m]) (index_of_list [0; 0])))
+       || not (rejects (fun () ->
+                 Sparse.make_pattern Sparse.CSC m n
+                   (index_of_list [0; 1]) (index_of_list [0])))
+    then fail "make_pattern" "bad triplets not rejected"
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 2.7.0"
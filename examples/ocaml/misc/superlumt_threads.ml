@@ -0,0 +1,100 @@
+(* Check the thread count controls of the SuperLUMT solver.
+
+   The Robertson problem is integrated with a SuperLUMT solver created with
+   [nthreads = 4] and then
+   - left with four threads,
+   - set to two threads (set_num_threads),
+   - set to choose its count with a tiny grain (set_auto_num_threads), which
+     must give the maximum, and with the default grain, which must give one
+     thread for so small a matrix,
+   - set to three threads but drawing them from a pool of one thread, which
+     must give one thread, and
+   - the same without sharing the pool, which must give three threads.
+   After each integration, get_num_threads must report the count used by
+   the last factorization, and the results must agree with those of the
+   first run.  Out-of-range counts, grains, and pool sizes must be rejected
+   with Invalid_argument.  *)
+
+module RealArray = Sundials.RealArray
+module Sparse = Matrix.Sparse
+module Superlumt = Sundials.LinearSolver.Direct.Superlumt
+
+let neq = 3
+let nthreads = 4
+let tend = 4.0e4
+
+let f _ (y : RealArray.t) (yd : RealArray.t) =
+  let yd1 = -0.04 *. y.{0} +. 1.0e4 *. y.{1} *. y.{2}
+  and yd3 = 3.0e7 *. y.{1} *. y.{1} in
+  yd.{0} <- yd1;
+  yd.{1} <- (-. yd1 -. yd3);
+  yd.{2} <- yd3
+
+(* The Jacobian is stored as a full 3x3 matrix in column order.  *)
+let jac { Cvode.jac_y = (y : RealArray.t) } smat =
+  let values =
+    [| -0.04; 0.04; 0.0;
+       1.0e4 *. y.{2}; -1.0e4 *. y.{2} -. 6.0e7 *. y.{1}; 6.0e7 *. y.{1};
+       1.0e4 *. y.{1}; -1.0e4 *. y.{1}; 0.0 |] in
+  for j = 0 to neq do Sparse.set_col smat j (neq * j) done;
+  Array.iteri (fun idx v -> Sparse.set smat idx (idx mod neq) v) values
+
+let fail msg = print_endline msg; exit 1
+
+let run name configure expected =
+  let y = Nvector_serial.wrap (RealArray.of_list [1.0; 0.0; 0.0]) in
+  let abstol = RealArray.of_list [1.0e-8; 1.0e-14; 1.0e-6] in
+  let mat = Matrix.wrap_sparse (Sparse.make Sparse.CSC neq neq (neq * neq)) in
+  let ls = Superlumt.make ~nthreads y mat in
+  if Superlumt.max_num_threads ls <> nthreads then fail "WRONG MAXIMUM";
+  configure ls;
+  let s = Cvode.(init BDF ~lsolver:Dls.(solver ~jac ls)
+                   (SVtolerances (1.0e-4, Nvector_serial.wrap abstol)) f
+                   0.0 y)
+  in
+  ignore (Cvode.solve_normal s tend y);
+  let used = Superlumt.get_num_threads ls in
+  Printf.printf "%-22s %d threads  y = %12.5e %12.5e %12.5e\n"
+    name used (Nvector.unwrap y).{0} (Nvector.unwrap y).{1}
+    (Nvector.unwrap y).{2};
+  if used <> expected then fail "WRONG THREAD COUNT";
+  ls, RealArray.copy (Nvector.unwrap y)
+
+let close a b = abs_float (a -. b) <= 1.0e-8 *. (abs_float a +. 1.0e-12)
+
+let rejects f = try f (); false with Invalid_argument _ -> true
+
+let main () =
+  let ls, y0 = run "fixed" ignore nthreads in
+  let agrees (name, configure, expected) =
+    let _, y = run name configure expected in
+    if not (List.for_all2 close (RealArray.to_list y0) (RealArray.to_list y))
+    then fail "RESULTS DIFFER"
+  in
+  Superlumt.Pool.set_size 1;
+  if Superlumt.Pool.size () <> 1 then fail "WRONG POOL SIZE";
+  List.iter agrees [
+    "two threads", (fun ls -> Superlumt.set_num_threads ls 2), 2;
+    "auto, tiny grain",
+      (fun ls -> Superlumt.set_auto_num_threads ~grain:1 ls), nthreads;
+    "auto", (fun ls -> Superlumt.set_auto_num_threads ls), 1;
+    "pool of one",
+      (fun ls -> Superlumt.set_num_threads ls 3; Superlumt.Pool.share ls), 1;
+    "unshared",
+      (fun ls -> Superlumt.set_num_threads ls 3;
+                 Superlumt.Pool.share ~shared:false ls), 3;
+  ];
+  Superlumt.Pool.set_size 0;
+  List.iter (fun (name, f) ->
+      if not (rejects f) then fail (name ^ " NOT REJECTED"))
+    [ "0 threads", (fun () -> Superlumt.set_num_threads ls 0);
+      "too many threads",
+        (fun () -> Superlumt.set_num_threads ls (nthreads + 1));
+      "grain of 0", (fun () -> Superlumt.set_auto_num_threads ~grain:0 ls);
+      "negative pool", (fun () -> Superlumt.Pool.set_size (-1)) ];
+  print_endline "thread counts ok"
+
+let () =
+  try main ()
+  with Sundials.Config.NotImplementedBySundialsVersion ->
+    print_endline "requires Sundials >= 3.0.0 and SuperLUMT"
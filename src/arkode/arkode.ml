@@ -65,6 +65,9 @@ exception VectorOpErr
 
 let no_roots = (0, Arkode_impl.dummy_rootsfn)
 
+let masked_roots m g =
+  (RootMask.length m, fun t y gout -> RootMask.eval m (g t y) gout)
+
 (* Synchronized with arkode_step_stats_index in arkode_ml.h *)
 type step_stats = {
     num_steps           : int;
@@ -87,6 +90,30 @@ type solver_result =
   | RootsFound          (** ARK_ROOT_RETURN *)
   | StopTimeReached     (** ARK_TSTOP_RETURN *)
 
+(* Shared by the Ensemble and Parareal submodules of the time-stepping
+   modules.  *)
+let rec solve_to solve_normal s tout y =
+  match solve_normal s tout y with
+  | _, RootsFound -> solve_to solve_normal s tout y
+  | _ -> ()
+
+(* Shared by the time-stepping modules.  *)
+external c_set_tracing : Sundials_impl.arg_cache -> int -> unit
+    = "sunml_sundials_set_tracing"
+
+external c_get_trace : Sundials_impl.arg_cache -> Sundials.Trace.event array
+    = "sunml_sundials_get_trace"
+
+external c_set_recorder
+    : Sundials_impl.arg_cache -> Sundials.Recorder.t option -> unit
+    = "sunml_sundials_set_recorder"
+
+external c_set_profiling : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_sundials_set_profiling"
+
+external c_get_profile : Sundials_impl.arg_cache -> profile
+    = "sunml_sundials_get_profile"
+
 module ButcherTable = struct (* {{{ *)
 
   (* Synchronized with arkode_butcher_table_index in arkode_ml.h *)
@@ -301,8 +328,12 @@ module ARKStep = struct (* {{{ *)
     | Linear of bool
     | Nonlinear
 
+  (* A right-hand side function is either an OCaml closure or a native C
+     function (in which case the closure is a placeholder).  *)
+  type 'd rhs = 'd rhsfn * Sundials.cfun option
+
   type ('d, 'k) implicit_problem = {
-      irhsfn    : 'd rhsfn;
+      irhsfn    : 'd rhs;
       linearity : linearity;
       nlsolver  : ('d, 'k, (('d, 'k) session) Sundials_NonlinearSolver.integrator)
                   Sundials_NonlinearSolver.t option;
@@ -314,16 +345,28 @@ module ARKStep = struct (* {{{ *)
 
   type ('d, 'k) problem =
     | Implicit of ('d, 'k) implicit_problem
-    | Explicit of 'd rhsfn
-    | ImEx of 'd rhsfn * ('d, 'k) implicit_problem
+    | Explicit of 'd rhs
+    | ImEx of 'd rhs * ('d, 'k) implicit_problem
 
   let implicit ?nlsolver ?lsolver ?linearity fi =
-    Implicit (implicit_problem ?nlsolver ?lsolver ?linearity fi)
+    Implicit (implicit_problem ?nlsolver ?lsolver ?linearity (fi, None))
 
-  let explicit f = Explicit f
+  let explicit f = Explicit (f, None)
 
   let imex ?nlsolver ?lsolver ?linearity ~fi fe =
-    ImEx (fe, implicit_problem ?nlsolver ?lsolver ?linearity fi)
+    ImEx ((fe, None),
+          implicit_problem ?nlsolver ?lsolver ?linearity (fi, None))
+
+  let implicit_cfun ?nlsolver ?lsolver ?linearity fi =
+    Implicit (implicit_problem ?nlsolver ?lsolver ?linearity
+                               (native_rhsfn1, Some fi))
+
+  let explicit_cfun f = Explicit (native_rhsfn2, Some f)
+
+  let imex_cfun ?nlsolver ?lsolver ?linearity ~fi fe =
+    ImEx ((native_rhsfn2, Some fe),
+          implicit_problem ?nlsolver ?lsolver ?linearity
+                           (native_rhsfn1, Some fi))
 
   external c_root_init : ('a, 'k) session -> int -> unit
       = "sunml_arkode_ark_root_init"
@@ -479,7 +522,7 @@ module ARKStep = struct (* {{{ *)
       | LSI.Superlumt _ ->
           if jac = None then invalid_arg "Superlumt requires Jacobian function";
           session.ls_callbacks <- SlsSuperlumtCallback cb
-      | LSI.Custom _ ->
+      | LSI.Custom _ | LSI.BlockDiag ->
           check_dqjac jac mat;
           session.ls_callbacks <- DirectCustomCallback cb
       | _ -> assert false
@@ -520,6 +563,12 @@ module ARKStep = struct (* {{{ *)
       LSI.attach ls;
       session.ls_solver <- LSI.HLS hls
 
+    let colored_jac c fi { jac_t = t; jac_y = y; jac_fy = fy } jm =
+      Matrix.Coloring.jacobian c (fi t) y fy jm
+
+    let incremental_jac t f arg jm =
+      Matrix.Incremental.jacobian t (fun cols jm -> f cols arg jm) jm
+
     (* Sundials < 3.0.0 *)
     let invalidate_callback session =
       if in_compat_mode2 then
@@ -731,6 +780,10 @@ module ARKStep = struct (* {{{ *)
           c_set_jac_times session (jac_times_setup <> None)
                                   (jac_times_vec <> None)
 
+    let dual_jac_times_vec fd { jac_t; jac_y; jac_tmp; _ } v jv =
+      fd jac_t { Nvector_dual.value = jac_y; Nvector_dual.tangent = v }
+               { Nvector_dual.value = jac_tmp; Nvector_dual.tangent = jv }
+
     let set_jac_times s ?jac_times_setup f =
       if in_compat_mode2 && jac_times_setup <> None then
           raise Config.NotImplementedBySundialsVersion;
@@ -1043,7 +1096,7 @@ module ARKStep = struct (* {{{ *)
         | LSI.Superlumt _ ->
             session.mass_callbacks
               <- SlsSuperlumtMassCallback (cb, Matrix.unwrap mat)
-        | LSI.Custom _ ->
+        | LSI.Custom _ | LSI.BlockDiag ->
             session.mass_callbacks
               <- DirectCustomMassCallback (cb, Matrix.unwrap mat)
         | _ -> assert false
@@ -1452,10 +1505,17 @@ module ARKStep = struct (* {{{ *)
     ('a, 'k) session Weak.t
     -> bool             (* f_i given *)
     -> bool             (* f_e given *)
+    -> Sundials.cfun option (* native f_i *)
+    -> Sundials.cfun option (* native f_e *)
     -> ('a, 'k) nvector (* y_0 *)
     -> float            (* t_0 *)
     -> (arkstep arkode_mem * c_weak_ref)
-    = "sunml_arkode_ark_init"
+    = "sunml_arkode_ark_init_byte"
+      "sunml_arkode_ark_init"
+
+  external c_set_cfuns
+    : ('a, 'k) session -> Sundials.cfun option -> Sundials.cfun option -> unit
+    = "sunml_arkode_set_cfuns"
 
   let init prob tol ?restol ?order ?mass ?(roots=no_roots) t0 y0 =
     let (nroots, roots) = roots in
@@ -1472,7 +1532,9 @@ module ARKStep = struct (* {{{ *)
       | ImEx (fe, { irhsfn=fi; linearity=l; nlsolver=nls; lsolver=ls }) ->
           ImplicitAndExplicit, Some fi, Some fe, nls,  ls,   Some l
     in
-    let arkode_mem, backref = c_init weakref (fi <> None) (fe <> None) y0 t0 in
+    let cfun = function Some (_, cf) -> cf | None -> None in
+    let arkode_mem, backref =
+      c_init weakref (fi <> None) (fe <> None) (cfun fi) (cfun fe) y0 t0 in
     (* arkode_mem and backref have to be immediately captured in a session and
        associated with the finalizer before we do anything else.  *)
     let session = {
@@ -1483,10 +1545,11 @@ module ARKStep = struct (* {{{ *)
             uses_resv    = false;
 
             exn_temp     = None;
+            argcache     = Sundials_impl.make_arg_cache ();
 
             problem      = problem;
-            rhsfn1       = (match fi with Some f -> f | None -> dummy_rhsfn1);
-            rhsfn2       = (match fe with Some f -> f | None -> dummy_rhsfn2);
+            rhsfn1       = (match fi with Some (f, _) -> f | None -> dummy_rhsfn1);
+            rhsfn2       = (match fe with Some (f, _) -> f | None -> dummy_rhsfn2);
 
             rootsfn      = roots;
             errh         = dummy_errh;
@@ -1554,20 +1617,24 @@ module ARKStep = struct (* {{{ *)
     let lin, nlsolver, lsolver =
       match problem with
       | None -> None, None, None
-      | Some (Implicit { irhsfn = fi; linearity; nlsolver; lsolver }) ->
+      | Some (Implicit { irhsfn = (fi, cfi); linearity; nlsolver; lsolver }) ->
           session.problem <- ImplicitOnly;
           session.rhsfn1 <- fi;
           session.rhsfn2 <- dummy_rhsfn2;
+          c_set_cfuns session cfi None;
           Some linearity, nlsolver, lsolver
-      | Some (Explicit fe) ->
+      | Some (Explicit (fe, cfe)) ->
           session.problem <- ExplicitOnly;
           session.rhsfn1 <- dummy_rhsfn1;
           session.rhsfn2 <- fe;
+          c_set_cfuns session None cfe;
           None, None, None
-      | Some (ImEx (fe, { irhsfn = fi; linearity; nlsolver; lsolver })) ->
+      | Some (ImEx ((fe, cfe),
+                    { irhsfn = (fi, cfi); linearity; nlsolver; lsolver })) ->
           session.problem <- ImplicitAndExplicit;
           session.rhsfn1 <- fi;
           session.rhsfn2 <- fe;
+          c_set_cfuns session cfi cfe;
           Some linearity, nlsolver, lsolver
     in
     (match lin with
@@ -1639,6 +1706,20 @@ module ARKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     c_solve_one_step s t y
 
+  external c_solve_schedule
+      : ('a, 'k) session -> RealArray.t -> ('a, 'k) nvector -> RealArray2.t
+        -> int * float * solver_result
+      = "sunml_arkode_ark_solve_schedule"
+
+  let solve_schedule s ts y yout =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray.length ts = 0
+    then invalid_arg "solve_schedule: no output times";
+    if RealArray2.size yout <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "solve_schedule: array sizes do not match";
+    c_solve_schedule s ts y yout
+
   external c_get_dky
       : ('a, 'k) session -> float -> int -> ('a, 'k) nvector -> unit
       = "sunml_arkode_ark_get_dky"
@@ -1647,6 +1728,25 @@ module ARKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     fun t k -> c_get_dky s t k y
 
+  external c_get_dky_many
+      : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) nvector
+        -> RealArray2.t -> unit
+      = "sunml_arkode_ark_get_dky_many"
+
+  let get_dky_many s y ts k dkys =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "get_dky_many: array sizes do not match";
+    c_get_dky_many s ts k y dkys
+
+  module Ensemble = struct (* {{{ *)
+    let solve ?prepare ?failed s ~t0 ~y0 ~tout y yout =
+      Sundials_sweep_impl.ensemble ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ?prepare ?failed s ~t0 ~y0 ~tout y yout
+  end (* }}} *)
+
   (* Synchronized with arkode_timestepper_stats_index in arkode_ml.h *)
   type timestepper_stats = {
       exp_steps           : int;
@@ -1667,38 +1767,68 @@ module ARKStep = struct (* {{{ *)
   external get_work_space         : ('a, 'k) session -> int * int
       = "sunml_arkode_ark_get_work_space"
 
-  external get_num_steps          : ('a, 'k) session -> int
+  external get_num_steps          : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_steps"
+        "sunml_arkode_ark_get_num_steps_untagged"
+      [@@noalloc]
 
-  external get_num_exp_steps      : ('d, 'k) session -> int
+  external get_num_exp_steps      : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_exp_steps"
+        "sunml_arkode_ark_get_num_exp_steps_untagged"
+      [@@noalloc]
 
-  external get_num_acc_steps      : ('d, 'k) session -> int
+  external get_num_acc_steps      : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_acc_steps"
+        "sunml_arkode_ark_get_num_acc_steps_untagged"
+      [@@noalloc]
 
-  external get_num_step_attempts  : ('d, 'k) session -> int
+  external get_num_step_attempts  : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_step_attempts"
+        "sunml_arkode_ark_get_num_step_attempts_untagged"
+      [@@noalloc]
 
   external get_num_rhs_evals      : ('a, 'k) session -> int * int
       = "sunml_arkode_ark_get_num_rhs_evals"
 
-  external get_num_lin_solv_setups : ('a, 'k) session -> int
+  external get_num_lin_solv_setups : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_lin_solv_setups"
+        "sunml_arkode_ark_get_num_lin_solv_setups_untagged"
+      [@@noalloc]
 
-  external get_num_err_test_fails : ('a, 'k) session -> int
+  external get_num_err_test_fails : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_err_test_fails"
+        "sunml_arkode_ark_get_num_err_test_fails_untagged"
+      [@@noalloc]
 
-  external get_actual_init_step   : ('a, 'k) session -> float
+  external get_actual_init_step   : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_ark_get_actual_init_step"
+        "sunml_arkode_ark_get_actual_init_step_unboxed"
+      [@@noalloc]
 
-  external get_last_step          : ('a, 'k) session -> float
+  external get_last_step          : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_ark_get_last_step"
+        "sunml_arkode_ark_get_last_step_unboxed"
+      [@@noalloc]
 
-  external get_current_step       : ('a, 'k) session -> float
+  external get_current_step       : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_ark_get_current_step"
+        "sunml_arkode_ark_get_current_step_unboxed"
+      [@@noalloc]
 
-  external get_current_time       : ('a, 'k) session -> float
+  external get_current_time       : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_ark_get_current_time"
+        "sunml_arkode_ark_get_current_time_unboxed"
+      [@@noalloc]
+
+  let set_profiling s enable = c_set_profiling s.argcache enable
+
+  let get_profile s = c_get_profile s.argcache
+
+  let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+  let get_trace s = c_get_trace s.argcache
+
+  let set_recorder s r = c_set_recorder s.argcache r
 
   let print_timestepper_stats s oc =
     let stats = get_timestepper_stats s
@@ -1913,8 +2043,11 @@ module ARKStep = struct (* {{{ *)
       : ('d, 'k) session -> ButcherTable.t option * ButcherTable.t option
       = "sunml_arkode_ark_get_current_butcher_tables"
 
-  external get_tol_scale_factor           : ('a, 'k) session -> float
+  external get_tol_scale_factor
+      : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_ark_get_tol_scale_factor"
+        "sunml_arkode_ark_get_tol_scale_factor_unboxed"
+      [@@noalloc]
 
   external c_get_err_weights
       : ('a, 'k) session -> ('a, 'k) nvector -> unit
@@ -1940,17 +2073,26 @@ module ARKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec ew;
     c_get_est_local_errors s ew
 
-  external get_num_nonlin_solv_iters      : ('a, 'k) session -> int
+  external get_num_nonlin_solv_iters
+      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_nonlin_solv_iters"
+        "sunml_arkode_ark_get_num_nonlin_solv_iters_untagged"
+      [@@noalloc]
 
-  external get_num_nonlin_solv_conv_fails : ('a, 'k) session -> int
+  external get_num_nonlin_solv_conv_fails
+      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_nonlin_solv_conv_fails"
+        "sunml_arkode_ark_get_num_nonlin_solv_conv_fails_untagged"
+      [@@noalloc]
 
   external get_nonlin_solv_stats          : ('a, 'k) session -> int * int
       = "sunml_arkode_ark_get_nonlin_solv_stats"
 
-  external get_num_g_evals                : ('a, 'k) session -> int
+  external get_num_g_evals
+      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_ark_get_num_g_evals"
+        "sunml_arkode_ark_get_num_g_evals_untagged"
+      [@@noalloc]
 
   external write_parameters : ('d, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_ark_write_parameters"
@@ -1958,6 +2100,20 @@ module ARKStep = struct (* {{{ *)
   external write_butcher : ('d, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_ark_write_butcher"
 
+  module Parareal = struct (* {{{ *)
+    let coarse ~steps s y =
+      Sundials_sweep_impl.parareal_coarse
+        ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ~set_fixed_step ~steps s y
+
+    let solve ?max_iters ?map_fine ~coarse ~tol fine ts y u =
+      Sundials_sweep_impl.parareal
+        ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ?max_iters ?map_fine ~coarse ~tol fine ts y u
+  end (* }}} *)
+
 end (* }}} *)
 
 module ERKStep = struct (* {{{ *)
@@ -2000,16 +2156,16 @@ module ERKStep = struct (* {{{ *)
     ('a, 'k) session Weak.t
     -> ('a, 'k) nvector (* y_0 *)
     -> float            (* t_0 *)
+    -> Sundials.cfun option (* native f *)
     -> (erkstep arkode_mem * c_weak_ref)
     = "sunml_arkode_erk_init"
 
-  let init tol ?order f ?(roots=no_roots) t0 y0 =
-    let (nroots, roots) = roots in
+  let init' tol order f cfun (nroots, roots) t0 y0 =
     let checkvec = Nvector.check y0 in
     if Sundials_configuration.safe && nroots < 0 then
       raise (Invalid_argument "number of root functions is negative");
     let weakref = Weak.create 1 in
-    let arkode_mem, backref = c_init weakref y0 t0 in
+    let arkode_mem, backref = c_init weakref y0 t0 cfun in
     (* arkode_mem and backref have to be immediately captured in a session and
        associated with the finalizer before we do anything else.  *)
     let session = {
@@ -2020,6 +2176,7 @@ module ERKStep = struct (* {{{ *)
             uses_resv    = false;
 
             exn_temp     = None;
+            argcache     = Sundials_impl.make_arg_cache ();
 
             problem      = ExplicitOnly;
             rhsfn1       = f;
@@ -2056,6 +2213,12 @@ module ERKStep = struct (* {{{ *)
     (match order with Some o -> c_set_order session o | None -> ());
     session
 
+  let init tol ?order f ?(roots=no_roots) t0 y0 =
+    init' tol order f None roots t0 y0
+
+  let init_cfun tol ?order f ?(roots=no_roots) t0 y0 =
+    init' tol order native_rhsfn1 (Some f) roots t0 y0
+
   let get_num_roots { nroots } = nroots
 
   external c_reinit
@@ -2098,6 +2261,20 @@ module ERKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     c_solve_one_step s t y
 
+  external c_solve_schedule
+      : ('a, 'k) session -> RealArray.t -> ('a, 'k) nvector -> RealArray2.t
+        -> int * float * solver_result
+      = "sunml_arkode_erk_solve_schedule"
+
+  let solve_schedule s ts y yout =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray.length ts = 0
+    then invalid_arg "solve_schedule: no output times";
+    if RealArray2.size yout <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "solve_schedule: array sizes do not match";
+    c_solve_schedule s ts y yout
+
   external c_get_dky
       : ('a, 'k) session -> float -> int -> ('a, 'k) nvector -> unit
       = "sunml_arkode_erk_get_dky"
@@ -2106,6 +2283,25 @@ module ERKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     fun t k -> c_get_dky s t k y
 
+  external c_get_dky_many
+      : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) nvector
+        -> RealArray2.t -> unit
+      = "sunml_arkode_erk_get_dky_many"
+
+  let get_dky_many s y ts k dkys =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "get_dky_many: array sizes do not match";
+    c_get_dky_many s ts k y dkys
+
+  module Ensemble = struct (* {{{ *)
+    let solve ?prepare ?failed s ~t0 ~y0 ~tout y yout =
+      Sundials_sweep_impl.ensemble ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ?prepare ?failed s ~t0 ~y0 ~tout y yout
+  end (* }}} *)
+
   (* Synchronized with arkode_timestepper_stats_index in arkode_ml.h *)
   type timestepper_stats = {
       exp_steps           : int;
@@ -2124,35 +2320,65 @@ module ERKStep = struct (* {{{ *)
   external get_work_space         : ('a, 'k) session -> int * int
       = "sunml_arkode_erk_get_work_space"
 
-  external get_num_steps          : ('a, 'k) session -> int
+  external get_num_steps          : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_steps"
+        "sunml_arkode_erk_get_num_steps_untagged"
+      [@@noalloc]
 
-  external get_num_exp_steps      : ('d, 'k) session -> int
+  external get_num_exp_steps      : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_exp_steps"
+        "sunml_arkode_erk_get_num_exp_steps_untagged"
+      [@@noalloc]
 
-  external get_num_acc_steps      : ('d, 'k) session -> int
+  external get_num_acc_steps      : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_acc_steps"
+        "sunml_arkode_erk_get_num_acc_steps_untagged"
+      [@@noalloc]
 
-  external get_num_step_attempts  : ('d, 'k) session -> int
+  external get_num_step_attempts  : ('d, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_step_attempts"
+        "sunml_arkode_erk_get_num_step_attempts_untagged"
+      [@@noalloc]
 
-  external get_num_rhs_evals      : ('a, 'k) session -> int
+  external get_num_rhs_evals      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_rhs_evals"
+        "sunml_arkode_erk_get_num_rhs_evals_untagged"
+      [@@noalloc]
 
-  external get_num_err_test_fails : ('a, 'k) session -> int
+  external get_num_err_test_fails : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_err_test_fails"
+        "sunml_arkode_erk_get_num_err_test_fails_untagged"
+      [@@noalloc]
 
-  external get_actual_init_step   : ('a, 'k) session -> float
+  external get_actual_init_step   : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_erk_get_actual_init_step"
+        "sunml_arkode_erk_get_actual_init_step_unboxed"
+      [@@noalloc]
 
-  external get_last_step          : ('a, 'k) session -> float
+  external get_last_step          : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_erk_get_last_step"
+        "sunml_arkode_erk_get_last_step_unboxed"
+      [@@noalloc]
 
-  external get_current_step       : ('a, 'k) session -> float
+  external get_current_step       : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_erk_get_current_step"
+        "sunml_arkode_erk_get_current_step_unboxed"
+      [@@noalloc]
 
-  external get_current_time       : ('a, 'k) session -> float
+  external get_current_time       : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_erk_get_current_time"
+        "sunml_arkode_erk_get_current_time_unboxed"
+      [@@noalloc]
+
+  let set_profiling s enable = c_set_profiling s.argcache enable
+
+  let get_profile s = c_get_profile s.argcache
+
+  let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+  let get_trace s = c_get_trace s.argcache
+
+  let set_recorder s r = c_set_recorder s.argcache r
 
   let print_timestepper_stats s oc =
     let stats = get_timestepper_stats s
@@ -2289,8 +2515,11 @@ module ERKStep = struct (* {{{ *)
       : ('d, 'k) session -> ButcherTable.t
       = "sunml_arkode_erk_get_current_butcher_table"
 
-  external get_tol_scale_factor           : ('a, 'k) session -> float
+  external get_tol_scale_factor
+      : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_erk_get_tol_scale_factor"
+        "sunml_arkode_erk_get_tol_scale_factor_unboxed"
+      [@@noalloc]
 
   external c_get_err_weights
       : ('a, 'k) session -> ('a, 'k) nvector -> unit
@@ -2308,8 +2537,11 @@ module ERKStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec ew;
     c_get_est_local_errors s ew
 
-  external get_num_g_evals                : ('a, 'k) session -> int
+  external get_num_g_evals
+      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_erk_get_num_g_evals"
+        "sunml_arkode_erk_get_num_g_evals_untagged"
+      [@@noalloc]
 
   external write_parameters : ('d, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_erk_write_parameters"
@@ -2317,6 +2549,20 @@ module ERKStep = struct (* {{{ *)
   external write_butcher : ('d, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_erk_write_butcher"
 
+  module Parareal = struct (* {{{ *)
+    let coarse ~steps s y =
+      Sundials_sweep_impl.parareal_coarse
+        ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ~set_fixed_step ~steps s y
+
+    let solve ?max_iters ?map_fine ~coarse ~tol fine ts y u =
+      Sundials_sweep_impl.parareal
+        ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ?max_iters ?map_fine ~coarse ~tol fine ts y u
+  end (* }}} *)
+
 end (* }}} *)
 
 module MRIStep = struct (* {{{ *)
@@ -2345,16 +2591,17 @@ module MRIStep = struct (* {{{ *)
     ('a, 'k) session Weak.t
     -> ('a, 'k) nvector (* y_0 *)
     -> float            (* t_0 *)
+    -> Sundials.cfun option (* native slow f *)
+    -> Sundials.cfun option (* native fast f *)
     -> (mristep arkode_mem * c_weak_ref)
     = "sunml_arkode_mri_init"
 
-  let init ~slow ~fast ?hslow ?hfast ?(roots=no_roots) t0 y0 =
-    let (nroots, roots) = roots in
+  let init' (slow, cslow) (fast, cfast) hslow hfast (nroots, roots) t0 y0 =
     let checkvec = Nvector.check y0 in
     if Sundials_configuration.safe && nroots < 0 then
       raise (Invalid_argument "number of root functions is negative");
     let weakref = Weak.create 1 in
-    let arkode_mem, backref = c_init weakref y0 t0 in
+    let arkode_mem, backref = c_init weakref y0 t0 cslow cfast in
     (* arkode_mem and backref have to be immediately captured in a session and
        associated with the finalizer before we do anything else.  *)
     let session = {
@@ -2365,6 +2612,7 @@ module MRIStep = struct (* {{{ *)
             uses_resv    = false;
 
             exn_temp     = None;
+            argcache     = Sundials_impl.make_arg_cache ();
 
             problem      = ExplicitOnly;
             rhsfn1       = slow;
@@ -2400,6 +2648,12 @@ module MRIStep = struct (* {{{ *)
       then set_fixed_step session ?hslow ?hfast ();
     session
 
+  let init ~slow ~fast ?hslow ?hfast ?(roots=no_roots) t0 y0 =
+    init' (slow, None) (fast, None) hslow hfast roots t0 y0
+
+  let init_cfun ~slow ~fast ?hslow ?hfast ?(roots=no_roots) t0 y0 =
+    init' (slow, None) (native_rhsfn2, Some fast) hslow hfast roots t0 y0
+
   let get_num_roots { nroots } = nroots
 
   external c_reinit
@@ -2440,6 +2694,20 @@ module MRIStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     c_solve_one_step s t y
 
+  external c_solve_schedule
+      : ('a, 'k) session -> RealArray.t -> ('a, 'k) nvector -> RealArray2.t
+        -> int * float * solver_result
+      = "sunml_arkode_mri_solve_schedule"
+
+  let solve_schedule s ts y yout =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray.length ts = 0
+    then invalid_arg "solve_schedule: no output times";
+    if RealArray2.size yout <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "solve_schedule: array sizes do not match";
+    c_solve_schedule s ts y yout
+
   external c_get_dky
       : ('a, 'k) session -> float -> int -> ('a, 'k) nvector -> unit
       = "sunml_arkode_mri_get_dky"
@@ -2448,6 +2716,25 @@ module MRIStep = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec y;
     fun t k -> c_get_dky s t k y
 
+  external c_get_dky_many
+      : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) nvector
+        -> RealArray2.t -> unit
+      = "sunml_arkode_mri_get_dky_many"
+
+  let get_dky_many s y ts k dkys =
+    if Sundials_configuration.safe then s.checkvec y;
+    if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap y),
+                                 RealArray.length ts)
+    then invalid_arg "get_dky_many: array sizes do not match";
+    c_get_dky_many s ts k y dkys
+
+  module Ensemble = struct (* {{{ *)
+    let solve ?prepare ?failed s ~t0 ~y0 ~tout y yout =
+      Sundials_sweep_impl.ensemble ~reinit:(fun s t0 y -> reinit s t0 y)
+        ~solve_to:(solve_to solve_normal)
+        ?prepare ?failed s ~t0 ~y0 ~tout y yout
+  end (* }}} *)
+
   external get_work_space         : ('a, 'k) session -> int * int
       = "sunml_arkode_mri_get_work_space"
 
@@ -2457,11 +2744,25 @@ module MRIStep = struct (* {{{ *)
   external get_num_rhs_evals      : ('a, 'k) session -> int * int
       = "sunml_arkode_mri_get_num_rhs_evals"
 
-  external get_last_step          : ('a, 'k) session -> float
+  external get_last_step          : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_mri_get_last_step"
+        "sunml_arkode_mri_get_last_step_unboxed"
+      [@@noalloc]
 
-  external get_current_time       : ('a, 'k) session -> float
+  external get_current_time       : ('a, 'k) session -> (float [@unboxed])
       = "sunml_arkode_mri_get_current_time"
+        "sunml_arkode_mri_get_current_time_unboxed"
+      [@@noalloc]
+
+  let set_profiling s enable = c_set_profiling s.argcache enable
+
+  let get_profile s = c_get_profile s.argcache
+
+  let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+  let get_trace s = c_get_trace s.argcache
+
+  let set_recorder s r = c_set_recorder s.argcache r
 
   external set_diagnostics : ('a, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_mri_set_diagnostics"
@@ -2547,8 +2848,11 @@ module MRIStep = struct (* {{{ *)
       : ('d, 'k) session -> ButcherTable.t * ButcherTable.t
       = "sunml_arkode_mri_get_current_butcher_tables"
 
-  external get_num_g_evals                : ('a, 'k) session -> int
+  external get_num_g_evals
+      : ('a, 'k) session -> (int [@untagged])
       = "sunml_arkode_mri_get_num_g_evals"
+        "sunml_arkode_mri_get_num_g_evals_untagged"
+      [@@noalloc]
 
   external write_parameters : ('d, 'k) session -> Logfile.t -> unit
       = "sunml_arkode_mri_write_parameters"
@@ -114,12 +114,24 @@ val default_tolerances : ('data, 'kind) tolerance
     {warning [y] and [gout] should not be accessed after the function has
              returned.}
 
+    The same [gout] array is passed to each call. Once the function has
+    returned, it is empty until the next call.
+
     @noarkode <node> ARKRootFn *)
 type 'd rootsfn = float -> 'd -> RealArray.t -> unit
 
 (** A convenience value for signalling that there are no roots to monitor. *)
 val no_roots : (int * 'd rootsfn)
 
+(** [masked_roots m g] returns root functions for use with [~roots] that
+    only evaluate the active entries of the mask [m]: {!RootMask.eval}
+    calls [g t y i] for each active index [i]. The mask may be updated between
+    calls to the solver functions.
+
+    The number of root functions is [RootMask.length m]. *)
+val masked_roots :
+  RootMask.t -> (float -> 'd -> int -> float) -> (int * 'd rootsfn)
+
 (** {3:arkodeadapt Adaptivity} *)
 
 type adaptivity_args = {
@@ -423,6 +435,13 @@ module ARKStep : sig (* {{{ *)
 
   (** Arguments common to Jacobian callback functions.
 
+      {warning The record is reused between calls and should not be
+               retained after the callback returns.}
+
+      Only the record is reused: its [jac_t] field, like the other float
+      arguments of callbacks (e.g., [gamma]), is boxed afresh at each call,
+      so callbacks still allocate their float arguments.
+
       @noarkode <node> ARKLsJacFn
       @noarkode <node> ARKLsJacTimesVecFn
       @noarkode <node> ARKLsPrecSolveFn
@@ -479,6 +498,23 @@ module ARKStep : sig (* {{{ *)
         ('m, RealArray.t, 'kind, [>`Dls]) LinearSolver.t ->
       'kind serial_linear_solver
 
+    (** [colored_jac c fi] approximates the Jacobian of the implicit
+        right-hand side function [fi] by finite differences, with one
+        evaluation of [fi] per color of [c] (see {!Matrix.Coloring}). It is
+        an alternative to a hand-written Jacobian function for sparse and
+        band matrices. *)
+    val colored_jac : 'm Matrix.Coloring.t
+                      -> (float -> RealArray.t -> RealArray.t -> unit)
+                      -> 'm jac_fn
+
+    (** [incremental_jac t f] is a Jacobian function that only recomputes
+        the columns marked dirty in [t] (see {!Matrix.Incremental}). The
+        call [f cols arg jm] must assign the columns [cols] of [jm]; the
+        other columns already hold their last computed values. *)
+    val incremental_jac : 'm Matrix.Incremental.t
+                          -> (int array -> 'm jac_fn)
+                          -> 'm jac_fn
+
     (** {3:arkdlsstats Solver statistics} *)
 
     (** Returns the sizes of the real and integer workspaces used by a direct
@@ -706,6 +742,18 @@ module ARKStep : sig (* {{{ *)
       -> ('d, 'k) preconditioner
       -> ('d, 'k) linear_solver
 
+    (** Computes exact Jacobian-vector products by forward-mode automatic
+        differentiation. The call [dual_jac_times_vec fd] returns a
+        {!jac_times_vec_fn} that computes {% $J\mathtt{v}$%} with a single
+        call [fd t y fy], where [fd] evaluates the implicit right-hand side
+        function {% $f_I$%} on dual-number vectors (see {!Nvector_dual}).
+        The values of [y] are the current state and its tangents are [v];
+        the tangents of [fy] receive the product, and its values, stored in
+        the work vector, are discarded. *)
+    val dual_jac_times_vec :
+      (float -> Nvector_dual.data -> Nvector_dual.data -> unit)
+      -> Nvector_serial.data jac_times_vec_fn
+
     (** {3:arkspilsset Solver parameters} *)
 
     (** Sets the maximum number of time steps to wait before recomputation of
@@ -1188,6 +1236,39 @@ module ARKStep : sig (* {{{ *)
     -> 'data rhsfn
     -> ('data, 'kind) problem
 
+  (** Like {!implicit} but the implicit portion of the right-hand side is a
+      native C function of type
+      [int f(realtype t, N_Vector y, N_Vector ydot, void *data)], where
+      [data] is the pointer given to [sunml_sundials_wrap_cfun]. It is called
+      directly by ARKODE without entering the OCaml runtime and must follow
+      the SUNDIALS return value conventions (0 for success, a positive
+      value for a recoverable error, and a negative value for an
+      unrecoverable error). See {!Sundials.cfun}. *)
+  val implicit_cfun :
+    ?nlsolver : ('data, 'kind,
+                  (('data, 'kind) session) Sundials_NonlinearSolver.integrator)
+                Sundials_NonlinearSolver.t
+    -> ?lsolver  : ('data, 'kind) linear_solver
+    -> ?linearity : linearity
+    -> Sundials.cfun
+    -> ('data, 'kind) problem
+
+  (** Like {!explicit} but the explicit portion of the right-hand side is a
+      native C function (see {!implicit_cfun}). *)
+  val explicit_cfun : Sundials.cfun -> ('data, 'kind) problem
+
+  (** Like {!imex} but both portions of the right-hand side are native C
+      functions (see {!implicit_cfun}). *)
+  val imex_cfun :
+    ?nlsolver : ('data, 'kind,
+                  (('data, 'kind) session) Sundials_NonlinearSolver.integrator)
+                Sundials_NonlinearSolver.t
+    -> ?lsolver  : ('data, 'kind) linear_solver
+    -> ?linearity : linearity
+    -> fi:Sundials.cfun
+    -> Sundials.cfun
+    -> ('data, 'kind) problem
+
   (** Creates and initializes a session with the solver. The call
       {[init problem tol ~restol ~order ~mass:msolver ~roots:(nroots, g) t0 y0]}
       has as arguments:
@@ -1275,6 +1356,28 @@ module ARKStep : sig (* {{{ *)
   val solve_one_step : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
                           -> float * solver_result
 
+  (** Integrates an ODE system over a sequence of output times. The call
+      [n, tret, r = solve_schedule s ts y yout] calls {!solve_normal} for
+      each time in [ts], which must be nonempty and monotonic, and stores
+      the solution at [ts.{i}] in the [i]th column of [yout], using [y] as
+      workspace. The array [yout] must have a row for each element of [y]
+      and a column for each element of [ts]. The whole loop runs in a
+      single call into C.
+
+      It returns [n], the number of columns filled, [tret], the time
+      reached by the last step, and [r], the result of the last step. The
+      loop stops early when a root or the stop time is reached; in that
+      case, [y] holds the solution at [tret] and the call can be resumed
+      with the remaining times once the event has been handled. Exceptions
+      are propagated as for {!solve_normal} with the columns for the times
+      already reached filled.
+
+      @noarkode <node> ARKStepEvolve (ARK_NORMAL)
+      @raise Invalid_argument [ts] is empty or the array sizes do not agree. *)
+  val solve_schedule : (Nvector_serial.data, 'k) session -> RealArray.t
+                       -> (Nvector_serial.data, 'k) Nvector.t -> RealArray2.t
+                       -> int * float * solver_result
+
   (** Returns the interpolated solution or derivatives.
       [get_dky s dky t k] computes the [k]th derivative of the function
       at time [t], i.e.,
@@ -1292,6 +1395,21 @@ module ARKStep : sig (* {{{ *)
       @raise BadK [k] is not in the range \{0, 1, ..., dord\}. *)
   val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+  (** Evaluates the interpolated solution or derivatives at several times.
+      [get_dky_many s dky ts k dkys] computes the [k]th derivative at each
+      time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+      [dkys], using [dky] as workspace. The array [dkys] must have a row for
+      each element of [dky] and a column for each element of [ts]. All of the
+      evaluations are made in a single call into C.
+
+      @noarkode <node> ARKStepGetDky
+      @raise BadT A time is not in the interval {% $[t_n - h_n, t_n]$%}.
+      @raise BadK [k] is not in the range \{0, 1, ..., dord\}.
+      @raise Invalid_argument The sizes of [dky], [ts], and [dkys] do not agree. *)
+  val get_dky_many : (Nvector_serial.data, 'k) session
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> RealArray.t -> int -> RealArray2.t -> unit
+
   (** Reinitializes the solver with new parameters and state values. The
       values of the independent variable, i.e., the simulation time, and the
       state variables must be given. If given, [problem] specifies new
@@ -1318,6 +1436,70 @@ module ARKStep : sig (* {{{ *)
     -> ('d, 'k) Nvector.t
     -> unit
 
+  (** Solving families of independent problems with a single session, as
+      described for {!Cvode.Ensemble}. *)
+  module Ensemble : sig (* {{{ *)
+
+    (** Solves each member of a family of problems from [t0] to [tout],
+        exactly as {!Cvode.Ensemble.solve}. The session is reinitialized
+        with {!reinit}, without changing the problem or solvers, for each
+        member.
+
+        @raise Invalid_argument The array sizes do not match the length of [y]. *)
+    val solve :
+      ?prepare:(int -> unit)
+      -> ?failed:(int -> exn -> unit)
+      -> (Nvector_serial.data, 'k) session
+      -> t0:float
+      -> y0:RealArray2.t
+      -> tout:float
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> RealArray2.t
+      -> unit
+
+  end (* }}} *)
+
+  (** Parallel-in-time integration, as described for {!Cvode.Parareal}.
+      The fine sessions are reinitialized with {!reinit}, without changing
+      the problem or solvers, at each iteration. An implicit or IMEX
+      coarse propagator is useful when the problem is stiff. *)
+  module Parareal : sig (* {{{ *)
+
+    (** Returns a coarse propagator for {!solve}. The call
+        [coarse ~steps s y] returns a function that, given [t0], [t1], and
+        the value [v] at [t0], reinitializes [s] at [t0] and replaces [v]
+        by the value at [t1] found by [steps] fixed steps of length
+        [(t1 - t0) / steps], using [y] as workspace. The session is
+        typically created with a low-order method and loose tolerances,
+        and only used for this purpose.
+
+        @noarkode <node> ARKStepSetFixedStep *)
+    val coarse :
+      steps:int
+      -> (Nvector_serial.data, 'k) session
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> float -> float -> RealArray.t -> unit
+
+    (** Integrates over a sequence of time slices with the parareal
+        algorithm, exactly as {!Cvode.Parareal.solve} (without
+        [keep_jacobian]).
+
+        @raise Invalid_argument The array sizes do not match the length of
+                                [y] or the number of sessions. *)
+    val solve :
+      ?max_iters:int
+      -> ?map_fine:((int -> (Nvector_serial.data, 'k) Nvector.t -> unit)
+                    -> int -> int -> unit)
+      -> coarse:(float -> float -> RealArray.t -> unit)
+      -> tol:float
+      -> (Nvector_serial.data, 'k) session array
+      -> RealArray.t
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> RealArray2.t
+      -> int * float
+
+  end (* }}} *)
+
   (** Change the number of equations and unknowns between integrator steps.
       The call
       [resize s ~resize_nvec:rfn ~lsolver ~mass tol ~restol hscale ynew t0]
@@ -1822,6 +2004,38 @@ module ARKStep : sig (* {{{ *)
       @noarkode <node> ARKStepGetCurrentTime *)
   val get_current_time        : ('d, 'k) session -> float
 
+  (** Enables or disables profiling of the session. Enabling profiling
+      resets the counters, which then accumulate the number of calls and the
+      time spent in the solver and in each category of callback (see
+      {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+      Profiling is disabled by default. *)
+  val set_profiling : ('d, 'k) session -> bool -> unit
+
+  (** Returns the profiling counters of the session. All of the counters are
+      zero if profiling has never been enabled. See {!set_profiling}. *)
+  val get_profile : ('d, 'k) session -> Sundials.profile
+
+  (** Enables tracing of the session, with a buffer that keeps the given
+      number of most recent events, or disables it if the capacity is zero
+      (see {!Sundials.Trace}). Enabling tracing again discards the events
+      recorded so far. Tracing is independent of profiling and is disabled by
+      default.
+
+      @raise Invalid_argument If the capacity is negative. *)
+  val set_tracing : ('d, 'k) session -> int -> unit
+
+  (** Returns the events recorded in the trace of the session, oldest first.
+      The array is empty if tracing is disabled. See {!set_tracing}. *)
+  val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
+  (** Attaches a recorder to the session, or detaches the current one (see
+      {!Sundials.Recorder}). After each successful call to {!solve_normal},
+      {!solve_one_step}, or {!solve_schedule}, the time reached and the
+      solution are appended to the recording. A session holds at most one
+      recorder, which remains open when it is detached. *)
+  val set_recorder : (Nvector_serial.data, 'k) session
+                     -> Sundials.Recorder.t option -> unit
+
   (** Returns the implicit and explicit Butcher tables in use by the solver.
       In the call [bi, be = get_current_butcher_tables s], [bi] is the
       implicit butcher table and [be] is the explicit one.
@@ -2028,6 +2242,23 @@ module ERKStep : sig (* {{{ *)
       -> ('data, 'kind) Nvector.t
       -> ('data, 'kind) session
 
+  (** Like {!init} but the right-hand side is a native C function of type
+      [int f(realtype t, N_Vector y, N_Vector ydot, void *data)], where
+      [data] is the pointer given to [sunml_sundials_wrap_cfun]. It is called
+      directly by ARKODE without entering the OCaml runtime and must follow
+      the SUNDIALS return value conventions. See {!Sundials.cfun}.
+
+      @since 4.0.0
+      @noarkode <node> ERKStepCreate *)
+  val init_cfun :
+      ('data, 'kind) tolerance
+      -> ?order:int
+      -> Sundials.cfun
+      -> ?roots:(int * 'data rootsfn)
+      -> float
+      -> ('data, 'kind) Nvector.t
+      -> ('data, 'kind) session
+
   (** Integrates an ODE system over an interval. The call
       [tret, r = solve_normal s tout yout] has as arguments
       - [s], a solver session,
@@ -2056,6 +2287,16 @@ module ERKStep : sig (* {{{ *)
   val solve_one_step : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
                           -> float * solver_result
 
+  (** Like {!solve_normal} but integrates over a sequence of output times,
+      storing the solution at [ts.{i}] in the [i]th column of [yout]. See
+      {!ARKStep.solve_schedule}.
+
+      @noarkode <node> ERKStepEvolve (ARK_NORMAL)
+      @raise Invalid_argument [ts] is empty or the array sizes do not agree. *)
+  val solve_schedule : (Nvector_serial.data, 'k) session -> RealArray.t
+                       -> (Nvector_serial.data, 'k) Nvector.t -> RealArray2.t
+                       -> int * float * solver_result
+
   (** Returns the interpolated solution or derivatives.
       [get_dky s dky t k] computes the [k]th derivative of the function
       at time [t], i.e.,
@@ -2073,6 +2314,21 @@ module ERKStep : sig (* {{{ *)
       @raise BadK [k] is not in the range \{0, 1, ..., dord\}. *)
   val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+  (** Evaluates the interpolated solution or derivatives at several times.
+      [get_dky_many s dky ts k dkys] computes the [k]th derivative at each
+      time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+      [dkys], using [dky] as workspace. The array [dkys] must have a row for
+      each element of [dky] and a column for each element of [ts]. All of the
+      evaluations are made in a single call into C.
+
+      @noarkode <node> ERKStepGetDky
+      @raise BadT A time is not in the interval {% $[t_n - h_n, t_n]$%}.
+      @raise BadK [k] is not in the range \{0, 1, ..., dord\}.
+      @raise Invalid_argument The sizes of [dky], [ts], and [dkys] do not agree. *)
+  val get_dky_many : (Nvector_serial.data, 'k) session
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> RealArray.t -> int -> RealArray2.t -> unit
+
   (** Reinitializes the solver with new parameters and state values. The
       values of the independent variable, i.e., the simulation time, and the
       state variables must be given. If given, [order] changes the order of
@@ -2092,6 +2348,69 @@ module ERKStep : sig (* {{{ *)
     -> ('d, 'k) Nvector.t
     -> unit
 
+  (** Solving families of independent problems with a single session, as
+      described for {!Cvode.Ensemble}. *)
+  module Ensemble : sig (* {{{ *)
+
+    (** Solves each member of a family of problems from [t0] to [tout],
+        exactly as {!Cvode.Ensemble.solve}. The session is reinitialized
+        with {!reinit} for each member.
+
+        @raise Invalid_argument The array sizes do not match the length of [y]. *)
+    val solve :
+      ?prepare:(int -> unit)
+      -> ?failed:(int -> exn -> unit)
+      -> (Nvector_serial.data, 'k) session
+      -> t0:float
+      -> y0:RealArray2.t
+      -> tout:float
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> RealArray2.t
+      -> unit
+
+  end (* }}} *)
+
+  (** Parallel-in-time integration, as described for {!Cvode.Parareal}.
+      The fine sessions are reinitialized with {!reinit}, without changing
+      the problem or solvers, at each iteration. A fixed-step explicit
+      method makes a cheap coarse propagator for non-stiff problems. *)
+  module Parareal : sig (* {{{ *)
+
+    (** Returns a coarse propagator for {!solve}. The call
+        [coarse ~steps s y] returns a function that, given [t0], [t1], and
+        the value [v] at [t0], reinitializes [s] at [t0] and replaces [v]
+        by the value at [t1] found by [steps] fixed steps of length
+        [(t1 - t0) / steps], using [y] as workspace. The session is
+        typically created with a low-order method and loose tolerances,
+        and only used for this purpose.
+
+        @noarkode <node> ERKStepSetFixedStep *)
+    val coarse :
+      steps:int
+      -> (Nvector_serial.data, 'k) session
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> float -> float -> RealArray.t -> unit
+
+    (** Integrates over a sequence of time slices with the parareal
+        algorithm, exactly as {!Cvode.Parareal.solve} (without
+        [keep_jacobian]).
+
+        @raise Invalid_argument The array sizes do not match the length of
+                                [y] or the number of sessions. *)
+    val solve :
+      ?max_iters:int
+      -> ?map_fine:((int -> (Nvector_serial.data, 'k) Nvector.t -> unit)
+                    -> int -> int -> unit)
+      -> coarse:(float -> float -> RealArray.t -> unit)
+      -> tol:float
+      -> (Nvector_serial.data, 'k) session array
+      -> RealArray.t
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> RealArray2.t
+      -> int * float
+
+  end (* }}} *)
+
   (** Change the number of equations and unknowns between integrator steps.
       The call
       [resize s ~resize_nvec:rfn tol hscale ynew t0]
@@ -2377,6 +2696,38 @@ module ERKStep : sig (* {{{ *)
       @noarkode <node> ERKStepGetCurrentTime *)
   val get_current_time        : ('d, 'k) session -> float
 
+  (** Enables or disables profiling of the session. Enabling profiling
+      resets the counters, which then accumulate the number of calls and the
+      time spent in the solver and in each category of callback (see
+      {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+      Profiling is disabled by default. *)
+  val set_profiling : ('d, 'k) session -> bool -> unit
+
+  (** Returns the profiling counters of the session. All of the counters are
+      zero if profiling has never been enabled. See {!set_profiling}. *)
+  val get_profile : ('d, 'k) session -> Sundials.profile
+
+  (** Enables tracing of the session, with a buffer that keeps the given
+      number of most recent events, or disables it if the capacity is zero
+      (see {!Sundials.Trace}). Enabling tracing again discards the events
+      recorded so far. Tracing is independent of profiling and is disabled by
+      default.
+
+      @raise Invalid_argument If the capacity is negative. *)
+  val set_tracing : ('d, 'k) session -> int -> unit
+
+  (** Returns the events recorded in the trace of the session, oldest first.
+      The array is empty if tracing is disabled. See {!set_tracing}. *)
+  val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
+  (** Attaches a recorder to the session, or detaches the current one (see
+      {!Sundials.Recorder}). After each successful call to {!solve_normal},
+      {!solve_one_step}, or {!solve_schedule}, the time reached and the
+      solution are appended to the recording. A session holds at most one
+      recorder, which remains open when it is detached. *)
+  val set_recorder : (Nvector_serial.data, 'k) session
+                     -> Sundials.Recorder.t option -> unit
+
   (** Returns the Butcher table in use by the solver.
 
       @noarkode <node> ERKStepGetCurrentButcherTable *)
@@ -2552,6 +2903,28 @@ module MRIStep : sig (* {{{ *)
       -> ('data, 'kind) Nvector.t
       -> ('data, 'kind) session
 
+  (** Like {!init} but the fast portion of the right-hand side is a native C
+      function of type
+      [int f(realtype t, N_Vector y, N_Vector ydot, void *data)], where
+      [data] is the pointer given to [sunml_sundials_wrap_cfun]. It is called
+      directly by the inner stepper, at every fast stage, without entering
+      the OCaml runtime and must follow the SUNDIALS return value
+      conventions. A negative (unrecoverable) result stops the inner
+      integration and is reported by {!Arkode.InnerStepFail}. See
+      {!Sundials.cfun}.
+
+      @since 4.0.0
+      @noarkode <node> MRIStepCreate *)
+  val init_cfun :
+         slow:'data rhsfn
+      -> fast:Sundials.cfun
+      -> ?hslow:float
+      -> ?hfast:float
+      -> ?roots:(int * 'data rootsfn)
+      -> float
+      -> ('data, 'kind) Nvector.t
+      -> ('data, 'kind) session
+
   (** Integrates an ODE system over an interval. The call
       [tret, r = solve_normal s tout yout] has as arguments
       - [s], a solver session,
@@ -2575,6 +2948,16 @@ module MRIStep : sig (* {{{ *)
   val solve_one_step : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
                           -> float * solver_result
 
+  (** Like {!solve_normal} but integrates over a sequence of output times,
+      storing the solution at [ts.{i}] in the [i]th column of [yout]. See
+      {!ARKStep.solve_schedule}.
+
+      @noarkode <node> MRIStepEvolve (ARK_NORMAL)
+      @raise Invalid_argument [ts] is empty or the array sizes do not agree. *)
+  val solve_schedule : (Nvector_serial.data, 'k) session -> RealArray.t
+                       -> (Nvector_serial.data, 'k) Nvector.t -> RealArray2.t
+                       -> int * float * solver_result
+
   (** Returns the interpolated solution or derivatives.
       [get_dky s dky t k] computes the [k]th derivative of the function
       at time [t], i.e.,
@@ -2592,6 +2975,21 @@ module MRIStep : sig (* {{{ *)
       @raise BadK [k] is not in the range \{0, 1, ..., dord\}. *)
   val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+  (** Evaluates the interpolated solution or derivatives at several times.
+      [get_dky_many s dky ts k dkys] computes the [k]th derivative at each
+      time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+      [dkys], using [dky] as workspace. The array [dkys] must have a row for
+      each element of [dky] and a column for each element of [ts]. All of the
+      evaluations are made in a single call into C.
+
+      @noarkode <node> MRIStepGetDky
+      @raise BadT A time is not in the interval {% $[t_n - h_n, t_n]$%}.
+      @raise BadK [k] is not in the range \{0, 1, ..., dord\}.
+      @raise Invalid_argument The sizes of [dky], [ts], and [dkys] do not agree. *)
+  val get_dky_many : (Nvector_serial.data, 'k) session
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> RealArray.t -> int -> RealArray2.t -> unit
+
   (** Reinitializes the solver with new parameters and state values. The
       values of the independent variable, i.e., the simulation time, and the
       state variables must be given. If given, [roots] specifies a new root
@@ -2607,6 +3005,28 @@ module MRIStep : sig (* {{{ *)
     -> ('d, 'k) Nvector.t
     -> unit
 
+  (** Solving families of independent problems with a single session, as
+      described for {!Cvode.Ensemble}. *)
+  module Ensemble : sig (* {{{ *)
+
+    (** Solves each member of a family of problems from [t0] to [tout],
+        exactly as {!Cvode.Ensemble.solve}. The session is reinitialized
+        with {!reinit} for each member.
+
+        @raise Invalid_argument The array sizes do not match the length of [y]. *)
+    val solve :
+      ?prepare:(int -> unit)
+      -> ?failed:(int -> exn -> unit)
+      -> (Nvector_serial.data, 'k) session
+      -> t0:float
+      -> y0:RealArray2.t
+      -> tout:float
+      -> (Nvector_serial.data, 'k) Nvector.t
+      -> RealArray2.t
+      -> unit
+
+  end (* }}} *)
+
   (** Change the number of equations and unknowns between integrator steps.
       The call
       [resize s ~resize_nvec:rfn ynew t0]
@@ -2766,6 +3186,38 @@ module MRIStep : sig (* {{{ *)
       @noarkode <node> MRIStepGetCurrentTime *)
   val get_current_time        : ('d, 'k) session -> float
 
+  (** Enables or disables profiling of the session. Enabling profiling
+      resets the counters, which then accumulate the number of calls and the
+      time spent in the solver and in each category of callback (see
+      {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+      Profiling is disabled by default. *)
+  val set_profiling : ('d, 'k) session -> bool -> unit
+
+  (** Returns the profiling counters of the session. All of the counters are
+      zero if profiling has never been enabled. See {!set_profiling}. *)
+  val get_profile : ('d, 'k) session -> Sundials.profile
+
+  (** Enables tracing of the session, with a buffer that keeps the given
+      number of most recent events, or disables it if the capacity is zero
+      (see {!Sundials.Trace}). Enabling tracing again discards the events
+      recorded so far. Tracing is independent of profiling and is disabled by
+      default.
+
+      @raise Invalid_argument If the capacity is negative. *)
+  val set_tracing : ('d, 'k) session -> int -> unit
+
+  (** Returns the events recorded in the trace of the session, oldest first.
+      The array is empty if tracing is disabled. See {!set_tracing}. *)
+  val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
+  (** Attaches a recorder to the session, or detaches the current one (see
+      {!Sundials.Recorder}). After each successful call to {!solve_normal},
+      {!solve_one_step}, or {!solve_schedule}, the time reached and the
+      solution are appended to the recording. A session holds at most one
+      recorder, which remains open when it is detached. *)
+  val set_recorder : (Nvector_serial.data, 'k) session
+                     -> Sundials.Recorder.t option -> unit
+
   (** Returns the Butcher tables in use by the solver.
       The call [slow, fast = get_current_butcher_tables s] returns the slow
       and fast butcher tables.
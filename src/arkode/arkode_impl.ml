@@ -239,6 +239,7 @@ type ('a, 'kind, 'step) session = {
   mutable uses_resv    : bool;
 
   mutable exn_temp     : exn option;
+  argcache             : Sundials_impl.arg_cache;
 
   mutable problem      : problem_type; (* ARK only *)
   mutable rhsfn1       : 'a rhsfn;  (* ARK: implicit; ERK: f; MRI: slow *)
@@ -479,6 +480,13 @@ let dummy_rhsfn1 _ _ _ =
   Sundials_impl.crash "Internal error: dummy_rhsfn1 called\n"
 let dummy_rhsfn2 _ _ _ =
   Sundials_impl.crash "Internal error: dummy_rhsfn2 called\n"
+(* Placeholders for native right-hand side functions (see Sundials.cfun).
+   They are distinct from the dummies so that set_imex, etc., still see a
+   function.  *)
+let native_rhsfn1 _ _ _ =
+  Sundials_impl.crash "Internal error: native_rhsfn1 called\n"
+let native_rhsfn2 _ _ _ =
+  Sundials_impl.crash "Internal error: native_rhsfn2 called\n"
 let dummy_rootsfn _ _ _ =
   Sundials_impl.crash "Internal error: dummy_rootsfn called\n"
 let dummy_errh _ =
@@ -162,9 +162,11 @@ static int rhsfn1(realtype t, N_Vector y, N_Vector ydot, void *user_data)
     args[1] = NVEC_BACKLINK(y);
     args[2] = NVEC_BACKLINK(ydot);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(Field(session, RECORD_ARKODE_SESSION_RHSFN1),
 				 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_RHS);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -181,13 +183,44 @@ static int rhsfn2(realtype t, N_Vector y, N_Vector ydot, void *user_data)
     args[1] = NVEC_BACKLINK(y);
     args[2] = NVEC_BACKLINK(ydot);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(Field(session, RECORD_ARKODE_SESSION_RHSFN2),
 				 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_RHS);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
+/* Forward to native right-hand side functions without entering OCaml. */
+static int native_rhsfn1(realtype t, N_Vector y, N_Vector ydot,
+			 void *user_data)
+{
+    struct sunml_cfun *f = &(ARKODE_CDATA(user_data)->rhsfn1);
+    return ((ARKRhsFn)(f->fn))(t, y, ydot, f->data);
+}
+
+static int native_rhsfn2(realtype t, N_Vector y, N_Vector ydot,
+			 void *user_data)
+{
+    struct sunml_cfun *f = &(ARKODE_CDATA(user_data)->rhsfn2);
+    return ((ARKRhsFn)(f->fn))(t, y, ydot, f->data);
+}
+
+#define RHSFN1(cdata) (((cdata)->rhsfn1.fn == NULL) ? rhsfn1 : native_rhsfn1)
+#define RHSFN2(cdata) (((cdata)->rhsfn2.fn == NULL) ? rhsfn2 : native_rhsfn2)
+
+/* Copy an optional Sundials.cfun into the C-side session data.  */
+static void set_cfun(struct sunml_cfun *dst, value vcfun)
+{
+    if (vcfun == Val_none) {
+	dst->fn = NULL;
+	dst->data = NULL;
+    } else {
+	*dst = *CFUN_VAL(Some_val(vcfun));
+    }
+}
+
 static int roots(realtype t, N_Vector y, realtype *gout, void *user_data)
 {
     CAMLparam0();
@@ -195,19 +228,20 @@ static int roots(realtype t, N_Vector y, realtype *gout, void *user_data)
     CAMLlocalN(args, 3);
 
     value *backref = user_data;
-    intnat nroots;
 
     WEAK_DEREF (session, *backref);
 
-    nroots = ARKODE_NROOTS_FROM_ML (session);
-
     args[0] = caml_copy_double (t);
     args[1] = NVEC_BACKLINK (y);
-    args[2] = caml_ba_alloc (BIGARRAY_FLOAT, 1, gout, &nroots);
+    args[2] = sunml_argcache_realarray (ARKODE_ARGCACHE_FROM_ML (session),
+					ARKODE_ARGCACHE_GOUT, gout,
+					ARKODE_NROOTS_FROM_ML (session));
 
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(session, RECORD_ARKODE_SESSION_ROOTSFN),
 				  3, args);
+    sunml_argcache_release_realarray (ARKODE_ARGCACHE_FROM_ML (session),
+				      ARKODE_ARGCACHE_GOUT, args[2]);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, UNRECOVERABLE));
 }
@@ -270,7 +304,9 @@ static int adaptfn(N_Vector y, realtype t,
 
     args[0] = caml_copy_double (t);
     args[1] = NVEC_BACKLINK (y);
-    args[2] = caml_alloc_tuple(RECORD_ARKODE_ADAPTIVITY_ARGS_SIZE);
+    args[2] = sunml_argcache_block (ARKODE_ARGCACHE_FROM_ML (session),
+				    ARKODE_ARGCACHE_ADAPTIVITY_ARGS,
+				    RECORD_ARKODE_ADAPTIVITY_ARGS_SIZE);
 
     Store_field(args[2],RECORD_ARKODE_ADAPTIVITY_ARGS_H1, caml_copy_double(h1));
     Store_field(args[2],RECORD_ARKODE_ADAPTIVITY_ARGS_H2, caml_copy_double(h2));
@@ -357,12 +393,17 @@ static int poststepfn(realtype t, N_Vector y, void *user_data)
 }
 #endif
 
-value sunml_arkode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp)
+/* The argument records are cached in the session and updated in place
+   (see sunml_argcache_block).  */
+value sunml_arkode_make_jac_arg(value session, realtype t, N_Vector y,
+				N_Vector fy, value tmp)
 {
-    CAMLparam1(tmp);
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_ARKODE_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(ARKODE_ARGCACHE_FROM_ML(session),
+			     ARKODE_ARGCACHE_JAC_ARG,
+			     RECORD_ARKODE_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_ARKODE_JACOBIAN_ARG_JAC_T, caml_copy_double(t));
     Store_field(r, RECORD_ARKODE_JACOBIAN_ARG_JAC_Y, NVEC_BACKLINK(y));
     Store_field(r, RECORD_ARKODE_JACOBIAN_ARG_JAC_FY, NVEC_BACKLINK(fy));
@@ -371,12 +412,14 @@ value sunml_arkode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp)
     CAMLreturn(r);
 }
 
-value sunml_arkode_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+value sunml_arkode_make_triple_tmp(value session, N_Vector tmp1,
+				   N_Vector tmp2, N_Vector tmp3)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(3);
+    r = sunml_argcache_block(ARKODE_ARGCACHE_FROM_ML(session),
+			     ARKODE_ARGCACHE_TRIPLE_TMP, 3);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     Store_field(r, 2, NVEC_BACKLINK(tmp3));
@@ -403,12 +446,14 @@ static int jacfn(realtype t,
     cb = ARKODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_arkode_make_jac_arg (t, y, fy,
-				  sunml_arkode_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = MAT_BACKLINK(Jac);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -440,12 +485,14 @@ static int jacfn(long int n,
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_arkode_make_jac_arg (t, y, fy,
-				  sunml_arkode_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = Some_val(dmat);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -476,12 +523,14 @@ static int bandjacfn(long int N,
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_arkode_make_jac_arg(t, y, fy,
-				 sunml_arkode_make_triple_tmp(tmp1, tmp2, tmp3));
+    args[0] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = Some_val(bmat);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -509,7 +558,7 @@ static int precsetupfn(realtype t,
 
     WEAK_DEREF (session, *(value*)user_data);
 
-    args[0] = sunml_arkode_make_jac_arg(t, y, fy, Val_unit);
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, Val_unit);
     args[1] = Val_bool(jok);
     args[2] = caml_copy_double(gamma);
 
@@ -518,8 +567,10 @@ static int precsetupfn(realtype t,
     cb = Field (cb, RECORD_ARKODE_SPILS_PRECFNS_PREC_SETUP_FN);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SETUP);
 
     /* Update jcurPtr; leave it unchanged if an error occurred.  */
     if (!Is_exception_result (r)) {
@@ -531,15 +582,18 @@ static int precsetupfn(realtype t,
     CAMLreturnT(int, sunml_arkode_translate_exception (session, r, RECOVERABLE));
 }
 
-static value make_spils_solve_arg(N_Vector r,
+static value make_spils_solve_arg(value session,
+				  N_Vector r,
 				  realtype gamma,
 				  realtype delta,
 				  int lr)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(v);
 
-    v = caml_alloc_tuple(RECORD_ARKODE_SPILS_SOLVE_ARG_SIZE);
+    v = sunml_argcache_block(ARKODE_ARGCACHE_FROM_ML(session),
+			     ARKODE_ARGCACHE_SPILS_SOLVE_ARG,
+			     RECORD_ARKODE_SPILS_SOLVE_ARG_SIZE);
     Store_field(v, RECORD_ARKODE_SPILS_SOLVE_ARG_RHS, NVEC_BACKLINK(r));
     Store_field(v, RECORD_ARKODE_SPILS_SOLVE_ARG_GAMMA,
                 caml_copy_double(gamma));
@@ -569,17 +623,20 @@ static int precsolvefn(realtype t,
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_arkode_make_jac_arg(t, y, fy, Val_unit);
-    args[1] = make_spils_solve_arg(rvec, gamma, delta, lr);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, Val_unit);
+    args[1] = make_spils_solve_arg(session, rvec, gamma, delta, lr);
     args[2] = NVEC_BACKLINK(z);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = ARKODE_LS_PRECFNS_FROM_ML(session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_ARKODE_SPILS_PRECFNS_PREC_SOLVE_FN);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -596,17 +653,20 @@ static int jactimesfn(N_Vector v,
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_arkode_make_jac_arg(t, y, fy, NVEC_BACKLINK(tmp));
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_arkode_make_jac_arg(session, t, y, fy, NVEC_BACKLINK(tmp));
     args[1] = NVEC_BACKLINK(v);
     args[2] = NVEC_BACKLINK(Jv);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = ARKODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -620,15 +680,18 @@ static int jacsetupfn(realtype t,
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_arkode_make_jac_arg(t, y, fy, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_arkode_make_jac_arg(session, t, y, fy, Val_unit);
+
     cb = ARKODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 1);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn(cb, arg);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -903,11 +966,13 @@ static int massfn(realtype t,
     cb = Field (cb, 0);
 
     args[0] = caml_copy_double(t);
-    args[1] = sunml_arkode_make_triple_tmp (tmp1, tmp2, tmp3);
+    args[1] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
     args[2] = MAT_BACKLINK(M);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -937,11 +1002,13 @@ static int massfn(long int n,
     }
 
     args[0] = caml_copy_double(t);
-    args[1] = sunml_arkode_make_triple_tmp (tmp1, tmp2, tmp3);
+    args[1] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
     args[2] = Some_val(dmat);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -970,15 +1037,19 @@ static int bandmassfn(long int N,
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = caml_alloc_tuple(RECORD_ARKODE_BANDRANGE_SIZE);
+    args[0] = sunml_argcache_block(ARKODE_ARGCACHE_FROM_ML(session),
+				   ARKODE_ARGCACHE_BANDRANGE,
+				   RECORD_ARKODE_BANDRANGE_SIZE);
     Store_field(args[0], RECORD_ARKODE_BANDRANGE_MUPPER, Val_long(mupper));
     Store_field(args[0], RECORD_ARKODE_BANDRANGE_MLOWER, Val_long(mlower));
     args[1] = caml_copy_double(t);
-    args[2] = sunml_arkode_make_triple_tmp(tmp1, tmp2, tmp3);
+    args[2] = sunml_arkode_make_triple_tmp(session, tmp1, tmp2, tmp3);
     args[3] = Some_val(bmat);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 4, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -1002,8 +1073,10 @@ static int masstimesfn(N_Vector v,
     cb = ARKODE_MASS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -1020,8 +1093,10 @@ static int masssetupfn(realtype t,
     cb = Field (cb, 1);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn(cb, caml_copy_double(t));
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -1047,8 +1122,10 @@ static int massprecsetupfn(realtype t,
     cb = Field (cb, RECORD_ARKODE_SPILS_MASS_PRECFNS_PREC_SETUP_FN);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn(cb, caml_copy_double(t));
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SETUP);
 
     /* Update jcurPtr; leave it unchanged if an error occurred.  */
     if (!Is_exception_result (r)) {
@@ -1059,14 +1136,17 @@ static int massprecsetupfn(realtype t,
     CAMLreturnT(int, sunml_arkode_translate_exception (session, r, RECOVERABLE));
 }
 
-static value make_spils_mass_solve_arg(N_Vector r,
+static value make_spils_mass_solve_arg(value session,
+				       N_Vector r,
 				       realtype delta,
 				       int lr)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(v);
 
-    v = caml_alloc_tuple(RECORD_ARKODE_SPILS_MASS_SOLVE_ARG_SIZE);
+    v = sunml_argcache_block(ARKODE_ARGCACHE_FROM_ML(session),
+			     ARKODE_ARGCACHE_SPILS_MASS_SOLVE_ARG,
+			     RECORD_ARKODE_SPILS_MASS_SOLVE_ARG_SIZE);
     Store_field(v, RECORD_ARKODE_SPILS_MASS_SOLVE_ARG_RHS, NVEC_BACKLINK(r));
     Store_field(v, RECORD_ARKODE_SPILS_MASS_SOLVE_ARG_DELTA,
                 caml_copy_double(delta));
@@ -1091,17 +1171,20 @@ static int massprecsolvefn(realtype t,
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
+    WEAK_DEREF (session, *(value*)user_data);
+
     args[0] = caml_copy_double(t);
-    args[1] = make_spils_mass_solve_arg(rvec, delta, lr);
+    args[1] = make_spils_mass_solve_arg(session, rvec, delta, lr);
     args[2] = NVEC_BACKLINK(z);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = ARKODE_MASS_PRECFNS_FROM_ML(session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_ARKODE_SPILS_MASS_PRECFNS_PREC_SOLVE_FN);
 
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -1428,7 +1511,7 @@ static value sunml_arkode_mri_innerstep_exception(void *arkode_mem)
 
 void sunml_arkode_check_flag(const char *call, int flag, void *arkode_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == ARK_SUCCESS
 	    || flag == ARK_ROOT_RETURN
@@ -1547,21 +1630,26 @@ void sunml_arkode_check_flag(const char *call, int flag, void *arkode_mem)
 
 /** ARKStep basic interface **/
 
-/* ARKStepCreate() */
+/* ARKStepCreate().  The optional cfi and cfe arguments give native
+ * implementations of f_i and f_e, respectively.  */
 CAMLprim value sunml_arkode_ark_init(value weakref, value hasfi, value hasfe,
+				     value cfi, value cfe,
 			             value y0, value t0)
 {
-    CAMLparam5(weakref, hasfi, hasfe, y0, t0);
+    CAMLparam5(weakref, hasfi, hasfe, cfi, cfe);
+    CAMLxparam2(y0, t0);
     CAMLlocal2(r, varkode_mem);
 
     value *backref;
+    ARKRhsFn fi = NULL;
+    ARKRhsFn fe = NULL;
+
+    if (Bool_val(hasfi)) fi = (cfi == Val_none) ? rhsfn1 : native_rhsfn1;
+    if (Bool_val(hasfe)) fe = (cfe == Val_none) ? rhsfn2 : native_rhsfn2;
 
 #if 400 <= SUNDIALS_LIB_VERSION
     N_Vector nv_y0 = NVEC_VAL(y0);
-    void *arkode_mem = ARKStepCreate(Bool_val(hasfe)  ? rhsfn2 : NULL,
-				     Bool_val(hasfi)  ? rhsfn1 : NULL,
-				     Double_val(t0),
-				     nv_y0);
+    void *arkode_mem = ARKStepCreate(fe, fi, Double_val(t0), nv_y0);
 
     if (arkode_mem == NULL)
 	caml_failwith("ARKStepCreate returned NULL");
@@ -1569,7 +1657,8 @@ CAMLprim value sunml_arkode_ark_init(value weakref, value hasfi, value hasfe,
     varkode_mem = caml_alloc_final(1, NULL, 1, 5);
     ARKODE_MEM(varkode_mem) = arkode_mem;
 
-    backref = sunml_sundials_malloc_value(weakref);
+    backref = sunml_sundials_malloc_value_ext(weakref,
+					      sizeof(struct arkode_cdata));
     if (backref == NULL) {
 	ARKStepFree (&arkode_mem);
 	caml_raise_out_of_memory();
@@ -1585,23 +1674,22 @@ CAMLprim value sunml_arkode_ark_init(value weakref, value hasfi, value hasfe,
     ARKODE_MEM(varkode_mem) = arkode_mem;
 
     N_Vector nv_y0 = NVEC_VAL(y0);
-    flag = ARKodeInit(arkode_mem,
-		      Bool_val(hasfe)  ? rhsfn2 : NULL,
-		      Bool_val(hasfi)  ? rhsfn1 : NULL,
-		      Double_val(t0),
-		      nv_y0);
+    flag = ARKodeInit(arkode_mem, fe, fi, Double_val(t0), nv_y0);
     if (flag != ARK_SUCCESS) {
 	ARKodeFree (&arkode_mem);
 	CHECK_FLAG("ARKodeInit", flag);
     }
 
-    backref = sunml_sundials_malloc_value(weakref);
+    backref = sunml_sundials_malloc_value_ext(weakref,
+					      sizeof(struct arkode_cdata));
     if (backref == NULL) {
 	ARKodeFree (&arkode_mem);
 	caml_raise_out_of_memory();
     }
     ARKodeSetUserData (arkode_mem, backref);
 #endif
+    set_cfun(&(ARKODE_CDATA(backref)->rhsfn1), cfi);
+    set_cfun(&(ARKODE_CDATA(backref)->rhsfn2), cfe);
 
     r = caml_alloc_tuple (2);
     Store_field (r, 0, varkode_mem);
@@ -1610,6 +1698,18 @@ CAMLprim value sunml_arkode_ark_init(value weakref, value hasfi, value hasfe,
     CAMLreturn(r);
 }
 
+BYTE_STUB7(sunml_arkode_ark_init)
+
+/* Change the native implementations of f_i and f_e.  The new functions are
+ * only passed to ARKODE by the next call to sunml_arkode_ark_reinit.  */
+CAMLprim value sunml_arkode_set_cfuns(value vdata, value cf1, value cf2)
+{
+    CAMLparam3(vdata, cf1, cf2);
+    set_cfun(&(ARKODE_CDATA_FROM_ML(vdata)->rhsfn1), cf1);
+    set_cfun(&(ARKODE_CDATA_FROM_ML(vdata)->rhsfn2), cf2);
+    CAMLreturn (Val_unit);
+}
+
 /* Set the root function to a generic trampoline and set the number of
  * roots.  */
 CAMLprim value sunml_arkode_ark_root_init (value vdata, value vnroots)
@@ -1655,16 +1755,18 @@ CAMLprim value sunml_arkode_ark_reinit(value vdata, value t0, value y0)
     ARKRhsFn fe = NULL;
     ARKRhsFn fi = NULL;
 
+    struct arkode_cdata *cdata = ARKODE_CDATA_FROM_ML(vdata);
+
     switch (ARKODE_PROBLEM(vdata)) {
     case VARIANT_ARKODE_PROBLEM_TYPE_IMPLICIT_ONLY:
-	fi = rhsfn1;
+	fi = RHSFN1(cdata);
 	break;
     case VARIANT_ARKODE_PROBLEM_TYPE_EXPLICIT_ONLY:
-	fe = rhsfn2;
+	fe = RHSFN2(cdata);
 	break;
     case VARIANT_ARKODE_PROBLEM_TYPE_IMPLICIT_AND_EXPLICIT:
-	fe = rhsfn2;
-	fi = rhsfn1;
+	fe = RHSFN2(cdata);
+	fi = RHSFN1(cdata);
 	break;
     }
 
@@ -1682,6 +1784,188 @@ CAMLprim value sunml_arkode_ark_reinit(value vdata, value t0, value y0)
     CAMLreturn (Val_unit);
 }
 
+/* Translate the return value of an evolve function into a solver_result,
+   propagating any exception recorded by a callback or raised for the flag.
+   Must be called immediately after the solver, before anything else is
+   allocated.  */
+static enum arkode_solver_result_tag solver_result(value vdata, int flag,
+						   const char *call)
+{
+    value exn;
+
+    switch (flag) {
+    case ARK_SUCCESS:
+	return VARIANT_ARKODE_SOLVER_RESULT_SUCCESS;
+
+    case ARK_ROOT_RETURN:
+	return VARIANT_ARKODE_SOLVER_RESULT_ROOTSFOUND;
+
+    case ARK_TSTOP_RETURN:
+	return VARIANT_ARKODE_SOLVER_RESULT_STOPTIMEREACHED;
+
+    default:
+	/* If an exception was recorded, propagate it.  This accounts for
+	 * almost all failures except for repeated recoverable failures in the
+	 * residue function.  */
+	exn = Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP);
+	if (Is_block (exn)) {
+	    Store_field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP, Val_none);
+	    /* In bytecode, caml_raise() duplicates some parts of the
+	     * stacktrace.  This does not seem to happen in native code
+	     * execution.  */
+	    caml_raise (Field (exn, 0));
+	}
+	sunml_arkode_check_flag(call, flag, ARKODE_MEM_FROM_ML(vdata));
+    }
+
+    return -1;
+}
+
+/* Sample the step size and the main counters after a call to an evolve
+   function, and mark root returns, if the session is traced (see
+   Sundials.Trace).  The counters that a stepper does not provide are
+   omitted.  These functions do not allocate in the OCaml heap.  */
+typedef void (*trace_stats_fn)(struct sunml_profile *prof, void *arkode_mem,
+			       int flag);
+
+static void ark_trace_stats(struct sunml_profile *prof, void *arkode_mem,
+			    int flag)
+{
+    realtype h;
+    long int n;
+
+    if (!sunml_trace_enabled(prof)) return;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    if (ARKStepGetLastStep(arkode_mem, &h) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (ARKStepGetNumSteps(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (ARKStepGetNumErrTestFails(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_ERR_TEST_FAILS, n);
+    if (ARKStepGetNumNonlinSolvIters(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_NONLIN_ITERS, n);
+#else
+    if (ARKodeGetLastStep(arkode_mem, &h) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (ARKodeGetNumSteps(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (ARKodeGetNumErrTestFails(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_ERR_TEST_FAILS, n);
+    if (ARKodeGetNumNonlinSolvIters(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_NONLIN_ITERS, n);
+#endif
+    if (flag == ARK_ROOT_RETURN)
+	sunml_trace_roots(prof);
+}
+
+#if 400 <= SUNDIALS_LIB_VERSION
+static void erk_trace_stats(struct sunml_profile *prof, void *arkode_mem,
+			    int flag)
+{
+    realtype h;
+    long int n;
+
+    if (!sunml_trace_enabled(prof)) return;
+
+    if (ERKStepGetLastStep(arkode_mem, &h) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (ERKStepGetNumSteps(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (ERKStepGetNumErrTestFails(arkode_mem, &n) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_ERR_TEST_FAILS, n);
+    if (flag == ARK_ROOT_RETURN)
+	sunml_trace_roots(prof);
+}
+
+/* The slow steps.  */
+static void mri_trace_stats(struct sunml_profile *prof, void *arkode_mem,
+			    int flag)
+{
+    realtype h;
+    long int n, nfast;
+
+    if (!sunml_trace_enabled(prof)) return;
+
+    if (MRIStepGetLastStep(arkode_mem, &h) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (MRIStepGetNumSteps(arkode_mem, &n, &nfast) == ARK_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (flag == ARK_ROOT_RETURN)
+	sunml_trace_roots(prof);
+}
+#endif
+
+/* Append the solution to the recording of the session, if any, after a
+   successful call to an evolve function (see Sundials.Recorder).  The
+   methods have a fixed order, which is recorded as zero.  Does not
+   allocate in the OCaml heap.  */
+typedef int (*last_step_fn)(void *arkode_mem, realtype *h);
+
+static void record(value vdata, realtype t, value vy, int flag,
+		   last_step_fn last_step)
+{
+    struct sunml_recorder *rec;
+    realtype h = 0.0;
+
+    if (flag < 0) return;
+    rec = sunml_recorder_of(ARKODE_ARGCACHE_FROM_ML(vdata));
+    if (rec == NULL) return;
+
+    if (sunml_recorder_steps(rec))
+	last_step(ARKODE_MEM_FROM_ML(vdata), &h);
+    sunml_recorder_append(rec, t, Field(vy, 0), h, 0.0);
+}
+
+#if 400 <= SUNDIALS_LIB_VERSION
+#define ARK_LAST_STEP ARKStepGetLastStep
+#else
+#define ARK_LAST_STEP ARKodeGetLastStep
+#endif
+
+/* Integrate to each of the times in vts in turn with the given evolve
+   function, storing the solution in successive columns of vyout.  Stops
+   early when a root or the stop time is reached.  The sizes are checked in
+   OCaml.  */
+static value solve_schedule(value vdata, value vts, value vy, value vyout,
+			    int (*evolve)(void *, realtype, N_Vector,
+					  realtype *, int),
+			    trace_stats_fn trace_stats,
+			    last_step_fn last_step,
+			    const char *call)
+{
+    CAMLparam4(vdata, vts, vy, vyout);
+    CAMLlocal1(ret);
+    void *arkode_mem = ARKODE_MEM_FROM_ML(vdata);
+    N_Vector y = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i = 0, nt = ARRAY1_LEN(vts);
+    realtype tret = ts[0];
+    enum arkode_solver_result_tag result = VARIANT_ARKODE_SOLVER_RESULT_SUCCESS;
+
+    while (i < nt) {
+	SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(vdata));
+	int flag = evolve(arkode_mem, ts[i], y, &tret, ARK_NORMAL);
+	SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+	trace_stats(sunml_profile, arkode_mem, flag);
+	record(vdata, tret, vy, flag, last_step);
+	result = solver_result(vdata, flag, call);
+
+	if (result == VARIANT_ARKODE_SOLVER_RESULT_SUCCESS || tret == ts[i])
+	    sunml_realarray2_set_col(vyout, i++, Field(vy, 0));
+	if (result != VARIANT_ARKODE_SOLVER_RESULT_SUCCESS) break;
+    }
+
+    assert (Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP) == Val_none);
+
+    ret = caml_alloc_tuple (3);
+    Store_field (ret, 0, Val_long (i));
+    Store_field (ret, 1, caml_copy_double (tret));
+    Store_field (ret, 2, Val_int (result));
+
+    CAMLreturn (ret);
+}
+
 static value ark_solver(value vdata, value nextt, value vy, int onestep)
 {
     CAMLparam3(vdata, nextt, vy);
@@ -1689,13 +1973,14 @@ static value ark_solver(value vdata, value nextt, value vy, int onestep)
     realtype tret;
     int flag;
     N_Vector y;
-    enum arkode_solver_result_tag result = -1;
+    enum arkode_solver_result_tag result;
     const char* call;
 
     y = NVEC_VAL (vy);
     // Caml_ba_data_val(y) must not be shifted by the OCaml GC during this
     // function call, which calls Caml through the callback f.  Is this
     // guaranteed?
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(vdata));
 #if 400 <= SUNDIALS_LIB_VERSION
     flag = ARKStepEvolve(ARKODE_MEM_FROM_ML (vdata), Double_val (nextt),
 			 y, &tret, onestep ? ARK_ONE_STEP : ARK_NORMAL);
@@ -1705,34 +1990,11 @@ static value ark_solver(value vdata, value nextt, value vy, int onestep)
 		   y, &tret, onestep ? ARK_ONE_STEP : ARK_NORMAL);
     call = "ARKode";
 #endif
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    ark_trace_stats(sunml_profile, ARKODE_MEM_FROM_ML (vdata), flag);
+    record(vdata, tret, vy, flag, ARK_LAST_STEP);
 
-    switch (flag) {
-    case ARK_SUCCESS:
-	result = VARIANT_ARKODE_SOLVER_RESULT_SUCCESS;
-	break;
-
-    case ARK_ROOT_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_ROOTSFOUND;
-	break;
-
-    case ARK_TSTOP_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_STOPTIMEREACHED;
-	break;
-
-    default:
-	/* If an exception was recorded, propagate it.  This accounts for
-	 * almost all failures except for repeated recoverable failures in the
-	 * residue function.  */
-	ret = Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP);
-	if (Is_block (ret)) {
-	    Store_field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP, Val_none);
-	    /* In bytecode, caml_raise() duplicates some parts of the
-	     * stacktrace.  This does not seem to happen in native code
-	     * execution.  */
-	    caml_raise (Field (ret, 0));
-	}
-	sunml_arkode_check_flag(call, flag, ARKODE_MEM_FROM_ML(vdata));
-    }
+    result = solver_result(vdata, flag, call);
 
     assert (Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP) == Val_none);
 
@@ -1755,6 +2017,20 @@ CAMLprim value sunml_arkode_ark_solve_one_step(value vdata, value nextt, value y
     CAMLreturn(ark_solver(vdata, nextt, y, 1));
 }
 
+CAMLprim value sunml_arkode_ark_solve_schedule(value vdata, value vts,
+					       value vy, value vyout)
+{
+    CAMLparam4(vdata, vts, vy, vyout);
+#if 400 <= SUNDIALS_LIB_VERSION
+    CAMLreturn(solve_schedule(vdata, vts, vy, vyout,
+			      ARKStepEvolve, ark_trace_stats,
+			      ARKStepGetLastStep, "ARKStepEvolve"));
+#else
+    CAMLreturn(solve_schedule(vdata, vts, vy, vyout, ARKode, ark_trace_stats,
+			      ARKodeGetLastStep, "ARKode"));
+#endif
+}
+
 CAMLprim value sunml_arkode_ark_get_dky(value vdata, value vt, value vk, value vy)
 {
     CAMLparam4(vdata, vt, vk, vy);
@@ -1774,6 +2050,33 @@ CAMLprim value sunml_arkode_ark_get_dky(value vdata, value vt, value vk, value v
     CAMLreturn (Val_unit);
 }
 
+/* Evaluate the interpolant at each of the times in vts, using vy as
+   workspace, and store the results in successive columns of vdkys.
+   The sizes are checked in OCaml.  */
+CAMLprim value sunml_arkode_ark_get_dky_many(value vdata, value vts, value vk,
+					     value vy, value vdkys)
+{
+    CAMLparam5(vdata, vts, vk, vy, vdkys);
+
+    void *arkode_mem = ARKODE_MEM_FROM_ML(vdata);
+    N_Vector y_nv = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+#if 400 <= SUNDIALS_LIB_VERSION
+	int flag = ARKStepGetDky(arkode_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("ARKStepGetDky", flag);
+#else
+	int flag = ARKodeGetDky(arkode_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("ARKodeGetDky", flag);
+#endif
+	sunml_realarray2_set_col(vdkys, i, Field(vy, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_arkode_ark_get_err_weights(value varkode_mem, value verrws)
 {
     CAMLparam2(varkode_mem, verrws);
@@ -1831,7 +2134,7 @@ CAMLprim value sunml_arkode_ark_get_est_local_errors(value varkode_mem,
 #if 400 <= SUNDIALS_LIB_VERSION
 void sunml_arkode_check_ls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == ARKLS_SUCCESS) return;
 
@@ -1858,7 +2161,7 @@ void sunml_arkode_check_ls_flag(const char *call, int flag)
 #else
 void sunml_arkode_check_dls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == ARKDLS_SUCCESS) return;
 
@@ -1886,7 +2189,7 @@ void sunml_arkode_check_dls_flag(const char *call, int flag)
 
 void sunml_arkode_check_spils_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == ARKSPILS_SUCCESS) return;
 
@@ -3025,6 +3328,25 @@ CAMLprim value sunml_arkode_ark_get_num_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+/* The _unboxed and _untagged variants of the getters are the entry
+ * points of their [@@noalloc] externals in native code (see arkode.ml).
+ * They ignore the returned flag: the only possible failure is a NULL
+ * memory pointer, which cannot occur for a live session.  The ERKStep
+ * and MRIStep variants do not raise NotImplementedBySundialsVersion
+ * either, since such sessions cannot be created with earlier versions.  */
+CAMLprim intnat sunml_arkode_ark_get_num_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_acc_steps(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3043,6 +3365,19 @@ CAMLprim value sunml_arkode_ark_get_num_acc_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_acc_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumAccSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumAccSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_exp_steps(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3061,6 +3396,19 @@ CAMLprim value sunml_arkode_ark_get_num_exp_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_exp_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumExpSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumExpSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_step_attempts(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3079,6 +3427,19 @@ CAMLprim value sunml_arkode_ark_get_num_step_attempts(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_step_attempts_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumStepAttempts(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumStepAttempts(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_rhs_evals(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3121,6 +3482,19 @@ CAMLprim value sunml_arkode_ark_get_num_lin_solv_setups(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_lin_solv_setups_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumLinSolvSetups(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumLinSolvSetups(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_err_test_fails(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3139,6 +3513,19 @@ CAMLprim value sunml_arkode_ark_get_num_err_test_fails(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_err_test_fails_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumErrTestFails(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumErrTestFails(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_actual_init_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3157,6 +3544,19 @@ CAMLprim value sunml_arkode_ark_get_actual_init_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_ark_get_actual_init_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetActualInitStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetActualInitStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_last_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3175,6 +3575,19 @@ CAMLprim value sunml_arkode_ark_get_last_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_ark_get_last_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetLastStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetLastStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_current_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3193,6 +3606,19 @@ CAMLprim value sunml_arkode_ark_get_current_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_ark_get_current_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetCurrentStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetCurrentStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_current_time(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3211,6 +3637,19 @@ CAMLprim value sunml_arkode_ark_get_current_time(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_ark_get_current_time_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetCurrentTime(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetCurrentTime(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_set_max_num_steps(value varkode_mem, value mxsteps)
 {
     CAMLparam2(varkode_mem, mxsteps);
@@ -3844,6 +4283,19 @@ CAMLprim value sunml_arkode_ark_get_tol_scale_factor(value varkode_mem)
     CAMLreturn(caml_copy_double(r));
 }
 
+CAMLprim double sunml_arkode_ark_get_tol_scale_factor_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetTolScaleFactor(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetTolScaleFactor(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_nonlin_solv_iters(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3860,6 +4312,19 @@ CAMLprim value sunml_arkode_ark_get_num_nonlin_solv_iters(value varkode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_nonlin_solv_iters_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumNonlinSolvIters(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumNonlinSolvIters(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_num_nonlin_solv_conv_fails(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3876,6 +4341,19 @@ CAMLprim value sunml_arkode_ark_get_num_nonlin_solv_conv_fails(value varkode_mem
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_nonlin_solv_conv_fails_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumNonlinSolvConvFails(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumNonlinSolvConvFails(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_nonlin_solv_stats(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -3915,6 +4393,19 @@ CAMLprim value sunml_arkode_ark_get_num_g_evals(value varkode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_arkode_ark_get_num_g_evals_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ARKStepGetNumGEvals(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#else
+    ARKodeGetNumGEvals(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_ark_get_lin_work_space(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -4561,15 +5052,18 @@ CAMLprim value sunml_arkode_ark_write_butcher(value varkode_mem, value vlog)
  * ERKStep basic interface
  */
 
-/* ERKStepCreate() */
-CAMLprim value sunml_arkode_erk_init(value weakref, value y0, value t0)
+/* ERKStepCreate().  The optional cf argument gives a native implementation
+ * of the right-hand side function.  */
+CAMLprim value sunml_arkode_erk_init(value weakref, value y0, value t0,
+				     value cf)
 {
-    CAMLparam3(weakref, y0, t0);
+    CAMLparam4(weakref, y0, t0, cf);
     CAMLlocal2(r, varkode_mem);
 #if 400 <= SUNDIALS_LIB_VERSION
     value *backref;
 
-    void *arkode_mem = ERKStepCreate(rhsfn1, Double_val(t0), NVEC_VAL(y0));
+    void *arkode_mem = ERKStepCreate((cf == Val_none) ? rhsfn1 : native_rhsfn1,
+				     Double_val(t0), NVEC_VAL(y0));
 
     if (arkode_mem == NULL)
 	caml_failwith("ERKStepCreate returned NULL");
@@ -4577,11 +5071,13 @@ CAMLprim value sunml_arkode_erk_init(value weakref, value y0, value t0)
     varkode_mem = caml_alloc_final(1, NULL, 1, 5);
     ARKODE_MEM(varkode_mem) = arkode_mem;
 
-    backref = sunml_sundials_malloc_value(weakref);
+    backref = sunml_sundials_malloc_value_ext(weakref,
+					      sizeof(struct arkode_cdata));
     if (backref == NULL) {
 	ERKStepFree (&arkode_mem);
 	caml_raise_out_of_memory();
     }
+    set_cfun(&(ARKODE_CDATA(backref)->rhsfn1), cf);
     ERKStepSetUserData (arkode_mem, backref);
 
     r = caml_alloc_tuple (2);
@@ -4631,7 +5127,8 @@ CAMLprim value sunml_arkode_erk_reinit(value vdata, value t0, value y0)
     CAMLparam3(vdata, t0, y0);
 #if 400 <= SUNDIALS_LIB_VERSION
     int flag = ERKStepReInit(ARKODE_MEM_FROM_ML(vdata),
-			     rhsfn1, Double_val(t0), NVEC_VAL(y0));
+			     RHSFN1(ARKODE_CDATA_FROM_ML(vdata)),
+			     Double_val(t0), NVEC_VAL(y0));
     CHECK_FLAG("ERKStepReInit", flag);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -4647,43 +5144,19 @@ static value erk_solver(value vdata, value nextt, value vy, int onestep)
     realtype tret;
     int flag;
     N_Vector y;
-    enum arkode_solver_result_tag result = -1;
+    enum arkode_solver_result_tag result;
 
     y = NVEC_VAL (vy);
     // Caml_ba_data_val(y) must not be shifted by the OCaml GC during this
     // function call, which calls Caml through the callback f.  Is this
     // guaranteed?
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(vdata));
     flag = ERKStepEvolve(ARKODE_MEM_FROM_ML (vdata), Double_val (nextt),
 			 y, &tret, onestep ? ARK_ONE_STEP : ARK_NORMAL);
-
-    switch (flag) {
-    case ARK_SUCCESS:
-	result = VARIANT_ARKODE_SOLVER_RESULT_SUCCESS;
-	break;
-
-    case ARK_ROOT_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_ROOTSFOUND;
-	break;
-
-    case ARK_TSTOP_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_STOPTIMEREACHED;
-	break;
-
-    default:
-	/* If an exception was recorded, propagate it.  This accounts for
-	 * almost all failures except for repeated recoverable failures in the
-	 * residue function.  */
-	ret = Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP);
-	if (Is_block (ret)) {
-	    Store_field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP, Val_none);
-	    /* In bytecode, caml_raise() duplicates some parts of the
-	     * stacktrace.  This does not seem to happen in native code
-	     * execution.  */
-	    caml_raise (Field (ret, 0));
-	}
-	sunml_arkode_check_flag("ERKStepEvolve", flag,
-				ARKODE_MEM_FROM_ML(vdata));
-    }
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    erk_trace_stats(sunml_profile, ARKODE_MEM_FROM_ML (vdata), flag);
+    record(vdata, tret, vy, flag, ERKStepGetLastStep);
+    result = solver_result(vdata, flag, "ERKStepEvolve");
 
     assert (Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP) == Val_none);
 
@@ -4709,6 +5182,20 @@ CAMLprim value sunml_arkode_erk_solve_one_step(value vdata, value nextt, value y
     CAMLreturn(erk_solver(vdata, nextt, y, 1));
 }
 
+CAMLprim value sunml_arkode_erk_solve_schedule(value vdata, value vts,
+					       value vy, value vyout)
+{
+    CAMLparam4(vdata, vts, vy, vyout);
+#if 400 <= SUNDIALS_LIB_VERSION
+    CAMLreturn(solve_schedule(vdata, vts, vy, vyout,
+			      ERKStepEvolve, erk_trace_stats,
+			      ERKStepGetLastStep, "ERKStepEvolve"));
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+    CAMLreturn(Val_unit);
+#endif
+}
+
 CAMLprim value sunml_arkode_erk_get_dky(value vdata, value vt, value vk, value vy)
 {
     CAMLparam4(vdata, vt, vk, vy);
@@ -4722,6 +5209,27 @@ CAMLprim value sunml_arkode_erk_get_dky(value vdata, value vt, value vk, value v
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_arkode_erk_get_dky_many(value vdata, value vts, value vk,
+					     value vy, value vdkys)
+{
+    CAMLparam5(vdata, vts, vk, vy, vdkys);
+#if 400 <= SUNDIALS_LIB_VERSION
+    void *arkode_mem = ARKODE_MEM_FROM_ML(vdata);
+    N_Vector y_nv = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = ERKStepGetDky(arkode_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("ERKStepGetDky", flag);
+	sunml_realarray2_set_col(vdkys, i, Field(vy, 0));
+    }
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_arkode_erk_session_finalize(value vdata)
 {
 #if 400 <= SUNDIALS_LIB_VERSION
@@ -5034,6 +5542,17 @@ CAMLprim value sunml_arkode_erk_get_num_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_actual_init_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5049,6 +5568,17 @@ CAMLprim value sunml_arkode_erk_get_actual_init_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_erk_get_actual_init_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetActualInitStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_last_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5064,6 +5594,17 @@ CAMLprim value sunml_arkode_erk_get_last_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_erk_get_last_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetLastStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_current_step(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5079,6 +5620,17 @@ CAMLprim value sunml_arkode_erk_get_current_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_erk_get_current_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetCurrentStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_current_time(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5094,6 +5646,17 @@ CAMLprim value sunml_arkode_erk_get_current_time(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_erk_get_current_time_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetCurrentTime(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_err_weights(value varkode_mem, value verrws)
 {
     CAMLparam2(varkode_mem, verrws);
@@ -5122,6 +5685,17 @@ CAMLprim value sunml_arkode_erk_get_tol_scale_factor(value varkode_mem)
     CAMLreturn(caml_copy_double(r));
 }
 
+CAMLprim double sunml_arkode_erk_get_tol_scale_factor_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetTolScaleFactor(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_num_exp_steps(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5137,6 +5711,17 @@ CAMLprim value sunml_arkode_erk_get_num_exp_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_exp_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumExpSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_num_acc_steps(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5152,6 +5737,17 @@ CAMLprim value sunml_arkode_erk_get_num_acc_steps(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_acc_steps_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumAccSteps(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_num_step_attempts(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5167,6 +5763,17 @@ CAMLprim value sunml_arkode_erk_get_num_step_attempts(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_step_attempts_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumStepAttempts(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_num_rhs_evals(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5186,6 +5793,17 @@ CAMLprim value sunml_arkode_erk_get_num_rhs_evals(value varkode_mem)
     CAMLreturn(r);
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_rhs_evals_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumRhsEvals(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_num_err_test_fails(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5201,6 +5819,17 @@ CAMLprim value sunml_arkode_erk_get_num_err_test_fails(value varkode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_err_test_fails_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumErrTestFails(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_get_est_local_errors(value varkode_mem,
 						     value vele)
 {
@@ -5606,6 +6235,17 @@ CAMLprim value sunml_arkode_erk_get_num_g_evals(value varkode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_arkode_erk_get_num_g_evals_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    ERKStepGetNumGEvals(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_erk_set_no_inactive_root_warn(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -5652,16 +6292,20 @@ CAMLprim value sunml_arkode_erk_write_butcher(value varkode_mem, value vlog)
  * MRIStep basic interface
  */
 
-/* MRIStepCreate() */
-CAMLprim value sunml_arkode_mri_init(value weakref, value y0, value t0)
+/* MRIStepCreate().  The optional cfs and cff arguments give native
+ * implementations of the slow and fast right-hand sides, respectively.  */
+CAMLprim value sunml_arkode_mri_init(value weakref, value y0, value t0,
+				     value cfs, value cff)
 {
-    CAMLparam3(weakref, y0, t0);
+    CAMLparam5(weakref, y0, t0, cfs, cff);
     CAMLlocal2(r, varkode_mem);
 #if 400 <= SUNDIALS_LIB_VERSION
     value *backref;
 
-    void *arkode_mem = MRIStepCreate(rhsfn1, rhsfn2,
-				     Double_val(t0), NVEC_VAL(y0));
+    void *arkode_mem = MRIStepCreate(
+			    (cfs == Val_none) ? rhsfn1 : native_rhsfn1,
+			    (cff == Val_none) ? rhsfn2 : native_rhsfn2,
+			    Double_val(t0), NVEC_VAL(y0));
 
     if (arkode_mem == NULL)
 	caml_failwith("MRIStepCreate returned NULL");
@@ -5669,12 +6313,15 @@ CAMLprim value sunml_arkode_mri_init(value weakref, value y0, value t0)
     varkode_mem = caml_alloc_final(1, NULL, 1, 5);
     ARKODE_MEM(varkode_mem) = arkode_mem;
 
-    backref = sunml_sundials_malloc_value(weakref);
+    backref = sunml_sundials_malloc_value_ext(weakref,
+					      sizeof(struct arkode_cdata));
     if (backref == NULL) {
 	MRIStepFree (&arkode_mem);
 	caml_raise_out_of_memory();
     }
     MRIStepSetUserData (arkode_mem, backref);
+    set_cfun(&(ARKODE_CDATA(backref)->rhsfn1), cfs);
+    set_cfun(&(ARKODE_CDATA(backref)->rhsfn2), cff);
 
     r = caml_alloc_tuple (2);
     Store_field (r, 0, varkode_mem);
@@ -5706,8 +6353,10 @@ CAMLprim value sunml_arkode_mri_reinit(value vdata, value t0, value y0)
 {
     CAMLparam3(vdata, t0, y0);
 #if 400 <= SUNDIALS_LIB_VERSION
+    struct arkode_cdata *cdata = ARKODE_CDATA_FROM_ML(vdata);
     int flag = MRIStepReInit(ARKODE_MEM_FROM_ML(vdata),
-			     rhsfn1, rhsfn2, Double_val(t0), NVEC_VAL(y0));
+			     RHSFN1(cdata), RHSFN2(cdata),
+			     Double_val(t0), NVEC_VAL(y0));
     CHECK_FLAG("MRIStepReInit", flag);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -5723,43 +6372,19 @@ static value mri_solver(value vdata, value nextt, value vy, int onestep)
     realtype tret;
     int flag;
     N_Vector y;
-    enum arkode_solver_result_tag result = -1;
+    enum arkode_solver_result_tag result;
 
     y = NVEC_VAL (vy);
     // Caml_ba_data_val(y) must not be shifted by the OCaml GC during this
     // function call, which calls Caml through the callback f.  Is this
     // guaranteed?
+    SUNML_PROFILE_BEGIN(ARKODE_ARGCACHE_FROM_ML(vdata));
     flag = MRIStepEvolve(ARKODE_MEM_FROM_ML (vdata), Double_val (nextt),
 			 y, &tret, onestep ? ARK_ONE_STEP : ARK_NORMAL);
-
-    switch (flag) {
-    case ARK_SUCCESS:
-	result = VARIANT_ARKODE_SOLVER_RESULT_SUCCESS;
-	break;
-
-    case ARK_ROOT_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_ROOTSFOUND;
-	break;
-
-    case ARK_TSTOP_RETURN:
-	result = VARIANT_ARKODE_SOLVER_RESULT_STOPTIMEREACHED;
-	break;
-
-    default:
-	/* If an exception was recorded, propagate it.  This accounts for
-	 * almost all failures except for repeated recoverable failures in the
-	 * residue function.  */
-	ret = Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP);
-	if (Is_block (ret)) {
-	    Store_field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP, Val_none);
-	    /* In bytecode, caml_raise() duplicates some parts of the
-	     * stacktrace.  This does not seem to happen in native code
-	     * execution.  */
-	    caml_raise (Field (ret, 0));
-	}
-	sunml_arkode_check_flag("MRIStepEvolve", flag,
-				ARKODE_MEM_FROM_ML(vdata));
-    }
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    mri_trace_stats(sunml_profile, ARKODE_MEM_FROM_ML (vdata), flag);
+    record(vdata, tret, vy, flag, MRIStepGetLastStep);
+    result = solver_result(vdata, flag, "MRIStepEvolve");
 
     assert (Field (vdata, RECORD_ARKODE_SESSION_EXN_TEMP) == Val_none);
 
@@ -5785,6 +6410,20 @@ CAMLprim value sunml_arkode_mri_solve_one_step(value vdata, value nextt, value y
     CAMLreturn(mri_solver(vdata, nextt, y, 1));
 }
 
+CAMLprim value sunml_arkode_mri_solve_schedule(value vdata, value vts,
+					       value vy, value vyout)
+{
+    CAMLparam4(vdata, vts, vy, vyout);
+#if 400 <= SUNDIALS_LIB_VERSION
+    CAMLreturn(solve_schedule(vdata, vts, vy, vyout,
+			      MRIStepEvolve, mri_trace_stats,
+			      MRIStepGetLastStep, "MRIStepEvolve"));
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+    CAMLreturn(Val_unit);
+#endif
+}
+
 CAMLprim value sunml_arkode_mri_get_dky(value vdata, value vt, value vk, value vy)
 {
     CAMLparam4(vdata, vt, vk, vy);
@@ -5798,6 +6437,27 @@ CAMLprim value sunml_arkode_mri_get_dky(value vdata, value vt, value vk, value v
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_arkode_mri_get_dky_many(value vdata, value vts, value vk,
+					     value vy, value vdkys)
+{
+    CAMLparam5(vdata, vts, vk, vy, vdkys);
+#if 400 <= SUNDIALS_LIB_VERSION
+    void *arkode_mem = ARKODE_MEM_FROM_ML(vdata);
+    N_Vector y_nv = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = MRIStepGetDky(arkode_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("MRIStepGetDky", flag);
+	sunml_realarray2_set_col(vdkys, i, Field(vy, 0));
+    }
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_arkode_mri_session_finalize(value vdata)
 {
 #if 400 <= SUNDIALS_LIB_VERSION
@@ -5988,6 +6648,17 @@ CAMLprim value sunml_arkode_mri_get_last_step(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_mri_get_last_step_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    MRIStepGetLastStep(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_mri_get_num_rhs_evals(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
@@ -6186,6 +6857,17 @@ CAMLprim value sunml_arkode_mri_get_current_time(value varkode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_arkode_mri_get_current_time_unboxed(value varkode_mem)
+{
+    realtype v = 0.0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    MRIStepGetCurrentTime(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_mri_get_root_info(value vdata, value roots)
 {
     CAMLparam2(vdata, roots);
@@ -6220,6 +6902,17 @@ CAMLprim value sunml_arkode_mri_get_num_g_evals(value varkode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_arkode_mri_get_num_g_evals_untagged(value varkode_mem)
+{
+    long int v = 0;
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    MRIStepGetNumGEvals(ARKODE_MEM_FROM_ML(varkode_mem), &v);
+#endif
+
+    return v;
+}
+
 CAMLprim value sunml_arkode_mri_set_no_inactive_root_warn(value varkode_mem)
 {
     CAMLparam1(varkode_mem);
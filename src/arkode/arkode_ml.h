@@ -18,6 +18,8 @@
 #include <sundials/sundials_nvector.h>
 #include <caml/mlvalues.h>
 
+#include "../sundials/sundials_ml.h"
+
 /*
  * The session data structure is shared in four parts across the OCaml and C
  * heaps:
@@ -100,8 +102,10 @@ void sunml_arkode_check_dls_flag(const char *call, int flag);
 void sunml_arkode_check_spils_flag(const char *call, int flag);
 #endif
 
-value sunml_arkode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp);
-value sunml_arkode_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+value sunml_arkode_make_jac_arg(value session, realtype t, N_Vector y,
+				N_Vector fy, value tmp);
+value sunml_arkode_make_triple_tmp(value session, N_Vector tmp1,
+				   N_Vector tmp2, N_Vector tmp3);
 
 #define CHECK_FLAG(call, flag) if (flag != ARK_SUCCESS) \
 				 sunml_arkode_check_flag(call, flag, NULL)
@@ -147,6 +151,7 @@ enum arkode_session_index {
     RECORD_ARKODE_SESSION_CHECKVEC,
     RECORD_ARKODE_SESSION_USES_RESV,
     RECORD_ARKODE_SESSION_EXN_TEMP,
+    RECORD_ARKODE_SESSION_ARGCACHE,
     RECORD_ARKODE_SESSION_PROBLEM,
     RECORD_ARKODE_SESSION_RHSFN1,
     RECORD_ARKODE_SESSION_RHSFN2,
@@ -189,6 +194,32 @@ enum arkode_session_index {
 #define ARKODE_MASS_PRECFNS_FROM_ML(v) \
     Field((v), RECORD_ARKODE_SESSION_MASS_PRECFNS)
 
+/* Purely C-side session data.  It is stored just after the global root, in
+ * the space reserved by sunml_sundials_malloc_value_ext, so that it can be
+ * reached from the user data without passing through the OCaml heap.  */
+struct arkode_cdata {
+    struct sunml_cfun rhsfn1;	/* native rhsfn1 (fn == NULL if not) */
+    struct sunml_cfun rhsfn2;	/* native rhsfn2 (fn == NULL if not) */
+};
+
+#define ARKODE_CDATA(backref) \
+    ((struct arkode_cdata *)SUNML_HEAPREF_EXT(backref))
+#define ARKODE_CDATA_FROM_ML(v) ARKODE_CDATA(ARKODE_BACKREF_FROM_ML(v))
+
+#define ARKODE_ARGCACHE_FROM_ML(v) Field((v), RECORD_ARKODE_SESSION_ARGCACHE)
+
+/* Slots of the callback argument cache (see sunml_argcache_block).  */
+enum arkode_argcache_index {
+  ARKODE_ARGCACHE_GOUT = 0,
+  ARKODE_ARGCACHE_JAC_ARG,
+  ARKODE_ARGCACHE_TRIPLE_TMP,
+  ARKODE_ARGCACHE_SPILS_SOLVE_ARG,
+  ARKODE_ARGCACHE_SPILS_MASS_SOLVE_ARG,
+  ARKODE_ARGCACHE_ADAPTIVITY_ARGS,
+  ARKODE_ARGCACHE_BANDRANGE,
+  ARKODE_ARGCACHE_SIZE
+};
+
 enum arkode_problem_type_tag {
   VARIANT_ARKODE_PROBLEM_TYPE_IMPLICIT_ONLY = 0,
   VARIANT_ARKODE_PROBLEM_TYPE_EXPLICIT_ONLY,
@@ -58,6 +58,9 @@ exception VectorOpErr
 
 let no_roots = (0, dummy_rootsfn)
 
+let masked_roots m g =
+  (RootMask.length m, fun t y gout -> RootMask.eval m (g t y) gout)
+
 type lmm =
   | Adams
   | BDF
@@ -254,7 +257,7 @@ module Dls = struct (* {{{ *)
     | LSI.Superlumt _ ->
         if jac = None then invalid_arg "Superlumt requires Jacobian function";
         session.ls_callbacks <- SlsSuperlumtCallback cb
-    | LSI.Custom _ ->
+    | LSI.Custom _ | LSI.BlockDiag ->
         check_dqjac jac mat;
         session.ls_callbacks <- DirectCustomCallback cb
     | _ -> assert false
@@ -295,6 +298,12 @@ module Dls = struct (* {{{ *)
     LSI.attach ls;
     session.ls_solver <- LSI.HLS hls
 
+  let colored_jac c f { jac_t = t; jac_y = y; jac_fy = fy } jm =
+    Matrix.Coloring.jacobian c (f t) y fy jm
+
+  let incremental_jac t f arg jm =
+    Matrix.Incremental.jacobian t (fun cols jm -> f cols arg jm) jm
+
   (* Sundials < 3.0.0 *)
   let invalidate_callback session =
     if in_compat_mode2 then
@@ -486,6 +495,10 @@ module Spils = struct (* {{{ *)
         c_set_jac_times session (jac_times_setup <> None)
                                 (jac_times_vec <> None)
 
+  let dual_jac_times_vec fd { jac_t; jac_y; jac_tmp; _ } v jv =
+    fd jac_t { Nvector_dual.value = jac_y; Nvector_dual.tangent = v }
+             { Nvector_dual.value = jac_tmp; Nvector_dual.tangent = jv }
+
   let set_jac_times s ?jac_times_setup f =
     if in_compat_mode2 && jac_times_setup <> None then
         raise Config.NotImplementedBySundialsVersion;
@@ -649,28 +662,96 @@ module Spils = struct (* {{{ *)
       ls_check_spils_band s;
       get_num_rhs_evals s
   end (* }}} *)
+
+  module Native = struct (* {{{ *)
+
+    type 'm setup_fn =
+      (unit, RealArray.t) jacobian_arg -> bool -> float -> 'm -> bool
+
+    external c_set_preconditioner : ('a, 'k) session -> unit
+      = "sunml_cvode_set_native_preconditioner"
+
+    let init_preconditioner setup (np : 'm LSI.Iterative.native) session nv =
+      if RealArray.length (Nvector.unwrap nv) <> np.LSI.Iterative.native_size
+      then invalid_arg "Cvode.Spils.Native: wrong number of equations";
+      let m = np.LSI.Iterative.native_matrix in
+      let prec_setup_fn jac jok gamma =
+        let jcur = setup jac jok gamma m in
+        np.LSI.Iterative.native_factor ();
+        jcur
+      in
+      let prec_solve_fn _ { rhs } z = LinearSolver.Native.solve np rhs z in
+      c_set_preconditioner session;
+      session.ls_precfns <-
+        NativePrecFns ({ prec_setup_fn = Some prec_setup_fn; prec_solve_fn },
+                       np.LSI.Iterative.native_cptr)
+
+    let prec_left setup np =
+      LSI.Iterative.(PrecLeft,  init_preconditioner setup np)
+    let prec_right setup np =
+      LSI.Iterative.(PrecRight, init_preconditioner setup np)
+    let prec_both setup np =
+      LSI.Iterative.(PrecBoth,  init_preconditioner setup np)
+  end (* }}} *)
 end (* }}} *)
 
+type structured_tolerance = {
+    rtol  : RealArray.t;
+    atol  : RealArray.t;
+    floor : RealArray.t option;
+    cap   : RealArray.t option;
+    block : int;
+  }
+
 external sv_tolerances  : ('a, 'k) session -> float -> ('a, 'k) nvector -> unit
     = "sunml_cvode_sv_tolerances"
 external ss_tolerances  : ('a, 'k) session -> float -> float -> unit
     = "sunml_cvode_ss_tolerances"
 external wf_tolerances  : ('a, 'k) session -> unit
     = "sunml_cvode_wf_tolerances"
+external st_tolerances  : ('a, 'k) session -> structured_tolerance -> unit
+    = "sunml_cvode_st_tolerances"
 
 type ('a, 'k) tolerance =
   | SStolerances of float * float
   | SVtolerances of float * ('a, 'k) nvector
   | WFtolerances of 'a error_weight_fun
+  | STtolerances of structured_tolerance
 
 let default_tolerances = SStolerances (1.0e-4, 1.0e-8)
 
+(* The array lengths are checked against the state length in C.  *)
+let check_structured_tolerance { rtol; atol; floor; cap; block } =
+  let nonempty name a =
+    if RealArray.length a = 0
+    then invalid_arg ("structured_tolerances: empty " ^ name)
+  in
+  if block < 1 then invalid_arg "structured_tolerances: block < 1";
+  nonempty "rtol" rtol;
+  nonempty "atol" atol;
+  (match floor with
+   | None -> ()
+   | Some a ->
+       nonempty "floor" a;
+       for i = 0 to RealArray.length a - 1 do
+         if not (a.{i} > 0.0)
+         then invalid_arg "structured_tolerances: floor must be positive"
+       done);
+  (match cap with None -> () | Some a -> nonempty "cap" a)
+
+let structured_tolerances ?floor ?cap ?(block=1) ~rtol ~atol () =
+  let st = { rtol; atol; floor; cap; block } in
+  check_structured_tolerance st;
+  STtolerances st
+
 let set_tolerances s tol =
   match tol with
   | SStolerances (rel, abs) -> (s.errw <- dummy_errw; ss_tolerances s rel abs)
   | SVtolerances (rel, abs) -> (if Sundials_configuration.safe then s.checkvec abs;
                                 s.errw <- dummy_errw; sv_tolerances s rel abs)
   | WFtolerances ferrw -> (s.errw <- ferrw; wf_tolerances s)
+  | STtolerances st -> (check_structured_tolerance st;
+                        s.errw <- dummy_errw; st_tolerances s st)
 
 external c_session_finalize : ('a, 'kind) session -> unit
     = "sunml_cvode_session_finalize"
@@ -695,12 +776,13 @@ external c_set_nonlinear_solver
 
 external c_init
     : ('a, 'k) session Weak.t -> lmm -> bool -> ('a, 'k) nvector
-      -> float -> (cvode_mem * c_weak_ref)
-    = "sunml_cvode_init"
+      -> float -> Sundials.cfun option -> (cvode_mem * c_weak_ref)
+    = "sunml_cvode_init_byte"
+      "sunml_cvode_init"
 
-let init lmm tol ?(nlsolver : ('data, 'kind,
+let init' lmm tol (nlsolver : ('data, 'kind,
             (('data, 'kind) session) Sundials_NonlinearSolver.integrator)
-           Sundials_NonlinearSolver.t option) ?lsolver f ?(roots=no_roots) t0 y0 =
+           Sundials_NonlinearSolver.t option) lsolver f cfun roots t0 y0 =
   let (nroots, roots) = roots in
   let checkvec = Nvector.check y0 in
   if Sundials_configuration.safe && nroots < 0
@@ -710,7 +792,7 @@ let init lmm tol ?(nlsolver : ('data, 'kind,
              | None -> true
              | Some { NLSI.solver = s } -> s = NLSI.NewtonSolver
   in
-  let cvode_mem, backref = c_init weakref lmm iter y0 t0 in
+  let cvode_mem, backref = c_init weakref lmm iter y0 t0 cfun in
   (* cvode_mem and backref have to be immediately captured in a session and
      associated with the finalizer before we do anything else.  *)
   let session = {
@@ -720,6 +802,7 @@ let init lmm tol ?(nlsolver : ('data, 'kind,
           checkvec     = checkvec;
 
           exn_temp     = None;
+          argcache     = Sundials_impl.make_arg_cache ();
 
           rhsfn        = f;
           rootsfn      = roots;
@@ -753,6 +836,12 @@ let init lmm tol ?(nlsolver : ('data, 'kind,
    | _ -> ());
   session
 
+let init lmm tol ?nlsolver ?lsolver f ?(roots=no_roots) t0 y0 =
+  init' lmm tol nlsolver lsolver f None roots t0 y0
+
+let init_cfun lmm tol ?nlsolver ?lsolver f ?(roots=no_roots) t0 y0 =
+  init' lmm tol nlsolver lsolver dummy_rhsfn (Some f) roots t0 y0
+
 let get_num_roots { nroots } = nroots
 
 (* Sundials < 4.0.0 *)
@@ -767,13 +856,24 @@ external c_reinit
     : ('a, 'k) session -> float -> ('a, 'k) nvector -> unit
     = "sunml_cvode_reinit"
 
-let reinit session ?nlsolver ?lsolver ?roots t0 y0 =
+external c_keep_jacobian : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_matrix_keep_jacobian"
+
+let reinit session ?nlsolver ?lsolver ?roots ?keep_jacobian t0 y0 =
   if Sundials_configuration.safe then session.checkvec y0;
+  if in_compat_mode2 && keep_jacobian <> None
+    then raise Config.NotImplementedBySundialsVersion;
   Dls.invalidate_callback session;
   c_reinit session t0 y0;
   (match lsolver with
    | None -> ()
    | Some linsolv -> linsolv session y0);
+  (match keep_jacobian with
+   | None -> ()
+   | Some keep ->
+       (* the matrix of a new linear solver may differ from the saved one *)
+       if lsolver <> None then c_keep_jacobian session.argcache false;
+       c_keep_jacobian session.argcache keep);
   (if in_compat_mode2_3 then
     match nlsolver with
     | None -> ()
@@ -816,6 +916,75 @@ let solve_one_step s t y =
   if Sundials_configuration.safe then s.checkvec y;
   c_solve_one_step s t y
 
+external c_solve_schedule
+    : ('a, 'k) session -> RealArray.t -> ('a, 'k) nvector -> RealArray2.t
+      -> int * float * solver_result
+    = "sunml_cvode_solve_schedule"
+
+let solve_schedule s ts y yout =
+  if Sundials_configuration.safe then s.checkvec y;
+  if RealArray.length ts = 0
+  then invalid_arg "solve_schedule: no output times";
+  if RealArray2.size yout <> (RealArray.length (Nvector.unwrap y),
+                               RealArray.length ts)
+  then invalid_arg "solve_schedule: array sizes do not match";
+  c_solve_schedule s ts y yout
+
+type budget_result =
+  | Finished of solver_result
+  | Suspended
+
+(* True if integrating the session never enters OCaml: the right-hand side
+   is native, and there are no OCaml root, error, Jacobian, or
+   preconditioner functions, nor custom solvers or matrices.  *)
+let native_callbacks s =
+  let native_matrix (type k m nd nk) (m : (k, m, nd, nk) Matrix.t) =
+    match Matrix.get_id m with
+    | Matrix.Dense | Matrix.Band | Matrix.Sparse -> true
+    | _ -> false
+  in
+  let native_lsolver = function
+    | LSI.NoHLS -> true
+    | LSI.HLS { LSI.solver = LSI.Custom _ } -> false
+    | LSI.HLS { LSI.matrix = Some m } -> native_matrix m
+    | LSI.HLS { LSI.matrix = None } -> true
+  in
+  s.rhsfn == dummy_rhsfn
+  && s.nroots = 0
+  && s.errh == dummy_errh
+  && s.errw == dummy_errw
+  && native_lsolver s.ls_solver
+  && (match s.ls_callbacks with
+      | NoCallbacks | DiagNoCallbacks | SpilsCallback (None, None) -> true
+      | DlsDenseCallback { jacfn } -> jacfn == DirectTypes.no_callback
+      | DlsBandCallback { jacfn } -> jacfn == DirectTypes.no_callback
+      | _ -> false)
+  && (match s.ls_precfns with
+      | NoPrecFns | BandedPrecFns -> true
+      | _ -> false)
+  && (match s.nls_solver with
+      | Some { NLSI.solver = NLSI.CustomSolver _ } -> false
+      | _ -> true)
+  && (match s.sensext with NoSensExt -> true | _ -> false)
+
+external c_solve_budgeted
+    : ('a, 'k) session -> float -> ('a, 'k) nvector -> int * float * bool
+      -> float * solver_result * bool
+    = "sunml_cvode_solve_budgeted"
+
+let solve_budgeted ?(max_steps=500) ?(max_time=0.0) ?(release_runtime=false)
+                   s t y =
+  if Sundials_configuration.safe then s.checkvec y;
+  if max_steps < 0 || max_time < 0.0
+  then invalid_arg "solve_budgeted: negative budget";
+  if release_runtime
+     && (Nvector.get_id y = Nvector.Custom || not (native_callbacks s))
+  then invalid_arg "solve_budgeted: the session has OCaml callbacks";
+  let tret, r, suspended =
+    c_solve_budgeted s t y (max_steps, max_time, release_runtime)
+  in
+  tret, if suspended then Suspended else Finished r
+
 external c_get_dky
     : ('a, 'k) session -> float -> int -> ('a, 'k) nvector -> unit
     = "sunml_cvode_get_dky"
@@ -824,41 +993,133 @@ let get_dky s y =
   if Sundials_configuration.safe then s.checkvec y;
   fun t k -> c_get_dky s t k y
 
+external c_get_dky_many
+    : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) nvector
+      -> RealArray2.t -> unit
+    = "sunml_cvode_get_dky_many"
+
+let get_dky_many s y ts k dkys =
+  if Sundials_configuration.safe then s.checkvec y;
+  if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap y),
+                               RealArray.length ts)
+  then invalid_arg "get_dky_many: array sizes do not match";
+  c_get_dky_many s ts k y dkys
+
+type snapshot
+
+external snapshot : ('a, 'k) session -> snapshot
+    = "sunml_cvode_snapshot"
+
+external restore : ('a, 'k) session -> snapshot -> unit
+    = "sunml_cvode_restore"
+
+module Ensemble = struct (* {{{ *)
+
+  let rec solve_to s tout y =
+    match solve_normal s tout y with
+    | _, RootsFound -> solve_to s tout y
+    | _ -> ()
+
+  let solve ?prepare ?failed s ~t0 ~y0 ~tout y yout =
+    Sundials_sweep_impl.ensemble ~reinit:(fun s t0 y -> reinit s t0 y)
+      ~solve_to ?prepare ?failed s ~t0 ~y0 ~tout y yout
+
+end (* }}} *)
+
+module Parareal = struct (* {{{ *)
+
+  let solve ?max_iters ?keep_jacobian ?map_fine ~coarse ~tol fine ts y u =
+    Sundials_sweep_impl.parareal
+      ~reinit:(fun s t0 y -> reinit s ?keep_jacobian t0 y)
+      ~solve_to:Ensemble.solve_to
+      ?max_iters ?map_fine ~coarse ~tol fine ts y u
+
+end (* }}} *)
+
+module Pool = struct (* {{{ *)
+
+  type 'k t = {
+    create : float -> (Nvector_serial.data, 'k) Nvector.t
+               -> (Nvector_serial.data, 'k) session;
+    free   : (int, (Nvector_serial.data, 'k) session list) Hashtbl.t;
+    mutable busy : ((Nvector_serial.data, 'k) session * int) list;
+  }
+
+  let create create = { create; free = Hashtbl.create 8; busy = [] }
+
+  let acquire p t0 y0 =
+    let n = RealArray.length (Nvector.unwrap y0) in
+    let s =
+      match (try Hashtbl.find p.free n with Not_found -> []) with
+      | s :: ss ->
+          Hashtbl.replace p.free n ss;
+          reinit s t0 y0;
+          s
+      | [] -> p.create t0 y0
+    in
+    p.busy <- (s, n) :: p.busy;
+    s
+
+  let release p s =
+    match (try Some (List.assq s p.busy) with Not_found -> None) with
+    | None -> invalid_arg "Pool.release: session not acquired from this pool"
+    | Some n ->
+        p.busy <- List.filter (fun (s', _) -> s' != s) p.busy;
+        let ss = try Hashtbl.find p.free n with Not_found -> [] in
+        Hashtbl.replace p.free n (s :: ss)
+
+  let clear p = Hashtbl.reset p.free
+
+end (* }}} *)
+
 external get_integrator_stats : ('a, 'k) session -> integrator_stats
     = "sunml_cvode_get_integrator_stats"
 
 external get_work_space         : ('a, 'k) session -> int * int
     = "sunml_cvode_get_work_space"
 
-external get_num_steps          : ('a, 'k) session -> int
-    = "sunml_cvode_get_num_steps"
+external get_num_steps          : ('a, 'k) session -> (int [@untagged])
+    = "sunml_cvode_get_num_steps" "sunml_cvode_get_num_steps_untagged"
+    [@@noalloc]
 
-external get_num_rhs_evals      : ('a, 'k) session -> int
-    = "sunml_cvode_get_num_rhs_evals"
+external get_num_rhs_evals      : ('a, 'k) session -> (int [@untagged])
+    = "sunml_cvode_get_num_rhs_evals" "sunml_cvode_get_num_rhs_evals_untagged"
+    [@@noalloc]
 
-external get_num_lin_solv_setups : ('a, 'k) session -> int
+external get_num_lin_solv_setups : ('a, 'k) session -> (int [@untagged])
     = "sunml_cvode_get_num_lin_solv_setups"
+      "sunml_cvode_get_num_lin_solv_setups_untagged"
+    [@@noalloc]
 
-external get_num_err_test_fails : ('a, 'k) session -> int
+external get_num_err_test_fails : ('a, 'k) session -> (int [@untagged])
     = "sunml_cvode_get_num_err_test_fails"
+      "sunml_cvode_get_num_err_test_fails_untagged"
+    [@@noalloc]
 
-external get_last_order         : ('a, 'k) session -> int
-    = "sunml_cvode_get_last_order"
+external get_last_order         : ('a, 'k) session -> (int [@untagged])
+    = "sunml_cvode_get_last_order" "sunml_cvode_get_last_order_untagged"
+    [@@noalloc]
 
-external get_current_order      : ('a, 'k) session -> int
-    = "sunml_cvode_get_current_order"
+external get_current_order      : ('a, 'k) session -> (int [@untagged])
+    = "sunml_cvode_get_current_order" "sunml_cvode_get_current_order_untagged"
+    [@@noalloc]
 
-external get_actual_init_step   : ('a, 'k) session -> float
+external get_actual_init_step   : ('a, 'k) session -> (float [@unboxed])
     = "sunml_cvode_get_actual_init_step"
+      "sunml_cvode_get_actual_init_step_unboxed"
+    [@@noalloc]
 
-external get_last_step          : ('a, 'k) session -> float
-    = "sunml_cvode_get_last_step"
+external get_last_step          : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_cvode_get_last_step" "sunml_cvode_get_last_step_unboxed"
+    [@@noalloc]
 
-external get_current_step       : ('a, 'k) session -> float
-    = "sunml_cvode_get_current_step"
+external get_current_step       : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_cvode_get_current_step" "sunml_cvode_get_current_step_unboxed"
+    [@@noalloc]
 
-external get_current_time       : ('a, 'k) session -> float
-    = "sunml_cvode_get_current_time"
+external get_current_time       : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_cvode_get_current_time" "sunml_cvode_get_current_time_unboxed"
+    [@@noalloc]
 
 let print_integrator_stats s oc =
   let stats = get_integrator_stats s
@@ -874,6 +1135,54 @@ let print_integrator_stats s oc =
     Printf.fprintf oc "current_step = %e\n"        stats.current_step;
     Printf.fprintf oc "current_time = %e\n"        stats.current_time;
 
+external c_set_tracing : Sundials_impl.arg_cache -> int -> unit
+    = "sunml_sundials_set_tracing"
+
+external c_get_trace : Sundials_impl.arg_cache -> Sundials.Trace.event array
+    = "sunml_sundials_get_trace"
+
+external c_set_recorder
+    : Sundials_impl.arg_cache -> Sundials.Recorder.t option -> unit
+    = "sunml_sundials_set_recorder"
+
+external c_set_profiling : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_sundials_set_profiling"
+
+external c_get_profile : Sundials_impl.arg_cache -> profile
+    = "sunml_sundials_get_profile"
+
+let set_profiling s enable = c_set_profiling s.argcache enable
+
+let get_profile s = c_get_profile s.argcache
+
+let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+let get_trace s = c_get_trace s.argcache
+
+let set_recorder s r = c_set_recorder s.argcache r
+
+type memory_report = {
+  work_space : int * int;
+  lsolver_work_space : int * int;
+  process_nvectors : Nvector.memory;
+}
+
+external c_dls_get_work_space : ('a, 'k) session -> int * int
+    = "sunml_cvode_dls_get_work_space"
+
+let get_memory_report s =
+  let lsolver_work_space =
+    match s.ls_callbacks with
+    | NoCallbacks -> (0, 0)
+    | DiagNoCallbacks -> Diag.get_work_space s
+    | SpilsCallback _ | BSpilsCallback _ | BSpilsCallbackSens _ ->
+        Spils.get_work_space s
+    | _ -> c_dls_get_work_space s
+  in
+  { work_space = get_work_space s;
+    lsolver_work_space;
+    process_nvectors = Nvector.get_memory () }
+
 external set_error_file : ('a, 'k) session -> Logfile.t -> unit
     = "sunml_cvode_set_error_file"
 
@@ -947,11 +1256,15 @@ let set_all_root_directions s rd =
 external set_no_inactive_root_warn      : ('a, 'k) session -> unit
     = "sunml_cvode_set_no_inactive_root_warn"
 
-external get_num_stab_lim_order_reds    : ('a, 'k) session -> int
+external get_num_stab_lim_order_reds    : ('a, 'k) session -> (int [@untagged])
     = "sunml_cvode_get_num_stab_lim_order_reds"
+      "sunml_cvode_get_num_stab_lim_order_reds_untagged"
+    [@@noalloc]
 
-external get_tol_scale_factor           : ('a, 'k) session -> float
+external get_tol_scale_factor           : ('a, 'k) session -> (float [@unboxed])
     = "sunml_cvode_get_tol_scale_factor"
+      "sunml_cvode_get_tol_scale_factor_unboxed"
+    [@@noalloc]
 
 external c_get_err_weights : ('a, 'k) session -> ('a, 'k) nvector -> unit
     = "sunml_cvode_get_err_weights"
@@ -967,17 +1280,22 @@ let get_est_local_errors s ew =
   if Sundials_configuration.safe then s.checkvec ew;
   c_get_est_local_errors s ew
 
-external get_num_nonlin_solv_iters      : ('a, 'k) session -> int
+external get_num_nonlin_solv_iters      : ('a, 'k) session -> (int [@untagged])
     = "sunml_cvode_get_num_nonlin_solv_iters"
+      "sunml_cvode_get_num_nonlin_solv_iters_untagged"
+    [@@noalloc]
 
-external get_num_nonlin_solv_conv_fails : ('a, 'k) session -> int
+external get_num_nonlin_solv_conv_fails : ('a, 'k) session -> (int [@untagged])
     = "sunml_cvode_get_num_nonlin_solv_conv_fails"
+      "sunml_cvode_get_num_nonlin_solv_conv_fails_untagged"
+    [@@noalloc]
 
 external get_nonlin_solv_stats          : ('a, 'k) session -> int * int
     = "sunml_cvode_get_nonlin_solv_stats"
 
-external get_num_g_evals                : ('a, 'k) session -> int
-    = "sunml_cvode_get_num_g_evals"
+external get_num_g_evals                : ('a, 'k) session -> (int [@untagged])
+    = "sunml_cvode_get_num_g_evals" "sunml_cvode_get_num_g_evals_untagged"
+    [@@noalloc]
 
 
 (* Let C code know about some of the values in this module.  *)
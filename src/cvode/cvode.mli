@@ -77,6 +77,13 @@ type 'd triple = 'd * 'd * 'd
 
 (** Arguments common to Jacobian callback functions.
 
+    {warning The record is reused between calls and should not be
+             retained after the callback returns.}
+
+    Only the record is reused: its [jac_t] field, like the other float
+    arguments of callbacks (e.g., [gamma]), is boxed afresh at each call,
+    so callbacks still allocate their float arguments.
+
     @cvode <node5#ss:jacFn> CVLsJacFn
     @cvode <node5#ss:jtimesfn> CVLsJacTimesVecFn
     @cvode <node5#ss:psolveFn> CVLsPrecSolveFn
@@ -154,6 +161,22 @@ module Dls : sig (* {{{ *)
     ('m, RealArray.t, 'kind, [>`Dls]) LinearSolver.t ->
     'kind serial_linear_solver
 
+  (** [colored_jac c f] approximates the Jacobian of the right-hand side
+      function [f] by finite differences, with one evaluation of [f] per
+      color of [c] (see {!Matrix.Coloring}). It is an alternative to a
+      hand-written Jacobian function for sparse and band matrices. *)
+  val colored_jac : 'm Matrix.Coloring.t
+                    -> (float -> RealArray.t -> RealArray.t -> unit)
+                    -> 'm jac_fn
+
+  (** [incremental_jac t f] is a Jacobian function that only recomputes
+      the columns marked dirty in [t] (see {!Matrix.Incremental}). The call
+      [f cols arg jm] must assign the columns [cols] of [jm]; the other
+      columns already hold their last computed values. *)
+  val incremental_jac : 'm Matrix.Incremental.t
+                        -> (int array -> 'm jac_fn)
+                        -> 'm jac_fn
+
   (** {3:stats Solver statistics} *)
 
   (** Returns the sizes of the real and integer workspaces used by a direct
@@ -325,6 +348,48 @@ module Spils : sig (* {{{ *)
     val get_num_rhs_evals : 'kind serial_session -> int
   end (* }}} *)
 
+  (** Native preconditioners (see {!Sundials_LinearSolver.Native}).
+      The setup function fills the matrix of the preconditioner with an
+      approximation of {% $P = I - \gamma J$ %}; the matrix is then factored,
+      and the preconditioner is applied in C, without calling back into
+      OCaml, at each Krylov iteration.  *)
+  module Native : sig (* {{{ *)
+
+    (** A function [setup jac jok gamma m] that fills [m] with an
+        approximation of {% $I - \gamma J$ %}. The arguments [jac], [jok],
+        and [gamma] are as for {!prec_setup_fn}, as is the result, which
+        indicates whether the Jacobian data was recomputed.
+
+        @raise Sundials.RecoverableFailure To signal a recoverable error. *)
+    type 'm setup_fn =
+      (unit, RealArray.t) jacobian_arg -> bool -> float -> 'm -> bool
+
+    (** Left preconditioning with a native preconditioner.
+
+        @cvode <node5#sss:optin_spils> CVodeSetPreconditioner *)
+    val prec_left : 'm setup_fn
+                    -> 'm LinearSolver.Native.t
+                    -> (Nvector_serial.data,
+                        [>Nvector_serial.kind]) preconditioner
+
+    (** Like {!prec_left} but preconditions from the right.
+
+        @cvode <node5#sss:optin_spils> CVodeSetPreconditioner *)
+    val prec_right : 'm setup_fn
+                     -> 'm LinearSolver.Native.t
+                     -> (Nvector_serial.data,
+                         [>Nvector_serial.kind]) preconditioner
+
+    (** Like {!prec_left} but preconditions from both sides, with the same
+        matrix.
+
+        @cvode <node5#sss:optin_spils> CVodeSetPreconditioner *)
+    val prec_both : 'm setup_fn
+                    -> 'm LinearSolver.Native.t
+                    -> (Nvector_serial.data,
+                        [>Nvector_serial.kind]) preconditioner
+  end (* }}} *)
+
   (** {3:lsolvers Solvers} *)
 
   (** Callback functions that preprocess or evaluate Jacobian-related data
@@ -373,6 +438,18 @@ module Spils : sig (* {{{ *)
     -> ('d, 'k) preconditioner
     -> ('d, 'k) linear_solver
 
+  (** Computes exact Jacobian-vector products by forward-mode automatic
+      differentiation. The call [dual_jac_times_vec fd] returns a
+      {!jac_times_vec_fn} that computes {% $J\mathtt{v}$%} with a single call
+      [fd t y fy], where [fd] evaluates the right-hand side function on
+      dual-number vectors (see {!Nvector_dual}). The values of [y] are the
+      current state and its tangents are [v]; the tangents of [fy] receive
+      the product, and its values, stored in the work vector, are
+      discarded. No memory is allocated for the vectors. *)
+  val dual_jac_times_vec :
+    (float -> Nvector_dual.data -> Nvector_dual.data -> unit)
+    -> Nvector_serial.data jac_times_vec_fn
+
   (** {3:set Solver parameters} *)
 
   (** Sets the maximum number of time steps to wait before recomputation of
@@ -492,6 +569,31 @@ end (* }}} *)
     should be avoided ([efun] is not allowed to abort the solver). *)
 type 'data error_weight_fun = 'data -> 'data -> unit
 
+(** Structured tolerances computed natively, without calling back into
+    OCaml. The components of the dependent variable vector are grouped into
+    consecutive blocks of [block] elements. For each component [i] in the
+    group [g], the error weight is
+    [ewt.{i} = 1 / min(cap.{g}, max(floor.{g}, rtol.{g} * s + atol.{g}))],
+    where [s] is the largest [abs y.{j}] in the group. Each array has either
+    one element, which applies to every group, or one element per group.
+
+    The arrays are shared with the session, not copied: they must not be
+    resized, and changes to their contents take effect at the next step.
+    A single array may thus serve as the absolute tolerance of many sessions
+    (compare {{!SVtolerances}SVtolerances}, where Sundials clones the
+    vector for each session).
+
+    Only vectors with contiguous storage (serial, OpenMP, and Pthreads)
+    are supported. The array lengths are checked against the length of the
+    dependent variable vector when the tolerances are set. *)
+type structured_tolerance = {
+    rtol  : RealArray.t;        (** Relative tolerances. *)
+    atol  : RealArray.t;        (** Absolute tolerances. *)
+    floor : RealArray.t option; (** Lower bounds on [1 / ewt]. *)
+    cap   : RealArray.t option; (** Upper bounds on [1 / ewt]. *)
+    block : int;                (** Number of components per group. *)
+  }
+
 (** Tolerance specifications. *)
 type ('data, 'kind) tolerance =
   | SStolerances of float * float
@@ -500,10 +602,27 @@ type ('data, 'kind) tolerance =
     (** [(rel, abs)] : scalar relative and vector absolute tolerances. *)
   | WFtolerances of 'data error_weight_fun
     (** Set the multiplicative error weights for the weighted RMS norm. *)
+  | STtolerances of structured_tolerance
+    (** Structured tolerances evaluated natively.
+        See {!structured_tolerance} and {!structured_tolerances}. *)
 
 (** A default relative tolerance of 1.0e-4 and absolute tolerance of 1.0e-8. *)
 val default_tolerances : ('data, 'kind) tolerance
 
+(** Builds structured tolerances. By default, [block] is 1 and there is no
+    floor or cap.
+
+    @raise Invalid_argument if [block] is not positive, an array is empty,
+                            or a floor element is not positive. *)
+val structured_tolerances :
+     ?floor:RealArray.t
+  -> ?cap:RealArray.t
+  -> ?block:int
+  -> rtol:RealArray.t
+  -> atol:RealArray.t
+  -> unit
+  -> ('data, 'kind) tolerance
+
 (** {2:solver Solver initialization and use} *)
 
 (** Choice of linear multistep method.
@@ -540,6 +659,9 @@ type 'd rhsfn = float -> 'd -> 'd -> unit
     {warning [y] and [gout] should not be accessed after the function has
              returned.}
 
+    The same [gout] array is passed to each call. Once the function has
+    returned, it is empty until the next call.
+
     @cvode <node5#ss:rootFn> cvRootFn *)
 type 'd rootsfn = float -> 'd -> RealArray.t -> unit
 
@@ -591,9 +713,48 @@ val init :
     -> ('data, 'kind) Nvector.t
     -> ('data, 'kind) session
 
+(** Like {!init} but the right-hand side is a native C function rather than
+    an OCaml closure. The function [f] must have the C type
+    [int f(realtype t, N_Vector y, N_Vector ydot, void *data)], where
+    [data] is the pointer given to [sunml_sundials_wrap_cfun], and it must
+    follow the SUNDIALS return value conventions (0 for success, a
+    positive value for a recoverable error, and a negative value for an
+    unrecoverable error). It is called directly by CVODE without entering
+    the OCaml runtime, so it must not call back into OCaml nor access the
+    payloads of the vectors through the OCaml heap. The other callbacks
+    (roots, linear solver, etc.) may still be OCaml closures.
+
+    Recoverable and unrecoverable failures are reported as for {!init},
+    except that no exception can be propagated from [f].
+
+    @cvode <node5#sss:cvodemalloc> CVodeCreate/CVodeInit
+    @cvode <node5#ss:rhsFn> CVRhsFn *)
+val init_cfun :
+    lmm
+    -> ('data, 'kind) tolerance
+    -> ?nlsolver
+         : ('data, 'kind,
+            (('data, 'kind) session) Sundials_NonlinearSolver.integrator)
+           Sundials_NonlinearSolver.t
+    -> ?lsolver  : ('data, 'kind) linear_solver
+    -> Sundials.cfun
+    -> ?roots:(int * 'data rootsfn)
+    -> float
+    -> ('data, 'kind) Nvector.t
+    -> ('data, 'kind) session
+
 (** A convenience value for signalling that there are no roots to monitor. *)
 val no_roots : (int * 'd rootsfn)
 
+(** [masked_roots m g] returns root functions for use with [~roots] that
+    only evaluate the active entries of the mask [m]: {!RootMask.eval}
+    calls [g t y i] for each active index [i]. The mask may be updated between
+    calls to the solver functions.
+
+    The number of root functions is [RootMask.length m]. *)
+val masked_roots :
+  RootMask.t -> (float -> 'd -> int -> float) -> (int * 'd rootsfn)
+
 (** Values returned by the step functions. Failures are indicated by
     exceptions.
 
@@ -639,6 +800,80 @@ val solve_normal : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
 val solve_one_step : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
                         -> float * solver_result
 
+(** Integrates an ODE system over a sequence of output times. The call
+    [n, tret, r = solve_schedule s ts y yout] calls {!solve_normal} for each
+    time in [ts], which must be nonempty and monotonic, and stores the
+    solution at [ts.{i}] in the [i]th column of [yout], using [y] as
+    workspace. The array [yout] must have a row for each element of [y] and
+    a column for each element of [ts]. The whole loop runs in a single call
+    into C.
+
+    It returns [n], the number of columns filled, [tret], the time reached
+    by the last step, and [r], the result of the last step. The loop stops
+    early when a root or the stop time is reached; in that case, [y] holds
+    the solution at [tret] and the call can be resumed with the remaining
+    times once the event has been handled. Exceptions are propagated as for
+    {!solve_normal} with the columns for the times already reached filled.
+
+    @cvode <node5#sss:cvode> CVode (CV_NORMAL)
+    @raise Invalid_argument [ts] is empty or the array sizes do not agree. *)
+val solve_schedule : (Nvector_serial.data, 'k) session -> RealArray.t
+                     -> (Nvector_serial.data, 'k) Nvector.t -> RealArray2.t
+                     -> int * float * solver_result
+
+(** The outcome of a call to {!solve_budgeted}. *)
+type budget_result =
+  | Finished of solver_result (** The requested time, a root, or the stop
+                                  time was reached, as for
+                                  {!solve_normal}. *)
+  | Suspended                 (** The budget was spent first. *)
+
+(** Integrates an ODE system towards a time within a budget of internal
+    steps and elapsed time, so that long integrations can be interleaved
+    with other work. The call
+    [tret, r = solve_budgeted ~max_steps ~max_time s tout yout] takes
+    internal steps, as {!solve_one_step} does, until [tout] is reached or
+    passed, in which case the solution is interpolated at [tout] as for
+    {!solve_normal} and [r] is [Finished Success]; or until a root or the
+    stop time is reached, giving [Finished RootsFound] or
+    [Finished StopTimeReached]; or until [max_steps] steps (default: [500])
+    have been taken or [max_time] seconds have elapsed, giving [Suspended].
+    A budget of [0] is unlimited. A call takes at least one step unless a
+    previous step has already passed [tout].
+
+    In every case, [yout] holds the solution at [tret]. After [Suspended],
+    calling [solve_budgeted] again with the same [tout] resumes the
+    integration, so that a scheduler can yield between calls, for
+    instance:
+{[
+let rec run s tout y =
+  match Cvode.solve_budgeted ~max_time:0.005 s tout y with
+  | _, Cvode.Suspended -> Lwt.pause () >>= fun () -> run s tout y
+  | tret, Cvode.Finished r -> Lwt.return (tret, r)
+]}
+    or with [Eio.Fiber.yield ()] in a loop under Eio.
+
+    If [release_runtime] is [true], the OCaml runtime lock is released
+    during each internal step (except the first step of an integration),
+    so that other threads (or domains) run in parallel. This requires a
+    session that never calls OCaml during a step: its right-hand side must
+    be native (see {!init_cfun}); it must have no root functions, error
+    handler, error weight function, Jacobian function, or preconditioner
+    other than {!Spils.Banded}; and its linear solver, nonlinear solver,
+    and Jacobian matrix must not be custom (nor array-based). The vectors
+    must not be custom either. Sensitivity and adjoint problems are
+    excluded.
+
+    Failures raise the same exceptions as {!solve_normal}.
+
+    @cvode <node5#sss:cvode> CVode (CV_ONE_STEP)
+    @raise Invalid_argument A budget is negative, or [release_runtime] is
+                            [true] but the session has OCaml callbacks. *)
+val solve_budgeted : ?max_steps:int -> ?max_time:float
+                     -> ?release_runtime:bool
+                     -> ('d, 'k) session -> float -> ('d, 'k) Nvector.t
+                     -> float * budget_result
+
 (** Returns the interpolated solution or derivatives.
     [get_dky s dky t k] computes the [k]th derivative of the function at time
     [t], i.e., {% $\frac{d^\mathtt{k}y(\mathtt{t})}{\mathit{dt}^\mathtt{k}}$%},
@@ -656,12 +891,38 @@ val solve_one_step : ('d, 'k) session -> float -> ('d, 'k) Nvector.t
     @raise BadK [k] is not in the range 0, 1, ..., $q_u$. *)
 val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+(** Evaluates the interpolated solution or derivatives at several times.
+    [get_dky_many s dky ts k dkys] computes the [k]th derivative at each
+    time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+    [dkys], using [dky] as workspace. The array [dkys] must have a row for
+    each element of [dky] and a column for each element of [ts]. All of the
+    evaluations are made in a single call into C.
+
+    @cvode <node5#sss:optin_root> CVodeGetDky
+    @raise BadT A time is not in the interval {% $[t_n - h_u, t_n]$%}.
+    @raise BadK [k] is not in the range 0, 1, ..., $q_u$.
+    @raise Invalid_argument The sizes of [dky], [ts], and [dkys] do not agree. *)
+val get_dky_many : (Nvector_serial.data, 'k) session
+                   -> (Nvector_serial.data, 'k) Nvector.t
+                   -> RealArray.t -> int -> RealArray2.t -> unit
+
 (** Reinitializes the solver with new parameters and state values. The
     values of the independent variable, i.e., the simulation time, and the
     state variables must be given. If given, [nlsolver] specifies a nonlinear
     solver, [lsolver] specifies a linear solver, and [roots] specifies a
     new root finding function; both default to unchanged.
 
+    If [keep_jacobian] is [true], the first Jacobian requested after
+    reinitialization is the last one computed, rather than a new
+    evaluation, and subsequent Jacobians are saved for later
+    reinitializations. This only applies to matrix-based linear solvers
+    with a Jacobian function. The restored Jacobian was computed at the
+    state before reinitialization. The solver treats it as current, and its
+    usual heuristics decide when to compute a new one. The iteration matrix
+    is still factored again because the step size restarts. If
+    [keep_jacobian] is [false], Jacobians are no longer saved. By default,
+    the current setting is kept but no Jacobian is restored.
+
     @cvode <node5#sss:cvreinit> CVodeReInit
     @cvode <node>               CVodeSetLinearSolver
     @cvode <node>               CVodeSetNonlinearSolver *)
@@ -672,10 +933,230 @@ val reinit :
                Sundials_NonlinearSolver.t
   -> ?lsolver:('d, 'k) linear_solver
   -> ?roots:(int * 'd rootsfn)
+  -> ?keep_jacobian:bool
   -> float
   -> ('d, 'k) Nvector.t
   -> unit
 
+(** The state of a session at a given time: the Nordsieck array, the step
+    size and order history, the method coefficients, and the counters (see
+    {!snapshot}). *)
+type snapshot
+
+(** Captures the state of a session, typically between two calls to
+    {!solve_one_step} or {!solve_normal}, so that the integration can be
+    resumed later from the same point with {!restore}, for instance to
+    branch into several scenarios. Taking a snapshot copies [q+3] vectors,
+    where [q] is the maximum order, and the vector tolerances, if any.
+
+    @raise Invalid_argument Quadratures, sensitivities, or adjoint problems are active (Cvodes).
+    @raise Config.NotImplementedBySundialsVersion Not available for Sundials >= 4.1.0.
+    @since 4.0.0 *)
+val snapshot : ('d, 'k) session -> snapshot
+
+(** Resets a session to a state captured by {!snapshot}. The integration
+    then resumes with the step size, order, and error history it had at the
+    time of the snapshot, unlike after {!reinit}, and the counters are
+    restored too, as is the state of the rootfinding. A fresh linear solver
+    setup, with a new Jacobian or preconditioner evaluation, is made at the
+    next step, so that restoring the same snapshot always leads to the same
+    solution. The counters of the linear solver, which are kept in its own
+    memory, are not restored.
+
+    The session must be the one from which the snapshot was taken and it
+    must not have been reconfigured in between, i.e., its linear and
+    nonlinear solvers and its root functions must not have been replaced,
+    nor its maximum order changed. Nor may the optional inputs of the
+    integrator (e.g., the tolerances, the step size bounds, the stop time,
+    or the root directions) have been changed since the snapshot: they are
+    not silently reverted.
+
+    The [y] vector passed to the solution functions is not modified.
+
+    @raise Invalid_argument The session has been reconfigured, or its optional inputs changed, since the snapshot.
+    @raise Config.NotImplementedBySundialsVersion Not available for Sundials >= 4.1.0.
+    @since 4.0.0 *)
+val restore : ('d, 'k) session -> snapshot -> unit
+
+(** Solving families of independent problems.
+
+    Parameter sweeps and Monte Carlo studies solve many small systems that
+    differ only in their initial conditions and parameters. The functions
+    of this module solve every member of such a family in turn with a
+    single session, reinitializing it between members, so that the solver
+    memory, linear solver, and vectors are created only once.
+
+    The members are solved sequentially, in the calling thread: no
+    parallelism is used. Since they are independent, larger sweeps can be
+    distributed over several processes by passing each one a slice of the
+    arrays (for instance, with
+    {{:OCAML_DOC_ROOT(Bigarray.Array2.html#VALsub_left)}
+    [Bigarray.Array2.sub_left]} on {!Sundials.RealArray2.unwrap}, which
+    selects a range of columns).
+
+    This description also applies to the [Ensemble] submodules of
+    {!Arkode.ARKStep}, {!Arkode.ERKStep}, and {!Arkode.MRIStep}, which share
+    this implementation. *)
+module Ensemble : sig (* {{{ *)
+
+  (** Solves each member of a family of problems from [t0] to [tout].
+      The call [solve ~prepare ~failed s ~t0 ~y0 ~tout y yout] has as
+      arguments
+      - [prepare], a function called with the index [i] of each member
+                   before it is solved, typically to update the parameters
+                   used by the right-hand side function,
+      - [failed], a function called with the index of a member and the
+                  exception raised while solving it,
+      - [s], a session created for one member of the family,
+      - [t0], the common initial value of the independent variable,
+      - [y0], an array whose [i]th column gives the initial values of the
+              [i]th member,
+      - [tout], the common time at which solutions are desired,
+      - [y], the vector used to initialize [s], which is used as
+             workspace, and,
+      - [yout], an array of the same size as [y0] whose [i]th column
+                receives the solution of the [i]th member at [tout].
+
+      The session is reinitialized with {!reinit} for each member and
+      integrated with {!solve_normal}, which is called again whenever
+      roots are found before [tout]. If [failed] is not given, the first
+      exception aborts the sweep; otherwise, [yout] receives whatever
+      solution was reached for the failed member and the remaining members
+      are solved.
+
+      @raise Invalid_argument The array sizes do not match the length of [y]. *)
+  val solve :
+    ?prepare:(int -> unit)
+    -> ?failed:(int -> exn -> unit)
+    -> (Nvector_serial.data, 'k) session
+    -> t0:float
+    -> y0:RealArray2.t
+    -> tout:float
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> RealArray2.t
+    -> unit
+
+end (* }}} *)
+
+(** Parallel-in-time integration.
+
+    When long integrations already exploit all of the available spatial
+    parallelism, the parareal algorithm splits the time interval into
+    slices, each with its own fine session, and corrects the results of a
+    cheap coarse propagator with fine solutions computed independently on
+    every slice. The iteration converges to the solution of the fine
+    sessions run one after another, and is exact after as many iterations
+    as there are slices. A coarse propagator can be built with a fixed-step
+    explicit method, see {!Arkode.ERKStep.Parareal.coarse}.
+
+    The fine sessions are reinitialized with {!reinit} at each iteration,
+    so that they are created only once. By default, they are solved one
+    after another in the calling thread. Since each iteration solves all
+    of the slices not yet made exact, this costs more than a single
+    sequential fine integration over the whole interval: the algorithm only
+    pays off when the fine solutions of an iteration, which do not depend
+    on each other, are computed in parallel by a [map_fine] function.
+
+    This description also applies to {!Arkode.ARKStep.Parareal} and
+    {!Arkode.ERKStep.Parareal}, which share this implementation. *)
+module Parareal : sig (* {{{ *)
+
+  (** Integrates over a sequence of time slices with the parareal
+      algorithm. The call [k, d = solve ~coarse ~tol fine ts y u] has as
+      arguments
+      - [coarse], a function such that [coarse t0 t1 v] replaces [v], the
+                  value at [t0], by an approximation of the value at [t1],
+      - [tol], the largest change in any component of the solution at the
+               end of any slice for which an iteration is considered to
+               have converged,
+      - [fine], an array giving the session for each slice, which may all
+                be the same session when memory matters more than the
+                reuse of each slice's Jacobian,
+      - [ts], the bounds of the [m] slices, in increasing or decreasing
+              order,
+      - [y], a vector used as workspace, and,
+      - [u], an array with a row for each element of [y] and a column for
+             each element of [ts], whose first column gives the initial
+             values, and whose other columns receive the solution at
+             each [ts.{i}].
+
+      It returns [k], the number of iterations, and [d], the change at the
+      last one. The iteration stops at convergence or after [max_iters]
+      iterations, which defaults to [m]. The slices that the iteration has
+      already made exact are not solved again. If [keep_jacobian] is
+      given, it is passed to {!reinit}, so that each fine session can start
+      from the Jacobian it computed at the previous iteration.
+
+      At each iteration, [map_fine job k m] is called to compute the fine
+      solutions of slices [k] to [m - 1]. It must call [job i yi] once for
+      each such [i], where [yi] is a vector of the same length as [y] that
+      is not used by any other concurrent call. The calls may be made in
+      any order, and in parallel if the sessions in [fine] are distinct.
+      The default calls [job i y] for each slice in turn.
+
+      @raise Invalid_argument The array sizes do not match the length of [y]
+                              or the number of sessions. *)
+  val solve :
+    ?max_iters:int
+    -> ?keep_jacobian:bool
+    -> ?map_fine:((int -> (Nvector_serial.data, 'k) Nvector.t -> unit)
+                  -> int -> int -> unit)
+    -> coarse:(float -> float -> RealArray.t -> unit)
+    -> tol:float
+    -> (Nvector_serial.data, 'k) session array
+    -> RealArray.t
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> RealArray2.t
+    -> int * float
+
+end (* }}} *)
+
+(** Recycling sessions across problems of different sizes.
+
+    Applications that solve a stream of problems, such as the cells of an
+    adaptive mesh, often return to the same few problem sizes. Creating a
+    session allocates the solver memory, the linear solver and its matrix,
+    and, as Sundials before version 5 cannot resize a CVODE session, a new
+    session is needed whenever the size changes. A pool keeps the sessions
+    that are no longer in use, indexed by their size, and reinitializes one
+    of them with {!reinit} when a problem of the same size arrives, so that
+    their workspace is reused. The tolerances, linear solver, and other
+    optional inputs of a recycled session are those it had when it was
+    released. *)
+module Pool : sig (* {{{ *)
+
+  (** A pool of sessions for serial nvectors. *)
+  type 'k t
+
+  (** [create f] returns an empty pool, where [f t0 y0] creates, with
+      {!init}, a session for a problem with initial values [y0] at
+      [t0]. The length of [y0] determines the sizes of the vectors and
+      matrices that [f] creates. *)
+  val create :
+    (float -> (Nvector_serial.data, 'k) Nvector.t
+            -> (Nvector_serial.data, 'k) session)
+    -> 'k t
+
+  (** [acquire p t0 y0] returns a session for a problem of the same length
+      as [y0], starting from [y0] at [t0]. A released session of that length
+      is reinitialized if possible, and a new one is created otherwise. The
+      session belongs to the caller until it is passed to {!release}. *)
+  val acquire :
+    'k t -> float -> (Nvector_serial.data, 'k) Nvector.t
+    -> (Nvector_serial.data, 'k) session
+
+  (** Returns a session obtained from {!acquire} to the pool. The session
+      must not be used again, except by obtaining it from {!acquire}.
+
+      @raise Invalid_argument The session was not acquired from this pool. *)
+  val release : 'k t -> (Nvector_serial.data, 'k) session -> unit
+
+  (** Forgets the released sessions, which are then reclaimed normally by
+      the garbage collector. *)
+  val clear : 'k t -> unit
+
+end (* }}} *)
+
 (** {2:set Modifying the solver (optional input functions)} *)
 
 (** Sets the integration tolerances.
@@ -683,7 +1164,11 @@ val reinit :
     @cvode <node5#sss:cvtolerances> CVodeSStolerances
     @cvode <node5#sss:cvtolerances> CVodeSVtolerances
     @cvode <node5#sss:cvtolerances> CVodeWFtolerances
-    @cvode <node5#ss:ewtsetFn>       CVEwtFn *)
+    @cvode <node5#ss:ewtsetFn>       CVEwtFn
+    @raise Invalid_argument Structured tolerances that are malformed (see
+                            {!structured_tolerances}), that do not match
+                            the length of the dependent variable vector, or
+                            for a vector without contiguous storage. *)
 val set_tolerances : ('d, 'k) session -> ('d, 'k) tolerance -> unit
 
 (** Configure the default error handler to write messages to a file.
@@ -900,6 +1385,59 @@ val get_integrator_stats    : ('d, 'k) session -> integrator_stats
     @cvode <node5#sss:optout_main> CVodeGetIntegratorStats *)
 val print_integrator_stats  : ('d, 'k) session -> out_channel -> unit
 
+(** Enables or disables profiling of the session. Enabling profiling
+    resets the counters, which then accumulate the number of calls and the
+    time spent in the solver and in each category of callback (see
+    {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+    Profiling is disabled by default. *)
+val set_profiling : ('d, 'k) session -> bool -> unit
+
+(** Returns the profiling counters of the session. All of the counters are
+    zero if profiling has never been enabled. See {!set_profiling}. *)
+val get_profile : ('d, 'k) session -> Sundials.profile
+
+(** Enables tracing of the session, with a buffer that keeps the given
+    number of most recent events, or disables it if the capacity is zero
+    (see {!Sundials.Trace}). Enabling tracing again discards the events
+    recorded so far. Tracing is independent of profiling and is disabled by
+    default.
+
+    @raise Invalid_argument If the capacity is negative. *)
+val set_tracing : ('d, 'k) session -> int -> unit
+
+(** Returns the events recorded in the trace of the session, oldest first.
+    The array is empty if tracing is disabled. See {!set_tracing}. *)
+val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
+(** Attaches a recorder to the session, or detaches the current one (see
+    {!Sundials.Recorder}). After each successful call to {!solve_normal},
+    {!solve_one_step}, or {!solve_schedule}, the time reached and the
+    solution are appended to the recording. A session holds at most one
+    recorder, which remains open when it is detached. *)
+val set_recorder : (Nvector_serial.data, 'k) session
+                   -> Sundials.Recorder.t option -> unit
+
+(** A memory report of a session. The sizes of workspaces are given as
+    pairs of the numbers of real and integer words, as reported by Sundials;
+    they include the vectors that it allocates. The nvector counts are not
+    specific to the session: they are process-wide and cover all of the
+    nvectors of the library, since those cloned by Sundials cannot be
+    attributed to a session (linear solvers, for instance, clone their
+    vectors before they are attached to a session). *)
+type memory_report = {
+  work_space : int * int;          (** The integrator, see
+                                       {!get_work_space}. *)
+  lsolver_work_space : int * int;  (** The linear solver, including its
+                                       matrix, or [(0, 0)] if there is
+                                       none. *)
+  process_nvectors : Nvector.memory;
+                                   (** Process-wide counts, see
+                                       {!Nvector.get_memory}. *)
+}
+
+(** Returns a memory report for the session. *)
+val get_memory_report : ('d, 'k) session -> memory_report
+
 (** Returns the number of nonlinear (functional or Newton) iterations performed.
 
     @cvode <node5#sss:optout_main> CVodeGetNumNonlinSolvIters *)
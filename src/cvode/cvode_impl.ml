@@ -362,6 +362,7 @@ type ('a, 'kind) session = {
   checkvec   : (('a, 'kind) Nvector.t -> unit);
 
   mutable exn_temp     : exn option;
+  argcache             : Sundials_impl.arg_cache;
 
   rhsfn                : 'a rhsfn;
   mutable rootsfn      : 'a rootsfn;
@@ -453,6 +454,7 @@ and 'a linsolv_precfns =
   | BPrecFnsSens of 'a AdjointTypes'.SpilsTypes'.precfns_with_sens
 
   | BandedPrecFns
+  | NativePrecFns of 'a SpilsTypes'.precfns * LSI.Iterative.native_cptr
 
   | BBDPrecFns of 'a CvodeBbdParamTypes.precfns
   | BBBDPrecFns of 'a CvodesBbdParamTypes.precfns
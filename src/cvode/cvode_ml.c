@@ -19,6 +19,7 @@
 #include <caml/custom.h>
 #include <caml/fail.h>
 #include <caml/bigarray.h>
+#include <caml/signals.h>
 
 // When we compile with sensitivity (CVODES), we are obliged to use the
 // cvodes/cvodes_* header files. In fact, nearly everything functions
@@ -98,6 +99,8 @@
 #include "../nvectors/nvector_ml.h"
 
 #include <stdio.h>
+#include <time.h>
+#include <string.h>
 #define MAX_ERRMSG_LEN 256
 
 
@@ -192,13 +195,23 @@ static int rhsfn(realtype t, N_Vector y, N_Vector ydot, void *user_data)
     args[1] = NVEC_BACKLINK(y);
     args[2] = NVEC_BACKLINK(ydot);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(Field(session, RECORD_CVODE_SESSION_RHSFN),
 				 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_RHS);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
+/* Forward to a native right-hand side function without entering OCaml. */
+static int native_rhsfn(realtype t, N_Vector y, N_Vector ydot,
+			void *user_data)
+{
+    struct sunml_cfun *f = &(CVODE_CDATA(user_data)->rhsfn);
+    return ((CVRhsFn)(f->fn))(t, y, ydot, f->data);
+}
+
 static int roots(realtype t, N_Vector y, realtype *gout, void *user_data)
 {
     CAMLparam0();
@@ -206,19 +219,20 @@ static int roots(realtype t, N_Vector y, realtype *gout, void *user_data)
     CAMLlocalN(args, 3);
 
     value *backref = user_data;
-    intnat nroots;
 
     WEAK_DEREF (session, *backref);
 
-    nroots = CVODE_NROOTS_FROM_ML (session);
-
     args[0] = caml_copy_double (t);
     args[1] = NVEC_BACKLINK (y);
-    args[2] = caml_ba_alloc (BIGARRAY_FLOAT, 1, gout, &nroots);
+    args[2] = sunml_argcache_realarray (CVODE_ARGCACHE_FROM_ML (session),
+					CVODE_ARGCACHE_GOUT, gout,
+					CVODE_NROOTS_FROM_ML (session));
 
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(session, RECORD_CVODE_SESSION_ROOTSFN),
 				  3, args);
+    sunml_argcache_release_realarray (CVODE_ARGCACHE_FROM_ML (session),
+				      CVODE_ARGCACHE_GOUT, args[2]);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, UNRECOVERABLE));
 }
@@ -244,12 +258,24 @@ static int errw(N_Vector y, N_Vector ewt, void *user_data)
     CAMLreturnT (int, 0);
 }
 
-value sunml_cvode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp)
+/* Compute the error weights from a structured specification without
+   entering OCaml.  */
+static int native_errw(N_Vector y, N_Vector ewt, void *user_data)
 {
-    CAMLparam1(tmp);
+    return sunml_ewtspec_eval(&(CVODE_CDATA(user_data)->ewtspec), y, ewt);
+}
+
+/* The argument records are cached in the session and updated in place
+   (see sunml_argcache_block).  */
+value sunml_cvode_make_jac_arg(value session, realtype t, N_Vector y,
+			       N_Vector fy, value tmp)
+{
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_CVODE_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODE_ARGCACHE_JAC_ARG,
+			     RECORD_CVODE_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_CVODE_JACOBIAN_ARG_JAC_T, caml_copy_double(t));
     Store_field(r, RECORD_CVODE_JACOBIAN_ARG_JAC_Y, NVEC_BACKLINK(y));
     Store_field(r, RECORD_CVODE_JACOBIAN_ARG_JAC_FY, NVEC_BACKLINK(fy));
@@ -258,12 +284,14 @@ value sunml_cvode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp)
     CAMLreturn(r);
 }
 
-value sunml_cvode_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+value sunml_cvode_make_triple_tmp(value session, N_Vector tmp1,
+				  N_Vector tmp2, N_Vector tmp3)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(3);
+    r = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODE_ARGCACHE_TRIPLE_TMP, 3);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     Store_field(r, 2, NVEC_BACKLINK(tmp3));
@@ -287,17 +315,24 @@ static int jacfn(
 
     WEAK_DEREF (session, *(value*)user_data);
 
+    if (sunml_jac_cache_restore(CVODE_ARGCACHE_FROM_ML(session), Jac))
+	CAMLreturnT(int, 0);
+
     cb = CVODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_cvode_make_jac_arg (t, y, fy,
-				  sunml_cvode_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = MAT_BACKLINK(Jac);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
-    CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
+    int rc = CHECK_EXCEPTION(session, r, RECOVERABLE);
+    if (rc == 0) sunml_jac_cache_save(CVODE_ARGCACHE_FROM_ML(session), Jac);
+    CAMLreturnT(int, rc);
 }
 
 #else
@@ -328,12 +363,14 @@ static int jacfn(
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_cvode_make_jac_arg (t, y, fy,
-				  sunml_cvode_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = Some_val(dmat);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -365,12 +402,14 @@ static int bandjacfn(
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_cvode_make_jac_arg(t, y, fy,
-				 sunml_cvode_make_triple_tmp(tmp1, tmp2, tmp3));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, args[0]);
     args[1] = Some_val(bmat);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -397,7 +436,7 @@ static int precsetupfn(realtype t,
 
     WEAK_DEREF (session, *(value*)user_data);
 
-    args[0] = sunml_cvode_make_jac_arg(t, y, fy, Val_unit);
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, Val_unit);
     args[1] = Val_bool(jok);
     args[2] = caml_copy_double(gamma);
 
@@ -406,8 +445,10 @@ static int precsetupfn(realtype t,
     cb = Field (cb, RECORD_CVODE_SPILS_PRECFNS_PREC_SETUP_FN);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SETUP);
 
     /* Update jcurPtr; leave it unchanged if an error occurred.  */
     if (!Is_exception_result (r)) {
@@ -420,16 +461,19 @@ static int precsetupfn(realtype t,
 }
 
 static value make_spils_solve_arg(
+	value session,
 	N_Vector r,
 	realtype gamma,
 	realtype delta,
 	int lr)
 
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(v);
 
-    v = caml_alloc_tuple(RECORD_CVODE_SPILS_SOLVE_ARG_SIZE);
+    v = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODE_ARGCACHE_SPILS_SOLVE_ARG,
+			     RECORD_CVODE_SPILS_SOLVE_ARG_SIZE);
     Store_field(v, RECORD_CVODE_SPILS_SOLVE_ARG_RHS, NVEC_BACKLINK(r));
     Store_field(v, RECORD_CVODE_SPILS_SOLVE_ARG_GAMMA,
                 caml_copy_double(gamma));
@@ -460,21 +504,56 @@ static int precsolvefn(
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_cvode_make_jac_arg(t, y, fy, Val_unit);
-    args[1] = make_spils_solve_arg(rvec, gamma, delta, lr);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, Val_unit);
+    args[1] = make_spils_solve_arg(session, rvec, gamma, delta, lr);
     args[2] = NVEC_BACKLINK(z);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_LS_PRECFNS_FROM_ML(session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_CVODE_SPILS_PRECFNS_PREC_SOLVE_FN);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
 
+/* Native preconditioners (Cvode.Spils.Native): the setup function is the
+   OCaml one (see precsetupfn), but the solve stays in C. */
+static int native_precsolvefn(
+	realtype t,
+	N_Vector y,
+	N_Vector fy,
+	N_Vector rvec,
+	N_Vector z,
+	realtype gamma,
+	realtype delta,
+	int lr,
+	void *user_data
+#if SUNDIALS_LIB_VERSION < 300
+	,
+	N_Vector tmp
+#endif
+	)
+{
+    CAMLparam0();
+    CAMLlocal2(session, cb);
+
+    WEAK_DEREF (session, *(value*)user_data);
+
+    cb = CVODE_LS_PRECFNS_FROM_ML(session);
+
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
+    int r = sunml_lsolver_native_prec_solve(Field(cb, 1), rvec, z);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
+
+    CAMLreturnT(int, r);
+}
+
 static int jactimesfn(N_Vector v,
 		      N_Vector Jv,
 		      realtype t,
@@ -487,17 +566,20 @@ static int jactimesfn(N_Vector v,
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_cvode_make_jac_arg(t, y, fy, NVEC_BACKLINK(tmp));
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_cvode_make_jac_arg(session, t, y, fy, NVEC_BACKLINK(tmp));
     args[1] = NVEC_BACKLINK(v);
     args[2] = NVEC_BACKLINK(Jv);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -511,15 +593,18 @@ static int jacsetupfn(realtype t,
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_cvode_make_jac_arg(t, y, fy, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_cvode_make_jac_arg(session, t, y, fy, Val_unit);
+
     cb = CVODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 1);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn(cb, arg);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -685,6 +770,20 @@ CAMLprim value sunml_cvode_set_preconditioner (value vsession,
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_cvode_set_native_preconditioner (value vsession)
+{
+    CAMLparam1 (vsession);
+    void *mem = CVODE_MEM_FROM_ML (vsession);
+#if 400 <= SUNDIALS_LIB_VERSION
+    int flag = CVodeSetPreconditioner (mem, precsetupfn, native_precsolvefn);
+    CHECK_LS_FLAG ("CVodeSetPreconditioner", flag);
+#else
+    int flag = CVSpilsSetPreconditioner (mem, precsetupfn, native_precsolvefn);
+    CHECK_SPILS_FLAG ("CVSpilsSetPreconditioner", flag);
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvode_set_banded_preconditioner (value vsession,
 						      value vneqs,
 						      value vmupper,
@@ -743,17 +842,35 @@ CAMLprim value sunml_cvode_wf_tolerances (value vdata)
  
     int flag = CVodeWFtolerances(CVODE_MEM_FROM_ML(vdata), errw);
     CHECK_FLAG("CVodeWFtolerances", flag);
+    sunml_ewtspec_free(&(CVODE_CDATA_FROM_ML(vdata)->ewtspec));
+
+    CAMLreturn (Val_unit);
+}
+
+/* The sizes are checked against the state length by sunml_ewtspec_set,
+   before anything is changed, and the other values in OCaml.  */
+CAMLprim value sunml_cvode_st_tolerances (value vdata, value vspec)
+{
+    CAMLparam2(vdata, vspec);
+
+    struct cvode_cdata *cdata = CVODE_CDATA_FROM_ML(vdata);
+
+    sunml_ewtspec_set(&cdata->ewtspec, vspec, cdata->neq);
+    int flag = CVodeWFtolerances(CVODE_MEM_FROM_ML(vdata), native_errw);
+    CHECK_FLAG("CVodeWFtolerances", flag);
 
     CAMLreturn (Val_unit);
 }
 
 /* basic interface */
 
-/* CVodeCreate() + CVodeInit().  */
+/* CVodeCreate() + CVodeInit().  If vcfun is Some f, the right-hand side is
+   the native function f rather than the OCaml closure in the session.  */
 CAMLprim value sunml_cvode_init(value weakref, value lmm, value iter, value initial,
-			        value t0)
+			        value t0, value vcfun)
 {
     CAMLparam5(weakref, lmm, iter, initial, t0);
+    CAMLxparam1(vcfun);
     CAMLlocal2(r, vcvode_mem);
 
     int flag;
@@ -786,17 +903,22 @@ CAMLprim value sunml_cvode_init(value weakref, value lmm, value iter, value init
     CVODE_MEM(vcvode_mem) = cvode_mem;
 
     N_Vector initial_nv = NVEC_VAL(initial);
-    flag = CVodeInit(cvode_mem, rhsfn, Double_val(t0), initial_nv);
+    flag = CVodeInit(cvode_mem, (vcfun == Val_none) ? rhsfn : native_rhsfn,
+		     Double_val(t0), initial_nv);
     if (flag != CV_SUCCESS) {
 	CVodeFree (&cvode_mem);
 	CHECK_FLAG("CVodeInit", flag);
     }
 
-    value *backref = sunml_sundials_malloc_value(weakref);
+    value *backref = sunml_sundials_malloc_value_ext(weakref,
+					    sizeof(struct cvode_cdata));
     if (backref == NULL) {
 	CVodeFree (&cvode_mem);
 	caml_raise_out_of_memory();
     }
+    if (vcfun != Val_none)
+	CVODE_CDATA(backref)->rhsfn = *CFUN_VAL(Some_val(vcfun));
+    CVODE_CDATA(backref)->neq = sunml_nvec_data_length(initial_nv);
     CVodeSetUserData (cvode_mem, backref);
 
     r = caml_alloc_tuple (2);
@@ -806,6 +928,8 @@ CAMLprim value sunml_cvode_init(value weakref, value lmm, value iter, value init
     CAMLreturn(r);
 }
 
+BYTE_STUB6(sunml_cvode_init)
+
 /* Set the root function to a generic trampoline and set the number of
  * roots.  */
 CAMLprim value sunml_cvode_root_init (value vdata, value vnroots)
@@ -828,6 +952,7 @@ CAMLprim value sunml_cvode_sv_tolerances(value vdata, value reltol, value abstol
     int flag = CVodeSVtolerances(CVODE_MEM_FROM_ML(vdata),
 				 Double_val(reltol), atol_nv);
     CHECK_FLAG("CVodeSVtolerances", flag);
+    sunml_ewtspec_free(&(CVODE_CDATA_FROM_ML(vdata)->ewtspec));
 
     CAMLreturn (Val_unit);
 }
@@ -843,50 +968,104 @@ CAMLprim value sunml_cvode_reinit(value vdata, value t0, value y0)
     CAMLreturn (Val_unit);
 }
 
-static value solver(value vdata, value nextt, value vy, int onestep)
+/* Translate the return value of CVode into a solver_result, propagating any
+   exception recorded by a callback or raised for the flag.  Must be called
+   immediately after CVode, before anything else is allocated.  */
+static enum cvode_solver_result_tag solver_result(value vdata, int flag)
 {
-    CAMLparam3(vdata, nextt, vy);
-    CAMLlocal1(ret);
-    realtype tret;
-    int flag;
-    N_Vector y;
-    enum cvode_solver_result_tag result = -1;
-
-    y = NVEC_VAL (vy);
-    // Caml_ba_data_val(y) must not be shifted by the OCaml GC during this
-    // function call, which calls Caml through the callback f.  Is this
-    // guaranteed?
-    flag = CVode (CVODE_MEM_FROM_ML (vdata), Double_val (nextt), y, &tret,
-		  onestep ? CV_ONE_STEP : CV_NORMAL);
+    value exn;
 
     switch (flag) {
     case CV_SUCCESS:
-	result = VARIANT_CVODE_SOLVER_RESULT_SUCCESS;
-	break;
+	return VARIANT_CVODE_SOLVER_RESULT_SUCCESS;
 
     case CV_ROOT_RETURN:
-	result = VARIANT_CVODE_SOLVER_RESULT_ROOTSFOUND;
-	break;
+	return VARIANT_CVODE_SOLVER_RESULT_ROOTSFOUND;
 
     case CV_TSTOP_RETURN:
-	result = VARIANT_CVODE_SOLVER_RESULT_STOPTIMEREACHED;
-	break;
+	return VARIANT_CVODE_SOLVER_RESULT_STOPTIMEREACHED;
 
     default:
 	/* If an exception was recorded, propagate it.  This accounts for
 	 * almost all failures except for repeated recoverable failures in the
 	 * residue function.  */
-	ret = Field (vdata, RECORD_CVODE_SESSION_EXN_TEMP);
-	if (Is_block (ret)) {
+	exn = Field (vdata, RECORD_CVODE_SESSION_EXN_TEMP);
+	if (Is_block (exn)) {
 	    Store_field (vdata, RECORD_CVODE_SESSION_EXN_TEMP, Val_none);
 	    /* In bytecode, caml_raise() duplicates some parts of the
 	     * stacktrace.  This does not seem to happen in native code
 	     * execution.  */
-	    caml_raise (Field (ret, 0));
+	    caml_raise (Field (exn, 0));
 	}
 	sunml_cvode_check_flag("CVode", flag, CVODE_MEM_FROM_ML(vdata));
     }
 
+    return -1;
+}
+
+/* Sample the step size and the main counters after a call to CVode, and
+   mark root returns, if the session is traced (see Sundials.Trace).  Does
+   not allocate in the OCaml heap.  */
+static void trace_stats(struct sunml_profile *prof, void *cvode_mem, int flag)
+{
+    realtype h;
+    long int n;
+
+    if (!sunml_trace_enabled(prof)) return;
+
+    if (CVodeGetLastStep(cvode_mem, &h) == CV_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (CVodeGetNumSteps(cvode_mem, &n) == CV_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (CVodeGetNumErrTestFails(cvode_mem, &n) == CV_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_ERR_TEST_FAILS, n);
+    if (CVodeGetNumNonlinSolvIters(cvode_mem, &n) == CV_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_NONLIN_ITERS, n);
+    if (flag == CV_ROOT_RETURN)
+	sunml_trace_roots(prof);
+}
+
+/* Append the solution to the recording of the session, if any, after a
+   successful call to CVode (see Sundials.Recorder).  Does not allocate in
+   the OCaml heap.  */
+static void record(value vdata, realtype t, value vy, int flag)
+{
+    struct sunml_recorder *rec;
+    realtype h = 0.0;
+    int q = 0;
+
+    if (flag < 0) return;
+    rec = sunml_recorder_of(CVODE_ARGCACHE_FROM_ML(vdata));
+    if (rec == NULL) return;
+
+    if (sunml_recorder_steps(rec)) {
+	CVodeGetLastStep(CVODE_MEM_FROM_ML(vdata), &h);
+	CVodeGetLastOrder(CVODE_MEM_FROM_ML(vdata), &q);
+    }
+    sunml_recorder_append(rec, t, Field(vy, 0), h, q);
+}
+
+static value solver(value vdata, value nextt, value vy, int onestep)
+{
+    CAMLparam3(vdata, nextt, vy);
+    CAMLlocal1(ret);
+    realtype tret;
+    int flag;
+    N_Vector y;
+    enum cvode_solver_result_tag result;
+
+    y = NVEC_VAL (vy);
+    // Caml_ba_data_val(y) must not be shifted by the OCaml GC during this
+    // function call, which calls Caml through the callback f.  Is this
+    // guaranteed?
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(vdata));
+    flag = CVode (CVODE_MEM_FROM_ML (vdata), Double_val (nextt), y, &tret,
+		  onestep ? CV_ONE_STEP : CV_NORMAL);
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    trace_stats(sunml_profile, CVODE_MEM_FROM_ML (vdata), flag);
+    record(vdata, tret, vy, flag);
+    result = solver_result(vdata, flag);
+
     assert (Field (vdata, RECORD_CVODE_SESSION_EXN_TEMP) == Val_none);
 
     ret = caml_alloc_tuple (2);
@@ -908,6 +1087,133 @@ CAMLprim value sunml_cvode_solve_one_step(value vdata, value nextt, value y)
     CAMLreturn(solver(vdata, nextt, y, 1));
 }
 
+/* Integrate to each of the times in vts in turn, storing the solution in
+   successive columns of vyout.  Stops early when a root or the stop time is
+   reached.  The sizes are checked in OCaml.  */
+CAMLprim value sunml_cvode_solve_schedule(value vdata, value vts, value vy,
+					  value vyout)
+{
+    CAMLparam4(vdata, vts, vy, vyout);
+    CAMLlocal1(ret);
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector y = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i = 0, nt = ARRAY1_LEN(vts);
+    realtype tret = ts[0];
+    enum cvode_solver_result_tag result = VARIANT_CVODE_SOLVER_RESULT_SUCCESS;
+
+    while (i < nt) {
+	SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(vdata));
+	int flag = CVode(cvode_mem, ts[i], y, &tret, CV_NORMAL);
+	SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+	trace_stats(sunml_profile, cvode_mem, flag);
+	record(vdata, tret, vy, flag);
+	result = solver_result(vdata, flag);
+
+	if (result == VARIANT_CVODE_SOLVER_RESULT_SUCCESS || tret == ts[i])
+	    sunml_realarray2_set_col(vyout, i++, Field(vy, 0));
+	if (result != VARIANT_CVODE_SOLVER_RESULT_SUCCESS) break;
+    }
+
+    assert (Field (vdata, RECORD_CVODE_SESSION_EXN_TEMP) == Val_none);
+
+    ret = caml_alloc_tuple (3);
+    Store_field (ret, 0, Val_long (i));
+    Store_field (ret, 1, caml_copy_double (tret));
+    Store_field (ret, 2, Val_int (result));
+
+    CAMLreturn (ret);
+}
+
+static double budget_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/* Advance towards vtout by internal steps until it is reached (the
+   solution is then interpolated, as for CV_NORMAL), a root or the stop
+   time is reached, or the budget (max_steps, max_time, release) is spent.
+   A budget of 0 steps or 0.0 seconds is unlimited.
+
+   If release is set, the runtime lock is released around each step, so
+   that other threads can run. The OCaml side checks that no OCaml
+   callbacks are installed. The first step of an integration is always
+   taken with the lock held, since the initial setup may clone vectors,
+   which allocates in the OCaml heap.  */
+CAMLprim value sunml_cvode_solve_budgeted(value vdata, value vtout, value vy,
+					  value vbudget)
+{
+    CAMLparam4(vdata, vtout, vy, vbudget);
+    CAMLlocal1(ret);
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector y = NVEC_VAL(vy);
+    realtype tout = Double_val(vtout);
+    long max_steps = Long_val(Field(vbudget, 0));
+    double max_time = Double_val(Field(vbudget, 1));
+    int release = Bool_val(Field(vbudget, 2));
+    double deadline = (max_time > 0.0) ? budget_clock() + max_time : 0.0;
+    enum cvode_solver_result_tag result = VARIANT_CVODE_SOLVER_RESULT_SUCCESS;
+    int suspended = 0, flag = CV_SUCCESS, unlocked;
+    long nsteps, n;
+    realtype tret, h;
+
+    CVodeGetNumSteps(cvode_mem, &nsteps);
+    SUNML_PROFILE_BEGIN(CVODE_ARGCACHE_FROM_ML(vdata));
+
+    /* A previous step may already have passed tout.  */
+    if (nsteps > 0) {
+	CVodeGetCurrentTime(cvode_mem, &tret);
+	CVodeGetLastStep(cvode_mem, &h);
+	if ((tret - tout) * h >= 0.0) {
+	    flag = CVodeGetDky(cvode_mem, tout, 0, y);
+	    CHECK_FLAG("CVodeGetDky", flag);
+	    tret = tout;
+	    goto done;
+	}
+    }
+
+    for (n = 1; ; ++n) {
+	unlocked = release && nsteps > 0;
+	if (unlocked) caml_enter_blocking_section();
+	flag = CVode(cvode_mem, tout, y, &tret, CV_ONE_STEP);
+	if (unlocked) caml_leave_blocking_section();
+	trace_stats(sunml_profile, cvode_mem, flag);
+	result = solver_result(vdata, flag);
+	nsteps = 1;
+
+	if (result != VARIANT_CVODE_SOLVER_RESULT_SUCCESS) break;
+
+	CVodeGetLastStep(cvode_mem, &h);
+	if ((tret - tout) * h >= 0.0) {
+	    flag = CVodeGetDky(cvode_mem, tout, 0, y);
+	    CHECK_FLAG("CVodeGetDky", flag);
+	    tret = tout;
+	    break;
+	}
+
+	if ((max_steps > 0 && n >= max_steps)
+		|| (deadline > 0.0 && budget_clock() >= deadline)) {
+	    suspended = 1;
+	    break;
+	}
+    }
+
+done:
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    record(vdata, tret, vy, flag);
+
+    assert (Field (vdata, RECORD_CVODE_SESSION_EXN_TEMP) == Val_none);
+
+    ret = caml_alloc_tuple (3);
+    Store_field (ret, 0, caml_copy_double (tret));
+    Store_field (ret, 1, Val_int (result));
+    Store_field (ret, 2, Val_bool (suspended));
+
+    CAMLreturn (ret);
+}
+
 CAMLprim value sunml_cvode_get_dky(value vdata, value vt, value vk, value vy)
 {
     CAMLparam4(vdata, vt, vk, vy);
@@ -921,6 +1227,307 @@ CAMLprim value sunml_cvode_get_dky(value vdata, value vt, value vk, value vy)
     CAMLreturn (Val_unit);
 }
 
+/* Evaluate the interpolant at each of the times in vts, using vy as
+   workspace, and store the results in successive columns of vdkys.
+   The sizes are checked in OCaml.  */
+CAMLprim value sunml_cvode_get_dky_many(value vdata, value vts, value vk,
+					value vy, value vdkys)
+{
+    CAMLparam5(vdata, vts, vk, vy, vdkys);
+
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector y_nv = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = CVodeGetDky(cvode_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("CVodeGetDky", flag);
+	sunml_realarray2_set_col(vdkys, i, Field(vy, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
+/* Snapshots of the integrator state.
+
+   A snapshot is a copy of the solver memory, which holds the step size and
+   order history, the method coefficients, and the counters, together with
+   copies of the Nordsieck array, of the last correction, of the error
+   weights, and of the rootfinding state.  Restoring it copies everything
+   back, so the integration resumes exactly as it would have from the time
+   of the snapshot.  The pointers in the solver memory are restored too,
+   which is only valid if the vectors, the linear and nonlinear solvers, and
+   the root functions have not been replaced in between: this is checked.
+   The optional inputs are also part of the solver memory; rather than
+   silently undo the changes made to them since the snapshot, restoring
+   fails if there are any.
+
+   The linear solver data (the Jacobian and its factorization) is not part
+   of the snapshot.  A setup is forced at the next step, and the setup
+   function is wrapped for that one call so that it reports a convergence
+   failure (CV_FAIL_OTHER), which makes the linear solver reevaluate the
+   Jacobian (or the preconditioner) rather than reuse one computed after
+   the snapshot.  Restoring the same snapshot thus always gives the same
+   future, whatever was done in between.
+
+   The solver memory is only accessible through the headers that Sundials
+   installs before 4.1.0.  */
+
+#if SUNDIALS_LIB_VERSION < 410
+/* The value of MSBP in cvode.c: the maximum number of steps between
+   linear solver setups.  */
+#define SNAPSHOT_MSBP 20
+
+typedef int (*CVodeLSetupFn)(CVodeMem cv_mem, int convfail, N_Vector ypred,
+			     N_Vector fpred, booleantype *jcurPtr,
+			     N_Vector vtemp1, N_Vector vtemp2,
+			     N_Vector vtemp3);
+
+struct cvode_snapshot {
+    struct CVodeMemRec mem;
+    N_Vector zn[L_MAX];
+    N_Vector acor;
+    N_Vector ewt;
+    N_Vector vabstol;		/* if mem.cv_itol == CV_SV */
+    N_Vector tmp;		/* if mem.cv_itol == CV_SV */
+    value ewtspec;		/* Val_unit if none is set */
+
+    /* The rootfinding arrays: glo, ghi, and grout in groots, iroots and
+       rootdir in iroots, and gactive; nrtfn elements each.  */
+    realtype *groots;
+    int *iroots;
+    booleantype *gactive;
+};
+
+#define CVODE_SNAPSHOT(v) (*(struct cvode_snapshot **)Data_custom_val(v))
+
+static void free_cvode_snapshot(struct cvode_snapshot *snap)
+{
+    int j;
+
+    if (snap == NULL) return;
+    for (j = 0; j < L_MAX; ++j)
+	if (snap->zn[j] != NULL) N_VDestroy(snap->zn[j]);
+    if (snap->acor != NULL) N_VDestroy(snap->acor);
+    if (snap->ewt != NULL) N_VDestroy(snap->ewt);
+    if (snap->vabstol != NULL) N_VDestroy(snap->vabstol);
+    if (snap->tmp != NULL) N_VDestroy(snap->tmp);
+    if (snap->ewtspec != Val_unit)
+	caml_remove_generational_global_root(&snap->ewtspec);
+    free(snap->groots);
+    free(snap->iroots);
+    free(snap->gactive);
+    free(snap);
+}
+
+static void finalize_cvode_snapshot(value vsnap)
+{
+    free_cvode_snapshot(CVODE_SNAPSHOT(vsnap));
+}
+
+static N_Vector snapshot_copy(N_Vector v)
+{
+    N_Vector c = N_VClone(v);
+    if (c == NULL) caml_raise_out_of_memory();
+    N_VScale(1.0, v, c);
+    return c;
+}
+
+/* The solver memory is reused, not reallocated, by the functions that the
+   OCaml interface allows between a snapshot and its restoration, except
+   those that replace one of these pointers.  */
+static int cvode_snapshot_matches(CVodeMem cv_mem, struct cvode_snapshot *snap)
+{
+    int j;
+
+    if (cv_mem->cv_lmem != snap->mem.cv_lmem
+	    || cv_mem->cv_acor != snap->mem.cv_acor
+	    || cv_mem->cv_ewt != snap->mem.cv_ewt
+	    || cv_mem->cv_glo != snap->mem.cv_glo
+	    || cv_mem->cv_nrtfn != snap->mem.cv_nrtfn
+	    || cv_mem->cv_qmax != snap->mem.cv_qmax)
+	return 0;
+#if 400 <= SUNDIALS_LIB_VERSION
+    if (cv_mem->NLS != snap->mem.NLS) return 0;
+#endif
+    for (j = 0; j <= snap->mem.cv_qmax; ++j)
+	if (cv_mem->cv_zn[j] != snap->mem.cv_zn[j]) return 0;
+    return 1;
+}
+
+/* The optional inputs that are held in the solver memory.  Those of the
+   linear solver are held in its own memory and are not affected by
+   restoring a snapshot.  */
+static int cvode_snapshot_same_options(CVodeMem cv_mem,
+				       struct cvode_snapshot *snap)
+{
+    CVodeMem old = &snap->mem;
+    struct sunml_ewtspec *es = &(CVODE_CDATA(cv_mem->cv_user_data)->ewtspec);
+    int i;
+
+    if (cv_mem->cv_f != old->cv_f
+	    || cv_mem->cv_lmm != old->cv_lmm
+	    || cv_mem->cv_itol != old->cv_itol
+	    || cv_mem->cv_reltol != old->cv_reltol
+	    || cv_mem->cv_Sabstol != old->cv_Sabstol
+	    || cv_mem->cv_user_efun != old->cv_user_efun
+	    || cv_mem->cv_efun != old->cv_efun
+	    || cv_mem->cv_e_data != old->cv_e_data
+	    || cv_mem->cv_mxstep != old->cv_mxstep
+	    || cv_mem->cv_mxhnil != old->cv_mxhnil
+	    || cv_mem->cv_sldeton != old->cv_sldeton
+	    || cv_mem->cv_hin != old->cv_hin
+	    || cv_mem->cv_hmin != old->cv_hmin
+	    || cv_mem->cv_hmax_inv != old->cv_hmax_inv
+	    || cv_mem->cv_maxnef != old->cv_maxnef
+	    || cv_mem->cv_maxncf != old->cv_maxncf
+	    || cv_mem->cv_nlscoef != old->cv_nlscoef
+	    || cv_mem->cv_gfun != old->cv_gfun
+	    || cv_mem->cv_mxgnull != old->cv_mxgnull)
+	return 0;
+#if SUNDIALS_LIB_VERSION < 400
+    if (cv_mem->cv_iter != old->cv_iter
+	    || cv_mem->cv_maxcor != old->cv_maxcor)
+	return 0;
+#endif
+
+    /* The solver clears the stop time once it is reached, so only a stop
+       time set since the snapshot is a change.  */
+    if (cv_mem->cv_tstopset
+	    && (!old->cv_tstopset || cv_mem->cv_tstop != old->cv_tstop))
+	return 0;
+
+    if ((es->rtol == NULL) != (snap->ewtspec == Val_unit)
+	    || (es->rtol != NULL && es->spec != snap->ewtspec))
+	return 0;
+
+    if (cv_mem->cv_itol == CV_SV) {
+	N_VLinearSum(1.0, cv_mem->cv_Vabstol, -1.0, snap->vabstol, snap->tmp);
+	if (N_VMaxNorm(snap->tmp) != 0.0) return 0;
+    }
+
+    for (i = 0; i < cv_mem->cv_nrtfn; ++i)
+	if (cv_mem->cv_rootdir[i] != snap->iroots[cv_mem->cv_nrtfn + i])
+	    return 0;
+
+    return 1;
+}
+
+/* Installed in place of the linear solver setup function by
+   sunml_cvode_restore, for one call.  */
+static int snapshot_lsetup(CVodeMem cv_mem, int convfail, N_Vector ypred,
+			   N_Vector fpred, booleantype *jcurPtr,
+			   N_Vector vtemp1, N_Vector vtemp2, N_Vector vtemp3)
+{
+    struct cvode_cdata *cdata = CVODE_CDATA(cv_mem->cv_user_data);
+
+    cv_mem->cv_lsetup = (CVodeLSetupFn)cdata->restore_lsetup;
+    return cv_mem->cv_lsetup(cv_mem, CV_FAIL_OTHER, ypred, fpred, jcurPtr,
+			     vtemp1, vtemp2, vtemp3);
+}
+#endif
+
+CAMLprim value sunml_cvode_snapshot(value vdata)
+{
+    CAMLparam1(vdata);
+    CAMLlocal1(vsnap);
+#if SUNDIALS_LIB_VERSION < 410
+    CVodeMem cv_mem = (CVodeMem)CVODE_MEM_FROM_ML(vdata);
+    struct sunml_ewtspec *es = &(CVODE_CDATA_FROM_ML(vdata)->ewtspec);
+    struct cvode_snapshot *snap;
+    int j, nrtfn = cv_mem->cv_nrtfn;
+
+#ifdef SUNDIALSML_WITHSENS
+    if (cv_mem->cv_quadr || cv_mem->cv_sensi || cv_mem->cv_adj)
+	caml_invalid_argument("snapshot: quadratures, sensitivities, or "
+			      "adjoint problems are active");
+#endif
+
+    snap = calloc(1, sizeof(struct cvode_snapshot));
+    if (snap == NULL) caml_raise_out_of_memory();
+    snap->ewtspec = Val_unit;
+    vsnap = caml_alloc_final(1, &finalize_cvode_snapshot, 1, 20);
+    CVODE_SNAPSHOT(vsnap) = snap;
+
+    for (j = 0; j <= cv_mem->cv_qmax; ++j)
+	snap->zn[j] = snapshot_copy(cv_mem->cv_zn[j]);
+    snap->acor = snapshot_copy(cv_mem->cv_acor);
+    snap->ewt = snapshot_copy(cv_mem->cv_ewt);
+    if (cv_mem->cv_itol == CV_SV) {
+	snap->vabstol = snapshot_copy(cv_mem->cv_Vabstol);
+	snap->tmp = snapshot_copy(cv_mem->cv_Vabstol);
+    }
+    if (es->rtol != NULL) {
+	snap->ewtspec = es->spec;
+	caml_register_generational_global_root(&snap->ewtspec);
+    }
+
+    if (nrtfn > 0) {
+	snap->groots = malloc(3 * nrtfn * sizeof(realtype));
+	snap->iroots = malloc(2 * nrtfn * sizeof(int));
+	snap->gactive = malloc(nrtfn * sizeof(booleantype));
+	if (snap->groots == NULL || snap->iroots == NULL
+		|| snap->gactive == NULL)
+	    caml_raise_out_of_memory();
+	memcpy(snap->groots, cv_mem->cv_glo, nrtfn * sizeof(realtype));
+	memcpy(snap->groots + nrtfn, cv_mem->cv_ghi, nrtfn * sizeof(realtype));
+	memcpy(snap->groots + 2 * nrtfn, cv_mem->cv_grout,
+	       nrtfn * sizeof(realtype));
+	memcpy(snap->iroots, cv_mem->cv_iroots, nrtfn * sizeof(int));
+	memcpy(snap->iroots + nrtfn, cv_mem->cv_rootdir, nrtfn * sizeof(int));
+	memcpy(snap->gactive, cv_mem->cv_gactive, nrtfn * sizeof(booleantype));
+    }
+
+    snap->mem = *cv_mem;
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (vsnap);
+}
+
+CAMLprim value sunml_cvode_restore(value vdata, value vsnap)
+{
+    CAMLparam2(vdata, vsnap);
+#if SUNDIALS_LIB_VERSION < 410
+    CVodeMem cv_mem = (CVodeMem)CVODE_MEM_FROM_ML(vdata);
+    struct cvode_cdata *cdata = CVODE_CDATA_FROM_ML(vdata);
+    struct cvode_snapshot *snap = CVODE_SNAPSHOT(vsnap);
+    int j, nrtfn = snap->mem.cv_nrtfn;
+
+    if (!cvode_snapshot_matches(cv_mem, snap))
+	caml_invalid_argument("restore: the session has been reconfigured");
+    if (!cvode_snapshot_same_options(cv_mem, snap))
+	caml_invalid_argument("restore: optional inputs have been changed");
+
+    *cv_mem = snap->mem;
+    for (j = 0; j <= cv_mem->cv_qmax; ++j)
+	N_VScale(1.0, snap->zn[j], cv_mem->cv_zn[j]);
+    N_VScale(1.0, snap->acor, cv_mem->cv_acor);
+    N_VScale(1.0, snap->ewt, cv_mem->cv_ewt);
+
+    if (nrtfn > 0) {
+	memcpy(cv_mem->cv_glo, snap->groots, nrtfn * sizeof(realtype));
+	memcpy(cv_mem->cv_ghi, snap->groots + nrtfn, nrtfn * sizeof(realtype));
+	memcpy(cv_mem->cv_grout, snap->groots + 2 * nrtfn,
+	       nrtfn * sizeof(realtype));
+	memcpy(cv_mem->cv_iroots, snap->iroots, nrtfn * sizeof(int));
+	memcpy(cv_mem->cv_gactive, snap->gactive, nrtfn * sizeof(booleantype));
+    }
+
+    /* force a linear solver setup, with a fresh Jacobian, at the next step */
+    cv_mem->cv_nstlp = cv_mem->cv_nst - SNAPSHOT_MSBP;
+    if (cv_mem->cv_lsetup != NULL
+	    && cv_mem->cv_lsetup != (CVodeLSetupFn)snapshot_lsetup) {
+	cdata->restore_lsetup = (void (*)(void))cv_mem->cv_lsetup;
+	cv_mem->cv_lsetup = (CVodeLSetupFn)snapshot_lsetup;
+    }
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvode_get_err_weights(value vcvode_mem, value verrws)
 {
     CAMLparam2(vcvode_mem, verrws);
@@ -959,7 +1566,7 @@ value sunml_cvode_last_lin_exception(void *cvode_mem)
 
 void sunml_cvode_check_flag(const char *call, int flag, void *cvode_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == CV_SUCCESS
 	    || flag == CV_ROOT_RETURN
@@ -1043,7 +1650,7 @@ void sunml_cvode_check_flag(const char *call, int flag, void *cvode_mem)
 #if SUNDIALS_LIB_VERSION >= 400
 void sunml_cvode_check_ls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == CVLS_SUCCESS) return;
 
@@ -1068,7 +1675,7 @@ void sunml_cvode_check_ls_flag(const char *call, int flag)
 #else
 void sunml_cvode_check_dls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == CVDLS_SUCCESS) return;
 
@@ -1094,7 +1701,7 @@ void sunml_cvode_check_dls_flag(const char *call, int flag)
 
 void sunml_cvode_check_spils_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == CVSPILS_SUCCESS) return;
 
@@ -1124,7 +1731,13 @@ CAMLprim value sunml_cvode_session_finalize(value vdata)
     if (CVODE_MEM_FROM_ML(vdata) != NULL) {
 	void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
 	value *backref = CVODE_BACKREF_FROM_ML(vdata);
+	struct cvode_cdata *cdata = CVODE_CDATA(backref);
 	CVodeFree(&cvode_mem);
+	if (cdata->sens_tmps != NULL)
+	    N_VDestroyVectorArray(cdata->sens_tmps,
+				  2 * (cdata->sens_nthreads - 1));
+	sunml_quadforms_free(&cdata->quadforms);
+	sunml_ewtspec_free(&cdata->ewtspec);
 	sunml_sundials_free_value(backref);
     }
 
@@ -1138,6 +1751,7 @@ CAMLprim value sunml_cvode_ss_tolerances(value vdata, value reltol, value abstol
     int flag = CVodeSStolerances(CVODE_MEM_FROM_ML(vdata),
 		 Double_val(reltol), Double_val(abstol));
     CHECK_FLAG("CVodeSStolerances", flag);
+    sunml_ewtspec_free(&(CVODE_CDATA_FROM_ML(vdata)->ewtspec));
 
     CAMLreturn (Val_unit);
 }
@@ -1323,6 +1937,17 @@ CAMLprim value sunml_cvode_get_num_steps(value vcvode_mem)
     CAMLreturn(Val_long(v));
 }
 
+/* The _unboxed and _untagged variants of the getters are the entry
+ * points of their [@@noalloc] externals in native code (see cvode.ml).
+ * They ignore the returned flag: the only possible failure is a NULL
+ * memory pointer, which cannot occur for a live session.  */
+CAMLprim intnat sunml_cvode_get_num_steps_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumSteps(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_num_rhs_evals(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1336,6 +1961,13 @@ CAMLprim value sunml_cvode_get_num_rhs_evals(value vcvode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_cvode_get_num_rhs_evals_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumRhsEvals(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_num_lin_solv_setups(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1349,6 +1981,13 @@ CAMLprim value sunml_cvode_get_num_lin_solv_setups(value vcvode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_cvode_get_num_lin_solv_setups_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumLinSolvSetups(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_num_err_test_fails(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1362,6 +2001,13 @@ CAMLprim value sunml_cvode_get_num_err_test_fails(value vcvode_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_cvode_get_num_err_test_fails_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumErrTestFails(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_last_order(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1375,6 +2021,13 @@ CAMLprim value sunml_cvode_get_last_order(value vcvode_mem)
     CAMLreturn(Val_int(v));
 }
 
+CAMLprim intnat sunml_cvode_get_last_order_untagged(value vcvode_mem)
+{
+    int v = 0;
+    CVodeGetLastOrder(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_current_order(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1388,6 +2041,13 @@ CAMLprim value sunml_cvode_get_current_order(value vcvode_mem)
     CAMLreturn(Val_int(v));
 }
 
+CAMLprim intnat sunml_cvode_get_current_order_untagged(value vcvode_mem)
+{
+    int v = 0;
+    CVodeGetCurrentOrder(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_actual_init_step(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1401,6 +2061,13 @@ CAMLprim value sunml_cvode_get_actual_init_step(value vcvode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_cvode_get_actual_init_step_unboxed(value vcvode_mem)
+{
+    realtype v = 0.0;
+    CVodeGetActualInitStep(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_last_step(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1414,6 +2081,13 @@ CAMLprim value sunml_cvode_get_last_step(value vcvode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_cvode_get_last_step_unboxed(value vcvode_mem)
+{
+    realtype v = 0.0;
+    CVodeGetLastStep(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_current_step(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1427,6 +2101,13 @@ CAMLprim value sunml_cvode_get_current_step(value vcvode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_cvode_get_current_step_unboxed(value vcvode_mem)
+{
+    realtype v = 0.0;
+    CVodeGetCurrentStep(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_current_time(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1440,6 +2121,13 @@ CAMLprim value sunml_cvode_get_current_time(value vcvode_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_cvode_get_current_time_unboxed(value vcvode_mem)
+{
+    realtype v = 0.0;
+    CVodeGetCurrentTime(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_set_max_ord(value vcvode_mem, value maxord)
 {
     CAMLparam2(vcvode_mem, maxord);
@@ -1676,6 +2364,13 @@ CAMLprim value sunml_cvode_get_num_stab_lim_order_reds(value vcvode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_cvode_get_num_stab_lim_order_reds_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumStabLimOrderReds(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_tol_scale_factor(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1687,6 +2382,13 @@ CAMLprim value sunml_cvode_get_tol_scale_factor(value vcvode_mem)
     CAMLreturn(caml_copy_double(r));
 }
 
+CAMLprim double sunml_cvode_get_tol_scale_factor_unboxed(value vcvode_mem)
+{
+    realtype v = 0.0;
+    CVodeGetTolScaleFactor(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_num_nonlin_solv_iters(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1698,6 +2400,13 @@ CAMLprim value sunml_cvode_get_num_nonlin_solv_iters(value vcvode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_cvode_get_num_nonlin_solv_iters_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumNonlinSolvIters(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_num_nonlin_solv_conv_fails(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1709,6 +2418,13 @@ CAMLprim value sunml_cvode_get_num_nonlin_solv_conv_fails(value vcvode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_cvode_get_num_nonlin_solv_conv_fails_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumNonlinSolvConvFails(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_get_nonlin_solv_stats(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
@@ -1737,6 +2453,13 @@ CAMLprim value sunml_cvode_get_num_g_evals(value vcvode_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_cvode_get_num_g_evals_untagged(value vcvode_mem)
+{
+    long int v = 0;
+    CVodeGetNumGEvals(CVODE_MEM_FROM_ML(vcvode_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_cvode_dls_get_work_space(value vcvode_mem)
 {
     CAMLparam1(vcvode_mem);
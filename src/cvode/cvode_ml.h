@@ -18,6 +18,8 @@
 #include <sundials/sundials_nvector.h>
 #include <caml/mlvalues.h>
 
+#include "../sundials/sundials_ml.h"
+
 /*
  * The session data structure is shared in four parts across the OCaml and C
  * heaps:
@@ -145,8 +147,10 @@ void sunml_cvode_check_dls_flag(const char *call, int flag);
 void sunml_cvode_check_spils_flag(const char *call, int flag);
 #endif
 
-value sunml_cvode_make_jac_arg(realtype t, N_Vector y, N_Vector fy, value tmp);
-value sunml_cvode_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+value sunml_cvode_make_jac_arg(value session, realtype t, N_Vector y,
+			       N_Vector fy, value tmp);
+value sunml_cvode_make_triple_tmp(value session, N_Vector tmp1,
+				  N_Vector tmp2, N_Vector tmp3);
 
 value sunml_cvode_last_lin_exception(void *cvode_mem);
 
@@ -193,6 +197,7 @@ enum cvode_session_index {
     RECORD_CVODE_SESSION_NROOTS,
     RECORD_CVODE_SESSION_CHECKVEC,
     RECORD_CVODE_SESSION_EXN_TEMP,
+    RECORD_CVODE_SESSION_ARGCACHE,
     RECORD_CVODE_SESSION_RHSFN,
     RECORD_CVODE_SESSION_ROOTSFN,
     RECORD_CVODE_SESSION_ERRH,
@@ -216,6 +221,61 @@ enum cvode_session_index {
 #define CVODE_LS_PRECFNS_FROM_ML(v) Field((v), RECORD_CVODE_SESSION_LS_PRECFNS)
 #define CVODE_SENSEXT_FROM_ML(v) Field(Field((v), RECORD_CVODE_SESSION_SENSEXT), 0)
 
+/* Purely C-side session data.  It is stored just after the global root, in
+ * the space reserved by sunml_sundials_malloc_value_ext, so that it can be
+ * reached from cv_user_data without passing through the OCaml heap.  */
+struct cvode_cdata {
+    struct sunml_cfun rhsfn;	/* native right-hand side (fn == NULL if not) */
+
+    /* The length of the state vector, or -1 if its data is not contiguous
+       (see sunml_nvec_data_length).  */
+    intnat neq;
+
+    /* Cvodes: native sensitivity right-hand side, evaluated for several
+       parameters concurrently by sens_nthreads threads, which need
+       2 * (sens_nthreads - 1) temporary vectors besides those provided by
+       Sundials (see sunml_cvodes_sens_init_cfun).  */
+    struct sunml_cfun sensrhsfn1;
+    int sens_nthreads;
+    N_Vector *sens_tmps;
+
+    /* Cvodes, backward sessions: native right-hand side of badj_nblocks
+       independent blocks, evaluated concurrently by badj_nthreads threads
+       through two serial views per block (see
+       sunml_cvodes_adj_init_backward_cfun).  */
+    struct sunml_cfun brhsfn1;
+    int badj_nblocks;
+    int badj_nthreads;
+    N_Vector *badj_views;
+
+    /* Cvodes: quadrature right-hand side given by linear and quadratic
+       forms (see sunml_cvodes_quad_init_forms).  */
+    struct sunml_quadforms quadforms;
+
+    /* Error weights given by a structured specification (see
+       sunml_cvode_st_tolerances).  */
+    struct sunml_ewtspec ewtspec;
+
+    /* The linear solver setup function, while it is wrapped after a
+       restore (see sunml_cvode_restore).  */
+    void (*restore_lsetup)(void);
+};
+
+#define CVODE_CDATA(backref) ((struct cvode_cdata *)SUNML_HEAPREF_EXT(backref))
+#define CVODE_CDATA_FROM_ML(v) CVODE_CDATA(CVODE_BACKREF_FROM_ML(v))
+
+#define CVODE_ARGCACHE_FROM_ML(v) Field((v), RECORD_CVODE_SESSION_ARGCACHE)
+
+/* Slots of the callback argument cache (see sunml_argcache_block).
+   Cvodes numbers its own slots from CVODE_ARGCACHE_SIZE.  */
+enum cvode_argcache_index {
+  CVODE_ARGCACHE_GOUT = 0,
+  CVODE_ARGCACHE_JAC_ARG,
+  CVODE_ARGCACHE_TRIPLE_TMP,
+  CVODE_ARGCACHE_SPILS_SOLVE_ARG,
+  CVODE_ARGCACHE_SIZE
+};
+
 enum cvode_spils_precfns_index {
   RECORD_CVODE_SPILS_PRECFNS_PREC_SOLVE_FN   = 0,
   RECORD_CVODE_SPILS_PRECFNS_PREC_SETUP_FN,
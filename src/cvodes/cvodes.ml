@@ -79,6 +79,67 @@ module Quadrature = struct (* {{{ *)
     c_quad_init s v0;
     se.has_quad <- true
 
+  type form =
+    | Linear of LintArray.t * RealArray.t
+    | Quadratic of LintArray.t * LintArray.t * RealArray.t
+
+  let flatten_forms forms =
+    let nterms = function
+      | Linear (a, w) ->
+          let n = RealArray.length w in
+          if Sundials_configuration.safe && Bigarray.Array1.dim a <> n
+          then invalid_arg "init_forms: array sizes do not match";
+          n
+      | Quadratic (a, b, w) ->
+          let n = RealArray.length w in
+          if Sundials_configuration.safe
+             && (Bigarray.Array1.dim a <> n || Bigarray.Array1.dim b <> n)
+          then invalid_arg "init_forms: array sizes do not match";
+          n
+    in
+    let n = Array.fold_left (fun n f -> n + nterms f) 0 forms in
+    let row = LintArray.create n
+    and ia = LintArray.create n
+    and ib = LintArray.create n
+    and w = RealArray.create n
+    and k = ref 0 in
+    let add i a b wj =
+      if Sundials_configuration.safe && (a < 0 || b < -1)
+      then invalid_arg "init_forms: negative index";
+      row.{!k} <- i; ia.{!k} <- a; ib.{!k} <- b; w.{!k} <- wj;
+      incr k
+    in
+    Array.iteri (fun i f ->
+        match f with
+        | Linear (a, wa) ->
+            for j = 0 to RealArray.length wa - 1 do
+              add i a.{j} (-1) wa.{j}
+            done
+        | Quadratic (a, b, wa) ->
+            for j = 0 to RealArray.length wa - 1 do
+              if Sundials_configuration.safe && b.{j} < 0
+              then invalid_arg "init_forms: negative index";
+              add i a.{j} b.{j} wa.{j}
+            done) forms;
+    (row, ia, ib, w)
+
+  external c_quad_init_forms
+      : ('a, 'k) session
+        -> LintArray.t * LintArray.t * LintArray.t * RealArray.t
+        -> ('a, 'k) nvector -> unit
+      = "sunml_cvodes_quad_init_forms"
+
+  let init_forms s forms v0 =
+    if Sundials_configuration.safe
+       && Array.length forms <> RealArray.length (Nvector.unwrap v0)
+    then invalid_arg "init_forms: wrong number of forms";
+    let terms = flatten_forms forms in
+    add_fwdsensext s;
+    let se = fwdsensext s in
+    se.checkquadvec <- Nvector.check v0;
+    c_quad_init_forms s terms v0;
+    se.has_quad <- true
+
   external c_reinit : ('a, 'k) session -> ('a, 'k) nvector -> unit
     = "sunml_cvodes_quad_reinit"
 
@@ -130,6 +191,19 @@ module Quadrature = struct (* {{{ *)
     if Sundials_configuration.safe then se.checkquadvec dky;
     fun t k -> c_get_dky s t k dky
 
+  external c_get_dky_many
+      : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) nvector
+        -> RealArray2.t -> unit
+      = "sunml_cvodes_quad_get_dky_many"
+
+  let get_dky_many s dky ts k dkys =
+    let se = fwdsensext s in
+    if Sundials_configuration.safe then se.checkquadvec dky;
+    if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap dky),
+                                 RealArray.length ts)
+    then invalid_arg "get_dky_many: array sizes do not match";
+    c_get_dky_many s ts k dky dkys
+
   external get_num_rhs_evals       : ('a, 'k) session -> int
       = "sunml_cvodes_quad_get_num_rhs_evals"
 
@@ -226,6 +300,11 @@ module Sensitivity = struct (* {{{ *)
                               -> ('a, 'k) nvector array -> unit
       = "sunml_cvodes_sens_init_1"
 
+  external c_sens_init_cfun : ('a, 'k) session -> ('a, 'k) sens_method
+                              -> int -> Sundials.cfun
+                              -> ('a, 'k) nvector array -> unit
+      = "sunml_cvodes_sens_init_cfun"
+
   external c_set_params : ('a, 'k) session -> sens_params -> unit
       = "sunml_cvodes_sens_set_params"
 
@@ -310,7 +389,7 @@ module Sensitivity = struct (* {{{ *)
     | Staggered1 _ -> true
     | _ -> false
 
-  let init s tol fmethod ?sens_params fm v0 =
+  let init' s tol fmethod sens_params c_init v0 =
     if Sundials_configuration.safe then Array.iter s.checkvec v0;
     add_fwdsensext s;
     let se = fwdsensext s in
@@ -318,21 +397,7 @@ module Sensitivity = struct (* {{{ *)
     if Sundials_configuration.safe && ns = 0 then
       invalid_arg "init: require at least one sensitivity parameter";
     (match sens_params with None -> () | Some sp -> check_sens_params ns sp);
-    (match fm with
-     | AllAtOnce fo -> begin
-         if is_Staggered1 fmethod then
-           failwith "init: Cannot combine AllAtOnce and Staggered1";
-         (match fo with Some f -> se.sensrhsfn  <- f
-                      | None   -> se.sensrhsfn  <- dummy_sensrhsfn;
-                                  se.sensrhsfn1 <- dummy_sensrhsfn1);
-         c_sens_init s fmethod (fo <> None) v0
-       end
-     | OneByOne fo -> begin
-         (match fo with Some f -> se.sensrhsfn1 <- f
-                      | None   -> se.sensrhsfn  <- dummy_sensrhsfn;
-                                  se.sensrhsfn1 <- dummy_sensrhsfn1);
-         c_sens_init_1 s fmethod (fo <> None) v0
-       end);
+    c_init se;
     se.num_sensitivities <- ns;
     (match sens_params with
      | None -> se.senspvals <- None
@@ -342,6 +407,35 @@ module Sensitivity = struct (* {{{ *)
     set_tolerances s tol;
     if not in_compat_mode2_3 then set_nonlinear_solver_sens s fmethod
 
+  let init s tol fmethod ?sens_params fm v0 =
+    let c_init se =
+      match fm with
+      | AllAtOnce fo -> begin
+          if is_Staggered1 fmethod then
+            failwith "init: Cannot combine AllAtOnce and Staggered1";
+          (match fo with Some f -> se.sensrhsfn  <- f
+                       | None   -> se.sensrhsfn  <- dummy_sensrhsfn;
+                                   se.sensrhsfn1 <- dummy_sensrhsfn1);
+          c_sens_init s fmethod (fo <> None) v0
+        end
+      | OneByOne fo -> begin
+          (match fo with Some f -> se.sensrhsfn1 <- f
+                       | None   -> se.sensrhsfn  <- dummy_sensrhsfn;
+                                   se.sensrhsfn1 <- dummy_sensrhsfn1);
+          c_sens_init_1 s fmethod (fo <> None) v0
+        end
+    in
+    init' s tol fmethod sens_params c_init v0
+
+  let init_cfun s tol fmethod ?sens_params ?(num_threads=1) f v0 =
+    if num_threads < 1 then invalid_arg "init_cfun: num_threads";
+    let c_init se =
+      se.sensrhsfn  <- dummy_sensrhsfn;
+      se.sensrhsfn1 <- dummy_sensrhsfn1;
+      c_sens_init_cfun s fmethod num_threads f v0
+    in
+    init' s tol fmethod sens_params c_init v0
+
   external c_reinit
       :    ('a, 'k) session
         -> ('a, 'k) sens_method
@@ -399,6 +493,19 @@ module Sensitivity = struct (* {{{ *)
     if Sundials_configuration.safe then s.checkvec dkys;
     fun t k i -> c_get_dky1 s t k i dkys
 
+  external c_get_dky1_many
+      : ('a, 'k) session -> RealArray.t -> int -> int -> ('a, 'k) nvector
+        -> RealArray2.t -> unit
+      = "sunml_cvodes_sens_get_dky1_many_byte"
+        "sunml_cvodes_sens_get_dky1_many"
+
+  let get_dky1_many s dkys ts k i dkyss =
+    if Sundials_configuration.safe then s.checkvec dkys;
+    if RealArray2.size dkyss <> (RealArray.length (Nvector.unwrap dkys),
+                                  RealArray.length ts)
+    then invalid_arg "get_dky1_many: array sizes do not match";
+    c_get_dky1_many s ts k i dkys dkyss
+
   type dq_method = DQCentered | DQForward
 
   external set_dq_method : ('a, 'k) session -> dq_method -> float -> unit
@@ -495,6 +602,18 @@ module Sensitivity = struct (* {{{ *)
                     c_quadsens_init s true v0
         | None -> c_quadsens_init s false v0
 
+      external c_quadsens_init_forms
+          : ('a, 'k) session -> ('a, 'k) nvector array -> unit
+          = "sunml_cvodes_quadsens_init_forms"
+
+      let init_forms s v0 =
+        let se = fwdsensext s in
+        if not se.has_quad then raise Quadrature.QuadNotInitialized;
+        if Sundials_configuration.safe && Array.length v0 <> se.num_sensitivities
+        then invalid_arg "init_forms: wrong number of vectors";
+        if Sundials_configuration.safe then Array.iter se.checkquadvec v0;
+        c_quadsens_init_forms s v0
+
       external c_reinit : ('a, 'k) session -> ('a, 'k) nvector array -> unit
           = "sunml_cvodes_quadsens_reinit"
 
@@ -589,6 +708,20 @@ module Sensitivity = struct (* {{{ *)
         if Sundials_configuration.safe then se.checkquadvec dkyqs;
         fun t k i -> c_get_dky1 s t k i dkyqs
 
+      external c_get_dky1_many
+          : ('a, 'k) session -> RealArray.t -> int -> int -> ('a, 'k) nvector
+            -> RealArray2.t -> unit
+          = "sunml_cvodes_quadsens_get_dky1_many_byte"
+            "sunml_cvodes_quadsens_get_dky1_many"
+
+      let get_dky1_many s dkyqs ts k i dkyqss =
+        let se = fwdsensext s in
+        if Sundials_configuration.safe then se.checkquadvec dkyqs;
+        if RealArray2.size dkyqss
+           <> (RealArray.length (Nvector.unwrap dkyqs), RealArray.length ts)
+        then invalid_arg "get_dky1_many: array sizes do not match";
+        c_get_dky1_many s ts k i dkyqs dkyqss
+
       external get_num_rhs_evals       : ('a, 'k) session -> int
           = "sunml_cvodes_quadsens_get_num_rhs_evals"
 
@@ -970,7 +1103,7 @@ module Adjoint = struct (* {{{ *)
                 BSlsSuperlumtCallback { jacfn = f; jmat = none }
             | Some (WithSens f) ->
                 BSlsSuperlumtCallbackSens { jacfn_sens = f; jmat = none })
-      | LSI.Custom _ ->
+      | LSI.Custom _ | LSI.BlockDiag ->
           session.ls_callbacks <- (match jac with
             | None ->
                 (match Matrix.get_id mat with
@@ -1377,7 +1510,17 @@ module Adjoint = struct (* {{{ *)
         -> (cvode_mem * int * c_weak_ref)
       = "sunml_cvodes_adj_init_backward"
 
-  let init_backward s lmm tol ?nlsolver ?lsolver mf t0 y0 =
+  external c_init_backward_cfun
+      : ('a, 'k) session -> ('a, 'k) session Weak.t
+        -> (Cvode.lmm * bool * float * ('a, 'k) nvector)
+        -> (cvode_mem * int * c_weak_ref)
+      = "sunml_cvodes_adj_init_backward_cfun"
+
+  external c_set_brhsfn_blocks
+      : ('a, 'k) session -> int -> int -> int -> Sundials.cfun -> unit
+      = "sunml_cvodes_adj_set_brhsfn_blocks"
+
+  let init_backward' s lmm tol nlsolver lsolver mf c_init t0 y0 =
     let { bsessions } as se = fwdsensext s in
     let ns = num_sensitivities s in
     let checkvec = Nvector.check y0 in
@@ -1386,11 +1529,7 @@ module Adjoint = struct (* {{{ *)
                | None -> true
                | Some { NLSI.solver = s } -> s = NLSI.NewtonSolver
     in
-    let cvode_mem, which, backref =
-      match mf with
-      | NoSens _ -> c_init_backward s weakref (lmm, iter, t0, y0) false
-      | WithSens _ -> c_init_backward s weakref (lmm, iter, t0, y0) true
-    in
+    let cvode_mem, which, backref = c_init weakref (lmm, iter, t0, y0) in
     (* cvode_mem and backref have to be immediately captured in a session and
        associated with the finalizer before we do anything else.  *)
     let bs = Bsession {
@@ -1400,6 +1539,7 @@ module Adjoint = struct (* {{{ *)
             checkvec     = checkvec;
 
             exn_temp     = None;
+            argcache     = Sundials_impl.make_arg_cache ();
 
             rhsfn        = dummy_rhsfn;
             rootsfn      = dummy_rootsfn;
@@ -1450,6 +1590,26 @@ module Adjoint = struct (* {{{ *)
     se.bsessions <- (tosession bs) :: bsessions;
     bs
 
+  let init_backward s lmm tol ?nlsolver ?lsolver mf t0 y0 =
+    let c_init weakref args =
+      match mf with
+      | NoSens _ -> c_init_backward s weakref args false
+      | WithSens _ -> c_init_backward s weakref args true
+    in
+    init_backward' s lmm tol nlsolver lsolver mf c_init t0 y0
+
+  let init_backward_cfun s lmm tol ?nlsolver ?lsolver ?(num_threads=1)
+                         num_blocks f t0 y0 =
+    let n = RealArray.length (Nvector.unwrap y0) in
+    if num_blocks < 1 || n mod num_blocks <> 0 then
+      invalid_arg "init_backward_cfun: num_blocks";
+    if num_threads < 1 then invalid_arg "init_backward_cfun: num_threads";
+    let c_init weakref args = c_init_backward_cfun s weakref args in
+    let bs = init_backward' s lmm tol nlsolver lsolver
+                            (NoSens dummy_brhsfn_no_sens) c_init t0 y0 in
+    c_set_brhsfn_blocks (tosession bs) n num_blocks num_threads f;
+    bs
+
   external c_reinit
       : ('a, 'k) session -> int -> float -> ('a, 'k) nvector -> unit
       = "sunml_cvodes_adj_reinit"
@@ -78,6 +78,29 @@ module Quadrature : sig (* {{{ *)
   val init : ('d, 'k) Cvode.session -> 'd quadrhsfn
                 -> ('d, 'k) Nvector.t -> unit
 
+  (** Quadrature integrands given by linear and quadratic forms over the
+      state variables. For arrays [a], [b], and [w] of the same length,
+      - [Linear (a, w)] denotes {% $\sum_j w_j y_{a_j}$%}, and,
+      - [Quadratic (a, b, w)] denotes {% $\sum_j w_j y_{a_j} y_{b_j}$%}. *)
+  type form =
+    | Linear of LintArray.t * RealArray.t
+    | Quadratic of LintArray.t * LintArray.t * RealArray.t
+
+  (** Activates the integration of quadrature equations whose right-hand
+      sides are given by forms: {% $\dot{y}_{Q,i}$%} is the value of the
+      [i]th element of the array, and the vector gives the initial value of
+      $y_Q$. Such quadratures, e.g., energies or cost functionals, are
+      evaluated in C without calling into OCaml. The forms are copied, and
+      their indices must be valid for the state vector of the session.
+
+      Their sensitivities can be computed by
+      {!Sensitivity.Quadrature.init_forms}.
+
+      @cvodes <node5#ss:quad_malloc> CVodeQuadInit
+      @raise Invalid_argument The number of forms does not match the length of the vector, an index is negative or not less than the length of the state vector, or the state vector does not have contiguous storage. *)
+  val init_forms :
+    'k Cvode.serial_session -> form array -> 'k Nvector_serial.any -> unit
+
   (** Reinitializes the integration of quadrature equations. The vector
       gives a new value for $y_Q$.
 
@@ -111,6 +134,21 @@ module Quadrature : sig (* {{{ *)
       @raise BadK [k] is not in the range 0, 1, ..., $q_u$. *)
   val get_dky : ('d, 'k) Cvode.session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+  (** Evaluates the interpolated solution or derivatives at several times.
+      [get_dky_many s dkyq ts k dkyqs] computes the [k]th derivative at each
+      time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+      [dkyqs], using [dkyq] as workspace. The array [dkyqs] must have a row for
+      each element of [dkyq] and a column for each element of [ts]. All of the
+      evaluations are made in a single call into C.
+
+      @cvodes <node5#ss:quad_get> CVodeGetQuadDky
+      @raise BadT A time is not in the interval {% $[t_n - h_u, t_n]$%}.
+      @raise BadK [k] is not in the range 0, 1, ..., $q_u$.
+      @raise Invalid_argument The sizes of [dkyq], [ts], and [dkyqs] do not agree. *)
+  val get_dky_many : (Nvector_serial.data, 'k) Cvode.session
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> RealArray.t -> int -> RealArray2.t -> unit
+
   (** {2:tols Tolerances} *)
 
   (** Tolerances for calculating quadrature variables. *)
@@ -403,6 +441,41 @@ module Sensitivity : sig (* {{{ *)
              -> ('d, 'k) Nvector.t array
              -> unit
 
+  (** Like {!init} but the sensitivity right-hand side is a native C
+      function that is evaluated for one parameter at a time, and for
+      several parameters concurrently. The function [f] must have the C
+      type of a [CVSensRhs1Fn],
+      [int f(int ns, realtype t, N_Vector y, N_Vector ydot, int is,
+             N_Vector yS, N_Vector ySdot, void *data,
+             N_Vector tmp1, N_Vector tmp2)],
+      where [data] is the pointer given to [sunml_sundials_wrap_cfun]
+      (see {!Sundials.cfun}).
+
+      Unless the method is [Staggered1], which requires the sensitivities
+      one parameter at a time, the calls for the different parameters are
+      shared among [num_threads] OpenMP threads (default: [1]). Each call
+      writes only into its own [ySdot] and receives its own temporary
+      vectors, but the calls share [y], [ydot], and [data], which [f] must
+      therefore only read. Like the native right-hand sides of
+      {!Cvode.init_cfun}, [f] must not call back into OCaml. The first
+      negative result, if any, and otherwise the greatest one is returned
+      to CVODES. The library must be compiled with OpenMP for the calls to
+      run in parallel.
+
+      @cvodes <node6#ss:sensi_malloc> CVodeSensInit
+      @cvodes <node6#ss:sensi_malloc> CVodeSensInit1
+      @cvodes <node6#ss:user_fct_fwd> CVSensRhs1Fn
+      @raise Invalid_argument The number of threads is not positive.
+      @since 4.0.0 *)
+  val init_cfun : ('d, 'k) Cvode.session
+                  -> ('d, 'k) tolerance
+                  -> ('d, 'k) sens_method
+                  -> ?sens_params:sens_params
+                  -> ?num_threads:int
+                  -> Sundials.cfun
+                  -> ('d, 'k) Nvector.t array
+                  -> unit
+
   (** Reinitializes the forward sensitivity computation.
 
       @cvodes <node6#ss:sensi_malloc> CVodeSensReInit *)
@@ -488,6 +561,17 @@ module Sensitivity : sig (* {{{ *)
     val init : ('d, 'k) Cvode.session -> ?fqs:'d quadsensrhsfn
              -> ('d, 'k) Nvector.t array -> unit
 
+    (** Activates the integration of the sensitivities of quadratures
+        initialized with {!Quadrature.init_forms}. Their right-hand sides,
+        the derivatives of the forms, are evaluated in C. The array gives
+        the initial values of the quadrature sensitivities.
+
+        @cvodes <node6#ss:quad_sens_init> CVodeQuadSensInit
+        @raise QuadNotInitialized {!Quadrature.init_forms} has not been called.
+        @raise Invalid_argument The quadratures are not given by forms. *)
+    val init_forms :
+      'k Cvode.serial_session -> 'k Nvector_serial.any array -> unit
+
     (** Reinitializes the quadrature sensitivity integration.
 
         @cvodes <node6#ss:quad_sens_init> CVodeQuadSensReInit *)
@@ -569,6 +653,20 @@ module Sensitivity : sig (* {{{ *)
     val get_dky1 : ('d, 'k) Cvode.session -> ('d, 'k) Nvector.t
                      -> float -> int -> int -> unit
 
+    (** Evaluates a single interpolated quadrature sensitivity vector, or
+        its derivatives, at several times.
+        [get_dky1_many s dksq ts k i dksqs] is like {!get_dky1} applied at
+        each time [ts.{j}], storing the results in the columns of [dksqs]
+        and using [dksq] as workspace.
+
+        @cvodes <node6#ss:quad_sens_get> CVodeGetQuadSensDky1
+        @raise BadK [k] is not in the range 0, 1, ..., [qlast].
+        @raise BadT A time is not in the allowed range.
+        @raise Invalid_argument The sizes of [dksq], [ts], and [dksqs] do not agree. *)
+    val get_dky1_many : (Nvector_serial.data, 'k) Cvode.session
+                        -> (Nvector_serial.data, 'k) Nvector.t
+                        -> RealArray.t -> int -> int -> RealArray2.t -> unit
+
     (** {2:get Querying the solver (optional output functions)} *)
 
     (** Returns the number of calls to the quadrature right-hand side
@@ -685,6 +783,22 @@ module Sensitivity : sig (* {{{ *)
   val get_dky1 : ('d, 'k) Cvode.session -> ('d, 'k) Nvector.t
                    -> float -> int -> int -> unit
 
+  (** Evaluates a single interpolated sensitivity solution vector, or its
+      derivatives, at several times. [get_dky1_many s dks ts k i dkss] is
+      like {!get_dky1} applied at each time [ts.{j}], storing the results
+      in the columns of [dkss] and using [dks] as workspace. The array
+      [dkss] must have a row for each element of [dks] and a column for
+      each element of [ts].
+
+      @cvodes <node6#ss:sensi_get> CVodeGetSensDky1
+      @raise BadIS The index [i] is not in the allowed range.
+      @raise BadK [k] is not in the range 0, 1, ..., [qlast].
+      @raise BadT A time is not in the allowed range.
+      @raise Invalid_argument The sizes of [dks], [ts], and [dkss] do not agree. *)
+  val get_dky1_many : (Nvector_serial.data, 'k) Cvode.session
+                      -> (Nvector_serial.data, 'k) Nvector.t
+                      -> RealArray.t -> int -> int -> RealArray2.t -> unit
+
   (** {2:set Modifying the solver (optional input functions)} *)
 
   (** Sets the integration tolerances for sensitivities.
@@ -893,6 +1007,12 @@ module Adjoint : sig (* {{{ *)
       of integration steps between consecutive checkpoints, and the type of
       variable-degree interpolation.
 
+      The checkpoints are cloned from the nvectors of the session. For
+      problems whose checkpoints do not fit in memory, they can be stored in
+      files by creating the session with {!Nvector_serial.wrap_with_scratch}
+      and enabling {!Nvector_serial.set_scratch_dir} only during the forward
+      integration.
+
       @cvodes <node7#sss:cvadjinit> CVodeAdjInit *)
   val init : ('d, 'k) Cvode.session -> int -> interpolation -> unit
 
@@ -961,6 +1081,9 @@ module Adjoint : sig (* {{{ *)
 
   (** Arguments common to Jacobian callback functions.
 
+      {warning The record is reused between calls and should not be
+               retained after the callback returns.}
+
       @cvodes <node7> CVodeLsJacFnB
       @cvodes <node7> CVodeJacTimesVecFnB
       @cvodes <node7> CVodeLsPrecSolveFnB
@@ -1679,6 +1802,52 @@ module Adjoint : sig (* {{{ *)
     -> ('d, 'k) Nvector.t
     -> ('d, 'k) bsession
 
+  (** Like {!init_backward} but for a backward problem made of [num_blocks]
+      independent blocks of equal length, for instance, the adjoint states
+      of several functionals of the same forward solution, stacked in
+      [yb0]. The right-hand side is a native C function that is called for
+      one block at a time, and for several blocks concurrently. The function
+      [f] must have the C type
+      [int f(realtype t, N_Vector y, int ib, N_Vector yB, N_Vector yBdot,
+             void *data)],
+      where [yB] and [yBdot] are serial views on the [ib]th blocks of the
+      backward state and its derivative, and [data] is the pointer given to
+      [sunml_sundials_wrap_cfun] (see {!Sundials.cfun}).
+
+      The calls for the different blocks share the checkpoints and the
+      interpolated forward solution [y], which [f] must only read, and
+      they are shared among [num_threads] OpenMP threads (default: [1]).
+      Like the native right-hand sides of {!Cvode.init_cfun}, [f] must not
+      call back into OCaml. The first negative result, if any, and otherwise
+      the greatest one is returned to CVODES. The library must be compiled
+      with OpenMP for the calls to run in parallel.
+
+      Integrating the blocks as a single backward problem means that the
+      forward solution is interpolated once for all of them and that the
+      steps are shared. The Jacobian of such a problem is block diagonal
+      (see {!Sundials_Matrix.BlockDiag}).
+
+      @cvodes <node7#sss:cvinitb> CVodeCreateB
+      @cvodes <node7#sss:cvinitb> CVodeInitB
+      @raise Invalid_argument The number of blocks does not divide the length of [yb0], or the number of threads is not positive.
+      @since 4.0.0 *)
+  val init_backward_cfun :
+       (Nvector_serial.data, 'k) Cvode.session
+    -> Cvode.lmm
+    -> (Nvector_serial.data, 'k) tolerance
+    -> ?nlsolver
+         : (Nvector_serial.data, 'k,
+            ((Nvector_serial.data, 'k) Cvode.session)
+              Sundials_NonlinearSolver.integrator)
+           Sundials_NonlinearSolver.t
+    -> ?lsolver  : (Nvector_serial.data, 'k) linear_solver
+    -> ?num_threads:int
+    -> int
+    -> Sundials.cfun
+    -> float
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> 'k serial_bsession
+
   (** Support for backward quadrature equations that may or may
       not depend on forward sensitivities.
 
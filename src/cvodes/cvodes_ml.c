@@ -14,6 +14,7 @@
 #include "../config.h"
 #include <cvodes/cvodes.h>
 #include <sundials/sundials_band.h>
+#include <nvector/nvector_serial.h>
 
 #include <caml/alloc.h>
 #include <caml/memory.h>
@@ -51,6 +52,13 @@
 #include "cvodes_ml.h"
 #include "../nvectors/nvector_ml.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#define SENS_THREAD_NUM() omp_get_thread_num()
+#else
+#define SENS_THREAD_NUM() 0
+#endif
+
 CAMLprim value sunml_cvodes_init_module (value exns)
 {
     CAMLparam1 (exns);
@@ -87,12 +95,13 @@ void sunml_cvodes_wrap_to_nvector_table(int n, value vy, N_Vector *y)
     }
 }
 
-static value make_double_tmp(N_Vector tmp1, N_Vector tmp2)
+static value make_double_tmp(value session, N_Vector tmp1, N_Vector tmp2)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(2);
+    r = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODES_ARGCACHE_DOUBLE_TMP, 2);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     CAMLreturn(r);
@@ -131,12 +140,14 @@ static int sensrhsfn(int ns, realtype t, N_Vector y, N_Vector ydot,
     WEAK_DEREF (session, *(value*)user_data);
     sensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args = caml_alloc_tuple (RECORD_CVODES_SENSRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_SENSRHSFN_ARGS,
+				 RECORD_CVODES_SENSRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_YP, NVEC_BACKLINK (ydot));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_TMP,
-		 make_double_tmp (tmp1, tmp2));
+		 make_double_tmp(session, tmp1, tmp2));
 
     sunml_cvodes_wrap_to_nvector_table(ns, CVODES_SENSARRAY1_FROM_EXT(sensext), ys);
     sunml_cvodes_wrap_to_nvector_table(ns,
@@ -160,12 +171,14 @@ static int sensrhsfn1(int ns, realtype t, N_Vector y, N_Vector ydot,
 
     WEAK_DEREF (session, *(value*)user_data);
 
-    args = caml_alloc_tuple (RECORD_CVODES_SENSRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_SENSRHSFN_ARGS,
+				 RECORD_CVODES_SENSRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_YP, NVEC_BACKLINK (ydot));
     Store_field (args, RECORD_CVODES_SENSRHSFN_ARGS_TMP,
-		 make_double_tmp (tmp1, tmp2));
+		 make_double_tmp(session, tmp1, tmp2));
 
     cb = CVODE_SENSEXT_FROM_ML (session);
     cb = CVODES_SENSRHSFN1_FROM_EXT (cb);
@@ -179,6 +192,50 @@ static int sensrhsfn1(int ns, realtype t, N_Vector y, N_Vector ydot,
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
+/* Evaluate a native one-by-one sensitivity right-hand side for all of the
+   parameters, concurrently on sens_nthreads threads.  Each thread passes
+   its own pair of temporary vectors.  The result is the first negative
+   (unrecoverable) return value, if any, and otherwise the greatest.  */
+static int native_sensrhsfn(int ns, realtype t, N_Vector y, N_Vector ydot,
+			    N_Vector *ys, N_Vector *ysdot, void *user_data,
+			    N_Vector tmp1, N_Vector tmp2)
+{
+    struct cvode_cdata *cdata = CVODE_CDATA(user_data);
+    CVSensRhs1Fn f = (CVSensRhs1Fn)(cdata->sensrhsfn1.fn);
+    void *data = cdata->sensrhsfn1.data;
+    int nt = cdata->sens_nthreads;
+    int is, rmin = 0, rmax = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nt) \
+			 reduction(min:rmin) reduction(max:rmax)
+#else
+    (void)nt;
+#endif
+    for (is = 0; is < ns; ++is) {
+	int id = SENS_THREAD_NUM();
+	N_Vector t1 = (id == 0) ? tmp1 : cdata->sens_tmps[2 * (id - 1)];
+	N_Vector t2 = (id == 0) ? tmp2 : cdata->sens_tmps[2 * (id - 1) + 1];
+	int r = f(ns, t, y, ydot, is, ys[is], ysdot[is], data, t1, t2);
+
+	if (r < rmin) rmin = r;
+	if (r > rmax) rmax = r;
+    }
+
+    return (rmin < 0) ? rmin : rmax;
+}
+
+/* Forward, one parameter at a time, to a native sensitivity right-hand
+   side (for the Staggered1 method).  */
+static int native_sensrhsfn1(int ns, realtype t, N_Vector y, N_Vector ydot,
+			     int is, N_Vector ys, N_Vector ysdot,
+			     void *user_data, N_Vector tmp1, N_Vector tmp2)
+{
+    struct sunml_cfun *f = &(CVODE_CDATA(user_data)->sensrhsfn1);
+    return ((CVSensRhs1Fn)(f->fn))(ns, t, y, ydot, is, ys, ysdot, f->data,
+				   tmp1, tmp2);
+}
+
 static int quadsensrhsfn(int ns, realtype t, N_Vector y, N_Vector *ys,
 		         N_Vector yqdot, N_Vector *yqsdot, void *user_data,
 		         N_Vector tmp1, N_Vector tmp2)
@@ -189,7 +246,9 @@ static int quadsensrhsfn(int ns, realtype t, N_Vector y, N_Vector *ys,
     WEAK_DEREF (session, *(value*)user_data);
     sensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args = caml_alloc_tuple (RECORD_CVODES_QUADSENSRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_QUADSENSRHSFN_ARGS,
+				 RECORD_CVODES_QUADSENSRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_QUADSENSRHSFN_ARGS_T,
 		 caml_copy_double (t));
     Store_field (args, RECORD_CVODES_QUADSENSRHSFN_ARGS_Y, NVEC_BACKLINK (y));
@@ -198,7 +257,7 @@ static int quadsensrhsfn(int ns, realtype t, N_Vector y, N_Vector *ys,
     Store_field (args, RECORD_CVODES_QUADSENSRHSFN_ARGS_YQP,
 		 NVEC_BACKLINK(yqdot));
     Store_field (args, RECORD_CVODES_QUADSENSRHSFN_ARGS_TMP,
-		 make_double_tmp (tmp1, tmp2));
+		 make_double_tmp(session, tmp1, tmp2));
 
     sunml_cvodes_wrap_to_nvector_table(ns, CVODES_SENSARRAY1_FROM_EXT(sensext), ys);
     sunml_cvodes_wrap_to_nvector_table(ns,
@@ -217,12 +276,15 @@ static int brhsfn(realtype t, N_Vector y, N_Vector yb, N_Vector ybdot,
     CAMLparam0();
     CAMLlocal3(args, session, cb);
 
-    args = caml_alloc_tuple (RECORD_CVODES_ADJ_BRHSFN_ARGS_SIZE);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_ADJ_BRHSFN_ARGS,
+				 RECORD_CVODES_ADJ_BRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_YB, NVEC_BACKLINK (yb));
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_SENSEXT_FROM_ML (session);
     cb = CVODES_BRHSFN_FROM_EXT (cb);
 
@@ -243,7 +305,9 @@ static int brhsfn_sens(realtype t, N_Vector y, N_Vector *ys, N_Vector yb,
     sensext = CVODE_SENSEXT_FROM_ML(session);
     ns = Int_val(Field(sensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
 
-    args = caml_alloc_tuple (RECORD_CVODES_ADJ_BRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_ADJ_BRHSFN_ARGS,
+				 RECORD_CVODES_ADJ_BRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_CVODES_ADJ_BRHSFN_ARGS_YB, NVEC_BACKLINK (yb));
@@ -264,14 +328,17 @@ static int bquadrhsfn(realtype t, N_Vector y, N_Vector yb, N_Vector qbdot,
     CAMLparam0();
     CAMLlocal3(args, session, cb);
 
-    args = caml_alloc_tuple (RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_SIZE);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+				 RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_T,
 		 caml_copy_double(t));
     Store_field (args, RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_Y, NVEC_BACKLINK(y));
     Store_field (args, RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_YB,
 		 NVEC_BACKLINK (yb));
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_SENSEXT_FROM_ML (session);
     cb = CVODES_BQUADRHSFN_FROM_EXT(cb);
 
@@ -292,7 +359,9 @@ static int bquadrhsfn_sens(realtype t, N_Vector y, N_Vector *ys, N_Vector yb,
     sensext = CVODE_SENSEXT_FROM_ML(session);
     ns = Int_val(Field(sensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
 
-    args = caml_alloc_tuple (RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (CVODE_ARGCACHE_FROM_ML (session),
+				 CVODES_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+				 RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_T,
 		 caml_copy_double (t));
     Store_field (args, RECORD_CVODES_ADJ_BQUADRHSFN_ARGS_Y,
@@ -310,13 +379,15 @@ static int bquadrhsfn_sens(realtype t, N_Vector y, N_Vector *ys, N_Vector yb,
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
 
-value sunml_cvodes_make_jac_arg(realtype t, N_Vector y, N_Vector yb,
-			  N_Vector fyb, value tmp)
+value sunml_cvodes_make_jac_arg(value session, realtype t, N_Vector y,
+				N_Vector yb, N_Vector fyb, value tmp)
 {
-    CAMLparam1(tmp);
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_CVODES_ADJ_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODES_ARGCACHE_ADJ_JAC_ARG,
+			     RECORD_CVODES_ADJ_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_CVODES_ADJ_JACOBIAN_ARG_JAC_T, caml_copy_double(t));
     Store_field(r, RECORD_CVODES_ADJ_JACOBIAN_ARG_JAC_Y, NVEC_BACKLINK(y));
     Store_field(r, RECORD_CVODES_ADJ_JACOBIAN_ARG_JAC_YB, NVEC_BACKLINK(yb));
@@ -327,16 +398,19 @@ value sunml_cvodes_make_jac_arg(realtype t, N_Vector y, N_Vector yb,
 }
 
 static value make_spils_solve_arg(
+	value session,
 	N_Vector rvecb,
 	realtype gammab,
 	realtype deltab,
 	int lrb)
 
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(v);
 
-    v = caml_alloc_tuple(RECORD_CVODES_ADJ_SPILS_SOLVE_ARG_SIZE);
+    v = sunml_argcache_block(CVODE_ARGCACHE_FROM_ML(session),
+			     CVODES_ARGCACHE_ADJ_SPILS_SOLVE_ARG,
+			     RECORD_CVODES_ADJ_SPILS_SOLVE_ARG_SIZE);
     Store_field(v, RECORD_CVODES_ADJ_SPILS_SOLVE_ARG_RVEC, NVEC_BACKLINK(rvecb));
     Store_field(v, RECORD_CVODES_ADJ_SPILS_SOLVE_ARG_GAMMA,
                 caml_copy_double(gammab));
@@ -368,11 +442,12 @@ static int bprecsolvefn(
     CAMLlocalN(args, 3);
     CAMLlocal2(session, cb);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
-    args[1] = make_spils_solve_arg(rvecb, gammab, deltab, lrb);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
+    args[1] = make_spils_solve_arg(session, rvecb, gammab, deltab, lrb);
     args[2] = NVEC_BACKLINK(zvecb);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_CVODES_BSPILS_PRECFNS_PREC_SOLVE_FN);
@@ -410,8 +485,8 @@ static int bprecsolvefn_withsens(
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
-    args[1] = make_spils_solve_arg(rvecb, gammab, deltab, lrb);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
+    args[1] = make_spils_solve_arg(session, rvecb, gammab, deltab, lrb);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[2] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -451,11 +526,12 @@ static int bprecsetupfn(
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
     args[1] = Val_bool(jokb);
     args[2] = caml_copy_double(gammab);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_CVODES_BSPILS_PRECFNS_PREC_SETUP_FN);
@@ -500,7 +576,7 @@ static int bprecsetupfn_withsens(
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -538,9 +614,10 @@ static int bjacsetupfn(
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
+
     cb = CVODE_LS_CALLBACKS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
@@ -568,7 +645,7 @@ static int bjacsetupfn_withsens(
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, Val_unit);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, Val_unit);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -600,11 +677,13 @@ static int bjactimesfn(
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, NVEC_BACKLINK(tmpb));
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb,
+					NVEC_BACKLINK(tmpb));
     args[1] = NVEC_BACKLINK(vb);
     args[2] = NVEC_BACKLINK(Jvb);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = CVODE_LS_CALLBACKS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
@@ -636,7 +715,8 @@ static int bjactimesfn_withsens(
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = CVODE_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb, NVEC_BACKLINK(tmpb));
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb,
+					NVEC_BACKLINK(tmpb));
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -678,8 +758,8 @@ static int bjacfn_nosens(
     cb = CVODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
     args[1] = MAT_BACKLINK(jacb);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -711,8 +791,8 @@ static int bjacfn_withsens(
     cb = CVODE_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -754,8 +834,8 @@ static int bjacfn_nosens(
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
     args[1] = Some_val(dmat);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -795,8 +875,8 @@ static int bjacfn_withsens(
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -840,8 +920,8 @@ static int bbandjacfn_nosens(
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
     args[1] = Some_val(bmat);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -884,8 +964,8 @@ static int bbandjacfn_withsens(
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_cvodes_make_jac_arg(t, y, yb, fyb,
-		sunml_cvode_make_triple_tmp(tmp1b, tmp2b, tmp3b));
+    args[0] = sunml_cvode_make_triple_tmp(session, tmp1b, tmp2b, tmp3b);
+    args[0] = sunml_cvodes_make_jac_arg(session, t, y, yb, fyb, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_CVODES_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = CVODES_BSENSARRAY_FROM_EXT(bsensext);
@@ -911,12 +991,40 @@ CAMLprim value sunml_cvodes_quad_init(value vdata, value vq0)
     int flag;
     N_Vector q0 = NVEC_VAL(vq0);
     
+    sunml_quadforms_free(&(CVODE_CDATA_FROM_ML(vdata)->quadforms));
     flag = CVodeQuadInit(CVODE_MEM_FROM_ML(vdata), quadrhsfn, q0);
     SCHECK_FLAG("CVodeQuadInit", flag);
 
     CAMLreturn (Val_unit);
 }
 
+static int native_quadforms(realtype t, N_Vector y, N_Vector yQdot,
+			    void *user_data)
+{
+    sunml_quadforms_eval(&(CVODE_CDATA(user_data)->quadforms), y, yQdot);
+    return 0;
+}
+
+/* CVodeQuadInit() with a right-hand side given by linear and quadratic
+   forms (vrow, va, vb, vw) and evaluated without calling into OCaml.  */
+CAMLprim value sunml_cvodes_quad_init_forms(value vdata, value vforms,
+					    value vq0)
+{
+    CAMLparam3(vdata, vforms, vq0);
+    N_Vector q0 = NVEC_VAL(vq0);
+    struct cvode_cdata *cdata = CVODE_CDATA_FROM_ML(vdata);
+    int flag;
+
+    sunml_quadforms_set(&cdata->quadforms,
+			Field(vforms, 0), Field(vforms, 1),
+			Field(vforms, 2), Field(vforms, 3), cdata->neq);
+
+    flag = CVodeQuadInit(CVODE_MEM_FROM_ML(vdata), native_quadforms, q0);
+    SCHECK_FLAG("CVodeQuadInit", flag);
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvodes_quad_reinit(value vdata, value vq0)
 {
     CAMLparam2(vdata, vq0);
@@ -970,6 +1078,25 @@ CAMLprim value sunml_cvodes_quad_get_dky(value vdata, value vt, value vk,
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_cvodes_quad_get_dky_many(value vdata, value vts, value vk,
+					      value vdkyq, value vdkyqs)
+{
+    CAMLparam5(vdata, vts, vk, vdkyq, vdkyqs);
+
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector dkyq = NVEC_VAL(vdkyq);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = CVodeGetQuadDky(cvode_mem, ts[i], Int_val(vk), dkyq);
+	SCHECK_FLAG("CVodeGetQuadDky", flag);
+	sunml_realarray2_set_col(vdkyqs, i, Field(vdkyq, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvodes_quad_get_err_weights(value vdata, value veqweight)
 {
     CAMLparam2(vdata, veqweight);
@@ -1107,6 +1234,57 @@ CAMLprim value sunml_cvodes_sens_init_1(value vdata, value vmethod, value vrhsfn
     CAMLreturn (Val_unit);
 }
 
+/* CVodeSensInit() or CVodeSensInit1() with a native one-by-one sensitivity
+   right-hand side.  The Staggered1 method calls it for one parameter at a
+   time; the other methods evaluate all of the parameters concurrently on
+   vnthreads threads.  */
+CAMLprim value sunml_cvodes_sens_init_cfun(value vdata, value vmethod,
+					   value vnthreads, value vcfun,
+					   value vys0)
+{
+    CAMLparam5(vdata, vmethod, vnthreads, vcfun, vys0);
+    int ns = Wosize_val (vys0); /* vys0 : nvector array */
+    int method = decode_sens_method(vmethod);
+    int nt = Int_val(vnthreads);
+    N_Vector *ys0;
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    struct cvode_cdata *cdata = CVODE_CDATA_FROM_ML(vdata);
+    int flag;
+
+    if (nt < 1)
+	caml_invalid_argument("Cvodes.Sensitivity.init_cfun: num_threads");
+    if (nt > ns) nt = ns;
+    if (method == CV_STAGGERED1) nt = 1;
+
+    CVodeSensFree(cvode_mem);
+    if (cdata->sens_tmps != NULL) {
+	N_VDestroyVectorArray(cdata->sens_tmps, 2 * (cdata->sens_nthreads - 1));
+	cdata->sens_tmps = NULL;
+    }
+    cdata->sensrhsfn1 = *CFUN_VAL(vcfun);
+    cdata->sens_nthreads = 1;
+
+    ys0 = sunml_nvector_array_alloc(vys0);
+    if (nt > 1) {
+	cdata->sens_tmps = N_VCloneVectorArray(2 * (nt - 1), ys0[0]);
+	if (cdata->sens_tmps == NULL) {
+	    sunml_nvector_array_free(ys0);
+	    caml_raise_out_of_memory();
+	}
+	cdata->sens_nthreads = nt;
+    }
+
+    if (method == CV_STAGGERED1)
+	flag = CVodeSensInit1(cvode_mem, ns, method, native_sensrhsfn1, ys0);
+    else
+	flag = CVodeSensInit(cvode_mem, ns, method, native_sensrhsfn, ys0);
+    sunml_nvector_array_free(ys0);
+    SCHECK_FLAG((method == CV_STAGGERED1) ? "CVodeSensInit1" : "CVodeSensInit",
+		flag);
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvodes_sens_reinit(value vdata, value vmethod, value vs0)
 {
     CAMLparam3(vdata, vmethod, vs0);
@@ -1175,6 +1353,30 @@ CAMLprim value sunml_cvodes_sens_get_dky1(value vdata, value vt, value vk,
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_cvodes_sens_get_dky1_many(value vdata, value vts,
+					       value vk, value vis,
+					       value vdkys, value vdkyss)
+{
+    CAMLparam5(vdata, vts, vk, vis, vdkys);
+    CAMLxparam1(vdkyss);
+
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector dkys = NVEC_VAL(vdkys);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = CVodeGetSensDky1(cvode_mem, ts[i], Int_val(vk),
+				    Int_val(vis), dkys);
+	SCHECK_FLAG("CVodeGetSensDky1", flag);
+	sunml_realarray2_set_col(vdkyss, i, Field(vdkys, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
+BYTE_STUB6(sunml_cvodes_sens_get_dky1_many)
+
 CAMLprim value sunml_cvodes_sens_get_err_weights(value vdata, value vesweight)
 {
     CAMLparam2(vdata, vesweight);
@@ -1203,6 +1405,40 @@ CAMLprim value sunml_cvodes_quadsens_init(value vdata, value vrhsfn, value vyqs0
     CAMLreturn (Val_unit);
 }
 
+static int native_quadsensforms(int ns, realtype t, N_Vector y,
+				N_Vector *ys, N_Vector yqdot,
+				N_Vector *yqsdot, void *user_data,
+				N_Vector tmp1, N_Vector tmp2)
+{
+    struct sunml_quadforms *qf = &(CVODE_CDATA(user_data)->quadforms);
+    int is;
+
+    for (is = 0; is < ns; ++is)
+	sunml_quadforms_eval_sens(qf, y, ys[is], yqsdot[is]);
+    return 0;
+}
+
+/* CVodeQuadSensInit() for quadratures initialized by
+   sunml_cvodes_quad_init_forms: the sensitivities are the derivatives of
+   the same forms.  */
+CAMLprim value sunml_cvodes_quadsens_init_forms(value vdata, value vyqs0)
+{
+    CAMLparam2(vdata, vyqs0);
+    N_Vector *yqs0;
+
+    if (CVODE_CDATA_FROM_ML(vdata)->quadforms.w == NULL)
+	caml_invalid_argument("Cvodes.Sensitivity.Quadrature.init_forms: "
+			      "the quadratures are not given by forms");
+
+    yqs0 = sunml_nvector_array_alloc(vyqs0);
+    int flag = CVodeQuadSensInit(CVODE_MEM_FROM_ML(vdata),
+				 native_quadsensforms, yqs0);
+    sunml_nvector_array_free(yqs0);
+    SCHECK_FLAG("CVodeQuadSensInit", flag);
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvodes_quadsens_reinit(value vdata, value vyqs0)
 {
     CAMLparam2(vdata, vyqs0);
@@ -1282,6 +1518,30 @@ CAMLprim value sunml_cvodes_quadsens_get_dky1(value vdata, value vt, value vk,
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_cvodes_quadsens_get_dky1_many(value vdata, value vts,
+						   value vk, value vis,
+						   value vdkyqs, value vdkyqss)
+{
+    CAMLparam5(vdata, vts, vk, vis, vdkyqs);
+    CAMLxparam1(vdkyqss);
+
+    void *cvode_mem = CVODE_MEM_FROM_ML(vdata);
+    N_Vector dkyqs = NVEC_VAL(vdkyqs);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = CVodeGetQuadSensDky1(cvode_mem, ts[i], Int_val(vk),
+					Int_val(vis), dkyqs);
+	SCHECK_FLAG("CVodeGetQuadSensDky1", flag);
+	sunml_realarray2_set_col(vdkyqss, i, Field(vdkyqs, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
+BYTE_STUB6(sunml_cvodes_quadsens_get_dky1_many)
+
 CAMLprim value sunml_cvodes_quadsens_get_err_weights(value vdata, value veqweights)
 {
     CAMLparam2(vdata, veqweights);
@@ -1724,10 +1984,63 @@ CAMLprim value sunml_cvodes_adj_spils_set_linear_solver (value vparent, value vw
     CAMLreturn (Val_unit);
 }
 
-CAMLprim value sunml_cvodes_adj_init_backward(value vparent, value weakref,
-					      value vargs, value vwithsens)
+/* The right-hand side of a backward problem made of several independent
+   blocks, for instance, the adjoints of several functionals of the same
+   forward solution.  The blocks of yb and ybdot are seen through serial
+   views, and a native function is called for each of them, concurrently on
+   badj_nthreads threads.  The result is the first negative (unrecoverable)
+   return value, if any, and otherwise the greatest.  */
+typedef int (*sunml_cvodes_brhsfn1)(realtype t, N_Vector y, int ib,
+				    N_Vector yb, N_Vector ybdot, void *data);
+
+static int native_brhsfn_blocks(realtype t, N_Vector y, N_Vector yb,
+				N_Vector ybdot, void *user_data)
 {
-    CAMLparam4(vparent, weakref, vargs, vwithsens);
+    struct cvode_cdata *cdata = CVODE_CDATA(user_data);
+    sunml_cvodes_brhsfn1 f = (sunml_cvodes_brhsfn1)(cdata->brhsfn1.fn);
+    void *data = cdata->brhsfn1.data;
+    int nb = cdata->badj_nblocks;
+    int nt = cdata->badj_nthreads;
+    N_Vector *views = cdata->badj_views;
+    sundials_ml_index m = NV_LENGTH_S(views[0]);
+    int ib, rmin = 0, rmax = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nt) \
+			 reduction(min:rmin) reduction(max:rmax)
+#else
+    (void)nt;
+#endif
+    for (ib = 0; ib < nb; ++ib) {
+	int r;
+
+	NV_DATA_S(views[2 * ib])     = NV_DATA_S(yb) + ib * m;
+	NV_DATA_S(views[2 * ib + 1]) = NV_DATA_S(ybdot) + ib * m;
+	r = f(t, y, ib, views[2 * ib], views[2 * ib + 1], data);
+
+	if (r < rmin) rmin = r;
+	if (r > rmax) rmax = r;
+    }
+
+    return (rmin < 0) ? rmin : rmax;
+}
+
+static void free_badj_views(struct cvode_cdata *cdata)
+{
+    int i;
+
+    if (cdata->badj_views == NULL) return;
+    for (i = 0; i < 2 * cdata->badj_nblocks; ++i)
+	if (cdata->badj_views[i] != NULL)
+	    N_VDestroy_Serial(cdata->badj_views[i]);
+    free(cdata->badj_views);
+    cdata->badj_views = NULL;
+}
+
+static value init_backward(value vparent, value weakref, value vargs,
+			   int withsens, CVRhsFnB fb)
+{
+    CAMLparam3(vparent, weakref, vargs);
     CAMLlocal2(r, vcvode_mem);
     CAMLlocal2(vlmm, viter);
     int flag, lmm_c, which;
@@ -1764,13 +2077,13 @@ CAMLprim value sunml_cvodes_adj_init_backward(value vparent, value weakref,
 	SCHECK_FLAG("CVodeCreateB", flag);
     }
 
-    if (Bool_val(vwithsens)) {
+    if (withsens) {
 	flag = CVodeInitBS(parent, which, brhsfn_sens, tb0, initial_nv);
 	if (flag != CV_SUCCESS) {
 	    SCHECK_FLAG("CVodeInitBS", flag);
 	}
     } else {
-	flag = CVodeInitB(parent, which, brhsfn, tb0, initial_nv);
+	flag = CVodeInitB(parent, which, fb, tb0, initial_nv);
 	if (flag != CV_SUCCESS) {
 	    SCHECK_FLAG("CVodeInitB", flag);
 	}
@@ -1779,10 +2092,12 @@ CAMLprim value sunml_cvodes_adj_init_backward(value vparent, value weakref,
     vcvode_mem = caml_alloc_final(1, NULL, 1, 15);
     CVODE_MEM(vcvode_mem) = CVodeGetAdjCVodeBmem(parent, which);
 
-    value *backref = sunml_sundials_malloc_value(weakref);
+    value *backref = sunml_sundials_malloc_value_ext(weakref,
+					    sizeof(struct cvode_cdata));
     if (backref == NULL) {
 	caml_raise_out_of_memory();
     }
+    CVODE_CDATA(backref)->neq = sunml_nvec_data_length(initial_nv);
     CVodeSetUserDataB (parent, which, backref);
 
     r = caml_alloc_tuple (3);
@@ -1793,6 +2108,56 @@ CAMLprim value sunml_cvodes_adj_init_backward(value vparent, value weakref,
     CAMLreturn(r);
 }
 
+CAMLprim value sunml_cvodes_adj_init_backward(value vparent, value weakref,
+					      value vargs, value vwithsens)
+{
+    CAMLparam4(vparent, weakref, vargs, vwithsens);
+    CAMLreturn(init_backward(vparent, weakref, vargs, Bool_val(vwithsens),
+			     brhsfn));
+}
+
+/* CVodeCreateB() and CVodeInitB() for a backward problem with a native
+   right-hand side made of independent blocks.  The function and the blocks
+   are given by sunml_cvodes_adj_set_brhsfn_blocks, which must be called
+   before the first step.  */
+CAMLprim value sunml_cvodes_adj_init_backward_cfun(value vparent,
+						   value weakref, value vargs)
+{
+    CAMLparam3(vparent, weakref, vargs);
+    CAMLreturn(init_backward(vparent, weakref, vargs, 0,
+			     native_brhsfn_blocks));
+}
+
+CAMLprim value sunml_cvodes_adj_set_brhsfn_blocks(value vdata, value vlen,
+						  value vnblocks,
+						  value vnthreads, value vcfun)
+{
+    CAMLparam5(vdata, vlen, vnblocks, vnthreads, vcfun);
+    struct cvode_cdata *cdata = CVODE_CDATA_FROM_ML(vdata);
+    int nb = Int_val(vnblocks);
+    int nt = Int_val(vnthreads);
+    sundials_ml_index m = Long_val(vlen) / nb;
+    int i;
+
+    if (nt > nb) nt = nb;
+
+    free_badj_views(cdata);
+    cdata->badj_views = calloc(2 * nb, sizeof(N_Vector));
+    if (cdata->badj_views == NULL) caml_raise_out_of_memory();
+    cdata->badj_nblocks = nb;
+    for (i = 0; i < 2 * nb; ++i) {
+	cdata->badj_views[i] = N_VMake_Serial(m, NULL);
+	if (cdata->badj_views[i] == NULL) {
+	    free_badj_views(cdata);
+	    caml_raise_out_of_memory();
+	}
+    }
+    cdata->brhsfn1 = *CFUN_VAL(vcfun);
+    cdata->badj_nthreads = nt;
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_cvodes_adj_reinit(value vparent, value vwhich,
 				   value vtb0, value vyb0)
 {
@@ -1909,7 +2274,7 @@ CAMLprim value sunml_cvodes_adjquad_sv_tolerances(value vparent, value vwhich,
 
 void sunml_cvodes_check_flag(const char *call, int flag, void *cvode_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == CV_SUCCESS
 	    || flag == CV_ROOT_RETURN
@@ -2638,6 +3003,7 @@ CAMLprim value sunml_cvodes_adj_bsession_finalize(value vdata)
     if (CVODE_MEM_FROM_ML(vdata) != NULL) {
 	value *backref = CVODE_BACKREF_FROM_ML(vdata);
 	// NB: CVodeFree() is *not* called: parents free-up backward problems
+	free_badj_views(CVODE_CDATA(backref));
 	sunml_sundials_free_value(backref);
     }
     return Val_unit;
@@ -58,8 +58,8 @@
 
 void sunml_cvodes_check_flag(const char *call, int flag, void *cvode_mem);
 
-value sunml_cvodes_make_jac_arg(realtype t, N_Vector y, N_Vector yb,
-			  N_Vector fyb, value tmp);
+value sunml_cvodes_make_jac_arg(value session, realtype t, N_Vector y,
+				N_Vector yb, N_Vector fyb, value tmp);
 void sunml_cvodes_wrap_to_nvector_table(int n, value vy, N_Vector *y);
 
 
@@ -167,6 +167,18 @@ enum cvodes_quadsensrhsfn_args_index {
     RECORD_CVODES_QUADSENSRHSFN_ARGS_SIZE
 };
 
+/* Slots of the callback argument cache, following those of Cvode.  */
+enum cvodes_argcache_index {
+    CVODES_ARGCACHE_DOUBLE_TMP = CVODE_ARGCACHE_SIZE,
+    CVODES_ARGCACHE_SENSRHSFN_ARGS,
+    CVODES_ARGCACHE_QUADSENSRHSFN_ARGS,
+    CVODES_ARGCACHE_ADJ_JAC_ARG,
+    CVODES_ARGCACHE_ADJ_SPILS_SOLVE_ARG,
+    CVODES_ARGCACHE_ADJ_BRHSFN_ARGS,
+    CVODES_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+    CVODES_ARGCACHE_SIZE
+};
+
 enum cvodes_adj_interpolation {
     VARIANT_CVODES_ADJ_INTERPOLATION_POLYNOMIAL = 0,
     VARIANT_CVODES_ADJ_INTERPOLATION_HERMITE
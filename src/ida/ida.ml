@@ -65,6 +65,9 @@ exception VectorOpErr
 
 let no_roots = (0, dummy_rootsfn)
 
+let masked_roots m g =
+  (RootMask.length m, fun t y y' gout -> RootMask.eval m (g t y y') gout)
+
 type integrator_stats = {
     num_steps : int;
     num_res_evals : int;
@@ -245,7 +248,7 @@ module Dls = struct (* {{{ *)
     | LSI.Superlumt _ ->
         if jac = None then invalid_arg "Superlumt requires Jacobian function";
         session.ls_callbacks <- SlsSuperlumtCallback cb
-    | LSI.Custom _ ->
+    | LSI.Custom _ | LSI.BlockDiag ->
         check_dqjac jac mat;
         session.ls_callbacks <- DirectCustomCallback cb
     | _ -> assert false
@@ -286,6 +289,10 @@ module Dls = struct (* {{{ *)
     LSI.attach ls;
     session.ls_solver <- LSI.HLS hls
 
+  let colored_jac c f { jac_t = t; jac_y = y; jac_y' = yp;
+                        jac_res = r; jac_coef = cj } jm =
+    Matrix.Coloring.dae_jacobian c (f t) cj y yp r jm
+
   (* Sundials < 3.0.0 *)
   let invalidate_callback session =
     if in_compat_mode2 then
@@ -471,6 +478,15 @@ module Spils = struct (* {{{ *)
         c_set_jac_times session (jac_times_setup <> None)
                                 (jac_times_vec <> None)
 
+  let dual_jac_times_vec fd { jac_t; jac_y; jac_y'; jac_coef;
+                              jac_tmp = (tmp1, tmp2); _ } v jv =
+    for i = 0 to RealArray.length v - 1 do
+      tmp2.{i} <- jac_coef *. v.{i}
+    done;
+    fd jac_t { Nvector_dual.value = jac_y; Nvector_dual.tangent = v }
+             { Nvector_dual.value = jac_y'; Nvector_dual.tangent = tmp2 }
+             { Nvector_dual.value = tmp1; Nvector_dual.tangent = jv }
+
   let set_jac_times s ?jac_times_setup f =
     if in_compat_mode2 && jac_times_setup <> None then
         raise Config.NotImplementedBySundialsVersion;
@@ -565,6 +581,31 @@ module Spils = struct (* {{{ *)
     if in_compat_mode2_3 then ls_check_spils s;
     get_num_lin_res_evals s
 
+  module Native = struct (* {{{ *)
+
+    type 'm setup_fn = (unit, RealArray.t) jacobian_arg -> 'm -> unit
+
+    external c_set_preconditioner : ('a, 'k) session -> unit
+      = "sunml_ida_set_native_preconditioner"
+
+    let init_preconditioner setup (np : 'm LSI.Iterative.native) session nv =
+      if RealArray.length (Nvector.unwrap nv) <> np.LSI.Iterative.native_size
+      then invalid_arg "Ida.Spils.Native: wrong number of equations";
+      let m = np.LSI.Iterative.native_matrix in
+      let prec_setup_fn jac =
+        setup jac m;
+        np.LSI.Iterative.native_factor ()
+      in
+      let prec_solve_fn _ r z _ = LinearSolver.Native.solve np r z in
+      c_set_preconditioner session;
+      session.ls_precfns <-
+        NativePrecFns ({ prec_setup_fn = Some prec_setup_fn; prec_solve_fn },
+                       np.LSI.Iterative.native_cptr)
+
+    let prec_left setup np =
+      LSI.Iterative.(PrecLeft, init_preconditioner setup np)
+  end (* }}} *)
+
 end (* }}} *)
 
 external sv_tolerances
@@ -621,10 +662,11 @@ external c_set_nonlinear_solver
 
 external c_init : ('a, 'k) session Weak.t -> float
                   -> ('a, 'k) Nvector.t -> ('a, 'k) Nvector.t
+                  -> Sundials.cfun option
                   -> (ida_mem * c_weak_ref)
     = "sunml_ida_init"
 
-let init tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
+let init' tol nlsolver lsolver resfn cfun varid roots t0 y y' =
   let (nroots, rootsfn) = roots in
   let checkvec = Nvector.check y in
   if Sundials_configuration.safe then
@@ -635,7 +677,7 @@ let init tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
     match nlsolver with
     | Some nls when NLSI.(get_type nls <> RootFind) -> raise IllInput
     | _ -> ());
-  let ida_mem, backref = c_init weakref t0 y y' in
+  let ida_mem, backref = c_init weakref t0 y y' cfun in
   (* ida_mem and backref have to be immediately captured in a session and
      associated with the finalizer before we do anything else.  *)
   let session = { ida        = ida_mem;
@@ -644,6 +686,7 @@ let init tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
                   checkvec   = checkvec;
 
                   exn_temp   = None;
+                  argcache   = Sundials_impl.make_arg_cache ();
 
                   id_set     = false;
                   resfn      = resfn;
@@ -679,6 +722,12 @@ let init tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
    | _ -> ());
   session
 
+let init tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
+  init' tol nlsolver lsolver resfn None varid roots t0 y y'
+
+let init_cfun tol ?nlsolver ~lsolver resfn ?varid ?(roots=no_roots) t0 y y' =
+  init' tol nlsolver lsolver dummy_resfn (Some resfn) varid roots t0 y y'
+
 let get_num_roots { nroots } = nroots
 
 external c_reinit
@@ -686,15 +735,26 @@ external c_reinit
       -> ('a, 'k) Nvector.t -> unit
     = "sunml_ida_reinit"
 
-let reinit session ?nlsolver ?lsolver ?roots t0 y0 y'0 =
+external c_keep_jacobian : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_matrix_keep_jacobian"
+
+let reinit session ?nlsolver ?lsolver ?roots ?keep_jacobian t0 y0 y'0 =
   if Sundials_configuration.safe then
     (session.checkvec y0;
      session.checkvec y'0);
+  if in_compat_mode2 && keep_jacobian <> None
+    then raise Config.NotImplementedBySundialsVersion;
   Dls.invalidate_callback session;
   c_reinit session t0 y0 y'0;
   (match lsolver with
    | None -> ()
    | Some linsolv -> linsolv session y0);
+  (match keep_jacobian with
+   | None -> ()
+   | Some keep ->
+       (* the matrix of a new linear solver may differ from the saved one *)
+       if lsolver <> None then c_keep_jacobian session.argcache false;
+       c_keep_jacobian session.argcache keep);
   (if in_compat_mode2_3 then
     match nlsolver with
     | Some nls when NLSI.(get_type nls <> RootFind) -> raise IllInput
@@ -742,6 +802,22 @@ let solve_one_step s t y yp =
      s.checkvec yp);
   c_solve_one_step s t y yp
 
+external c_solve_schedule : ('a, 'k) session -> RealArray.t
+                            -> ('a, 'k) Nvector.t -> ('a, 'k) Nvector.t
+                            -> RealArray2.t -> int * float * solver_result
+    = "sunml_ida_solve_schedule"
+
+let solve_schedule s ts y yp yout =
+  if Sundials_configuration.safe then
+    (s.checkvec y;
+     s.checkvec yp);
+  if RealArray.length ts = 0
+  then invalid_arg "solve_schedule: no output times";
+  if RealArray2.size yout <> (RealArray.length (Nvector.unwrap y),
+                               RealArray.length ts)
+  then invalid_arg "solve_schedule: array sizes do not match";
+  c_solve_schedule s ts y yp yout
+
 external c_get_dky
     : ('a, 'k) session -> float -> int -> ('a, 'k) Nvector.t -> unit
     = "sunml_ida_get_dky"
@@ -750,41 +826,110 @@ let get_dky s y =
   if Sundials_configuration.safe then s.checkvec y;
   fun t k -> c_get_dky s t k y
 
+external c_get_dky_many
+    : ('a, 'k) session -> RealArray.t -> int -> ('a, 'k) Nvector.t
+      -> RealArray2.t -> unit
+    = "sunml_ida_get_dky_many"
+
+let get_dky_many s y ts k dkys =
+  if Sundials_configuration.safe then s.checkvec y;
+  if RealArray2.size dkys <> (RealArray.length (Nvector.unwrap y),
+                               RealArray.length ts)
+  then invalid_arg "get_dky_many: array sizes do not match";
+  c_get_dky_many s ts k y dkys
+
+type snapshot
+
+external snapshot : ('a, 'k) session -> snapshot
+    = "sunml_ida_snapshot"
+
+external restore : ('a, 'k) session -> snapshot -> unit
+    = "sunml_ida_restore"
+
+module Pool = struct (* {{{ *)
+
+  type 'k t = {
+    create : float -> (Nvector_serial.data, 'k) Nvector.t
+               -> (Nvector_serial.data, 'k) Nvector.t
+               -> (Nvector_serial.data, 'k) session;
+    free   : (int, (Nvector_serial.data, 'k) session list) Hashtbl.t;
+    mutable busy : ((Nvector_serial.data, 'k) session * int) list;
+  }
+
+  let create create = { create; free = Hashtbl.create 8; busy = [] }
+
+  let acquire p t0 y0 y'0 =
+    let n = RealArray.length (Nvector.unwrap y0) in
+    let s =
+      match (try Hashtbl.find p.free n with Not_found -> []) with
+      | s :: ss ->
+          Hashtbl.replace p.free n ss;
+          reinit s t0 y0 y'0;
+          s
+      | [] -> p.create t0 y0 y'0
+    in
+    p.busy <- (s, n) :: p.busy;
+    s
+
+  let release p s =
+    match (try Some (List.assq s p.busy) with Not_found -> None) with
+    | None -> invalid_arg "Pool.release: session not acquired from this pool"
+    | Some n ->
+        p.busy <- List.filter (fun (s', _) -> s' != s) p.busy;
+        let ss = try Hashtbl.find p.free n with Not_found -> [] in
+        Hashtbl.replace p.free n (s :: ss)
+
+  let clear p = Hashtbl.reset p.free
+
+end (* }}} *)
+
 external get_integrator_stats : ('a, 'k) session -> integrator_stats
     = "sunml_ida_get_integrator_stats"
 
 external get_work_space         : ('a, 'k) session -> int * int
     = "sunml_ida_get_work_space"
 
-external get_num_steps          : ('a, 'k) session -> int
-    = "sunml_ida_get_num_steps"
+external get_num_steps          : ('a, 'k) session -> (int [@untagged])
+    = "sunml_ida_get_num_steps" "sunml_ida_get_num_steps_untagged"
+    [@@noalloc]
 
-external get_num_res_evals      : ('a, 'k) session -> int
-    = "sunml_ida_get_num_res_evals"
+external get_num_res_evals      : ('a, 'k) session -> (int [@untagged])
+    = "sunml_ida_get_num_res_evals" "sunml_ida_get_num_res_evals_untagged"
+    [@@noalloc]
 
-external get_num_lin_solv_setups : ('a, 'k) session -> int
+external get_num_lin_solv_setups : ('a, 'k) session -> (int [@untagged])
     = "sunml_ida_get_num_lin_solv_setups"
+      "sunml_ida_get_num_lin_solv_setups_untagged"
+    [@@noalloc]
 
-external get_num_err_test_fails : ('a, 'k) session -> int
+external get_num_err_test_fails : ('a, 'k) session -> (int [@untagged])
     = "sunml_ida_get_num_err_test_fails"
+      "sunml_ida_get_num_err_test_fails_untagged"
+    [@@noalloc]
 
-external get_last_order         : ('a, 'k) session -> int
-    = "sunml_ida_get_last_order"
+external get_last_order         : ('a, 'k) session -> (int [@untagged])
+    = "sunml_ida_get_last_order" "sunml_ida_get_last_order_untagged"
+    [@@noalloc]
 
-external get_current_order      : ('a, 'k) session -> int
-    = "sunml_ida_get_current_order"
+external get_current_order      : ('a, 'k) session -> (int [@untagged])
+    = "sunml_ida_get_current_order" "sunml_ida_get_current_order_untagged"
+    [@@noalloc]
 
-external get_actual_init_step   : ('a, 'k) session -> float
-    = "sunml_ida_get_actual_init_step"
+external get_actual_init_step   : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_ida_get_actual_init_step" "sunml_ida_get_actual_init_step_unboxed"
+    [@@noalloc]
 
-external get_last_step          : ('a, 'k) session -> float
-    = "sunml_ida_get_last_step"
+external get_last_step          : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_ida_get_last_step" "sunml_ida_get_last_step_unboxed"
+    [@@noalloc]
 
-external get_current_step       : ('a, 'k) session -> float
-    = "sunml_ida_get_current_step"
+external get_current_step       : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_ida_get_current_step" "sunml_ida_get_current_step_unboxed"
+    [@@noalloc]
 
-external get_current_time       : ('a, 'k) session -> float
-    = "sunml_ida_get_current_time"
+external get_current_time       : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_ida_get_current_time" "sunml_ida_get_current_time_unboxed"
+    [@@noalloc]
 
 let print_integrator_stats s oc =
   let stats = get_integrator_stats s
@@ -800,6 +945,53 @@ let print_integrator_stats s oc =
     Printf.fprintf oc "current_step = %e\n"        stats.current_step;
     Printf.fprintf oc "current_time = %e\n"        stats.current_time;
 
+external c_set_tracing : Sundials_impl.arg_cache -> int -> unit
+    = "sunml_sundials_set_tracing"
+
+external c_get_trace : Sundials_impl.arg_cache -> Sundials.Trace.event array
+    = "sunml_sundials_get_trace"
+
+external c_set_recorder
+    : Sundials_impl.arg_cache -> Sundials.Recorder.t option -> unit
+    = "sunml_sundials_set_recorder"
+
+external c_set_profiling : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_sundials_set_profiling"
+
+external c_get_profile : Sundials_impl.arg_cache -> profile
+    = "sunml_sundials_get_profile"
+
+let set_profiling s enable = c_set_profiling s.argcache enable
+
+let get_profile s = c_get_profile s.argcache
+
+let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+let get_trace s = c_get_trace s.argcache
+
+let set_recorder s r = c_set_recorder s.argcache r
+
+type memory_report = {
+  work_space : int * int;
+  lsolver_work_space : int * int;
+  process_nvectors : Nvector.memory;
+}
+
+external c_dls_get_work_space : ('a, 'k) session -> int * int
+    = "sunml_ida_dls_get_work_space"
+
+let get_memory_report s =
+  let lsolver_work_space =
+    match s.ls_callbacks with
+    | NoCallbacks -> (0, 0)
+    | SpilsCallback _ | BSpilsCallback _ | BSpilsCallbackSens _ ->
+        Spils.get_work_space s
+    | _ -> c_dls_get_work_space s
+  in
+  { work_space = get_work_space s;
+    lsolver_work_space;
+    process_nvectors = Nvector.get_memory () }
+
 external set_error_file : ('a, 'k) session -> Logfile.t -> unit
     = "sunml_ida_set_error_file"
 
@@ -855,8 +1047,9 @@ external set_no_inactive_root_warn      : ('a, 'k) session -> unit
 external get_num_stab_lim_order_reds    : ('a, 'k) session -> int
     = "c_ida_get_num_stab_lim_order_reds"
 *)
-external get_tol_scale_factor           : ('a, 'k) session -> float
-    = "sunml_ida_get_tol_scale_factor"
+external get_tol_scale_factor           : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_ida_get_tol_scale_factor" "sunml_ida_get_tol_scale_factor_unboxed"
+    [@@noalloc]
 
 external c_get_err_weights : ('a, 'k) session -> ('a, 'k) Nvector.t -> unit
     = "sunml_ida_get_err_weights"
@@ -872,17 +1065,22 @@ let get_est_local_errors s ew =
   if Sundials_configuration.safe then s.checkvec ew;
   c_get_est_local_errors s ew
 
-external get_num_nonlin_solv_iters      : ('a, 'k) session -> int
+external get_num_nonlin_solv_iters      : ('a, 'k) session -> (int [@untagged])
     = "sunml_ida_get_num_nonlin_solv_iters"
+      "sunml_ida_get_num_nonlin_solv_iters_untagged"
+    [@@noalloc]
 
-external get_num_nonlin_solv_conv_fails : ('a, 'k) session -> int
+external get_num_nonlin_solv_conv_fails : ('a, 'k) session -> (int [@untagged])
     = "sunml_ida_get_num_nonlin_solv_conv_fails"
+      "sunml_ida_get_num_nonlin_solv_conv_fails_untagged"
+    [@@noalloc]
 
 external get_nonlin_solv_stats          : ('a, 'k) session -> int * int
     = "sunml_ida_get_nonlin_solv_stats"
 
-external get_num_g_evals                : ('a, 'k) session -> int
-    = "sunml_ida_get_num_g_evals"
+external get_num_g_evals                : ('a, 'k) session -> (int [@untagged])
+    = "sunml_ida_get_num_g_evals" "sunml_ida_get_num_g_evals_untagged"
+    [@@noalloc]
 
 external c_set_constraints : ('a,'k) session -> ('a,'k) Nvector.t -> unit
   = "sunml_ida_set_constraints"
@@ -80,6 +80,13 @@ type 'd triple = 'd * 'd * 'd
 
 (** Arguments common to Jacobian callback functions.
 
+    {warning The record is reused between calls and should not be
+             retained after the callback returns.}
+
+    Only the record is reused: its [jac_t] and [jac_coef] fields, like the
+    other float arguments of callbacks, are boxed afresh at each call, so
+    callbacks still allocate their float arguments.
+
     @noida <node5> IDALsJacFn
     @noida <node5> IDALsJacTimesVecFn
     @noida <node5> IDALsPrecSolveFn
@@ -137,6 +144,17 @@ module Dls : sig (* {{{ *)
     ('m, RealArray.t, 'kind, [>`Dls]) LinearSolver.t ->
     'kind serial_linear_solver
 
+  (** [colored_jac c f] approximates the Jacobian
+      {% $\frac{\partial F}{\partial y} + c_j\frac{\partial F}{\partial\dot{y}}$%}
+      of the residual function [f] by finite differences, with one
+      evaluation of [f] per color of [c] (see {!Matrix.Coloring}). It is
+      an alternative to a hand-written Jacobian function for sparse and
+      band matrices. *)
+  val colored_jac : 'm Matrix.Coloring.t
+                    -> (float -> RealArray.t -> RealArray.t -> RealArray.t
+                        -> unit)
+                    -> 'm jac_fn
+
   (** {3:stats Solver statistics} *)
 
   (** Returns the sizes of the real and integer workspaces used by a direct
@@ -236,6 +254,30 @@ module Spils : sig (* {{{ *)
     -> 'd prec_solve_fn
     -> ('d, 'k) preconditioner
 
+  (** Native preconditioners (see {!Sundials_LinearSolver.Native}).
+      The setup function fills the matrix of the preconditioner with an
+      approximation of
+      {% $\frac{\partial F}{\partial y} + c_j\frac{\partial F}{\partial\dot{y}}$%};
+      the matrix is then factored, and the preconditioner is applied in C,
+      without calling back into OCaml, at each Krylov iteration.  *)
+  module Native : sig (* {{{ *)
+
+    (** A function [setup jac m] that fills [m] with an approximation of
+        the system Jacobian. The argument [jac] is as for
+        {!prec_setup_fn}.
+
+        @raise Sundials.RecoverableFailure To signal a recoverable error. *)
+    type 'm setup_fn = (unit, RealArray.t) jacobian_arg -> 'm -> unit
+
+    (** Left preconditioning with a native preconditioner.
+
+        @ida <node5> IDASetPreconditioner *)
+    val prec_left : 'm setup_fn
+                    -> 'm LinearSolver.Native.t
+                    -> (Nvector_serial.data,
+                        [>Nvector_serial.kind]) preconditioner
+  end (* }}} *)
+
   (** {3:lsolvers Solvers} *)
 
   (** Callback functions that preprocess or evaluate Jacobian-related data
@@ -284,6 +326,21 @@ module Spils : sig (* {{{ *)
     -> ('d, 'k) preconditioner
     -> ('d, 'k) linear_solver
 
+  (** Computes exact Jacobian-vector products by forward-mode automatic
+      differentiation. The call [dual_jac_times_vec fd] returns a
+      {!jac_times_vec_fn} that computes
+      {% $J\mathtt{v} = \frac{\partial F}{\partial y}\mathtt{v}
+           + c_j \frac{\partial F}{\partial\dot{y}}\mathtt{v}$%}
+      with a single call [fd t y y' r], where [fd] evaluates the residual
+      function on dual-number vectors (see {!Nvector_dual}). The tangents of
+      [y] are [v] and those of [y'] are [c_j v]; the tangents of [r]
+      receive the product, and its values are discarded. Both work vectors
+      are used, so no memory is allocated for the vectors. *)
+  val dual_jac_times_vec :
+    (float -> Nvector_dual.data -> Nvector_dual.data -> Nvector_dual.data
+     -> unit)
+    -> Nvector_serial.data jac_times_vec_fn
+
   (** {3:set Solver parameters} *)
 
   (** Sets the factor by which the Krylov linear solver's convergence test
@@ -451,6 +508,9 @@ type 'd resfn = float -> 'd -> 'd -> 'd -> unit
     {warning [y], [y'], and [gout] should not be accessed after the function
              has returned.}
 
+    The same [gout] array is passed to each call. Once the function has
+    returned, it is empty until the next call.
+
     @ida <node5#ss:rootFn> IDARootFn *)
 type 'd rootsfn = float -> 'd -> 'd -> RealArray.t -> unit
 
@@ -504,9 +564,44 @@ val init :
     -> ('d, 'kind) Nvector.t
     -> ('d, 'kind) session
 
+(** Like {!init} but the residual is a native C function rather than an
+    OCaml closure. The function must have the C type
+    [int f(realtype t, N_Vector y, N_Vector yp, N_Vector r, void *data)],
+    where [data] is the pointer given to [sunml_sundials_wrap_cfun], and it
+    must follow the SUNDIALS return value conventions (0 for success, a
+    positive value for a recoverable error, and a negative value for an
+    unrecoverable error). It is called directly by IDA without entering the
+    OCaml runtime, so it must not call back into OCaml. The other callbacks
+    may still be OCaml closures.
+
+    @ida <node5#sss:idainit> IDACreate/IDAInit
+    @ida <node5#ss:resFn> IDAResFn *)
+val init_cfun :
+    ('d, 'kind) tolerance
+    -> ?nlsolver: ('d, 'kind,
+                   (('d, 'kind) session) Sundials_NonlinearSolver.integrator)
+                  Sundials_NonlinearSolver.t
+    -> lsolver:('d, 'kind) linear_solver
+    -> Sundials.cfun
+    -> ?varid:('d, 'kind) Nvector.t
+    -> ?roots:(int * 'd rootsfn)
+    -> float
+    -> ('d, 'kind) Nvector.t
+    -> ('d, 'kind) Nvector.t
+    -> ('d, 'kind) session
+
 (** A convenience value for signalling that there are no roots to monitor. *)
 val no_roots : (int * 'd rootsfn)
 
+(** [masked_roots m g] returns root functions for use with [~roots] that
+    only evaluate the active entries of the mask [m]: {!RootMask.eval}
+    calls [g t y y' i] for each active index [i]. The mask may be updated
+    between calls to the solver functions.
+
+    The number of root functions is [RootMask.length m]. *)
+val masked_roots :
+  RootMask.t -> (float -> 'd -> 'd -> int -> float) -> (int * 'd rootsfn)
+
 (** {3:calcic Initial Condition Calculation} *)
 
 (** Symbolic names for constants used when calculating initial values or
@@ -700,6 +795,29 @@ val solve_one_step : ('d, 'k) session -> float
                      -> ('d, 'k) Nvector.t -> ('d, 'k) Nvector.t
                      -> float * solver_result
 
+(** Integrates a DAE system over a sequence of output times. The call
+    [n, tret, r = solve_schedule s ts y y' yout] calls {!solve_normal} for
+    each time in [ts], which must be nonempty and monotonic, and stores the
+    solution at [ts.{i}] in the [i]th column of [yout], using [y] and [y']
+    as workspace. The array [yout] must have a row for each element of [y]
+    and a column for each element of [ts]. The whole loop runs in a single
+    call into C.
+
+    It returns [n], the number of columns filled, [tret], the time reached
+    by the last step, and [r], the result of the last step. The loop stops
+    early when a root or the stop time is reached; in that case, [y] and
+    [y'] hold the solution and its derivative at [tret] and the call can be
+    resumed with the remaining times once the event has been handled.
+    Exceptions are propagated as for {!solve_normal} with the columns for
+    the times already reached filled.
+
+    @ida <node5#sss:idasolve> IDASolve (IDA_NORMAL)
+    @raise Invalid_argument [ts] is empty or the array sizes do not agree. *)
+val solve_schedule : (Nvector_serial.data, 'k) session -> RealArray.t
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> (Nvector_serial.data, 'k) Nvector.t
+                     -> RealArray2.t -> int * float * solver_result
+
 (** Returns the interpolated solution or derivatives.
     [get_dky s dky t k] computes the [k]th derivative of the function at time
     [t], i.e., {% $\frac{d^\mathtt{k}y(\mathtt{t})}{\mathit{dt}^\mathtt{k}}$%},
@@ -717,6 +835,21 @@ val solve_one_step : ('d, 'k) session -> float
     @raise BadK [k] is not in the range 0, 1, ..., $q_u$. *)
 val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
 
+(** Evaluates the interpolated solution or derivatives at several times.
+    [get_dky_many s dky ts k dkys] computes the [k]th derivative at each
+    time [ts.{i}], as {!get_dky} does, and stores it in the [i]th column of
+    [dkys], using [dky] as workspace. The array [dkys] must have a row for
+    each element of [dky] and a column for each element of [ts]. All of the
+    evaluations are made in a single call into C.
+
+    @ida <node5#sss:optin_root> IDAGetDky
+    @raise BadT A time is not in the interval {% $[t_n - h_u, t_n]$%}.
+    @raise BadK [k] is not in the range 0, 1, ..., $q_u$.
+    @raise Invalid_argument The sizes of [dky], [ts], and [dkys] do not agree. *)
+val get_dky_many : (Nvector_serial.data, 'k) session
+                   -> (Nvector_serial.data, 'k) Nvector.t
+                   -> RealArray.t -> int -> RealArray2.t -> unit
+
 (** Reinitializes the solver with new parameters and state values. The
     values of the independent variable, i.e., the simulation time, the
     state variables, and the derivatives must be given.
@@ -724,6 +857,16 @@ val get_dky : ('d, 'k) session -> ('d, 'k) Nvector.t -> float -> int -> unit
     remains unchanged. The argument [~roots] works similarly; pass
     {!no_roots} to disable root finding.
 
+    If [keep_jacobian] is [true], the first Jacobian requested after
+    reinitialization is the last one computed, rather than a new
+    evaluation, and subsequent Jacobians are saved for later
+    reinitializations. This only applies to matrix-based linear solvers
+    with a Jacobian function. The restored Jacobian was computed at the
+    state and with the coefficient $c_j$ in use before reinitialization;
+    the Newton iteration may thus need more iterations to converge. If
+    [keep_jacobian] is [false], Jacobians are no longer saved. By default,
+    the current setting is kept but no Jacobian is restored.
+
     @ida <node5#sss:cvreinit> IDAReInit
     @ida <node>               IDASetLinearSolver
     @ida <node>               IDASetNonlinearSolver *)
@@ -734,11 +877,103 @@ val reinit :
                Sundials_NonlinearSolver.t
   -> ?lsolver:('d, 'k) linear_solver
   -> ?roots:(int * 'd rootsfn)
+  -> ?keep_jacobian:bool
   -> float
   -> ('d, 'k) Nvector.t
   -> ('d, 'k) Nvector.t
   -> unit
 
+(** The state of a session at a given time: the history array, the step
+    size and order history, the method coefficients, and the counters (see
+    {!snapshot}). *)
+type snapshot
+
+(** Captures the state of a session, typically between two calls to
+    {!solve_one_step} or {!solve_normal}, so that the integration can be
+    resumed later from the same point with {!restore}, for instance to
+    branch into several scenarios. Taking a snapshot copies [q+4] vectors,
+    where [q] is the maximum order, and the vector tolerances, variable
+    types, and constraints, if any.
+
+    @raise Invalid_argument Quadratures, sensitivities, or adjoint problems are active (Idas).
+    @raise Config.NotImplementedBySundialsVersion Not available for Sundials >= 4.1.0.
+    @since 4.0.0 *)
+val snapshot : ('d, 'k) session -> snapshot
+
+(** Resets a session to a state captured by {!snapshot}. The integration
+    then resumes with the step size, order, and error history it had at the
+    time of the snapshot, unlike after {!reinit}, and the counters are
+    restored too, as is the state of the rootfinding. A fresh linear solver
+    setup, with a new Jacobian or preconditioner evaluation, is made at the
+    next step, so that restoring the same snapshot always leads to the same
+    solution. The counters of the linear solver, which are kept in its own
+    memory, are not restored.
+
+    The session must be the one from which the snapshot was taken and it
+    must not have been reconfigured in between, i.e., its linear and
+    nonlinear solvers and its root functions must not have been replaced,
+    nor its maximum order changed. Nor may the optional inputs of the
+    integrator (e.g., the tolerances, the step size bounds, the stop time,
+    or the root directions) have been changed since the snapshot: they are
+    not silently reverted.
+
+    The [y] and [y'] vectors passed to the solution functions are not
+    modified.
+
+    @raise Invalid_argument The session has been reconfigured, or its optional inputs changed, since the snapshot.
+    @raise Config.NotImplementedBySundialsVersion Not available for Sundials >= 4.1.0.
+    @since 4.0.0 *)
+val restore : ('d, 'k) session -> snapshot -> unit
+
+(** Recycling sessions across problems of different sizes.
+
+    Applications that solve a stream of problems, such as the cells of an
+    adaptive mesh, often return to the same few problem sizes. Creating a
+    session allocates the solver memory, the linear solver and its matrix,
+    and, as Sundials before version 5 cannot resize an IDA session, a new
+    session is needed whenever the size changes. A pool keeps the sessions
+    that are no longer in use, indexed by their size, and reinitializes one
+    of them with {!reinit} when a problem of the same size arrives, so that
+    their workspace is reused. The tolerances, linear solver, and other
+    optional inputs of a recycled session are those it had when it was
+    released. *)
+module Pool : sig (* {{{ *)
+
+  (** A pool of sessions for serial nvectors. *)
+  type 'k t
+
+  (** [create f] returns an empty pool, where [f t0 y0 y'0] creates, with
+      {!init}, a session for a problem with initial values [y0] and
+      derivatives [y'0] at [t0]. The length of [y0] determines the sizes of
+      the vectors and matrices that [f] creates. *)
+  val create :
+    (float -> (Nvector_serial.data, 'k) Nvector.t
+            -> (Nvector_serial.data, 'k) Nvector.t
+            -> (Nvector_serial.data, 'k) session)
+    -> 'k t
+
+  (** [acquire p t0 y0 y'0] returns a session for a problem of the same
+      length as [y0], starting from [y0] and [y'0] at [t0]. A released
+      session of that length is reinitialized if possible, and a new one is
+      created otherwise. The session belongs to the caller until it is
+      passed to {!release}. *)
+  val acquire :
+    'k t -> float -> (Nvector_serial.data, 'k) Nvector.t
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> (Nvector_serial.data, 'k) session
+
+  (** Returns a session obtained from {!acquire} to the pool. The session
+      must not be used again, except by obtaining it from {!acquire}.
+
+      @raise Invalid_argument The session was not acquired from this pool. *)
+  val release : 'k t -> (Nvector_serial.data, 'k) session -> unit
+
+  (** Forgets the released sessions, which are then reclaimed normally by
+      the garbage collector. *)
+  val clear : 'k t -> unit
+
+end (* }}} *)
+
 (** {2:set Modifying the solver (optional input functions)} *)
 
 (** Set the integration tolerances.
@@ -939,6 +1174,58 @@ val get_integrator_stats    : ('d, 'k) session -> integrator_stats
     @ida <node5#sss:optout_main> IDAGetIntegratorStats *)
 val print_integrator_stats  : ('d, 'k) session -> out_channel -> unit
 
+(** Enables or disables profiling of the session. Enabling profiling
+    resets the counters, which then accumulate the number of calls and the
+    time spent in the solver and in each category of callback (see
+    {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+    Profiling is disabled by default. *)
+val set_profiling : ('d, 'k) session -> bool -> unit
+
+(** Returns the profiling counters of the session. All of the counters are
+    zero if profiling has never been enabled. See {!set_profiling}. *)
+val get_profile : ('d, 'k) session -> Sundials.profile
+
+(** Enables tracing of the session, with a buffer that keeps the given
+    number of most recent events, or disables it if the capacity is zero
+    (see {!Sundials.Trace}). Enabling tracing again discards the events
+    recorded so far. Tracing is independent of profiling and is disabled by
+    default.
+
+    @raise Invalid_argument If the capacity is negative. *)
+val set_tracing : ('d, 'k) session -> int -> unit
+
+(** Returns the events recorded in the trace of the session, oldest first.
+    The array is empty if tracing is disabled. See {!set_tracing}. *)
+val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
+(** Attaches a recorder to the session, or detaches the current one (see
+    {!Sundials.Recorder}). After each successful call to {!solve_normal},
+    {!solve_one_step}, or {!solve_schedule}, the time reached and the
+    solution are appended to the recording. A session holds at most one
+    recorder, which remains open when it is detached. *)
+val set_recorder : (Nvector_serial.data, 'k) session
+                   -> Sundials.Recorder.t option -> unit
+
+(** A memory report of a session. The sizes of workspaces are given as
+    pairs of the numbers of real and integer words, as reported by Sundials;
+    they include the vectors that it allocates. The nvector counts are not
+    specific to the session: they are process-wide and cover all of the
+    nvectors of the library, since those cloned by Sundials cannot be
+    attributed to a session (linear solvers, for instance, clone their
+    vectors before they are attached to a session). *)
+type memory_report = {
+  work_space : int * int;          (** The integrator, see
+                                       {!get_work_space}. *)
+  lsolver_work_space : int * int;  (** The linear solver, including its
+                                       matrix, or [(0, 0)] if there is
+                                       none. *)
+  process_nvectors : Nvector.memory;
+                                   (** Process-wide counts, see
+                                       {!Nvector.get_memory}. *)
+}
+
+(** Returns a memory report for the session. *)
+val get_memory_report : ('d, 'k) session -> memory_report
 
 (** Returns the number of nonlinear (functional or Newton) iterations performed.
 
@@ -337,6 +337,8 @@ type ('a,'kind) session = {
 
   (* Temporary storage for exceptions raised within callbacks.  *)
   mutable exn_temp   : exn option;
+  (* Reused callback arguments (see sundials_ml.h). *)
+  argcache           : Sundials_impl.arg_cache;
   (* Tracks whether IDASetId has been called. *)
   mutable id_set     : bool;
 
@@ -481,6 +483,7 @@ and 'a linsolv_precfns =
   | BPrecFnsSens of 'a AdjointTypes'.SpilsTypes'.precfns_with_sens
 
   | BandedPrecFns
+  | NativePrecFns of 'a SpilsTypes'.precfns * LSI.Iterative.native_cptr
 
   | BBDPrecFns of 'a IdaBbdParamTypes.precfns
   | BBBDPrecFns of 'a IdasBbdParamTypes.precfns
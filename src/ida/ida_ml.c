@@ -75,6 +75,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #define MAX_ERRMSG_LEN 256
 
@@ -179,19 +180,33 @@ static int resfn (realtype t, N_Vector y, N_Vector yp,
 
     WEAK_DEREF (session, *(value*)user_data);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (IDA_RESFN_FROM_ML (session), 4, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_RHS);
 
     CAMLreturnT (int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
-value sunml_ida_make_jac_arg(realtype t, realtype coef, N_Vector y, N_Vector yp,
-		       N_Vector res, value tmp)
+/* Forward to a native residual function without entering OCaml. */
+static int native_resfn (realtype t, N_Vector y, N_Vector yp,
+			 N_Vector resval, void *user_data)
 {
-    CAMLparam1(tmp);
+    struct sunml_cfun *f = &(IDA_CDATA(user_data)->resfn);
+    return ((IDAResFn)(f->fn))(t, y, yp, resval, f->data);
+}
+
+/* The argument records are cached in the session and updated in place
+   (see sunml_argcache_block).  */
+value sunml_ida_make_jac_arg(value session, realtype t, realtype coef,
+			     N_Vector y, N_Vector yp, N_Vector res, value tmp)
+{
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_IDA_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(IDA_ARGCACHE_FROM_ML(session),
+			     IDA_ARGCACHE_JAC_ARG,
+			     RECORD_IDA_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_IDA_JACOBIAN_ARG_JAC_T, caml_copy_double(t));
     Store_field(r, RECORD_IDA_JACOBIAN_ARG_JAC_COEF, caml_copy_double(coef));
     Store_field(r, RECORD_IDA_JACOBIAN_ARG_JAC_Y, NVEC_BACKLINK(y));
@@ -202,24 +217,27 @@ value sunml_ida_make_jac_arg(realtype t, realtype coef, N_Vector y, N_Vector yp,
     CAMLreturn(r);
 }
 
-value sunml_ida_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+value sunml_ida_make_triple_tmp(value session, N_Vector tmp1,
+				N_Vector tmp2, N_Vector tmp3)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(3);
+    r = sunml_argcache_block(IDA_ARGCACHE_FROM_ML(session),
+			     IDA_ARGCACHE_TRIPLE_TMP, 3);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     Store_field(r, 2, NVEC_BACKLINK(tmp3));
     CAMLreturn(r);
 }
 
-value sunml_ida_make_double_tmp(N_Vector tmp1, N_Vector tmp2)
+value sunml_ida_make_double_tmp(value session, N_Vector tmp1, N_Vector tmp2)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(2);
+    r = sunml_argcache_block(IDA_ARGCACHE_FROM_ML(session),
+			     IDA_ARGCACHE_DOUBLE_TMP, 2);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     CAMLreturn(r);
@@ -243,17 +261,24 @@ static int jacfn (realtype t,
 
     WEAK_DEREF (session, *(value*)user_data);
 
+    if (sunml_jac_cache_restore(IDA_ARGCACHE_FROM_ML(session), jac))
+	CAMLreturnT(int, 0);
+
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_ida_make_jac_arg (t, coef, y, yp, res,
-				sunml_ida_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_ida_make_jac_arg(session, t, coef, y, yp, res, args[0]);
     args[1] = MAT_BACKLINK(jac);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
-    CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
+    int rc = CHECK_EXCEPTION(session, r, RECOVERABLE);
+    if (rc == 0) sunml_jac_cache_save(IDA_ARGCACHE_FROM_ML(session), jac);
+    CAMLreturnT(int, rc);
 }
 
 #else
@@ -286,12 +311,14 @@ static int jacfn (long int neq,
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_ida_make_jac_arg (t, coef, y, yp, res,
-				sunml_ida_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_ida_make_jac_arg(session, t, coef, y, yp, res, args[0]);
     args[1] = Some_val(dmat);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -324,12 +351,14 @@ static int bandjacfn (long int neq,
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_ida_make_jac_arg (t, coef, y, yp, res,
-				sunml_ida_make_triple_tmp (tmp1, tmp2, tmp3));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1, tmp2, tmp3);
+    args[0] = sunml_ida_make_jac_arg(session, t, coef, y, yp, res, args[0]);
     args[1] = Some_val(bmat);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
@@ -342,19 +371,20 @@ static int rootsfn (realtype t, N_Vector y, N_Vector yp,
     CAMLparam0 ();
     CAMLlocal1 (session);
     CAMLlocalN (args, 4);
-    intnat nroots;
 
     WEAK_DEREF (session, *(value*)user_data);
 
-    nroots = IDA_NROOTS_FROM_ML (session);
-
     args[0] = caml_copy_double (t);
     args[1] = NVEC_BACKLINK (y);
     args[2] = NVEC_BACKLINK (yp);
-    args[3] = caml_ba_alloc (BIGARRAY_FLOAT, 1, gout, &nroots);
+    args[3] = sunml_argcache_realarray (IDA_ARGCACHE_FROM_ML (session),
+					IDA_ARGCACHE_GOUT, gout,
+					IDA_NROOTS_FROM_ML (session));
 
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (IDA_ROOTSFN_FROM_ML (session), 4, args);
+    sunml_argcache_release_realarray (IDA_ARGCACHE_FROM_ML (session),
+				      IDA_ARGCACHE_GOUT, args[3]);
 
     CAMLreturnT (int, CHECK_EXCEPTION (session, r, UNRECOVERABLE));
 }
@@ -403,10 +433,12 @@ static int precsetupfn(realtype t,
     cb = Field (cb, RECORD_IDA_SPILS_PRECFNS_PREC_SETUP_FN);
     cb = Field (cb, 0);
 
-    arg = sunml_ida_make_jac_arg(t, cj, y, yp, res, Val_unit);
+    arg = sunml_ida_make_jac_arg(session, t, cj, y, yp, res, Val_unit);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn (cb, arg);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SETUP);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -431,22 +463,57 @@ static int precsolvefn(
     CAMLlocalN(args, 4);
     CAMLlocal2(session, cb);
 
-    args[0] = sunml_ida_make_jac_arg(t, cj, y, yp, res, Val_unit);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_ida_make_jac_arg(session, t, cj, y, yp, res, Val_unit);
     args[1] = NVEC_BACKLINK (rvec);
     args[2] = NVEC_BACKLINK (z);
     args[3] = caml_copy_double (delta);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_IDA_SPILS_PRECFNS_PREC_SOLVE_FN);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (cb, 4, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
 
     CAMLreturnT (int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
+/* Native preconditioners (Ida.Spils.Native): the setup function is the
+   OCaml one (see precsetupfn), but the solve stays in C. */
+static int native_precsolvefn(
+	realtype t,
+	N_Vector y,
+	N_Vector yp,
+	N_Vector res,
+	N_Vector rvec,
+	N_Vector z,
+	realtype cj,
+	realtype delta,
+	void *user_data
+#if SUNDIALS_LIB_VERSION < 300
+	,
+	N_Vector tmp
+#endif
+	)
+{
+    CAMLparam0();
+    CAMLlocal2(session, cb);
+
+    WEAK_DEREF (session, *(value*)user_data);
+
+    cb = IDA_LS_PRECFNS_FROM_ML (session);
+
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
+    int r = sunml_lsolver_native_prec_solve(Field(cb, 1), rvec, z);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
+
+    CAMLreturnT(int, r);
+}
+
 static int jactimesfn(
     realtype t,
     N_Vector y,
@@ -462,18 +529,21 @@ static int jactimesfn(
     CAMLlocalN(args, 3);
     CAMLlocal2(session, cb);
 
-    args[0] = sunml_ida_make_jac_arg (t, cj, y, yp, res,
-				sunml_ida_make_double_tmp (tmp1, tmp2));
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_ida_make_double_tmp(session, tmp1, tmp2);
+    args[0] = sunml_ida_make_jac_arg(session, t, cj, y, yp, res, args[0]);
     args[1] = NVEC_BACKLINK (v);
     args[2] = NVEC_BACKLINK (Jv);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_CALLBACKS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT (int, CHECK_EXCEPTION (session, r, UNRECOVERABLE));
 }
@@ -489,15 +559,18 @@ static int jacsetupfn(realtype t,
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_ida_make_jac_arg(t, cj, y, yp, res, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_ida_make_jac_arg(session, t, cj, y, yp, res, Val_unit);
+
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 1);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback_exn(cb, arg);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -643,6 +716,21 @@ CAMLprim value sunml_ida_spils_set_linear_solver (value vida_mem, value vlsolv)
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_ida_set_native_preconditioner (value vsession)
+{
+    CAMLparam1 (vsession);
+    void *mem = IDA_MEM_FROM_ML (vsession);
+#if 400 <= SUNDIALS_LIB_VERSION
+    int flag = IDASetPreconditioner (mem, precsetupfn, native_precsolvefn);
+    CHECK_LS_FLAG ("IDASetPreconditioner", flag);
+#else
+    int flag = IDASpilsSetPreconditioner (mem, precsetupfn,
+					  native_precsolvefn);
+    CHECK_SPILS_FLAG ("IDASpilsSetPreconditioner", flag);
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_ida_set_preconditioner (value vsession,
 					     value vset_presetup)
 {
@@ -775,10 +863,12 @@ CAMLprim value sunml_ida_root_init (value vida_mem, value vnroots)
  * initialization fails the GC frees IDAMem and the weak global root.  Doing
  * that cleanup in C would be ugly, e.g. we wouldn't be able to reuse
  * c_ida_set_linear_solver() so we have to duplicate it or hack some ad-hoc
- * extensions to that function.  */
-CAMLprim value sunml_ida_init (value weakref, value vt0, value vy, value vyp)
+ * extensions to that function.  If vcfun is Some f, the residual is the
+ * native function f rather than the OCaml closure in the session.  */
+CAMLprim value sunml_ida_init (value weakref, value vt0, value vy, value vyp,
+			       value vcfun)
 {
-    CAMLparam4 (weakref, vy, vyp, vt0);
+    CAMLparam5 (weakref, vy, vyp, vt0, vcfun);
     CAMLlocal2 (r, vida_mem);
     int flag;
     N_Vector y, yp;
@@ -794,17 +884,21 @@ CAMLprim value sunml_ida_init (value weakref, value vt0, value vy, value vyp)
 
     y = NVEC_VAL (vy);
     yp = NVEC_VAL (vyp);
-    flag = IDAInit (ida_mem, resfn, Double_val (vt0), y, yp);
+    flag = IDAInit (ida_mem, (vcfun == Val_none) ? resfn : native_resfn,
+		    Double_val (vt0), y, yp);
     if (flag != IDA_SUCCESS) {
 	IDAFree (&ida_mem);
 	CHECK_FLAG ("IDAInit", flag);
     }
 
-    backref = sunml_sundials_malloc_value(weakref);
+    backref = sunml_sundials_malloc_value_ext(weakref, sizeof(struct ida_cdata));
     if (backref == NULL) {
 	IDAFree (&ida_mem);
 	caml_failwith ("Out of memory");
     }
+    if (vcfun != Val_none)
+	IDA_CDATA(backref)->resfn = *CFUN_VAL(Some_val(vcfun));
+    IDA_CDATA(backref)->neq = sunml_nvec_data_length(y);
     IDASetUserData (ida_mem, backref);
 
     r = caml_alloc_tuple(2);
@@ -841,49 +935,103 @@ CAMLprim value sunml_ida_reinit(value vdata, value t0, value y0, value yp0)
     CAMLreturn (Val_unit);
 }
 
-static value solve (value vdata, value nextt, value vy, value vyp, int onestep)
+/* Translate the return value of IDASolve into a solver_result, propagating
+   any exception recorded by a callback or raised for the flag.  Must be
+   called immediately after IDASolve, before anything else is allocated.  */
+static enum ida_solver_result_tag solver_result (value vdata, int flag)
 {
-    CAMLparam4 (vdata, nextt, vy, vyp);
-    CAMLlocal1 (ret);
-    void *ida_mem = IDA_MEM_FROM_ML (vdata);
-    realtype tret;
-    int flag;
-    N_Vector y, yp;
-    enum ida_solver_result_tag result = -1;
-
-    y = NVEC_VAL (vy);
-    yp = NVEC_VAL (vyp);
-    flag = IDASolve (ida_mem, Double_val (nextt), &tret, y, yp,
-	             onestep ? IDA_ONE_STEP : IDA_NORMAL);
+    value exn;
 
     switch (flag) {
     case IDA_SUCCESS:
-	result = VARIANT_IDA_SOLVER_RESULT_SUCCESS;
-	break;
+	return VARIANT_IDA_SOLVER_RESULT_SUCCESS;
 
     case IDA_ROOT_RETURN:
-	result = VARIANT_IDA_SOLVER_RESULT_ROOTSFOUND;
-	break;
+	return VARIANT_IDA_SOLVER_RESULT_ROOTSFOUND;
 
     case IDA_TSTOP_RETURN:
-	result = VARIANT_IDA_SOLVER_RESULT_STOPTIMEREACHED;
-	break;
+	return VARIANT_IDA_SOLVER_RESULT_STOPTIMEREACHED;
 
     default:
 	/* If an exception was recorded, propagate it.  This accounts for
 	 * almost all failures except for repeated recoverable failures in the
 	 * residue function.  */
-	ret = Field (vdata, RECORD_IDA_SESSION_EXN_TEMP);
-	if (Is_block (ret)) {
+	exn = Field (vdata, RECORD_IDA_SESSION_EXN_TEMP);
+	if (Is_block (exn)) {
 	    Store_field (vdata, RECORD_IDA_SESSION_EXN_TEMP, Val_none);
 	    /* In bytecode, caml_raise() duplicates some parts of the
 	     * stacktrace.  This does not seem to happen in native code
 	     * execution.  */
-	    caml_raise (Field (ret, 0));
+	    caml_raise (Field (exn, 0));
 	}
-	sunml_ida_check_flag("IDASolve", flag, ida_mem);
+	sunml_ida_check_flag("IDASolve", flag, IDA_MEM_FROM_ML (vdata));
     }
 
+    return -1;
+}
+
+/* Sample the step size and the main counters after a call to IDASolve,
+   and mark root returns, if the session is traced (see Sundials.Trace).
+   Does not allocate in the OCaml heap.  */
+static void trace_stats(struct sunml_profile *prof, void *ida_mem, int flag)
+{
+    realtype h;
+    long int n;
+
+    if (!sunml_trace_enabled(prof)) return;
+
+    if (IDAGetLastStep(ida_mem, &h) == IDA_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEP_SIZE, h);
+    if (IDAGetNumSteps(ida_mem, &n) == IDA_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_STEPS, n);
+    if (IDAGetNumErrTestFails(ida_mem, &n) == IDA_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_ERR_TEST_FAILS, n);
+    if (IDAGetNumNonlinSolvIters(ida_mem, &n) == IDA_SUCCESS)
+	sunml_trace_counter(prof, SUNML_TRACE_NONLIN_ITERS, n);
+    if (flag == IDA_ROOT_RETURN)
+	sunml_trace_roots(prof);
+}
+
+/* Append the solution to the recording of the session, if any, after a
+   successful call to IDASolve (see Sundials.Recorder).  Does not allocate
+   in the OCaml heap.  */
+static void record(value vdata, realtype t, value vy, int flag)
+{
+    struct sunml_recorder *rec;
+    realtype h = 0.0;
+    int q = 0;
+
+    if (flag < 0) return;
+    rec = sunml_recorder_of(IDA_ARGCACHE_FROM_ML(vdata));
+    if (rec == NULL) return;
+
+    if (sunml_recorder_steps(rec)) {
+	IDAGetLastStep(IDA_MEM_FROM_ML(vdata), &h);
+	IDAGetLastOrder(IDA_MEM_FROM_ML(vdata), &q);
+    }
+    sunml_recorder_append(rec, t, Field(vy, 0), h, q);
+}
+
+static value solve (value vdata, value nextt, value vy, value vyp, int onestep)
+{
+    CAMLparam4 (vdata, nextt, vy, vyp);
+    CAMLlocal1 (ret);
+    void *ida_mem = IDA_MEM_FROM_ML (vdata);
+    realtype tret;
+    int flag;
+    N_Vector y, yp;
+    enum ida_solver_result_tag result;
+
+    y = NVEC_VAL (vy);
+    yp = NVEC_VAL (vyp);
+    SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(vdata));
+    flag = IDASolve (ida_mem, Double_val (nextt), &tret, y, yp,
+	             onestep ? IDA_ONE_STEP : IDA_NORMAL);
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    trace_stats(sunml_profile, ida_mem, flag);
+    record(vdata, tret, vy, flag);
+    result = solver_result (vdata, flag);
+
     assert (Field (vdata, RECORD_IDA_SESSION_EXN_TEMP) == Val_none);
 
     ret = caml_alloc_tuple (2);
@@ -908,6 +1056,45 @@ CAMLprim value sunml_ida_solve_one_step (value vdata, value nextt,
     CAMLreturn(solve(vdata, nextt, y, yp, 1));
 }
 
+/* Integrate to each of the times in vts in turn, storing the solution in
+   successive columns of vyout.  Stops early when a root or the stop time is
+   reached.  The sizes are checked in OCaml.  */
+CAMLprim value sunml_ida_solve_schedule (value vdata, value vts, value vy,
+					 value vyp, value vyout)
+{
+    CAMLparam5 (vdata, vts, vy, vyp, vyout);
+    CAMLlocal1 (ret);
+    void *ida_mem = IDA_MEM_FROM_ML (vdata);
+    N_Vector y = NVEC_VAL (vy);
+    N_Vector yp = NVEC_VAL (vyp);
+    realtype *ts = REAL_ARRAY (vts);
+    intnat i = 0, nt = ARRAY1_LEN (vts);
+    realtype tret = ts[0];
+    enum ida_solver_result_tag result = VARIANT_IDA_SOLVER_RESULT_SUCCESS;
+
+    while (i < nt) {
+	SUNML_PROFILE_BEGIN(IDA_ARGCACHE_FROM_ML(vdata));
+	int flag = IDASolve (ida_mem, ts[i], &tret, y, yp, IDA_NORMAL);
+	SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+	trace_stats(sunml_profile, ida_mem, flag);
+	record(vdata, tret, vy, flag);
+	result = solver_result (vdata, flag);
+
+	if (result == VARIANT_IDA_SOLVER_RESULT_SUCCESS || tret == ts[i])
+	    sunml_realarray2_set_col (vyout, i++, Field (vy, 0));
+	if (result != VARIANT_IDA_SOLVER_RESULT_SUCCESS) break;
+    }
+
+    assert (Field (vdata, RECORD_IDA_SESSION_EXN_TEMP) == Val_none);
+
+    ret = caml_alloc_tuple (3);
+    Store_field (ret, 0, Val_long (i));
+    Store_field (ret, 1, caml_copy_double (tret));
+    Store_field (ret, 2, Val_int (result));
+
+    CAMLreturn (ret);
+}
+
 CAMLprim value sunml_ida_get_dky(value vdata, value vt, value vk, value vy)
 {
     CAMLparam4(vdata, vt, vk, vy);
@@ -921,6 +1108,273 @@ CAMLprim value sunml_ida_get_dky(value vdata, value vt, value vk, value vy)
     CAMLreturn (Val_unit);
 }
 
+/* Evaluate the interpolant at each of the times in vts, using vy as
+   workspace, and store the results in successive columns of vdkys.
+   The sizes are checked in OCaml.  */
+CAMLprim value sunml_ida_get_dky_many(value vdata, value vts, value vk,
+				      value vy, value vdkys)
+{
+    CAMLparam5(vdata, vts, vk, vy, vdkys);
+
+    void *ida_mem = IDA_MEM_FROM_ML(vdata);
+    N_Vector y_nv = NVEC_VAL(vy);
+    realtype *ts = REAL_ARRAY(vts);
+    intnat i, nt = ARRAY1_LEN(vts);
+
+    for (i = 0; i < nt; ++i) {
+	int flag = IDAGetDky(ida_mem, ts[i], Int_val(vk), y_nv);
+	CHECK_FLAG("IDAGetDky", flag);
+	sunml_realarray2_set_col(vdkys, i, Field(vy, 0));
+    }
+
+    CAMLreturn (Val_unit);
+}
+
+/* Snapshots of the integrator state.
+
+   As for Cvode (see sunml_cvode_snapshot), a snapshot is a copy of the
+   solver memory together with copies of the history array (phi), of the
+   last error vector (ee), of the error weights, and of the rootfinding
+   state, and restoring it fails if the optional inputs have been changed
+   in between.  The linear solver data is not part of it.  The IDA linear
+   solvers reevaluate the Jacobian (or the preconditioner) at every setup,
+   so it suffices to force one at the next step: cjold, the cj of the last
+   setup, is given the opposite sign of cj on restoration, so that their
+   ratio is out of range.
+
+   The solver memory is only accessible through the headers that Sundials
+   installs before 4.1.0.  */
+
+#if SUNDIALS_LIB_VERSION < 410
+struct ida_snapshot {
+    struct IDAMemRec mem;
+    N_Vector phi[MXORDP1];
+    N_Vector ee;
+    N_Vector ewt;
+    N_Vector vatol;		/* if mem.ida_itol == IDA_SV */
+    N_Vector id;		/* if mem.ida_id != NULL */
+    N_Vector constraints;	/* if mem.ida_constraintsSet */
+    N_Vector tmp;
+
+    /* The rootfinding arrays: glo, ghi, and grout in groots, iroots and
+       rootdir in iroots, and gactive; nrtfn elements each.  */
+    realtype *groots;
+    int *iroots;
+    booleantype *gactive;
+};
+
+#define IDA_SNAPSHOT(v) (*(struct ida_snapshot **)Data_custom_val(v))
+
+static void free_ida_snapshot(struct ida_snapshot *snap)
+{
+    int j;
+
+    if (snap == NULL) return;
+    for (j = 0; j < MXORDP1; ++j)
+	if (snap->phi[j] != NULL) N_VDestroy(snap->phi[j]);
+    if (snap->ee != NULL) N_VDestroy(snap->ee);
+    if (snap->ewt != NULL) N_VDestroy(snap->ewt);
+    if (snap->vatol != NULL) N_VDestroy(snap->vatol);
+    if (snap->id != NULL) N_VDestroy(snap->id);
+    if (snap->constraints != NULL) N_VDestroy(snap->constraints);
+    if (snap->tmp != NULL) N_VDestroy(snap->tmp);
+    free(snap->groots);
+    free(snap->iroots);
+    free(snap->gactive);
+    free(snap);
+}
+
+static void finalize_ida_snapshot(value vsnap)
+{
+    free_ida_snapshot(IDA_SNAPSHOT(vsnap));
+}
+
+static N_Vector snapshot_copy(N_Vector v)
+{
+    N_Vector c = N_VClone(v);
+    if (c == NULL) caml_raise_out_of_memory();
+    N_VScale(1.0, v, c);
+    return c;
+}
+
+static int snapshot_same_vector(N_Vector v, N_Vector saved, N_Vector tmp)
+{
+    N_VLinearSum(1.0, v, -1.0, saved, tmp);
+    return (N_VMaxNorm(tmp) == 0.0);
+}
+
+static int ida_snapshot_matches(IDAMem ida_mem, struct ida_snapshot *snap)
+{
+    int j;
+
+    if (ida_mem->ida_lmem != snap->mem.ida_lmem
+	    || ida_mem->ida_ee != snap->mem.ida_ee
+	    || ida_mem->ida_ewt != snap->mem.ida_ewt
+	    || ida_mem->ida_glo != snap->mem.ida_glo
+	    || ida_mem->ida_nrtfn != snap->mem.ida_nrtfn
+	    || ida_mem->ida_maxord != snap->mem.ida_maxord
+	    || ida_mem->ida_id != snap->mem.ida_id
+	    || ida_mem->ida_constraints != snap->mem.ida_constraints)
+	return 0;
+#if 400 <= SUNDIALS_LIB_VERSION
+    if (ida_mem->NLS != snap->mem.NLS) return 0;
+#endif
+    for (j = 0; j <= snap->mem.ida_maxord; ++j)
+	if (ida_mem->ida_phi[j] != snap->mem.ida_phi[j]) return 0;
+    return 1;
+}
+
+/* The optional inputs that are held in the solver memory.  Those of the
+   linear solver are held in its own memory and are not affected by
+   restoring a snapshot.  */
+static int ida_snapshot_same_options(IDAMem ida_mem,
+				     struct ida_snapshot *snap)
+{
+    IDAMem old = &snap->mem;
+    int i;
+
+    if (ida_mem->ida_res != old->ida_res
+	    || ida_mem->ida_itol != old->ida_itol
+	    || ida_mem->ida_rtol != old->ida_rtol
+	    || ida_mem->ida_Satol != old->ida_Satol
+	    || ida_mem->ida_user_efun != old->ida_user_efun
+	    || ida_mem->ida_efun != old->ida_efun
+	    || ida_mem->ida_edata != old->ida_edata
+	    || ida_mem->ida_mxstep != old->ida_mxstep
+	    || ida_mem->ida_hin != old->ida_hin
+	    || ida_mem->ida_hmax_inv != old->ida_hmax_inv
+	    || ida_mem->ida_suppressalg != old->ida_suppressalg
+	    || ida_mem->ida_constraintsSet != old->ida_constraintsSet
+	    || ida_mem->ida_maxnef != old->ida_maxnef
+	    || ida_mem->ida_maxncf != old->ida_maxncf
+	    || ida_mem->ida_epcon != old->ida_epcon
+	    || ida_mem->ida_gfun != old->ida_gfun
+	    || ida_mem->ida_mxgnull != old->ida_mxgnull)
+	return 0;
+#if SUNDIALS_LIB_VERSION < 400
+    if (ida_mem->ida_maxcor != old->ida_maxcor) return 0;
+#endif
+
+    /* The solver clears the stop time once it is reached, so only a stop
+       time set since the snapshot is a change.  */
+    if (ida_mem->ida_tstopset
+	    && (!old->ida_tstopset || ida_mem->ida_tstop != old->ida_tstop))
+	return 0;
+
+    if ((ida_mem->ida_itol == IDA_SV
+	    && !snapshot_same_vector(ida_mem->ida_Vatol, snap->vatol, snap->tmp))
+	|| (ida_mem->ida_id != NULL
+	    && !snapshot_same_vector(ida_mem->ida_id, snap->id, snap->tmp))
+	|| (ida_mem->ida_constraintsSet
+	    && !snapshot_same_vector(ida_mem->ida_constraints,
+				     snap->constraints, snap->tmp)))
+	return 0;
+
+    for (i = 0; i < ida_mem->ida_nrtfn; ++i)
+	if (ida_mem->ida_rootdir[i] != snap->iroots[ida_mem->ida_nrtfn + i])
+	    return 0;
+
+    return 1;
+}
+#endif
+
+CAMLprim value sunml_ida_snapshot(value vdata)
+{
+    CAMLparam1(vdata);
+    CAMLlocal1(vsnap);
+#if SUNDIALS_LIB_VERSION < 410
+    IDAMem ida_mem = (IDAMem)IDA_MEM_FROM_ML(vdata);
+    struct ida_snapshot *snap;
+    int j, nrtfn = ida_mem->ida_nrtfn;
+
+#ifdef SUNDIALSML_WITHSENS
+    if (ida_mem->ida_quadr || ida_mem->ida_sensi || ida_mem->ida_adj)
+	caml_invalid_argument("snapshot: quadratures, sensitivities, or "
+			      "adjoint problems are active");
+#endif
+
+    snap = calloc(1, sizeof(struct ida_snapshot));
+    if (snap == NULL) caml_raise_out_of_memory();
+    vsnap = caml_alloc_final(1, &finalize_ida_snapshot, 1, 20);
+    IDA_SNAPSHOT(vsnap) = snap;
+
+    for (j = 0; j <= ida_mem->ida_maxord; ++j)
+	snap->phi[j] = snapshot_copy(ida_mem->ida_phi[j]);
+    snap->ee = snapshot_copy(ida_mem->ida_ee);
+    snap->ewt = snapshot_copy(ida_mem->ida_ewt);
+    snap->tmp = snapshot_copy(ida_mem->ida_ewt);
+    if (ida_mem->ida_itol == IDA_SV)
+	snap->vatol = snapshot_copy(ida_mem->ida_Vatol);
+    if (ida_mem->ida_id != NULL)
+	snap->id = snapshot_copy(ida_mem->ida_id);
+    if (ida_mem->ida_constraintsSet)
+	snap->constraints = snapshot_copy(ida_mem->ida_constraints);
+
+    if (nrtfn > 0) {
+	snap->groots = malloc(3 * nrtfn * sizeof(realtype));
+	snap->iroots = malloc(2 * nrtfn * sizeof(int));
+	snap->gactive = malloc(nrtfn * sizeof(booleantype));
+	if (snap->groots == NULL || snap->iroots == NULL
+		|| snap->gactive == NULL)
+	    caml_raise_out_of_memory();
+	memcpy(snap->groots, ida_mem->ida_glo, nrtfn * sizeof(realtype));
+	memcpy(snap->groots + nrtfn, ida_mem->ida_ghi,
+	       nrtfn * sizeof(realtype));
+	memcpy(snap->groots + 2 * nrtfn, ida_mem->ida_grout,
+	       nrtfn * sizeof(realtype));
+	memcpy(snap->iroots, ida_mem->ida_iroots, nrtfn * sizeof(int));
+	memcpy(snap->iroots + nrtfn, ida_mem->ida_rootdir, nrtfn * sizeof(int));
+	memcpy(snap->gactive, ida_mem->ida_gactive,
+	       nrtfn * sizeof(booleantype));
+    }
+
+    snap->mem = *ida_mem;
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (vsnap);
+}
+
+CAMLprim value sunml_ida_restore(value vdata, value vsnap)
+{
+    CAMLparam2(vdata, vsnap);
+#if SUNDIALS_LIB_VERSION < 410
+    IDAMem ida_mem = (IDAMem)IDA_MEM_FROM_ML(vdata);
+    struct ida_snapshot *snap = IDA_SNAPSHOT(vsnap);
+    int j, nrtfn = snap->mem.ida_nrtfn;
+
+    if (!ida_snapshot_matches(ida_mem, snap))
+	caml_invalid_argument("restore: the session has been reconfigured");
+    if (!ida_snapshot_same_options(ida_mem, snap))
+	caml_invalid_argument("restore: optional inputs have been changed");
+
+    *ida_mem = snap->mem;
+    for (j = 0; j <= ida_mem->ida_maxord; ++j)
+	N_VScale(1.0, snap->phi[j], ida_mem->ida_phi[j]);
+    N_VScale(1.0, snap->ee, ida_mem->ida_ee);
+    N_VScale(1.0, snap->ewt, ida_mem->ida_ewt);
+
+    if (nrtfn > 0) {
+	memcpy(ida_mem->ida_glo, snap->groots, nrtfn * sizeof(realtype));
+	memcpy(ida_mem->ida_ghi, snap->groots + nrtfn,
+	       nrtfn * sizeof(realtype));
+	memcpy(ida_mem->ida_grout, snap->groots + 2 * nrtfn,
+	       nrtfn * sizeof(realtype));
+	memcpy(ida_mem->ida_iroots, snap->iroots, nrtfn * sizeof(int));
+	memcpy(ida_mem->ida_gactive, snap->gactive,
+	       nrtfn * sizeof(booleantype));
+    }
+
+    /* force a linear solver setup at the next step; before the first step,
+       cj is not yet set, but the initial cjold already forces one */
+    if (ida_mem->ida_nst > 0)
+	ida_mem->ida_cjold = -ida_mem->ida_cj;
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_ida_get_err_weights(value vida_mem, value verrws)
 {
     CAMLparam2(vida_mem, verrws);
@@ -1051,7 +1505,7 @@ value sunml_ida_last_lin_exception(void *ida_mem)
 
 void sunml_ida_check_flag(const char *call, int flag, void *ida_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == IDA_SUCCESS
 	|| flag == IDA_ROOT_RETURN
@@ -1134,7 +1588,7 @@ void sunml_ida_check_flag(const char *call, int flag, void *ida_mem)
 #if 400 <= SUNDIALS_LIB_VERSION
 void sunml_ida_check_ls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == IDALS_SUCCESS) return;
 
@@ -1159,7 +1613,7 @@ void sunml_ida_check_ls_flag(const char *call, int flag)
 #else
 void sunml_ida_check_dls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == IDADLS_SUCCESS) return;
 
@@ -1185,7 +1639,7 @@ void sunml_ida_check_dls_flag(const char *call, int flag)
 
 void sunml_ida_check_spils_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == IDASPILS_SUCCESS) return;
 
@@ -1213,7 +1667,12 @@ CAMLprim value sunml_ida_session_finalize(value vdata)
     if (IDA_MEM_FROM_ML(vdata) != NULL) {
 	void *ida_mem = IDA_MEM_FROM_ML(vdata);
 	value *backref = IDA_BACKREF_FROM_ML(vdata);
+	struct ida_cdata *cdata = IDA_CDATA(backref);
 	IDAFree(&ida_mem);
+	if (cdata->sens_tmps != NULL)
+	    N_VDestroyVectorArray(cdata->sens_tmps,
+				  3 * (cdata->sens_nthreads - 1));
+	sunml_quadforms_free(&cdata->quadforms);
 	sunml_sundials_free_value(backref);
     }
 
@@ -1367,6 +1826,17 @@ CAMLprim value sunml_ida_get_num_steps(value vida_mem)
     CAMLreturn(Val_long(v));
 }
 
+/* The _unboxed and _untagged variants of the getters are the entry
+ * points of their [@@noalloc] externals in native code (see ida.ml).
+ * They ignore the returned flag: the only possible failure is a NULL
+ * memory pointer, which cannot occur for a live session.  */
+CAMLprim intnat sunml_ida_get_num_steps_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumSteps(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_num_res_evals(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1380,6 +1850,13 @@ CAMLprim value sunml_ida_get_num_res_evals(value vida_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_ida_get_num_res_evals_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumResEvals(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_num_lin_solv_setups(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1393,6 +1870,13 @@ CAMLprim value sunml_ida_get_num_lin_solv_setups(value vida_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_ida_get_num_lin_solv_setups_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumLinSolvSetups(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_num_err_test_fails(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1406,6 +1890,13 @@ CAMLprim value sunml_ida_get_num_err_test_fails(value vida_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_ida_get_num_err_test_fails_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumErrTestFails(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_last_order(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1419,6 +1910,13 @@ CAMLprim value sunml_ida_get_last_order(value vida_mem)
     CAMLreturn(Val_int(v));
 }
 
+CAMLprim intnat sunml_ida_get_last_order_untagged(value vida_mem)
+{
+    int v = 0;
+    IDAGetLastOrder(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_current_order(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1432,6 +1930,13 @@ CAMLprim value sunml_ida_get_current_order(value vida_mem)
     CAMLreturn(Val_int(v));
 }
 
+CAMLprim intnat sunml_ida_get_current_order_untagged(value vida_mem)
+{
+    int v = 0;
+    IDAGetCurrentOrder(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_actual_init_step(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1445,6 +1950,13 @@ CAMLprim value sunml_ida_get_actual_init_step(value vida_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_ida_get_actual_init_step_unboxed(value vida_mem)
+{
+    realtype v = 0.0;
+    IDAGetActualInitStep(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_last_step(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1460,6 +1972,13 @@ CAMLprim value sunml_ida_get_last_step(value vida_mem)
     CAMLreturn(tmp);
 }
 
+CAMLprim double sunml_ida_get_last_step_unboxed(value vida_mem)
+{
+    realtype v = 0.0;
+    IDAGetLastStep(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_current_step(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1473,6 +1992,13 @@ CAMLprim value sunml_ida_get_current_step(value vida_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_ida_get_current_step_unboxed(value vida_mem)
+{
+    realtype v = 0.0;
+    IDAGetCurrentStep(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_current_time(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1486,6 +2012,13 @@ CAMLprim value sunml_ida_get_current_time(value vida_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_ida_get_current_time_unboxed(value vida_mem)
+{
+    realtype v = 0.0;
+    IDAGetCurrentTime(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_set_nonlin_conv_coef_ic(value vida_mem, value vcoef)
 {
     CAMLparam2(vida_mem, vcoef);
@@ -1783,6 +2316,13 @@ CAMLprim value sunml_ida_get_tol_scale_factor(value vida_mem)
     CAMLreturn(caml_copy_double(r));
 }
 
+CAMLprim double sunml_ida_get_tol_scale_factor_unboxed(value vida_mem)
+{
+    realtype v = 0.0;
+    IDAGetTolScaleFactor(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_num_nonlin_solv_iters(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1794,6 +2334,13 @@ CAMLprim value sunml_ida_get_num_nonlin_solv_iters(value vida_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_ida_get_num_nonlin_solv_iters_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumNonlinSolvIters(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_num_nonlin_solv_conv_fails(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1805,6 +2352,13 @@ CAMLprim value sunml_ida_get_num_nonlin_solv_conv_fails(value vida_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_ida_get_num_nonlin_solv_conv_fails_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumNonlinSolvConvFails(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_ida_get_nonlin_solv_stats(value vida_mem)
 {
     CAMLparam1(vida_mem);
@@ -1833,6 +2387,13 @@ CAMLprim value sunml_ida_get_num_g_evals(value vida_mem)
     CAMLreturn(Val_long(r));
 }
 
+CAMLprim intnat sunml_ida_get_num_g_evals_untagged(value vida_mem)
+{
+    long int v = 0;
+    IDAGetNumGEvals(IDA_MEM_FROM_ML(vida_mem), &v);
+    return v;
+}
+
 
 CAMLprim value sunml_ida_dls_get_work_space(value vida_mem)
 {
@@ -28,10 +28,11 @@ void sunml_ida_check_dls_flag(const char *call, int flag);
 void sunml_ida_check_spils_flag(const char *call, int flag);
 #endif
 
-value sunml_ida_make_jac_arg(realtype t, realtype coef, N_Vector y, N_Vector yp,
-		       N_Vector res, value tmp);
-value sunml_ida_make_triple_tmp(N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
-value sunml_ida_make_double_tmp(N_Vector tmp1, N_Vector tmp2);
+value sunml_ida_make_jac_arg(value session, realtype t, realtype coef,
+			     N_Vector y, N_Vector yp, N_Vector res, value tmp);
+value sunml_ida_make_triple_tmp(value session, N_Vector tmp1,
+				N_Vector tmp2, N_Vector tmp3);
+value sunml_ida_make_double_tmp(value session, N_Vector tmp1, N_Vector tmp2);
 
 value sunml_ida_last_lin_exception(void *ida_mem);
 
@@ -76,6 +77,7 @@ enum ida_index {
     RECORD_IDA_SESSION_NROOTS,
     RECORD_IDA_SESSION_CHECKVEC,
     RECORD_IDA_SESSION_EXN_TEMP,
+    RECORD_IDA_SESSION_ARGCACHE,
     RECORD_IDA_SESSION_ID_SET,
     RECORD_IDA_SESSION_RESFN,
     RECORD_IDA_SESSION_ROOTSFN,
@@ -103,6 +105,44 @@ enum ida_index {
 #define IDA_LS_PRECFNS_FROM_ML(v)     (Field((v), RECORD_IDA_SESSION_LS_PRECFNS))
 #define IDA_SENSEXT_FROM_ML(v)     (Field(Field((v), RECORD_IDA_SESSION_SENSEXT), 0))
 
+/* Purely C-side session data.  It is stored just after the global root, in
+ * the space reserved by sunml_sundials_malloc_value_ext, so that it can be
+ * reached from ida_user_data without passing through the OCaml heap.  */
+struct ida_cdata {
+    struct sunml_cfun resfn;	/* native residual function (fn == NULL if not) */
+
+    /* The length of the state vector, or -1 if its data is not contiguous
+       (see sunml_nvec_data_length).  */
+    intnat neq;
+
+    /* Idas: native sensitivity residual, evaluated for several parameters
+       concurrently by sens_nthreads threads, which need
+       3 * (sens_nthreads - 1) temporary vectors besides those provided by
+       Sundials (see sunml_idas_sens_init_cfun).  */
+    struct sunml_cfun sensresfn1;
+    int sens_nthreads;
+    N_Vector *sens_tmps;
+
+    /* Idas: quadrature right-hand side given by linear and quadratic forms
+       (see sunml_idas_quad_init_forms).  */
+    struct sunml_quadforms quadforms;
+};
+
+#define IDA_CDATA(backref) ((struct ida_cdata *)SUNML_HEAPREF_EXT(backref))
+#define IDA_CDATA_FROM_ML(v) IDA_CDATA(IDA_BACKREF_FROM_ML(v))
+
+#define IDA_ARGCACHE_FROM_ML(v) Field((v), RECORD_IDA_SESSION_ARGCACHE)
+
+/* Slots of the callback argument cache (see sunml_argcache_block).
+   Idas numbers its own slots from IDA_ARGCACHE_SIZE.  */
+enum ida_argcache_index {
+    IDA_ARGCACHE_GOUT = 0,
+    IDA_ARGCACHE_JAC_ARG,
+    IDA_ARGCACHE_TRIPLE_TMP,
+    IDA_ARGCACHE_DOUBLE_TMP,
+    IDA_ARGCACHE_SIZE
+};
+
 enum ida_spils_precfns_index {
     RECORD_IDA_SPILS_PRECFNS_PREC_SOLVE_FN = 0,
     RECORD_IDA_SPILS_PRECFNS_PREC_SETUP_FN,
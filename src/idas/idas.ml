@@ -84,6 +84,67 @@ module Quadrature = struct (* {{{ *)
     c_quad_init session yQ0;
     s.has_quad <- true
 
+  type form =
+    | Linear of LintArray.t * RealArray.t
+    | Quadratic of LintArray.t * LintArray.t * RealArray.t
+
+  let flatten_forms forms =
+    let nterms = function
+      | Linear (a, w) ->
+          let n = RealArray.length w in
+          if Sundials_configuration.safe && Bigarray.Array1.dim a <> n
+          then invalid_arg "init_forms: array sizes do not match";
+          n
+      | Quadratic (a, b, w) ->
+          let n = RealArray.length w in
+          if Sundials_configuration.safe
+             && (Bigarray.Array1.dim a <> n || Bigarray.Array1.dim b <> n)
+          then invalid_arg "init_forms: array sizes do not match";
+          n
+    in
+    let n = Array.fold_left (fun n f -> n + nterms f) 0 forms in
+    let row = LintArray.create n
+    and ia = LintArray.create n
+    and ib = LintArray.create n
+    and w = RealArray.create n
+    and k = ref 0 in
+    let add i a b wj =
+      if Sundials_configuration.safe && (a < 0 || b < -1)
+      then invalid_arg "init_forms: negative index";
+      row.{!k} <- i; ia.{!k} <- a; ib.{!k} <- b; w.{!k} <- wj;
+      incr k
+    in
+    Array.iteri (fun i f ->
+        match f with
+        | Linear (a, wa) ->
+            for j = 0 to RealArray.length wa - 1 do
+              add i a.{j} (-1) wa.{j}
+            done
+        | Quadratic (a, b, wa) ->
+            for j = 0 to RealArray.length wa - 1 do
+              if Sundials_configuration.safe && b.{j} < 0
+              then invalid_arg "init_forms: negative index";
+              add i a.{j} b.{j} wa.{j}
+            done) forms;
+    (row, ia, ib, w)
+
+  external c_quad_init_forms
+      : ('a, 'k) session
+        -> LintArray.t * LintArray.t * LintArray.t * RealArray.t
+        -> ('a, 'k) Nvector.t -> unit
+      = "sunml_idas_quad_init_forms"
+
+  let init_forms s forms v0 =
+    if Sundials_configuration.safe
+       && Array.length forms <> RealArray.length (Nvector.unwrap v0)
+    then invalid_arg "init_forms: wrong number of forms";
+    let terms = flatten_forms forms in
+    add_fwdsensext s;
+    let se = fwdsensext s in
+    se.checkquadvec <- Nvector.check v0;
+    c_quad_init_forms s terms v0;
+    se.has_quad <- true
+
   external c_reinit : ('a, 'k) session -> ('a, 'k) Nvector.t -> unit
     = "sunml_idas_quad_reinit"
 
@@ -221,6 +282,13 @@ module Sensitivity = struct (* {{{ *)
                          -> ('a, 'k) Nvector.t array -> unit
     = "sunml_idas_sens_init"
 
+  external c_sens_init_cfun : ('a, 'k) session -> sens_method -> int
+                              -> Sundials.cfun
+                              -> ('a, 'k) Nvector.t array
+                              -> ('a, 'k) Nvector.t array -> unit
+    = "sunml_idas_sens_init_cfun_byte"
+      "sunml_idas_sens_init_cfun"
+
   external c_set_params : ('a, 'k) session -> sens_params -> unit
       = "sunml_idas_sens_set_params"
 
@@ -280,7 +348,7 @@ module Sensitivity = struct (* {{{ *)
            else Array.iter check_pi p)
       end
 
-  let init s tol fmethod ?sens_nlsolver ?sens_params ?fs y0 y'0 =
+  let init' s tol fmethod sens_nlsolver sens_params c_init y0 y'0 =
     if Sundials_configuration.safe then
       (Array.iter s.checkvec y0;
        Array.iter s.checkvec y'0);
@@ -293,10 +361,7 @@ module Sensitivity = struct (* {{{ *)
        if ns <> Array.length y'0 then
          invalid_arg "init: y0 and y'0 have inconsistent lengths");
     (match sens_params with None -> () | Some sp -> check_sens_params ns sp);
-    c_sens_init s fmethod (fs <> None) y0 y'0;
-    (match fs with
-     | Some f -> se.sensresfn <- f
-     | None -> ());
+    c_init se;
     se.num_sensitivities <- ns;
     (match sens_params with
      | None -> se.senspvals <- None
@@ -308,6 +373,21 @@ module Sensitivity = struct (* {{{ *)
     if not in_compat_mode2_3
       then set_nonlinear_solver_sens s fmethod sens_nlsolver
 
+  let init s tol fmethod ?sens_nlsolver ?sens_params ?fs y0 y'0 =
+    let c_init se =
+      c_sens_init s fmethod (fs <> None) y0 y'0;
+      (match fs with
+       | Some f -> se.sensresfn <- f
+       | None -> ())
+    in
+    init' s tol fmethod sens_nlsolver sens_params c_init y0 y'0
+
+  let init_cfun s tol fmethod ?sens_nlsolver ?sens_params ?(num_threads=1)
+                f y0 y'0 =
+    if num_threads < 1 then invalid_arg "init_cfun: num_threads";
+    let c_init _ = c_sens_init_cfun s fmethod num_threads f y0 y'0 in
+    init' s tol fmethod sens_nlsolver sens_params c_init y0 y'0
+
   external c_reinit
     : ('a, 'k) session -> sens_method
       -> ('a, 'k) Nvector.t array -> ('a, 'k) Nvector.t array -> unit
@@ -492,6 +572,18 @@ module Sensitivity = struct (* {{{ *)
                   c_quadsens_init s true v0
       | None -> c_quadsens_init s false v0
 
+    external c_quadsens_init_forms
+        : ('a, 'k) session -> ('a, 'k) Nvector.t array -> unit
+        = "sunml_idas_quadsens_init_forms"
+
+    let init_forms s v0 =
+      let se = fwdsensext s in
+      if not se.has_quad then raise Quadrature.QuadNotInitialized;
+      if Sundials_configuration.safe && Array.length v0 <> se.num_sensitivities
+      then invalid_arg "init_forms: wrong number of vectors";
+      if Sundials_configuration.safe then Array.iter se.checkquadvec v0;
+      c_quadsens_init_forms s v0
+
     external c_reinit : ('a, 'k) session -> ('a, 'k) Nvector.t array -> unit
       = "sunml_idas_quadsens_reinit"
 
@@ -1021,7 +1113,7 @@ module Adjoint = struct (* {{{ *)
                 BSlsSuperlumtCallback { jacfn = f; jmat = none }
             | Some (WithSens f) ->
                 BSlsSuperlumtCallbackSens { jacfn_sens = f; jmat = none })
-      | LSI.Custom _ ->
+      | LSI.Custom _ | LSI.BlockDiag ->
           session.ls_callbacks <- (match jac with
             | None ->
                 (match Matrix.get_id mat with
@@ -1419,6 +1511,7 @@ module Adjoint = struct (* {{{ *)
             checkvec     = checkvec;
 
             exn_temp     = None;
+            argcache     = Sundials_impl.make_arg_cache ();
             id_set       = false;
 
             resfn        = dummy_resfn;
@@ -82,6 +82,29 @@ module Quadrature : sig (* {{{ *)
   val init : ('d, 'k) Ida.session
               -> 'd quadrhsfn -> ('d, 'k) Nvector.t -> unit
 
+  (** Quadrature integrands given by linear and quadratic forms over the
+      state variables. For arrays [a], [b], and [w] of the same length,
+      - [Linear (a, w)] denotes {% $\sum_j w_j y_{a_j}$%}, and,
+      - [Quadratic (a, b, w)] denotes {% $\sum_j w_j y_{a_j} y_{b_j}$%}. *)
+  type form =
+    | Linear of LintArray.t * RealArray.t
+    | Quadratic of LintArray.t * LintArray.t * RealArray.t
+
+  (** Activates the integration of quadrature equations whose right-hand
+      sides are given by forms: {% $\dot{y}_{Q,i}$%} is the value of the
+      [i]th element of the array, and the vector gives the initial value of
+      $y_Q$. Such quadratures, e.g., energies or cost functionals, are
+      evaluated in C without calling into OCaml. The forms are copied, and
+      their indices must be valid for the state vector of the session.
+
+      Their sensitivities can be computed by
+      {!Sensitivity.Quadrature.init_forms}.
+
+      @idas <node5#ss:quad_init> IDAQuadInit
+      @raise Invalid_argument The number of forms does not match the length of the vector, an index is negative or not less than the length of the state vector, or the state vector does not have contiguous storage. *)
+  val init_forms :
+    'k Ida.serial_session -> form array -> 'k Nvector_serial.any -> unit
+
   (** Reinitializes the integration of quadrature equations. The vector
       gives a new value for $y_Q$.
 
@@ -348,6 +371,44 @@ module Sensitivity : sig (* {{{ *)
              -> ('d, 'k) Nvector.t array
              -> unit
 
+  (** Like {!init} but the sensitivity residual is a native C function that
+      is evaluated for one parameter at a time, and for several parameters
+      concurrently. The function [f] must have the C type
+      [int f(int ns, realtype t, N_Vector y, N_Vector yp, N_Vector res,
+             int is, N_Vector yS, N_Vector ypS, N_Vector resS, void *data,
+             N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)],
+      and compute the sensitivity residual [resS] of the parameter [is],
+      where [data] is the pointer given to [sunml_sundials_wrap_cfun]
+      (see {!Sundials.cfun}).
+
+      The calls for the different parameters are shared among
+      [num_threads] OpenMP threads (default: [1]). Each call writes only
+      into its own [resS] and receives its own temporary vectors, but the
+      calls share [y], [yp], [res], and [data], which [f] must therefore
+      only read. Like the native residuals of {!Ida.init_cfun}, [f] must
+      not call back into OCaml. The first negative result, if any, and
+      otherwise the greatest one is returned to IDAS. The library must be
+      compiled with OpenMP for the calls to run in parallel.
+
+      @idas <node6#ss:sensi_init> IDASensInit
+      @idas <node6#s:user_fct_fwd> IDASensResFn
+      @raise Invalid_argument The number of threads is not positive.
+      @since 4.0.0 *)
+  val init_cfun : ('d, 'k) Ida.session
+                  -> ('d, 'k) tolerance
+                  -> sens_method
+                  -> ?sens_nlsolver:
+                      (('d, 'k) Sundials_NonlinearSolver.Senswrapper.t, 'k,
+                       (('d, 'k) Ida.session)
+                          Sundials_NonlinearSolver.integrator)
+                                     Sundials_NonlinearSolver.t
+                  -> ?sens_params:sens_params
+                  -> ?num_threads:int
+                  -> Sundials.cfun
+                  -> ('d, 'k) Nvector.t array
+                  -> ('d, 'k) Nvector.t array
+                  -> unit
+
   (** Reinitializes the forward sensitivity computation.
 
       @idas <node6#ss:sensi_init> IDASensReInit *)
@@ -445,6 +506,17 @@ module Sensitivity : sig (* {{{ *)
     val init : ('d, 'k) Ida.session -> ?fqs:'d quadsensrhsfn
                   -> ('d, 'k) Nvector.t array -> unit
 
+    (** Activates the integration of the sensitivities of quadratures
+        initialized with {!Quadrature.init_forms}. Their right-hand sides,
+        the derivatives of the forms, are evaluated in C. The array gives
+        the initial values of the quadrature sensitivities.
+
+        @idas <node6#ss:quad_sens_init> IDAQuadSensInit
+        @raise QuadNotInitialized {!Quadrature.init_forms} has not been called.
+        @raise Invalid_argument The quadratures are not given by forms. *)
+    val init_forms :
+      'k Ida.serial_session -> 'k Nvector_serial.any array -> unit
+
     (** Reinitializes the quadrature sensitivity integration.
 
         @idas <node6#ss:quad_sens_init> IDAQuadSensReInit *)
@@ -844,6 +916,12 @@ module Adjoint : sig (* {{{ *)
       of integration steps between consecutive checkpoints, and the type of
       variable-degree interpolation.
 
+      The checkpoints are cloned from the nvectors of the session. For
+      problems whose checkpoints do not fit in memory, they can be stored in
+      files by creating the session with {!Nvector_serial.wrap_with_scratch}
+      and enabling {!Nvector_serial.set_scratch_dir} only during the forward
+      integration.
+
       @idas <node7#sss:idaadjinit> IDAAdjInit *)
   val init : ('d, 'k) Ida.session -> int -> interpolation -> unit
 
@@ -914,6 +992,9 @@ module Adjoint : sig (* {{{ *)
 
   (** Arguments common to Jacobian callback functions.
 
+      {warning The record is reused between calls and should not be
+               retained after the callback returns.}
+
       @idas <node7#ss:densejac_b> IDALsJacFnB
       @idas <node7#ss:jactimesvec_b> IDAJacTimesVecFnB
       @idas <node7#ss:psolve_b> IDALsPrecSolveFnB
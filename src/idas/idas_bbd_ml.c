@@ -40,14 +40,17 @@ static int bbbdlocal(sundials_ml_index nlocal, realtype t, N_Vector yy,
     CAMLparam0();
     CAMLlocal3(args, session, cb);
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BRESFN_ARGS,
+				 RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_Y, NVEC_BACKLINK (yy));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YP, NVEC_BACKLINK (yp));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YB, NVEC_BACKLINK (yyB));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YBP, NVEC_BACKLINK (ypB));
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_IDAS_BBBD_PRECFNS_LOCAL_FN);
@@ -66,14 +69,17 @@ static int bbbdcomm(sundials_ml_index nlocal, realtype t,
     CAMLparam0();
     CAMLlocal3(args, session, cb);
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BRESFN_ARGS,
+				 RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_Y, NVEC_BACKLINK (yy));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YP, NVEC_BACKLINK (yp));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YB, NVEC_BACKLINK (yyB));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YBP, NVEC_BACKLINK (ypB));
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_IDAS_BBBD_PRECFNS_COMM_FN);
@@ -50,6 +50,13 @@
 #include "../lsolvers/sundials_nonlinearsolver_ml.h"
 #include "../lsolvers/sundials_matrix_ml.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#define SENS_THREAD_NUM() omp_get_thread_num()
+#else
+#define SENS_THREAD_NUM() 0
+#endif
+
 #define MAX_ERRMSG_LEN 256
 
 CAMLprim value sunml_idas_init_module (value exns)
@@ -90,7 +97,7 @@ void sunml_idas_wrap_to_nvector_table(int n, value vy, N_Vector *y)
 
 void sunml_idas_check_flag(const char *call, int flag, void *ida_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == IDA_SUCCESS
 	    || flag == IDA_ROOT_RETURN
@@ -221,14 +228,16 @@ void sunml_idas_check_flag(const char *call, int flag, void *ida_mem)
 
 /* Callbacks */
 
-value sunml_idas_make_jac_arg(realtype t, N_Vector y, N_Vector yp,
-			N_Vector yb, N_Vector ypb, N_Vector resb,
-			realtype coef, value tmp)
+value sunml_idas_make_jac_arg(value session, realtype t, N_Vector y,
+			      N_Vector yp, N_Vector yb, N_Vector ypb,
+			      N_Vector resb, realtype coef, value tmp)
 {
-    CAMLparam1(tmp);
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_IDAS_ADJ_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(IDA_ARGCACHE_FROM_ML(session),
+			     IDAS_ARGCACHE_ADJ_JAC_ARG,
+			     RECORD_IDAS_ADJ_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_IDAS_ADJ_JACOBIAN_ARG_JAC_T, caml_copy_double(t));
     Store_field(r, RECORD_IDAS_ADJ_JACOBIAN_ARG_JAC_Y, NVEC_BACKLINK(y));
     Store_field(r, RECORD_IDAS_ADJ_JACOBIAN_ARG_JAC_YP, NVEC_BACKLINK(yp));
@@ -281,7 +290,9 @@ static int sensresfn(int Ns, realtype t,
     WEAK_DEREF (session, *backref);
     sensext = IDA_SENSEXT_FROM_ML(session);
 
-    args = caml_alloc_tuple (RECORD_IDAS_SENSRESFN_ARGS_SIZE);
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_SENSRESFN_ARGS,
+				 RECORD_IDAS_SENSRESFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_SENSRESFN_ARGS_T,
 		 caml_copy_double (t));
     Store_field (args, RECORD_IDAS_SENSRESFN_ARGS_Y,
@@ -297,7 +308,7 @@ static int sensresfn(int Ns, realtype t,
 	         IDAS_SENSARRAY2_FROM_EXT(sensext));
     sunml_idas_wrap_to_nvector_table (Ns, IDAS_SENSARRAY2_FROM_EXT(sensext), ypS);
     Store_field (args, RECORD_IDAS_SENSRESFN_ARGS_TMP,
-		 sunml_ida_make_triple_tmp (tmp1, tmp2, tmp3));
+		 sunml_ida_make_triple_tmp(session, tmp1, tmp2, tmp3));
 
     sunml_idas_wrap_to_nvector_table (Ns, IDAS_SENSARRAY3_FROM_EXT(sensext), resvalS);
 
@@ -307,6 +318,56 @@ static int sensresfn(int Ns, realtype t,
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, RECOVERABLE));
 }
 
+/* The type of native sensitivity residuals for a single parameter (see
+   Idas.Sensitivity.init_cfun).  */
+typedef int (*sensres1fn)(int ns, realtype t,
+			  N_Vector y, N_Vector yp, N_Vector resval,
+			  int is, N_Vector yS, N_Vector ypS, N_Vector resvalS,
+			  void *data,
+			  N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+
+/* Evaluate a native sensitivity residual for all of the parameters,
+   concurrently on sens_nthreads threads.  Each thread passes its own
+   triple of temporary vectors.  The result is the first negative
+   (unrecoverable) return value, if any, and otherwise the greatest.  */
+static int native_sensresfn(int Ns, realtype t,
+			    N_Vector y, N_Vector yp, N_Vector resval,
+			    N_Vector *yS, N_Vector *ypS, N_Vector *resvalS,
+			    void *user_data,
+			    N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+    struct ida_cdata *cdata = IDA_CDATA(user_data);
+    sensres1fn f = (sensres1fn)(cdata->sensresfn1.fn);
+    void *data = cdata->sensresfn1.data;
+    int nt = cdata->sens_nthreads;
+    int is, rmin = 0, rmax = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nt) \
+			 reduction(min:rmin) reduction(max:rmax)
+#else
+    (void)nt;
+#endif
+    for (is = 0; is < Ns; ++is) {
+	int id = SENS_THREAD_NUM();
+	N_Vector t1 = tmp1, t2 = tmp2, t3 = tmp3;
+	int r;
+
+	if (id > 0) {
+	    t1 = cdata->sens_tmps[3 * (id - 1)];
+	    t2 = cdata->sens_tmps[3 * (id - 1) + 1];
+	    t3 = cdata->sens_tmps[3 * (id - 1) + 2];
+	}
+	r = f(Ns, t, y, yp, resval, is, yS[is], ypS[is], resvalS[is],
+	      data, t1, t2, t3);
+
+	if (r < rmin) rmin = r;
+	if (r > rmax) rmax = r;
+    }
+
+    return (rmin < 0) ? rmin : rmax;
+}
+
 static int quadsensrhsfn(int ns, realtype t, N_Vector yy, N_Vector yp,
 			 N_Vector *yyS, N_Vector *ypS,
 			 N_Vector rrQ, N_Vector *rhsvalQS,
@@ -319,7 +380,9 @@ static int quadsensrhsfn(int ns, realtype t, N_Vector yy, N_Vector yp,
     WEAK_DEREF (session, *(value*)user_data);
     sensext = IDA_SENSEXT_FROM_ML(session);
 
-    args = caml_alloc_tuple (RECORD_IDAS_QUADSENSRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_QUADSENSRHSFN_ARGS,
+				 RECORD_IDAS_QUADSENSRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_QUADSENSRHSFN_ARGS_T,
 		 caml_copy_double (t));
     Store_field (args, RECORD_IDAS_QUADSENSRHSFN_ARGS_Y,
@@ -333,7 +396,7 @@ static int quadsensrhsfn(int ns, realtype t, N_Vector yy, N_Vector yp,
     Store_field (args, RECORD_IDAS_QUADSENSRHSFN_ARGS_SENSP,
 		 IDAS_SENSARRAY2_FROM_EXT(sensext));
     Store_field (args, RECORD_IDAS_QUADSENSRHSFN_ARGS_TMP,
-		 sunml_ida_make_triple_tmp (tmp1, tmp2, tmp3));
+		 sunml_ida_make_triple_tmp(session, tmp1, tmp2, tmp3));
 
     sunml_idas_wrap_to_nvector_table (ns,
 	    IDAS_SENSARRAY3_FROM_EXT(sensext), rhsvalQS);
@@ -356,7 +419,9 @@ static int bresfn(realtype t, N_Vector y, N_Vector yp,
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = IDA_SENSEXT_FROM_ML(session);
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BRESFN_ARGS,
+				 RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YP, NVEC_BACKLINK (yp));
@@ -383,7 +448,9 @@ static int bresfn_sens(realtype t, N_Vector y, N_Vector yp,
     bsensext = IDA_SENSEXT_FROM_ML(session);
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BRESFN_ARGS,
+				 RECORD_IDAS_ADJ_BRESFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_IDAS_ADJ_BRESFN_ARGS_YP, NVEC_BACKLINK (yp));
@@ -422,9 +489,11 @@ static int bprecsetupfn(realtype t,
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_idas_make_jac_arg(t, yy, yp, yB, ypB, resvalB, cjB, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_idas_make_jac_arg(session, t, yy, yp, yB, ypB, resvalB, cjB,
+				  Val_unit);
+
     cb = IDA_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_IDAS_BSPILS_PRECFNS_PREC_SETUP_FN);
@@ -464,7 +533,8 @@ static int bprecsetupfn_sens(realtype t,
     bsensext = IDA_SENSEXT_FROM_ML(session);
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yB, ypB, resvalB, cjB, Val_unit);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yB, ypB, resvalB,
+				      cjB, Val_unit);
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
     args[2] = IDAS_BSENSARRAY2_FROM_EXT (bsensext);
     sunml_idas_wrap_to_nvector_table (ns, args[1], yyS);
@@ -503,12 +573,14 @@ static int bprecsolvefn(realtype t,
     CAMLlocalN(args, 4);
     CAMLlocal2(session, cb);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yB, ypB, resvalB, cjB, Val_unit);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yB, ypB, resvalB,
+				      cjB, Val_unit);
     args[1] = NVEC_BACKLINK (rvecB);
     args[2] = NVEC_BACKLINK (zvecB);
     args[3] = caml_copy_double (deltaB);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_IDAS_BSPILS_PRECFNS_PREC_SOLVE_FN);
@@ -547,7 +619,8 @@ static int bprecsolvefn_sens(realtype t,
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = IDA_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yB, ypB, resvalB, cjB, Val_unit);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yB, ypB, resvalB,
+				      cjB, Val_unit);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -583,9 +656,11 @@ static int bjacsetupfn(realtype t,
     CAMLparam0();
     CAMLlocal3(session, cb, arg);
 
-    arg = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB, Val_unit);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    arg = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB, cjB,
+				  Val_unit);
+
     cb = IDA_LS_CALLBACKS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
@@ -615,7 +690,8 @@ static int bjacsetupfn_sens(realtype t,
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = IDA_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB, Val_unit);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, Val_unit);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -651,12 +727,14 @@ static int bjactimesfn(realtype t,
     CAMLlocalN(args, 3);
     CAMLlocal2(session, cb);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_double_tmp (tmp1B, tmp2B));
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_ida_make_double_tmp(session, tmp1B, tmp2B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
     args[1] = NVEC_BACKLINK(vB);
     args[2] = NVEC_BACKLINK(JvB);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = IDA_LS_CALLBACKS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Some_val (cb);
@@ -691,8 +769,9 @@ static int bjactimesfn_sens(realtype t,
     WEAK_DEREF (session, *(value*)user_data);
     bsensext = IDA_SENSEXT_FROM_ML(session);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_double_tmp (tmp1B, tmp2B));
+    args[0] = sunml_ida_make_double_tmp(session, tmp1B, tmp2B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -737,8 +816,9 @@ static int bjacfn_nosens(realtype t,
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
     args[1] = MAT_BACKLINK(JacB);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -773,8 +853,9 @@ static int bjacfn_withsens(realtype t,
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -819,8 +900,9 @@ static int bjacfn_nosens(long int NeqB,
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
     args[1] = Some_val(dmat);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -863,8 +945,9 @@ static int bjacfn_withsens(long int NeqB,
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -911,8 +994,9 @@ static int bbandjacfn_nosens(long int NeqB,
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp(tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
     args[1] = Some_val(bmat);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -957,8 +1041,9 @@ static int bbandjacfn_withsens(long int NeqB,
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp(tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT (bsensext);
@@ -984,14 +1069,17 @@ static int bquadrhsfn(realtype t, N_Vector y, N_Vector yp,
     CAMLparam0();
     CAMLlocal3(args, session, sensext);
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_SIZE);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+				 RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_Y, NVEC_BACKLINK(y));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_YP, NVEC_BACKLINK(yp));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_YB, NVEC_BACKLINK(yB));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_YBP, NVEC_BACKLINK(ypB));
 
-    WEAK_DEREF (session, *(value*)user_data);
     sensext = IDA_SENSEXT_FROM_ML (session);
 
     /* NB: Don't trigger GC while processing this return value!  */
@@ -1014,7 +1102,9 @@ static int bquadrhsfn_sens(realtype t, N_Vector y, N_Vector yp,
     sensext = IDA_SENSEXT_FROM_ML(session);
     ns = Int_val(Field(sensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
 
-    args = caml_alloc_tuple (RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_SIZE);
+    args = sunml_argcache_block (IDA_ARGCACHE_FROM_ML (session),
+				 IDAS_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+				 RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_SIZE);
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_T, caml_copy_double (t));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_Y, NVEC_BACKLINK (y));
     Store_field (args, RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_YP, NVEC_BACKLINK (yp));
@@ -1045,12 +1135,40 @@ CAMLprim value sunml_idas_quad_init (value vsession, value vyQ0)
     N_Vector yQ0 = NVEC_VAL (vyQ0);
     int flag;
 
+    sunml_quadforms_free (&(IDA_CDATA_FROM_ML (vsession)->quadforms));
     flag = IDAQuadInit (IDA_MEM_FROM_ML (vsession), quadrhsfn, yQ0);
     SCHECK_FLAG ("IDAQuadInit", flag);
 
     CAMLreturn (Val_unit);
 }
 
+static int native_quadforms(realtype t, N_Vector y, N_Vector yp,
+			    N_Vector rhsQ, void *user_data)
+{
+    sunml_quadforms_eval(&(IDA_CDATA(user_data)->quadforms), y, rhsQ);
+    return 0;
+}
+
+/* IDAQuadInit() with a right-hand side given by linear and quadratic
+   forms (vrow, va, vb, vw) and evaluated without calling into OCaml.  */
+CAMLprim value sunml_idas_quad_init_forms (value vsession, value vforms,
+					   value vyQ0)
+{
+    CAMLparam3 (vsession, vforms, vyQ0);
+    N_Vector yQ0 = NVEC_VAL (vyQ0);
+    struct ida_cdata *cdata = IDA_CDATA_FROM_ML (vsession);
+    int flag;
+
+    sunml_quadforms_set (&cdata->quadforms,
+			 Field (vforms, 0), Field (vforms, 1),
+			 Field (vforms, 2), Field (vforms, 3), cdata->neq);
+
+    flag = IDAQuadInit (IDA_MEM_FROM_ML (vsession), native_quadforms, yQ0);
+    SCHECK_FLAG ("IDAQuadInit", flag);
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_idas_quad_reinit (value vsession, value vyQ0)
 {
 
@@ -1255,6 +1373,55 @@ CAMLprim value sunml_idas_sens_init(value vdata, value vmethod, value vrhsfn,
     CAMLreturn (Val_unit);
 }
 
+/* IDASensInit() with a native sensitivity residual for a single parameter,
+   evaluated for all of the parameters concurrently on vnthreads threads.  */
+CAMLprim value sunml_idas_sens_init_cfun(value vdata, value vmethod,
+					 value vnthreads, value vcfun,
+					 value vyS0, value vypS0)
+{
+    CAMLparam5(vdata, vmethod, vnthreads, vcfun, vyS0);
+    CAMLxparam1(vypS0);
+    int ns = Wosize_val (vyS0);	/* vyS0 : nvector array */
+    int nt = Int_val(vnthreads);
+    N_Vector *yS0, *ypS0;
+    struct ida_cdata *cdata = IDA_CDATA_FROM_ML(vdata);
+    int flag;
+
+    if (nt < 1)
+	caml_invalid_argument("Idas.Sensitivity.init_cfun: num_threads");
+    if (nt > ns) nt = ns;
+
+    if (cdata->sens_tmps != NULL) {
+	N_VDestroyVectorArray(cdata->sens_tmps, 3 * (cdata->sens_nthreads - 1));
+	cdata->sens_tmps = NULL;
+    }
+    cdata->sensresfn1 = *CFUN_VAL(vcfun);
+    cdata->sens_nthreads = 1;
+
+    yS0 = sunml_nvector_array_alloc(vyS0);
+    ypS0 = sunml_nvector_array_alloc(vypS0);
+    if (nt > 1) {
+	cdata->sens_tmps = N_VCloneVectorArray(3 * (nt - 1), yS0[0]);
+	if (cdata->sens_tmps == NULL) {
+	    sunml_nvector_array_free(yS0);
+	    sunml_nvector_array_free(ypS0);
+	    caml_raise_out_of_memory();
+	}
+	cdata->sens_nthreads = nt;
+    }
+
+    flag = IDASensInit(IDA_MEM_FROM_ML(vdata), ns,
+		       decode_sens_method(vmethod),
+		       native_sensresfn, yS0, ypS0);
+    sunml_nvector_array_free(yS0);
+    sunml_nvector_array_free(ypS0);
+    SCHECK_FLAG("IDASensInit", flag);
+
+    CAMLreturn (Val_unit);
+}
+
+BYTE_STUB6(sunml_idas_sens_init_cfun)
+
 CAMLprim value sunml_idas_sens_reinit(value vdata, value vmethod, value vyS0,
 				  value vypS0)
 {
@@ -1678,6 +1845,41 @@ CAMLprim value sunml_idas_quadsens_init(value vdata, value vrhsfn, value vyqs0)
     CAMLreturn (Val_unit);
 }
 
+static int native_quadsensforms(int ns, realtype t, N_Vector yy,
+				N_Vector yp, N_Vector *yyS, N_Vector *ypS,
+				N_Vector rrQ, N_Vector *rhsvalQS,
+				void *user_data,
+				N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+    struct sunml_quadforms *qf = &(IDA_CDATA(user_data)->quadforms);
+    int is;
+
+    for (is = 0; is < ns; ++is)
+	sunml_quadforms_eval_sens(qf, yy, yyS[is], rhsvalQS[is]);
+    return 0;
+}
+
+/* IDAQuadSensInit() for quadratures initialized by
+   sunml_idas_quad_init_forms: the sensitivities are the derivatives of the
+   same forms.  */
+CAMLprim value sunml_idas_quadsens_init_forms(value vdata, value vyqs0)
+{
+    CAMLparam2(vdata, vyqs0);
+    N_Vector *yqs0;
+
+    if (IDA_CDATA_FROM_ML(vdata)->quadforms.w == NULL)
+	caml_invalid_argument("Idas.Sensitivity.Quadrature.init_forms: "
+			      "the quadratures are not given by forms");
+
+    yqs0 = sunml_nvector_array_alloc(vyqs0);
+    int flag = IDAQuadSensInit(IDA_MEM_FROM_ML(vdata),
+			       native_quadsensforms, yqs0);
+    sunml_nvector_array_free(yqs0);
+    SCHECK_FLAG("IDAQuadSensInit", flag);
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_idas_quadsens_reinit(value vdata, value vyqs0)
 {
     CAMLparam2(vdata, vyqs0);
@@ -2557,10 +2759,12 @@ CAMLprim value sunml_idas_adj_init_backward(value vparent, value weakref,
     vida_mem = caml_alloc_final(1, NULL, 1, 15);
     IDA_MEM(vida_mem) = IDAGetAdjIDABmem(parent, which);
 
-    value *backref = sunml_sundials_malloc_value(weakref);
+    value *backref = sunml_sundials_malloc_value_ext(weakref,
+					    sizeof(struct ida_cdata));
     if (backref == NULL) {
 	caml_raise_out_of_memory();
     }
+    IDA_CDATA(backref)->neq = sunml_nvec_data_length(y0);
     IDASetUserDataB (parent, which, backref);
 
     r = caml_alloc_tuple (3);
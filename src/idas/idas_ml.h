@@ -61,9 +61,9 @@
 void sunml_idas_check_flag(const char *call, int flag, void *ida_mem);
 
 void sunml_idas_wrap_to_nvector_table(int n, value vy, N_Vector *y);
-value sunml_idas_make_jac_arg(realtype t, N_Vector y, N_Vector yp,
-                        N_Vector yb, N_Vector ypb, N_Vector resb,
-                        realtype coef, value tmp);
+value sunml_idas_make_jac_arg(value session, realtype t, N_Vector y,
+			      N_Vector yp, N_Vector yb, N_Vector ypb,
+			      N_Vector resb, realtype coef, value tmp);
 
 // NB: overrides CHECK_FLAG macro in ida_ml.h
 #define SCHECK_FLAG(call, flag) if (flag != IDA_SUCCESS) \
@@ -194,6 +194,16 @@ enum idas_adj_bquadrhsfn_args_index {
     RECORD_IDAS_ADJ_BQUADRHSFN_ARGS_SIZE
 };
 
+/* Slots of the callback argument cache, following those of Ida.  */
+enum idas_argcache_index {
+    IDAS_ARGCACHE_SENSRESFN_ARGS = IDA_ARGCACHE_SIZE,
+    IDAS_ARGCACHE_QUADSENSRHSFN_ARGS,
+    IDAS_ARGCACHE_ADJ_JAC_ARG,
+    IDAS_ARGCACHE_ADJ_BRESFN_ARGS,
+    IDAS_ARGCACHE_ADJ_BQUADRHSFN_ARGS,
+    IDAS_ARGCACHE_SIZE
+};
+
 enum idas_adj_interpolation {
     VARIANT_IDAS_ADJ_INTERPOLATION_POLYNOMIAL = 0,
     VARIANT_IDAS_ADJ_INTERPOLATION_HERMITE
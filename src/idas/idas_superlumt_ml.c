@@ -61,8 +61,9 @@ static int jacfn_nosens( /* IDASlsSparseJacFnB */
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     smat = Field(cb, 1);
     if (smat == Val_none) {
@@ -107,8 +108,9 @@ static int jacfn_withsens( /* IDASlsSparseJacFnB */
     cb = IDA_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_idas_make_jac_arg(t, yy, yp, yyB, ypB, resvalB, cjB,
-			        sunml_ida_make_triple_tmp (tmp1B, tmp2B, tmp3B));
+    args[0] = sunml_ida_make_triple_tmp(session, tmp1B, tmp2B, tmp3B);
+    args[0] = sunml_idas_make_jac_arg(session, t, yy, yp, yyB, ypB, resvalB,
+				      cjB, args[0]);
 
     int ns = Int_val(Field(bsensext, RECORD_IDAS_BWD_SESSION_NUMSENSITIVITIES));
     args[1] = IDAS_BSENSARRAY1_FROM_EXT(bsensext);
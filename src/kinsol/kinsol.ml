@@ -212,7 +212,7 @@ module Dls = struct (* {{{ *)
     | LSI.Superlumt _ ->
         if jac = None then invalid_arg "Superlumt requires Jacobian function";
         session.ls_callbacks <- SlsSuperlumtCallback cb
-    | LSI.Custom _ ->
+    | LSI.Custom _ | LSI.BlockDiag ->
         check_dqjac jac mat;
         session.ls_callbacks <- DirectCustomCallback cb
     | _ -> assert false
@@ -252,6 +252,12 @@ module Dls = struct (* {{{ *)
     LSI.attach ls;
     session.ls_solver <- LSI.HLS hls
 
+  let colored_jac c f { jac_u = u; jac_fu = fu } jm =
+    Matrix.Coloring.jacobian c f u fu jm
+
+  let incremental_jac t f arg jm =
+    Matrix.Incremental.jacobian t (fun cols jm -> f cols arg jm) jm
+
   (* Sundials < 3.0.0 *)
   let invalidate_callback session =
     if in_compat_mode2 then
@@ -418,6 +424,15 @@ module Spils = struct (* {{{ *)
       session.ls_callbacks <- SpilsCallback jac_times_vec;
       if jac_times_vec <> None then c_set_jac_times_vec_fn session true
 
+  let dual_jac_times_vec fd =
+    let tmp = ref RealArray.empty in
+    fun v jv u _ ->
+      let n = RealArray.length u in
+      if RealArray.length !tmp <> n then tmp := RealArray.create n;
+      fd { Nvector_dual.value = u; Nvector_dual.tangent = v }
+         { Nvector_dual.value = !tmp; Nvector_dual.tangent = jv };
+      false
+
   let set_jac_times s f =
     match s.ls_callbacks with
     | SpilsCallback _ ->
@@ -488,6 +503,32 @@ module Spils = struct (* {{{ *)
   let get_num_lin_func_evals s =
     if in_compat_mode2_3 then ls_check_spils s;
     get_num_lin_func_evals s
+
+  module Native = struct (* {{{ *)
+
+    type 'm setup_fn =
+      (unit, RealArray.t) jacobian_arg -> RealArray.t solve_arg -> 'm -> unit
+
+    external c_set_preconditioner : ('a, 'k) session -> unit
+      = "sunml_kinsol_spils_set_native_preconditioner"
+
+    let init_preconditioner setup (np : 'm LSI.Iterative.native) session nv =
+      if RealArray.length (Nvector.unwrap nv) <> np.LSI.Iterative.native_size
+      then invalid_arg "Kinsol.Spils.Native: wrong number of equations";
+      let m = np.LSI.Iterative.native_matrix in
+      let prec_setup_fn jac sarg =
+        setup jac sarg m;
+        np.LSI.Iterative.native_factor ()
+      in
+      let prec_solve_fn _ _ v = LinearSolver.Native.solve np v v in
+      c_set_preconditioner session;
+      session.ls_precfns <-
+        NativePrecFns ({ prec_setup_fn = Some prec_setup_fn; prec_solve_fn },
+                       np.LSI.Iterative.native_cptr)
+
+    let prec_right setup np =
+      LSI.Iterative.(PrecRight, init_preconditioner setup np)
+  end (* }}} *)
 end (* }}} *)
 
 external set_error_file : ('a, 'k) session -> Logfile.t -> unit
@@ -611,26 +652,56 @@ let set_constraints s cc =
 let set_sys_func s fsys =
   s.sysfn <- fsys
 
+external c_set_tracing : Sundials_impl.arg_cache -> int -> unit
+    = "sunml_sundials_set_tracing"
+
+external c_get_trace : Sundials_impl.arg_cache -> Sundials.Trace.event array
+    = "sunml_sundials_get_trace"
+
+external c_set_profiling : Sundials_impl.arg_cache -> bool -> unit
+    = "sunml_sundials_set_profiling"
+
+external c_get_profile : Sundials_impl.arg_cache -> profile
+    = "sunml_sundials_get_profile"
+
+let set_profiling s enable = c_set_profiling s.argcache enable
+
+let get_profile s = c_get_profile s.argcache
+
+let set_tracing s capacity = c_set_tracing s.argcache capacity
+
+let get_trace s = c_get_trace s.argcache
+
 external get_work_space : ('a, 'k) session -> int * int
     = "sunml_kinsol_get_work_space"
 
-external get_num_func_evals : ('a, 'k) session -> int
+external get_num_func_evals : ('a, 'k) session -> (int [@untagged])
     = "sunml_kinsol_get_num_func_evals"
+      "sunml_kinsol_get_num_func_evals_untagged"
+    [@@noalloc]
 
-external get_num_nonlin_solv_iters : ('a, 'k) session -> int
+external get_num_nonlin_solv_iters : ('a, 'k) session -> (int [@untagged])
     = "sunml_kinsol_get_num_nonlin_solv_iters"
+      "sunml_kinsol_get_num_nonlin_solv_iters_untagged"
+    [@@noalloc]
 
-external get_num_beta_cond_fails : ('a, 'k) session -> int
+external get_num_beta_cond_fails : ('a, 'k) session -> (int [@untagged])
     = "sunml_kinsol_get_num_beta_cond_fails"
+      "sunml_kinsol_get_num_beta_cond_fails_untagged"
+    [@@noalloc]
 
-external get_num_backtrack_ops : ('a, 'k) session -> int
+external get_num_backtrack_ops : ('a, 'k) session -> (int [@untagged])
     = "sunml_kinsol_get_num_backtrack_ops"
+      "sunml_kinsol_get_num_backtrack_ops_untagged"
+    [@@noalloc]
 
-external get_func_norm : ('a, 'k) session -> float
-    = "sunml_kinsol_get_func_norm"
+external get_func_norm : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_kinsol_get_func_norm" "sunml_kinsol_get_func_norm_unboxed"
+    [@@noalloc]
 
-external get_step_length : ('a, 'k) session -> float
-    = "sunml_kinsol_get_step_length"
+external get_step_length : ('a, 'k) session -> (float [@unboxed])
+    = "sunml_kinsol_get_step_length" "sunml_kinsol_get_step_length_unboxed"
+    [@@noalloc]
 
 external c_init
     : ('a, 'k) session Weak.t -> ('a, 'k) nvector -> int option -> int option
@@ -656,6 +727,7 @@ let init ?max_iters ?maa ?lsolver f u0 =
           checkvec     = checkvec;
 
           exn_temp     = None;
+          argcache     = Sundials_impl.make_arg_cache ();
 
           neqs         = 0;
 
@@ -696,6 +768,44 @@ let solve s u strategy u_scale f_scale =
   then raise MissingLinearSolver
   else c_solve s u strategy u_scale f_scale
 
+module Ensemble = struct (* {{{ *)
+
+  let solve ?(prepare=fun _ -> ()) ?failed ?guess ?(reuse_setup=false)
+            s ~u0 strategy u_scale f_scale u uout =
+    let ud = Nvector.unwrap u in
+    let nr, nc = RealArray2.size u0 in
+    if Sundials_configuration.safe
+       && (nr <> RealArray.length ud || RealArray2.size uout <> (nr, nc))
+    then invalid_arg "Ensemble.solve: array sizes do not match";
+    let solved = Array.make nc false in
+    let start i =
+      match guess with
+      | None -> RealArray2.col u0 i
+      | Some g ->
+          (match g i with
+           | Some j when 0 <= j && j < nc && solved.(j) ->
+               RealArray2.col uout j
+           | _ -> RealArray2.col u0 i)
+    in
+    for i = 0 to nc - 1 do
+      RealArray.blit ~src:(start i) ~dst:ud;
+      (try
+         prepare i;
+         if reuse_setup then
+           (if i > 0 && solved.(i - 1) then set_no_init_setup s
+            else set_init_setup s);
+         ignore (solve s u strategy u_scale f_scale);
+         solved.(i) <- true
+       with e ->
+         match failed with
+         | None -> (if reuse_setup then set_init_setup s; raise e)
+         | Some f -> f i e);
+      RealArray.blit ~src:ud ~dst:(RealArray2.col uout i)
+    done;
+    if reuse_setup then set_init_setup s
+
+end (* }}} *)
+
 (* Let C code know about some of the values in this module.  *)
 external c_init_module : exn array -> unit =
   "sunml_kinsol_init_module"
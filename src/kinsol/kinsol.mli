@@ -71,6 +71,9 @@ type 'd double = 'd * 'd
 
 (** Arguments common to Jacobian callback functions.
 
+    {warning The record is reused between calls and should not be
+             retained after the callback returns.}
+
     @kinsol <node5#ss:djacFn> KINLsJacFn
     @kinsol <node5#ss:psolveFn> KINLsPrecSolveFn
     @kinsol <node5#ss:precondFn> KINLsPrecSetupFn *)
@@ -120,6 +123,22 @@ module Dls : sig (* {{{ *)
     ('m, RealArray.t, 'kind, [>`Dls]) LinearSolver.t ->
     'kind serial_linear_solver
 
+  (** [colored_jac c f] approximates the Jacobian of the system function
+      [f] by finite differences, with one evaluation of [f] per color of
+      [c] (see {!Matrix.Coloring}). It is an alternative to a hand-written
+      Jacobian function for sparse and band matrices. *)
+  val colored_jac : 'm Matrix.Coloring.t
+                    -> (RealArray.t -> RealArray.t -> unit)
+                    -> 'm jac_fn
+
+  (** [incremental_jac t f] is a Jacobian function that only recomputes
+      the columns marked dirty in [t] (see {!Matrix.Incremental}). The call
+      [f cols arg jm] must assign the columns [cols] of [jm]; the other
+      columns already hold their last computed values. *)
+  val incremental_jac : 'm Matrix.Incremental.t
+                        -> (int array -> 'm jac_fn)
+                        -> 'm jac_fn
+
   (** {3:stats Solver statistics} *)
 
   (** Returns the sizes of the real and integer workspaces used by a direct
@@ -226,6 +245,30 @@ module Spils : sig (* {{{ *)
     -> 'd prec_solve_fn
     -> ('d, 'k) preconditioner
 
+  (** Native preconditioners (see {!Sundials_LinearSolver.Native}).
+      The setup function fills the matrix of the preconditioner with an
+      approximation of the system Jacobian {% $J(u)$ %}; the matrix is then
+      factored, and the preconditioner is applied in C, without calling
+      back into OCaml, at each Krylov iteration.  *)
+  module Native : sig (* {{{ *)
+
+    (** A function [setup jac sarg m] that fills [m] with an approximation
+        of the system Jacobian. The arguments [jac] and [sarg] are as for
+        {!prec_setup_fn}.
+
+        @raise Sundials.RecoverableFailure To signal a recoverable error. *)
+    type 'm setup_fn =
+      (unit, RealArray.t) jacobian_arg -> RealArray.t solve_arg -> 'm -> unit
+
+    (** Right preconditioning with a native preconditioner.
+
+        @kinsol <node5#sss:optin_spils> KINSetPreconditioner *)
+    val prec_right : 'm setup_fn
+                     -> 'm LinearSolver.Native.t
+                     -> (Nvector_serial.data,
+                         [>Nvector_serial.kind]) preconditioner
+  end (* }}} *)
+
   (** {3:lsolvers Solvers} *)
 
   (** Callback functions that compute (an approximation to) the Jacobian
@@ -262,6 +305,18 @@ module Spils : sig (* {{{ *)
     -> ('d, 'k) preconditioner
     -> ('d, 'k) linear_solver
 
+  (** Computes exact Jacobian-vector products by forward-mode automatic
+      differentiation. The call [dual_jac_times_vec fd] returns a
+      {!jac_times_vec_fn} that computes {% $J\mathtt{v}$%} with a single
+      call [fd u fu], where [fd] evaluates the system function on
+      dual-number vectors (see {!Nvector_dual}). The values of [u] are the
+      current iterate and its tangents are [v]; the tangents of [fu]
+      receive the product. Its values are stored in an array allocated at
+      the first call and reused afterward. *)
+  val dual_jac_times_vec :
+    (Nvector_dual.data -> Nvector_dual.data -> unit)
+    -> Nvector_serial.data jac_times_vec_fn
+
   (** {3:stats Solver statistics} *)
 
   (** Returns the sizes of the real and integer workspaces used by the spils
@@ -434,6 +489,74 @@ val solve :
     -> ('d, 'k) Nvector.t
     -> result
 
+(** Solving families of nonlinear systems.
+
+    Steady-state sweeps solve many systems that share a structure and
+    differ only in their parameters. The function of this module solves
+    every member of such a family in turn with a single session, so that
+    the solver memory, linear solver, and vectors are created only once.
+    In particular, a sparse direct linear solver keeps the symbolic
+    factorization of the (frozen) pattern of the Jacobian matrix across
+    the members and only refactors it numerically.
+
+    The members are independent, so larger sweeps can be distributed over
+    several processes by passing each one a slice of the arrays (for
+    instance, with
+    {{:OCAML_DOC_ROOT(Bigarray.Array2.html#VALsub_left)}
+    [Bigarray.Array2.sub_left]} on {!Sundials.RealArray2.unwrap}, which
+    selects a range of columns). *)
+module Ensemble : sig (* {{{ *)
+
+  (** Solves each member of a family of nonlinear systems. The call
+      [solve ~prepare ~failed ~guess ~reuse_setup s ~u0 strategy u_scale
+      f_scale u uout] has as arguments
+      - [prepare], a function called with the index [i] of each member
+                   before it is solved, typically to update the parameters
+                   used by the system function,
+      - [failed], a function called with the index of a member and the
+                  exception raised while solving it,
+      - [guess], a function that returns, for a member [i], the index of a
+                 neighbouring member whose solution is to be used as the
+                 initial guess for [i] (a warm start),
+      - [reuse_setup], whether the linear solver setup (a Jacobian
+                       evaluation and factorization) made for a member is
+                       kept for the first iteration of the next one
+                       (default: [false]),
+      - [s], a session created for one member of the family,
+      - [u0], an array whose [i]th column gives the initial guess of the
+              [i]th member,
+      - [strategy], [u_scale], and [f_scale], as for {!solve},
+      - [u], a vector of the session, which is used as workspace, and,
+      - [uout], an array of the same size as [u0] whose [i]th column
+                receives the solution of the [i]th member.
+
+      The initial guess of a member is the column of [u0] when [guess] is
+      not given, when it returns [None], or when the member it designates
+      has not been solved successfully (yet). Setups are only reused
+      after a successful solution (see {!set_no_init_setup}), and the
+      default is restored at the end of the sweep.
+
+      If [failed] is not given, the first exception aborts the sweep;
+      otherwise, [uout] receives whatever iterate was reached for the
+      failed member and the remaining members are solved.
+
+      @raise Invalid_argument The array sizes do not match the length of [u]. *)
+  val solve :
+    ?prepare:(int -> unit)
+    -> ?failed:(int -> exn -> unit)
+    -> ?guess:(int -> int option)
+    -> ?reuse_setup:bool
+    -> (Nvector_serial.data, 'k) session
+    -> u0:RealArray2.t
+    -> strategy
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> (Nvector_serial.data, 'k) Nvector.t
+    -> RealArray2.t
+    -> unit
+
+end (* }}} *)
+
 (** {2:set Modifying the solver (optional input functions)} *)
 
 (** Specifies that an initial call to the preconditioner setup function
@@ -650,6 +773,30 @@ val set_print_level : ('d, 'k) session -> print_level -> unit
 
 (** {2:get Querying the solver (optional output functions)} *)
 
+(** Enables or disables profiling of the session. Enabling profiling
+    resets the counters, which then accumulate the number of calls and the
+    time spent in the solver and in each category of callback (see
+    {!Sundials.profile}). Disabling profiling leaves the counters unchanged.
+    Profiling is disabled by default. *)
+val set_profiling : ('d, 'k) session -> bool -> unit
+
+(** Returns the profiling counters of the session. All of the counters are
+    zero if profiling has never been enabled. See {!set_profiling}. *)
+val get_profile : ('d, 'k) session -> Sundials.profile
+
+(** Enables tracing of the session, with a buffer that keeps the given
+    number of most recent events, or disables it if the capacity is zero
+    (see {!Sundials.Trace}). Enabling tracing again discards the events
+    recorded so far. Tracing is independent of profiling and is disabled by
+    default.
+
+    @raise Invalid_argument If the capacity is negative. *)
+val set_tracing : ('d, 'k) session -> int -> unit
+
+(** Returns the events recorded in the trace of the session, oldest first.
+    The array is empty if tracing is disabled. See {!set_tracing}. *)
+val get_trace : ('d, 'k) session -> Sundials.Trace.event array
+
 (** Returns the sizes of the real and integer workspaces.
 
     @kinsol <node5#sss:output_main> KINGetWorkSpace
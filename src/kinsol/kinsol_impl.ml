@@ -128,6 +128,7 @@ type ('a, 'k) session = {
 
   mutable neqs       : int;    (* only valid for 'kind = serial *)
   mutable exn_temp   : exn option;
+  argcache           : Sundials_impl.arg_cache;
 
   mutable sysfn      : 'a sysfn;
   mutable errh       : errh;
@@ -162,6 +163,7 @@ and ('a, 'kind) linsolv_callbacks =
 and 'a linsolv_precfns =
   | NoPrecFns
   | PrecFns of 'a SpilsTypes'.precfns
+  | NativePrecFns of 'a SpilsTypes'.precfns * LSI.Iterative.native_cptr
   | BBDPrecFns of 'a KinsolBbdParamTypes.precfns
 
 (* Linear solver check functions *)
@@ -206,18 +206,23 @@ static int sysfn(N_Vector uu, N_Vector val, void *user_data)
     // not be retained by closure_rhsfn! If it wants a permanent copy, then
     // it has to make it manually.
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callback2_exn(KINSOL_SYSFN_FROM_ML (session), vuu, vval);
+    SUNML_PROFILE_END(SUNML_PROFILE_RHS);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
-static value make_prec_solve_arg(N_Vector uscale, N_Vector fscale)
+static value make_prec_solve_arg(value session,
+				 N_Vector uscale, N_Vector fscale)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_KINSOL_SPILS_PREC_SOLVE_ARG_SIZE);
+    r = sunml_argcache_block(KINSOL_ARGCACHE_FROM_ML(session),
+			     KINSOL_ARGCACHE_PREC_SOLVE_ARG,
+			     RECORD_KINSOL_SPILS_PREC_SOLVE_ARG_SIZE);
     Store_field(r, RECORD_KINSOL_SPILS_PREC_SOLVE_ARG_USCALE,
 	        NVEC_BACKLINK(uscale));
     Store_field(r, RECORD_KINSOL_SPILS_PREC_SOLVE_ARG_FSCALE,
@@ -226,12 +231,17 @@ static value make_prec_solve_arg(N_Vector uscale, N_Vector fscale)
     CAMLreturn(r);
 }
 
-value sunml_kinsol_make_jac_arg(N_Vector u, N_Vector fu, value tmp)
+/* The argument records are cached in the session and updated in place
+   (see sunml_argcache_block).  */
+value sunml_kinsol_make_jac_arg(value session, N_Vector u, N_Vector fu,
+				value tmp)
 {
-    CAMLparam1(tmp);
+    CAMLparam2(session, tmp);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(RECORD_KINSOL_JACOBIAN_ARG_SIZE);
+    r = sunml_argcache_block(KINSOL_ARGCACHE_FROM_ML(session),
+			     KINSOL_ARGCACHE_JAC_ARG,
+			     RECORD_KINSOL_JACOBIAN_ARG_SIZE);
     Store_field(r, RECORD_KINSOL_JACOBIAN_ARG_JAC_U, NVEC_BACKLINK(u));
     Store_field(r, RECORD_KINSOL_JACOBIAN_ARG_JAC_FU, NVEC_BACKLINK(fu));
     Store_field(r, RECORD_KINSOL_JACOBIAN_ARG_JAC_TMP, tmp);
@@ -239,12 +249,14 @@ value sunml_kinsol_make_jac_arg(N_Vector u, N_Vector fu, value tmp)
     CAMLreturn(r);
 }
 
-value sunml_kinsol_make_double_tmp(N_Vector tmp1, N_Vector tmp2)
+value sunml_kinsol_make_double_tmp(value session,
+				   N_Vector tmp1, N_Vector tmp2)
 {
-    CAMLparam0();
+    CAMLparam1(session);
     CAMLlocal1(r);
 
-    r = caml_alloc_tuple(2);
+    r = sunml_argcache_block(KINSOL_ARGCACHE_FROM_ML(session),
+			     KINSOL_ARGCACHE_DOUBLE_TMP, 2);
     Store_field(r, 0, NVEC_BACKLINK(tmp1));
     Store_field(r, 1, NVEC_BACKLINK(tmp2));
     CAMLreturn(r);
@@ -267,11 +279,14 @@ static int jacfn(
     cb = KINSOL_LS_CALLBACKS_FROM_ML(session);
     cb = Field (cb, 0);
 
-    args[0] = sunml_kinsol_make_jac_arg(u, fu, sunml_kinsol_make_double_tmp(tmp1, tmp2));
+    args[0] = sunml_kinsol_make_double_tmp(session, tmp1, tmp2);
+    args[0] = sunml_kinsol_make_jac_arg(session, u, fu, args[0]);
     args[1] = MAT_BACKLINK(Jac);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, UNRECOVERABLE));
 }
@@ -301,11 +316,14 @@ static int jacfn(
 	Store_field(cb, 1, dmat);
     }
 
-    args[0] = sunml_kinsol_make_jac_arg(u, fu, sunml_kinsol_make_double_tmp(tmp1, tmp2));
+    args[0] = sunml_kinsol_make_double_tmp(session, tmp1, tmp2);
+    args[0] = sunml_kinsol_make_jac_arg(session, u, fu, args[0]);
     args[1] = Some_val(dmat);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, UNRECOVERABLE));
 }
@@ -335,11 +353,14 @@ static int bandjacfn(
 	Store_field(cb, 1, bmat);
     }
 
-    args[0] = sunml_kinsol_make_jac_arg(u, fu, sunml_kinsol_make_double_tmp(tmp1, tmp2));
+    args[0] = sunml_kinsol_make_double_tmp(session, tmp1, tmp2);
+    args[0] = sunml_kinsol_make_jac_arg(session, u, fu, args[0]);
     args[1] = Some_val(bmat);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (Field(cb, 0), 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC);
 
     CAMLreturnT(int, CHECK_EXCEPTION(session, r, UNRECOVERABLE));
 }
@@ -362,17 +383,20 @@ static int precsetupfn(
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 2);
 
-    args[0] = sunml_kinsol_make_jac_arg(uu, fu, Val_unit);
-    args[1] = make_prec_solve_arg(uscale, fscale);
-
     WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_kinsol_make_jac_arg(session, uu, fu, Val_unit);
+    args[1] = make_prec_solve_arg(session, uscale, fscale);
+
     cb = KINSOL_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_KINSOL_SPILS_PRECFNS_PREC_SETUP_FN);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 2, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SETUP);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
@@ -394,21 +418,53 @@ static int precsolvefn(
     CAMLlocal2(session, cb);
     CAMLlocalN(args, 3);
 
-    args[0] = sunml_kinsol_make_jac_arg(uu, fu, Val_unit);
-    args[1] = make_prec_solve_arg(uscale, fscale);
+    WEAK_DEREF (session, *(value*)user_data);
+
+    args[0] = sunml_kinsol_make_jac_arg(session, uu, fu, Val_unit);
+    args[1] = make_prec_solve_arg(session, uscale, fscale);
     args[2] = NVEC_BACKLINK(vv);
 
-    WEAK_DEREF (session, *(value*)user_data);
     cb = KINSOL_LS_PRECFNS_FROM_ML (session);
     cb = Field (cb, 0);
     cb = Field (cb, RECORD_KINSOL_SPILS_PRECFNS_PREC_SOLVE_FN);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn(cb, 3, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
 
     CAMLreturnT(int, CHECK_EXCEPTION (session, r, RECOVERABLE));
 }
 
+/* Native preconditioners (Kinsol.Spils.Native): the setup function is the
+   OCaml one (see precsetupfn), but the solve, in place, stays in C. */
+static int native_precsolvefn(
+	N_Vector uu,
+	N_Vector uscale,
+	N_Vector fu,
+	N_Vector fscale,
+	N_Vector vv,
+	void *user_data
+#if SUNDIALS_LIB_VERSION < 300
+	,
+	N_Vector tmp
+#endif
+	)
+{
+    CAMLparam0();
+    CAMLlocal2(session, cb);
+
+    WEAK_DEREF (session, *(value*)user_data);
+
+    cb = KINSOL_LS_PRECFNS_FROM_ML (session);
+
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
+    int r = sunml_lsolver_native_prec_solve(Field(cb, 1), vv, vv);
+    SUNML_PROFILE_END(SUNML_PROFILE_PREC_SOLVE);
+
+    CAMLreturnT(int, r);
+}
+
 static int jactimesfn(
 	N_Vector v,
 	N_Vector Jv,
@@ -430,8 +486,10 @@ static int jactimesfn(
     cb = Field (cb, 0);
     cb = Some_val (cb);
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(session));
     /* NB: Don't trigger GC while processing this return value!  */
     value r = caml_callbackN_exn (cb, 4, args);
+    SUNML_PROFILE_END(SUNML_PROFILE_JAC_TIMES);
 
     if (!Is_exception_result (r)) {
 	*new_uu = Bool_val (r);
@@ -583,6 +641,23 @@ CAMLprim value sunml_kinsol_spils_set_linear_solver (value vkin_mem, value vlsol
     CAMLreturn (Val_unit);
 }
 
+CAMLprim value sunml_kinsol_spils_set_native_preconditioner (value vsession)
+{
+    CAMLparam1 (vsession);
+    void *mem = KINSOL_MEM_FROM_ML (vsession);
+
+#if 400 <= SUNDIALS_LIB_VERSION
+    int flag = KINSetPreconditioner (mem, precsetupfn, native_precsolvefn);
+    CHECK_LS_FLAG ("KINSetPreconditioner", flag);
+#else
+    int flag = KINSpilsSetPreconditioner (mem, precsetupfn,
+					  native_precsolvefn);
+    CHECK_SPILS_FLAG ("KINSpilsSetPreconditioner", flag);
+#endif
+
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_kinsol_spils_set_preconditioner (value vsession,
 						  value vset_precsetup)
 {
@@ -747,7 +822,15 @@ CAMLprim value sunml_kinsol_solve(value vdata, value vu, value vstrategy,
 	break;
     }
 
+    SUNML_PROFILE_BEGIN(KINSOL_ARGCACHE_FROM_ML(vdata));
     flag = KINSol(KINSOL_MEM_FROM_ML(vdata), u, strategy, uscale, fscale);
+    SUNML_PROFILE_END(SUNML_PROFILE_SOLVER);
+    if (sunml_trace_enabled(sunml_profile)) {
+	long int nni;
+	if (KINGetNumNonlinSolvIters(KINSOL_MEM_FROM_ML(vdata), &nni)
+		== KIN_SUCCESS)
+	    sunml_trace_counter(sunml_profile, SUNML_TRACE_NONLIN_ITERS, nni);
+    }
     CHECK_FLAG("KINSol", flag);
 
     switch (flag) {
@@ -797,7 +880,7 @@ static value sunml_kinsol_last_lin_exception(void *kin_mem)
 
 void sunml_kinsol_check_flag(const char *call, int flag, void *kin_mem)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == KIN_SUCCESS
 	|| flag == KIN_INITIAL_GUESS_OK
@@ -862,7 +945,7 @@ void sunml_kinsol_check_flag(const char *call, int flag, void *kin_mem)
 #if 400 <= SUNDIALS_LIB_VERSION
 void sunml_kinsol_check_ls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == KINLS_SUCCESS) return;
 
@@ -886,7 +969,7 @@ void sunml_kinsol_check_ls_flag(const char *call, int flag)
 #else
 void sunml_kinsol_check_dls_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == KINDLS_SUCCESS) return;
 
@@ -911,7 +994,7 @@ void sunml_kinsol_check_dls_flag(const char *call, int flag)
 
 void sunml_kinsol_check_spils_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == KINSPILS_SUCCESS) return;
 
@@ -1444,6 +1527,17 @@ CAMLprim value sunml_kinsol_get_num_func_evals(value vkin_mem)
     CAMLreturn(Val_long(v));
 }
 
+/* The _unboxed and _untagged variants of the getters are the entry
+ * points of their [@@noalloc] externals in native code (see kinsol.ml).
+ * They ignore the returned flag: the only possible failure is a NULL
+ * memory pointer, which cannot occur for a live session.  */
+CAMLprim intnat sunml_kinsol_get_num_func_evals_untagged(value vkin_mem)
+{
+    long int v = 0;
+    KINGetNumFuncEvals(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_kinsol_get_num_nonlin_solv_iters(value vkin_mem)
 {
     CAMLparam1(vkin_mem);
@@ -1457,6 +1551,13 @@ CAMLprim value sunml_kinsol_get_num_nonlin_solv_iters(value vkin_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_kinsol_get_num_nonlin_solv_iters_untagged(value vkin_mem)
+{
+    long int v = 0;
+    KINGetNumNonlinSolvIters(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_kinsol_get_num_beta_cond_fails(value vkin_mem)
 {
     CAMLparam1(vkin_mem);
@@ -1470,6 +1571,13 @@ CAMLprim value sunml_kinsol_get_num_beta_cond_fails(value vkin_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_kinsol_get_num_beta_cond_fails_untagged(value vkin_mem)
+{
+    long int v = 0;
+    KINGetNumBetaCondFails(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_kinsol_get_num_backtrack_ops(value vkin_mem)
 {
     CAMLparam1(vkin_mem);
@@ -1483,6 +1591,13 @@ CAMLprim value sunml_kinsol_get_num_backtrack_ops(value vkin_mem)
     CAMLreturn(Val_long(v));
 }
 
+CAMLprim intnat sunml_kinsol_get_num_backtrack_ops_untagged(value vkin_mem)
+{
+    long int v = 0;
+    KINGetNumBacktrackOps(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_kinsol_get_func_norm(value vkin_mem)
 {
     CAMLparam1(vkin_mem);
@@ -1496,6 +1611,13 @@ CAMLprim value sunml_kinsol_get_func_norm(value vkin_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_kinsol_get_func_norm_unboxed(value vkin_mem)
+{
+    realtype v = 0.0;
+    KINGetFuncNorm(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
 CAMLprim value sunml_kinsol_get_step_length(value vkin_mem)
 {
     CAMLparam1(vkin_mem);
@@ -1509,3 +1631,10 @@ CAMLprim value sunml_kinsol_get_step_length(value vkin_mem)
     CAMLreturn(caml_copy_double(v));
 }
 
+CAMLprim double sunml_kinsol_get_step_length_unboxed(value vkin_mem)
+{
+    realtype v = 0.0;
+    KINGetStepLength(KINSOL_MEM_FROM_ML(vkin_mem), &v);
+    return v;
+}
+
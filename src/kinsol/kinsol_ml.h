@@ -26,8 +26,10 @@ void sunml_kinsol_check_dls_flag(const char *call, int flag);
 void sunml_kinsol_check_spils_flag(const char *call, int flag);
 #endif
 
-value sunml_kinsol_make_jac_arg(N_Vector u, N_Vector fu, value tmp);
-value sunml_kinsol_make_double_tmp(N_Vector tmp1, N_Vector tmp2);
+value sunml_kinsol_make_jac_arg(value session, N_Vector u, N_Vector fu,
+				value tmp);
+value sunml_kinsol_make_double_tmp(value session,
+				   N_Vector tmp1, N_Vector tmp2);
 
 #define CHECK_FLAG(call, flag) if (flag != KIN_SUCCESS) \
 				 sunml_kinsol_check_flag(call, flag, NULL)
@@ -71,6 +73,7 @@ enum kinsol_index {
     RECORD_KINSOL_SESSION_CHECKVEC,
     RECORD_KINSOL_SESSION_NEQS,
     RECORD_KINSOL_SESSION_EXN_TEMP,
+    RECORD_KINSOL_SESSION_ARGCACHE,
     RECORD_KINSOL_SESSION_SYSFN,
     RECORD_KINSOL_SESSION_ERRH,
     RECORD_KINSOL_SESSION_INFOH,
@@ -98,6 +101,15 @@ enum kinsol_bandrange_index {
     (KINSOL_MEM(Field((v), RECORD_KINSOL_SESSION_MEM)))
 #define KINSOL_BACKREF_FROM_ML(v) \
     ((value *)(Field((v), RECORD_KINSOL_SESSION_BACKREF)))
+#define KINSOL_ARGCACHE_FROM_ML(v) Field((v), RECORD_KINSOL_SESSION_ARGCACHE)
+
+/* Slots of the callback argument cache (see sunml_argcache_block).  */
+enum kinsol_argcache_index {
+  KINSOL_ARGCACHE_JAC_ARG = 0,
+  KINSOL_ARGCACHE_DOUBLE_TMP,
+  KINSOL_ARGCACHE_PREC_SOLVE_ARG,
+  KINSOL_ARGCACHE_SIZE
+};
 
 enum kinsol_spils_prec_solve_arg_index {
   RECORD_KINSOL_SPILS_PREC_SOLVE_ARG_USCALE = 0,
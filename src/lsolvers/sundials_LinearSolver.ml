@@ -126,6 +126,68 @@ module Direct = struct (* {{{ *)
       attached = false;
     }
 
+  external c_lapack_dense_mixed
+           : 'k Nvector_serial.any
+             -> 'k Matrix.dense
+             -> int
+             -> (Matrix.Dense.t, Nvector_serial.data, 'k) cptr
+    = "sunml_lsolver_lapack_dense_mixed"
+
+  let lapack_dense_mixed ?(max_refinements=10) nvec mat =
+    if in_compat_mode || not Config.lapack_enabled || Precision.single
+    then raise Config.NotImplementedBySundialsVersion;
+    if max_refinements < 0
+    then invalid_arg "max_refinements must be nonnegative";
+    LS {
+      rawptr = c_lapack_dense_mixed nvec mat max_refinements;
+      solver = LapackDense;
+      matrix = Some mat;
+      compat = LSI.Iterative.info;
+      check_prec_type = (fun _ -> true);
+      ocaml_callbacks = empty_ocaml_callbacks ();
+      attached = false;
+    }
+
+  external c_lapack_band_mixed
+           : 'k Nvector_serial.any
+             -> 'k Matrix.band
+             -> int
+             -> (Matrix.Band.t, Nvector_serial.data, 'k) cptr
+    = "sunml_lsolver_lapack_band_mixed"
+
+  let lapack_band_mixed ?(max_refinements=10) nvec mat =
+    if in_compat_mode || not Config.lapack_enabled || Precision.single
+    then raise Config.NotImplementedBySundialsVersion;
+    if max_refinements < 0
+    then invalid_arg "max_refinements must be nonnegative";
+    LS {
+      rawptr = c_lapack_band_mixed nvec mat max_refinements;
+      solver = LapackBand;
+      matrix = Some mat;
+      compat = LSI.Iterative.info;
+      check_prec_type = (fun _ -> true);
+      ocaml_callbacks = empty_ocaml_callbacks ();
+      attached = false;
+    }
+
+  external c_blockdiag
+           : 'k Nvector_serial.any
+             -> 'k Matrix.blockdiag
+             -> (Matrix.BlockDiag.t, Nvector_serial.data, 'k) cptr
+    = "sunml_lsolver_blockdiag"
+
+  let blockdiag nvec mat =
+    if in_compat_mode then raise Config.NotImplementedBySundialsVersion;
+    LS {
+      rawptr = c_blockdiag nvec mat;
+      solver = BlockDiag;
+      matrix = Some mat;
+      compat = LSI.Iterative.info;
+      check_prec_type = (fun _ -> true);
+      ocaml_callbacks = empty_ocaml_callbacks ();
+      attached = false;
+    }
+
   module Klu = struct (* {{{ *)
     include LSI.Klu
 
@@ -169,10 +231,12 @@ module Direct = struct (* {{{ *)
            f (fst (Matrix.Sparse.size smat)) nnz
         | _ -> assert false
       else begin
+          let smat = Matrix.unwrap mat in
           (match nnz with
-           | Some n -> Matrix.Sparse.resize ~nnz:n (Matrix.unwrap mat)
+           | Some n -> Matrix.Sparse.resize ~nnz:n smat
            | None -> ());
-          c_reinit cptr mat
+          (* The symbolic analysis remains valid for a frozen pattern. *)
+          if not (Matrix.Sparse.is_frozen smat) then c_reinit cptr mat
         end
 
     external c_set_ordering
@@ -236,6 +300,62 @@ module Direct = struct (* {{{ *)
         | _ -> assert false
       else c_set_ordering cptr ordering
 
+    external c_set_num_threads
+             : ('s Matrix.Sparse.t, Nvector_serial.data, 'k) cptr
+               -> int
+               -> float
+               -> unit
+      = "sunml_lsolver_superlumt_set_num_threads"
+
+    let max_num_threads = function
+      | LS { solver = Superlumt { num_threads } } -> num_threads
+      | _ -> assert false
+
+    let set_num_threads (LS { rawptr = cptr } as ls) nthreads =
+      if in_compat_mode then raise Config.NotImplementedBySundialsVersion;
+      if nthreads < 1 || nthreads > max_num_threads ls
+      then invalid_arg "Superlumt.set_num_threads";
+      c_set_num_threads cptr nthreads 0.0
+
+    let default_grain = 50000
+
+    let set_auto_num_threads ?(grain=default_grain) (LS { rawptr = cptr }) =
+      if in_compat_mode then raise Config.NotImplementedBySundialsVersion;
+      if grain < 1 then invalid_arg "Superlumt.set_auto_num_threads";
+      c_set_num_threads cptr 0 (float grain)
+
+    external c_get_num_threads
+             : ('s Matrix.Sparse.t, Nvector_serial.data, 'k) cptr -> int
+      = "sunml_lsolver_superlumt_get_num_threads"
+
+    let get_num_threads (LS { rawptr = cptr } as ls) =
+      if in_compat_mode then max_num_threads ls else c_get_num_threads cptr
+
+    module Pool = struct (* {{{ *)
+
+      external c_set_size : int -> unit
+        = "sunml_lsolver_superlumt_set_pool_size"
+
+      external size : unit -> int
+        = "sunml_lsolver_superlumt_get_pool_size"
+
+      let set_size n =
+        if in_compat_mode then raise Config.NotImplementedBySundialsVersion;
+        if n < 0 then invalid_arg "Superlumt.Pool.set_size";
+        c_set_size n
+
+      external c_set_shared
+               : ('s Matrix.Sparse.t, Nvector_serial.data, 'k) cptr
+                 -> bool
+                 -> unit
+        = "sunml_lsolver_superlumt_set_shared"
+
+      let share ?(shared=true) (LS { rawptr = cptr }) =
+        if in_compat_mode then raise Config.NotImplementedBySundialsVersion;
+        c_set_shared cptr shared
+
+    end (* }}} *)
+
   end (* }}} *)
 
   let superlumt = Superlumt.make
@@ -384,6 +504,27 @@ module Iterative = struct (* {{{ *)
       attached = false;
     }
 
+  external c_spgmr_lowsync : int -> ('d, 'k) Nvector.t -> ('m, 'nd, 'nk) cptr
+    = "sunml_lsolver_spgmr_lowsync"
+
+  let spgmr_lowsync ?maxl ?max_restarts nvec =
+    (match Config.sundials_version with
+     | 2,_,_ | 3,_,_ -> raise Config.NotImplementedBySundialsVersion;
+     | _ -> ());
+    let cptr = c_spgmr_lowsync (default maxl) nvec in
+    (match max_restarts with
+     | Some mr -> c_set_max_restarts cptr Spgmr mr
+     | _ -> ());
+    LS {
+      rawptr = cptr;
+      solver = Spgmr;
+      matrix = None;
+      compat = info;
+      check_prec_type = (fun _ -> true);
+      ocaml_callbacks = empty_ocaml_callbacks ();
+      attached = false;
+    }
+
   external c_sptfqmr : int -> ('d, 'k) Nvector.t -> ('m, 'nd, 'nk) cptr
     = "sunml_lsolver_sptfqmr"
 
@@ -477,6 +618,67 @@ module Iterative = struct (* {{{ *)
   end (* }}} *)
 end (* }}} *)
 
+module Native = struct (* {{{ *)
+  type 'm t = 'm LSI.Iterative.native
+
+  (* Must correspond with sundials_linearsolver_ml.c:native_prec_kind *)
+  type kind = Jacobi | BlockJacobi | Ilu0
+
+  external c_make : kind -> int -> int -> LSI.Iterative.native_cptr
+    = "sunml_lsolver_native_make"
+
+  external c_jacobi_factor : LSI.Iterative.native_cptr -> RealArray.t -> unit
+    = "sunml_lsolver_native_jacobi_factor"
+
+  external c_block_jacobi_factor
+    : LSI.Iterative.native_cptr -> Matrix.BlockDiag.t -> unit
+    = "sunml_lsolver_native_block_jacobi_factor"
+
+  external c_ilu0_factor
+    : LSI.Iterative.native_cptr -> 's Matrix.Sparse.t -> unit
+    = "sunml_lsolver_native_ilu0_factor"
+
+  external c_solve
+    : LSI.Iterative.native_cptr -> RealArray.t -> RealArray.t -> unit
+    = "sunml_lsolver_native_solve"
+
+  let jacobi n =
+    if n < 0 then invalid_arg "Native.jacobi: negative size";
+    let cptr = c_make Jacobi n 0 in
+    let d = RealArray.make n 1.0 in
+    LSI.Iterative.{ native_cptr = cptr;
+                    native_matrix = d;
+                    native_size = n;
+                    native_factor = (fun () -> c_jacobi_factor cptr d) }
+
+  let block_jacobi nblocks bsize =
+    let bd = Matrix.BlockDiag.create nblocks bsize in
+    let n = nblocks * bsize in
+    let cptr = c_make BlockJacobi n bsize in
+    LSI.Iterative.{ native_cptr = cptr;
+                    native_matrix = bd;
+                    native_size = n;
+                    native_factor =
+                      (fun () -> c_block_jacobi_factor cptr bd) }
+
+  let ilu0 a =
+    let m, n = Matrix.Sparse.size a in
+    if m <> n then invalid_arg "Native.ilu0: matrix is not square";
+    let cptr = c_make Ilu0 n 0 in
+    LSI.Iterative.{ native_cptr = cptr;
+                    native_matrix = a;
+                    native_size = n;
+                    native_factor = (fun () -> c_ilu0_factor cptr a) }
+
+  let matrix { LSI.Iterative.native_matrix } = native_matrix
+
+  let size { LSI.Iterative.native_size } = native_size
+
+  let factor { LSI.Iterative.native_factor } = native_factor ()
+
+  let solve { LSI.Iterative.native_cptr } r z = c_solve native_cptr r z
+end (* }}} *)
+
 module Custom = struct (* {{{ *)
 
   type ('d, 'k) atimesfn =
@@ -133,6 +133,72 @@ module Direct : sig (* {{{ *)
     -> 'k Matrix.band
     -> (Matrix.Band.t, 'k, [`Dls]) serial_t
 
+  (** Creates a mixed-precision direct linear solver on dense matrices.
+      Its setup factors a single-precision copy of the matrix using LAPACK
+      ([sgetrf]), and its solve refines the single-precision solution
+      against the double-precision matrix, for at most [max_refinements]
+      steps (default: 10), until the residual is negligible. This roughly
+      halves the cost of the factorization, at the price of an extra copy
+      of the matrix and a few matrix-vector products per solve. The
+      refinement converges if the matrix is well enough conditioned, i.e.,
+      if its condition number is well below $10^7$. If the residual is not
+      negligible after [max_refinements] steps, or if it stops decreasing,
+      the matrix is factored again in double precision and that
+      factorization is used until the next setup. The same happens at
+      setup when the single-precision factorization fails, because an
+      element of the matrix is out of range or the copy is singular; the
+      setup only fails if the double-precision factorization fails too.
+      With [max_refinements = 0], the single-precision solution is
+      accepted as is. See {!dense}.
+
+      NB: This feature is only available for
+          {{!Sundials_Config.sundials_version}Config.sundials_version} >= 3.0.0,
+          in double precision, and if
+          {{!Sundials_Config.lapack_enabled}Config.lapack_enabled}.
+
+      @raise MatrixNotSquare The matrix is not square
+      @raise MatrixVectorMismatch Matrix and vector sizes are incompatible *)
+  val lapack_dense_mixed :
+    ?max_refinements:int
+    -> 'k Nvector_serial.any
+    -> 'k Matrix.dense
+    -> (Matrix.Dense.t, 'k, [`Dls]) serial_t
+
+  (** Creates a mixed-precision direct linear solver on banded matrices,
+      which factors a single-precision copy of the matrix using LAPACK
+      ([sgbtrf]). See {!lapack_dense_mixed} and {!band}. The bandwidths
+      of the matrix must not change.
+
+      NB: This feature is only available for
+          {{!Sundials_Config.sundials_version}Config.sundials_version} >= 3.0.0,
+          in double precision, and if
+          {{!Sundials_Config.lapack_enabled}Config.lapack_enabled}.
+
+      @raise MatrixNotSquare The matrix is not square
+      @raise MatrixVectorMismatch Matrix and vector sizes are incompatible *)
+  val lapack_band_mixed :
+    ?max_refinements:int
+    -> 'k Nvector_serial.any
+    -> 'k Matrix.band
+    -> (Matrix.Band.t, 'k, [`Dls]) serial_t
+
+  (** Creates a direct linear solver on block-diagonal matrices. Its setup
+      factors the blocks in place, and its solve substitutes block by block,
+      both in C without calling back into OCaml and in parallel when the
+      library is compiled with OpenMP (see {!Sundials_Matrix.BlockDiag}).
+      Since Sundials cannot approximate the Jacobian of such matrices, a
+      Jacobian function must be given when the solver is attached to a
+      session.
+
+      NB: This feature is only available for
+          {{!Sundials_Config.sundials_version}Config.sundials_version} >= 3.0.0.
+
+      @raise MatrixVectorMismatch Matrix and vector sizes are incompatible *)
+  val blockdiag :
+    'k Nvector_serial.any
+    -> 'k Matrix.blockdiag
+    -> (Matrix.BlockDiag.t, 'k, [`Dls]) serial_t
+
   (** KLU direct linear solver operating on sparse matrices (requires KLU). *)
   module Klu : sig (* {{{ *)
 
@@ -161,7 +227,10 @@ module Direct : sig (* {{{ *)
       numeric) at the next solver setup call. In the call [reinit ls a nnz],
       [a] is the Jacobian matrix, which is reinitialized with the given
       number of non-zeros if [nnz] if given. New symbolic and numeric
-      factorizations will be completed at the next solver step.
+      factorizations will be completed at the next solver step. If the
+      pattern of [a] is {{!Sundials_Matrix.Sparse.freeze_pattern}frozen},
+      the symbolic factorization is kept and only a numeric refactorization
+      is performed.
 
       @nocvode <node> SUNLinSol_KLUReInit *)
     val reinit : ('s Matrix.Sparse.t, 'k, [>`Klu]) serial_t
@@ -223,6 +292,89 @@ module Direct : sig (* {{{ *)
     val set_ordering : ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t
                        -> ordering -> unit
 
+    (** {3:threads Thread count}
+
+      The [nthreads] argument of {!make} is an upper bound: it sizes the
+      solver's internal statistics. The count actually used can be lowered
+      (or raised again up to that bound) between factorizations, so that
+      small refactorizations do not oversubscribe the cores. *)
+
+    (** Returns the [nthreads] value passed to {!make}. *)
+    val max_num_threads : ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t -> int
+
+    (** Sets the number of threads used by subsequent factorizations. It
+      must lie between [1] and {!max_num_threads}.
+
+      @raise Invalid_argument The count is out of range.
+      @raise Config.NotImplementedBySundialsVersion Not available in
+             compatibility mode. *)
+    val set_num_threads : ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t
+                          -> int -> unit
+
+    (** The default value of the [grain] argument of
+        {!set_auto_num_threads}. *)
+    val default_grain : int
+
+    (** Chooses the number of threads before each factorization. The work
+      is estimated as the number of nonzeros in the Jacobian times the
+      fill ratio, {% $(\mathit{nnz}(L) + \mathit{nnz}(U))/\mathit{nnz}(A)$ %},
+      observed in the previous factorization (initially [4]), and one
+      thread is used per [grain] nonzeros (default: {!default_grain}), up
+      to {!max_num_threads}. A subsequent {!set_num_threads} returns to a
+      fixed count.
+
+      @raise Invalid_argument [grain] is not positive.
+      @raise Config.NotImplementedBySundialsVersion Not available in
+             compatibility mode. *)
+    val set_auto_num_threads : ?grain:int
+                               -> ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t
+                               -> unit
+
+    (** Returns the number of threads used by the last factorization, or
+      the count that the first factorization will use if it is fixed. *)
+    val get_num_threads : ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t -> int
+
+    (** A process-wide budget of factorization threads shared by SuperLUMT
+      solvers.
+
+      SuperLUMT starts and joins its worker threads within each
+      factorization, so rather than keeping threads alive, the pool bounds
+      the number of threads that the solvers that {!share} it use at the
+      same time. A solver takes the threads it would otherwise use, or
+      those that remain, before factoring and returns them afterward.
+      The calling thread always participates, so a factorization proceeds
+      with one thread when the budget is exhausted.
+
+      The pool is only a budget: it limits factorizations that run at the
+      same time and never starts or keeps threads itself. Since solvers on
+      sparse matrices factor while holding the OCaml runtime lock, two
+      factorizations never overlap under OCaml 4.x and the pool then never
+      limits anything. *)
+    module Pool : sig (* {{{ *)
+
+      (** Sets the number of threads in the pool. The value [0], the
+          default, imposes no limit.
+
+          @raise Invalid_argument The size is negative.
+          @raise Config.NotImplementedBySundialsVersion Not available in
+                 compatibility mode. *)
+      val set_size : int -> unit
+
+      (** Returns the number of threads in the pool ([0] for no limit). *)
+      val size : unit -> int
+
+      (** Sets whether a solver draws its threads from the pool
+          (default: [true] when calling this function, [false] for newly
+          created solvers).
+
+          @raise Config.NotImplementedBySundialsVersion Not available in
+                 compatibility mode. *)
+      val share : ?shared:bool
+                  -> ('s Matrix.Sparse.t, 'k, [>`Slu]) serial_t
+                  -> unit
+
+    end (* }}} *)
+
   end (* }}} *)
 
   (** Creates a direct linear solver on sparse matrices using SuperLUMT.
@@ -302,6 +454,22 @@ module Iterative : sig (* {{{ *)
               -> ('d, 'k) Nvector.t
               -> ('m, 'd, 'k, [`Iter|`Spgmr]) t
 
+  (** Krylov iterative solver using the GMRES method, like {!spgmr}, but
+    with a low-synchronization orthogonalization: at each iteration, the
+    inner products of the new vector against all the previous basis vectors
+    are batched, together with its norm, into a single
+    [N_VDotProdMulti], so that a parallel nvector with fused operations
+    needs one global reduction per iteration rather than one per basis
+    vector. A second pass is made when the new vector is nearly in the span
+    of the basis. The other options behave as for {!spgmr}, except that
+    {!set_gs_type} has no effect.
+
+    @raise Config.NotImplementedBySundialsVersion Requires sundials >= 4.0.0.
+    @nocvode <node> SUNLinSol_SPGMR *)
+  val spgmr_lowsync : ?maxl:int -> ?max_restarts:int
+                      -> ('d, 'k) Nvector.t
+                      -> ('m, 'd, 'k, [`Iter|`Spgmr]) t
+
   (** Krylov iterative with the scaled preconditioned transpose-free
     quasi-minimal residual (SPTFQMR) method. The [maxl] arguments gives the
     maximum dimension of the Krylov subspace (defaults to 5). The nvector
@@ -472,6 +640,51 @@ module Iterative : sig (* {{{ *)
 
 end (* }}} *)
 
+(** Preconditioners that are applied entirely in C.
+
+  A native preconditioner holds a matrix {% $P$ %} that the preconditioner
+  setup function of a session fills (see, for instance,
+  {!Cvode.Spils.Native}); it is then factored and the Krylov iterations
+  solve {% $Pz = r$ %} without calling back into OCaml. The same
+  {% $P$ %} is used for left and right preconditioning. Only serial
+  nvectors are supported. *)
+module Native : sig (* {{{ *)
+
+  (** A native preconditioner whose setup fills a matrix of type ['m]. *)
+  type 'm t = 'm Sundials_LinearSolver_impl.Iterative.native
+
+  (** Diagonal (Jacobi) preconditioning: [jacobi n] holds the [n]
+      diagonal elements of {% $P$ %}, initially all one. *)
+  val jacobi : int -> RealArray.t t
+
+  (** Block-Jacobi preconditioning: [block_jacobi nblocks bsize] holds
+      the dense diagonal blocks of {% $P$ %}, which are LU factored with
+      partial pivoting. *)
+  val block_jacobi : int -> int -> Matrix.BlockDiag.t t
+
+  (** Incomplete LU factorization without fill-in. The given sparse
+      matrix, which is filled by the setup function, fixes the sparsity
+      pattern of the factors; its pattern may nevertheless change between
+      setups. Every row must contain a diagonal element. *)
+  val ilu0 : 's Matrix.Sparse.t -> 's Matrix.Sparse.t t
+
+  (** The matrix that the setup function must fill. *)
+  val matrix : 'm t -> 'm
+
+  (** The number of equations. *)
+  val size : 'm t -> int
+
+  (** Factors the current contents of the matrix. This is done
+      automatically after each call to the setup function of a session.
+
+      @raise Sundials.RecoverableFailure A zero pivot was encountered. *)
+  val factor : 'm t -> unit
+
+  (** [solve p r z] computes {% $z = P^{-1}r$ %} with the last
+      factorization. The arrays [r] and [z] may be the same. *)
+  val solve : 'm t -> RealArray.t -> RealArray.t -> unit
+end (* }}} *)
+
 (** Custom linear solvers. *)
 module Custom : sig (* {{{ *)
 
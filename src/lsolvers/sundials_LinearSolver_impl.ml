@@ -111,6 +111,18 @@ module Iterative = struct (* {{{ *)
     set_prec_type    = (fun _ -> ());
   }
 
+  (* A preconditioner applied entirely in C (see the Native preconditioners
+     section of sundials_linearsolver_ml.c). The setup function of a session
+     fills native_matrix, then native_factor factors it into native_cptr. *)
+  type native_cptr
+
+  type 'm native = {
+    native_cptr   : native_cptr;
+    native_matrix : 'm;
+    native_size   : int;
+    native_factor : unit -> unit;
+  }
+
 end (* }}} *)
 
 module Custom = struct (* {{{ *)
@@ -194,6 +206,7 @@ type ('m, 'nd, 'nk, 't) solver_data =
   | LapackDense : (Matrix.Dense.t, 'nd, 'nk, [>`Dls]) solver_data
   | Band        : (Matrix.Band.t,  'nd, 'nk, [>`Dls]) solver_data
   | LapackBand  : (Matrix.Band.t,  'nd, 'nk, [>`Dls]) solver_data
+  | BlockDiag   : (Matrix.BlockDiag.t, 'nd, 'nk, [>`Dls]) solver_data
   | Klu         : Klu.info
                   -> ('s Matrix.Sparse.t, 'nd, 'nk, [>`Klu]) solver_data
   | Superlumt   : Superlumt.info
@@ -501,16 +501,29 @@ module Sparse = struct (* {{{ *)
   external c_rewrap : 's t -> 's data
     = "sunml_matrix_sparse_rewrap"
 
+  external c_is_shared : cptr -> bool
+    = "sunml_matrix_sparse_is_shared"
+
+  (* Shared patterns are immutable (see share_pattern). *)
+  let check_unshared name rawptr =
+    if c_is_shared rawptr
+    then invalid_arg ("Matrix.Sparse." ^ name ^ ": shared pattern")
+
   let unwrap ({ payload; rawptr } as m) =
+    check_unshared "unwrap" rawptr;
     let { idxvals; idxptrs; data } =
       if unsafe_content then c_rewrap m else payload
     in
     idxvals, idxptrs, data
 
+  let unwrap_data ({ payload } as m) =
+    (if unsafe_content then c_rewrap m else payload).data
+
   external c_resize : 's t -> int -> bool -> unit
     = "sunml_matrix_sparse_resize"
 
   let resize ?nnz a =
+    check_unshared "resize" a.rawptr;
     let nnz = match nnz with Some x -> x | None -> 0 in
     c_resize a nnz true
 
@@ -539,6 +552,7 @@ module Sparse = struct (* {{{ *)
 
   let set_col { payload = { idxptrs }; rawptr; valid } j idx =
     if check_valid && not valid then raise Invalidated;
+    check_unshared "set_col" rawptr;
     if unsafe_content then c_set_idx rawptr j idx
     else idxptrs.{j} <- Index.of_int idx
 
@@ -564,6 +578,7 @@ module Sparse = struct (* {{{ *)
 
   let set { payload = { idxvals; data }; rawptr; valid } idx i v =
     if check_valid && not valid then raise Invalidated;
+    check_unshared "set" rawptr;
     if unsafe_content then (c_set_val rawptr idx i; c_set_data rawptr idx v)
     else (idxvals.{idx} <- Index.of_int i; data.{idx} <- v)
 
@@ -574,6 +589,7 @@ module Sparse = struct (* {{{ *)
 
   let set_rowval { payload = { idxvals }; rawptr; valid } idx i =
     if check_valid && not valid then raise Invalidated;
+    check_unshared "set_rowval" rawptr;
     if unsafe_content then c_set_val rawptr idx i
     else idxvals.{idx} <- Index.of_int i
 
@@ -596,6 +612,77 @@ module Sparse = struct (* {{{ *)
     if unsafe_content then c_get_data rawptr idx
     else data.{idx}
 
+  type pattern_cptr
+
+  type 's pattern = {
+    pformat : 's sformat;
+    pcptr : pattern_cptr;
+  }
+
+  external c_make_pattern
+    : 's sformat -> int -> int -> index_array -> index_array -> pattern_cptr
+    = "sunml_matrix_sparse_make_pattern"
+
+  external c_pattern_nnz : pattern_cptr -> int
+    = "sunml_matrix_sparse_pattern_nnz"
+
+  external c_assemble : pattern_cptr -> RealArray.t -> 's t -> unit
+    = "sunml_matrix_sparse_assemble"
+
+  let make_pattern (type s) (sformat : s sformat) m n rows cols =
+    if Sundials_configuration.safe then
+      (match Config.sundials_version, sformat with
+       | (2,v,_), _ when v < 6 ->
+           raise Config.NotImplementedBySundialsVersion
+       | (2,v,_), CSR when v < 7 ->
+           raise Config.NotImplementedBySundialsVersion
+       | _ -> ());
+    { pformat = sformat; pcptr = c_make_pattern sformat m n rows cols }
+
+  let pattern_nnz { pcptr } = c_pattern_nnz pcptr
+
+  let assemble ({ valid } as a) { pcptr } vals =
+    if check_valid && not valid then raise Invalidated;
+    c_assemble pcptr vals a
+
+  let from_triplets sformat m n rows cols vals =
+    let p = make_pattern sformat m n rows cols in
+    let a = make sformat m n (max 1 (pattern_nnz p)) in
+    assemble a p vals;
+    a, p
+
+  external c_set_frozen : cptr -> bool -> unit
+    = "sunml_matrix_sparse_set_frozen"
+
+  external c_is_frozen : cptr -> bool
+    = "sunml_matrix_sparse_is_frozen"
+
+  let freeze_pattern { rawptr; valid } =
+    if check_valid && not valid then raise Invalidated;
+    if Sundials_configuration.safe && unsafe_content
+    then raise Config.NotImplementedBySundialsVersion;
+    c_set_frozen rawptr true
+
+  let thaw_pattern { rawptr; valid } =
+    if check_valid && not valid then raise Invalidated;
+    c_set_frozen rawptr false
+
+  let is_frozen { rawptr; valid } =
+    if check_valid && not valid then raise Invalidated;
+    c_is_frozen rawptr
+
+  external c_share_pattern : 's t -> 's t
+    = "sunml_matrix_sparse_share_pattern"
+
+  let share_pattern ({ valid } as a) =
+    if check_valid && not valid then raise Invalidated;
+    if unsafe_content then raise Config.NotImplementedBySundialsVersion;
+    c_share_pattern a
+
+  let is_shared { rawptr; valid } =
+    if check_valid && not valid then raise Invalidated;
+    c_is_shared rawptr
+
   let pp (type s) fmt (mat : s t) =
     if check_valid && not mat.valid then raise Invalidated;
     let m, n = size mat in
@@ -704,6 +791,7 @@ module Sparse = struct (* {{{ *)
   let set_to_zero { payload = { idxvals; idxptrs; data }; rawptr; valid } =
     if check_valid && not valid then raise Invalidated;
     if unsafe_content then c_set_to_zero rawptr
+    else if c_is_frozen rawptr then Bigarray.Array1.fill data 0.0
     else (Bigarray.Array1.fill idxvals Index.zero;
           Bigarray.Array1.fill idxptrs Index.zero;
           Bigarray.Array1.fill data 0.0)
@@ -751,6 +839,177 @@ module Sparse = struct (* {{{ *)
   }
 end (* }}} *)
 
+module Coloring = struct (* {{{ *)
+  type cptr
+
+  type 'm t = {
+    cptr   : cptr;
+    ncols  : int;
+    nrows  : int;
+    ncolors : int;
+    ypert  : RealArray.t;
+    fpert  : RealArray.t;
+    mutable yppert : RealArray.t option;
+  }
+
+  external c_sparse : 's Sparse.t -> float -> cptr
+    = "sunml_matrix_coloring_sparse"
+
+  external c_band : Band.t -> float -> cptr
+    = "sunml_matrix_coloring_band"
+
+  external c_num_colors : cptr -> int
+    = "sunml_matrix_coloring_num_colors"
+
+  external c_prepare : cptr -> 'm -> unit
+    = "sunml_matrix_coloring_prepare"
+
+  external c_perturb : cptr -> int -> RealArray.t -> RealArray.t -> unit
+    = "sunml_matrix_coloring_perturb"
+
+  external c_perturb_derivative
+    : cptr -> float -> RealArray.t -> RealArray.t -> unit
+    = "sunml_matrix_coloring_perturb_derivative"
+
+  external c_scatter
+    : cptr -> int -> RealArray.t -> RealArray.t -> 'm -> unit
+    = "sunml_matrix_coloring_scatter"
+
+  let default_relinc () = sqrt Config.unit_roundoff
+
+  let make cptr nrows ncols = {
+      cptr;
+      ncols;
+      nrows;
+      ncolors = c_num_colors cptr;
+      ypert = RealArray.create ncols;
+      fpert = RealArray.create nrows;
+      yppert = None;
+    }
+
+  let sparse ?relinc ({ valid } as a) =
+    if check_valid && not valid then raise Invalidated;
+    if Sundials_configuration.safe then
+      (match Config.sundials_version with
+       | (2,v,_) when v < 6 -> raise Config.NotImplementedBySundialsVersion
+       | _ -> ());
+    let relinc = match relinc with Some r -> r | None -> default_relinc () in
+    let m, n = Sparse.size a in
+    make (c_sparse a relinc) m n
+
+  let band ?relinc ({ valid } as a) =
+    if check_valid && not valid then raise Invalidated;
+    let relinc = match relinc with Some r -> r | None -> default_relinc () in
+    let m, n = Band.size a in
+    make (c_band a relinc) m n
+
+  let num_colors { ncolors } = ncolors
+
+  let check_lengths { ncols; nrows } y fy =
+    if Sundials_configuration.safe
+       && (RealArray.length y <> ncols || RealArray.length fy <> nrows)
+    then invalid_arg "Matrix.Coloring.jacobian: vector length"
+
+  let jacobian ({ cptr; ncolors; ypert; fpert } as c) f y fy a =
+    check_lengths c y fy;
+    c_prepare cptr a;
+    for k = 0 to ncolors - 1 do
+      c_perturb cptr k y ypert;
+      f ypert fpert;
+      c_scatter cptr k fy fpert a
+    done
+
+  let dae_jacobian ({ cptr; ncols; ncolors; ypert; fpert } as c) f cj y yp r a =
+    check_lengths c y r;
+    if Sundials_configuration.safe && RealArray.length yp <> ncols
+    then invalid_arg "Matrix.Coloring.dae_jacobian: vector length";
+    let yppert =
+      match c.yppert with
+      | Some yppert -> yppert
+      | None -> (let yppert = RealArray.create ncols in
+                 c.yppert <- Some yppert;
+                 yppert)
+    in
+    c_prepare cptr a;
+    for k = 0 to ncolors - 1 do
+      c_perturb cptr k y ypert;
+      c_perturb_derivative cptr cj yp yppert;
+      f ypert yppert fpert;
+      c_scatter cptr k r fpert a
+    done
+
+end (* }}} *)
+
+module Incremental = struct (* {{{ *)
+  type 'm t = {
+    unwrap : 'm -> RealArray2.data;
+    saved  : RealArray2.data;
+    dirty  : Bytes.t;           (* one nonzero byte per dirty column *)
+    mutable ndirty : int;
+    mutable empty  : bool;      (* no Jacobian has been saved yet *)
+  }
+
+  let make unwrap a =
+    let open Bigarray in
+    let d = unwrap a in
+    let ncols = Array2.dim1 d in
+    let saved = Array2.create (Array2.kind d) c_layout ncols (Array2.dim2 d) in
+    Array2.fill saved 0.0;
+    { unwrap; saved;
+      dirty  = Bytes.make ncols '\001';
+      ndirty = ncols;
+      empty  = true }
+
+  let dense ({ valid } as a) =
+    if check_valid && not valid then raise Invalidated;
+    make Dense.unwrap a
+
+  let band ({ valid } as a) =
+    if check_valid && not valid then raise Invalidated;
+    make Band.unwrap a
+
+  let mark t j =
+    if j < 0 || j >= Bytes.length t.dirty
+    then invalid_arg "Matrix.Incremental.mark: column";
+    if Bytes.get t.dirty j = '\000' then begin
+      Bytes.set t.dirty j '\001';
+      t.ndirty <- t.ndirty + 1
+    end
+
+  let mark_all t =
+    Bytes.fill t.dirty 0 (Bytes.length t.dirty) '\001';
+    t.ndirty <- Bytes.length t.dirty
+
+  let num_dirty { ndirty } = ndirty
+
+  let columns { dirty; ndirty } =
+    let cols = Array.make ndirty 0 and k = ref 0 in
+    Bytes.iteri (fun j c -> if c <> '\000' then (cols.(!k) <- j; incr k))
+                dirty;
+    cols
+
+  let jacobian t f a =
+    let open Bigarray in
+    let d = t.unwrap a in
+    if Sundials_configuration.safe
+       && (Array2.dim1 d <> Array2.dim1 t.saved
+           || Array2.dim2 d <> Array2.dim2 t.saved)
+    then invalid_arg "Matrix.Incremental.jacobian: matrix size";
+    Array2.blit t.saved d;
+    if t.ndirty > 0 then begin
+      let cols = columns t in
+      f cols a;
+      if t.empty then Array2.blit d t.saved
+      else Array.iter (fun j -> Array1.blit (Array2.slice_left d j)
+                                            (Array2.slice_left t.saved j))
+                      cols;
+      t.empty <- false;
+      Bytes.fill t.dirty 0 (Bytes.length t.dirty) '\000';
+      t.ndirty <- 0
+    end
+
+end (* }}} *)
+
 type lint_array = LintArray.t
 type real_array = RealArray.t
 
@@ -1030,6 +1289,99 @@ module ArrayBand = struct (* {{{ *)
 
 end (* }}} *)
 
+module BlockDiag = struct (* {{{ *)
+
+  type t = RealArray2.t * RealArray2.t array
+
+  (* The views share the storage of the whole array: the columns of block b
+     are the columns b * bsize to (b + 1) * bsize - 1.  *)
+  let views a nblocks bsize =
+    let d = RealArray2.unwrap a in
+    Array.init nblocks
+      (fun b -> RealArray2.wrap (Bigarray.Array2.sub_left d (b * bsize) bsize))
+
+  let check_dims nblocks bsize =
+    if nblocks < 0 || bsize < 1
+    then invalid_arg "Matrix.BlockDiag: invalid dimensions"
+
+  let create nblocks bsize =
+    check_dims nblocks bsize;
+    let a = RealArray2.create bsize (nblocks * bsize) in
+    (a, views a nblocks bsize)
+
+  let make nblocks bsize v =
+    check_dims nblocks bsize;
+    let a = RealArray2.make bsize (nblocks * bsize) v in
+    (a, views a nblocks bsize)
+
+  let dims (a, blocks) = (Array.length blocks, fst (RealArray2.size a))
+
+  let size (a, _) = let _, n = RealArray2.size a in (n, n)
+
+  let block (_, blocks) b = blocks.(b)
+
+  let get (_, blocks) b i j = RealArray2.get blocks.(b) i j
+  let set (_, blocks) b i j v = RealArray2.set blocks.(b) i j v
+
+  let update (_, blocks) b i j f =
+    let x = blocks.(b) in
+    RealArray2.set x i j (f (RealArray2.get x i j))
+
+  let unwrap (a, _) = RealArray2.unwrap a
+
+  let pp fmt (_, blocks) =
+    Format.pp_open_vbox fmt 0;
+    Array.iteri (fun b x ->
+        if b > 0 then Format.pp_print_cut fmt ();
+        RealArray2.pp fmt x) blocks;
+    Format.pp_close_box fmt ()
+
+  let set_to_zero (a, _) = RealArray2.fill a 0.0
+
+  let blit ~src:((a, _) as src) ~dst:((b, _) as dst) =
+    if Sundials_configuration.safe && dims src <> dims dst
+    then raise IncompatibleArguments;
+    RealArray2.blit ~src:a ~dst:b
+
+  external scale_add : float -> t -> t -> unit
+      = "sunml_blockdiagmatrix_scale_add"
+
+  external scale_addi : float -> t -> unit
+      = "sunml_blockdiagmatrix_scale_addi"
+
+  external matvec : t -> real_array -> real_array -> unit
+      = "sunml_blockdiagmatrix_matvec"
+
+  external getrf : t -> lint_array -> unit
+      = "sunml_blockdiagmatrix_getrf"
+
+  external getrs : t -> lint_array -> real_array -> unit
+      = "sunml_blockdiagmatrix_getrs"
+
+  let clone a = let nblocks, bsize = dims a in create nblocks bsize
+
+  let space (a, _) =
+    let m, n = RealArray2.size a in
+    (m * n, 3)
+
+  let ops = {
+    m_clone      = clone;
+
+    m_zero       = set_to_zero;
+
+    m_copy       = (fun src dst -> blit ~src ~dst);
+
+    m_scale_add  = scale_add;
+
+    m_scale_addi = scale_addi;
+
+    m_matvec     = matvec;
+
+    m_space      = space;
+  }
+
+end (* }}} *)
+
 type standard
 type custom
 
@@ -1041,6 +1393,7 @@ type (_,_,_,_) id =
   | Custom : (custom, 'm, 'nd, 'nk) id
   | ArrayDense : (custom, ArrayDense.t, RealArray.t, 'nk) id
   | ArrayBand  : (custom, ArrayBand.t, RealArray.t, 'nk) id
+  | BlockDiag  : (custom, BlockDiag.t, RealArray.t, 'nk) id
 
 type cmat
 
@@ -1065,6 +1418,8 @@ type 'nk arraydense = (custom, ArrayDense.t, RealArray.t, 'nk) t
 
 type 'nk arrayband = (custom, ArrayBand.t, RealArray.t, 'nk) t
 
+type 'nk blockdiag = (custom, BlockDiag.t, RealArray.t, 'nk) t
+
 external c_wrap : ('k, 'm, 'nd, 'nk) id -> 'content_cptr -> 'm -> cmat
   = "sunml_matrix_wrap"
 
@@ -1112,16 +1467,41 @@ let sparse_csr ?m ?nnz n =
   let nnz = match nnz with Some nnz -> nnz | None -> n / 10 in
   wrap_sparse Sparse.(make CSR m n nnz)
 
-let wrap_custom ops data = {
+type native_op =
+  | Clone     of cfun
+  | Zero      of cfun
+  | Copy      of cfun
+  | ScaleAdd  of cfun
+  | ScaleAddI of cfun
+  | Matvec    of cfun
+  | Space     of cfun
+
+(* Must correspond with matrix_ml.h:mat_matrix_ops_index *)
+let natives_of_list nops =
+  let natives = Array.make 7 None in
+  let set i f = natives.(i) <- Some f in
+  List.iter (function
+      | Clone f     -> set 0 f
+      | Zero f      -> set 1 f
+      | Copy f      -> set 2 f
+      | ScaleAdd f  -> set 3 f
+      | ScaleAddI f -> set 4 f
+      | Matvec f    -> set 5 f
+      | Space f     -> set 6 f) nops;
+  natives
+
+let no_natives = natives_of_list []
+
+let wrap_custom ?(natives=[]) ops data = {
     payload = data;
-    rawptr  = c_wrap Custom ops data;
+    rawptr  = c_wrap Custom (ops, natives_of_list natives) data;
     id      = Custom;
     mat_ops = ops;
   }
 
 let wrap_arraydense data = {
     payload = data;
-    rawptr  = c_wrap ArrayDense ArrayDense.ops data;
+    rawptr  = c_wrap ArrayDense (ArrayDense.ops, no_natives) data;
     id      = ArrayDense;
     mat_ops = ArrayDense.ops;
   }
@@ -1132,7 +1512,7 @@ let arraydense ?m ?(i=0.0) n =
 
 let wrap_arrayband data = {
     payload = data;
-    rawptr  = c_wrap ArrayBand ArrayBand.ops data;
+    rawptr  = c_wrap ArrayBand (ArrayBand.ops, no_natives) data;
     id      = ArrayBand;
     mat_ops = ArrayBand.ops;
   }
@@ -1147,6 +1527,16 @@ let arrayband ?mu ?smu ?ml ?(i=0.0) n =
   let smu = match smu with Some smu -> smu | None -> mu+ml in
   wrap_arrayband (ArrayBand.make (smu, mu, ml) n i)
 
+let wrap_blockdiag data = {
+    payload = data;
+    rawptr  = c_wrap BlockDiag (BlockDiag.ops, no_natives) data;
+    id      = BlockDiag;
+    mat_ops = BlockDiag.ops;
+  }
+
+let blockdiag ?(i=0.0) nblocks bsize =
+  wrap_blockdiag (BlockDiag.make nblocks bsize i)
+
 let get_ops { mat_ops } = mat_ops
 
 let get_id { id } = id
@@ -1222,6 +1612,7 @@ let pp (type k m nd nk) fmt ({ id; payload } : (k, m, nd, nk) t) =
   | Custom -> Format.pp_print_string fmt "<custom matrix>"
   | ArrayDense -> ArrayDense.pp fmt payload
   | ArrayBand  -> ArrayBand.pp fmt payload
+  | BlockDiag  -> BlockDiag.pp fmt payload
 
 (* Let C code know about some of the values in this module.  *)
 external c_init_module : exn array -> unit =
@@ -483,20 +483,29 @@ module Sparse : sig (* {{{ *)
             -> unit
             -> Format.formatter -> 's t -> unit
 
-  (** [set_col a j idx] sets the data index of column [j] to [idx]. *)
+  (** [set_col a j idx] sets the data index of column [j] to [idx].
+
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}. *)
   val set_col : csc t -> int -> int -> unit
 
   (** [get_col a j] returns the data index of column [j]. *)
   val get_col : csc t -> int -> int
 
-  (** [set_row a j idx] sets the data index of row [j] to [idx]. *)
+  (** [set_row a j idx] sets the data index of row [j] to [idx].
+
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}. *)
   val set_row : csr t -> int -> int -> unit
 
   (** [get_row a j] returns the data index of row [j]. *)
   val get_row : csr t -> int -> int
 
   (** [set a idx i v] sets the [idx]th row/column to [i] and its value
-      to [v]. *)
+      to [v]. Only {!set_data} and {!unwrap_data} may be used on a matrix
+      with a {{!share_pattern}shared} pattern.
+
+      @raise Invalid_argument The pattern of the matrix is shared. *)
   val set : 'f t -> int -> int -> float -> unit
 
   (** [r, v = get a idx] returns the row/column [r] and value [v] at the
@@ -522,12 +531,27 @@ module Sparse : sig (* {{{ *)
       {!scale_add}, {!scale_addi}, {!blit}, and {!resize} functions are
       used.
 
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}; use
+                              {!unwrap_data} instead.
       @nocvode <node> SM_INDEXVALS_S
       @nocvode <node> SM_INDEXPTRS_S
       @nocvode <node> SM_DATA_S
   *)
   val unwrap : 's t -> index_array * index_array * RealArray.t
 
+  (** Direct access to the values of the nonzero elements, that is, the
+      [data] array returned by {!unwrap}. Unlike {!unwrap}, this function
+      may be applied to a matrix with a {{!share_pattern}shared} pattern:
+      the values of such a matrix are its own, while the index arrays,
+      which are not returned, remain read-only.
+
+      The remarks about {!resize} and Sundials < 3.0.0 made for {!unwrap}
+      also apply here.
+
+      @nocvode <node> SM_DATA_S *)
+  val unwrap_data : 's t -> RealArray.t
+
   (** Reallocates the underlying arrays to the given number of non-zero
       elements, or otherwise to the current number of non-zero elements .
 
@@ -535,10 +559,125 @@ module Sparse : sig (* {{{ *)
       matrix argument. In this case, any previously 'unwrapped' array is no
       longer associated with the matrix storage.
 
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}.
       @nocvode <node> SUNSparseMatrix_Realloc
       @nocvode <node> SUNSparseMatrix_Reallocate *)
   val resize : ?nnz:int -> 's t -> unit
 
+  (** {3:sparse_triplets Assembly from triplets} *)
+
+  (** The positions of a list of entries, given by their row and column
+      indices (the coordinate or triplet format), in the compressed storage
+      of a sparse matrix. A pattern is computed once, and then used to
+      assemble values into matrices, for instance at each evaluation of a
+      Jacobian function whose sparsity does not change. *)
+  type 's pattern
+
+  (** [make_pattern fmt m n rows cols] sorts the entries [(rows.{k},
+      cols.{k})] of an [m] by [n] matrix into the format [fmt]. The entries
+      need not be ordered, and may be repeated. The cost is linear in the
+      number of entries and in the dimensions of the matrix.
+
+      @raise Invalid_argument The arrays have different lengths or an index
+                              is out of range. *)
+  val make_pattern : 's sformat -> int -> int -> index_array -> index_array
+                     -> 's pattern
+
+  (** Returns the number of distinct entries in a pattern, that is, the
+      number of nonzeros of the matrices assembled with it. *)
+  val pattern_nnz : 's pattern -> int
+
+  (** [assemble a p vals] replaces the contents of [a] with the matrix whose
+      entries are given by the pattern [p] and the values [vals], which
+      correspond to the [rows] and [cols] arrays passed to {!make_pattern}.
+      The values of repeated entries are summed. The operation makes a
+      single pass over [vals].
+
+      NB: This operation may replace the underlying storage of its matrix
+      argument if it is too small to contain the pattern. In this case, any
+      previously 'unwrapped' array is no longer associated with the matrix
+      storage.
+
+      @raise Invalid_argument [vals] has the wrong length, [a] the wrong
+                              size, or [a] has a {{!freeze_pattern}frozen}
+                              pattern different from [p]. *)
+  val assemble : 's t -> 's pattern -> RealArray.t -> unit
+
+  (** [a, p = from_triplets fmt m n rows cols vals] creates an [m] by [n]
+      matrix [a] from the entries [(rows.{k}, cols.{k}, vals.{k})] (see
+      {!make_pattern} and {!assemble}), together with their pattern [p] for
+      subsequent assemblies. *)
+  val from_triplets : 's sformat -> int -> int
+                      -> index_array -> index_array -> RealArray.t
+                      -> 's t * 's pattern
+
+  (** {3:sparse_frozen Frozen patterns} *)
+
+  (** Freezes the sparsity pattern of a matrix, that is, the contents of
+      its [idxvals] and [idxptrs] arrays (see {!unwrap}), so that only the
+      values of its nonzero entries change. This suits problems whose
+      sparsity is fixed for the whole simulation.
+
+      When the pattern of a matrix is frozen,
+      - {!set_to_zero}, which solvers call before each evaluation of a
+        Jacobian function, only zeroes the values, and the Jacobian function
+        need only update them (with {!set_data} or through {!unwrap_data}),
+      - {!blit} only copies the values into the matrix when the source has
+        the same pattern, and otherwise copies the source pattern too,
+      - {!assemble} only scatters the values, after checking that the
+        pattern is the one given, and
+      - {!Sundials_LinearSolver.Direct.Klu.reinit} keeps the symbolic analysis of
+        the factorization so that only a numeric refactorization is
+        performed.
+      The clones made by the solvers after the pattern is frozen share it.
+      Operations that add nonzeros, like {!scale_addi} on a matrix without
+      a complete diagonal, still update the pattern. It is the caller's
+      responsibility to freeze only a complete pattern.
+
+      @raise Config.NotImplementedBySundialsVersion Frozen patterns require
+             Sundials >= 3.0.0. *)
+  val freeze_pattern : 's t -> unit
+
+  (** Allows the sparsity pattern of a matrix to change again. *)
+  val thaw_pattern : 's t -> unit
+
+  (** Indicates whether the sparsity pattern of a matrix is frozen. *)
+  val is_frozen : 's t -> bool
+
+  (** {3:sparse_shared Shared patterns} *)
+
+  (** [share_pattern a] returns a new matrix with the dimensions and
+      sparsity pattern of [a] and zero values. The [idxvals] and [idxptrs]
+      arrays (see {!unwrap}) are shared rather than copied; only the
+      values are separate. This suits ensembles of sessions with identical
+      sparsity: the matrix of each session is obtained from a common
+      template.
+
+      A shared pattern is {{!freeze_pattern}frozen} and immutable: it
+      cannot be thawed or resized, and the operations that would add
+      nonzeros, like {!scale_addi} on a matrix without a complete diagonal,
+      fail rather than rewrite it. The functions that give access to the
+      pattern, {!unwrap}, {!set}, {!set_col}, {!set_row}, {!set_rowval},
+      and {!set_colval}, raise [Invalid_argument]; values are accessed
+      with {!unwrap_data}, {!get_data}, and {!set_data}. The clones made
+      by the solvers share the pattern too.
+
+      {{!Sundials_LinearSolver.Direct.klu}KLU} solvers for matrices with a
+      shared pattern also share the symbolic analysis of the factorization:
+      the first solver to factor a matrix computes it, and the others only
+      perform a numeric factorization, provided that they use the same
+      {{!Sundials_LinearSolver.Direct.Klu.set_ordering}ordering}. This
+      requires {{!Sundials_Config.sundials_version}Config.sundials_version}
+      >= 4.0.0.
+
+      @raise Config.NotImplementedBySundialsVersion Shared patterns require
+             Sundials >= 3.0.0. *)
+  val share_pattern : 's t -> 's t
+
+  (** Indicates whether the sparsity pattern of a matrix is shared. *)
+  val is_shared : 's t -> bool
+
   (** {3:sparse_ops Operations} *)
 
   (** Operations on sparse matrices. *)
@@ -602,13 +741,19 @@ module Sparse : sig (* {{{ *)
 
   (** {3:sparse_lowlevel Low-level details} *)
 
-  (** [set_rowval a idx i] sets the [idx]th row to [i]. *)
+  (** [set_rowval a idx i] sets the [idx]th row to [i].
+
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}. *)
   val set_rowval : csc t -> int -> int -> unit
 
   (** [r = get_rowval a idx] returns the row [r] at the [idx]th position. *)
   val get_rowval : csc t -> int -> int
 
-  (** [set_colval a idx i] sets the [idx]th column to [i]. *)
+  (** [set_colval a idx i] sets the [idx]th column to [i].
+
+      @raise Invalid_argument The pattern of the matrix is
+                              {{!share_pattern}shared}. *)
   val set_colval : csr t -> int -> int -> unit
 
   (** [c = get_colval a idx] returns the column [c] at the [idx]th
@@ -628,6 +773,126 @@ module Sparse : sig (* {{{ *)
 
 end (* }}} *)
 
+(** Finite-difference approximation of sparse and band Jacobians with
+    column coloring (the method of Curtis, Powell, and Reid). The columns
+    of a Jacobian that have no nonzero row in common are perturbed
+    together, so that a Jacobian is computed with one evaluation of the
+    function per color rather than one per column. The coloring is
+    computed once from the sparsity pattern of a matrix, and the
+    difference quotients are scattered directly into the matrix storage.
+
+    The [colored_jac] functions of {!Cvode.Dls}, {!Ida.Dls},
+    {!Arkode.ARKStep.Dls}, and {!Kinsol.Dls} turn a coloring into a Jacobian
+    function. *)
+module Coloring : sig (* {{{ *)
+
+  (** A coloring of the columns of matrices of type ['m]. It includes a
+      workspace, and it must not be used by two Jacobian evaluations at
+      the same time. *)
+  type 'm t
+
+  (** [sparse a] colors the columns of matrices with the same sparsity
+      pattern as [a], that is, with the same [idxvals] and [idxptrs] arrays
+      (see {!Sparse.unwrap}). The pattern should include the whole
+      diagonal for the solvers that add the identity to the Jacobian.
+
+      The increment applied to the [j]th variable is
+      [relinc *. max 1.0 (abs_float y.{j})], with the sign of [y.{j}], where
+      [relinc] defaults to the square root of
+      {{!Sundials_Config.unit_roundoff}unit_roundoff}.
+
+      @raise Config.NotImplementedBySundialsVersion Sparse matrices not
+                                                    available. *)
+  val sparse : ?relinc:float -> 's Sparse.t -> 's Sparse.t t
+
+  (** [band a] colors the columns of band matrices with the same
+      dimensions as [a]. There are [mu + ml + 1] colors. *)
+  val band : ?relinc:float -> Band.t -> Band.t t
+
+  (** Returns the number of colors, that is, the number of function
+      evaluations per Jacobian. *)
+  val num_colors : 'm t -> int
+
+  (** [jacobian c f y fy a] stores in [a] an approximation of the
+      Jacobian of [f] at [y], where [fy] contains [f y]. The function
+      [f y' fy'] stores its result in [fy'].
+
+      The pattern of a sparse matrix is restored before its entries are
+      computed, unless it is {{!Sparse.freeze_pattern}frozen}, in which
+      case it must already be the pattern of the coloring.
+
+      @raise Invalid_argument [a] or a vector does not have the expected
+                              size, or [a] has a frozen pattern different
+                              from that of [c]. *)
+  val jacobian : 'm t -> (RealArray.t -> RealArray.t -> unit)
+                 -> RealArray.t -> RealArray.t -> 'm -> unit
+
+  (** [dae_jacobian c f cj y yp r a] stores in [a] an approximation of
+      {% $\frac{\partial F}{\partial y} + c_j\frac{\partial F}{\partial\dot{y}}$%}
+      at [(y, yp)], where [r] contains [f y yp]. The function
+      [f y' yp' r'] stores its result in [r']. Each [y.{j}] is perturbed
+      by the increment described for {!sparse}, that is,
+      [relinc *. max 1.0 (abs_float y.{j})] with the sign of [y.{j}], and
+      [yp.{j}] by [cj] times that increment. Unlike {!Ida}'s internal
+      difference quotients, the increment thus depends neither on the
+      error weights nor on the step size.
+
+      @raise Invalid_argument [a] or a vector does not have the expected
+                              size. *)
+  val dae_jacobian : 'm t
+                     -> (RealArray.t -> RealArray.t -> RealArray.t -> unit)
+                     -> float -> RealArray.t -> RealArray.t -> RealArray.t
+                     -> 'm -> unit
+
+end (* }}} *)
+
+(** Incremental dense and band Jacobians. Only some columns of a Jacobian
+    are recomputed, namely those marked {e dirty} since the previous
+    evaluation; the others are copied from a saved Jacobian. This suits
+    models where only a few components, for example those affected by a
+    discrete switch, change the Jacobian between evaluations.
+
+    The [incremental_jac] functions of {!Cvode.Dls},
+    {!Arkode.ARKStep.Dls}, and {!Kinsol.Dls} turn an incremental Jacobian
+    into a Jacobian function. The solvers still factor the whole iteration
+    matrix after each evaluation. *)
+module Incremental : sig (* {{{ *)
+
+  (** Saved Jacobians of type ['m] and their dirty columns. *)
+  type 'm t
+
+  (** [dense a] saves Jacobians with the same size as [a]. All columns
+      are initially dirty. *)
+  val dense : Dense.t -> Dense.t t
+
+  (** [band a] saves Jacobians with the same dimensions as [a]. All
+      columns are initially dirty. *)
+  val band : Band.t -> Band.t t
+
+  (** [mark t j] marks column [j] as dirty.
+
+      @raise Invalid_argument [j] is not a valid column. *)
+  val mark : 'm t -> int -> unit
+
+  (** Marks all columns as dirty. *)
+  val mark_all : 'm t -> unit
+
+  (** Returns the number of dirty columns. *)
+  val num_dirty : 'm t -> int
+
+  (** [jacobian t f a] fills [a] with the saved Jacobian, calls
+      [f cols a] to recompute the dirty columns [cols] (in increasing
+      order), saves them, and marks all columns as clean. The function [f]
+      must assign every element of the given columns that can be nonzero
+      and must not change the other columns. It is not called if no columns
+      are dirty. If [f] raises an exception, the saved Jacobian and the
+      dirty columns are left unchanged.
+
+      @raise Invalid_argument [a] does not have the expected size. *)
+  val jacobian : 'm t -> (int array -> 'm -> unit) -> 'm -> unit
+
+end (* }}} *)
+
 (** {2:array Arrays as matrices} *)
 
 (** General purpose dense matrix operations on arrays.
@@ -728,13 +993,19 @@ module ArrayDense : sig (* {{{ *)
       and [j] were swapped (in order, where [p.{0}] swaps against the
       original matrix [a]).
 
+      When {{!Sundials_Config.lapack_enabled}Config.lapack_enabled}, the factorization is computed
+      by [dgetrf], otherwise by a cache-blocked variant of [denseGETRF]
+      that gives the same results. In both cases, [p] holds 0-based
+      indices.
+
       @cvode <node9#ss:dense> denseGETRF
       @raise ZeroDiagonalElement Zero found in matrix diagonal *)
   val getrf : t -> LintArray.t -> unit
 
   (** [getrs a p b] finds the solution of [ax = b] using an LU factorization
       found by {!getrf}. Both [p] and [b] must have the same number of rows
-      as [a].
+      as [a]. The triangular solves are done by the Blas when
+      {{!Sundials_Config.lapack_enabled}Config.lapack_enabled}.
 
       @cvode <node9#ss:dense> denseGETRS *)
   val getrs : t -> LintArray.t -> RealArray.t -> unit
@@ -744,6 +1015,9 @@ module ArrayDense : sig (* {{{ *)
         : t -> LintArray.t -> RealArray.t -> int -> unit
 
   (** Performs Cholesky factorization of a real symmetric positive matrix.
+      Only the lower triangle is read and overwritten. The factorization
+      is computed by [dpotrf] when {{!Sundials_Config.lapack_enabled}Config.lapack_enabled} and
+      otherwise by a cache-blocked variant of [densePOTRF].
 
       @cvode <node9#ss:dense> densePOTRF *)
   val potrf : t -> unit
@@ -759,6 +1033,13 @@ module ArrayDense : sig (* {{{ *)
       an [m] by [n] matrix, where [m >= n]. The [beta] vector must have
       length [n]. The [work] vector must have length [m].
 
+      When {{!Sundials_Config.lapack_enabled}Config.lapack_enabled}, the factorization is computed
+      by the blocked [dgeqrf] (with [beta] holding its [tau]) in a
+      workspace of the size that it requests; [work] is only used if that
+      workspace cannot be allocated. The signs of the diagonal of R, and the reflectors, may
+      then differ from those computed by [denseGEQRF], but the result is
+      used in the same way by {!ormqr}.
+
       @cvode <node9#ss:dense> denseGEQRF *)
   val geqrf : t -> RealArray.t -> RealArray.t -> unit
 
@@ -920,6 +1201,11 @@ module ArrayBand : sig (* {{{ *)
       of L is all 1s. U may occupy elements up to bandwidth [smu]
       (rather than to [mu]).
 
+      When {{!Sundials_Config.lapack_enabled}Config.lapack_enabled} and
+      {% $\mathtt{smu} \geq \mathtt{mu} + \mathtt{ml}$ %}, the
+      factorization is computed by [dgbtrf] and its result converted to the
+      layout of [bandGBTRF], so that it can be passed to {!gbtrs}.
+
       @cvode <node9#ss:band> bandGBTRF *)
   val gbtrf : t -> LintArray.t -> unit
 
@@ -931,6 +1217,121 @@ module ArrayBand : sig (* {{{ *)
 
 end (* }}} *)
 
+(** Block-diagonal matrices, that is, square matrices made of [nblocks]
+    independent (square) blocks of order [bsize] along the diagonal, as
+    arise, for example, from ensembles of decoupled cells. Only the blocks
+    are stored, one after the other and each in column-major order, and the
+    operations and the LU factorization process one whole block at a time
+    (in parallel when the library is compiled with OpenMP). Use
+    {!Sundials_LinearSolver.Direct.blockdiag} to solve systems involving
+    such matrices. *)
+module BlockDiag : sig (* {{{ *)
+
+  (** A block-diagonal matrix. *)
+  type t
+
+  (** {3:blockdiag_basic Basic access} *)
+
+  (** [make nblocks bsize x] returns a matrix of [nblocks] blocks of order
+      [bsize] with all elements of the blocks set to [x].
+
+      @raise Invalid_argument if [nblocks < 0] or [bsize < 1]. *)
+  val make : int -> int -> float -> t
+
+  (** [create nblocks bsize] returns a matrix of [nblocks] uninitialized
+      blocks of order [bsize].
+
+      @raise Invalid_argument if [nblocks < 0] or [bsize < 1]. *)
+  val create : int -> int -> t
+
+  (** [nblocks, bsize = dims a] returns the number of blocks and their
+      order. *)
+  val dims : t -> int * int
+
+  (** [m, n = size a] returns the numbers of rows [m] and columns [n]
+      of [a], that is, [nblocks * bsize] for both. *)
+  val size : t -> int * int
+
+  (** [block a b] returns the [b]th block of [a] (counting from 0) as a
+      [bsize] by [bsize] array. The two share the same underlying storage
+      and the same array is returned by every call, so that, for instance,
+      a Jacobian function can fill the blocks in place without allocating
+      or copying. *)
+  val block : t -> int -> RealArray2.t
+
+  (** [get a b i j] returns the value at row [i] and column [j] of the
+      [b]th block of [a]. *)
+  val get : t -> int -> int -> int -> float
+
+  (** [set a b i j v] sets the value at row [i] and column [j] of the
+      [b]th block of [a] to [v]. *)
+  val set : t -> int -> int -> int -> float -> unit
+
+  (** [update a b i j f] sets the value at row [i] and column [j] of the
+      [b]th block of [a] to [f v]. *)
+  val update : t -> int -> int -> int -> (float -> float) -> unit
+
+  (** Direct access to the underlying storage array, which has [bsize]
+      rows and [nblocks * bsize] columns, the columns of the [b]th block
+      being the columns [b * bsize] to [(b + 1) * bsize - 1]. *)
+  val unwrap : t -> RealArray2.data
+
+  (** Pretty-print a block-diagonal matrix, block by block, using the
+      {{:OCAML_DOC_ROOT(Format.html)} Format} module. *)
+  val pp : Format.formatter -> t -> unit
+
+  (** {3:blockdiag_ops Operations} *)
+
+  (** Operations on block-diagonal matrices. For
+      {{!Sundials_Config.sundials_version}Config.sundials_version} >= 3.0.0,
+      the wrapped matrices ({!Sundials_Matrix.wrap_blockdiag}) implement the
+      SUNMatrix operations directly in C, except for cloning. *)
+  val ops : (t, RealArray.t) matrix_ops
+
+  (** [scale_add c A B] calculates $A = cA + B$.
+
+      @raise IncompatibleArguments Matrix dimensions do not match *)
+  val scale_add : float -> t -> t -> unit
+
+  (** [scale_addi c A] calculates $A = cA + I$. *)
+  val scale_addi : float -> t -> unit
+
+  (** The call [matvec a x y] computes the matrix-vector product $y = Ax$. *)
+  val matvec : t -> RealArray.t -> RealArray.t -> unit
+
+  (** Fills the matrix with zeros. *)
+  val set_to_zero : t -> unit
+
+  (** [blit ~src ~dst] copies the contents of [src] into [dst]. Both
+      must have the same dimensions.
+
+      @raise IncompatibleArguments Matrix dimensions do not match *)
+  val blit : src:t -> dst:t -> unit
+
+  (** [lrw, liw = space a] returns the storage requirements of [a] as
+      [lrw] realtype words and [liw] integer words. *)
+  val space : t -> int * int
+
+  (** {3:blockdiag_calcs Calculations} *)
+
+  (** [getrf a p] performs the LU factorization of every block of [a] with
+      partial pivoting, in place, as {!ArrayDense.getrf}. The
+      [nblocks * bsize] elements of [p] receive the pivots, those of the
+      [b]th block being relative to that block.
+
+      @cvode <node9#ss:dense> denseGETRF
+      @raise ZeroDiagonalElement Zero found in matrix diagonal (the index
+                                 is over the whole matrix) *)
+  val getrf : t -> LintArray.t -> unit
+
+  (** [getrs a p b] finds the solution of [ax = b] using the factorization
+      computed by {!getrf}. The solution overwrites [b].
+
+      @cvode <node9#ss:dense> denseGETRS *)
+  val getrs : t -> LintArray.t -> RealArray.t -> unit
+
+end (* }}} *)
+
 (** {2:generic Generic matrices} *)
 
 (** Distinguishes a library-supplied matrix from a custom one. *)
@@ -1044,10 +1445,50 @@ val arrayband
     band matrix. The two values share the same underlying storage. *)
 val wrap_arrayband : ArrayBand.t -> 'nk arrayband
 
-(** Wrap a custom matrix value.
+(** Generic matrix with block-diagonal content. *)
+type 'nk blockdiag = (custom, BlockDiag.t, RealArray.t, 'nk) t
+
+(** By default, [blockdiag nblocks bsize] returns a block-diagonal matrix of
+    [nblocks] blocks of order [bsize] with all elements initialized to [0.0].
+    The optional argument [i] specifies the initial value. *)
+val blockdiag : ?i:float -> int -> int -> 'nk blockdiag
+
+(** Creates a (block-diagonal) matrix by wrapping an existing block-diagonal
+    matrix. The two values share the same underlying storage. *)
+val wrap_blockdiag : BlockDiag.t -> 'nk blockdiag
+
+(** A native implementation of one of the {!matrix_ops}. The C function,
+    given to {!Sundials.cfun}, receives the payloads of the matrices
+    (['m], as OCaml [value]s) and the data pointer of the cfun in last
+    position. Except for [Clone], it returns [0] on success and a nonzero
+    value on failure, and it must not allocate on the OCaml heap.
+    - [Clone]: [value (*)(value a, void *data)] returns the payload of a
+      new matrix;
+    - [Zero]: [int (*)(value a, void *data)];
+    - [Copy]: [int (*)(value a, value b, void *data)] copies [a] into [b];
+    - [ScaleAdd]: [int (*)(realtype c, value a, value b, void *data)];
+    - [ScaleAddI]: [int (*)(realtype c, value a, void *data)];
+    - [Matvec]: [int (*)(value a, N_Vector x, N_Vector y, void *data)];
+    - [Space]: [int (*)(value a, long *lrw, long *liw, void *data)]. *)
+type native_op =
+  | Clone     of cfun
+  | Zero      of cfun
+  | Copy      of cfun
+  | ScaleAdd  of cfun
+  | ScaleAddI of cfun
+  | Matvec    of cfun
+  | Space     of cfun
+
+(** Wrap a custom matrix value. The operations given in [natives] are
+    called directly from C in place of the corresponding fields of
+    [ops], which remain in use from OCaml for those that are not given and
+    in {{!Sundials_Config.sundials_version}Config.sundials_version} < 3.0.0.
+    The clones of the matrix share its operations.
 
     @nocvode <node> Description of the SUNMatrix module *)
-val wrap_custom : ('m, 'nd) matrix_ops -> 'm -> (custom, 'm, 'nd, 'nk) t
+val wrap_custom
+  : ?natives:native_op list
+  -> ('m, 'nd) matrix_ops -> 'm -> (custom, 'm, 'nd, 'nk) t
 
 (** Matrix internal type identifiers.
 
@@ -1059,6 +1500,7 @@ type (_,_,_,_) id =
   | Custom : (custom, 'm, 'nd, 'nk) id
   | ArrayDense : (custom, ArrayDense.t, RealArray.t, 'nk) id
   | ArrayBand  : (custom, ArrayBand.t, RealArray.t, 'nk) id
+  | BlockDiag  : (custom, BlockDiag.t, RealArray.t, 'nk) id
 
 (** Return a record of matrix operations. *)
 val get_ops : ('k, 'm, 'nd, 'nk) t -> ('m, 'nd) matrix_ops
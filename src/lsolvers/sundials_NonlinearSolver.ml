@@ -52,6 +52,9 @@ external c_set_lsolve_fn   : ('d, 'k, 's) cptr -> unit
 external c_set_convtest_fn : ('d, 'k, 's) cptr -> unit
   = "sunml_nlsolver_set_convtest_fn"
 
+external c_clear_convtest_fn : ('d, 'k, 's) cptr -> unit
+  = "sunml_nlsolver_clear_convtest_fn"
+
 external c_set_max_iters : ('d, 'k, 's) cptr -> int -> unit
   = "sunml_nlsolver_set_max_iters"
 
@@ -136,6 +139,15 @@ let set_convtest_fn (type d k s)
       -> callbacks.convtestfn <- cbf;
          c_set_convtest_fn rawptr
 
+let clear_convtest_fn (type d k s)
+                      ({ rawptr; solver; callbacks } : (d, k, s) t) =
+  check_compat ();
+  match solver with
+  | CustomSolver _ | CustomSensSolver _ -> raise IncorrectUse
+  | FixedPointSolver _ | NewtonSolver                        (* C/Cnls *)
+      -> c_clear_convtest_fn rawptr;
+         callbacks.convtestfn <- empty_convtestfn
+
 let set_max_iters (type d k s) ({ rawptr; solver } : (d, k, s) t) i =
   check_compat ();
   match solver with
@@ -222,6 +222,25 @@ type ('data, 's) convtestfn = 'data -> 'data -> float -> 'data -> 's -> convtest
     @nocvode <node> SUNNonlinSolSetConvTestFn *)
 val set_convtest_fn : ('d, 'k, 's) t -> ('d, 's) convtestfn -> unit
 
+(** Reinstates the convergence test that an integrator provided before it
+    was overridden by {!set_convtest_fn}. The system, linear solver setup,
+    and linear solver functions of an integrator are always called
+    directly by the nonlinear solver, so after this call no OCaml code
+    is involved in the nonlinear iterations unless the integrator's own
+    callbacks (e.g., the right-hand side function) are OCaml functions.
+    Overriding the test is thus best reserved for genuinely custom
+    criteria, and this function allows a temporary override, for
+    instance to trace the first steps of an integration.
+
+    Does nothing if the test is not currently overridden. The test must
+    have been overridden after the solver was attached to an integrator,
+    since otherwise there is no integrator test to reinstate.
+
+    @raise IncorrectUse The solver is a {!Custom} one, or its test was
+                        overridden before it was attached to an
+                        integrator. *)
+val clear_convtest_fn : ('d, 'k, 'a integrator) t -> unit
+
 (** Sets the maximum number of nonlinear solver iterations.
 
     @nocvode <node> SUNNonlinSolSetMaxIters *)
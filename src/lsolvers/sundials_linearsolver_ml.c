@@ -22,6 +22,7 @@
 #include <sundials/sundials_linearsolver.h>
 
 #include <assert.h>
+#include <float.h>
 
 #include <stdio.h>
 #include <sunlinsol/sunlinsol_band.h>
@@ -38,18 +39,21 @@
 
 #ifdef SUNDIALS_ML_SUPERLUMT
 #include <sunlinsol/sunlinsol_superlumt.h>
+#include <pthread.h>
 #endif
 
 #ifdef SUNDIALS_ML_LAPACK
 #include <sunlinsol/sunlinsol_lapackband.h>
 #include <sunlinsol/sunlinsol_lapackdense.h>
 #endif
-
-#include <nvector/nvector_serial.h>
 #endif
 
+#include <nvector/nvector_serial.h>
 #include <sundials/sundials_math.h>
 #include <sundials/sundials_iterative.h>
+#include <sundials/sundials_dense.h>
+
+#include <string.h>
 
 #include <caml/mlvalues.h>
 #include <caml/alloc.h>
@@ -286,6 +290,120 @@ CAMLprim value sunml_lsolver_lapack_band(value vnvec, value vbmat)
 #endif
 }
 
+/* KLU solvers for matrices with a shared pattern (see
+   Matrix.Sparse.share_pattern) reuse the symbolic analysis of the first
+   one to factor the pattern with the same ordering.  The setup operation is
+   wrapped to install the borrowed analysis in place of the first call to
+   klu_analyze, and the operations that would free it (free and reinit)
+   detach it beforehand.  The symbolic analysis computed by a solver is
+   handed over to the share, which frees it after its last user.  */
+#if 400 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_KLU
+
+struct klu_ops {
+    struct _generic_SUNLinearSolver_Ops ops;	/* must be first */
+    int (*setup)(SUNLinearSolver, SUNMatrix);
+    int (*free)(SUNLinearSolver);
+    struct sunml_sparse_share *share;	/* whose analysis is in use */
+};
+
+#define KLU_OPS(ls) ((struct klu_ops *)((ls)->ops))
+#define KLU_CONTENT(ls) ((SUNLinearSolverContent_KLU)((ls)->content))
+
+static void klu_free_shared_symbolic(void *symbolic)
+{
+    sun_klu_symbolic *sym = symbolic;
+    sun_klu_common common;
+
+    sun_klu_defaults(&common);
+    sun_klu_free_symbolic(&sym, &common);
+}
+
+static void klu_detach(SUNLinearSolver ls)
+{
+    struct klu_ops *x = KLU_OPS(ls);
+    SUNLinearSolverContent_KLU c = KLU_CONTENT(ls);
+
+    if (x->share == NULL) return;
+    if (c->symbolic == x->share->symbolic) c->symbolic = NULL;
+    sunml_sparse_share_release(x->share);
+    x->share = NULL;
+}
+
+static int klu_setup(SUNLinearSolver ls, SUNMatrix A)
+{
+    struct klu_ops *x = KLU_OPS(ls);
+    SUNLinearSolverContent_KLU c = KLU_CONTENT(ls);
+    struct sunml_sparse_share *s;
+    int r;
+
+    if (!c->first_factorize) return x->setup(ls, A);
+
+    klu_detach(ls);
+    s = sunml_matrix_sparse_share(A);
+    if (s == NULL) return x->setup(ls, A);
+
+    if (s->symbolic != NULL && s->ordering == c->common.ordering) {
+	c->symbolic = s->symbolic;
+	x->share = s;
+	++s->refs;
+
+	if (c->numeric != NULL) sun_klu_free_numeric(&c->numeric, &c->common);
+	c->numeric = sun_klu_factor(
+			(KLU_INDEXTYPE *) SUNSparseMatrix_IndexPointers(A),
+			(KLU_INDEXTYPE *) SUNSparseMatrix_IndexValues(A),
+			SUNSparseMatrix_Data(A),
+			c->symbolic, &c->common);
+	if (c->numeric == NULL) {
+	    c->last_flag = SUNLS_PACKAGE_FAIL_UNREC;
+	    return c->last_flag;
+	}
+	c->first_factorize = 0;
+	c->last_flag = SUNLS_SUCCESS;
+	return c->last_flag;
+    }
+
+    r = x->setup(ls, A);
+
+    if (r == SUNLS_SUCCESS && s->symbolic == NULL && c->symbolic != NULL) {
+	s->symbolic = c->symbolic;
+	s->ordering = c->common.ordering;
+	s->free_symbolic = klu_free_shared_symbolic;
+	x->share = s;
+	++s->refs;
+    }
+    return r;
+}
+
+static int klu_free(SUNLinearSolver ls)
+{
+    int (*free_ls)(SUNLinearSolver);
+
+    if (ls == NULL) return SUNLS_SUCCESS;
+    free_ls = KLU_OPS(ls)->free;
+    klu_detach(ls);
+    return free_ls(ls);
+}
+
+static int klu_wrap_ops(SUNLinearSolver ls)
+{
+    struct klu_ops *x = malloc(sizeof *x);
+
+    if (x == NULL) return -1;
+
+    x->ops = *ls->ops;
+    x->setup = ls->ops->setup;
+    x->free = ls->ops->free;
+    x->ops.setup = klu_setup;
+    x->ops.free = klu_free;
+    x->share = NULL;
+
+    free(ls->ops);
+    ls->ops = &x->ops;
+    return 0;
+}
+
+#endif
+
 CAMLprim value sunml_lsolver_klu(value vnvec, value vsmat)
 {
     CAMLparam2(vnvec, vsmat);
@@ -307,6 +425,13 @@ CAMLprim value sunml_lsolver_klu(value vnvec, value vsmat)
 	caml_raise_out_of_memory();
     }
 
+#if 400 <= SUNDIALS_LIB_VERSION
+    if (klu_wrap_ops(ls) != 0) {
+	SUNLinSolFree(ls);
+	caml_raise_out_of_memory();
+    }
+#endif
+
     CAMLreturn(alloc_lsolver(ls));
 #else
     CAMLreturn(Val_unit);
@@ -317,6 +442,7 @@ CAMLprim void sunml_lsolver_klu_reinit(value vcptr, value vsmat)
 {
     CAMLparam2(vcptr, vsmat);
 #if   400 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_KLU
+    klu_detach(LSOLVER_VAL(vcptr));
     SUNLinSol_KLUReInit(LSOLVER_VAL(vcptr), MAT_VAL(vsmat),
 			0, SUNKLU_REINIT_PARTIAL);
 #elif 312 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_KLU
@@ -342,6 +468,127 @@ CAMLprim void sunml_lsolver_klu_set_ordering(value vcptr, value vordering)
     CAMLreturn0;
 }
 
+/*
+ * The thread count given at creation sizes the solver's statistics
+ * arrays, so it is an upper bound, but any smaller count can be used for
+ * a given factorization. The setup operation is wrapped to choose that
+ * count, either fixed or from the work estimated as nnz(A) times the fill
+ * ratio (nnz(L) + nnz(U)) / nnz(A) of the previous factorization, and,
+ * for solvers that share the process-wide pool, to borrow the threads
+ * from a common budget while factoring. SuperLU_MT creates and joins its
+ * threads within each call to pdgstrf, so the pool bounds how many
+ * factorization threads run at once rather than keeping them alive.
+ *
+ * The extra state lives in an enlarged copy of the (per-instance) ops
+ * structure, which SUNLinSolFree releases with the rest of the solver.
+ */
+
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+
+struct superlumt_ops {
+    struct _generic_SUNLinearSolver_Ops ops;	/* must be first */
+    int (*setup)(SUNLinearSolver, SUNMatrix);
+    int max_threads;
+    int fixed_threads;	/* 0 to choose from the work estimate */
+    double grain;	/* nonzeros of L + U per thread */
+    double fill;	/* fill ratio of the last factorization */
+    int shared;		/* borrow threads from the pool */
+    int last_threads;
+};
+
+#define SUPERLUMT_OPS(ls) ((struct superlumt_ops *)((ls)->ops))
+#define SUPERLUMT_CONTENT(ls) ((SUNLinearSolverContent_SuperLUMT)((ls)->content))
+
+#define SUPERLUMT_DEFAULT_GRAIN 50000.0
+#define SUPERLUMT_DEFAULT_FILL	4.0
+
+static pthread_mutex_t superlumt_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static int superlumt_pool_size = 0;	/* 0 for no limit */
+static int superlumt_pool_busy = 0;
+
+/* The calling thread always takes part, so at least one thread is granted
+   even when the budget is exhausted. */
+static int superlumt_pool_acquire(int nthreads)
+{
+    int avail;
+
+    pthread_mutex_lock(&superlumt_pool_lock);
+    if (superlumt_pool_size > 0) {
+	avail = superlumt_pool_size - superlumt_pool_busy;
+	if (avail < nthreads) nthreads = avail;
+	if (nthreads < 1) nthreads = 1;
+    }
+    superlumt_pool_busy += nthreads;
+    pthread_mutex_unlock(&superlumt_pool_lock);
+
+    return nthreads;
+}
+
+static void superlumt_pool_release(int nthreads)
+{
+    pthread_mutex_lock(&superlumt_pool_lock);
+    superlumt_pool_busy -= nthreads;
+    pthread_mutex_unlock(&superlumt_pool_lock);
+}
+
+static int superlumt_choose_threads(struct superlumt_ops *x, double nnz)
+{
+    double nt;
+
+    if (x->fixed_threads > 0) return x->fixed_threads;
+
+    nt = nnz * x->fill / x->grain;
+    if (nt < 1.0) return 1;
+    if (nt > (double)x->max_threads) return x->max_threads;
+    return (int)nt;
+}
+
+static int superlumt_setup(SUNLinearSolver ls, SUNMatrix A)
+{
+    struct superlumt_ops *x = SUPERLUMT_OPS(ls);
+    SUNLinearSolverContent_SuperLUMT c = SUPERLUMT_CONTENT(ls);
+    double nnz = (double)SUNSparseMatrix_IndexPointers(A)[SUNSparseMatrix_NP(A)];
+    int nthreads, r;
+
+    nthreads = superlumt_choose_threads(x, nnz);
+    if (x->shared) nthreads = superlumt_pool_acquire(nthreads);
+
+    c->num_threads = nthreads;
+    r = x->setup(ls, A);
+
+    if (x->shared) superlumt_pool_release(nthreads);
+    x->last_threads = nthreads;
+
+    if (r == SUNLS_SUCCESS && nnz > 0.0)
+	x->fill = ((double)((SCPformat *)c->L->Store)->nnz
+		   + (double)((NCPformat *)c->U->Store)->nnz) / nnz;
+
+    return r;
+}
+
+static int superlumt_wrap_ops(SUNLinearSolver ls, int nthreads)
+{
+    struct superlumt_ops *x = malloc(sizeof *x);
+
+    if (x == NULL) return -1;
+
+    x->ops = *ls->ops;
+    x->setup = ls->ops->setup;
+    x->ops.setup = superlumt_setup;
+    x->max_threads = nthreads;
+    x->fixed_threads = nthreads;
+    x->grain = SUPERLUMT_DEFAULT_GRAIN;
+    x->fill = SUPERLUMT_DEFAULT_FILL;
+    x->shared = 0;
+    x->last_threads = nthreads;
+
+    free(ls->ops);
+    ls->ops = &x->ops;
+    return 0;
+}
+
+#endif
+
 CAMLprim value sunml_lsolver_superlumt(value vnvec, value vsmat, value vnthreads)
 {
     CAMLparam2(vnvec, vsmat);
@@ -365,6 +612,11 @@ CAMLprim value sunml_lsolver_superlumt(value vnvec, value vsmat, value vnthreads
 	caml_raise_out_of_memory();
     }
 
+    if (superlumt_wrap_ops(ls, Int_val(vnthreads)) != 0) {
+	SUNLinSolFree(ls);
+	caml_raise_out_of_memory();
+    }
+
     CAMLreturn(alloc_lsolver(ls));
 #else
     CAMLreturn(Val_unit);
@@ -382,6 +634,661 @@ CAMLprim void sunml_lsolver_superlumt_set_ordering(value vcptr, value vordering)
     CAMLreturn0;
 }
 
+CAMLprim void sunml_lsolver_superlumt_set_num_threads(value vcptr,
+						      value vnthreads,
+						      value vgrain)
+{
+    CAMLparam3(vcptr, vnthreads, vgrain);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+    struct superlumt_ops *x = SUPERLUMT_OPS(LSOLVER_VAL(vcptr));
+
+    x->fixed_threads = Int_val(vnthreads);
+    x->grain = Double_val(vgrain);
+#endif
+    CAMLreturn0;
+}
+
+CAMLprim value sunml_lsolver_superlumt_get_num_threads(value vcptr)
+{
+    CAMLparam1(vcptr);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+    CAMLreturn(Val_int(SUPERLUMT_OPS(LSOLVER_VAL(vcptr))->last_threads));
+#else
+    CAMLreturn(Val_int(0));
+#endif
+}
+
+CAMLprim void sunml_lsolver_superlumt_set_shared(value vcptr, value vshared)
+{
+    CAMLparam2(vcptr, vshared);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+    SUPERLUMT_OPS(LSOLVER_VAL(vcptr))->shared = Bool_val(vshared);
+#endif
+    CAMLreturn0;
+}
+
+CAMLprim void sunml_lsolver_superlumt_set_pool_size(value vsize)
+{
+    CAMLparam1(vsize);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+    pthread_mutex_lock(&superlumt_pool_lock);
+    superlumt_pool_size = Int_val(vsize);
+    pthread_mutex_unlock(&superlumt_pool_lock);
+#endif
+    CAMLreturn0;
+}
+
+CAMLprim value sunml_lsolver_superlumt_get_pool_size(value vunit)
+{
+    CAMLparam1(vunit);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_SUPERLUMT
+    int size;
+
+    pthread_mutex_lock(&superlumt_pool_lock);
+    size = superlumt_pool_size;
+    pthread_mutex_unlock(&superlumt_pool_lock);
+    CAMLreturn(Val_int(size));
+#else
+    CAMLreturn(Val_int(0));
+#endif
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Block-diagonal
+ *
+ * A direct solver for Matrix.BlockDiag matrices. The setup factors the
+ * blocks in place and the solve substitutes block by block (in parallel
+ * under OpenMP); neither allocates memory nor calls back into OCaml.
+ */
+
+#if 300 <= SUNDIALS_LIB_VERSION
+
+// Defined in sundials_matrix_ml.c
+sundials_ml_index sunml_blockdiag_getrf(value va, sundials_ml_index *p);
+void sunml_blockdiag_getrs(value va, sundials_ml_index *p, realtype *b);
+
+struct blockdiag_content {
+    sundials_ml_index n;	    /* nblocks * bsize */
+    sundials_ml_index *pivots;
+    long int last_flag;
+};
+#define BLOCKDIAG_CONTENT(ls) ((struct blockdiag_content *)(ls)->content)
+
+static SUNLinearSolver_Type blockdiag_gettype(SUNLinearSolver ls)
+{
+    return SUNLINEARSOLVER_DIRECT;
+}
+
+static int blockdiag_initialize(SUNLinearSolver ls)
+{
+    BLOCKDIAG_CONTENT(ls)->last_flag = SUNLS_SUCCESS;
+    return SUNLS_SUCCESS;
+}
+
+static int blockdiag_setup(SUNLinearSolver ls, SUNMatrix A)
+{
+    struct blockdiag_content *content = BLOCKDIAG_CONTENT(ls);
+    value va = MAT_BACKLINK(A);
+    sundials_ml_index r;
+
+    if (BLOCKDIAG_NBLOCKS(va) * BLOCKDIAG_BSIZE(va) != content->n) {
+	content->last_flag = SUNLS_ILL_INPUT;
+	return SUNLS_ILL_INPUT;
+    }
+
+    r = sunml_blockdiag_getrf(va, content->pivots);
+    content->last_flag = r;
+    return (r > 0) ? SUNLS_LUFACT_FAIL : SUNLS_SUCCESS;
+}
+
+static int blockdiag_solve(SUNLinearSolver ls, SUNMatrix A, N_Vector x,
+			   N_Vector b, realtype tol)
+{
+    struct blockdiag_content *content = BLOCKDIAG_CONTENT(ls);
+    realtype *xd;
+
+    N_VScale(1.0, b, x);
+    xd = N_VGetArrayPointer(x);
+    if (xd == NULL) {
+	content->last_flag = SUNLS_MEM_FAIL;
+	return SUNLS_MEM_FAIL;
+    }
+
+    sunml_blockdiag_getrs(MAT_BACKLINK(A), content->pivots, xd);
+    content->last_flag = SUNLS_SUCCESS;
+    return SUNLS_SUCCESS;
+}
+
+static long int blockdiag_lastflag(SUNLinearSolver ls)
+{
+    return BLOCKDIAG_CONTENT(ls)->last_flag;
+}
+
+static int blockdiag_space(SUNLinearSolver ls, long int *lenrw,
+			   long int *leniw)
+{
+    *lenrw = 0;
+    *leniw = 2 + BLOCKDIAG_CONTENT(ls)->n;
+    return SUNLS_SUCCESS;
+}
+
+static int blockdiag_free(SUNLinearSolver ls)
+{
+    if (ls->content != NULL) {
+	free(BLOCKDIAG_CONTENT(ls)->pivots);
+	free(ls->content);
+    }
+    if (ls->ops != NULL) free(ls->ops);
+    free(ls);
+
+    return SUNLS_SUCCESS;
+}
+
+#endif
+
+CAMLprim value sunml_lsolver_blockdiag(value vnvec, value vmat)
+{
+    CAMLparam2(vnvec, vmat);
+#if 300 <= SUNDIALS_LIB_VERSION
+    value va = MAT_UNWRAP(vmat);
+    sundials_ml_index n = BLOCKDIAG_NBLOCKS(va) * BLOCKDIAG_BSIZE(va);
+    struct blockdiag_content *content;
+    SUNLinearSolver_Ops ops;
+    SUNLinearSolver ls;
+
+    if (n != NV_LENGTH_S(NVEC_VAL(vnvec)))
+	caml_raise_constant(LSOLVER_EXN(MatrixVectorMismatch));
+
+    ls = (SUNLinearSolver)malloc(sizeof *ls);
+    ops = (SUNLinearSolver_Ops) malloc(
+	    sizeof(struct _generic_SUNLinearSolver_Ops));
+    content = (struct blockdiag_content *)malloc(sizeof *content);
+    if (content != NULL)
+	content->pivots = malloc((n > 0 ? n : 1) * sizeof(sundials_ml_index));
+    if (ls == NULL || ops == NULL || content == NULL
+	    || content->pivots == NULL) {
+	if (content != NULL) free(content->pivots);
+	free(content);
+	free(ops);
+	free(ls);
+	caml_raise_out_of_memory();
+    }
+    content->n = n;
+    content->last_flag = SUNLS_SUCCESS;
+
+    ops->gettype           = blockdiag_gettype;
+    ops->initialize        = blockdiag_initialize;
+    ops->setup             = blockdiag_setup;
+    ops->solve             = blockdiag_solve;
+    ops->lastflag          = blockdiag_lastflag;
+    ops->free              = blockdiag_free;
+    ops->setatimes         = NULL;
+    ops->setpreconditioner = NULL;
+    ops->setscalingvectors = NULL;
+    ops->numiters          = NULL;
+    ops->resnorm           = NULL;
+    ops->resid             = NULL;
+    ops->space             = blockdiag_space;
+
+    ls->ops = ops;
+    ls->content = content;
+
+    CAMLreturn(alloc_lsolver(ls));
+#else
+    CAMLreturn(Val_unit);
+#endif
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Mixed precision (Lapack)
+ *
+ * Direct solvers for dense and band matrices that factor a single-precision
+ * copy of the matrix with sgetrf/sgbtrf and then refine the solution
+ * against the (unmodified) double-precision matrix: x is updated by the
+ * correction computed from the residual b - Ax until the residual is
+ * negligible.  If it is still not negligible after max_refinements
+ * corrections, or if it stops decreasing, the matrix is factored again in
+ * double precision with dgetrf/dgbtrf, as in Lapack's dsgesv, and that
+ * factorization is used until the next setup.  With max_refinements = 0,
+ * the single-precision solution is accepted as is.
+ */
+
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_LAPACK \
+	&& !defined SUNDIALS_ML_SINGLE_PRECISION
+
+extern void sgetrf_(const int *m, const int *n, float *a, const int *lda,
+		    int *ipiv, int *info);
+extern void sgetrs_(const char *trans, const int *n, const int *nrhs,
+		    const float *a, const int *lda, const int *ipiv,
+		    float *b, const int *ldb, int *info);
+extern void sgbtrf_(const int *m, const int *n, const int *kl, const int *ku,
+		    float *ab, const int *ldab, int *ipiv, int *info);
+extern void sgbtrs_(const char *trans, const int *n, const int *kl,
+		    const int *ku, const int *nrhs, const float *ab,
+		    const int *ldab, const int *ipiv, float *b, const int *ldb,
+		    int *info);
+extern void dgetrf_(const int *m, const int *n, double *a, const int *lda,
+		    int *ipiv, int *info);
+extern void dgetrs_(const char *trans, const int *n, const int *nrhs,
+		    const double *a, const int *lda, const int *ipiv,
+		    double *b, const int *ldb, int *info);
+extern void dgbtrf_(const int *m, const int *n, const int *kl, const int *ku,
+		    double *ab, const int *ldab, int *ipiv, int *info);
+extern void dgbtrs_(const char *trans, const int *n, const int *kl,
+		    const int *ku, const int *nrhs, const double *ab,
+		    const int *ldab, const int *ipiv, double *b,
+		    const int *ldb, int *info);
+
+struct mixed_content {
+    int n;
+    int band;		    /* otherwise dense */
+    int kl, ku, ldab;	    /* for dense matrices, ldab = n */
+    int max_refinements;
+    float *lu;		    /* ldab * n */
+    int *pivots;	    /* n */
+    float *w;		    /* n */
+    realtype *r;	    /* n */
+    realtype *bc;	    /* n */
+    realtype anrm;	    /* infinity norm of the factored matrix */
+    int fallback;	    /* dlu holds the factorization, not lu */
+    realtype *dlu;	    /* ldab * n, allocated at the first fallback */
+    long int last_flag;
+};
+#define MIXED_CONTENT(ls) ((struct mixed_content *)(ls)->content)
+
+static SUNLinearSolver_Type mixed_gettype(SUNLinearSolver ls)
+{
+    return SUNLINEARSOLVER_DIRECT;
+}
+
+static int mixed_initialize(SUNLinearSolver ls)
+{
+    MIXED_CONTENT(ls)->last_flag = SUNLS_SUCCESS;
+    return SUNLS_SUCCESS;
+}
+
+/* Copy A into the single-precision storage, in the Lapack (general or
+   band) layout, and compute its infinity norm.  Returns 0 if an element
+   is out of range.  */
+static int mixed_convert(struct mixed_content *c, SUNMatrix A)
+{
+    int n = c->n, i, j;
+    float *lu = c->lu;
+    realtype *rowsum = c->r;
+    realtype v;
+
+    for (i = 0; i < n; ++i) rowsum[i] = 0.0;
+
+    if (c->band) {
+	int kl = c->kl, ku = c->ku, ldab = c->ldab;
+
+	for (j = 0; j < n; ++j) {
+	    realtype *col = SM_COLUMN_B(A, j);
+	    float *abj = lu + (size_t)j * ldab + kl + ku - j;
+	    int i0 = (j - ku > 0) ? j - ku : 0;
+	    int i1 = (j + kl < n - 1) ? j + kl : n - 1;
+
+	    for (i = 0; i < ldab; ++i) lu[(size_t)j * ldab + i] = 0.0f;
+	    for (i = i0; i <= i1; ++i) {
+		v = col[i - j];
+		if (v > FLT_MAX || v < -FLT_MAX) return 0;
+		abj[i] = (float)v;
+		rowsum[i] += (v < 0.0) ? -v : v;
+	    }
+	}
+    } else {
+	realtype *data = SM_DATA_D(A);
+
+	for (j = 0; j < n; ++j) {
+	    for (i = 0; i < n; ++i) {
+		v = data[(size_t)j * n + i];
+		if (v > FLT_MAX || v < -FLT_MAX) return 0;
+		lu[(size_t)j * n + i] = (float)v;
+		rowsum[i] += (v < 0.0) ? -v : v;
+	    }
+	}
+    }
+
+    c->anrm = 0.0;
+    for (i = 0; i < n; ++i)
+	if (rowsum[i] > c->anrm) c->anrm = rowsum[i];
+    return 1;
+}
+
+/* Factor A in double precision into dlu, in place of the single-precision
+   factorization.  */
+static int mixed_fallback(struct mixed_content *c, SUNMatrix A)
+{
+    int n = c->n, i, j, info;
+
+    if (c->dlu == NULL) {
+	c->dlu = malloc((size_t)c->ldab * (n > 0 ? n : 1) * sizeof(realtype));
+	if (c->dlu == NULL) return SUNLS_MEM_FAIL;
+    }
+
+    if (c->band) {
+	int kl = c->kl, ku = c->ku, ldab = c->ldab;
+
+	for (j = 0; j < n; ++j) {
+	    realtype *col = SM_COLUMN_B(A, j);
+	    realtype *abj = c->dlu + (size_t)j * ldab + kl + ku - j;
+	    int i0 = (j - ku > 0) ? j - ku : 0;
+	    int i1 = (j + kl < n - 1) ? j + kl : n - 1;
+
+	    for (i = 0; i < ldab; ++i) c->dlu[(size_t)j * ldab + i] = 0.0;
+	    for (i = i0; i <= i1; ++i) abj[i] = col[i - j];
+	}
+	dgbtrf_(&c->n, &c->n, &c->kl, &c->ku, c->dlu, &c->ldab, c->pivots,
+		&info);
+    } else {
+	memcpy(c->dlu, SM_DATA_D(A), (size_t)n * n * sizeof(realtype));
+	dgetrf_(&c->n, &c->n, c->dlu, &c->n, c->pivots, &info);
+    }
+
+    /* the single-precision pivots have been overwritten */
+    c->fallback = 1;
+    return (info > 0) ? SUNLS_LUFACT_FAIL : SUNLS_SUCCESS;
+}
+
+static int mixed_setup(SUNLinearSolver ls, SUNMatrix A)
+{
+    struct mixed_content *c = MIXED_CONTENT(ls);
+    int info, flag;
+
+    if (c->band ? (SUNMatGetID(A) != SUNMATRIX_BAND
+		   || SM_COLUMNS_B(A) != c->n
+		   || SM_LBAND_B(A) != c->kl || SM_UBAND_B(A) != c->ku)
+		: (SUNMatGetID(A) != SUNMATRIX_DENSE
+		   || SM_ROWS_D(A) != c->n || SM_COLUMNS_D(A) != c->n)) {
+	c->last_flag = SUNLS_ILL_INPUT;
+	return SUNLS_ILL_INPUT;
+    }
+
+    /* A matrix that is out of range or singular in single precision may
+       still be factored in double precision.  */
+    if (!mixed_convert(c, A)) {
+	flag = mixed_fallback(c, A);
+	c->last_flag = flag;
+	return flag;
+    }
+
+    if (c->band)
+	sgbtrf_(&c->n, &c->n, &c->kl, &c->ku, c->lu, &c->ldab, c->pivots,
+		&info);
+    else
+	sgetrf_(&c->n, &c->n, c->lu, &c->n, c->pivots, &info);
+
+    if (info > 0) {
+	flag = mixed_fallback(c, A);
+	c->last_flag = flag;
+	return flag;
+    }
+
+    c->fallback = 0;
+    c->last_flag = info;
+    return SUNLS_SUCCESS;
+}
+
+/* x := inv(A) bc, with the double-precision factorization */
+static void mixed_solve_double(struct mixed_content *c, realtype *x)
+{
+    int one = 1, info;
+
+    memcpy(x, c->bc, (size_t)c->n * sizeof(realtype));
+    if (c->band)
+	dgbtrs_("N", &c->n, &c->kl, &c->ku, &one, c->dlu, &c->ldab, c->pivots,
+		x, &c->n, &info);
+    else
+	dgetrs_("N", &c->n, &one, c->dlu, &c->n, c->pivots, x, &c->n, &info);
+}
+
+/* w := inv(LU) w */
+static void mixed_getrs(struct mixed_content *c)
+{
+    int one = 1, info;
+
+    if (c->band)
+	sgbtrs_("N", &c->n, &c->kl, &c->ku, &one, c->lu, &c->ldab, c->pivots,
+		c->w, &c->n, &info);
+    else
+	sgetrs_("N", &c->n, &one, c->lu, &c->n, c->pivots, c->w, &c->n, &info);
+}
+
+static realtype mixed_norm(int n, realtype *v)
+{
+    realtype nrm = 0.0, a;
+    int i;
+
+    for (i = 0; i < n; ++i) {
+	a = (v[i] < 0.0) ? -v[i] : v[i];
+	if (a > nrm) nrm = a;
+    }
+    return nrm;
+}
+
+/* r := bc - A x, returns the infinity norm of r */
+static realtype mixed_residual(struct mixed_content *c, SUNMatrix A,
+			       realtype *x)
+{
+    int n = c->n, i, j;
+    realtype *r = c->r;
+
+    for (i = 0; i < n; ++i) r[i] = c->bc[i];
+
+    if (c->band) {
+	for (j = 0; j < n; ++j) {
+	    realtype *col = SM_COLUMN_B(A, j), xj = x[j];
+	    int i0 = (j - c->ku > 0) ? j - c->ku : 0;
+	    int i1 = (j + c->kl < n - 1) ? j + c->kl : n - 1;
+
+	    for (i = i0; i <= i1; ++i) r[i] -= col[i - j] * xj;
+	}
+    } else {
+	realtype *data = SM_DATA_D(A);
+
+	for (j = 0; j < n; ++j) {
+	    realtype *col = data + (size_t)j * n, xj = x[j];
+	    for (i = 0; i < n; ++i) r[i] -= col[i] * xj;
+	}
+    }
+
+    return mixed_norm(n, r);
+}
+
+static int mixed_solve(SUNLinearSolver ls, SUNMatrix A, N_Vector x,
+		       N_Vector b, realtype tol)
+{
+    struct mixed_content *c = MIXED_CONTENT(ls);
+    realtype *xd = N_VGetArrayPointer(x);
+    realtype *bd = N_VGetArrayPointer(b);
+    realtype rnrm, rprev = BIG_REAL, rtol;
+    int n = c->n, i, k, flag;
+
+    if (xd == NULL || bd == NULL) {
+	c->last_flag = SUNLS_MEM_FAIL;
+	return SUNLS_MEM_FAIL;
+    }
+
+    /* b and x may be the same vector */
+    for (i = 0; i < n; ++i) c->bc[i] = bd[i];
+
+    if (c->fallback) {
+	mixed_solve_double(c, xd);
+	c->last_flag = SUNLS_SUCCESS;
+	return SUNLS_SUCCESS;
+    }
+
+    for (i = 0; i < n; ++i) c->w[i] = (float)bd[i];
+    mixed_getrs(c);
+    for (i = 0; i < n; ++i) xd[i] = c->w[i];
+
+    rtol = c->anrm * UNIT_ROUNDOFF * SUNRsqrt((realtype)n);
+    for (k = 0; c->max_refinements > 0; ++k) {
+	rnrm = mixed_residual(c, A, xd);
+	if (rnrm <= rtol * mixed_norm(n, xd)) break;
+
+	/* also catches a NaN residual */
+	if (k == c->max_refinements || !(rnrm < rprev)) {
+	    flag = mixed_fallback(c, A);
+	    if (flag != SUNLS_SUCCESS) {
+		c->last_flag = flag;
+		return (flag == SUNLS_MEM_FAIL) ? flag
+						: SUNLS_PACKAGE_FAIL_REC;
+	    }
+	    mixed_solve_double(c, xd);
+	    break;
+	}
+	rprev = rnrm;
+
+	for (i = 0; i < n; ++i) c->w[i] = (float)c->r[i];
+	mixed_getrs(c);
+	for (i = 0; i < n; ++i) xd[i] += c->w[i];
+    }
+
+    c->last_flag = SUNLS_SUCCESS;
+    return SUNLS_SUCCESS;
+}
+
+static long int mixed_lastflag(SUNLinearSolver ls)
+{
+    return MIXED_CONTENT(ls)->last_flag;
+}
+
+static int mixed_space(SUNLinearSolver ls, long int *lenrw,
+		       long int *leniw)
+{
+    struct mixed_content *c = MIXED_CONTENT(ls);
+
+    /* single-precision words count as half a realtype */
+    *lenrw = 2 * c->n + 1 + ((long int)c->ldab * c->n + c->n + 1) / 2
+		+ ((c->dlu != NULL) ? (long int)c->ldab * c->n : 0);
+    *leniw = 7 + c->n;
+    return SUNLS_SUCCESS;
+}
+
+static void mixed_free_content(struct mixed_content *c)
+{
+    if (c == NULL) return;
+    free(c->lu);
+    free(c->pivots);
+    free(c->w);
+    free(c->r);
+    free(c->bc);
+    free(c->dlu);
+    free(c);
+}
+
+static int mixed_free(SUNLinearSolver ls)
+{
+    mixed_free_content(MIXED_CONTENT(ls));
+    if (ls->ops != NULL) free(ls->ops);
+    free(ls);
+
+    return SUNLS_SUCCESS;
+}
+
+static value alloc_mixed(int n, int band, int kl, int ku,
+			 int max_refinements)
+{
+    struct mixed_content *c;
+    SUNLinearSolver_Ops ops;
+    SUNLinearSolver ls;
+    int ldab = band ? 2 * kl + ku + 1 : n;
+    size_t m = (n > 0) ? n : 1;
+
+    ls = (SUNLinearSolver)malloc(sizeof *ls);
+    ops = (SUNLinearSolver_Ops) malloc(
+	    sizeof(struct _generic_SUNLinearSolver_Ops));
+    c = (struct mixed_content *)calloc(1, sizeof *c);
+    if (c != NULL) {
+	c->lu     = malloc(m * ldab * sizeof(float));
+	c->pivots = malloc(m * sizeof(int));
+	c->w      = malloc(m * sizeof(float));
+	c->r      = malloc(m * sizeof(realtype));
+	c->bc     = malloc(m * sizeof(realtype));
+    }
+    if (ls == NULL || ops == NULL || c == NULL || c->lu == NULL
+	    || c->pivots == NULL || c->w == NULL || c->r == NULL
+	    || c->bc == NULL) {
+	mixed_free_content(c);
+	free(ops);
+	free(ls);
+	caml_raise_out_of_memory();
+    }
+    c->n = n;
+    c->band = band;
+    c->kl = kl;
+    c->ku = ku;
+    c->ldab = ldab;
+    c->max_refinements = max_refinements;
+    c->last_flag = SUNLS_SUCCESS;
+
+    ops->gettype           = mixed_gettype;
+    ops->initialize        = mixed_initialize;
+    ops->setup             = mixed_setup;
+    ops->solve             = mixed_solve;
+    ops->lastflag          = mixed_lastflag;
+    ops->free              = mixed_free;
+    ops->setatimes         = NULL;
+    ops->setpreconditioner = NULL;
+    ops->setscalingvectors = NULL;
+    ops->numiters          = NULL;
+    ops->resnorm           = NULL;
+    ops->resid             = NULL;
+    ops->space             = mixed_space;
+
+    ls->ops = ops;
+    ls->content = c;
+
+    return alloc_lsolver(ls);
+}
+
+#endif
+
+CAMLprim value sunml_lsolver_lapack_dense_mixed(value vnvec, value vdmat,
+						value vmaxref)
+{
+    CAMLparam3(vnvec, vdmat, vmaxref);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_LAPACK \
+	&& !defined SUNDIALS_ML_SINGLE_PRECISION
+    SUNMatrix dmat = MAT_VAL(vdmat);
+
+    if (SUNDenseMatrix_Rows(dmat) != SUNDenseMatrix_Columns(dmat))
+	caml_raise_constant(LSOLVER_EXN(MatrixNotSquare));
+
+    if (SUNDenseMatrix_Rows(dmat) != NV_LENGTH_S(NVEC_VAL(vnvec)))
+	caml_raise_constant(LSOLVER_EXN(MatrixVectorMismatch));
+
+    CAMLreturn(alloc_mixed(SUNDenseMatrix_Rows(dmat), 0, 0, 0,
+			   Int_val(vmaxref)));
+#else
+    CAMLreturn(Val_unit);
+#endif
+}
+
+CAMLprim value sunml_lsolver_lapack_band_mixed(value vnvec, value vbmat,
+					       value vmaxref)
+{
+    CAMLparam3(vnvec, vbmat, vmaxref);
+#if 300 <= SUNDIALS_LIB_VERSION && defined SUNDIALS_ML_LAPACK \
+	&& !defined SUNDIALS_ML_SINGLE_PRECISION
+    SUNMatrix bmat = MAT_VAL(vbmat);
+
+    if (SUNBandMatrix_Rows(bmat) != SUNBandMatrix_Columns(bmat))
+	caml_raise_constant(LSOLVER_EXN(MatrixNotSquare));
+
+    if (SUNBandMatrix_Rows(bmat) != NV_LENGTH_S(NVEC_VAL(vnvec)))
+	caml_raise_constant(LSOLVER_EXN(MatrixVectorMismatch));
+
+    CAMLreturn(alloc_mixed(SUNBandMatrix_Rows(bmat), 1,
+			   SUNBandMatrix_LowerBandwidth(bmat),
+			   SUNBandMatrix_UpperBandwidth(bmat),
+			   Int_val(vmaxref)));
+#else
+    CAMLreturn(Val_unit);
+#endif
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * Iterative
  */
@@ -688,6 +1595,221 @@ CAMLprim value sunml_lsolver_spgmr(value vmaxl, value vnvec)
 #endif
 }
 
+/* Low-synchronization GMRES
+
+   The solver is a SUNDIALS SPGMR whose solve operation is replaced: the
+   content, the options (preconditioning, scaling, restarts) and the other
+   operations are those of SPGMR, but each Arnoldi step orthogonalizes the
+   new basis vector with a single global reduction.  One N_VDotProdMulti
+   gives the inner products against all previous basis vectors together
+   with the squared norm of the new vector, and the norm after projection
+   follows from the Pythagorean identity.  A second (classical) pass is
+   made only when cancellation makes that estimate unreliable.  The
+   gs_type option is ignored.  */
+
+#if 400 <= SUNDIALS_LIB_VERSION
+
+#define LOWSYNC_REORTH (RCONST(1.0e-3))
+
+/* Orthogonalize w against v[0], ..., v[k-1], storing the coefficients in
+   h[0..k-1][k-1] and the norm of the result in *new_norm.  cv and Xv are
+   workspaces of length at least k + 1.  */
+static int lowsync_orthogonalize(N_Vector *v, realtype **h, int k,
+				 N_Vector w, realtype *new_norm,
+				 realtype *cv, N_Vector *Xv)
+{
+    realtype w_norm2, proj2, nrm2;
+    int i, pass;
+
+    for (i = 0; i < k; ++i) h[i][k - 1] = 0.0;
+
+    Xv[0] = w;
+    for (i = 0; i < k; ++i) Xv[i + 1] = v[i];
+
+    for (pass = 0; pass < 2; ++pass) {
+	/* cv[0] = <w, w>, cv[i + 1] = <w, v[i]> */
+	if (N_VDotProdMulti(k + 1, w, Xv, cv) != 0) return -1;
+
+	w_norm2 = cv[0];
+	proj2 = 0.0;
+	for (i = 0; i < k; ++i) {
+	    h[i][k - 1] += cv[i + 1];
+	    proj2 += cv[i + 1] * cv[i + 1];
+	    cv[i + 1] = -cv[i + 1];
+	}
+	cv[0] = 1.0;
+	if (N_VLinearCombination(k + 1, cv, Xv, w) != 0) return -1;
+
+	nrm2 = w_norm2 - proj2;
+	if (nrm2 > LOWSYNC_REORTH * w_norm2) break;
+    }
+
+    *new_norm = (nrm2 > 0.0) ? SUNRsqrt(nrm2) : 0.0;
+    return 0;
+}
+
+#define LOWSYNC_PSOLVE(r, z, lr)					    \
+    do {								    \
+	int ier = c->Psolve(c->PData, (r), (z), delta, (lr));		    \
+	if (ier != 0)							    \
+	    return (c->last_flag = (ier < 0) ? SUNLS_PSOLVE_FAIL_UNREC	    \
+					     : SUNLS_PSOLVE_FAIL_REC);	    \
+    } while (0)
+
+#define LOWSYNC_ATIMES(v, z)						    \
+    do {								    \
+	int ier = c->ATimes(c->ATData, (v), (z));			    \
+	if (ier != 0)							    \
+	    return (c->last_flag = (ier < 0) ? SUNLS_ATIMES_FAIL_UNREC	    \
+					     : SUNLS_ATIMES_FAIL_REC);	    \
+    } while (0)
+
+/* Follows SUNLinSolSolve_SPGMR, except for the orthogonalization.  */
+static int lowsync_solve(SUNLinearSolver ls, SUNMatrix A, N_Vector x,
+			 N_Vector b, realtype delta)
+{
+    SUNLinearSolverContent_SPGMR c = (SUNLinearSolverContent_SPGMR)ls->content;
+    N_Vector *V = c->V, xcor = c->xcor, vtemp = c->vtemp;
+    N_Vector s1 = c->s1, s2 = c->s2;
+    realtype **Hes = c->Hes, *givens = c->givens, *yg = c->yg;
+    realtype beta, rho, r_norm, rotation_product, s_product;
+    int l_max = c->maxl, max_restarts = c->max_restarts;
+    int prec_left = (c->pretype == PREC_LEFT) || (c->pretype == PREC_BOTH);
+    int prec_right = (c->pretype == PREC_RIGHT) || (c->pretype == PREC_BOTH);
+    int converged = 0;
+    int i, j, l, krydim = 0, ntries;
+
+    c->numiters = 0;
+
+    /* vtemp = r_0 = b - A x_0 */
+    if (N_VDotProd(x, x) == 0.0) {
+	N_VScale(1.0, b, vtemp);
+    } else {
+	LOWSYNC_ATIMES(x, vtemp);
+	N_VLinearSum(1.0, b, -1.0, vtemp, vtemp);
+    }
+    N_VScale(1.0, vtemp, V[0]);
+
+    /* V[0] = s1 P1_inv r_0 */
+    if (prec_left) LOWSYNC_PSOLVE(V[0], vtemp, PREC_LEFT);
+    else N_VScale(1.0, V[0], vtemp);
+    if (s1 != NULL) N_VProd(s1, vtemp, V[0]);
+    else N_VScale(1.0, vtemp, V[0]);
+
+    c->resnorm = r_norm = beta = SUNRsqrt(N_VDotProd(V[0], V[0]));
+    if (r_norm <= delta) return (c->last_flag = SUNLS_SUCCESS);
+
+    rho = beta;
+    N_VConst(0.0, xcor);
+
+    for (ntries = 0; ntries <= max_restarts; ++ntries) {
+	for (i = 0; i <= l_max; ++i)
+	    for (j = 0; j < l_max; ++j)
+		Hes[i][j] = 0.0;
+
+	rotation_product = 1.0;
+	N_VScale(1.0 / r_norm, V[0], V[0]);
+
+	for (l = 0; l < l_max; ++l) {
+	    ++c->numiters;
+	    krydim = l + 1;
+
+	    /* V[l+1] = s1 P1_inv A P2_inv s2_inv V[l] */
+	    if (s2 != NULL) N_VDiv(V[l], s2, vtemp);
+	    else N_VScale(1.0, V[l], vtemp);
+	    if (prec_right) {
+		N_VScale(1.0, vtemp, V[l + 1]);
+		LOWSYNC_PSOLVE(V[l + 1], vtemp, PREC_RIGHT);
+	    }
+	    LOWSYNC_ATIMES(vtemp, V[l + 1]);
+	    if (prec_left) LOWSYNC_PSOLVE(V[l + 1], vtemp, PREC_LEFT);
+	    else N_VScale(1.0, V[l + 1], vtemp);
+	    if (s1 != NULL) N_VProd(s1, vtemp, V[l + 1]);
+	    else N_VScale(1.0, vtemp, V[l + 1]);
+
+	    if (lowsync_orthogonalize(V, Hes, l + 1, V[l + 1],
+				      &(Hes[l + 1][l]), c->cv, c->Xv) != 0)
+		return (c->last_flag = SUNLS_VECTOROP_ERR);
+
+	    if (QRfact(krydim, Hes, givens, l) != 0)
+		return (c->last_flag = SUNLS_QRFACT_FAIL);
+
+	    rotation_product *= givens[2 * l + 1];
+	    c->resnorm = rho = SUNRabs(rotation_product * r_norm);
+	    if (rho <= delta) {
+		converged = 1;
+		break;
+	    }
+
+	    N_VScale(1.0 / Hes[l + 1][l], V[l + 1], V[l + 1]);
+	}
+
+	/* xcor += V y, where y solves the least squares problem */
+	yg[0] = r_norm;
+	for (i = 1; i <= krydim; ++i) yg[i] = 0.0;
+	if (QRsol(krydim, Hes, givens, yg) != 0)
+	    return (c->last_flag = SUNLS_QRSOL_FAIL);
+
+	c->cv[0] = 1.0;
+	c->Xv[0] = xcor;
+	for (i = 0; i < krydim; ++i) {
+	    c->cv[i + 1] = yg[i];
+	    c->Xv[i + 1] = V[i];
+	}
+	if (N_VLinearCombination(krydim + 1, c->cv, c->Xv, xcor) != 0)
+	    return (c->last_flag = SUNLS_VECTOROP_ERR);
+
+	if (converged || ntries == max_restarts) break;
+
+	/* restart from the last residual vector */
+	s_product = 1.0;
+	for (i = krydim; i > 0; --i) {
+	    yg[i] = s_product * givens[2 * i - 2];
+	    s_product *= givens[2 * i - 1];
+	}
+	yg[0] = s_product;
+
+	r_norm *= s_product;
+	for (i = 0; i <= krydim; ++i) {
+	    c->cv[i] = yg[i] * r_norm;
+	    c->Xv[i] = V[i];
+	}
+	r_norm = SUNRabs(r_norm);
+	if (N_VLinearCombination(krydim + 1, c->cv, c->Xv, V[0]) != 0)
+	    return (c->last_flag = SUNLS_VECTOROP_ERR);
+    }
+
+    if (!converged && rho >= beta) return (c->last_flag = SUNLS_CONV_FAIL);
+
+    /* x += P2_inv s2_inv xcor */
+    if (s2 != NULL) N_VDiv(xcor, s2, xcor);
+    if (prec_right) LOWSYNC_PSOLVE(xcor, vtemp, PREC_RIGHT);
+    else N_VScale(1.0, xcor, vtemp);
+    N_VLinearSum(1.0, x, 1.0, vtemp, x);
+
+    return (c->last_flag = converged ? SUNLS_SUCCESS : SUNLS_RES_REDUCED);
+}
+
+#undef LOWSYNC_PSOLVE
+#undef LOWSYNC_ATIMES
+
+#endif
+
+CAMLprim value sunml_lsolver_spgmr_lowsync(value vmaxl, value vnvec)
+{
+    CAMLparam2(vmaxl, vnvec);
+#if 400 <= SUNDIALS_LIB_VERSION
+    SUNLinearSolver ls = SUNLinSol_SPGMR(NVEC_VAL(vnvec),
+					 PREC_NONE, Int_val(vmaxl));
+    if (ls == NULL) caml_raise_out_of_memory();
+    ls->ops->solve = lowsync_solve;
+
+    CAMLreturn(alloc_lsolver(ls));
+#else
+    CAMLreturn(Val_unit);
+#endif
+}
+
 CAMLprim value sunml_lsolver_sptfqmr(value vmaxl, value vnvec)
 {
     CAMLparam2(vmaxl, vnvec);
@@ -724,6 +1846,382 @@ CAMLprim value sunml_lsolver_pcg(value vmaxl, value vnvec)
 #endif
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Native preconditioners
+ *
+ * Preconditioners whose solve runs entirely in C: the matrix P is filled
+ * from OCaml by the preconditioner setup function and then factored here,
+ * so the Krylov iterations never call back into OCaml.  The same P is
+ * used for left and right preconditioning.
+ *
+ *   jacobi:	   z = D^-1 r, where D is the given diagonal
+ *   block jacobi: LU factorization of each block of a Matrix.BlockDiag.t
+ *   ilu0:	   incomplete LU factorization, without fill-in, of a
+ *		   Matrix.Sparse.t (stored by rows with sorted columns)
+ */
+
+enum native_prec_kind {
+    NATIVE_PREC_JACOBI = 0,
+    NATIVE_PREC_BLOCK_JACOBI,
+    NATIVE_PREC_ILU0,
+};
+
+struct native_prec {
+    int kind;
+    sundials_ml_index n;
+    sundials_ml_index bsize;		/* block jacobi */
+
+    realtype *lu;			/* inverse diagonal or factors */
+    realtype **cols;			/* block jacobi: columns of lu */
+    sundials_ml_index *piv;		/* block jacobi: pivots */
+
+    sundials_ml_smat_index nnz;		/* ilu0: capacity of lu and idx */
+    sundials_ml_smat_index *ptr;	/* ilu0: n + 1 row pointers */
+    sundials_ml_smat_index *idx;	/* ilu0: column indices */
+    sundials_ml_smat_index *diag;	/* ilu0: position of each pivot */
+    sundials_ml_smat_index *work;	/* ilu0: n */
+};
+
+#define NATIVE_PREC(v) (*(struct native_prec **)Data_custom_val(v))
+
+static void free_native_prec(struct native_prec *p)
+{
+    if (p == NULL) return;
+    free(p->lu);
+    free(p->cols);
+    free(p->piv);
+    free(p->ptr);
+    free(p->idx);
+    free(p->diag);
+    free(p->work);
+    free(p);
+}
+
+static void finalize_native_prec(value vp)
+{
+    free_native_prec(NATIVE_PREC(vp));
+}
+
+CAMLprim value sunml_lsolver_native_make(value vkind, value vn, value vbsize)
+{
+    CAMLparam3(vkind, vn, vbsize);
+    CAMLlocal1(vp);
+    struct native_prec *p;
+    sundials_ml_index n = Long_val(vn), bsize = Long_val(vbsize), i;
+    int ok = 1;
+
+    p = calloc(1, sizeof(struct native_prec));
+    if (p == NULL) caml_raise_out_of_memory();
+    p->kind = Int_val(vkind);
+    p->n = n;
+    p->bsize = bsize;
+
+    switch (p->kind) {
+    case NATIVE_PREC_JACOBI:
+	ok = (p->lu = malloc((n > 0 ? n : 1) * sizeof(realtype))) != NULL;
+	break;
+
+    case NATIVE_PREC_BLOCK_JACOBI:
+	p->lu = malloc((n > 0 ? n * bsize : 1) * sizeof(realtype));
+	p->cols = malloc((n > 0 ? n : 1) * sizeof(realtype *));
+	p->piv = malloc((n > 0 ? n : 1) * sizeof(sundials_ml_index));
+	ok = p->lu != NULL && p->cols != NULL && p->piv != NULL;
+	if (ok)
+	    for (i = 0; i < n; ++i) p->cols[i] = p->lu + i * bsize;
+	break;
+
+    case NATIVE_PREC_ILU0:
+	p->ptr = malloc((n + 1) * sizeof(sundials_ml_smat_index));
+	p->diag = malloc((n > 0 ? n : 1) * sizeof(sundials_ml_smat_index));
+	p->work = malloc((n + 1) * sizeof(sundials_ml_smat_index));
+	ok = p->ptr != NULL && p->diag != NULL && p->work != NULL;
+	break;
+    }
+
+    if (!ok) {
+	free_native_prec(p);
+	caml_raise_out_of_memory();
+    }
+
+    vp = caml_alloc_final(1, &finalize_native_prec, 1, 20);
+    NATIVE_PREC(vp) = p;
+
+    CAMLreturn(vp);
+}
+
+CAMLprim void sunml_lsolver_native_jacobi_factor(value vp, value vdiag)
+{
+    CAMLparam2(vp, vdiag);
+    struct native_prec *p = NATIVE_PREC(vp);
+    realtype *d = REAL_ARRAY(vdiag);
+    sundials_ml_index i;
+
+#if SUNDIALS_ML_SAFE == 1
+    if (Caml_ba_array_val(vdiag)->dim[0] != p->n)
+	caml_invalid_argument("Native.jacobi: diagonal has the wrong length");
+#endif
+
+    for (i = 0; i < p->n; ++i) {
+	if (d[i] == 0.0) caml_raise_constant(SUNDIALS_EXN(RecoverableFailure));
+	p->lu[i] = 1.0 / d[i];
+    }
+
+    CAMLreturn0;
+}
+
+CAMLprim void sunml_lsolver_native_block_jacobi_factor(value vp, value vbd)
+{
+    CAMLparam2(vp, vbd);
+    struct native_prec *p = NATIVE_PREC(vp);
+    sundials_ml_index b, bsize = p->bsize, nblocks;
+
+#if SUNDIALS_ML_SAFE == 1
+    if (BLOCKDIAG_BSIZE(vbd) != bsize
+	    || BLOCKDIAG_NBLOCKS(vbd) * bsize != p->n)
+	caml_invalid_argument("Native.block_jacobi: matrix has the wrong size");
+#endif
+
+    nblocks = BLOCKDIAG_NBLOCKS(vbd);
+    memcpy(p->lu, BLOCKDIAG_DATA(vbd), p->n * bsize * sizeof(realtype));
+    for (b = 0; b < nblocks; ++b)
+	if (denseGETRF(p->cols + b * bsize, bsize, bsize,
+		       p->piv + b * bsize) != 0)
+	    caml_raise_constant(SUNDIALS_EXN(RecoverableFailure));
+
+    CAMLreturn0;
+}
+
+/* Copy A into p in compressed rows with sorted column indices: entries are
+   bucketed by row while walking the columns (transposing a csc matrix),
+   after first walking the rows into the same buckets by column (for a csr
+   matrix).  */
+static int native_ilu0_load(struct native_prec *p,
+			    MAT_CONTENT_SPARSE_TYPE A)
+{
+    sundials_ml_smat_index n = p->n, nnz, i, j, k, *aptr, *aidx;
+    sundials_ml_smat_index *tptr = NULL, *tidx = NULL, *count = p->work;
+    realtype *adata = A->data, *tdata = NULL;
+    int csr;
+
+#if SUNDIALS_LIB_VERSION >= 270
+    aptr = A->indexptrs;
+    aidx = A->indexvals;
+    csr = (A->sparsetype == CSR_MAT);
+#else
+    aptr = A->colptrs;
+    aidx = A->rowvals;
+    csr = 0;
+#endif
+    nnz = aptr[n];
+
+    if (nnz > p->nnz) {
+	realtype *lu = realloc(p->lu, nnz * sizeof(realtype));
+	sundials_ml_smat_index *idx;
+
+	if (lu == NULL) return 0;
+	p->lu = lu;
+	idx = realloc(p->idx, nnz * sizeof(sundials_ml_smat_index));
+	if (idx == NULL) return 0;
+	p->idx = idx;
+	p->nnz = nnz;
+    }
+
+    if (csr) {
+	/* rows to (sorted) columns */
+	tptr = malloc((n + 1) * sizeof(sundials_ml_smat_index));
+	tidx = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_smat_index));
+	tdata = malloc((nnz > 0 ? nnz : 1) * sizeof(realtype));
+	if (tptr == NULL || tidx == NULL || tdata == NULL) {
+	    free(tptr);
+	    free(tidx);
+	    free(tdata);
+	    return 0;
+	}
+
+	for (j = 0; j <= n; ++j) count[j] = 0;
+	for (k = 0; k < nnz; ++k) ++count[aidx[k] + 1];
+	for (j = 0; j < n; ++j) count[j + 1] += count[j];
+	for (j = 0; j <= n; ++j) tptr[j] = count[j];
+	for (i = 0; i < n; ++i)
+	    for (k = aptr[i]; k < aptr[i + 1]; ++k) {
+		sundials_ml_smat_index d = count[aidx[k]]++;
+		tidx[d] = i;
+		tdata[d] = adata[k];
+	    }
+
+	aptr = tptr;
+	aidx = tidx;
+	adata = tdata;
+    }
+
+    /* columns to (sorted) rows */
+    for (i = 0; i <= n; ++i) count[i] = 0;
+    for (k = 0; k < nnz; ++k) ++count[aidx[k] + 1];
+    for (i = 0; i < n; ++i) count[i + 1] += count[i];
+    for (i = 0; i <= n; ++i) p->ptr[i] = count[i];
+    for (j = 0; j < n; ++j)
+	for (k = aptr[j]; k < aptr[j + 1]; ++k) {
+	    sundials_ml_smat_index d = count[aidx[k]]++;
+	    p->idx[d] = j;
+	    p->lu[d] = adata[k];
+	}
+
+    free(tptr);
+    free(tidx);
+    free(tdata);
+    return 1;
+}
+
+/* ILU(0), row by row (IKJ variant).  Returns 0 on success and 1 for a zero
+   (or missing) pivot.  */
+static int native_ilu0(struct native_prec *p)
+{
+    sundials_ml_smat_index n = p->n, i, j, k, kk;
+    sundials_ml_smat_index *ptr = p->ptr, *idx = p->idx, *pos = p->work;
+    realtype *lu = p->lu;
+
+    for (j = 0; j < n; ++j) pos[j] = -1;
+
+    for (i = 0; i < n; ++i) {
+	for (k = ptr[i]; k < ptr[i + 1]; ++k) pos[idx[k]] = k;
+
+	p->diag[i] = -1;
+	for (k = ptr[i]; k < ptr[i + 1]; ++k) {
+	    sundials_ml_smat_index r = idx[k];
+	    realtype l;
+
+	    if (r >= i) {
+		if (r == i) p->diag[i] = k;
+		break;
+	    }
+
+	    l = (lu[k] /= lu[p->diag[r]]);
+	    for (kk = p->diag[r] + 1; kk < ptr[r + 1]; ++kk)
+		if (pos[idx[kk]] >= 0) lu[pos[idx[kk]]] -= l * lu[kk];
+	}
+
+	for (k = ptr[i]; k < ptr[i + 1]; ++k) pos[idx[k]] = -1;
+
+	if (p->diag[i] < 0 || lu[p->diag[i]] == 0.0) return 1;
+    }
+
+    return 0;
+}
+
+CAMLprim void sunml_lsolver_native_ilu0_factor(value vp, value va)
+{
+    CAMLparam2(vp, va);
+    struct native_prec *p = NATIVE_PREC(vp);
+    MAT_CONTENT_SPARSE_TYPE A =
+	MAT_CONTENT_SPARSE(Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR));
+
+#if SUNDIALS_ML_SAFE == 1
+    if (A->M != p->n || A->N != p->n)
+	caml_invalid_argument("Native.ilu0: matrix has the wrong size");
+#endif
+
+    if (!native_ilu0_load(p, A)) caml_raise_out_of_memory();
+    if (native_ilu0(p) != 0)
+	caml_raise_constant(SUNDIALS_EXN(RecoverableFailure));
+
+    CAMLreturn0;
+}
+
+static void native_prec_apply(struct native_prec *p, realtype *r, realtype *z)
+{
+    sundials_ml_index n = p->n, i, b;
+    sundials_ml_smat_index k;
+
+    switch (p->kind) {
+    case NATIVE_PREC_JACOBI:
+	for (i = 0; i < n; ++i) z[i] = p->lu[i] * r[i];
+	break;
+
+    case NATIVE_PREC_BLOCK_JACOBI:
+	if (z != r) memcpy(z, r, n * sizeof(realtype));
+	for (b = 0; b < n / p->bsize; ++b)
+	    denseGETRS(p->cols + b * p->bsize, p->bsize,
+		       p->piv + b * p->bsize, z + b * p->bsize);
+	break;
+
+    case NATIVE_PREC_ILU0:
+	/* L y = r (unit diagonal), then U z = y; both in place in z */
+	for (i = 0; i < n; ++i) {
+	    realtype s = r[i];
+	    for (k = p->ptr[i]; k < p->diag[i]; ++k)
+		s -= p->lu[k] * z[p->idx[k]];
+	    z[i] = s;
+	}
+	for (i = n - 1; i >= 0; --i) {
+	    realtype s = z[i];
+	    for (k = p->diag[i] + 1; k < p->ptr[i + 1]; ++k)
+		s -= p->lu[k] * z[p->idx[k]];
+	    z[i] = s / p->lu[p->diag[i]];
+	}
+	break;
+    }
+}
+
+/* The length of a vector whose elements are stored in a single local
+   array, or -1 for other kinds of vectors.  */
+static sundials_ml_index native_prec_length(N_Vector v)
+{
+#if SUNDIALS_LIB_VERSION >= 270
+    switch (N_VGetVectorID(v)) {
+    case SUNDIALS_NVEC_SERIAL:
+    case SUNDIALS_NVEC_OPENMP:
+    case SUNDIALS_NVEC_PTHREADS:
+	/* their contents all start with the length */
+	return NV_LENGTH_S(v);
+    default:
+	return -1;
+    }
+#else
+    return NV_LENGTH_S(v);
+#endif
+}
+
+/* A block-Jacobi preconditioner with empty blocks cannot be applied.  */
+static int native_prec_valid(struct native_prec *p)
+{
+    return p->kind != NATIVE_PREC_BLOCK_JACOBI || p->bsize > 0;
+}
+
+/* Called by the solvers, which supply arbitrary nvectors: anything but a
+   vector of the factored size is an unrecoverable failure.  */
+int sunml_lsolver_native_prec_solve(value vp, N_Vector r, N_Vector z)
+{
+    struct native_prec *p = NATIVE_PREC(vp);
+    realtype *rd = N_VGetArrayPointer(r);
+    realtype *zd = N_VGetArrayPointer(z);
+
+    if (rd == NULL || zd == NULL
+	    || native_prec_length(r) != p->n || native_prec_length(z) != p->n
+	    || !native_prec_valid(p))
+	return -1;
+
+    native_prec_apply(p, rd, zd);
+    return 0;
+}
+
+CAMLprim void sunml_lsolver_native_solve(value vp, value vr, value vz)
+{
+    CAMLparam3(vp, vr, vz);
+    struct native_prec *p = NATIVE_PREC(vp);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (Caml_ba_array_val(vr)->dim[0] != p->n
+	    || Caml_ba_array_val(vz)->dim[0] != p->n)
+	caml_invalid_argument("Native.solve: vector has the wrong length");
+#endif
+    if (!native_prec_valid(p))
+	caml_invalid_argument("Native.solve: empty blocks");
+
+    native_prec_apply(p, REAL_ARRAY(vr), REAL_ARRAY(vz));
+
+    CAMLreturn0;
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * Custom
  */
@@ -1368,7 +2866,7 @@ int ocaml_psolve(void *callback_croot,
 #if 300 <= SUNDIALS_LIB_VERSION
 static void sunml_lsolver_check_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == SUNLS_SUCCESS) return;
 
@@ -15,6 +15,7 @@
 #define _LSOLVER_ML_H__
 
 #include <caml/mlvalues.h>
+#include <sundials/sundials_nvector.h>
 
 #if SUNDIALS_LIB_VERSION >= 300
 
@@ -33,6 +34,10 @@ enum preconditioning_type_tag {
 int sunml_lsolver_precond_type(value);
 int sunml_lsolver_gs_type(value);
 
+/* Apply a native preconditioner (LinearSolver.Native) to the
+   serial nvector r, storing the result in z (which may be r).  */
+int sunml_lsolver_native_prec_solve(value vprec, N_Vector r, N_Vector z);
+
 // ONLY the constructors without arguments, since we decode with Int_val.
 // In any case, only the iterative ones are used from C.
 enum lsolver_solver_data_tag {
@@ -47,6 +52,7 @@ enum lsolver_solver_data_tag {
     VARIANT_LSOLVER_SOLVER_DATA_LAPACKDENSE,
     VARIANT_LSOLVER_SOLVER_DATA_BAND,
     VARIANT_LSOLVER_SOLVER_DATA_LAPACKBAND,
+    VARIANT_LSOLVER_SOLVER_DATA_BLOCKDIAG,
     // NO! VARIANT_LSOLVER_SOLVER_DATA_KLU,
     // NO! VARIANT_LSOLVER_SOLVER_DATA_SUPERLUMT,
     /* custom */
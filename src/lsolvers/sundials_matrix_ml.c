@@ -15,6 +15,8 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <limits.h>
 
 #if SUNDIALS_LIB_VERSION >= 300
 #include <sundials/sundials_matrix.h>
@@ -49,6 +51,15 @@
 #include <caml/fail.h>
 #include <caml/bigarray.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* The matvec and scale_add kernels on band and sparse matrices are shared
+   among OpenMP threads when the library is compiled with OpenMP, for
+   matrices with at least this many (stored) nonzeros.  */
+#define MATRIX_OMP_MIN_NNZ 20000
+
 extern CAMLprim value caml_ba_blit(value vsrc, value vdst);
 
 CAMLprim void sunml_mat_init_module (value exns)
@@ -671,30 +682,65 @@ CAMLprim void sunml_matrix_band_scale_addi(value vc, value va)
     CAMLreturn0;
 }
 
-CAMLprim void sunml_matrix_band_matvec(value va, value vx, value vy)
+static void matrix_band_matvec(MAT_CONTENT_BAND_TYPE a,
+			       realtype *xd, realtype *yd)
 {
-    CAMLparam3(va, vx, vy);
     sundials_ml_index i, j, is, ie;
-    realtype *col_j, *xd, *yd;
-    MAT_CONTENT_BAND_TYPE a = MAT_CONTENT_BAND(va);
-
-    xd = REAL_ARRAY(vx);
-    yd = REAL_ARRAY(vy);
+    realtype *col_j;
+
+#ifdef _OPENMP
+    /* Row-parallel: each thread computes whole elements of y.  */
+    if (a->M * (a->mu + a->ml + 1) >= MATRIX_OMP_MIN_NNZ
+	    && omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(static) private(j, is, ie)
+	for (i=0; i < a->M; i++) {
+	    realtype s = 0.0;
+
+	    is = SUNMAX(0, i - a->ml);
+	    ie = SUNMIN(a->N - 1, i + a->mu);
+	    for (j=is; j <= ie; j++)
+		s += a->cols[j][i - j + a->s_mu] * xd[j];
+	    yd[i] = s;
+	}
+	return;
+    }
+#endif
 
     // Adapted directly from SUNMatMatvec_Band
     for (i=0; i < a->M; i++)
 	yd[i] = 0.0;
     for(j=0; j < a->N; j++) {
+	realtype xj = xd[j];
+
 	col_j = a->cols[j] + a->s_mu;
 	is = SUNMAX(0, j - a->mu);
 	ie = SUNMIN(a->M - 1, j + a->ml);
 	for (i=is; i <= ie; i++)
-	    yd[i] += col_j[i-j]*xd[j];
+	    yd[i] += col_j[i-j]*xj;
     }
+}
+
+CAMLprim void sunml_matrix_band_matvec(value va, value vx, value vy)
+{
+    CAMLparam3(va, vx, vy);
+
+    matrix_band_matvec(MAT_CONTENT_BAND(va), REAL_ARRAY(vx), REAL_ARRAY(vy));
 
     CAMLreturn0;
 }
 
+#if SUNDIALS_LIB_VERSION >= 300
+static int csmat_band_matvec(SUNMatrix A, N_Vector x, N_Vector y)
+{
+    realtype *xd = N_VGetArrayPointer(x);
+    realtype *yd = N_VGetArrayPointer(y);
+
+    if (xd == NULL || yd == NULL || xd == yd) return 1;
+    matrix_band_matvec(SM_CONTENT_B(A), xd, yd);
+    return 0;
+}
+#endif
+
 #if SUNDIALS_LIB_VERSION < 300
 CAMLprim value sunml_matrix_band_wrap(DlsMat a)
 {
@@ -862,6 +908,50 @@ CAMLprim void sunml_matrix_sparse_set_to_zero(value vcptr)
     CAMLparam1(vcptr);
     CAMLreturn0;
 }
+
+CAMLprim void sunml_matrix_sparse_set_frozen(value vcptr, value vfrozen)
+{
+    CAMLparam2(vcptr, vfrozen);
+    CAMLreturn0;
+}
+
+CAMLprim value sunml_matrix_sparse_is_frozen(value vcptr)
+{
+    CAMLparam1(vcptr);
+    CAMLreturn(Val_false);
+}
+
+CAMLprim value sunml_matrix_sparse_share_pattern(value va)
+{
+    CAMLparam1(va);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_matrix_sparse_is_shared(value vcptr)
+{
+    CAMLparam1(vcptr);
+    CAMLreturn(Val_false);
+}
+
+CAMLprim value sunml_matrix_sparse_make_pattern(value vsformat, value vm,
+						value vn, value vrows,
+						value vcols)
+{
+    CAMLparam5(vsformat, vm, vn, vrows, vcols);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_matrix_sparse_pattern_nnz(value vp)
+{
+    CAMLparam1(vp);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim void sunml_matrix_sparse_assemble(value vp, value vvals, value va)
+{
+    CAMLparam3(vp, vvals, va);
+    CAMLreturn0;
+}
 #else
 
 static void finalize_mat_content_sparse(value vcptra)
@@ -871,6 +961,7 @@ static void finalize_mat_content_sparse(value vcptra)
 #if SUNDIALS_LIB_VERSION >= 300
     /* indexvals, indexptrs, and data are freed when the corresponding
        bigarrays are finalized */
+    sunml_sparse_share_release(MAT_SPARSE_SHARE(vcptra));
     free(content);
 
 #elif SUNDIALS_LIB_VERSION >= 270
@@ -906,6 +997,15 @@ static void zero_sparse(MAT_CONTENT_SPARSE_TYPE A)
     indexptrs[A->NP] = 0L;
 }
 
+// Only zero the values of a matrix whose sparsity pattern is frozen
+static void zero_sparse_values(MAT_CONTENT_SPARSE_TYPE A)
+{
+    sundials_ml_smat_index i;
+
+    for (i=0; i < A->NNZ; i++)
+	A->data[i] = 0.0;
+}
+
 static bool matrix_sparse_create_vcptr(sundials_ml_smat_index m,
 				       sundials_ml_smat_index n,
 				       sundials_ml_smat_index nnz,
@@ -979,8 +1079,10 @@ static bool matrix_sparse_create_vcptr(sundials_ml_smat_index m,
     zero_sparse(content); // reproduce effect of callocs in Sundials code
 
     // Setup the OCaml-side
-    *pvcptr = caml_alloc_final(1, &finalize_mat_content_sparse, 1, 20);
+    *pvcptr = caml_alloc_final(3, &finalize_mat_content_sparse, 1, 20);
     MAT_CONTENT_SPARSE(*pvcptr) = content;
+    MAT_SPARSE_FROZEN(*pvcptr) = 0;
+    MAT_SPARSE_SHARE(*pvcptr) = NULL;
 
 #else // SUNDIALS_LIB_VERSION < 300 (As per c_sparsematrix_new_sparse_mat)
 
@@ -1000,8 +1102,10 @@ static bool matrix_sparse_create_vcptr(sundials_ml_smat_index m,
 #endif
     *pvdata = caml_ba_alloc_dims(BIGARRAY_FLOAT, 1, a->data, a->NNZ);
 
-    *pvcptr = caml_alloc_final(1, finalize_mat_content_sparse, 1, 20);
+    *pvcptr = caml_alloc_final(3, finalize_mat_content_sparse, 1, 20);
     SLSMAT(*pvcptr) = a;
+    MAT_SPARSE_FROZEN(*pvcptr) = 0;
+    MAT_SPARSE_SHARE(*pvcptr) = NULL;
 
 #endif
 
@@ -1256,6 +1360,7 @@ static bool matrix_sparse_resize(value va, sundials_ml_smat_index nnz,
     // holding vpayload ensures that the underlying arrays are not gc-ed.
     vpayload = Field(va, RECORD_MAT_MATRIXCONTENT_PAYLOAD);
     A = MAT_CONTENT_SPARSE(vcptr);
+    if (MAT_SPARSE_SHARE(vcptr) != NULL) CAMLreturnT(bool, false);
 
 #if SUNDIALS_LIB_VERSION >= 270
     old_indexptrs = A->indexptrs;
@@ -1366,6 +1471,35 @@ static bool matrix_sparse_resize(value va, sundials_ml_smat_index nnz,
     CAMLreturnT(bool, true);
 }
 
+// Returns true if A and B have the same format and sparsity pattern
+static bool matrix_sparse_same_pattern(MAT_CONTENT_SPARSE_TYPE A,
+				       MAT_CONTENT_SPARSE_TYPE B)
+{
+    sundials_ml_smat_index np, *Ap, *Ai, *Bp, *Bi;
+
+    if (A->M != B->M || A->N != B->N) return false;
+
+#if SUNDIALS_LIB_VERSION >= 270
+    if (A->sparsetype != B->sparsetype) return false;
+    np = A->NP;
+    Ap = A->indexptrs;
+    Ai = A->indexvals;
+    Bp = B->indexptrs;
+    Bi = B->indexvals;
+#else
+    np = A->N;
+    Ap = A->rowvals;
+    Ai = A->colptrs;
+    Bp = B->rowvals;
+    Bi = B->colptrs;
+#endif
+
+    if (Ap == Bp && Ai == Bi) return true;
+    if (Ap[np] != Bp[np]) return false;
+    return (memcmp(Ap, Bp, (np + 1) * sizeof(sundials_ml_smat_index)) == 0
+	    && memcmp(Ai, Bi, Ap[np] * sizeof(sundials_ml_smat_index)) == 0);
+}
+
 // Adapted directly from SUNMatScaleAdd_Sparse
 static bool matrix_sparse_scale_add(realtype c, value va, value vcptrb)
 {
@@ -1384,6 +1518,25 @@ static bool matrix_sparse_scale_add(realtype c, value va, value vcptrb)
     A = MAT_CONTENT_SPARSE(vcptra);
     B = MAT_CONTENT_SPARSE(vcptrb);
 
+    /* Fast path: when the patterns are the same, the values are combined
+       in a single pass */
+    if (matrix_sparse_same_pattern(A, B)) {
+	realtype *Ad = A->data, *Bd = B->data;
+#if SUNDIALS_LIB_VERSION >= 270
+	nz = A->indexptrs[A->NP];
+#else
+	nz = A->rowvals[A->N];
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (nz >= MATRIX_OMP_MIN_NNZ)
+#endif
+	for (p=0; p < nz; p++)
+	    Ad[p] = c*Ad[p] + Bd[p];
+
+	CAMLreturnT(bool, true);
+    }
+
     /* Perform operation */
 
 #if SUNDIALS_LIB_VERSION >= 270
@@ -1448,6 +1601,8 @@ static bool matrix_sparse_scale_add(realtype c, value va, value vcptrb)
     /* If extra nonzeros required, check whether A has sufficient storage space
        for new nonzero entries (so B can be inserted into existing storage) */
     newmat = (newvals > (A->NNZ - A_indexptrs[N]));
+    if (newvals > 0 && MAT_SPARSE_SHARE(vcptra) != NULL)
+	CAMLreturnT(bool, false);	/* a shared pattern is never rewritten */
 
     /* perform operation based on existing/necessary structure */
 
@@ -1710,6 +1865,8 @@ static bool matrix_sparse_scale_addi(realtype c, value va)
        storage space for new nonzero entries  (so I can be inserted into
        existing storage) */
     newmat = (newvals > (A->NNZ - A_indexptrs[N]));
+    if (newvals > 0 && MAT_SPARSE_SHARE(vcptr) != NULL)
+	CAMLreturnT(bool, false);	/* a shared pattern is never rewritten */
 
     /* perform operation based on existing/necessary structure */
 
@@ -1890,16 +2047,12 @@ static int csmat_sparse_scale_addi(realtype c, SUNMatrix A)
 
 // Adapted directly from SUNMatMatvec_Sparse, Matvec_SparseCSC, and
 // Matvec_SparseCSR
-CAMLprim void sunml_matrix_sparse_matvec(value vcptra, value vx, value vy)
+static void matrix_sparse_matvec(MAT_CONTENT_SPARSE_TYPE A,
+				 realtype *xd, realtype *yd)
 {
-    CAMLparam3(vcptra, vx, vy);
-    MAT_CONTENT_SPARSE_TYPE A = MAT_CONTENT_SPARSE(vcptra);
-    sundials_ml_smat_index i, j;
+    sundials_ml_smat_index i, j, nnz;
     sundials_ml_smat_index *Ap, *Ai;
-    realtype *Ax, *xd, *yd;
-
-    xd = REAL_ARRAY(vx);
-    yd = REAL_ARRAY(vy);
+    realtype *Ax;
 
 #if SUNDIALS_LIB_VERSION >= 270
     Ap = A->indexptrs;
@@ -1910,30 +2063,108 @@ CAMLprim void sunml_matrix_sparse_matvec(value vcptra, value vx, value vy)
 #endif
     Ax = A->data;
 
-    /* initialize result */
-    for (i=0; i < A->M; i++)
-	yd[i] = 0.0;
-
-    if (A->sparsetype == CSC_MAT) {
-	/* iterate through matrix columns */
-	for (j=0; j < A->N; j++) {
-	    /* iterate down column of A, performing product */
-	    for (i=Ap[j]; i < Ap[j+1]; i++)
-		yd[Ai[i]] += Ax[i]*xd[j];
-	}
+#if SUNDIALS_LIB_VERSION >= 270
+    nnz = Ap[A->NP];
+#else
+    nnz = Ap[A->N];
+#endif
 
-    } else {
-	/* iterate through matrix rows */
+#if SUNDIALS_LIB_VERSION >= 270
+    if (A->sparsetype == CSR_MAT) {
+	/* iterate through matrix rows (in parallel) */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(j) \
+	    if (nnz >= MATRIX_OMP_MIN_NNZ)
+#endif
 	for (i=0; i < A->M; i++) {
+	    realtype s = 0.0;
+
 	    /* iterate along row of A, performing product */
 	    for (j=Ap[i]; j < Ap[i+1]; j++)
-		yd[i] += Ax[j]*xd[Ai[j]];
+		s += Ax[j]*xd[Ai[j]];
+	    yd[i] = s;
+	}
+	return;
+    }
+#endif
+
+#ifdef _OPENMP
+    /* Two passes over private copies of y: threads accumulate the products
+       of their columns, and then sum the copies row by row.  */
+    if (nnz >= MATRIX_OMP_MIN_NNZ && omp_get_max_threads() > 1) {
+	int nthreads = omp_get_max_threads();
+	realtype *ybuf = malloc((size_t)nthreads * A->M * sizeof(realtype));
+
+	if (ybuf != NULL) {
+#pragma omp parallel num_threads(nthreads) private(i, j)
+	    {
+		int t, nt = omp_get_num_threads();
+		realtype *yt = ybuf + (size_t)omp_get_thread_num() * A->M;
+
+		for (i=0; i < A->M; i++)
+		    yt[i] = 0.0;
+
+#pragma omp for schedule(static)
+		for (j=0; j < A->N; j++) {
+		    realtype xj = xd[j];
+		    sundials_ml_smat_index p;
+
+		    for (p=Ap[j]; p < Ap[j+1]; p++)
+			yt[Ai[p]] += Ax[p]*xj;
+		}
+
+#pragma omp for schedule(static)
+		for (i=0; i < A->M; i++) {
+		    realtype s = 0.0;
+
+		    for (t=0; t < nt; t++)
+			s += ybuf[(size_t)t * A->M + i];
+		    yd[i] = s;
+		}
+	    }
+	    free(ybuf);
+	    return;
 	}
     }
+#endif
+
+    /* initialize result */
+    for (i=0; i < A->M; i++)
+	yd[i] = 0.0;
+
+    /* iterate through matrix columns */
+    for (j=0; j < A->N; j++) {
+	realtype xj = xd[j];
+	sundials_ml_smat_index p;
+
+	/* iterate down column of A, performing product */
+	for (p=Ap[j]; p < Ap[j+1]; p++)
+	    yd[Ai[p]] += Ax[p]*xj;
+    }
+}
+
+CAMLprim void sunml_matrix_sparse_matvec(value vcptra, value vx, value vy)
+{
+    CAMLparam3(vcptra, vx, vy);
+
+    matrix_sparse_matvec(MAT_CONTENT_SPARSE(vcptra),
+			 REAL_ARRAY(vx), REAL_ARRAY(vy));
 
     CAMLreturn0;
 }
 
+#if SUNDIALS_LIB_VERSION >= 300
+static int csmat_sparse_matvec(SUNMatrix A, N_Vector x, N_Vector y)
+{
+    realtype *xd = N_VGetArrayPointer(x);
+    realtype *yd = N_VGetArrayPointer(y);
+
+    if (xd == NULL || yd == NULL || xd == yd) return 1;
+    matrix_sparse_matvec(SM_CONTENT_S(A), xd, yd);
+    return 0;
+}
+#endif
+
 CAMLprim void sunml_matrix_sparse_resize(value va, value vnnz, value vcopy)
 {
     CAMLparam3(va, vnnz, vcopy);
@@ -1942,6 +2173,30 @@ CAMLprim void sunml_matrix_sparse_resize(value va, value vnnz, value vcopy)
     CAMLreturn0;
 }
 
+/* Whether the structure of A is exactly the given one.  */
+static bool sparse_has_pattern(MAT_CONTENT_SPARSE_TYPE A,
+			       sundials_ml_smat_index np,
+			       sundials_ml_smat_index *indexptrs,
+			       sundials_ml_smat_index *indexvals)
+{
+    sundials_ml_smat_index *A_indexptrs, *A_indexvals;
+
+#if SUNDIALS_LIB_VERSION >= 270
+    A_indexptrs = A->indexptrs;
+    A_indexvals = A->indexvals;
+#else
+    A_indexptrs = A->rowvals;
+    A_indexvals = A->colptrs;
+#endif
+
+    return (A->NP == np
+	    && A_indexptrs[np] == indexptrs[np]
+	    && memcmp(A_indexptrs, indexptrs,
+		      np * sizeof(sundials_ml_smat_index)) == 0
+	    && memcmp(A_indexvals, indexvals,
+		      indexptrs[np] * sizeof(sundials_ml_smat_index)) == 0);
+}
+
 // Adapted directly from SUNMatCopy_Sparse
 static bool matrix_sparse_copy(value vcptra, value vb)
 {
@@ -1966,6 +2221,17 @@ static bool matrix_sparse_copy(value vcptra, value vb)
     /* Perform operation */
     A_nz = A_indexptrs[A->NP];
 
+    /* only copy the values into a matrix with a frozen pattern, unless the
+       pattern has changed */
+    if (MAT_SPARSE_FROZEN(vcptrb)
+	    && sparse_has_pattern(B, A->NP, A_indexptrs, A_indexvals)) {
+	memcpy(B->data, A->data, A_nz * sizeof(realtype));
+	CAMLreturnT(bool, true);
+    }
+
+    /* a shared pattern is never rewritten */
+    if (MAT_SPARSE_SHARE(vcptrb) != NULL) CAMLreturnT(bool, false);
+
     /* ensure that B is allocated with at least as
     much memory as we have nonzeros in A */
     if (B->NNZ < A_nz)
@@ -2166,8 +2432,10 @@ CAMLprim value sunml_matrix_sparse_wrap(SlsMat a)
 
     vpayload = sparse_wrap_payload(a);
 
-    vcptr = caml_alloc_final(1, NULL, 1, 20);
+    vcptr = caml_alloc_final(3, NULL, 1, 20);
     SLSMAT(vcptr) = a;
+    MAT_SPARSE_FROZEN(vcptr) = 0;
+    MAT_SPARSE_SHARE(vcptr) = NULL;
 
     vr = caml_alloc_tuple(RECORD_MAT_MATRIXCONTENT_SIZE);
     Store_field(vr, RECORD_MAT_MATRIXCONTENT_PAYLOAD, vpayload);
@@ -2186,78 +2454,853 @@ CAMLprim void sunml_matrix_sparse_set_to_zero(value vcptr)
     MAT_CONTENT_SPARSE_TYPE content = MAT_CONTENT_SPARSE(vcptr);
 
     /* Perform operation */
-    zero_sparse(content);
+    if (MAT_SPARSE_FROZEN(vcptr)) zero_sparse_values(content);
+    else zero_sparse(content);
 
     CAMLreturn0;
 }
 
+CAMLprim void sunml_matrix_sparse_set_frozen(value vcptr, value vfrozen)
+{
+    CAMLparam2(vcptr, vfrozen);
+#if SUNDIALS_LIB_VERSION >= 300
+    if (!Bool_val(vfrozen) && MAT_SPARSE_SHARE(vcptr) != NULL)
+	caml_invalid_argument("Matrix.Sparse.thaw_pattern: shared pattern");
 #endif
+    MAT_SPARSE_FROZEN(vcptr) = Bool_val(vfrozen);
+    CAMLreturn0;
+}
 
-/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * Matrix
- */
+CAMLprim value sunml_matrix_sparse_is_frozen(value vcptr)
+{
+    CAMLparam1(vcptr);
+    CAMLreturn(Val_bool(MAT_SPARSE_FROZEN(vcptr)));
+}
+
+/* Shared patterns.
+
+   The matrices that share a pattern share the idxvals and idxptrs
+   bigarrays, which the garbage collector frees after the last of them,
+   and a struct sunml_sparse_share, which is reference counted by their
+   finalizers and by the KLU solvers that borrow its symbolic analysis.
+   Shared patterns are frozen and never rewritten: the operations that
+   would change them fail instead.  */
 
 #if SUNDIALS_LIB_VERSION >= 300
-/*
- *  Type	    content		    backlink
- *  --------+-------------------------------------------------
- *  dense   | MAT_CONTENT_DENSE_TYPE	    Dense.t  (matrix_content)
- *  band    | MAT_CONTENT_BAND_TYPE	    Band.t   (matrix_content)
- *  sparse  | MAT_CONTENT_SPARSE_TYPE	    Sparse.t (matrix_content)
- *  custom  | matrix_ops record		    'm (custom data)
- */
-static SUNMatrix alloc_smat(void *content, value backlink,
-			    bool content_is_value)
+void sunml_sparse_share_release(struct sunml_sparse_share *s)
 {
-    SUNMatrix smat;
+    if (s == NULL || --s->refs > 0) return;
+    if (s->symbolic != NULL && s->free_symbolic != NULL)
+	s->free_symbolic(s->symbolic);
+    free(s);
+}
 
-    /* Alloc memory in C heap */
-    smat = (SUNMatrix)malloc(sizeof(struct csmat));
-    if (smat == NULL) return NULL;
+struct sunml_sparse_share *sunml_matrix_sparse_share(SUNMatrix A)
+{
+    if (SUNMatGetID(A) != SUNMATRIX_SPARSE
+	    || A->ops->copy != csmat_sparse_copy)
+	return NULL;
+    return MAT_SPARSE_SHARE(
+	    Field(MAT_BACKLINK(A), RECORD_MAT_MATRIXCONTENT_RAWPTR));
+}
 
-    smat->ops = (SUNMatrix_Ops)malloc(sizeof(struct _generic_SUNMatrix_Ops));
-    if (smat->ops == NULL) { free(smat); return(NULL); }
+/* Returns in *vr a new matrix with the pattern of va and zero values.  */
+static bool matrix_sparse_share_create(value va, value *vr)
+{
+    CAMLparam1(va);
+    CAMLlocal5(vcptra, vpayloada, vdata, vcptr, vpayload);
+    MAT_CONTENT_SPARSE_TYPE A, content;
+    struct sunml_sparse_share *s;
+    realtype *data;
 
-    smat->content = content;
-    if (content_is_value) // NB: free_smat does not unregister the content
-	caml_register_generational_global_root((value *)&(smat->content));
+    vcptra = Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+    vpayloada = Field(va, RECORD_MAT_MATRIXCONTENT_PAYLOAD);
+    A = MAT_CONTENT_SPARSE(vcptra);
 
-    MAT_BACKLINK(smat) = backlink;
-    caml_register_generational_global_root(&MAT_BACKLINK(smat));
+    s = MAT_SPARSE_SHARE(vcptra);
+    if (s == NULL) {
+	s = calloc(1, sizeof(struct sunml_sparse_share));
+	if (s == NULL) CAMLreturnT(bool, false);
+	s->refs = 1;
+	MAT_SPARSE_SHARE(vcptra) = s;
+    }
+    MAT_SPARSE_FROZEN(vcptra) = 1;
 
-    return smat;
+    data = (realtype *) calloc(A->NNZ, sizeof(realtype));
+    if (data == NULL) CAMLreturnT(bool, false);
+
+    content = (SUNMatrixContent_Sparse) malloc(sizeof *content);
+    if (content == NULL) {
+	free(data);
+	CAMLreturnT(bool, false);
+    }
+    *content = *A;
+    content->data = data;
+    if (content->sparsetype == CSC_MAT) {
+	content->rowvals = &(content->indexvals);
+	content->colptrs = &(content->indexptrs);
+    } else {
+	content->colvals = &(content->indexvals);
+	content->rowptrs = &(content->indexptrs);
+    }
+
+    vdata = caml_ba_alloc_dims(BIGARRAY_FLOAT | CAML_BA_MANAGED,
+			       1, data, A->NNZ);
+
+    vcptr = caml_alloc_final(3, &finalize_mat_content_sparse, 1, 20);
+    MAT_CONTENT_SPARSE(vcptr) = content;
+    MAT_SPARSE_FROZEN(vcptr) = 1;
+    MAT_SPARSE_SHARE(vcptr) = s;
+    ++s->refs;
+
+    vpayload = caml_alloc_tuple(RECORD_MAT_SPARSEDATA_SIZE);
+    Store_field(vpayload, RECORD_MAT_SPARSEDATA_IDXVALS,
+		Field(vpayloada, RECORD_MAT_SPARSEDATA_IDXVALS));
+    Store_field(vpayload, RECORD_MAT_SPARSEDATA_IDXPTRS,
+		Field(vpayloada, RECORD_MAT_SPARSEDATA_IDXPTRS));
+    Store_field(vpayload, RECORD_MAT_SPARSEDATA_DATA, vdata);
+    Store_field(vpayload, RECORD_MAT_SPARSEDATA_SFORMAT,
+		Field(vpayloada, RECORD_MAT_SPARSEDATA_SFORMAT));
+
+    *vr = caml_alloc_tuple(RECORD_MAT_MATRIXCONTENT_SIZE);
+    Store_field(*vr, RECORD_MAT_MATRIXCONTENT_PAYLOAD, vpayload);
+    Store_field(*vr, RECORD_MAT_MATRIXCONTENT_RAWPTR,  vcptr);
+    Store_field(*vr, RECORD_MAT_MATRIXCONTENT_VALID,   Val_bool(1));
+
+    CAMLreturnT(bool, true);
 }
+#endif
 
-#define MAT_OP_TABLE(smat)  ((smat)->content)
-#define GET_OP(smat, x) (Field((value)MAT_OP_TABLE(smat), x))
+CAMLprim value sunml_matrix_sparse_share_pattern(value va)
+{
+    CAMLparam1(va);
+    CAMLlocal1(vr);
+#if SUNDIALS_LIB_VERSION >= 300
+    if (! matrix_sparse_share_create(va, &vr))
+	caml_raise_out_of_memory();
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn(vr);
+}
 
-static void free_smat(SUNMatrix smat)
+CAMLprim value sunml_matrix_sparse_is_shared(value vcptr)
 {
-    caml_remove_generational_global_root(&MAT_BACKLINK(smat));
-    // smat->content is not owned by the sunmatrix
-    free(smat->ops);
-    free(smat);
+    CAMLparam1(vcptr);
+#if SUNDIALS_LIB_VERSION >= 300
+    CAMLreturn(Val_bool(MAT_SPARSE_SHARE(vcptr) != NULL));
+#else
+    CAMLreturn(Val_false);
+#endif
 }
 
-static void free_custom_smat(SUNMatrix smat)
+
+/* Assembly from triplets (coordinate format).
+
+   A pattern records where each triplet of a given list lands in the
+   compressed storage: the entries are sorted by column (csc) or row (csr)
+   and then by row (csc) or column (csr), and duplicates are merged.  Once
+   the pattern is known, the assembly of a matrix copies the index arrays and
+   scatters (and sums) the values in a single pass.  */
+
+struct sparse_pattern {
+    sundials_ml_smat_index m, n, np, nt, nnz;
+    sundials_ml_smat_index *dst;	/* nt destinations in data */
+    sundials_ml_smat_index *indexptrs;	/* np + 1 */
+    sundials_ml_smat_index *indexvals;	/* nnz */
+};
+
+#define SPARSE_PATTERN(v) (*(struct sparse_pattern **)Data_custom_val(v))
+
+static void free_sparse_pattern(struct sparse_pattern *p)
 {
-    caml_remove_generational_global_root((value *)&MAT_OP_TABLE(smat));
-    free_smat(smat);
+    if (p == NULL) return;
+    free(p->dst);
+    free(p->indexptrs);
+    free(p->indexvals);
+    free(p);
 }
 
-static void finalize_caml_smat(value vsmat)
+static void finalize_sparse_pattern(value vp)
 {
-    free_smat(MAT_CVAL(vsmat));
+    free_sparse_pattern(SPARSE_PATTERN(vp));
 }
 
-static void finalize_caml_custom_smat(value vsmat)
+/* Counting sorts, first on the minor index and then (stably) on the major
+   index, so that the cost is linear in the number of triplets.  */
+static struct sparse_pattern *make_sparse_pattern(bool csr,
+	sundials_ml_smat_index m, sundials_ml_smat_index n,
+	sundials_ml_smat_index nt,
+	sundials_ml_index *rows, sundials_ml_index *cols)
 {
-    free_custom_smat(MAT_CVAL(vsmat));
+    struct sparse_pattern *p;
+    sundials_ml_index *major = csr ? rows : cols;
+    sundials_ml_index *minor = csr ? cols : rows;
+    sundials_ml_smat_index np = csr ? m : n, nminor = csr ? n : m;
+    sundials_ml_smat_index *count = NULL, *order1 = NULL, *order2 = NULL;
+    sundials_ml_smat_index i, j, k, nz;
+
+    p = calloc(1, sizeof(struct sparse_pattern));
+    if (p == NULL) return NULL;
+    p->m = m;
+    p->n = n;
+    p->np = np;
+    p->nt = nt;
+
+    p->dst = malloc((nt > 0 ? nt : 1) * sizeof(sundials_ml_smat_index));
+    p->indexptrs = calloc(np + 1, sizeof(sundials_ml_smat_index));
+    p->indexvals = malloc((nt > 0 ? nt : 1) * sizeof(sundials_ml_smat_index));
+    count = calloc((np > nminor ? np : nminor) + 1,
+		   sizeof(sundials_ml_smat_index));
+    order1 = malloc((nt > 0 ? nt : 1) * sizeof(sundials_ml_smat_index));
+    order2 = malloc((nt > 0 ? nt : 1) * sizeof(sundials_ml_smat_index));
+    if (p->dst == NULL || p->indexptrs == NULL || p->indexvals == NULL
+	    || count == NULL || order1 == NULL || order2 == NULL)
+	goto fail;
+
+    /* sort on the minor index */
+    for (k = 0; k < nt; ++k) ++count[minor[k] + 1];
+    for (i = 0; i < nminor; ++i) count[i + 1] += count[i];
+    for (k = 0; k < nt; ++k) order1[count[minor[k]]++] = k;
+
+    /* stable sort on the major index */
+    for (i = 0; i <= nminor || i <= np; ++i) count[i] = 0;
+    for (k = 0; k < nt; ++k) ++count[major[k] + 1];
+    for (j = 0; j < np; ++j) count[j + 1] += count[j];
+    for (k = 0; k < nt; ++k) {
+	sundials_ml_smat_index t = order1[k];
+	order2[count[major[t]]++] = t;
+    }
+
+    /* merge duplicates and build the index arrays */
+    nz = 0;
+    for (k = 0; k < nt; ++k) {
+	sundials_ml_smat_index t = order2[k];
+
+	if (k == 0 || major[t] != major[order2[k - 1]]
+		   || minor[t] != minor[order2[k - 1]]) {
+	    p->indexvals[nz] = minor[t];
+	    ++p->indexptrs[major[t] + 1];
+	    ++nz;
+	}
+	p->dst[t] = nz - 1;
+    }
+    for (j = 0; j < np; ++j) p->indexptrs[j + 1] += p->indexptrs[j];
+    p->nnz = nz;
+
+    free(count);
+    free(order1);
+    free(order2);
+    return p;
+
+fail:
+    free(count);
+    free(order1);
+    free(order2);
+    free_sparse_pattern(p);
+    return NULL;
 }
 
-static void csmat_clone_ops(SUNMatrix dst, SUNMatrix src)
+CAMLprim value sunml_matrix_sparse_make_pattern(value vsformat, value vm,
+						value vn, value vrows,
+						value vcols)
 {
-    SUNMatrix_Ops ops = (SUNMatrix_Ops)dst->ops;
+    CAMLparam5(vsformat, vm, vn, vrows, vcols);
+    CAMLlocal1(vp);
+    sundials_ml_smat_index m = Long_val(vm), n = Long_val(vn), nt, k;
+    sundials_ml_index *rows = Caml_ba_data_val(vrows);
+    sundials_ml_index *cols = Caml_ba_data_val(vcols);
+    struct sparse_pattern *p;
+
+    nt = Caml_ba_array_val(vrows)->dim[0];
+    if (Caml_ba_array_val(vcols)->dim[0] != nt)
+	caml_invalid_argument("Matrix.Sparse.make_pattern: array lengths");
+    for (k = 0; k < nt; ++k)
+	if (rows[k] < 0 || rows[k] >= m || cols[k] < 0 || cols[k] >= n)
+	    caml_invalid_argument("Matrix.Sparse.make_pattern: index");
+
+    p = make_sparse_pattern(MAT_FROM_SFORMAT(vsformat) == CSR_MAT,
+			    m, n, nt, rows, cols);
+    if (p == NULL) caml_raise_out_of_memory();
+
+    vp = caml_alloc_final(1, &finalize_sparse_pattern, 1, 20);
+    SPARSE_PATTERN(vp) = p;
+
+    CAMLreturn(vp);
+}
+
+CAMLprim value sunml_matrix_sparse_pattern_nnz(value vp)
+{
+    CAMLparam1(vp);
+    CAMLreturn(Val_long(SPARSE_PATTERN(vp)->nnz));
+}
+
+CAMLprim void sunml_matrix_sparse_assemble(value vp, value vvals, value va)
+{
+    CAMLparam3(vp, vvals, va);
+    CAMLlocal1(vcptr);
+    struct sparse_pattern *p = SPARSE_PATTERN(vp);
+    realtype *vals = REAL_ARRAY(vvals);
+    sundials_ml_smat_index *indexptrs, *indexvals, k;
+    realtype *data;
+    MAT_CONTENT_SPARSE_TYPE A;
+
+    if (Caml_ba_array_val(vvals)->dim[0] != p->nt)
+	caml_invalid_argument("Matrix.Sparse.assemble: vals has the wrong length");
+
+    vcptr = Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+    A = MAT_CONTENT_SPARSE(vcptr);
+    if (A->M != p->m || A->N != p->n)
+	caml_invalid_argument("Matrix.Sparse.assemble: matrix size");
+
+    /* the structure of a matrix with a frozen pattern is not rewritten, so
+       it must already be that of the pattern */
+    if (MAT_SPARSE_FROZEN(vcptr)) {
+	if (!sparse_has_pattern(A, p->np, p->indexptrs, p->indexvals))
+	    caml_invalid_argument("Matrix.Sparse.assemble: pattern is frozen");
+    } else {
+	if (A->NNZ < p->nnz) {
+	    if (! matrix_sparse_resize(va, p->nnz, false, true))
+		caml_raise_out_of_memory();
+	    A = MAT_CONTENT_SPARSE(vcptr);
+	}
+
+#if SUNDIALS_LIB_VERSION >= 270
+	indexptrs = A->indexptrs;
+	indexvals = A->indexvals;
+#else
+	indexptrs = A->rowvals;
+	indexvals = A->colptrs;
+#endif
+	memcpy(indexptrs, p->indexptrs,
+	       (p->np + 1) * sizeof(sundials_ml_smat_index));
+	memcpy(indexvals, p->indexvals,
+	       p->nnz * sizeof(sundials_ml_smat_index));
+    }
+
+    data = A->data;
+    for (k = 0; k < p->nnz; ++k) data[k] = 0.0;
+    for (k = 0; k < p->nt; ++k) data[p->dst[k]] += vals[k];
+
+    CAMLreturn0;
+}
+
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Matrix.Coloring
+ */
+
+/* Finite-difference Jacobians with column coloring (Curtis, Powell, and
+ * Reid). Columns that have no nonzero row in common are given the same
+ * color, so that they can be perturbed together and all the entries of
+ * a Jacobian are obtained from one function evaluation per color.
+ *
+ * The entries of a coloring are listed by color with their position in the
+ * data array of a matrix, and the row and column that they occupy. A
+ * coloring of a sparse matrix also records its pattern, which is restored
+ * (unless frozen) before the entries are scattered.  */
+
+struct matrix_coloring {
+    bool sparse;
+    sundials_ml_index m, n;	    /* rows and columns */
+    sundials_ml_index mu, ml;	    /* band matrices */
+    sundials_ml_index ncolors;
+    sundials_ml_index *color;	    /* n: color of each column */
+    sundials_ml_index *cptrs;	    /* ncolors + 1: entries of each color */
+    sundials_ml_index *pos, *row, *col; /* entries */
+    realtype relinc;
+    realtype *inc;		    /* n: increments of the last perturbation */
+
+    /* pattern (sparse matrices) */
+    sundials_ml_smat_index np, nnz;
+    sundials_ml_smat_index *indexptrs;
+    sundials_ml_smat_index *indexvals;
+};
+
+#define MATRIX_COLORING(v) (*(struct matrix_coloring **)Data_custom_val(v))
+
+static void free_matrix_coloring(struct matrix_coloring *c)
+{
+    if (c == NULL) return;
+    free(c->color);
+    free(c->cptrs);
+    free(c->pos);
+    free(c->row);
+    free(c->col);
+    free(c->inc);
+    free(c->indexptrs);
+    free(c->indexvals);
+    free(c);
+}
+
+static void finalize_matrix_coloring(value vc)
+{
+    free_matrix_coloring(MATRIX_COLORING(vc));
+}
+
+static struct matrix_coloring *alloc_matrix_coloring(sundials_ml_index m,
+						     sundials_ml_index n,
+						     sundials_ml_index nent,
+						     realtype relinc)
+{
+    struct matrix_coloring *c;
+    sundials_ml_index ne = (nent > 0) ? nent : 1;
+
+    c = calloc(1, sizeof(struct matrix_coloring));
+    if (c == NULL) return NULL;
+    c->m = m;
+    c->n = n;
+    c->relinc = relinc;
+
+    c->color = malloc((n > 0 ? n : 1) * sizeof(sundials_ml_index));
+    c->inc   = calloc((n > 0 ? n : 1), sizeof(realtype));
+    c->pos   = malloc(ne * sizeof(sundials_ml_index));
+    c->row   = malloc(ne * sizeof(sundials_ml_index));
+    c->col   = malloc(ne * sizeof(sundials_ml_index));
+    if (c->color == NULL || c->inc == NULL
+	    || c->pos == NULL || c->row == NULL || c->col == NULL) {
+	free_matrix_coloring(c);
+	return NULL;
+    }
+    return c;
+}
+
+/* Given the colors of the columns, sort the nent entries (pos, row, col)
+   by color into c.  */
+static bool sort_coloring_entries(struct matrix_coloring *c,
+				  sundials_ml_index nent,
+				  sundials_ml_index *pos,
+				  sundials_ml_index *row,
+				  sundials_ml_index *col)
+{
+    sundials_ml_index k, e;
+
+    c->cptrs = calloc(c->ncolors + 1, sizeof(sundials_ml_index));
+    if (c->cptrs == NULL) return false;
+
+    for (e = 0; e < nent; ++e) ++c->cptrs[c->color[col[e]] + 1];
+    for (k = 0; k < c->ncolors; ++k) c->cptrs[k + 1] += c->cptrs[k];
+    for (e = 0; e < nent; ++e) {
+	sundials_ml_index d = c->cptrs[c->color[col[e]]]++;
+	c->pos[d] = pos[e];
+	c->row[d] = row[e];
+	c->col[d] = col[e];
+    }
+    for (k = c->ncolors; k > 0; --k) c->cptrs[k] = c->cptrs[k - 1];
+    c->cptrs[0] = 0;
+
+    return true;
+}
+
+static value alloc_coloring_value(struct matrix_coloring *c)
+{
+    CAMLparam0();
+    CAMLlocal1(vc);
+
+    vc = caml_alloc_final(1, &finalize_matrix_coloring, 1, 20);
+    MATRIX_COLORING(vc) = c;
+
+    CAMLreturn(vc);
+}
+
+#if SUNDIALS_LIB_VERSION >= 260
+/* Greedy coloring of the columns of a sparse matrix: each column takes the
+   smallest color not used by the columns that share one of its rows.  */
+static struct matrix_coloring *color_sparse(MAT_CONTENT_SPARSE_TYPE A,
+					    realtype relinc)
+{
+    struct matrix_coloring *c;
+    sundials_ml_smat_index *indexptrs, *indexvals, np, nnz;
+    sundials_ml_index m = A->M, n = A->N;
+    sundials_ml_index *pos = NULL, *row = NULL, *col = NULL;
+    sundials_ml_index *colptrs = NULL, *colents = NULL;
+    sundials_ml_index *rowptrs = NULL, *rowents = NULL;
+    sundials_ml_index *forbid = NULL;
+    sundials_ml_index i, j, e, f, p;
+    bool csr = false;
+
+#if SUNDIALS_LIB_VERSION >= 270
+    indexptrs = A->indexptrs;
+    indexvals = A->indexvals;
+    np = A->NP;
+    csr = (A->sparsetype == CSR_MAT);
+#else
+    indexptrs = A->rowvals;
+    indexvals = A->colptrs;
+    np = A->N;
+#endif
+    nnz = indexptrs[np];
+
+    c = alloc_matrix_coloring(m, n, nnz, relinc);
+    if (c == NULL) return NULL;
+    c->sparse = true;
+    c->np = np;
+    c->nnz = nnz;
+
+    c->indexptrs = malloc((np + 1) * sizeof(sundials_ml_smat_index));
+    c->indexvals = malloc((nnz > 0 ? nnz : 1)
+			  * sizeof(sundials_ml_smat_index));
+    pos     = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_index));
+    row     = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_index));
+    col     = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_index));
+    colents = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_index));
+    rowents = malloc((nnz > 0 ? nnz : 1) * sizeof(sundials_ml_index));
+    colptrs = calloc(n + 1, sizeof(sundials_ml_index));
+    rowptrs = calloc(m + 1, sizeof(sundials_ml_index));
+    forbid  = malloc((n + 1) * sizeof(sundials_ml_index));
+    if (c->indexptrs == NULL || c->indexvals == NULL
+	    || pos == NULL || row == NULL || col == NULL
+	    || colents == NULL || rowents == NULL
+	    || colptrs == NULL || rowptrs == NULL || forbid == NULL) {
+	free_matrix_coloring(c);
+	c = NULL;
+	goto done;
+    }
+    memcpy(c->indexptrs, indexptrs, (np + 1) * sizeof(sundials_ml_smat_index));
+    memcpy(c->indexvals, indexvals, nnz * sizeof(sundials_ml_smat_index));
+
+    /* list the entries */
+    for (j = 0; j < np; ++j) {
+	for (p = indexptrs[j]; p < indexptrs[j + 1]; ++p) {
+	    pos[p] = p;
+	    row[p] = csr ? j : indexvals[p];
+	    col[p] = csr ? indexvals[p] : j;
+	}
+    }
+
+    /* index the entries by column and by row */
+    for (e = 0; e < nnz; ++e) {
+	++colptrs[col[e] + 1];
+	++rowptrs[row[e] + 1];
+    }
+    for (j = 0; j < n; ++j) colptrs[j + 1] += colptrs[j];
+    for (i = 0; i < m; ++i) rowptrs[i + 1] += rowptrs[i];
+    for (e = 0; e < nnz; ++e) {
+	colents[colptrs[col[e]]++] = e;
+	rowents[rowptrs[row[e]]++] = e;
+    }
+    for (j = n; j > 0; --j) colptrs[j] = colptrs[j - 1];
+    colptrs[0] = 0;
+    for (i = m; i > 0; --i) rowptrs[i] = rowptrs[i - 1];
+    rowptrs[0] = 0;
+
+    /* color the columns */
+    for (j = 0; j <= n; ++j) forbid[j] = -1;
+    c->ncolors = 0;
+    for (j = 0; j < n; ++j) {
+	sundials_ml_index k;
+
+	for (e = colptrs[j]; e < colptrs[j + 1]; ++e) {
+	    i = row[colents[e]];
+	    for (f = rowptrs[i]; f < rowptrs[i + 1]; ++f) {
+		sundials_ml_index l = col[rowents[f]];
+		if (l < j) forbid[c->color[l]] = j;
+	    }
+	}
+	for (k = 0; forbid[k] == j; ++k);
+	c->color[j] = k;
+	if (k + 1 > c->ncolors) c->ncolors = k + 1;
+    }
+
+    if (! sort_coloring_entries(c, nnz, pos, row, col)) {
+	free_matrix_coloring(c);
+	c = NULL;
+    }
+
+done:
+    free(pos);
+    free(row);
+    free(col);
+    free(colents);
+    free(rowents);
+    free(colptrs);
+    free(rowptrs);
+    free(forbid);
+    return c;
+}
+#endif
+
+/* Columns whose distance is at least mu + ml + 1 have no row in common.  */
+static struct matrix_coloring *color_band(MAT_CONTENT_BAND_TYPE A,
+					  realtype relinc)
+{
+    struct matrix_coloring *c;
+    sundials_ml_index n = A->N, w = A->mu + A->ml + 1;
+    sundials_ml_index *pos = NULL, *row = NULL, *col = NULL;
+    sundials_ml_index i, j, e, nent;
+
+    if (w > n) w = n;
+    nent = 0;
+    for (j = 0; j < n; ++j)
+	nent += SUNMIN(n - 1, j + A->ml) - SUNMAX(0, j - A->mu) + 1;
+
+    c = alloc_matrix_coloring(n, n, nent, relinc);
+    if (c == NULL) return NULL;
+    c->sparse = false;
+    c->mu = A->mu;
+    c->ml = A->ml;
+    c->ncolors = w;
+
+    pos = malloc((nent > 0 ? nent : 1) * sizeof(sundials_ml_index));
+    row = malloc((nent > 0 ? nent : 1) * sizeof(sundials_ml_index));
+    col = malloc((nent > 0 ? nent : 1) * sizeof(sundials_ml_index));
+    if (pos == NULL || row == NULL || col == NULL) {
+	free_matrix_coloring(c);
+	c = NULL;
+	goto done;
+    }
+
+    e = 0;
+    for (j = 0; j < n; ++j) {
+	c->color[j] = j % w;
+	for (i = SUNMAX(0, j - A->mu); i <= SUNMIN(n - 1, j + A->ml); ++i) {
+	    pos[e] = j * A->ldim + i - j + A->s_mu;
+	    row[e] = i;
+	    col[e] = j;
+	    ++e;
+	}
+    }
+
+    if (! sort_coloring_entries(c, nent, pos, row, col)) {
+	free_matrix_coloring(c);
+	c = NULL;
+    }
+
+done:
+    free(pos);
+    free(row);
+    free(col);
+    return c;
+}
+
+CAMLprim value sunml_matrix_coloring_sparse(value va, value vrelinc)
+{
+    CAMLparam2(va, vrelinc);
+#if SUNDIALS_LIB_VERSION >= 260
+    struct matrix_coloring *c;
+
+    c = color_sparse(
+	    MAT_CONTENT_SPARSE(Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR)),
+	    Double_val(vrelinc));
+    if (c == NULL) caml_raise_out_of_memory();
+
+    CAMLreturn(alloc_coloring_value(c));
+#else
+    CAMLreturn(Val_unit);
+#endif
+}
+
+CAMLprim value sunml_matrix_coloring_band(value va, value vrelinc)
+{
+    CAMLparam2(va, vrelinc);
+    struct matrix_coloring *c;
+
+    c = color_band(
+	    MAT_CONTENT_BAND(Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR)),
+	    Double_val(vrelinc));
+    if (c == NULL) caml_raise_out_of_memory();
+
+    CAMLreturn(alloc_coloring_value(c));
+}
+
+CAMLprim value sunml_matrix_coloring_num_colors(value vc)
+{
+    CAMLparam1(vc);
+    CAMLreturn(Val_long(MATRIX_COLORING(vc)->ncolors));
+}
+
+/* Restore the pattern of a sparse matrix before its entries are scattered,
+ * and check the dimensions of a band matrix.  */
+CAMLprim void sunml_matrix_coloring_prepare(value vc, value va)
+{
+    CAMLparam2(vc, va);
+    CAMLlocal1(vcptr);
+    struct matrix_coloring *c = MATRIX_COLORING(vc);
+
+    vcptr = Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+
+    if (c->sparse) {
+#if SUNDIALS_LIB_VERSION >= 260
+	MAT_CONTENT_SPARSE_TYPE A = MAT_CONTENT_SPARSE(vcptr);
+
+	if (A->M != c->m || A->N != c->n)
+	    caml_invalid_argument("Matrix.Coloring.jacobian: matrix size");
+
+	/* the entries are scattered by position, so a frozen pattern must
+	   be the one of the coloring */
+	if (MAT_SPARSE_FROZEN(vcptr)) {
+	    if (!sparse_has_pattern(A, c->np, c->indexptrs, c->indexvals))
+		caml_invalid_argument(
+		    "Matrix.Coloring.jacobian: pattern is frozen");
+	} else {
+	    if (A->NNZ < c->nnz) {
+		if (! matrix_sparse_resize(va, c->nnz, false, true))
+		    caml_raise_out_of_memory();
+		A = MAT_CONTENT_SPARSE(vcptr);
+	    }
+#if SUNDIALS_LIB_VERSION >= 270
+	    memcpy(A->indexptrs, c->indexptrs,
+		   (c->np + 1) * sizeof(sundials_ml_smat_index));
+	    memcpy(A->indexvals, c->indexvals,
+		   c->nnz * sizeof(sundials_ml_smat_index));
+#else
+	    memcpy(A->rowvals, c->indexptrs,
+		   (c->np + 1) * sizeof(sundials_ml_smat_index));
+	    memcpy(A->colptrs, c->indexvals,
+		   c->nnz * sizeof(sundials_ml_smat_index));
+#endif
+	}
+#endif
+    } else {
+	MAT_CONTENT_BAND_TYPE A = MAT_CONTENT_BAND(vcptr);
+
+	if (A->N != c->n || A->mu != c->mu || A->ml != c->ml)
+	    caml_invalid_argument("Matrix.Coloring.jacobian: matrix size");
+    }
+
+    CAMLreturn0;
+}
+
+/* ypert = y + inc, where inc is nonzero only for the columns of color k */
+CAMLprim void sunml_matrix_coloring_perturb(value vc, value vk, value vy,
+					    value vypert)
+{
+    CAMLparam4(vc, vk, vy, vypert);
+    struct matrix_coloring *c = MATRIX_COLORING(vc);
+    sundials_ml_index k = Long_val(vk), j;
+    realtype *y = REAL_ARRAY(vy);
+    realtype *ypert = REAL_ARRAY(vypert);
+
+    for (j = 0; j < c->n; ++j) {
+	if (c->color[j] == k) {
+	    realtype a = (y[j] < 0.0) ? -y[j] : y[j];
+	    realtype inc = c->relinc * SUNMAX(a, 1.0);
+
+	    if (y[j] < 0.0) inc = -inc;
+	    ypert[j] = y[j] + inc;
+	    c->inc[j] = ypert[j] - y[j];  /* the increment actually applied */
+	} else {
+	    ypert[j] = y[j];
+	    c->inc[j] = 0.0;
+	}
+    }
+
+    CAMLreturn0;
+}
+
+/* yppert = yp + cj * inc, for the increments of the last perturbation */
+CAMLprim void sunml_matrix_coloring_perturb_derivative(value vc, value vcj,
+						       value vyp,
+						       value vyppert)
+{
+    CAMLparam4(vc, vcj, vyp, vyppert);
+    struct matrix_coloring *c = MATRIX_COLORING(vc);
+    realtype cj = Double_val(vcj);
+    realtype *yp = REAL_ARRAY(vyp);
+    realtype *yppert = REAL_ARRAY(vyppert);
+    sundials_ml_index j;
+
+    for (j = 0; j < c->n; ++j) yppert[j] = yp[j] + cj * c->inc[j];
+
+    CAMLreturn0;
+}
+
+/* Scatter the difference quotients of color k into the matrix */
+CAMLprim void sunml_matrix_coloring_scatter(value vc, value vk, value vf,
+					    value vfpert, value va)
+{
+    CAMLparam5(vc, vk, vf, vfpert, va);
+    CAMLlocal1(vcptr);
+    struct matrix_coloring *c = MATRIX_COLORING(vc);
+    sundials_ml_index k = Long_val(vk), e;
+    realtype *f = REAL_ARRAY(vf);
+    realtype *fpert = REAL_ARRAY(vfpert);
+    realtype *data = NULL;
+
+    vcptr = Field(va, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+#if SUNDIALS_LIB_VERSION >= 260
+    if (c->sparse) data = MAT_CONTENT_SPARSE(vcptr)->data;
+#endif
+    if (!c->sparse) data = MAT_CONTENT_BAND(vcptr)->data;
+    if (data == NULL) CAMLreturn0;
+
+    for (e = c->cptrs[k]; e < c->cptrs[k + 1]; ++e)
+	data[c->pos[e]] = (fpert[c->row[e]] - f[c->row[e]]) / c->inc[c->col[e]];
+
+    CAMLreturn0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Matrix
+ */
+
+#if SUNDIALS_LIB_VERSION >= 300
+/*
+ *  Type	    content		    backlink
+ *  --------+-------------------------------------------------
+ *  dense   | MAT_CONTENT_DENSE_TYPE	    Dense.t  (matrix_content)
+ *  band    | MAT_CONTENT_BAND_TYPE	    Band.t   (matrix_content)
+ *  sparse  | MAT_CONTENT_SPARSE_TYPE	    Sparse.t (matrix_content)
+ *  custom  | (matrix_ops, natives) pair	    'm (custom data)
+ *
+ *  The natives of a custom matrix are an array of cfun options, in the
+ *  same order as the matrix_ops record (see Matrix.wrap_custom).
+ */
+static SUNMatrix alloc_smat(void *content, value backlink,
+			    bool content_is_value)
+{
+    SUNMatrix smat;
+
+    /* Alloc memory in C heap */
+    smat = (SUNMatrix)malloc(sizeof(struct csmat));
+    if (smat == NULL) return NULL;
+
+    smat->ops = (SUNMatrix_Ops)malloc(sizeof(struct _generic_SUNMatrix_Ops));
+    if (smat->ops == NULL) { free(smat); return(NULL); }
+
+    smat->content = content;
+    if (content_is_value) // NB: free_smat does not unregister the content
+	caml_register_generational_global_root((value *)&(smat->content));
+
+    MAT_BACKLINK(smat) = backlink;
+    caml_register_generational_global_root(&MAT_BACKLINK(smat));
+
+    return smat;
+}
+
+#define MAT_OP_TABLE(smat)  ((smat)->content)
+#define GET_OP(smat, x) (Field(Field((value)MAT_OP_TABLE(smat), 0), x))
+#define GET_NATIVE(smat, x) \
+    (CFUN_VAL(Some_val(Field(Field((value)MAT_OP_TABLE(smat), 1), x))))
+
+static void free_smat(SUNMatrix smat)
+{
+    caml_remove_generational_global_root(&MAT_BACKLINK(smat));
+    // smat->content is not owned by the sunmatrix
+    free(smat->ops);
+    free(smat);
+}
+
+static void free_custom_smat(SUNMatrix smat)
+{
+    caml_remove_generational_global_root((value *)&MAT_OP_TABLE(smat));
+    free_smat(smat);
+}
+
+static void finalize_caml_smat(value vsmat)
+{
+    free_smat(MAT_CVAL(vsmat));
+}
+
+static void finalize_caml_custom_smat(value vsmat)
+{
+    free_custom_smat(MAT_CVAL(vsmat));
+}
+
+static void csmat_clone_ops(SUNMatrix dst, SUNMatrix src)
+{
+    SUNMatrix_Ops ops = (SUNMatrix_Ops)dst->ops;
 
     ops->getid     = src->ops->getid;
     ops->clone     = src->ops->clone;
@@ -2309,10 +3352,23 @@ static SUNMatrix csmat_band_clone(SUNMatrix A)
 static SUNMatrix csmat_sparse_clone(SUNMatrix A)
 {
     CAMLparam0();
-    CAMLlocal4(vcontenta, vpayloada, vcontentb, vpayloadb);
+    CAMLlocal5(vcontenta, vpayloada, vcontentb, vpayloadb, vcptra);
     SUNMatrix B;
 
     vcontenta = MAT_BACKLINK(A);
+
+    /* the clone of a matrix with a shared pattern shares it too */
+    vcptra = Field(vcontenta, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+    if (MAT_SPARSE_SHARE(vcptra) != NULL) {
+	if (! matrix_sparse_share_create(vcontenta, &vcontentb))
+	    CAMLreturnT(SUNMatrix, NULL);
+	B = alloc_smat(
+		MAT_CONTENT(Field(vcontentb, RECORD_MAT_MATRIXCONTENT_RAWPTR)),
+		vcontentb, false);
+	csmat_clone_ops(B, A);
+	CAMLreturnT(SUNMatrix, B);
+    }
+
     if (! matrix_sparse_create_mat(SM_ROWS_S(A), SM_COLUMNS_S(A),
 				   SM_NNZ_S(A), SM_SPARSETYPE_S(A),
 				   &vcontentb) )
@@ -2323,9 +3379,30 @@ static SUNMatrix csmat_sparse_clone(SUNMatrix A)
 	    vcontentb, false);
     csmat_clone_ops(B, A);
 
+    /* the clone of a matrix with a frozen pattern shares that pattern, so
+       that copies between them only transfer the values */
+    vcptra = Field(vcontenta, RECORD_MAT_MATRIXCONTENT_RAWPTR);
+    if (MAT_SPARSE_FROZEN(vcptra)) {
+	memcpy(SM_INDEXPTRS_S(B), SM_INDEXPTRS_S(A),
+	       (SM_NP_S(A) + 1) * sizeof(sundials_ml_smat_index));
+	memcpy(SM_INDEXVALS_S(B), SM_INDEXVALS_S(A),
+	       SM_NNZ_S(A) * sizeof(sundials_ml_smat_index));
+	MAT_SPARSE_FROZEN(Field(vcontentb, RECORD_MAT_MATRIXCONTENT_RAWPTR))
+	    = 1;
+    }
+
     CAMLreturnT(SUNMatrix, B);
 }
 
+static int csmat_sparse_zero(SUNMatrix A)
+{
+    value vcptr = Field(MAT_BACKLINK(A), RECORD_MAT_MATRIXCONTENT_RAWPTR);
+
+    if (MAT_SPARSE_FROZEN(vcptr)) zero_sparse_values(MAT_CONTENT_SPARSE(vcptr));
+    else zero_sparse(MAT_CONTENT_SPARSE(vcptr));
+    return 0;
+}
+
 static SUNMatrix csmat_custom_clone(SUNMatrix A);
 static SUNMatrix_ID csmat_custom_getid(SUNMatrix A);
 static int csmat_custom_zero(SUNMatrix A);
@@ -2335,6 +3412,16 @@ static int csmat_custom_scale_addi(realtype c, SUNMatrix A);
 static int csmat_custom_matvec(SUNMatrix A, N_Vector x, N_Vector y);
 static int csmat_custom_space(SUNMatrix A, long int *lenrw, long int *leniw);
 
+static void csmat_set_natives(SUNMatrix smat, value vnatives);
+
+static int csmat_blockdiag_zero(SUNMatrix A);
+static int csmat_blockdiag_copy(SUNMatrix A, SUNMatrix B);
+static int csmat_blockdiag_scale_add(realtype c, SUNMatrix A, SUNMatrix B);
+static int csmat_blockdiag_scale_addi(realtype c, SUNMatrix A);
+static int csmat_blockdiag_matvec(SUNMatrix A, N_Vector x, N_Vector y);
+static int csmat_blockdiag_space(SUNMatrix A, long int *lenrw,
+				 long int *leniw);
+
 #endif
 
 CAMLprim value sunml_matrix_wrap(value vid, value vcontent, value vpayload)
@@ -2376,7 +3463,7 @@ CAMLprim value sunml_matrix_wrap(value vid, value vcontent, value vpayload)
 	smat->ops->copy        = csmat_band_copy;         // ours
 	smat->ops->scaleadd    = csmat_band_scale_add;    // ours
 	smat->ops->scaleaddi   = SUNMatScaleAddI_Band;
-	smat->ops->matvec      = SUNMatMatvec_Band;
+	smat->ops->matvec      = csmat_band_matvec;	 // ours
 	smat->ops->space       = SUNMatSpace_Band;
 	break;
 
@@ -2384,11 +3471,11 @@ CAMLprim value sunml_matrix_wrap(value vid, value vcontent, value vpayload)
 	smat->ops->clone       = csmat_sparse_clone;      // ours
 	smat->ops->destroy     = free_smat;  // ours (only called for c clones)
 	smat->ops->getid       = SUNMatGetID_Sparse;
-	smat->ops->zero        = SUNMatZero_Sparse;
+	smat->ops->zero        = csmat_sparse_zero;	 // ours
 	smat->ops->copy        = csmat_sparse_copy;	 // ours
 	smat->ops->scaleadd    = csmat_sparse_scale_add;  // ours
 	smat->ops->scaleaddi   = csmat_sparse_scale_addi; // ours
-	smat->ops->matvec      = SUNMatMatvec_Sparse;
+	smat->ops->matvec      = csmat_sparse_matvec;	 // ours
 	smat->ops->space       = SUNMatSpace_Sparse;
 	break;
 
@@ -2406,7 +3493,22 @@ CAMLprim value sunml_matrix_wrap(value vid, value vcontent, value vpayload)
 	smat->ops->matvec      = csmat_custom_matvec;
 	smat->ops->space       = csmat_custom_space;
 	break;
+
+    case MATRIX_ID_BLOCKDIAG:
+	smat->ops->clone       = csmat_custom_clone;
+	smat->ops->destroy     = free_custom_smat;  // ours (only called for
+						   //	    c clones)
+	smat->ops->getid       = csmat_custom_getid;
+	smat->ops->zero        = csmat_blockdiag_zero;       // ours
+	smat->ops->copy        = csmat_blockdiag_copy;       // ours
+	smat->ops->scaleadd    = csmat_blockdiag_scale_add;  // ours
+	smat->ops->scaleaddi   = csmat_blockdiag_scale_addi; // ours
+	smat->ops->matvec      = csmat_blockdiag_matvec;     // ours
+	smat->ops->space       = csmat_blockdiag_space;      // ours
+	break;
     }
+    if (mat_id == MATRIX_ID_CUSTOM)
+	csmat_set_natives(smat, Field(vcontent, 1));
 
     // Setup the OCaml-side
     vr = caml_alloc_final(1,
@@ -2541,6 +3643,95 @@ static int csmat_custom_space(SUNMatrix A, long int *lenrw, long int *leniw)
 
     CAMLreturnT(int, 0);
 }
+
+/* Native operations on custom matrices (Matrix.wrap_custom ~natives).
+   They are called directly, without going through OCaml, with the payloads
+   of the matrices and the data pointer of their cfun.  Only the clone may
+   allocate on the OCaml heap; it returns the payload of the new matrix.  */
+
+typedef value (*native_clone_fn)(value a, void *data);
+typedef int (*native_zero_fn)(value a, void *data);
+typedef int (*native_copy_fn)(value a, value b, void *data);
+typedef int (*native_scale_add_fn)(realtype c, value a, value b, void *data);
+typedef int (*native_scale_addi_fn)(realtype c, value a, void *data);
+typedef int (*native_matvec_fn)(value a, N_Vector x, N_Vector y, void *data);
+typedef int (*native_space_fn)(value a, long int *lenrw, long int *leniw,
+			       void *data);
+
+static SUNMatrix csmat_native_clone(SUNMatrix A)
+{
+    CAMLparam0();
+    CAMLlocal1(vcontentb);
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_CLONE);
+    SUNMatrix B;
+
+    vcontentb = ((native_clone_fn)f->fn)(MAT_BACKLINK(A), f->data);
+
+    B = alloc_smat(MAT_OP_TABLE(A), vcontentb, true);
+    if (B == NULL) CAMLreturnT(SUNMatrix, NULL);
+    csmat_clone_ops(B, A);
+
+    CAMLreturnT(SUNMatrix, B);
+}
+
+static int csmat_native_zero(SUNMatrix A)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_ZERO);
+    return ((native_zero_fn)f->fn)(MAT_BACKLINK(A), f->data);
+}
+
+static int csmat_native_copy(SUNMatrix A, SUNMatrix B)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_COPY);
+    return ((native_copy_fn)f->fn)(MAT_BACKLINK(A), MAT_BACKLINK(B), f->data);
+}
+
+static int csmat_native_scale_add(realtype c, SUNMatrix A, SUNMatrix B)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_SCALE_ADD);
+    return ((native_scale_add_fn)f->fn)(c, MAT_BACKLINK(A), MAT_BACKLINK(B),
+					f->data);
+}
+
+static int csmat_native_scale_addi(realtype c, SUNMatrix A)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_SCALE_ADDI);
+    return ((native_scale_addi_fn)f->fn)(c, MAT_BACKLINK(A), f->data);
+}
+
+static int csmat_native_matvec(SUNMatrix A, N_Vector x, N_Vector y)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_MATVEC);
+    return ((native_matvec_fn)f->fn)(MAT_BACKLINK(A), x, y, f->data);
+}
+
+static int csmat_native_space(SUNMatrix A, long int *lenrw, long int *leniw)
+{
+    struct sunml_cfun *f = GET_NATIVE(A, RECORD_MAT_MATRIXOPS_SPACE);
+    return ((native_space_fn)f->fn)(MAT_BACKLINK(A), lenrw, leniw, f->data);
+}
+
+/* Replace the OCaml callbacks by the natives that are given.  The clones of
+   the matrix inherit the same operations (see csmat_clone_ops).  */
+static void csmat_set_natives(SUNMatrix smat, value vnatives)
+{
+#define HAS_NATIVE(x) (Field(vnatives, x) != Val_none)
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_CLONE))
+	smat->ops->clone     = csmat_native_clone;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_ZERO))
+	smat->ops->zero      = csmat_native_zero;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_COPY))
+	smat->ops->copy      = csmat_native_copy;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_SCALE_ADD))
+	smat->ops->scaleadd  = csmat_native_scale_add;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_SCALE_ADDI))
+	smat->ops->scaleaddi = csmat_native_scale_addi;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_MATVEC))
+	smat->ops->matvec    = csmat_native_matvec;
+    if (HAS_NATIVE(RECORD_MAT_MATRIXOPS_SPACE))
+	smat->ops->space     = csmat_native_space;
+#undef HAS_NATIVE
+}
 #endif
 
 CAMLprim void sunml_matrix_scale_add(value vc, value va, value vb)
@@ -2657,8 +3848,173 @@ CAMLprim void sunml_matrix_print_sparse(value vm, value vfile)
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * Array matrices
+ *
+ * When Lapack is available, the factorizations of array matrices are
+ * passed to its blocked routines (dgetrf, dpotrf, dgeqrf, dgbtrf) and the
+ * LU solve to the Blas triangular solver. Lapack returns 1-based int
+ * pivots, which are widened in place to the 0-based sundials_ml_index
+ * pivots expected by the other array functions (and by users).
+ *
+ * Otherwise, getrf and potrf are computed by the blocked kernels below.
+ * They apply exactly the same updates, in the same order, to each element
+ * as denseGETRF and densePOTRF, and so give identical results, but they
+ * work on panels of ARRAYMATRIX_NB columns and strips of ARRAYMATRIX_MB
+ * rows so that the columns being applied stay in cache.
  */
 
+#define ARRAYMATRIX_NB 64
+#define ARRAYMATRIX_MB 256
+
+#if defined SUNDIALS_ML_LAPACK && !defined SUNDIALS_ML_SINGLE_PRECISION
+#define ARRAYMATRIX_LAPACK
+
+extern void dgetrf_(const int *m, const int *n, double *a, const int *lda,
+		    int *ipiv, int *info);
+extern void dpotrf_(const char *uplo, const int *n, double *a,
+		    const int *lda, int *info);
+extern void dgeqrf_(const int *m, const int *n, double *a, const int *lda,
+		    double *tau, double *work, const int *lwork, int *info);
+extern void dgbtrf_(const int *m, const int *n, const int *kl, const int *ku,
+		    double *ab, const int *ldab, int *ipiv, int *info);
+extern void dtrsv_(const char *uplo, const char *trans, const char *diag,
+		   const int *n, const double *a, const int *lda, double *x,
+		   const int *incx);
+
+#define ARRAYMATRIX_FITS_INT(m, n) ((m) <= INT_MAX && (n) <= INT_MAX)
+
+/* Lapack writes n int pivots at the start of p. Working backward, each
+   p[i] only overwrites int pivots that have already been read. */
+static void arraymatrix_widen_pivots(sundials_ml_index *p, int n)
+{
+    int i, ip;
+
+    for (i = n - 1; i >= 0; --i) {
+	memcpy(&ip, (char *)p + i * sizeof(int), sizeof(int));
+	p[i] = (sundials_ml_index)ip - 1;
+    }
+}
+#endif
+
+static sundials_ml_index arraydense_getrf(realtype **a, sundials_ml_index m,
+					  sundials_ml_index n,
+					  sundials_ml_index *p)
+{
+    sundials_ml_index j0, j1, k, i, i0, i1, j, l;
+    realtype *col_k, *col_j, t, mult;
+
+    for (j0 = 0; j0 < n; j0 = j1) {
+	j1 = (j0 + ARRAYMATRIX_NB < n) ? j0 + ARRAYMATRIX_NB : n;
+
+	/* factor the panel (columns j0 to j1 - 1) */
+	for (k = j0; k < j1; ++k) {
+	    col_k = a[k];
+
+	    l = k;
+	    for (i = k + 1; i < m; ++i)
+		if (SUNRabs(col_k[i]) > SUNRabs(col_k[l])) l = i;
+	    p[k] = l;
+
+	    if (col_k[l] == 0.0) return (k + 1);
+
+	    if (l != k) {
+		for (j = j0; j < j1; ++j) {
+		    t = a[j][l]; a[j][l] = a[j][k]; a[j][k] = t;
+		}
+	    }
+
+	    mult = 1.0 / col_k[k];
+	    for (i = k + 1; i < m; ++i) col_k[i] *= mult;
+
+	    for (j = k + 1; j < j1; ++j) {
+		col_j = a[j];
+		t = col_j[k];
+		if (t != 0.0)
+		    for (i = k + 1; i < m; ++i) col_j[i] -= t * col_k[i];
+	    }
+	}
+
+	/* apply the panel's interchanges to the other columns */
+	for (k = j0; k < j1; ++k) {
+	    l = p[k];
+	    if (l == k) continue;
+	    for (j = 0; j < j0; ++j) {
+		t = a[j][l]; a[j][l] = a[j][k]; a[j][k] = t;
+	    }
+	    for (j = j1; j < n; ++j) {
+		t = a[j][l]; a[j][l] = a[j][k]; a[j][k] = t;
+	    }
+	}
+
+	/* rows j0 to j1 - 1 of U to the right of the panel */
+	for (j = j1; j < n; ++j) {
+	    col_j = a[j];
+	    for (k = j0; k < j1; ++k) {
+		col_k = a[k];
+		t = col_j[k];
+		if (t != 0.0)
+		    for (i = k + 1; i < j1; ++i) col_j[i] -= t * col_k[i];
+	    }
+	}
+
+	/* update the trailing submatrix, strip by strip */
+	for (i0 = j1; i0 < m; i0 = i1) {
+	    i1 = (i0 + ARRAYMATRIX_MB < m) ? i0 + ARRAYMATRIX_MB : m;
+	    for (j = j1; j < n; ++j) {
+		col_j = a[j];
+		for (k = j0; k < j1; ++k) {
+		    col_k = a[k];
+		    t = col_j[k];
+		    if (t != 0.0)
+			for (i = i0; i < i1; ++i) col_j[i] -= t * col_k[i];
+		}
+	    }
+	}
+    }
+
+    return 0;
+}
+
+static sundials_ml_index arraydense_potrf(realtype **a, sundials_ml_index m)
+{
+    sundials_ml_index j0, j1, j, k, i, i0, i1;
+    realtype *col_j, *col_k, d;
+
+    for (j0 = 0; j0 < m; j0 = j1) {
+	j1 = (j0 + ARRAYMATRIX_NB < m) ? j0 + ARRAYMATRIX_NB : m;
+
+	/* contributions of the columns left of the panel, strip by strip */
+	for (i0 = j0; i0 < m; i0 = i1) {
+	    i1 = (i0 + ARRAYMATRIX_MB < m) ? i0 + ARRAYMATRIX_MB : m;
+	    for (j = j0; j < j1 && j < i1; ++j) {
+		col_j = a[j];
+		for (k = 0; k < j0; ++k) {
+		    col_k = a[k];
+		    d = col_k[j];
+		    for (i = (i0 > j) ? i0 : j; i < i1; ++i)
+			col_j[i] -= col_k[i] * d;
+		}
+	    }
+	}
+
+	/* left-looking factorization within the panel */
+	for (j = j0; j < j1; ++j) {
+	    col_j = a[j];
+	    for (k = j0; k < j; ++k) {
+		col_k = a[k];
+		d = col_k[j];
+		for (i = j; i < m; ++i) col_j[i] -= col_k[i] * d;
+	    }
+
+	    d = col_j[j];
+	    if (d <= 0.0) return (j + 1);
+	    d = SUNRsqrt(d);
+	    for (i = j; i < m; ++i) col_j[i] /= d;
+	}
+    }
+
+    return 0;
+}
+
 CAMLprim value sunml_arraydensematrix_scale(value vc, value va)
 {
     CAMLparam2(vc, va);
@@ -2726,7 +4082,21 @@ CAMLprim value sunml_arraydensematrix_getrf(value va, value vp)
 	caml_invalid_argument("pivot array too small.");
 #endif
 
-    sundials_ml_index r = denseGETRF(ARRAY2_ACOLS(va), m, n, INDEX_ARRAY(vp));
+#ifdef ARRAYMATRIX_LAPACK
+    sundials_ml_index r;
+
+    if (ARRAYMATRIX_FITS_INT(m, n) && m >= n) {
+	int im = m, in = n, info;
+	dgetrf_(&im, &in, ARRAY2_DATA(va), &im, (int *)INDEX_ARRAY(vp), &info);
+	arraymatrix_widen_pivots(INDEX_ARRAY(vp), in);
+	r = info;
+    } else {
+	r = arraydense_getrf(ARRAY2_ACOLS(va), m, n, INDEX_ARRAY(vp));
+    }
+#else
+    sundials_ml_index r = arraydense_getrf(ARRAY2_ACOLS(va), m, n,
+					   INDEX_ARRAY(vp));
+#endif
 
     if (r != 0) {
 	caml_raise_with_arg(MATRIX_EXN_TAG(ZeroDiagonalElement),
@@ -2735,6 +4105,26 @@ CAMLprim value sunml_arraydensematrix_getrf(value va, value vp)
     CAMLreturn (Val_unit);
 }
 
+static void arraydense_getrs(value va, sundials_ml_index m,
+			     sundials_ml_index *p, realtype *b)
+{
+#ifdef ARRAYMATRIX_LAPACK
+    if (ARRAYMATRIX_FITS_INT(m, m)) {
+	int im = m, one = 1;
+	sundials_ml_index k;
+	realtype t;
+
+	for (k = 0; k < m; ++k) {
+	    if (p[k] != k) { t = b[k]; b[k] = b[p[k]]; b[p[k]] = t; }
+	}
+	dtrsv_("L", "N", "U", &im, ARRAY2_DATA(va), &im, b, &one);
+	dtrsv_("U", "N", "N", &im, ARRAY2_DATA(va), &im, b, &one);
+	return;
+    }
+#endif
+    denseGETRS(ARRAY2_ACOLS(va), m, p, b);
+}
+
 CAMLprim value sunml_arraydensematrix_getrs(value va, value vp, value vb)
 {
     CAMLparam3(va, vp, vb);
@@ -2752,7 +4142,7 @@ CAMLprim value sunml_arraydensematrix_getrs(value va, value vp, value vb)
 	caml_invalid_argument("pivot array too small.");
 #endif
 
-    denseGETRS(ARRAY2_ACOLS(va), m, INDEX_ARRAY(vp), REAL_ARRAY(vb));
+    arraydense_getrs(va, m, INDEX_ARRAY(vp), REAL_ARRAY(vb));
     CAMLreturn (Val_unit);
 }
 
@@ -2775,7 +4165,7 @@ CAMLprim value sunml_arraydensematrix_getrs_off(value va, value vp,
 	caml_invalid_argument("p is too small.");
 #endif
 
-    denseGETRS(ARRAY2_ACOLS(va), m, INDEX_ARRAY(vp), REAL_ARRAY(vb) + boff);
+    arraydense_getrs(va, m, INDEX_ARRAY(vp), REAL_ARRAY(vb) + boff);
     CAMLreturn (Val_unit);
 }
 
@@ -2792,7 +4182,16 @@ CAMLprim value sunml_arraydensematrix_potrf(value va)
 	caml_invalid_argument("matrix not square");
 #endif
 
-    densePOTRF(ARRAY2_ACOLS(va), m);
+#ifdef ARRAYMATRIX_LAPACK
+    if (ARRAYMATRIX_FITS_INT(m, m)) {
+	int im = m, info;
+	dpotrf_("L", &im, ARRAY2_DATA(va), &im, &info);
+    } else {
+	arraydense_potrf(ARRAY2_ACOLS(va), m);
+    }
+#else
+    arraydense_potrf(ARRAY2_ACOLS(va), m);
+#endif
     CAMLreturn (Val_unit);
 }
 
@@ -2832,7 +4231,29 @@ CAMLprim value sunml_arraydensematrix_geqrf(value va, value vbeta, value vv)
 	caml_invalid_argument("work is too small.");
 #endif
 
+#ifdef ARRAYMATRIX_LAPACK
+    if (ARRAYMATRIX_FITS_INT(m, n) && m >= n) {
+	int im = m, in = n, lwork = -1, info;
+	double wsize, *work;
+
+	/* dgeqrf only uses its blocked algorithm when given a workspace of
+	   (about) n * nb elements, so ask for the optimal size and only fall
+	   back to v (m >= n elements, unblocked) if it cannot be had.  */
+	dgeqrf_(&im, &in, ARRAY2_DATA(va), &im, REAL_ARRAY(vbeta),
+		&wsize, &lwork, &info);
+	lwork = (int)wsize;
+	work = (lwork > m) ? malloc(lwork * sizeof(double)) : NULL;
+	if (work == NULL) lwork = m;
+
+	dgeqrf_(&im, &in, ARRAY2_DATA(va), &im, REAL_ARRAY(vbeta),
+		(work != NULL) ? work : REAL_ARRAY(vv), &lwork, &info);
+	free(work);
+    } else {
+	denseGEQRF(ARRAY2_ACOLS(va), m, n, REAL_ARRAY(vbeta), REAL_ARRAY(vv));
+    }
+#else
     denseGEQRF(ARRAY2_ACOLS(va), m, n, REAL_ARRAY(vbeta), REAL_ARRAY(vv));
+#endif
     CAMLreturn (Val_unit);
 }
 
@@ -2997,7 +4418,34 @@ CAMLprim value sunml_arraybandmatrix_gbtrf(value va, value vsizes, value vp)
 	caml_invalid_argument("p is too small.");
 #endif
 
+#ifdef ARRAYMATRIX_LAPACK
+    /* The band is passed with ku = smu - ml upper diagonals, so that the
+       storage offsets match, after zeroing the smu - mu rows above the
+       band as bandGBTRF does. Lapack needs ml rows above them for fill.
+       Its multipliers are negated afterward: bandGBTRF stores -l(i,k). */
+    intnat ldab = ba->dim[1];
+
+    if (ARRAYMATRIX_FITS_INT(m, ldab) && smu >= mu + ml
+	    && ldab >= smu + ml + 1) {
+	int im = m, kl = ml, ku = smu - ml, ild = ldab, info;
+	realtype *ab = ARRAY2_DATA(va);
+	sundials_ml_index j;
+
+	for (j = 0; j < m; ++j)
+	    memset(ab + j * ldab, 0, (smu - mu) * sizeof(realtype));
+	dgbtrf_(&im, &im, &kl, &ku, ab, &ild, (int *)INDEX_ARRAY(vp), &info);
+	arraymatrix_widen_pivots(INDEX_ARRAY(vp), im);
+	for (j = 0; j < m; ++j) {
+	    realtype *sub = ab + j * ldab + smu + 1;
+	    sundials_ml_index i, nsub = (m - 1 - j < ml) ? m - 1 - j : ml;
+	    for (i = 0; i < nsub; ++i) sub[i] = -sub[i];
+	}
+    } else {
+	bandGBTRF(ARRAY2_ACOLS(va), m, mu, ml, smu, INDEX_ARRAY(vp));
+    }
+#else
     bandGBTRF(ARRAY2_ACOLS(va), m, mu, ml, smu, INDEX_ARRAY(vp));
+#endif
     CAMLreturn (Val_unit);
 }
 
@@ -3026,3 +4474,370 @@ CAMLprim value sunml_arraybandmatrix_gbtrs(value va, value vsizes, value vp, val
     CAMLreturn (Val_unit);
 }
 
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Block-diagonal matrices
+ *
+ * The nblocks square blocks of order bsize are stored one after the other,
+ * each in column-major order, in a RealArray2 of bsize rows and
+ * nblocks * bsize columns. The blocks are small and independent: every
+ * kernel processes a whole block at a time, while it is in cache, and the
+ * blocks are shared among OpenMP threads when there are enough of them.
+ */
+
+#define BLOCKDIAG_OMP(nblocks, bsize) \
+    ((nblocks) > 1 && (nblocks) * (bsize) * (bsize) >= MATRIX_OMP_MIN_NNZ)
+
+static void blockdiag_scale_add(realtype c, realtype *ad, realtype *bd,
+				sundials_ml_index n)
+{
+    sundials_ml_index i;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (n >= MATRIX_OMP_MIN_NNZ)
+#endif
+    for (i = 0; i < n; ++i)
+	ad[i] = c * ad[i] + bd[i];
+}
+
+static void blockdiag_scale_addi(realtype c, realtype *ad,
+				 sundials_ml_index nblocks,
+				 sundials_ml_index bsize)
+{
+    sundials_ml_index b, i, bsq = bsize * bsize;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(i) \
+	if (BLOCKDIAG_OMP(nblocks, bsize))
+#endif
+    for (b = 0; b < nblocks; ++b) {
+	realtype *ab = ad + b * bsq;
+
+	for (i = 0; i < bsq; ++i) ab[i] *= c;
+	for (i = 0; i < bsize; ++i) ab[i * bsize + i] += 1.0;
+    }
+}
+
+static void blockdiag_matvec(realtype *ad, sundials_ml_index nblocks,
+			     sundials_ml_index bsize, realtype *xd,
+			     realtype *yd)
+{
+    sundials_ml_index b, i, j;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(i, j) \
+	if (BLOCKDIAG_OMP(nblocks, bsize))
+#endif
+    for (b = 0; b < nblocks; ++b) {
+	realtype *ab = ad + b * bsize * bsize;
+	realtype *xb = xd + b * bsize;
+	realtype *yb = yd + b * bsize;
+
+	for (i = 0; i < bsize; ++i) yb[i] = 0.0;
+	for (j = 0; j < bsize; ++j) {
+	    realtype xj = xb[j];
+	    realtype *col_j = ab + j * bsize;
+
+	    for (i = 0; i < bsize; ++i) yb[i] += col_j[i] * xj;
+	}
+    }
+}
+
+/* Factor each block in place with the dense LU routine of Sundials: the
+   pivots of block b are p[b * bsize .. (b+1) * bsize - 1], relative to the
+   block. Returns 0 on success, and otherwise the (1-based) index of a
+   column, over the whole matrix, whose diagonal element is zero.  */
+sundials_ml_index sunml_blockdiag_getrf(value va, sundials_ml_index *p)
+{
+    realtype **acols = ARRAY2_ACOLS(BLOCKDIAG_ARRAY2(va));
+    sundials_ml_index nblocks = BLOCKDIAG_NBLOCKS(va);
+    sundials_ml_index bsize = BLOCKDIAG_BSIZE(va);
+    sundials_ml_index b, fail = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:fail) \
+	if (BLOCKDIAG_OMP(nblocks, bsize))
+#endif
+    for (b = 0; b < nblocks; ++b) {
+	sundials_ml_index r = denseGETRF(acols + b * bsize, bsize, bsize,
+					 p + b * bsize);
+	if (r != 0 && b * bsize + r > fail) fail = b * bsize + r;
+    }
+
+    return fail;
+}
+
+/* Solve with the blocks factored by sunml_blockdiag_getrf, overwriting b.  */
+void sunml_blockdiag_getrs(value va, sundials_ml_index *p, realtype *bd)
+{
+    realtype **acols = ARRAY2_ACOLS(BLOCKDIAG_ARRAY2(va));
+    sundials_ml_index nblocks = BLOCKDIAG_NBLOCKS(va);
+    sundials_ml_index bsize = BLOCKDIAG_BSIZE(va);
+    sundials_ml_index b;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (BLOCKDIAG_OMP(nblocks, bsize))
+#endif
+    for (b = 0; b < nblocks; ++b)
+	denseGETRS(acols + b * bsize, bsize, p + b * bsize, bd + b * bsize);
+}
+
+static bool blockdiag_same_dims(value va, value vb)
+{
+    return (BLOCKDIAG_NBLOCKS(va) == BLOCKDIAG_NBLOCKS(vb)
+	    && BLOCKDIAG_BSIZE(va) == BLOCKDIAG_BSIZE(vb));
+}
+
+#define BLOCKDIAG_LENGTH(v) \
+    (BLOCKDIAG_NBLOCKS(v) * BLOCKDIAG_BSIZE(v) * BLOCKDIAG_BSIZE(v))
+
+CAMLprim value sunml_blockdiagmatrix_scale_add(value vc, value va, value vb)
+{
+    CAMLparam3(vc, va, vb);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!blockdiag_same_dims(va, vb))
+	caml_raise_constant(MATRIX_EXN(IncompatibleArguments));
+#endif
+
+    blockdiag_scale_add(Double_val(vc), BLOCKDIAG_DATA(va),
+			BLOCKDIAG_DATA(vb), BLOCKDIAG_LENGTH(va));
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_blockdiagmatrix_scale_addi(value vc, value va)
+{
+    CAMLparam2(vc, va);
+
+    blockdiag_scale_addi(Double_val(vc), BLOCKDIAG_DATA(va),
+			 BLOCKDIAG_NBLOCKS(va), BLOCKDIAG_BSIZE(va));
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_blockdiagmatrix_matvec(value va, value vx, value vy)
+{
+    CAMLparam3(va, vx, vy);
+    sundials_ml_index n = BLOCKDIAG_NBLOCKS(va) * BLOCKDIAG_BSIZE(va);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (ARRAY1_LEN(vx) < n)
+	caml_invalid_argument("x array too small.");
+    if (ARRAY1_LEN(vy) < n)
+	caml_invalid_argument("y array too small.");
+#endif
+
+    blockdiag_matvec(BLOCKDIAG_DATA(va), BLOCKDIAG_NBLOCKS(va),
+		     BLOCKDIAG_BSIZE(va), REAL_ARRAY(vx), REAL_ARRAY(vy));
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_blockdiagmatrix_getrf(value va, value vp)
+{
+    CAMLparam2(va, vp);
+    sundials_ml_index r;
+
+#if SUNDIALS_ML_SAFE == 1
+    if (ARRAY1_LEN(vp) < BLOCKDIAG_NBLOCKS(va) * BLOCKDIAG_BSIZE(va))
+	caml_invalid_argument("pivot array too small.");
+#endif
+
+    r = sunml_blockdiag_getrf(va, INDEX_ARRAY(vp));
+    if (r != 0) {
+	caml_raise_with_arg(MATRIX_EXN_TAG(ZeroDiagonalElement),
+			    Val_index(r));
+    }
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_blockdiagmatrix_getrs(value va, value vp, value vb)
+{
+    CAMLparam3(va, vp, vb);
+
+#if SUNDIALS_ML_SAFE == 1
+    sundials_ml_index n = BLOCKDIAG_NBLOCKS(va) * BLOCKDIAG_BSIZE(va);
+
+    if (ARRAY1_LEN(vb) < n)
+	caml_invalid_argument("solution vector too small.");
+    if (ARRAY1_LEN(vp) < n)
+	caml_invalid_argument("pivot array too small.");
+#endif
+
+    sunml_blockdiag_getrs(va, INDEX_ARRAY(vp), REAL_ARRAY(vb));
+    CAMLreturn (Val_unit);
+}
+
+#if SUNDIALS_LIB_VERSION >= 300
+
+/* SUNMatrix operations on wrapped block-diagonal matrices. Only the clone
+   operation calls back into OCaml (to allocate the new payload).  */
+
+static int csmat_blockdiag_zero(SUNMatrix A)
+{
+    value va = MAT_BACKLINK(A);
+
+    memset(BLOCKDIAG_DATA(va), 0, BLOCKDIAG_LENGTH(va) * sizeof(realtype));
+    return 0;
+}
+
+static int csmat_blockdiag_copy(SUNMatrix A, SUNMatrix B)
+{
+    value va = MAT_BACKLINK(A);
+    value vb = MAT_BACKLINK(B);
+
+    if (!blockdiag_same_dims(va, vb)) return 1;
+    memcpy(BLOCKDIAG_DATA(vb), BLOCKDIAG_DATA(va),
+	   BLOCKDIAG_LENGTH(va) * sizeof(realtype));
+    return 0;
+}
+
+static int csmat_blockdiag_scale_add(realtype c, SUNMatrix A, SUNMatrix B)
+{
+    value va = MAT_BACKLINK(A);
+    value vb = MAT_BACKLINK(B);
+
+    if (!blockdiag_same_dims(va, vb)) return 1;
+    blockdiag_scale_add(c, BLOCKDIAG_DATA(va), BLOCKDIAG_DATA(vb),
+			BLOCKDIAG_LENGTH(va));
+    return 0;
+}
+
+static int csmat_blockdiag_scale_addi(realtype c, SUNMatrix A)
+{
+    value va = MAT_BACKLINK(A);
+
+    blockdiag_scale_addi(c, BLOCKDIAG_DATA(va), BLOCKDIAG_NBLOCKS(va),
+			 BLOCKDIAG_BSIZE(va));
+    return 0;
+}
+
+static int csmat_blockdiag_matvec(SUNMatrix A, N_Vector x, N_Vector y)
+{
+    value va = MAT_BACKLINK(A);
+    realtype *xd = N_VGetArrayPointer(x);
+    realtype *yd = N_VGetArrayPointer(y);
+
+    if (xd == NULL || yd == NULL || xd == yd) return 1;
+    blockdiag_matvec(BLOCKDIAG_DATA(va), BLOCKDIAG_NBLOCKS(va),
+		     BLOCKDIAG_BSIZE(va), xd, yd);
+    return 0;
+}
+
+static int csmat_blockdiag_space(SUNMatrix A, long int *lenrw,
+				 long int *leniw)
+{
+    value va = MAT_BACKLINK(A);
+
+    *lenrw = BLOCKDIAG_LENGTH(va);
+    *leniw = 3;
+    return 0;
+}
+
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Saved Jacobians
+ */
+
+/* The SUNML_ARGCACHE_JACOBIAN slot of a session's argument cache holds a
+   custom block once Jacobians are kept.  It wraps a malloc'ed struct, so
+   that the pointer remains valid across callbacks into OCaml.  The saved
+   matrix is a clone of the Jacobian, and restore is set by
+   Cvode.reinit/Ida.reinit to replace the next evaluation.  */
+
+#if SUNDIALS_LIB_VERSION >= 300
+struct jac_cache {
+    int enabled;
+    int restore;
+    SUNMatrix saved;
+};
+
+#define JAC_CACHE_VAL(v) (*(struct jac_cache **)Data_custom_val(v))
+
+static void jac_cache_clear(struct jac_cache *jc)
+{
+    if (jc->saved != NULL) SUNMatDestroy(jc->saved);
+    jc->saved = NULL;
+    jc->restore = 0;
+}
+
+static void finalize_jac_cache(value vjc)
+{
+    struct jac_cache *jc = JAC_CACHE_VAL(vjc);
+
+    if (jc == NULL) return;
+    jac_cache_clear(jc);
+    free(jc);
+}
+
+static struct jac_cache *jac_cache_get(value vcache)
+{
+    value vjc = Field(vcache, SUNML_ARGCACHE_JACOBIAN);
+    struct jac_cache *jc;
+
+    if (Is_long(vjc)) return NULL;
+    jc = JAC_CACHE_VAL(vjc);
+    return jc->enabled ? jc : NULL;
+}
+
+int sunml_jac_cache_restore(value vcache, SUNMatrix jac)
+{
+    struct jac_cache *jc = jac_cache_get(vcache);
+
+    if (jc == NULL || !jc->restore) return 0;
+    jc->restore = 0;
+
+    if (SUNMatGetID(jc->saved) != SUNMatGetID(jac)
+	    || SUNMatCopy(jc->saved, jac) != 0)
+	return 0;
+    return 1;
+}
+
+void sunml_jac_cache_save(value vcache, SUNMatrix jac)
+{
+    CAMLparam1(vcache);
+    struct jac_cache *jc = jac_cache_get(vcache);
+
+    if (jc == NULL) CAMLreturn0;
+
+    if (jc->saved == NULL) {
+	jc->saved = SUNMatClone(jac);
+	if (jc->saved == NULL) CAMLreturn0;
+    }
+    if (SUNMatCopy(jac, jc->saved) != 0) jac_cache_clear(jc);
+
+    CAMLreturn0;
+}
+#endif
+
+/* Keeping starts saving Jacobians (if necessary) and restores the last one
+   (if any) in place of the next evaluation.  Not keeping stops saving them
+   and forgets the last one.  The block is kept once created since a
+   callback in progress may still hold a pointer to it.  */
+CAMLprim value sunml_matrix_keep_jacobian(value vcache, value vkeep)
+{
+    CAMLparam2(vcache, vkeep);
+#if SUNDIALS_LIB_VERSION >= 300
+    CAMLlocal1(vjc);
+    struct jac_cache *jc;
+
+    vjc = Field(vcache, SUNML_ARGCACHE_JACOBIAN);
+    if (Is_long(vjc)) {
+	if (!Bool_val(vkeep)) CAMLreturn(Val_unit);
+
+	vjc = caml_alloc_final(1, &finalize_jac_cache, 0, 1);
+	JAC_CACHE_VAL(vjc) = NULL;
+	Store_field(vcache, SUNML_ARGCACHE_JACOBIAN, vjc);
+	jc = calloc(1, sizeof(struct jac_cache));
+	if (jc == NULL) caml_raise_out_of_memory();
+	JAC_CACHE_VAL(vjc) = jc;
+    }
+
+    jc = JAC_CACHE_VAL(vjc);
+    jc->enabled = Bool_val(vkeep);
+    if (jc->enabled)
+	jc->restore = (jc->saved != NULL);
+    else
+	jac_cache_clear(jc);
+#endif
+    CAMLreturn(Val_unit);
+}
@@ -196,6 +196,31 @@ struct csmat {
 // MAT_VAL turns an OCaml Matrix.t into a c-sunmatrix
 #define MAT_VAL(v) (MAT_CVAL(Field(v, RECORD_MAT_MATRIX_RAWPTR)))
 
+/* Saved Jacobians (see Cvode.reinit ~keep_jacobian), kept in a session's
+   argument cache (vcache).  The Jacobian trampolines call
+   sunml_jac_cache_restore before calling OCaml, and skip the call if it
+   returns nonzero, and sunml_jac_cache_save after a successful call.  */
+int sunml_jac_cache_restore(value vcache, SUNMatrix jac);
+void sunml_jac_cache_save(value vcache, SUNMatrix jac);
+
+/* Shared sparsity patterns (see Matrix.Sparse.share_pattern).  The
+   matrices that share a pattern, and the linear solvers that borrow its
+   symbolic analysis, each hold a reference.  The first KLU solver to
+   analyze the pattern stores its symbolic analysis here, together with
+   the ordering used and the function that frees it when the last
+   reference is released.  */
+struct sunml_sparse_share {
+    intnat refs;
+    void *symbolic;
+    int ordering;
+    void (*free_symbolic)(void *symbolic);
+};
+
+/* Returns the share of a sparse matrix created by the OCaml library, or
+   NULL if its pattern is not shared.  */
+struct sunml_sparse_share *sunml_matrix_sparse_share(SUNMatrix A);
+void sunml_sparse_share_release(struct sunml_sparse_share *s);
+
 #elif SUNDIALS_LIB_VERSION >= 260 // 260 <= SUNDIALS_LIB_VERSION < 300
 #define DLSMAT(v) (*(DlsMat *)Data_custom_val(v))
 #define SLSMAT(v) (*(SlsMat *)Data_custom_val(v))
@@ -232,6 +257,13 @@ CAMLprim value sunml_matrix_band_wrap(DlsMat a);
 #define MAT_TO_SFORMAT(x) (Val_int(x))
 #define MAT_FROM_SFORMAT(x) (Int_val(x))
 
+// The matrix_content.rawptr of a sparse matrix has a second word that
+// indicates whether its sparsity pattern is frozen, and a third that
+// points to a struct sunml_sparse_share if the pattern is shared.
+#define MAT_SPARSE_FROZEN(v) (((intnat *)Data_custom_val(v))[1])
+#define MAT_SPARSE_SHARE(v) \
+    (((struct sunml_sparse_share **)Data_custom_val(v))[2])
+
 enum mat_matrix_id_tag {
     MATRIX_ID_DENSE = 0,
     MATRIX_ID_BAND,
@@ -239,6 +271,7 @@ enum mat_matrix_id_tag {
     MATRIX_ID_CUSTOM,	    /* This and following are all custom matrices. */
     MATRIX_ID_ARRAYDENSE,
     MATRIX_ID_ARRAYBAND,
+    MATRIX_ID_BLOCKDIAG,
 };
 
 enum mat_matrix_content_index {
@@ -283,6 +316,13 @@ enum mat_sparse_data_index {
 
 #define MAT_UNWRAP(v) (Field(v, RECORD_MAT_MATRIX_PAYLOAD))
 
+// A Matrix.BlockDiag.t pairs a RealArray2 of bsize rows and
+// nblocks * bsize columns with an array of views onto its blocks.
+#define BLOCKDIAG_ARRAY2(v)  (Field((v), 0))
+#define BLOCKDIAG_DATA(v)    (ARRAY2_DATA(BLOCKDIAG_ARRAY2(v)))
+#define BLOCKDIAG_BSIZE(v)   ((sundials_ml_index)ARRAY2_NROWS(BLOCKDIAG_ARRAY2(v)))
+#define BLOCKDIAG_NBLOCKS(v) ((sundials_ml_index)Wosize_val(Field((v), 1)))
+
 /* This enum must list exceptions in the same order as the call to
  * c_init_module in matrix.ml.  */
 enum mat_exn_index {
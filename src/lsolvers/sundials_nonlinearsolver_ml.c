@@ -215,7 +215,7 @@ CAMLprim void sunml_nlsolver_init_module (value exns)
 #if 400 <= SUNDIALS_LIB_VERSION
 void sunml_nlsolver_check_flag(const char *call, int flag)
 {
-    static char exmsg[MAX_ERRMSG_LEN] = "";
+    char exmsg[MAX_ERRMSG_LEN];
 
     if (flag == SUN_NLS_SUCCESS
 	    || flag == SUN_NLS_CONTINUE
@@ -526,11 +526,34 @@ CAMLprim value sunml_nlsolver_set_lsolve_fn(value vnls)
     CAMLreturn (Val_unit);
 }
 
+#if 400 <= SUNDIALS_LIB_VERSION
+/* The convergence test currently installed in a native NLS. */
+static SUNNonlinSolConvTestFn current_ctest(SUNNonlinearSolver nls)
+{
+    switch (SUNNonlinSolGetType(nls)) {
+    case SUNNONLINEARSOLVER_ROOTFIND:
+	return ((SUNNonlinearSolverContent_Newton)nls->content)->CTest;
+
+    case SUNNONLINEARSOLVER_FIXEDPOINT:
+	return ((SUNNonlinearSolverContent_FixedPoint)nls->content)->CTest;
+
+    default:
+	return NULL;
+    }
+}
+#endif
+
 CAMLprim value sunml_nlsolver_set_convtest_fn(value vnls)
 {
     CAMLparam1(vnls);
 #if SUNDIALS_LIB_VERSION >= 400
     SUNNonlinearSolver nls = NLSOLVER_VAL(vnls);
+    SUNNonlinSolConvTestFn ctest = current_ctest(nls);
+
+    /* Remember the test installed by an integrator (C/Cnls) so that it can
+       be reinstated by sunml_nlsolver_clear_convtest_fn. */
+    if (ctest != NULL && ctest != convtest_callback)
+	NLS_NATIVE_CTEST(nls) = ctest;
 
     int flag = SUNNonlinSolSetConvTestFn(nls, convtest_callback);
     NLS_CHECK_FLAG("SUNNonlinSolSetConvTestFn", flag);
@@ -538,6 +561,26 @@ CAMLprim value sunml_nlsolver_set_convtest_fn(value vnls)
     CAMLreturn (Val_unit);
 }
 
+/* Reinstate the integrator's convergence test, which is then invoked
+   directly from C rather than via convtest_callback. */
+CAMLprim value sunml_nlsolver_clear_convtest_fn(value vnls)
+{
+    CAMLparam1(vnls);
+#if SUNDIALS_LIB_VERSION >= 400
+    SUNNonlinearSolver nls = NLSOLVER_VAL(vnls);
+    SUNNonlinSolConvTestFn ctest = current_ctest(nls);
+
+    if (ctest == convtest_callback) {
+	if (NLS_NATIVE_CTEST(nls) == NULL)
+	    caml_raise_constant(NLSOLVER_EXN(IncorrectUse));
+
+	int flag = SUNNonlinSolSetConvTestFn(nls, NLS_NATIVE_CTEST(nls));
+	NLS_CHECK_FLAG("SUNNonlinSolSetConvTestFn", flag);
+    }
+#endif
+    CAMLreturn (Val_unit);
+}
+
 CAMLprim value sunml_nlsolver_set_max_iters(value vnls, value vi)
 {
     CAMLparam2(vnls, vi);
@@ -801,6 +844,7 @@ static value rewrap_nlsolver(SUNNonlinearSolver nls0, value vcallbacks)
     free(nls0);
 
     NLS_CALLBACKS(nls) = vcallbacks;
+    NLS_NATIVE_CTEST(nls) = NULL;
     caml_register_generational_global_root(&NLS_CALLBACKS(nls));
 
     // Setup the OCaml-side
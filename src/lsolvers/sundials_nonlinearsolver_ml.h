@@ -27,9 +27,11 @@
 struct sunml_nls {
     struct _generic_SUNNonlinearSolver nls;
     value callbacks;
+    SUNNonlinSolConvTestFn native_ctest;
 };
 
 #define NLS_CALLBACKS(nls) (((struct sunml_nls *)nls)->callbacks)
+#define NLS_NATIVE_CTEST(nls) (((struct sunml_nls *)nls)->native_ctest)
 
 void sunml_nlsolver_check_flag(const char *call, int flag);
 #define NLS_CHECK_FLAG(call, flag) if (flag != SUN_NLS_SUCCESS) \
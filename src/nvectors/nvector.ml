@@ -37,6 +37,22 @@ type nvector_id =
 external get_id : ('data, 'kind) t -> nvector_id
   = "sunml_nvec_get_id"
 
+type memory = {
+  wrapped : int;
+  clones : int;
+  clone_bytes : int;
+  roots : int;
+  max_clones : int;
+  max_clone_bytes : int;
+  max_roots : int;
+}
+
+external get_memory : unit -> memory
+  = "sunml_nvec_get_memory"
+
+external reset_memory_high_water : unit -> unit
+  = "sunml_nvec_reset_memory_high_water"
+
 module type NVECTOR_OPS =
   sig
     type t
@@ -21,7 +21,7 @@
 (** Represents an nvector of kind ['kind] with underlying data of type ['data].
     The type argument ['kind] is either {!Nvector_serial.kind},
     {!Nvector_parallel.kind}, {!Nvector_custom.kind}, {!Nvector_openmp.kind},
-    or {!Nvector_pthreads.kind}.
+    {!Nvector_pthreads.kind}, or {!Nvector_cuda.kind}.
     It is needed because some linear solvers make additional
     assumptions about the underlying vector representation.
 
@@ -63,6 +63,36 @@ type nvector_id =
     @since 2.9.0 *)
 val get_id : ('data, 'kind) t -> nvector_id
 
+(** {2:memory Memory accounting} *)
+
+(** Process-wide counts of the nvectors of the library that are alive, that
+    is, not yet reclaimed by the garbage collector or destroyed by Sundials,
+    with high-water marks. Nvectors created from OCaml, by [wrap] or [make]
+    functions, are distinguished from those cloned by Sundials, for
+    instance, for the workspaces of solvers. Cloned nvectors that are never
+    destroyed show up as a growing number of [clones]. CUDA nvectors are
+    not counted. *)
+type memory = {
+  wrapped : int;          (** Live nvectors created from OCaml. *)
+  clones : int;           (** Live nvectors cloned by Sundials. *)
+  clone_bytes : int;      (** The size of the payloads of the live clones,
+                              in bytes. The payloads of custom nvectors are
+                              not counted. *)
+  roots : int;            (** Generational global roots held by live
+                              nvectors: one for the payload of each vector
+                              and one more for each custom, block, or
+                              scratch nvector. *)
+  max_clones : int;       (** The high-water mark of [clones]. *)
+  max_clone_bytes : int;  (** The high-water mark of [clone_bytes]. *)
+  max_roots : int;        (** The high-water mark of [roots]. *)
+}
+
+(** Returns the current counts and high-water marks. *)
+val get_memory : unit -> memory
+
+(** Resets the high-water marks to the current counts. *)
+val reset_memory_high_water : unit -> unit
+
 (** {2:genvec Generic vector operations}
 
     @cvode <node7> Description of the NVECTOR module. *)
@@ -0,0 +1,226 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*             Timothy Bourke, Jun Inoue, and Marc Pouzet              *)
+(*             (Inria/ENS)     (Inria/ENS)    (UPMC/ENS/Inria)         *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+open Sundials
+
+type cptr
+
+type data = {
+  host : RealArray.t;
+  cptr : cptr;
+}
+
+type kind = [`Cuda]
+type t = (data, kind) Nvector.t
+
+type memory = Unmanaged | Managed
+
+(* Selectively enable and disable fused and array operations *)
+external c_enablefusedops_cuda                        : t -> bool -> unit
+  = "sunml_nvec_cuda_enablefusedops"
+external c_enablelinearcombination_cuda               : t -> bool -> unit
+  = "sunml_nvec_cuda_enablelinearcombination"
+external c_enablescaleaddmulti_cuda                   : t -> bool -> unit
+  = "sunml_nvec_cuda_enablescaleaddmulti"
+external c_enabledotprodmulti_cuda                    : t -> bool -> unit
+  = "sunml_nvec_cuda_enabledotprodmulti"
+external c_enablelinearsumvectorarray_cuda            : t -> bool -> unit
+  = "sunml_nvec_cuda_enablelinearsumvectorarray"
+external c_enablescalevectorarray_cuda                : t -> bool -> unit
+  = "sunml_nvec_cuda_enablescalevectorarray"
+external c_enableconstvectorarray_cuda                : t -> bool -> unit
+  = "sunml_nvec_cuda_enableconstvectorarray"
+external c_enablewrmsnormvectorarray_cuda             : t -> bool -> unit
+  = "sunml_nvec_cuda_enablewrmsnormvectorarray"
+external c_enablewrmsnormmaskvectorarray_cuda         : t -> bool -> unit
+  = "sunml_nvec_cuda_enablewrmsnormmaskvectorarray"
+external c_enablescaleaddmultivectorarray_cuda        : t -> bool -> unit
+  = "sunml_nvec_cuda_enablescaleaddmultivectorarray"
+external c_enablelinearcombinationvectorarray_cuda    : t -> bool -> unit
+  = "sunml_nvec_cuda_enablelinearcombinationvectorarray"
+
+external c_make : bool -> int -> float -> (data -> bool) -> t
+  = "sunml_nvec_make_cuda"
+
+external c_wrap : RealArray.t -> (data -> bool) -> t
+  = "sunml_nvec_wrap_cuda"
+
+external c_host : bool -> bool -> data -> RealArray.t
+  = "sunml_nvec_cuda_host"
+
+let host ?(read=true) ?(write=true) d = c_host read write d
+
+let length d = RealArray.length d.host
+
+let make ?(with_fused_ops=false) ?(memory=Unmanaged) n iv =
+  let nv = c_make (memory = Managed) n iv (fun d -> length d = n) in
+  if with_fused_ops then c_enablefusedops_cuda nv true;
+  nv
+
+let wrap ?(with_fused_ops=false) v =
+  let len = RealArray.length v in
+  let nv = c_wrap v (fun d -> length d = len) in
+  if with_fused_ops then c_enablefusedops_cuda nv true;
+  nv
+
+let unwrap = Nvector.unwrap
+
+external is_managed : t -> bool
+  = "sunml_nvec_cuda_is_managed"
+
+let pp fmt v = RealArray.pp fmt (host ~write:false (unwrap v))
+
+let do_enable f nv v =
+  match v with
+  | None -> ()
+  | Some v -> f nv v
+
+let enable
+   ?with_fused_ops
+   ?with_linear_combination
+   ?with_scale_add_multi
+   ?with_dot_prod_multi
+   ?with_linear_sum_vector_array
+   ?with_scale_vector_array
+   ?with_const_vector_array
+   ?with_wrms_norm_vector_array
+   ?with_wrms_norm_mask_vector_array
+   ?with_scale_add_multi_vector_array
+   ?with_linear_combination_vector_array
+   nv
+  = do_enable c_enablefusedops_cuda nv
+              with_fused_ops;
+    do_enable c_enablelinearcombination_cuda nv
+              with_linear_combination;
+    do_enable c_enablescaleaddmulti_cuda nv
+              with_scale_add_multi;
+    do_enable c_enabledotprodmulti_cuda nv
+              with_dot_prod_multi;
+    do_enable c_enablelinearsumvectorarray_cuda nv
+              with_linear_sum_vector_array;
+    do_enable c_enablescalevectorarray_cuda nv
+              with_scale_vector_array;
+    do_enable c_enableconstvectorarray_cuda nv
+              with_const_vector_array;
+    do_enable c_enablewrmsnormvectorarray_cuda nv
+              with_wrms_norm_vector_array;
+    do_enable c_enablewrmsnormmaskvectorarray_cuda nv
+              with_wrms_norm_mask_vector_array;
+    do_enable c_enablescaleaddmultivectorarray_cuda nv
+              with_scale_add_multi_vector_array;
+    do_enable c_enablelinearcombinationvectorarray_cuda nv
+              with_linear_combination_vector_array
+
+module Ops = struct
+  type t = (data, kind) Nvector.t
+
+  external n_vclone        : t -> t
+    = "sunml_nvec_cuda_n_vclone"
+
+  external n_vlinearsum    : float -> t -> float -> t -> t -> unit
+    = "sunml_nvec_cuda_n_vlinearsum"
+
+  external n_vconst        : float -> t -> unit
+    = "sunml_nvec_cuda_n_vconst"
+
+  external n_vprod         : t -> t -> t -> unit
+    = "sunml_nvec_cuda_n_vprod"
+
+  external n_vdiv          : t -> t -> t -> unit
+    = "sunml_nvec_cuda_n_vdiv"
+
+  external n_vscale        : float -> t -> t -> unit
+    = "sunml_nvec_cuda_n_vscale"
+
+  external n_vabs          : t -> t -> unit
+    = "sunml_nvec_cuda_n_vabs"
+
+  external n_vinv          : t -> t -> unit
+    = "sunml_nvec_cuda_n_vinv"
+
+  external n_vaddconst     : t -> float -> t -> unit
+    = "sunml_nvec_cuda_n_vaddconst"
+
+  external n_vdotprod      : t -> t -> float
+    = "sunml_nvec_cuda_n_vdotprod"
+
+  external n_vmaxnorm      : t -> float
+    = "sunml_nvec_cuda_n_vmaxnorm"
+
+  external n_vwrmsnorm     : t -> t -> float
+    = "sunml_nvec_cuda_n_vwrmsnorm"
+
+  external n_vwrmsnormmask : t -> t -> t -> float
+    = "sunml_nvec_cuda_n_vwrmsnormmask"
+
+  external n_vmin          : t -> float
+    = "sunml_nvec_cuda_n_vmin"
+
+  external n_vwl2norm      : t -> t -> float
+    = "sunml_nvec_cuda_n_vwl2norm"
+
+  external n_vl1norm       : t -> float
+    = "sunml_nvec_cuda_n_vl1norm"
+
+  external n_vcompare      : float -> t -> t -> unit
+    = "sunml_nvec_cuda_n_vcompare"
+
+  external n_vinvtest      : t -> t -> bool
+    = "sunml_nvec_cuda_n_vinvtest"
+
+  external n_vconstrmask   : t -> t -> t -> bool
+    = "sunml_nvec_cuda_n_vconstrmask"
+
+  external n_vminquotient  : t -> t -> float
+    = "sunml_nvec_cuda_n_vminquotient"
+
+  external n_vspace  : t -> int * int
+    = "sunml_nvec_cuda_n_vspace"
+
+  external n_vlinearcombination : RealArray.t -> t array -> t -> unit
+    = "sunml_nvec_cuda_n_vlinearcombination"
+
+  external n_vscaleaddmulti : RealArray.t -> t -> t array -> t array -> unit
+    = "sunml_nvec_cuda_n_vscaleaddmulti"
+
+  external n_vdotprodmulti : t -> t array -> RealArray.t -> unit
+    = "sunml_nvec_cuda_n_vdotprodmulti"
+
+  external n_vlinearsumvectorarray
+    : float -> t array -> float -> t array -> t array -> unit
+    = "sunml_nvec_cuda_n_vlinearsumvectorarray"
+
+  external n_vscalevectorarray
+    : RealArray.t -> t array -> t array -> unit
+    = "sunml_nvec_cuda_n_vscalevectorarray"
+
+  external n_vconstvectorarray
+    : float -> t array -> unit
+    = "sunml_nvec_cuda_n_vconstvectorarray"
+
+  external n_vwrmsnormvectorarray
+    : t array -> t array -> RealArray.t -> unit
+    = "sunml_nvec_cuda_n_vwrmsnormvectorarray"
+
+  external n_vwrmsnormmaskvectorarray
+    : t array -> t array -> t -> RealArray.t -> unit
+    = "sunml_nvec_cuda_n_vwrmsnormmaskvectorarray"
+
+  external n_vscaleaddmultivectorarray
+    : RealArray.t -> t array -> t array array -> t array array -> unit
+    = "sunml_nvec_cuda_n_vscaleaddmultivectorarray"
+
+  external n_vlinearcombinationvectorarray
+    : RealArray.t -> t array array -> t array -> unit
+    = "sunml_nvec_cuda_n_vlinearcombinationvectorarray"
+end
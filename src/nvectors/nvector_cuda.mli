@@ -0,0 +1,140 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*             Timothy Bourke, Jun Inoue, and Marc Pouzet              *)
+(*             (Inria/ENS)     (Inria/ENS)    (UPMC/ENS/Inria)         *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+(** The CUDA nvectors of Sundials (requires CUDA).
+
+    The elements of a CUDA nvector reside on a GPU, where the vector
+    operations are executed. They are mirrored by a copy in host memory
+    that OCaml code accesses through {!host}. The two copies are
+    synchronized lazily: vector operations first transfer the inputs that
+    were modified on the host, and the host copy is only updated when it is
+    requested after a modification on the device.
+
+    Right-hand side functions and other callbacks receive the {!data} of
+    their nvector arguments. OCaml callbacks obtain the elements with
+    {!host}, for example,
+{[
+let f t y yd =
+  let y = Nvector_cuda.host ~write:false y
+  and yd = Nvector_cuda.host ~read:false yd in
+  ...
+]}
+    Alternatively, native callbacks ({!Sundials.cfun}) can launch kernels
+    that operate directly on the device copy. They must obtain pointers to
+    the elements of their N_Vector arguments with
+    [sunml_nvec_cuda_device_data(v, read, write)], declared in
+    [nvector_cuda_ml.h], which keeps track of the synchronization.
+
+    @version VERSION()
+    @author Timothy Bourke (Inria/ENS)
+    @author Jun Inoue (Inria/ENS)
+    @author Marc Pouzet (UPMC/ENS/Inria)
+    @cvode <node7#ss:nvec_cuda> NVECTOR_CUDA
+    @since 4.0.0 *)
+
+open Sundials
+
+(** The data of a CUDA nvector. *)
+type data
+
+(** Represents the internal layout of a CUDA nvector. The elements are not
+    accessible from the host, so CUDA nvectors cannot be used with the
+    direct linear solvers. *)
+type kind = [`Cuda]
+
+(** The type of CUDA nvectors. *)
+type t = (data, kind) Nvector.t
+
+(** The memory that holds the elements of an nvector. *)
+type memory =
+  | Unmanaged (** Separate device and host allocations, between which
+                  the elements are copied when necessary. *)
+  | Managed   (** A single allocation of unified memory accessible from
+                  both the host and the device. Transfers are performed by
+                  the CUDA driver on demand. *)
+
+(** [make n iv] creates a new CUDA nvector with [n] elements initialized to
+    [iv]. The memory is {!Unmanaged} by default. The vectors cloned from it
+    by the solvers use the same kind of memory.
+
+    The optional argument enables the fused and array operations for a
+    given nvector (they are disabled by default).
+
+    @cvode <node5> N_VMake_Cuda
+    @cvode <node5> N_VMakeManaged_Cuda *)
+val make : ?with_fused_ops:bool -> ?memory:memory -> int -> float -> t
+
+(** [wrap a] creates a new unmanaged CUDA nvector whose host copy is [a].
+    The elements of [a] are transferred to the device when first needed.
+
+    @cvode <node5> N_VMake_Cuda *)
+val wrap : ?with_fused_ops:bool -> RealArray.t -> t
+
+(** [host d] returns the host copy of the elements of a CUDA nvector.
+    If [read] is [true], the default, the host copy is first brought up to
+    date with the device. If [write] is [true], also the default, the host
+    copy is considered modified and it is transferred to the device before
+    the next operation on the vector. Callbacks should pass [~write:false]
+    for their inputs and [~read:false] for their outputs.
+
+    The array of a {!Managed} nvector aliases its unified memory; it must
+    not be used after the nvector has been reclaimed.
+
+    @raise Invalid_argument The nvector has been destroyed. *)
+val host : ?read:bool -> ?write:bool -> data -> RealArray.t
+
+(** Returns the number of elements of a CUDA nvector. *)
+val length : data -> int
+
+(** Aliases {!Nvector.unwrap}. *)
+val unwrap : t -> data
+
+(** Indicates whether an nvector uses {!Managed} memory. *)
+val is_managed : t -> bool
+
+(** Pretty-print a CUDA nvector using the
+    {{:OCAML_DOC_ROOT(Format.html)} Format} module. *)
+val pp : Format.formatter -> t -> unit
+
+(** Selectively enable or disable fused and array operations.
+    The [with_fused_ops] argument enables or disables all such operations.
+
+    @cvode <node5> N_VEnableFusedOps_Cuda
+    @cvode <node5> N_VEnableLinearCombination_Cuda
+    @cvode <node5> N_VEnableScaleAddMulti_Cuda
+    @cvode <node5> N_VEnableDotProdMulti_Cuda
+    @cvode <node5> N_VEnableLinearSumVectorArray_Cuda
+    @cvode <node5> N_VEnableScaleVectorArray_Cuda
+    @cvode <node5> N_VEnableConstVectorArray_Cuda
+    @cvode <node5> N_VEnableWrmsNormVectorArray_Cuda
+    @cvode <node5> N_VEnableWrmsNormMaskVectorArray_Cuda
+    @cvode <node5> N_VEnableScaleAddMultiVectorArray_Cuda
+    @cvode <node5> N_VEnableLinearCombinationVectorArray_Cuda *)
+val enable :
+     ?with_fused_ops                       : bool
+  -> ?with_linear_combination              : bool
+  -> ?with_scale_add_multi                 : bool
+  -> ?with_dot_prod_multi                  : bool
+  -> ?with_linear_sum_vector_array         : bool
+  -> ?with_scale_vector_array              : bool
+  -> ?with_const_vector_array              : bool
+  -> ?with_wrms_norm_vector_array          : bool
+  -> ?with_wrms_norm_mask_vector_array     : bool
+  -> ?with_scale_add_multi_vector_array    : bool
+  -> ?with_linear_combination_vector_array : bool
+  -> t
+  -> unit
+
+(** Underlying nvector operations on CUDA nvectors. They are executed on
+    the device. *)
+module Ops : Nvector.NVECTOR_OPS with type t = t
@@ -0,0 +1,1044 @@
+/***********************************************************************
+ *                                                                     *
+ *                   OCaml interface to Sundials                       *
+ *                                                                     *
+ *             Timothy Bourke, Jun Inoue, and Marc Pouzet              *
+ *             (Inria/ENS)     (Inria/ENS)    (UPMC/ENS/Inria)         *
+ *                                                                     *
+ *  Copyright 2020 Institut National de Recherche en Informatique et   *
+ *  en Automatique.  All rights reserved.  This file is distributed    *
+ *  under a New BSD License, refer to the file LICENSE.                *
+ *                                                                     *
+ ***********************************************************************/
+
+#include "../sundials/sundials_ml.h"
+#include "nvector_ml.h"
+#include "nvector_cuda_ml.h"
+
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <caml/callback.h>
+#include <caml/custom.h>
+#include <caml/fail.h>
+#include <caml/bigarray.h>
+
+#include <cuda_runtime.h>
+#include <nvector/nvector_cuda.h>
+
+/** Layout and synchronization */
+
+enum cuda_state {
+    CUDA_SYNCED = 0,	    /* host and device copies agree */
+    CUDA_HOST_NEWER,	    /* the host copy has been modified */
+    CUDA_DEVICE_NEWER,	    /* the device copy has been modified */
+};
+
+struct cuda_cnvec {
+    struct cnvec cnvec;	    /* must be first */
+    N_Vector cuda;	    /* the Sundials vector that owns the content */
+    realtype *data;	    /* device (or unified) memory allocated here */
+    int managed;
+    enum cuda_state state;
+};
+
+#define CUDA_CNVEC(nv) ((struct cuda_cnvec *)(nv))
+
+/* The payload is an Nvector_cuda.data record.  */
+#define PAYLOAD_HOST(p) (Field((p), 0))
+#define PAYLOAD_NVEC(p) (*(N_Vector *)&Field(Field((p), 1), 0))
+
+static void to_device(N_Vector v)
+{
+    struct cuda_cnvec *c = CUDA_CNVEC(v);
+
+    if (c->state == CUDA_HOST_NEWER) {
+	if (!c->managed) N_VCopyToDevice_Cuda(v);
+	c->state = CUDA_SYNCED;
+    }
+}
+
+static void to_host(N_Vector v)
+{
+    struct cuda_cnvec *c = CUDA_CNVEC(v);
+
+    if (c->state == CUDA_DEVICE_NEWER) {
+	if (c->managed) cudaDeviceSynchronize();
+	else N_VCopyFromDevice_Cuda(v);
+	c->state = CUDA_SYNCED;
+    }
+}
+
+realtype *sunml_nvec_cuda_device_data(N_Vector v, int read, int write)
+{
+    if (read) to_device(v);
+    if (write) CUDA_CNVEC(v)->state = CUDA_DEVICE_NEWER;
+    return N_VGetDeviceArrayPointer_Cuda(v);
+}
+
+realtype *sunml_nvec_cuda_host_data(N_Vector v, int read, int write)
+{
+    /* Kernels may still be running over unified memory.  */
+    if (read || CUDA_CNVEC(v)->managed) to_host(v);
+    if (write) CUDA_CNVEC(v)->state = CUDA_HOST_NEWER;
+    return N_VGetHostArrayPointer_Cuda(v);
+}
+
+#define SYNC_IN(v)  (to_device(v))
+#define MARK_OUT(v) (CUDA_CNVEC(v)->state = CUDA_DEVICE_NEWER)
+
+static void sync_in_array(int n, N_Vector *xs)
+{
+    int i;
+    for (i = 0; i < n; ++i) SYNC_IN(xs[i]);
+}
+
+static void mark_out_array(int n, N_Vector *xs)
+{
+    int i;
+    for (i = 0; i < n; ++i) MARK_OUT(xs[i]);
+}
+
+/** Operations */
+
+/* The standard operations preceded by the transfer of inputs modified on
+   the host, and followed by the marking of outputs.  Outputs are always
+   completely overwritten, so they are only transferred if they are also
+   inputs.  */
+
+static void cuda_linearsum(realtype a, N_Vector x, realtype b, N_Vector y,
+			   N_Vector z)
+{
+    SYNC_IN(x); SYNC_IN(y);
+    N_VLinearSum_Cuda(a, x, b, y, z);
+    MARK_OUT(z);
+}
+
+static void cuda_const(realtype c, N_Vector z)
+{
+    N_VConst_Cuda(c, z);
+    MARK_OUT(z);
+}
+
+static void cuda_prod(N_Vector x, N_Vector y, N_Vector z)
+{
+    SYNC_IN(x); SYNC_IN(y);
+    N_VProd_Cuda(x, y, z);
+    MARK_OUT(z);
+}
+
+static void cuda_div(N_Vector x, N_Vector y, N_Vector z)
+{
+    SYNC_IN(x); SYNC_IN(y);
+    N_VDiv_Cuda(x, y, z);
+    MARK_OUT(z);
+}
+
+static void cuda_scale(realtype c, N_Vector x, N_Vector z)
+{
+    SYNC_IN(x);
+    N_VScale_Cuda(c, x, z);
+    MARK_OUT(z);
+}
+
+static void cuda_abs(N_Vector x, N_Vector z)
+{
+    SYNC_IN(x);
+    N_VAbs_Cuda(x, z);
+    MARK_OUT(z);
+}
+
+static void cuda_inv(N_Vector x, N_Vector z)
+{
+    SYNC_IN(x);
+    N_VInv_Cuda(x, z);
+    MARK_OUT(z);
+}
+
+static void cuda_addconst(N_Vector x, realtype b, N_Vector z)
+{
+    SYNC_IN(x);
+    N_VAddConst_Cuda(x, b, z);
+    MARK_OUT(z);
+}
+
+static realtype cuda_dotprod(N_Vector x, N_Vector y)
+{
+    SYNC_IN(x); SYNC_IN(y);
+    return N_VDotProd_Cuda(x, y);
+}
+
+static realtype cuda_maxnorm(N_Vector x)
+{
+    SYNC_IN(x);
+    return N_VMaxNorm_Cuda(x);
+}
+
+static realtype cuda_wrmsnorm(N_Vector x, N_Vector w)
+{
+    SYNC_IN(x); SYNC_IN(w);
+    return N_VWrmsNorm_Cuda(x, w);
+}
+
+static realtype cuda_wrmsnormmask(N_Vector x, N_Vector w, N_Vector id)
+{
+    SYNC_IN(x); SYNC_IN(w); SYNC_IN(id);
+    return N_VWrmsNormMask_Cuda(x, w, id);
+}
+
+static realtype cuda_min(N_Vector x)
+{
+    SYNC_IN(x);
+    return N_VMin_Cuda(x);
+}
+
+static realtype cuda_wl2norm(N_Vector x, N_Vector w)
+{
+    SYNC_IN(x); SYNC_IN(w);
+    return N_VWL2Norm_Cuda(x, w);
+}
+
+static realtype cuda_l1norm(N_Vector x)
+{
+    SYNC_IN(x);
+    return N_VL1Norm_Cuda(x);
+}
+
+static void cuda_compare(realtype c, N_Vector x, N_Vector z)
+{
+    SYNC_IN(x);
+    N_VCompare_Cuda(c, x, z);
+    MARK_OUT(z);
+}
+
+static booleantype cuda_invtest(N_Vector x, N_Vector z)
+{
+    booleantype r;
+
+    SYNC_IN(x);
+    r = N_VInvTest_Cuda(x, z);
+    MARK_OUT(z);
+    return r;
+}
+
+static booleantype cuda_constrmask(N_Vector c, N_Vector x, N_Vector m)
+{
+    booleantype r;
+
+    SYNC_IN(c); SYNC_IN(x);
+    r = N_VConstrMask_Cuda(c, x, m);
+    MARK_OUT(m);
+    return r;
+}
+
+static realtype cuda_minquotient(N_Vector num, N_Vector denom)
+{
+    SYNC_IN(num); SYNC_IN(denom);
+    return N_VMinQuotient_Cuda(num, denom);
+}
+
+/* fused vector operations */
+
+static int cuda_linearcombination(int nvec, realtype *c, N_Vector *xs,
+				  N_Vector z)
+{
+    int r;
+
+    sync_in_array(nvec, xs);
+    r = N_VLinearCombination_Cuda(nvec, c, xs, z);
+    MARK_OUT(z);
+    return r;
+}
+
+static int cuda_scaleaddmulti(int nvec, realtype *a, N_Vector x,
+			      N_Vector *ys, N_Vector *zs)
+{
+    int r;
+
+    SYNC_IN(x);
+    sync_in_array(nvec, ys);
+    r = N_VScaleAddMulti_Cuda(nvec, a, x, ys, zs);
+    mark_out_array(nvec, zs);
+    return r;
+}
+
+static int cuda_dotprodmulti(int nvec, N_Vector x, N_Vector *ys,
+			     realtype *dotprods)
+{
+    SYNC_IN(x);
+    sync_in_array(nvec, ys);
+    return N_VDotProdMulti_Cuda(nvec, x, ys, dotprods);
+}
+
+/* vector array operations */
+
+static int cuda_linearsumvectorarray(int nvec, realtype a, N_Vector *xs,
+				     realtype b, N_Vector *ys, N_Vector *zs)
+{
+    int r;
+
+    sync_in_array(nvec, xs);
+    sync_in_array(nvec, ys);
+    r = N_VLinearSumVectorArray_Cuda(nvec, a, xs, b, ys, zs);
+    mark_out_array(nvec, zs);
+    return r;
+}
+
+static int cuda_scalevectorarray(int nvec, realtype *c, N_Vector *xs,
+				 N_Vector *zs)
+{
+    int r;
+
+    sync_in_array(nvec, xs);
+    r = N_VScaleVectorArray_Cuda(nvec, c, xs, zs);
+    mark_out_array(nvec, zs);
+    return r;
+}
+
+static int cuda_constvectorarray(int nvec, realtype c, N_Vector *zs)
+{
+    int r;
+
+    r = N_VConstVectorArray_Cuda(nvec, c, zs);
+    mark_out_array(nvec, zs);
+    return r;
+}
+
+static int cuda_wrmsnormvectorarray(int nvec, N_Vector *xs, N_Vector *ws,
+				    realtype *nrm)
+{
+    sync_in_array(nvec, xs);
+    sync_in_array(nvec, ws);
+    return N_VWrmsNormVectorArray_Cuda(nvec, xs, ws, nrm);
+}
+
+static int cuda_wrmsnormmaskvectorarray(int nvec, N_Vector *xs, N_Vector *ws,
+					N_Vector id, realtype *nrm)
+{
+    sync_in_array(nvec, xs);
+    sync_in_array(nvec, ws);
+    SYNC_IN(id);
+    return N_VWrmsNormMaskVectorArray_Cuda(nvec, xs, ws, id, nrm);
+}
+
+static int cuda_scaleaddmultivectorarray(int nvec, int nsum, realtype *a,
+					 N_Vector *xs, N_Vector **yss,
+					 N_Vector **zss)
+{
+    int j, r;
+
+    sync_in_array(nvec, xs);
+    for (j = 0; j < nsum; ++j) sync_in_array(nvec, yss[j]);
+    r = N_VScaleAddMultiVectorArray_Cuda(nvec, nsum, a, xs, yss, zss);
+    for (j = 0; j < nsum; ++j) mark_out_array(nvec, zss[j]);
+    return r;
+}
+
+static int cuda_linearcombinationvectorarray(int nvec, int nsum, realtype *c,
+					     N_Vector **xss, N_Vector *zs)
+{
+    int j, r;
+
+    for (j = 0; j < nsum; ++j) sync_in_array(nvec, xss[j]);
+    r = N_VLinearCombinationVectorArray_Cuda(nvec, nsum, c, xss, zs);
+    mark_out_array(nvec, zs);
+    return r;
+}
+
+/** Creation and destruction */
+
+static N_Vector clone_cuda(N_Vector w);
+
+static void free_cuda_cnvec(N_Vector nv)
+{
+    struct cuda_cnvec *c = CUDA_CNVEC(nv);
+
+    PAYLOAD_NVEC(NVEC_BACKLINK(nv)) = NULL;
+    sunml_nvec_remove_root(&NVEC_BACKLINK(nv));
+
+    /* The content belongs to the Sundials vector. */
+    nv->content = NULL;
+    N_VDestroy_Cuda(c->cuda);
+    if (c->data != NULL) cudaFree(c->data);
+
+    free(nv->ops);
+    free(c);
+}
+
+static void finalize_caml_cuda(value vnv)
+{
+    free_cuda_cnvec(NVEC_CVAL(vnv));
+}
+
+static void set_cuda_ops(N_Vector nv)
+{
+    N_Vector_Ops ops = (N_Vector_Ops) nv->ops;
+
+    ops->nvclone           = clone_cuda;
+    ops->nvcloneempty      = NULL;
+    ops->nvdestroy         = free_cuda_cnvec;
+    ops->nvgetvectorid	   = N_VGetVectorID_Cuda;
+    ops->nvspace           = N_VSpace_Cuda;
+
+    /* The elements are only accessed through the lazy synchronization. */
+    ops->nvgetarraypointer = NULL;
+    ops->nvsetarraypointer = NULL;
+
+    ops->nvlinearsum       = cuda_linearsum;
+    ops->nvconst           = cuda_const;
+    ops->nvprod            = cuda_prod;
+    ops->nvdiv             = cuda_div;
+    ops->nvscale           = cuda_scale;
+    ops->nvabs             = cuda_abs;
+    ops->nvinv             = cuda_inv;
+    ops->nvaddconst        = cuda_addconst;
+    ops->nvdotprod         = cuda_dotprod;
+    ops->nvmaxnorm         = cuda_maxnorm;
+    ops->nvwrmsnormmask    = cuda_wrmsnormmask;
+    ops->nvwrmsnorm        = cuda_wrmsnorm;
+    ops->nvmin             = cuda_min;
+    ops->nvwl2norm         = cuda_wl2norm;
+    ops->nvl1norm          = cuda_l1norm;
+    ops->nvcompare         = cuda_compare;
+    ops->nvinvtest         = cuda_invtest;
+    ops->nvconstrmask      = cuda_constrmask;
+    ops->nvminquotient     = cuda_minquotient;
+
+    /* fused vector operations (optional, NULL means disabled by default) */
+    ops->nvlinearcombination = NULL;
+    ops->nvscaleaddmulti     = NULL;
+    ops->nvdotprodmulti      = NULL;
+
+    /* vector array operations (optional, NULL means disabled by default) */
+    ops->nvlinearsumvectorarray         = NULL;
+    ops->nvscalevectorarray             = NULL;
+    ops->nvconstvectorarray             = NULL;
+    ops->nvwrmsnormvectorarray          = NULL;
+    ops->nvwrmsnormmaskvectorarray      = NULL;
+    ops->nvscaleaddmultivectorarray     = NULL;
+    ops->nvlinearcombinationvectorarray = NULL;
+}
+
+/* Create a c-nvec of length n, without setting its operations.  The host
+   copy of an unmanaged vector is vhost if it is not Val_unit.  Returns NULL
+   if memory could not be allocated.  */
+static N_Vector new_cuda(sundials_ml_index n, int managed, value vhost)
+{
+    CAMLparam1(vhost);
+    CAMLlocal2(vcptr, vpayload);
+    struct cuda_cnvec *c;
+    N_Vector nv, cuda;
+    realtype *data = NULL;
+    size_t size = n * sizeof(realtype);
+
+    vcptr = caml_alloc_small(1, Abstract_tag);
+    *(N_Vector *)&Field(vcptr, 0) = NULL;
+
+    if (managed) {
+	if (cudaMallocManaged((void **)&data, size, cudaMemAttachGlobal)
+		!= cudaSuccess)
+	    CAMLreturnT(N_Vector, NULL);
+	vhost = caml_ba_alloc_dims(BIGARRAY_FLOAT, 1, data, n);
+	cuda = N_VMakeManaged_Cuda(n, data);
+    } else {
+	if (vhost == Val_unit)
+	    vhost = caml_ba_alloc_dims(BIGARRAY_FLOAT, 1, NULL, n);
+	if (cudaMalloc((void **)&data, size) != cudaSuccess)
+	    CAMLreturnT(N_Vector, NULL);
+	cuda = N_VMake_Cuda(n, REAL_ARRAY(vhost), data);
+    }
+    if (cuda == NULL) {
+	cudaFree(data);
+	CAMLreturnT(N_Vector, NULL);
+    }
+
+    vpayload = caml_alloc_tuple(2);
+    Store_field(vpayload, 0, vhost);
+    Store_field(vpayload, 1, vcptr);
+
+    c = (struct cuda_cnvec *)malloc(sizeof(struct cuda_cnvec));
+    if (c == NULL) goto error;
+    nv = (N_Vector)c;
+    nv->ops = (N_Vector_Ops) malloc(sizeof(struct _generic_N_Vector_Ops));
+    if (nv->ops == NULL) { free(c); goto error; }
+
+    nv->content = cuda->content;
+    c->cuda     = cuda;
+    c->data     = data;
+    c->managed  = managed;
+    c->state    = CUDA_SYNCED;
+
+    NVEC_BACKLINK(nv) = vpayload;
+    sunml_nvec_register_root(&NVEC_BACKLINK(nv));
+    PAYLOAD_NVEC(vpayload) = nv;
+
+    CAMLreturnT(N_Vector, nv);
+
+error:
+    N_VDestroy_Cuda(cuda);
+    cudaFree(data);
+    CAMLreturnT(N_Vector, NULL);
+}
+
+static N_Vector clone_cuda(N_Vector w)
+{
+    N_Vector v;
+
+    if (w == NULL) return NULL;
+    v = new_cuda(N_VGetLength_Cuda(w), CUDA_CNVEC(w)->managed, Val_unit);
+    if (v == NULL) return NULL;
+
+    sunml_clone_cnvec_ops(v, w);
+    return v;
+}
+
+static value wrap_cuda(N_Vector nv, value checkfn)
+{
+    CAMLparam1(checkfn);
+    CAMLlocal1(vnvec);
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, NVEC_BACKLINK(nv));
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, finalize_caml_cuda));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+CAMLprim value sunml_nvec_make_cuda(value vmanaged, value vn, value viv,
+				    value checkfn)
+{
+    CAMLparam4(vmanaged, vn, viv, checkfn);
+    N_Vector nv;
+
+    nv = new_cuda(Long_val(vn), Bool_val(vmanaged), Val_unit);
+    if (nv == NULL) caml_raise_out_of_memory();
+    set_cuda_ops(nv);
+    cuda_const(Double_val(viv), nv);
+
+    CAMLreturn(wrap_cuda(nv, checkfn));
+}
+
+CAMLprim value sunml_nvec_wrap_cuda(value vhost, value checkfn)
+{
+    CAMLparam2(vhost, checkfn);
+    N_Vector nv;
+
+    nv = new_cuda(ARRAY1_LEN(vhost), 0, vhost);
+    if (nv == NULL) caml_raise_out_of_memory();
+    set_cuda_ops(nv);
+    CUDA_CNVEC(nv)->state = CUDA_HOST_NEWER;
+
+    CAMLreturn(wrap_cuda(nv, checkfn));
+}
+
+CAMLprim value sunml_nvec_cuda_host(value vread, value vwrite, value vdata)
+{
+    CAMLparam3(vread, vwrite, vdata);
+    N_Vector nv = PAYLOAD_NVEC(vdata);
+
+    if (nv == NULL) caml_invalid_argument("Nvector_cuda.host");
+    sunml_nvec_cuda_host_data(nv, Bool_val(vread), Bool_val(vwrite));
+
+    CAMLreturn(PAYLOAD_HOST(vdata));
+}
+
+CAMLprim value sunml_nvec_cuda_is_managed(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(Val_bool(CUDA_CNVEC(NVEC_VAL(vx))->managed));
+}
+
+/** Selectively activate fused and array operations for CUDA nvectors */
+
+/* N_VEnable*_Cuda would install the unsynchronized operations.  */
+#define ENABLE_OP(name)							\
+CAMLprim value sunml_nvec_cuda_enable##name(value vx, value vv)		\
+{									\
+    CAMLparam2(vx, vv);							\
+    ((N_Vector_Ops)NVEC_VAL(vx)->ops)->nv##name				\
+	= Bool_val(vv) ? cuda_##name : NULL;				\
+    CAMLreturn (Val_unit);						\
+}
+
+ENABLE_OP(linearcombination)
+ENABLE_OP(scaleaddmulti)
+ENABLE_OP(dotprodmulti)
+ENABLE_OP(linearsumvectorarray)
+ENABLE_OP(scalevectorarray)
+ENABLE_OP(constvectorarray)
+ENABLE_OP(wrmsnormvectorarray)
+ENABLE_OP(wrmsnormmaskvectorarray)
+ENABLE_OP(scaleaddmultivectorarray)
+ENABLE_OP(linearcombinationvectorarray)
+
+CAMLprim value sunml_nvec_cuda_enablefusedops(value vx, value vv)
+{
+    CAMLparam2(vx, vv);
+    sunml_nvec_cuda_enablelinearcombination(vx, vv);
+    sunml_nvec_cuda_enablescaleaddmulti(vx, vv);
+    sunml_nvec_cuda_enabledotprodmulti(vx, vv);
+    sunml_nvec_cuda_enablelinearsumvectorarray(vx, vv);
+    sunml_nvec_cuda_enablescalevectorarray(vx, vv);
+    sunml_nvec_cuda_enableconstvectorarray(vx, vv);
+    sunml_nvec_cuda_enablewrmsnormvectorarray(vx, vv);
+    sunml_nvec_cuda_enablewrmsnormmaskvectorarray(vx, vv);
+    sunml_nvec_cuda_enablescaleaddmultivectorarray(vx, vv);
+    sunml_nvec_cuda_enablelinearcombinationvectorarray(vx, vv);
+    CAMLreturn (Val_unit);
+}
+
+/** Operations from OCaml */
+
+#define LENGTH(v) (N_VGetLength_Cuda(v))
+
+CAMLprim value sunml_nvec_cuda_n_vclone(value vx)
+{
+    CAMLparam1(vx);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector z;
+
+    z = new_cuda(LENGTH(x), CUDA_CNVEC(x)->managed, Val_unit);
+    if (z == NULL) caml_raise_out_of_memory();
+    sunml_clone_cnvec_ops(z, x);
+    cuda_scale(1.0, x, z);
+
+    CAMLreturn(wrap_cuda(z, Field(vx, 2)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vlinearsum(value va, value vx, value vb,
+					    value vy, value vz)
+{
+    CAMLparam5(va, vx, vb, vy, vz);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector y = NVEC_VAL(vy);
+    N_Vector z = NVEC_VAL(vz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(y) != LENGTH(x) || LENGTH(z) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vlinearsum");
+#endif
+
+    cuda_linearsum(Double_val(va), x, Double_val(vb), y, z);
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vconst(value vc, value vz)
+{
+    CAMLparam2(vc, vz);
+    cuda_const(Double_val(vc), NVEC_VAL(vz));
+    CAMLreturn (Val_unit);
+}
+
+#define BINARY_OP(name)							\
+CAMLprim value sunml_nvec_cuda_n_v##name(value vx, value vy, value vz)	\
+{									\
+    CAMLparam3(vx, vy, vz);						\
+    N_Vector x = NVEC_VAL(vx);						\
+    N_Vector y = NVEC_VAL(vy);						\
+    N_Vector z = NVEC_VAL(vz);						\
+									\
+    if (SUNDIALS_ML_SAFE && (LENGTH(y) != LENGTH(x)			\
+			     || LENGTH(z) != LENGTH(x)))		\
+	caml_invalid_argument("Nvector_cuda.n_v" #name);		\
+									\
+    cuda_##name(x, y, z);						\
+    CAMLreturn (Val_unit);						\
+}
+
+BINARY_OP(prod)
+BINARY_OP(div)
+
+#define UNARY_OP(name)							\
+CAMLprim value sunml_nvec_cuda_n_v##name(value vx, value vz)		\
+{									\
+    CAMLparam2(vx, vz);							\
+    N_Vector x = NVEC_VAL(vx);						\
+    N_Vector z = NVEC_VAL(vz);						\
+									\
+    if (SUNDIALS_ML_SAFE && LENGTH(z) != LENGTH(x))			\
+	caml_invalid_argument("Nvector_cuda.n_v" #name);		\
+									\
+    cuda_##name(x, z);							\
+    CAMLreturn (Val_unit);						\
+}
+
+UNARY_OP(abs)
+UNARY_OP(inv)
+
+CAMLprim value sunml_nvec_cuda_n_vscale(value vc, value vx, value vz)
+{
+    CAMLparam3(vc, vx, vz);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector z = NVEC_VAL(vz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(z) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vscale");
+#endif
+
+    cuda_scale(Double_val(vc), x, z);
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vaddconst(value vx, value vb, value vz)
+{
+    CAMLparam3(vx, vb, vz);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector z = NVEC_VAL(vz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(z) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vaddconst");
+#endif
+
+    cuda_addconst(x, Double_val(vb), z);
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vdotprod(value vx, value vy)
+{
+    CAMLparam2(vx, vy);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector y = NVEC_VAL(vy);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(y) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vdotprod");
+#endif
+
+    CAMLreturn(caml_copy_double(cuda_dotprod(x, y)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vmaxnorm(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(cuda_maxnorm(NVEC_VAL(vx))));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vwrmsnorm(value vx, value vw)
+{
+    CAMLparam2(vx, vw);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector w = NVEC_VAL(vw);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(w) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vwrmsnorm");
+#endif
+
+    CAMLreturn(caml_copy_double(cuda_wrmsnorm(x, w)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vwrmsnormmask(value vx, value vw, value vid)
+{
+    CAMLparam3(vx, vw, vid);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector w = NVEC_VAL(vw);
+    N_Vector id = NVEC_VAL(vid);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(w) != LENGTH(x) || LENGTH(id) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vwrmsnormmask");
+#endif
+
+    CAMLreturn(caml_copy_double(cuda_wrmsnormmask(x, w, id)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vmin(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(cuda_min(NVEC_VAL(vx))));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vwl2norm(value vx, value vw)
+{
+    CAMLparam2(vx, vw);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector w = NVEC_VAL(vw);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(w) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vwl2norm");
+#endif
+
+    CAMLreturn(caml_copy_double(cuda_wl2norm(x, w)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vl1norm(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(cuda_l1norm(NVEC_VAL(vx))));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vcompare(value vc, value vx, value vz)
+{
+    CAMLparam3(vc, vx, vz);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector z = NVEC_VAL(vz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(z) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vcompare");
+#endif
+
+    cuda_compare(Double_val(vc), x, z);
+    CAMLreturn (Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vinvtest(value vx, value vz)
+{
+    CAMLparam2(vx, vz);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector z = NVEC_VAL(vz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(z) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vinvtest");
+#endif
+
+    CAMLreturn(Val_bool(cuda_invtest(x, z)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vconstrmask(value vc, value vx, value vm)
+{
+    CAMLparam3(vc, vx, vm);
+    N_Vector c = NVEC_VAL(vc);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector m = NVEC_VAL(vm);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(x) != LENGTH(c) || LENGTH(m) != LENGTH(c))
+	caml_invalid_argument("Nvector_cuda.n_vconstrmask");
+#endif
+
+    CAMLreturn(Val_bool(cuda_constrmask(c, x, m)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vminquotient(value vnum, value vdenom)
+{
+    CAMLparam2(vnum, vdenom);
+    N_Vector num = NVEC_VAL(vnum);
+    N_Vector denom = NVEC_VAL(vdenom);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (LENGTH(denom) != LENGTH(num))
+	caml_invalid_argument("Nvector_cuda.n_vminquotient");
+#endif
+
+    CAMLreturn(caml_copy_double(cuda_minquotient(num, denom)));
+}
+
+CAMLprim value sunml_nvec_cuda_n_vspace(value vx)
+{
+    CAMLparam1(vx);
+    CAMLlocal1(r);
+    sundials_ml_index lrw, liw;
+
+    N_VSpace_Cuda(NVEC_VAL(vx), &lrw, &liw);
+
+    r = caml_alloc_tuple(2);
+    Store_field(r, 0, Val_index(lrw));
+    Store_field(r, 1, Val_index(liw));
+
+    CAMLreturn(r);
+}
+
+/* fused vector operations */
+
+CAMLprim value sunml_nvec_cuda_n_vlinearcombination(value vac, value vax,
+						    value vz)
+{
+    CAMLparam3(vac, vax, vz);
+    realtype *ac = REAL_ARRAY(vac);
+    N_Vector z = NVEC_VAL(vz);
+    N_Vector *ax;
+    int nvec = sunml_arrays_of_nvectors(&ax, 1, vax);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(vac) < nvec || LENGTH(ax[0]) != LENGTH(z))
+	caml_invalid_argument("Nvector_cuda.n_vlinearcombination");
+#endif
+
+    cuda_linearcombination(nvec, ac, ax, z);
+    free(ax);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vscaleaddmulti(value vac, value vx,
+						value vay, value vaz)
+{
+    CAMLparam4(vac, vx, vay, vaz);
+    realtype *ac = REAL_ARRAY(vac);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector *a[2];
+    int nvec = sunml_arrays_of_nvectors(a, 2, vay, vaz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(vac) < nvec || LENGTH(a[0][0]) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vscaleaddmulti");
+#endif
+
+    cuda_scaleaddmulti(nvec, ac, x, a[0], a[1]);
+    free(*a);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vdotprodmulti(value vx, value vay, value vad)
+{
+    CAMLparam3(vx, vay, vad);
+    realtype *ad = REAL_ARRAY(vad);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector *ay;
+    int nvec = sunml_arrays_of_nvectors(&ay, 1, vay);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(vad) < nvec || LENGTH(ay[0]) != LENGTH(x))
+	caml_invalid_argument("Nvector_cuda.n_vdotprodmulti");
+#endif
+
+    cuda_dotprodmulti(nvec, x, ay, ad);
+    free(ay);
+    CAMLreturn(Val_unit);
+}
+
+/* vector array operations */
+
+CAMLprim value sunml_nvec_cuda_n_vlinearsumvectorarray(value va, value vax,
+						       value vb, value vay,
+						       value vaz)
+{
+    CAMLparam5(va, vax, vb, vay, vaz);
+    N_Vector *a[3];
+    int nvec = sunml_arrays_of_nvectors(a, 3, vax, vay, vaz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec) caml_invalid_argument("Nvector_cuda.n_vlinearsumvectorarray");
+#endif
+
+    cuda_linearsumvectorarray(nvec, Double_val(va), a[0],
+			      Double_val(vb), a[1], a[2]);
+    free(*a);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vscalevectorarray(value vac, value vax,
+						   value vaz)
+{
+    CAMLparam3(vac, vax, vaz);
+    realtype *ac = REAL_ARRAY(vac);
+    N_Vector *a[2];
+    int nvec = sunml_arrays_of_nvectors(a, 2, vax, vaz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(vac) < nvec)
+	caml_invalid_argument("Nvector_cuda.n_vscalevectorarray");
+#endif
+
+    cuda_scalevectorarray(nvec, ac, a[0], a[1]);
+    free(*a);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vconstvectorarray(value vc, value vaz)
+{
+    CAMLparam2(vc, vaz);
+    N_Vector *az;
+    int nvec = sunml_arrays_of_nvectors(&az, 1, vaz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec) caml_invalid_argument("Nvector_cuda.n_vconstvectorarray");
+#endif
+
+    cuda_constvectorarray(nvec, Double_val(vc), az);
+    free(az);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vwrmsnormvectorarray(value vax, value vaw,
+						      value van)
+{
+    CAMLparam3(vax, vaw, van);
+    realtype *an = REAL_ARRAY(van);
+    N_Vector *a[2];
+    int nvec = sunml_arrays_of_nvectors(a, 2, vax, vaw);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(van) < nvec)
+	caml_invalid_argument("Nvector_cuda.n_vwrmsnormvectorarray");
+#endif
+
+    cuda_wrmsnormvectorarray(nvec, a[0], a[1], an);
+    free(*a);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vwrmsnormmaskvectorarray(value vax,
+				    value vaw, value vi, value van)
+{
+    CAMLparam4(vax, vaw, vi, van);
+    realtype *an = REAL_ARRAY(van);
+    N_Vector i = NVEC_VAL(vi);
+    N_Vector *a[2];
+    int nvec = sunml_arrays_of_nvectors(a, 2, vax, vaw);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || ARRAY1_LEN(van) < nvec || LENGTH(a[0][0]) != LENGTH(i))
+	caml_invalid_argument("Nvector_cuda.n_vwrmsnormmaskvectorarray");
+#endif
+
+    cuda_wrmsnormmaskvectorarray(nvec, a[0], a[1], i, an);
+    free(*a);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vscaleaddmultivectorarray(value vaa,
+				    value vax, value vaay, value vaaz)
+{
+    CAMLparam4(vaa, vax, vaay, vaaz);
+    realtype *aa = REAL_ARRAY(vaa);
+    N_Vector *ax = NULL;
+    int nvec = sunml_arrays_of_nvectors(&ax, 1, vax);
+    N_Vector **ayz[2] = { NULL };
+    int nvec2, nsum;
+    sunml_arrays_of_nvectors2(&nsum, &nvec2, ayz, 2, vaay, vaaz);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvec || !nsum || nvec2 != nvec || ARRAY1_LEN(vaa) < nsum) {
+	if (ax != NULL) free(ax);
+	if (*ayz != NULL) free(*ayz);
+	caml_invalid_argument("Nvector_cuda.n_vscaleaddmultivectorarray");
+    }
+#endif
+
+    cuda_scaleaddmultivectorarray(nvec, nsum, aa, ax, ayz[0], ayz[1]);
+    free(ax);
+    free(*ayz);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_cuda_n_vlinearcombinationvectorarray(value vac,
+							value vaax, value vaz)
+{
+    CAMLparam3(vac, vaax, vaz);
+    realtype *ac = REAL_ARRAY(vac);
+    N_Vector *az;
+    int nvecz __attribute__((unused))
+	= sunml_arrays_of_nvectors(&az, 1, vaz);
+    N_Vector **aax;
+    int nvec, nsum;
+    sunml_arrays_of_nvectors2(&nsum, &nvec, &aax, 1, vaax);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (!nvecz || !nsum || nvec > nvecz || ARRAY1_LEN(vac) < nsum) {
+	if (az != NULL) free(az);
+	if (aax != NULL) free(aax);
+	caml_invalid_argument("Nvector_cuda.n_vlinearcombinationvectorarray");
+    }
+#endif
+
+    cuda_linearcombinationvectorarray(nvec, nsum, ac, aax, az);
+    free(az);
+    free(aax);
+    CAMLreturn(Val_unit);
+}
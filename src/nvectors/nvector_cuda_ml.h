@@ -0,0 +1,59 @@
+/***********************************************************************
+ *                                                                     *
+ *                   OCaml interface to Sundials                       *
+ *                                                                     *
+ *             Timothy Bourke, Jun Inoue, and Marc Pouzet              *
+ *             (Inria/ENS)     (Inria/ENS)    (UPMC/ENS/Inria)         *
+ *                                                                     *
+ *  Copyright 2020 Institut National de Recherche en Informatique et   *
+ *  en Automatique.  All rights reserved.  This file is distributed    *
+ *  under a New BSD License, refer to the file LICENSE.                *
+ *                                                                     *
+ ***********************************************************************/
+
+#ifndef __NVECTOR_CUDA_ML_H__
+#define __NVECTOR_CUDA_ML_H__
+
+#include <sundials/sundials_nvector.h>
+#include <caml/mlvalues.h>
+
+/* OCaml interface to CUDA NVectors.
+
+   See the comments in nvector_ml.h for the interfacing principles common to
+   all NVectors.
+
+   CUDA nvectors
+   -------------
+   The payload is a pair (an Nvector_cuda.data record) of a Bigarray over
+   the host copy of the elements and of an abstract block containing a
+   pointer back to the c-nvec.  The pointer is cleared when the c-nvec is
+   freed, so that a payload that outlives its nvector can be detected.
+
+   The c-nvec is a struct cnvec extended with the Sundials CUDA vector that
+   owns the content.  The N_Vector content field points to the same content
+   (a C++ object), so that the N_V*_Cuda functions apply directly to the
+   c-nvec.  The device memory, and the unified memory of managed vectors,
+   is allocated and freed by this interface.
+
+   The host and device copies are synchronized lazily.  The c-nvec records
+   which copy, if any, is more recent.  The N_Vector ops are wrappers over
+   the standard CUDA N_Vector operations that first copy their inputs to
+   the device if they were modified on the host, and then mark their
+   outputs as modified on the device.  The host copy is brought up to date
+   when it is requested through Nvector_cuda.host.
+
+   Native callbacks (see Sundials.cfun) must obtain the data of their
+   N_Vector arguments through sunml_nvec_cuda_device_data (or
+   sunml_nvec_cuda_host_data) rather than through N_VGetDeviceArrayPointer_Cuda,
+   indicating whether they read and/or write it.
+*/
+
+/* Return a device pointer to the elements of v, copied there first if read
+   is true and they were modified on the host.  The elements are then
+   marked as modified on the device if write is true.  */
+realtype *sunml_nvec_cuda_device_data(N_Vector v, int read, int write);
+
+/* Similarly, but for the host copy.  */
+realtype *sunml_nvec_cuda_host_data(N_Vector v, int read, int write);
+
+#endif
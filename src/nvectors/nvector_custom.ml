@@ -137,6 +137,120 @@ let make_wrap ops ?(with_fused_ops=false) v =
     then raise OperationNotSupported;
   nv
 
+type segment = {
+    data   : Sundials.RealArray.t;
+    offset : int;
+    length : int;
+    stride : int;
+  }
+
+type 'a override =
+  | LinearSum    of (float -> 'a -> float -> 'a -> 'a -> unit)
+  | Const        of (float -> 'a -> unit)
+  | Prod         of ('a -> 'a -> 'a -> unit)
+  | Div          of ('a -> 'a -> 'a -> unit)
+  | Scale        of (float -> 'a -> 'a -> unit)
+  | Abs          of ('a -> 'a -> unit)
+  | Inv          of ('a -> 'a -> unit)
+  | AddConst     of ('a -> float -> 'a -> unit)
+  | MaxNorm      of ('a -> float)
+  | WrmsNorm     of ('a -> 'a -> float)
+  | Min          of ('a -> float)
+  | DotProd      of ('a -> 'a -> float)
+  | Compare      of (float -> 'a -> 'a -> unit)
+  | InvTest      of ('a -> 'a -> bool)
+  | Wl2Norm      of ('a -> 'a -> float)
+  | L1Norm       of ('a -> float)
+  | WrmsNormMask of ('a -> 'a -> 'a -> float)
+  | ConstrMask   of ('a -> 'a -> 'a -> bool)
+  | MinQuotient  of ('a -> 'a -> float)
+
+external c_make_layout_wrap
+  : (('a -> 'a) * ('a -> segment array) * 'a nvector_ops)
+    -> int -> 'a -> segment array -> ('a -> bool) -> 'a t
+  = "sunml_nvec_wrap_custom_layout"
+
+let check_segments segs =
+  let check { data; offset; length; stride } =
+    if offset < 0 || length < 0 || stride < 1
+       || (length > 0
+           && offset + (length - 1) * stride >= Sundials.RealArray.length data)
+    then invalid_arg "Nvector_custom.make_layout_wrap: invalid segment"
+  in
+  Array.iter check segs;
+  segs
+
+let layout_length segs =
+  Array.fold_left (fun n s -> n + s.length) 0 segs
+
+(* Each override sets the corresponding field and the bit at the position
+   of that field in nvector_ops (see enum nvector_ops_tag). *)
+let add_override (ops, mask) ov =
+  match ov with
+  | LinearSum f    -> { ops with n_vlinearsum = f },         mask lor (1 lsl 3)
+  | Const f        -> { ops with n_vconst = f },             mask lor (1 lsl 4)
+  | Prod f         -> { ops with n_vprod = f },              mask lor (1 lsl 5)
+  | Div f          -> { ops with n_vdiv = f },               mask lor (1 lsl 6)
+  | Scale f        -> { ops with n_vscale = f },             mask lor (1 lsl 7)
+  | Abs f          -> { ops with n_vabs = f },               mask lor (1 lsl 8)
+  | Inv f          -> { ops with n_vinv = f },               mask lor (1 lsl 9)
+  | AddConst f     -> { ops with n_vaddconst = f },          mask lor (1 lsl 10)
+  | MaxNorm f      -> { ops with n_vmaxnorm = f },           mask lor (1 lsl 11)
+  | WrmsNorm f     -> { ops with n_vwrmsnorm = f },          mask lor (1 lsl 12)
+  | Min f          -> { ops with n_vmin = f },               mask lor (1 lsl 13)
+  | DotProd f      -> { ops with n_vdotprod = f },           mask lor (1 lsl 14)
+  | Compare f      -> { ops with n_vcompare = f },           mask lor (1 lsl 15)
+  | InvTest f      -> { ops with n_vinvtest = f },           mask lor (1 lsl 16)
+  | Wl2Norm f      -> { ops with n_vwl2norm = Some f },      mask lor (1 lsl 17)
+  | L1Norm f       -> { ops with n_vl1norm = Some f },       mask lor (1 lsl 18)
+  | WrmsNormMask f -> { ops with n_vwrmsnormmask = Some f }, mask lor (1 lsl 19)
+  | ConstrMask f   -> { ops with n_vconstrmask = Some f },   mask lor (1 lsl 20)
+  | MinQuotient f  -> { ops with n_vminquotient = Some f },  mask lor (1 lsl 21)
+
+let make_layout_wrap ~layout ~clone ?(overrides=[]) v =
+  let unused _ = assert false in
+  let checked_layout v = check_segments (layout v) in
+  let n_vcheck x y = layout_length (checked_layout x)
+                     = layout_length (checked_layout y) in
+  let base = {
+      n_vcheck;
+      n_vclone           = clone;
+      n_vspace           = None;
+      n_vlinearsum       = unused;
+      n_vconst           = unused;
+      n_vprod            = unused;
+      n_vdiv             = unused;
+      n_vscale           = unused;
+      n_vabs             = unused;
+      n_vinv             = unused;
+      n_vaddconst        = unused;
+      n_vmaxnorm         = unused;
+      n_vwrmsnorm        = unused;
+      n_vmin             = unused;
+      n_vdotprod         = unused;
+      n_vcompare         = unused;
+      n_vinvtest         = unused;
+      n_vwl2norm         = None;
+      n_vl1norm          = None;
+      n_vwrmsnormmask    = None;
+      n_vconstrmask      = None;
+      n_vminquotient     = None;
+      n_vlinearcombination            = None;
+      n_vscaleaddmulti                = None;
+      n_vdotprodmulti                 = None;
+      n_vlinearsumvectorarray         = None;
+      n_vscalevectorarray             = None;
+      n_vconstvectorarray             = None;
+      n_vwrmsnormvectorarray          = None;
+      n_vwrmsnormmaskvectorarray      = None;
+      n_vscaleaddmultivectorarray     = None;
+      n_vlinearcombinationvectorarray = None;
+    }
+  in
+  let ops, mask = List.fold_left add_override (base, 0) overrides in
+  let segs = checked_layout v in
+  c_make_layout_wrap (clone, checked_layout, ops) mask v segs (n_vcheck v)
+
 let add_tracing msg ops =
   let pr s = print_string msg; print_endline s in
   let { (* {{{ *)
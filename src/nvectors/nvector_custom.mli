@@ -201,6 +201,66 @@ type 'd nvector_ops = { (* {{{ *)
     into ['d] nvectors which can be passed to a solver. *)
 val make_wrap  : 'd nvector_ops -> ?with_fused_ops:bool -> 'd -> 'd t
 
+(** {2:layout Custom nvectors over float arrays}
+
+    Custom nvectors whose elements are stored in one or more
+    {!Sundials.RealArray.t}s can describe that storage instead of
+    implementing every operation. The standard operations are then
+    executed by loops in C without calling back into OCaml. *)
+
+(** A strided slice of a float array: the elements
+    [data.{offset + i * stride}] for [i] from [0] to [length - 1]. *)
+type segment = {
+    data   : Sundials.RealArray.t;
+    offset : int;
+    length : int;
+    stride : int;
+  }
+
+(** An operation implemented in OCaml to replace the built-in loop.
+    The functions have the same meaning as the corresponding fields of
+    {!nvector_ops}. *)
+type 'd override =
+  | LinearSum    of (float -> 'd -> float -> 'd -> 'd -> unit)
+  | Const        of (float -> 'd -> unit)
+  | Prod         of ('d -> 'd -> 'd -> unit)
+  | Div          of ('d -> 'd -> 'd -> unit)
+  | Scale        of (float -> 'd -> 'd -> unit)
+  | Abs          of ('d -> 'd -> unit)
+  | Inv          of ('d -> 'd -> unit)
+  | AddConst     of ('d -> float -> 'd -> unit)
+  | MaxNorm      of ('d -> float)
+  | WrmsNorm     of ('d -> 'd -> float)
+  | Min          of ('d -> float)
+  | DotProd      of ('d -> 'd -> float)
+  | Compare      of (float -> 'd -> 'd -> unit)
+  | InvTest      of ('d -> 'd -> bool)
+  | Wl2Norm      of ('d -> 'd -> float)
+  | L1Norm       of ('d -> float)
+  | WrmsNormMask of ('d -> 'd -> 'd -> float)
+  | ConstrMask   of ('d -> 'd -> 'd -> bool)
+  | MinQuotient  of ('d -> 'd -> float)
+
+(** [make_layout_wrap ~layout ~clone v] lifts [v] into a custom nvector
+    whose elements are those of the segments returned by [layout v], taken
+    in order. The function [clone] creates new payloads; it is followed by
+    a call to [layout] on the result. Two vectors are compatible if they
+    have the same total number of elements. The functions given in
+    [overrides] are called instead of the corresponding built-in
+    operations. Fused and array operations are not provided.
+
+    The segments of a vector must not be modified while it is in use by
+    a solver, and the vectors involved in a single operation must not
+    overlap in memory, except when an argument is also the result.
+
+    @raise Invalid_argument A segment lies outside its array. *)
+val make_layout_wrap
+  :  layout:('d -> segment array)
+  -> clone:('d -> 'd)
+  -> ?overrides:'d override list
+  -> 'd
+  -> 'd t
+
 (** Add tracing to custom operations.
     [add_tracing p ops] modifies a set of {!nvector_ops} so that
     a message, prefixed by [p], is printed each time an operation
@@ -0,0 +1,121 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*  Timothy Bourke (Inria), Jun Inoue (Inria), and Marc Pouzet (LIENS) *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+open Sundials
+
+type dual = { re : float; du : float }
+
+type data = { value : RealArray.t; tangent : RealArray.t }
+
+let wrap value tangent =
+  if RealArray.length value <> RealArray.length tangent
+  then invalid_arg "Nvector_dual.wrap: lengths differ";
+  { value; tangent }
+
+module type ARITH = sig (* {{{ *)
+  type num
+  type vec
+  val length : vec -> int
+  val get : vec -> int -> num
+  val set : vec -> int -> num -> unit
+  val const : float -> num
+  val value : num -> float
+  val add : num -> num -> num
+  val sub : num -> num -> num
+  val mul : num -> num -> num
+  val div : num -> num -> num
+  val neg : num -> num
+  val scale : float -> num -> num
+  val powi : num -> int -> num
+  val abs  : num -> num
+  val sqrt : num -> num
+  val exp  : num -> num
+  val log  : num -> num
+  val sin  : num -> num
+  val cos  : num -> num
+  val tanh : num -> num
+end (* }}} *)
+
+module Real = struct (* {{{ *)
+  type num = float
+  type vec = RealArray.t
+
+  let length = RealArray.length
+  let get (v : vec) i = v.{i}
+  let set (v : vec) i x = v.{i} <- x
+  let const x = x
+  let value x = x
+  let add = ( +. )
+  let sub = ( -. )
+  let mul = ( *. )
+  let div = ( /. )
+  let neg x = -. x
+  let scale = ( *. )
+  let powi x n = x ** float_of_int n
+  let abs = abs_float
+  let sqrt = sqrt
+  let exp = exp
+  let log = log
+  let sin = sin
+  let cos = cos
+  let tanh = tanh
+end (* }}} *)
+
+module Dual = struct (* {{{ *)
+  type num = dual
+  type vec = data
+
+  let fsin = sin
+  let fcos = cos
+
+  let length v = RealArray.length v.value
+  let get v i = { re = v.value.{i}; du = v.tangent.{i} }
+  let set v i x =
+    v.value.{i} <- x.re;
+    v.tangent.{i} <- x.du
+  let const x = { re = x; du = 0.0 }
+  let value x = x.re
+
+  let add x y = { re = x.re +. y.re; du = x.du +. y.du }
+  let sub x y = { re = x.re -. y.re; du = x.du -. y.du }
+  let mul x y = { re = x.re *. y.re; du = x.du *. y.re +. x.re *. y.du }
+  let div x y =
+    let r = x.re /. y.re in
+    { re = r; du = (x.du -. r *. y.du) /. y.re }
+  let neg x = { re = -. x.re; du = -. x.du }
+  let scale c x = { re = c *. x.re; du = c *. x.du }
+
+  let powi x n =
+    if n = 0 then { re = 1.0; du = 0.0 }
+    else
+      let p = x.re ** float_of_int (n - 1) in
+      { re = p *. x.re; du = float_of_int n *. p *. x.du }
+
+  let abs x = if x.re < 0.0 then neg x else x
+
+  let sqrt x =
+    let r = sqrt x.re in
+    { re = r; du = x.du /. (2.0 *. r) }
+
+  let exp x =
+    let r = exp x.re in
+    { re = r; du = r *. x.du }
+
+  let log x = { re = log x.re; du = x.du /. x.re }
+  let sin x = { re = sin x.re; du = fcos x.re *. x.du }
+  let cos x = { re = fcos x.re; du = -. fsin x.re *. x.du }
+
+  let tanh x =
+    let r = tanh x.re in
+    { re = r; du = (1.0 -. r *. r) *. x.du }
+end (* }}} *)
+
@@ -0,0 +1,106 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*  Timothy Bourke (Inria), Jun Inoue (Inria), and Marc Pouzet (LIENS) *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+(** Dual-number vectors for exact Jacobian-vector products.
+
+    A dual-number vector pairs the values of a serial vector with a vector
+    of tangents. Evaluating a function on dual numbers computes its value
+    and, in the same pass, its directional derivative along the tangents
+    (forward-mode automatic differentiation). Given a right-hand side
+    function written against {!ARITH}, the [Spils.dual_jac_times_vec]
+    functions of the solvers thus compute exact Jacobian-vector products
+    with a single evaluation, rather than the difference quotients that
+    require an extra evaluation and lose accuracy.
+
+    A function is written once for both uses by abstracting over the
+    arithmetic with a first-class module, for instance:
+{[
+let f (type n v) (module A : Nvector_dual.ARITH
+                    with type num = n and type vec = v) t y yd =
+  let y0 = A.get y 0 and y1 = A.get y 1 in
+  A.set yd 0 (A.mul y0 y1);
+  A.set yd 1 (A.sub (A.const 1.0) (A.exp y0))
+
+let rhs = f (module Nvector_dual.Real)
+let jtv = Cvode.Spils.dual_jac_times_vec (f (module Nvector_dual.Dual))
+]}
+    The [rhs] function operates directly on {!Sundials.RealArray.t}s and is
+    passed to the solver as usual. *)
+
+open Sundials
+
+(** A dual number [re + du ε], where [ε² = 0]. *)
+type dual = { re : float; du : float }
+
+(** The data of a dual-number vector: the values and the tangents, which
+    have the same length. The arrays are not copied, so that the vectors of
+    a solver can be wrapped without allocating. *)
+type data = { value : RealArray.t; tangent : RealArray.t }
+
+(** [wrap value tangent] pairs two arrays.
+
+    @raise Invalid_argument The arrays do not have the same length. *)
+val wrap : RealArray.t -> RealArray.t -> data
+
+(** Arithmetic over the elements of vectors. *)
+module type ARITH = sig (* {{{ *)
+
+  (** Scalars. *)
+  type num
+
+  (** Vectors of scalars. *)
+  type vec
+
+  (** Returns the number of elements in a vector. *)
+  val length : vec -> int
+
+  (** [get v i] returns the [i]th element of [v]. *)
+  val get : vec -> int -> num
+
+  (** [set v i x] sets the [i]th element of [v] to [x]. *)
+  val set : vec -> int -> num -> unit
+
+  (** Returns a constant, i.e., a scalar with a zero derivative. *)
+  val const : float -> num
+
+  (** Returns the value of a scalar, without its derivative, typically to
+      choose between branches. *)
+  val value : num -> float
+
+  val add : num -> num -> num
+  val sub : num -> num -> num
+  val mul : num -> num -> num
+  val div : num -> num -> num
+  val neg : num -> num
+
+  (** [scale c x] multiplies [x] by the constant [c]. *)
+  val scale : float -> num -> num
+
+  (** [powi x n] raises [x] to the integer power [n]. *)
+  val powi : num -> int -> num
+
+  val abs  : num -> num
+  val sqrt : num -> num
+  val exp  : num -> num
+  val log  : num -> num
+  val sin  : num -> num
+  val cos  : num -> num
+  val tanh : num -> num
+
+end (* }}} *)
+
+(** Arithmetic on floats and serial data. *)
+module Real : ARITH with type num = float and type vec = RealArray.t
+
+(** Arithmetic on dual numbers and dual-number vectors. *)
+module Dual : ARITH with type num = dual and type vec = data
+
@@ -0,0 +1,167 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*  Timothy Bourke (Inria), Jun Inoue (Inria), and Marc Pouzet (LIENS) *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+
+type kind
+type partition = Partition : ('d, 'k) Nvector.t -> partition
+type data = partition array
+type t = (data, kind) Nvector.t
+
+external c_wrap : data -> (data -> bool) -> t
+  = "sunml_nvec_wrap_many"
+
+external c_check : data -> data -> bool
+  = "sunml_nvec_many_check"
+
+let wrap parts =
+  if Array.length parts = 0 then invalid_arg "Nvector_many.wrap";
+  c_wrap parts (c_check parts)
+
+let unwrap = Nvector.unwrap
+
+external local_array : partition -> Sundials.RealArray.t
+  = "sunml_nvec_many_local_array"
+
+module Ops = struct
+  type t = (data, kind) Nvector.t
+
+  external n_vclone        : t -> t
+    = "sunml_nvec_many_n_vclone"
+
+  external n_vlinearsum    : float -> t -> float -> t -> t -> unit
+    = "sunml_nvec_many_n_vlinearsum"
+
+  external n_vconst        : float -> t -> unit
+    = "sunml_nvec_many_n_vconst"
+
+  external n_vprod         : t -> t -> t -> unit
+    = "sunml_nvec_many_n_vprod"
+
+  external n_vdiv          : t -> t -> t -> unit
+    = "sunml_nvec_many_n_vdiv"
+
+  external n_vscale        : float -> t -> t -> unit
+    = "sunml_nvec_many_n_vscale"
+
+  external n_vabs          : t -> t -> unit
+    = "sunml_nvec_many_n_vabs"
+
+  external n_vinv          : t -> t -> unit
+    = "sunml_nvec_many_n_vinv"
+
+  external n_vaddconst     : t -> float -> t -> unit
+    = "sunml_nvec_many_n_vaddconst"
+
+  external n_vdotprod      : t -> t -> float
+    = "sunml_nvec_many_n_vdotprod"
+
+  external n_vmaxnorm      : t -> float
+    = "sunml_nvec_many_n_vmaxnorm"
+
+  external n_vwrmsnorm     : t -> t -> float
+    = "sunml_nvec_many_n_vwrmsnorm"
+
+  external n_vwrmsnormmask : t -> t -> t -> float
+    = "sunml_nvec_many_n_vwrmsnormmask"
+
+  external n_vmin          : t -> float
+    = "sunml_nvec_many_n_vmin"
+
+  external n_vwl2norm      : t -> t -> float
+    = "sunml_nvec_many_n_vwl2norm"
+
+  external n_vl1norm       : t -> float
+    = "sunml_nvec_many_n_vl1norm"
+
+  external n_vcompare      : float -> t -> t -> unit
+    = "sunml_nvec_many_n_vcompare"
+
+  external n_vinvtest      : t -> t -> bool
+    = "sunml_nvec_many_n_vinvtest"
+
+  external n_vconstrmask   : t -> t -> t -> bool
+    = "sunml_nvec_many_n_vconstrmask"
+
+  external n_vminquotient  : t -> t -> float
+    = "sunml_nvec_many_n_vminquotient"
+
+  external n_vspace        : t -> int * int
+    = "sunml_nvec_many_n_vspace"
+
+  (* Fused and array operations in terms of the standard ones.  *)
+
+  let aliased z xa =
+    let rec f i = i < Array.length xa && (xa.(i) == z || f (i + 1)) in
+    f 1
+
+  let n_vlinearcombination (ca : Sundials.RealArray.t) (xa : t array) (z : t) =
+    let nvec = Array.length xa in
+    if nvec > 0 then begin
+      let acc = if aliased z xa then n_vclone z else z in
+      n_vscale ca.{0} xa.(0) acc;
+      for i = 1 to nvec - 1 do
+        n_vlinearsum ca.{i} xa.(i) 1.0 acc acc
+      done;
+      if acc != z then n_vscale 1.0 acc z
+    end
+
+  let n_vscaleaddmulti (aa : Sundials.RealArray.t) (x : t)
+                       (ya : t array) (za : t array) =
+    for i = 0 to Array.length ya - 1 do
+      n_vlinearsum aa.{i} x 1.0 ya.(i) za.(i)
+    done
+
+  let n_vdotprodmulti (x : t) (ya : t array) (dp : Sundials.RealArray.t) =
+    for i = 0 to Array.length ya - 1 do
+      dp.{i} <- n_vdotprod x ya.(i)
+    done
+
+  let n_vlinearsumvectorarray a (xa : t array) b (ya : t array) (za : t array) =
+    for i = 0 to Array.length xa - 1 do
+      n_vlinearsum a xa.(i) b ya.(i) za.(i)
+    done
+
+  let n_vscalevectorarray (ca : Sundials.RealArray.t) (xa : t array)
+                          (za : t array) =
+    for i = 0 to Array.length xa - 1 do
+      n_vscale ca.{i} xa.(i) za.(i)
+    done
+
+  let n_vconstvectorarray c (za : t array) =
+    Array.iter (n_vconst c) za
+
+  let n_vwrmsnormvectorarray (xa : t array) (wa : t array)
+                             (nrm : Sundials.RealArray.t) =
+    for i = 0 to Array.length xa - 1 do
+      nrm.{i} <- n_vwrmsnorm xa.(i) wa.(i)
+    done
+
+  let n_vwrmsnormmaskvectorarray (xa : t array) (wa : t array) (id : t)
+                                 (nrm : Sundials.RealArray.t) =
+    for i = 0 to Array.length xa - 1 do
+      nrm.{i} <- n_vwrmsnormmask xa.(i) wa.(i) id
+    done
+
+  let n_vscaleaddmultivectorarray (ra : Sundials.RealArray.t) (xa : t array)
+                                  (yaa : t array array) (zaa : t array array) =
+    for i = 0 to Array.length xa - 1 do
+      for j = 0 to Array.length yaa - 1 do
+        n_vlinearsum ra.{j} xa.(i) 1.0 yaa.(j).(i) zaa.(j).(i)
+      done
+    done
+
+  let n_vlinearcombinationvectorarray (ca : Sundials.RealArray.t)
+                                      (xaa : t array array) (za : t array) =
+    for i = 0 to Array.length za - 1 do
+      n_vlinearcombination ca (Array.map (fun xa -> xa.(i)) xaa) za.(i)
+    done
+end
@@ -0,0 +1,69 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*  Timothy Bourke (Inria), Jun Inoue (Inria), and Marc Pouzet (LIENS) *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+
+(** Nvectors made of several partitions.
+
+    A many-partition nvector is the concatenation of existing nvectors,
+    possibly of different kinds, for instance one serial nvector per
+    physical field or a mix of serial, OpenMP, Pthreads, and parallel
+    nvectors. The partitions are not copied: each operation on a
+    many-partition nvector applies the operation of each partition to its
+    own data, and reductions, like dot products and norms, combine the
+    results for each partition.
+
+    The length of a partition is taken to be its storage requirement in
+    reals (see {!Nvector.NVECTOR_OPS.n_vspace}), except for parallel
+    partitions, whose global length is used. When parallel partitions are
+    mixed with others, the others are considered to be replicated on all
+    processes. Each reduction combines the results over the local elements
+    of all the parallel partitions with a single [MPI_Allreduce].
+
+    This is similar to the ManyVector introduced in Sundials 5.0.0. *)
+
+(** Classifies many-partition nvectors. *)
+type kind
+
+(** A partition of a many-partition nvector. *)
+type partition = Partition : ('d, 'k) Nvector.t -> partition
+
+(** The data wrapped by a many-partition nvector. *)
+type data = partition array
+
+(** The type of many-partition nvectors. *)
+type t = (data, kind) Nvector.t
+
+(** [wrap parts] creates a many-partition nvector from a non-empty array of
+    nvectors. Two many-partition nvectors are compatible if they have the
+    same number of partitions and if their partitions are pairwise
+    compatible. Fused and array operations are provided by the Sundials
+    defaults in terms of the standard operations.
+
+    @raise Invalid_argument The array is empty, a partition does not
+                            provide {!Nvector.NVECTOR_OPS.n_vspace}, or the
+                            parallel partitions have different
+                            communicators. *)
+val wrap : data -> t
+
+(** Aliases {!Nvector.unwrap}. *)
+val unwrap : t -> data
+
+(** Returns the local elements of a serial, OpenMP, Pthreads, or
+    parallel partition. This permits access, within callbacks, to the
+    partitions of the nvectors created by a solver.
+
+    @raise Invalid_argument The partition is of another kind.
+    @raise Config.NotImplementedBySundialsVersion Nvector ids not available. *)
+val local_array : partition -> Sundials.RealArray.t
+
+(** Operations on many-partition nvectors. *)
+module Ops : Nvector.NVECTOR_OPS with type t = t
@@ -25,31 +25,206 @@
 #include <math.h>		/* for nan() */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include <nvector/nvector_serial.h>
 
 /** Generic nvector functions and macros */
 
-N_Vector sunml_alloc_cnvec(size_t content_size, value backlink)
+/* The ops table of a c-nvec is reference counted so that the vectors
+   cloned by Sundials can share the table of the vector they are cloned
+   from (see sunml_clone_cnvec).  The saved table holds the operations
+   replaced by sunml_nvec_save_ops.  */
+struct cnvec_ops {
+    struct _generic_N_Vector_Ops ops;	/* must be first */
+    int refs;
+    int has_saved;
+    struct _generic_N_Vector_Ops saved;
+};
+#define CNVEC_OPS(nv) ((struct cnvec_ops *)(nv)->ops)
+
+/* Freed c-nvecs are kept, together with their content blocks, for reuse
+   by later allocations with the same content size.  Solvers clone and
+   destroy vectors frequently (for sensitivities, Krylov bases, and
+   resizing), and typically with a single content size.  Only these two
+   small blocks are recycled: the ops table is shared and reference
+   counted instead, and the payload, which may be retained in OCaml, is
+   never reused.
+
+   The pool is global rather than per session because c-nvecs are not
+   tied to a session: they are created from OCaml, cloned by any solver
+   they are passed to, and outlive the sessions that cloned them.  It is
+   protected, together with the nvec_memory counters, by cnvec_lock since
+   sessions in different threads (or domains) may clone and destroy
+   vectors concurrently.  */
+#define CNVEC_POOL_SIZE 64
+static N_Vector cnvec_pool[CNVEC_POOL_SIZE];
+static int cnvec_pool_count = 0;
+static pthread_mutex_t cnvec_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static N_Vector alloc_pooled_cnvec(size_t content_size)
 {
     N_Vector nv;
+    int i;
+
+    pthread_mutex_lock(&cnvec_lock);
+    for (i = cnvec_pool_count - 1; i >= 0; --i) {
+	nv = cnvec_pool[i];
+	if (((struct cnvec *)nv)->content_size == content_size) {
+	    cnvec_pool[i] = cnvec_pool[--cnvec_pool_count];
+	    pthread_mutex_unlock(&cnvec_lock);
+	    return nv;
+	}
+    }
+    pthread_mutex_unlock(&cnvec_lock);
 
     /* Alloc memory in C heap */
     nv = (N_Vector)malloc(sizeof(struct cnvec));
     if (nv == NULL) return NULL;
 
-    nv->ops = NULL;
-    nv->ops = (N_Vector_Ops) malloc(sizeof(struct _generic_N_Vector_Ops));
-    if (nv->ops == NULL) { free(nv); return(NULL); }
-
     nv->content = NULL;
     if (content_size != 0) {
 	nv->content = (void *) malloc(content_size);
-	if (nv->content == NULL) { free(nv->ops); free(nv); return(NULL); }
+	if (nv->content == NULL) { free(nv); return(NULL); }
+    }
+    ((struct cnvec *)nv)->content_size = content_size;
+
+    return nv;
+}
+
+static void release_pooled_cnvec(N_Vector nv)
+{
+    pthread_mutex_lock(&cnvec_lock);
+    if (cnvec_pool_count < CNVEC_POOL_SIZE) {
+	cnvec_pool[cnvec_pool_count++] = nv;
+	nv = NULL;
+    }
+    pthread_mutex_unlock(&cnvec_lock);
+
+    if (nv != NULL) {
+	if (nv->content != NULL) free(nv->content);
+	free(nv);
     }
+}
+
+static struct nvec_memory {
+    long wrapped, clones, roots;
+    long long clone_bytes;
+    long max_clones, max_roots;
+    long long max_clone_bytes;
+} nvec_memory;
+
+void sunml_nvec_register_root(value *r)
+{
+    caml_register_generational_global_root(r);
+    pthread_mutex_lock(&cnvec_lock);
+    if (++nvec_memory.roots > nvec_memory.max_roots)
+	nvec_memory.max_roots = nvec_memory.roots;
+    pthread_mutex_unlock(&cnvec_lock);
+}
+
+void sunml_nvec_remove_root(value *r)
+{
+    caml_remove_generational_global_root(r);
+    pthread_mutex_lock(&cnvec_lock);
+    --nvec_memory.roots;
+    pthread_mutex_unlock(&cnvec_lock);
+}
+
+void sunml_nvec_account_payload(N_Vector nv, size_t bytes)
+{
+    struct cnvec *c = (struct cnvec *)nv;
+
+    if (!c->cloned) return;
+    pthread_mutex_lock(&cnvec_lock);
+    nvec_memory.clone_bytes += (long long)bytes - (long long)c->payload_size;
+    c->payload_size = bytes;
+    if (nvec_memory.clone_bytes > nvec_memory.max_clone_bytes)
+	nvec_memory.max_clone_bytes = nvec_memory.clone_bytes;
+    pthread_mutex_unlock(&cnvec_lock);
+}
+
+/* Return the current counts and the high-water marks as an
+   Nvector.memory record.  */
+CAMLprim value sunml_nvec_get_memory(value vunit)
+{
+    CAMLparam1(vunit);
+    CAMLlocal1(vr);
+    struct nvec_memory m;
+
+    pthread_mutex_lock(&cnvec_lock);
+    m = nvec_memory;
+    pthread_mutex_unlock(&cnvec_lock);
+
+    vr = caml_alloc_tuple(7);
+    Store_field(vr, 0, Val_long(m.wrapped));
+    Store_field(vr, 1, Val_long(m.clones));
+    Store_field(vr, 2, Val_long(m.clone_bytes));
+    Store_field(vr, 3, Val_long(m.roots));
+    Store_field(vr, 4, Val_long(m.max_clones));
+    Store_field(vr, 5, Val_long(m.max_clone_bytes));
+    Store_field(vr, 6, Val_long(m.max_roots));
+
+    CAMLreturn(vr);
+}
+
+CAMLprim value sunml_nvec_reset_memory_high_water(value vunit)
+{
+    pthread_mutex_lock(&cnvec_lock);
+    nvec_memory.max_clones = nvec_memory.clones;
+    nvec_memory.max_clone_bytes = nvec_memory.clone_bytes;
+    nvec_memory.max_roots = nvec_memory.roots;
+    pthread_mutex_unlock(&cnvec_lock);
+    return Val_unit;
+}
+
+N_Vector sunml_alloc_cnvec(size_t content_size, value backlink)
+{
+    N_Vector nv;
+
+    nv = alloc_pooled_cnvec(content_size);
+    if (nv == NULL) return NULL;
+
+    nv->ops = NULL;
+    nv->ops = (N_Vector_Ops) malloc(sizeof(struct cnvec_ops));
+    if (nv->ops == NULL) { release_pooled_cnvec(nv); return(NULL); }
+    CNVEC_OPS(nv)->refs = 1;
+    CNVEC_OPS(nv)->has_saved = 0;
+
+    ((struct cnvec *)nv)->cloned = 0;
+    ((struct cnvec *)nv)->payload_size = 0;
+    pthread_mutex_lock(&cnvec_lock);
+    nvec_memory.wrapped++;
+    pthread_mutex_unlock(&cnvec_lock);
+
+    NVEC_BACKLINK(nv) = backlink;
+    sunml_nvec_register_root(&NVEC_BACKLINK(nv));
+
+    return nv;
+}
+
+N_Vector sunml_clone_cnvec(size_t content_size, value backlink, N_Vector w)
+{
+    N_Vector nv;
+
+    nv = alloc_pooled_cnvec(content_size);
+    if (nv == NULL) return NULL;
+
+    ((struct cnvec *)nv)->cloned = 1;
+    ((struct cnvec *)nv)->payload_size = 0;
+    pthread_mutex_lock(&cnvec_lock);
+    nv->ops = w->ops;
+    CNVEC_OPS(nv)->refs++;
+    if (++nvec_memory.clones > nvec_memory.max_clones)
+	nvec_memory.max_clones = nvec_memory.clones;
+    pthread_mutex_unlock(&cnvec_lock);
 
     NVEC_BACKLINK(nv) = backlink;
-    caml_register_generational_global_root(&NVEC_BACKLINK(nv));
+    sunml_nvec_register_root(&NVEC_BACKLINK(nv));
 
     return nv;
 }
@@ -73,10 +248,61 @@ CAMLprim value sunml_alloc_caml_nvec(N_Vector nv, void (*finalizer)(value))
 
 void sunml_free_cnvec(N_Vector nv)
 {
-    caml_remove_generational_global_root(&NVEC_BACKLINK(nv));
-    if (nv->content != NULL) free(nv->content);
-    free(nv->ops);
-    free(nv);
+    struct cnvec *c = (struct cnvec *)nv;
+    int refs;
+
+    sunml_nvec_remove_root(&NVEC_BACKLINK(nv));
+
+    pthread_mutex_lock(&cnvec_lock);
+    if (c->cloned) {
+	nvec_memory.clones--;
+	nvec_memory.clone_bytes -= c->payload_size;
+    } else {
+	nvec_memory.wrapped--;
+    }
+    refs = --CNVEC_OPS(nv)->refs;
+    pthread_mutex_unlock(&cnvec_lock);
+
+    if (refs == 0) free(nv->ops);
+    nv->ops = NULL;
+    release_pooled_cnvec(nv);
+}
+
+N_Vector sunml_nvec_own_ops(N_Vector nv)
+{
+    struct cnvec_ops *ops = NULL;
+
+    pthread_mutex_lock(&cnvec_lock);
+    if (CNVEC_OPS(nv)->refs > 1) {
+	ops = (struct cnvec_ops *) malloc(sizeof(struct cnvec_ops));
+	if (ops != NULL) {
+	    *ops = *CNVEC_OPS(nv);
+	    ops->refs = 1;
+	    CNVEC_OPS(nv)->refs--;
+	    nv->ops = (N_Vector_Ops) ops;
+	}
+    } else {
+	ops = CNVEC_OPS(nv);
+    }
+    pthread_mutex_unlock(&cnvec_lock);
+
+    if (ops == NULL) caml_raise_out_of_memory();
+    return nv;
+}
+
+void sunml_nvec_save_ops(N_Vector nv)
+{
+    if (!CNVEC_OPS(nv)->has_saved) {
+	CNVEC_OPS(nv)->saved = CNVEC_OPS(nv)->ops;
+	CNVEC_OPS(nv)->has_saved = 1;
+    }
+}
+
+N_Vector_Ops sunml_nvec_restore_ops(N_Vector nv)
+{
+    if (!CNVEC_OPS(nv)->has_saved) return NULL;
+    CNVEC_OPS(nv)->has_saved = 0;
+    return &CNVEC_OPS(nv)->saved;
 }
 
 void sunml_finalize_caml_nvec (value vnv)
@@ -152,6 +378,209 @@ void sunml_nvector_array_free(N_Vector *nvarr)
     free(nvarr);
 }
 
+intnat sunml_nvec_data_length(N_Vector y)
+{
+    if (y->ops->nvgetarraypointer == NULL) return -1;
+#if 500 <= SUNDIALS_LIB_VERSION
+    return N_VGetLength(y);
+#else
+    return NV_LENGTH_S(y);	/* also the first field of OpenMP and Pthreads */
+#endif
+}
+
+/* The terms are copied, so the bigarrays need not outlive the call.
+   qf->w is non-NULL exactly when forms are set, even if there are no
+   terms.  */
+void sunml_quadforms_set(struct sunml_quadforms *qf,
+			 value vrow, value va, value vb, value vw, intnat ny)
+{
+    intnat n = Caml_ba_array_val(vw)->dim[0];
+    intnat *a = (intnat *)Caml_ba_data_val(va);
+    intnat *b = (intnat *)Caml_ba_data_val(vb);
+    intnat k;
+    void *p;
+
+    if (ny < 0)
+	caml_invalid_argument("init_forms: the state vector has no "
+			      "contiguous data");
+    for (k = 0; k < n; ++k)
+	if (a[k] < 0 || a[k] >= ny || b[k] >= ny)
+	    caml_invalid_argument("init_forms: index out of bounds");
+
+    p = malloc((n > 0 ? n : 1) * (3 * sizeof(intnat) + sizeof(realtype)));
+    if (p == NULL) caml_raise_out_of_memory();
+
+    sunml_quadforms_free(qf);
+    qf->nterms = n;
+    qf->w   = (realtype *)p;
+    qf->row = (intnat *)(qf->w + n);
+    qf->a   = qf->row + n;
+    qf->b   = qf->a + n;
+
+    memcpy(qf->w,   Caml_ba_data_val(vw),   n * sizeof(realtype));
+    memcpy(qf->row, Caml_ba_data_val(vrow), n * sizeof(intnat));
+    memcpy(qf->a,   Caml_ba_data_val(va),   n * sizeof(intnat));
+    memcpy(qf->b,   Caml_ba_data_val(vb),   n * sizeof(intnat));
+}
+
+void sunml_quadforms_free(struct sunml_quadforms *qf)
+{
+    free(qf->w);
+    qf->w = NULL;
+    qf->nterms = 0;
+}
+
+void sunml_quadforms_eval(struct sunml_quadforms *qf, N_Vector y, N_Vector q)
+{
+    realtype *yd = N_VGetArrayPointer(y);
+    realtype *qd = N_VGetArrayPointer(q);
+    intnat k;
+
+    N_VConst(0.0, q);
+    for (k = 0; k < qf->nterms; ++k) {
+	realtype v = qf->w[k] * yd[qf->a[k]];
+	qd[qf->row[k]] += (qf->b[k] < 0) ? v : v * yd[qf->b[k]];
+    }
+}
+
+/* The derivative of the forms along ys: the weights do not depend on the
+   parameters.  */
+void sunml_quadforms_eval_sens(struct sunml_quadforms *qf,
+			       N_Vector y, N_Vector ys, N_Vector qs)
+{
+    realtype *yd  = N_VGetArrayPointer(y);
+    realtype *ysd = N_VGetArrayPointer(ys);
+    realtype *qsd = N_VGetArrayPointer(qs);
+    intnat k, a, b;
+
+    N_VConst(0.0, qs);
+    for (k = 0; k < qf->nterms; ++k) {
+	a = qf->a[k];
+	b = qf->b[k];
+	qsd[qf->row[k]] += qf->w[k] * ((b < 0) ? ysd[a]
+					       : ysd[a] * yd[b] + yd[a] * ysd[b]);
+    }
+}
+
+/* Must correspond with Cvode.structured_tolerance.  */
+enum ewtspec_index {
+    EWTSPEC_RTOL = 0,
+    EWTSPEC_ATOL,
+    EWTSPEC_FLOOR,
+    EWTSPEC_CAP,
+    EWTSPEC_BLOCK,
+};
+
+static realtype *ewtspec_array(value va, intnat *len)
+{
+    *len = Caml_ba_array_val(va)->dim[0];
+    return (realtype *)Caml_ba_data_val(va);
+}
+
+/* An array applies to every group if it has one element, and otherwise
+   must have one for each group.  */
+static int ewtspec_fits(value va, intnat ngroups)
+{
+    intnat len = Caml_ba_array_val(va)->dim[0];
+    return (len == 1 || len >= ngroups);
+}
+
+void sunml_ewtspec_set(struct sunml_ewtspec *es, value vspec, intnat n)
+{
+    value vfloor = Field(vspec, EWTSPEC_FLOOR);
+    value vcap   = Field(vspec, EWTSPEC_CAP);
+    intnat ngroups;
+    intnat block = Long_val(Field(vspec, EWTSPEC_BLOCK));
+
+    if (n < 0)
+	caml_invalid_argument("STtolerances: the state vector has no "
+			      "contiguous data");
+    if (block < 1) caml_invalid_argument("STtolerances: block < 1");
+    ngroups = (n + block - 1) / block;
+    if (!ewtspec_fits(Field(vspec, EWTSPEC_RTOL), ngroups)
+	    || !ewtspec_fits(Field(vspec, EWTSPEC_ATOL), ngroups)
+	    || (vfloor != Val_none && !ewtspec_fits(Some_val(vfloor), ngroups))
+	    || (vcap != Val_none && !ewtspec_fits(Some_val(vcap), ngroups)))
+	caml_invalid_argument("STtolerances: array lengths do not match the "
+			      "number of groups");
+
+    if (es->rtol == NULL) {
+	es->spec = vspec;
+	caml_register_generational_global_root(&es->spec);
+    } else {
+	caml_modify_generational_global_root(&es->spec, vspec);
+    }
+
+    es->block = block;
+    es->rtol = ewtspec_array(Field(vspec, EWTSPEC_RTOL), &es->rtol_len);
+    es->atol = ewtspec_array(Field(vspec, EWTSPEC_ATOL), &es->atol_len);
+    es->floor = (vfloor == Val_none) ? NULL
+		: ewtspec_array(Some_val(vfloor), &es->floor_len);
+    es->cap = (vcap == Val_none) ? NULL
+		: ewtspec_array(Some_val(vcap), &es->cap_len);
+}
+
+void sunml_ewtspec_free(struct sunml_ewtspec *es)
+{
+    if (es->rtol == NULL) return;
+    caml_remove_generational_global_root(&es->spec);
+    es->rtol = NULL;
+}
+
+/* The lengths are checked by sunml_ewtspec_set, but only against the
+   length of the session's vectors.  An array of length 1 has stride 0.  */
+#define EWTSPEC_STRIDE(len, ngroups, stride) \
+    if ((len) > 1 && (len) < (ngroups)) return -1; \
+    stride = ((len) > 1)
+
+/* The common case, one group per component without bounds, is a separate
+   loop without branches so that it vectorizes.  */
+int sunml_ewtspec_eval(struct sunml_ewtspec *es, N_Vector y, N_Vector ewt)
+{
+    realtype *restrict yd, *restrict wd;
+    const realtype *restrict rtol = es->rtol, *restrict atol = es->atol;
+    intnat i, j, g, n, i1, ngroups, rs, as, fs = 0, cs = 0;
+    realtype s, w, bad = 1.0;
+
+    n = sunml_nvec_data_length(y);
+    if (n < 0) return -1;
+    yd = N_VGetArrayPointer(y);
+    wd = N_VGetArrayPointer(ewt);
+    if (yd == NULL || wd == NULL) return -1;
+
+    ngroups = (n + es->block - 1) / es->block;
+    EWTSPEC_STRIDE(es->rtol_len, ngroups, rs);
+    EWTSPEC_STRIDE(es->atol_len, ngroups, as);
+    if (es->floor != NULL) { EWTSPEC_STRIDE(es->floor_len, ngroups, fs); }
+    if (es->cap != NULL) { EWTSPEC_STRIDE(es->cap_len, ngroups, cs); }
+
+    if (es->block == 1 && es->floor == NULL && es->cap == NULL) {
+	for (i = 0; i < n; ++i) {
+	    w = rtol[i * rs] * SUNRabs(yd[i]) + atol[i * as];
+	    bad = (w < bad) ? w : bad;
+	    wd[i] = 1.0 / w;
+	}
+	return (bad > 0.0) ? 0 : -1;
+    }
+
+    for (i = 0, g = 0; i < n; i = i1, ++g) {
+	i1 = (i + es->block < n) ? i + es->block : n;
+
+	s = 0.0;
+	for (j = i; j < i1; ++j)
+	    if (SUNRabs(yd[j]) > s) s = SUNRabs(yd[j]);
+
+	w = rtol[g * rs] * s + atol[g * as];
+	if (es->floor != NULL && w < es->floor[g * fs]) w = es->floor[g * fs];
+	if (es->cap != NULL && w > es->cap[g * cs]) w = es->cap[g * cs];
+	if (w <= 0.0) return -1;
+
+	for (j = i; j < i1; ++j) wd[j] = 1.0 / w;
+    }
+
+    return 0;
+}
+
 CAMLprim value sunml_nvec_get_id(value vx)
 {
     CAMLparam1(vx);
@@ -222,14 +651,13 @@ static N_Vector clone_serial(N_Vector w)
     /* Create vector (we need not copy the data) */
     v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
 
-    v = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_Serial), v_payload);
+    v = sunml_clone_cnvec(sizeof(struct _N_VectorContent_Serial), v_payload, w);
     if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
 
     content = (N_VectorContent_Serial) v->content;
 
-    /* Create vector operation structure */
-    sunml_clone_cnvec_ops(v, w);
-
     /* Create content */
     content->length   = NV_LENGTH_S(w);
     content->own_data = 0;
@@ -267,18 +695,15 @@ static N_Vector clone_empty_serial(N_Vector w)
 /* Creation from OCaml.  */
 /* Adapted from sundials-2.5.0/src/nvec_ser/nvector_serial.c:
    N_VNewEmpty_Serial */
-CAMLprim value sunml_nvec_wrap_serial(value payload, value checkfn)
+static N_Vector alloc_serial(value payload, size_t content_size)
 {
-    CAMLparam2(payload, checkfn);
-    CAMLlocal1(vnvec);
-
     N_Vector nv;
     N_Vector_Ops ops;
     N_VectorContent_Serial content;
     long int length = (Caml_ba_array_val(payload))->dim[0];
 
     /* Create vector */
-    nv = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_Serial), payload);
+    nv = sunml_alloc_cnvec(content_size, payload);
     if (nv == NULL) caml_raise_out_of_memory();
     ops = (N_Vector_Ops) nv->ops;
     content = (N_VectorContent_Serial) nv->content;
@@ -336,6 +761,17 @@ CAMLprim value sunml_nvec_wrap_serial(value payload, value checkfn)
     content->own_data = 0;
     content->data     = Caml_ba_data_val(payload);
 
+    return nv;
+}
+
+CAMLprim value sunml_nvec_wrap_serial(value payload, value checkfn)
+{
+    CAMLparam2(payload, checkfn);
+    CAMLlocal1(vnvec);
+    N_Vector nv;
+
+    nv = alloc_serial(payload, sizeof(struct _N_VectorContent_Serial));
+
     vnvec = caml_alloc_tuple(3);
     Store_field(vnvec, 0, payload);
     Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
@@ -344,115 +780,572 @@ CAMLprim value sunml_nvec_wrap_serial(value payload, value checkfn)
     CAMLreturn(vnvec);
 }
 
-/** Custom nvectors * * * * * * * * * * * * * * * * * * * * * * * * * * */
+/* Serial nvectors with scratch clones.
+
+   The payloads of the vectors cloned from such an nvector are allocated in
+   unlinked temporary files mapped into memory (rather than on the C heap),
+   so that the workspace of a solver can exceed the available RAM.  The
+   content of these nvectors is extended with a reference, shared by all the
+   vectors cloned from the same original, to the directory in which the files
+   are created (a string option ref).  While the reference is None, clones
+   are allocated on the C heap as usual.  Switching it on only around the
+   forward phase of an adjoint problem puts just the checkpoints, which are
+   cloned during that phase, into files.  */
+
+struct scratch_content {
+    struct _N_VectorContent_Serial serial;
+    value dir;
+};
+#define SCRATCH_DIR(nvec) (((struct scratch_content *)(nvec)->content)->dir)
+
+/* The payloads of scratch clones are unmapped by their finalizer. Sub-arrays
+   share the custom operations (and thus the finalizer) of their parent.
+   The operations are copied from those of the runtime, once, by
+   sunml_nvec_serial_init_scratch.  This relies on the bigarray operations
+   and proxies of OCaml >= 4.09; scratch clones are not available with
+   earlier versions.  */
+#if 409 <= SUNDIALS_ML_OCAML_VERSION
+#define SCRATCH_CLONES
+static struct custom_operations scratch_ba_ops;
+
+static void scratch_ba_finalize(value v)
+{
+    struct caml_ba_array *b = Caml_ba_array_val(v);
 
-#define CNVEC_OP_TABLE(nvec)  ((nvec)->content)
+    if (b->proxy == NULL) {
+	munmap(b->data, caml_ba_byte_size(b));
+    } else if (--b->proxy->refcount == 0) {
+	munmap(b->proxy->data, b->proxy->size);
+	free(b->proxy);
+    }
+}
 
-#define GET_OP(nvec, x) (Field((value)CNVEC_OP_TABLE(nvec), x))
+static value alloc_scratch_payload(value vdir, struct caml_ba_array *w_ba)
+{
+    CAMLparam1(vdir);
+    CAMLlocal1(v_payload);
+    size_t size = caml_ba_byte_size(w_ba);
+    size_t pathlen = caml_string_length(vdir) + sizeof("/sundialsml-XXXXXX");
+    char *path;
+    void *data;
+    int fd;
+
+    /* mmap does not accept empty mappings */
+    if (size == 0)
+	CAMLreturn(caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim));
+
+    path = malloc(pathlen);
+    if (path == NULL) CAMLreturn(Val_unit);
+    snprintf(path, pathlen, "%s/sundialsml-XXXXXX", String_val(vdir));
+
+    fd = mkstemp(path);
+    if (fd == -1) {
+	free(path);
+	CAMLreturn(Val_unit);
+    }
+    unlink(path);
+    free(path);
 
-#define HAS_OP(ops, x)	     (Field(ops, x) != Val_int(0))
-#define IS_SOME_OP(nvec, x)  (HAS_OP(CNVEC_OP_TABLE(nvec), x))
-#define GET_SOME_OP(nvec, x) (Field(Field(CNVEC_OP_TABLE(nvec), x), 0))
+    if (ftruncate(fd, size) == -1) {
+	close(fd);
+	CAMLreturn(Val_unit);
+    }
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) CAMLreturn(Val_unit);
 
-static void free_custom_cnvec(N_Vector v)
-{
-    caml_remove_generational_global_root((value *)&CNVEC_OP_TABLE(v));
-    v->content = NULL;
-    sunml_free_cnvec(v);
+    v_payload = caml_ba_alloc(BIGARRAY_FLOAT | CAML_BA_MAPPED_FILE,
+			      w_ba->num_dims, data, w_ba->dim);
+    Custom_ops_val(v_payload) = &scratch_ba_ops;
+
+    CAMLreturn(v_payload);
 }
 
-static void finalize_custom_caml_nvec(value vnv)
+#endif /* SCRATCH_CLONES */
+
+CAMLprim void sunml_nvec_serial_init_scratch(value unit)
 {
-    free_custom_cnvec (NVEC_CVAL(vnv));
+    CAMLparam1(unit);
+#ifdef SCRATCH_CLONES
+    CAMLlocal1(vba);
+
+    vba = caml_ba_alloc_dims(BIGARRAY_FLOAT, 1, NULL, (intnat)0);
+    scratch_ba_ops = *Custom_ops_val(vba);
+    scratch_ba_ops.finalize = scratch_ba_finalize;
+#endif
+    CAMLreturn0;
 }
 
-#if SUNDIALS_LIB_VERSION >= 270
-static N_Vector_ID getvectorid_custom(N_Vector v)
+#ifdef SCRATCH_CLONES
+static N_Vector clone_serial_scratch(N_Vector w)
 {
-      return SUNDIALS_NVEC_CUSTOM;
-}
-#endif
+    CAMLparam0();
+    CAMLlocal2(v_payload, v_dir);
 
-// Custom operations
-static N_Vector callml_vclone(N_Vector w);
-static void callml_vspace(N_Vector v, sundials_ml_index *lrw, sundials_ml_index *liw);
-static void callml_vlinearsum(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z);
-static void callml_vconst(realtype c, N_Vector z);
-static void callml_vprod(N_Vector x, N_Vector y, N_Vector z);
-static void callml_vdiv(N_Vector x, N_Vector y, N_Vector z);
-static void callml_vscale(realtype c, N_Vector x, N_Vector z);
-static void callml_vabs(N_Vector x, N_Vector z);
-static void callml_vinv(N_Vector x, N_Vector z);
-static void callml_vaddconst(N_Vector x, realtype b, N_Vector z);
-static realtype callml_vdotprod(N_Vector x, N_Vector y);
-static realtype callml_vmaxnorm(N_Vector x);
-static realtype callml_vwrmsnorm(N_Vector x, N_Vector w);
-static realtype callml_vwrmsnormmask(N_Vector x, N_Vector w, N_Vector id);
-static realtype callml_vmin(N_Vector x);
-static realtype callml_vwl2norm(N_Vector x, N_Vector w);
-static realtype callml_vl1norm(N_Vector x);
-static void callml_vcompare(realtype c, N_Vector x, N_Vector z);
-static booleantype callml_vinvtest(N_Vector x, N_Vector z);
-static booleantype callml_vconstrmask(N_Vector c, N_Vector x, N_Vector m);
-static realtype callml_vminquotient(N_Vector num, N_Vector denom);
+    N_Vector v;
+    N_VectorContent_Serial content;
 
-/* Custom fused vector operations */
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vlinearcombination(int nvec, realtype* c,
-				     N_Vector* V, N_Vector z);
-static int callml_vscaleaddmulti(int nvec, realtype* a,
-			            N_Vector x, N_Vector* Y, N_Vector* Z);
-static int callml_vdotprodmulti(int nvec, N_Vector x, N_Vector *Y,
-				   realtype* dotprods);
-#endif
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+    v_dir = Field(SCRATCH_DIR(w), 0);
 
-/* Custom vector array operations */
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vlinearsumvectorarray(int nvec, realtype a, N_Vector* X,
-					realtype b, N_Vector* Y, N_Vector* Z);
-static int callml_vscalevectorarray(int nvec, realtype* c, N_Vector* X,
-				    N_Vector* Z);
-static int callml_vconstvectorarray(int nvecs, realtype c, N_Vector* Z);
-static int callml_vwrmsnormvectorarray(int nvecs, N_Vector* X,
-				       N_Vector* W, realtype* nrm);
-static int callml_vwrmsnormmaskvectorarray(int nvecs, N_Vector* X, N_Vector* W,
-					   N_Vector id, realtype* nrm);
-static int callml_vscaleaddmultivectorarray(int nvec, int nsum, realtype* a,
-					    N_Vector* X, N_Vector** Y,
-					    N_Vector** Z);
-static int callml_vlinearcombinationvectorarray(int nvec, int nsum, realtype* c,
-						N_Vector** X, N_Vector* Z);
-#endif
+    if (Is_block(v_dir)) {
+	v_payload = alloc_scratch_payload(Field(v_dir, 0),
+					  Caml_ba_array_val(NVEC_BACKLINK(w)));
+	if (v_payload == Val_unit) CAMLreturnT (N_Vector, NULL);
+    } else {
+	struct caml_ba_array *w_ba = Caml_ba_array_val(NVEC_BACKLINK(w));
+	v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
+    }
+    v_dir = SCRATCH_DIR(w);
 
-/* Creation from OCaml. */
-CAMLprim value sunml_nvec_wrap_custom(value mlops, value payload, value checkfn)
-{
-    CAMLparam3(mlops, payload, checkfn);
-    CAMLlocal1(vcnvec);
+    v = sunml_clone_cnvec(sizeof(struct scratch_content), v_payload, w);
+    if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
 
-    N_Vector nv;
-    N_Vector_Ops ops;
+    content = (N_VectorContent_Serial) v->content;
 
-    /* Create vector */
-    nv = sunml_alloc_cnvec(0, payload);
-    if (nv == NULL) caml_raise_out_of_memory();
-    ops = (N_Vector_Ops) nv->ops;
+    /* Create content */
+    content->length   = NV_LENGTH_S(w);
+    content->own_data = 0;
+    content->data     = Caml_ba_data_val(v_payload);
 
-    /* Create vector operation structure */
-    ops->nvclone           = callml_vclone;
-    ops->nvcloneempty      = NULL;
-    ops->nvdestroy         = free_custom_cnvec;
-#if SUNDIALS_LIB_VERSION >= 270
-    ops->nvgetvectorid	   = getvectorid_custom;
-#endif
+    SCRATCH_DIR(v) = v_dir;
+    sunml_nvec_register_root(&SCRATCH_DIR(v));
 
-    ops->nvspace = NULL;
-    if (HAS_OP(mlops, NVECTOR_OPS_NVSPACE))
-	ops->nvspace = callml_vspace;
+    CAMLreturnT(N_Vector, v);
+}
 
-    ops->nvlinearsum       = callml_vlinearsum;
-    ops->nvconst           = callml_vconst;
-    ops->nvprod            = callml_vprod;
+static void free_scratch_cnvec(N_Vector v)
+{
+    sunml_nvec_remove_root(&SCRATCH_DIR(v));
+    sunml_free_cnvec(v);
+}
+
+static void finalize_scratch_caml_nvec(value vnv)
+{
+    free_scratch_cnvec (NVEC_CVAL(vnv));
+}
+#endif /* SCRATCH_CLONES */
+
+CAMLprim value sunml_nvec_wrap_serial_scratch(value vdir, value payload,
+					      value checkfn)
+{
+    CAMLparam3(vdir, payload, checkfn);
+    CAMLlocal1(vnvec);
+#ifdef SCRATCH_CLONES
+    N_Vector nv;
+
+    nv = alloc_serial(payload, sizeof(struct scratch_content));
+    nv->ops->nvclone   = clone_serial_scratch;
+    nv->ops->nvdestroy = free_scratch_cnvec;
+
+    SCRATCH_DIR(nv) = vdir;
+    sunml_nvec_register_root(&SCRATCH_DIR(nv));
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, finalize_scratch_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+#else
+    caml_failwith("Nvector_serial.wrap_with_scratch: requires OCaml >= 4.09");
+#endif
+
+    CAMLreturn(vnvec);
+}
+
+CAMLprim void sunml_nvec_serial_set_scratch_dir(value vnvec, value vdir)
+{
+    CAMLparam2(vnvec, vdir);
+#ifdef SCRATCH_CLONES
+    N_Vector nv = NVEC_VAL(vnvec);
+
+    if (nv->ops->nvclone != clone_serial_scratch)
+	caml_invalid_argument("Nvector_serial.set_scratch_dir: no scratch clones");
+    Store_field(SCRATCH_DIR(nv), 0, vdir);
+#else
+    caml_invalid_argument("Nvector_serial.set_scratch_dir: no scratch clones");
+#endif
+
+    CAMLreturn0;
+}
+
+/* Flush the elements of a Bigarray mapped from a file (a checkpoint).
+   Other Bigarrays are left untouched.  */
+CAMLprim value sunml_nvec_sync_array(value vba)
+{
+    CAMLparam1(vba);
+    struct caml_ba_array *b = Caml_ba_array_val(vba);
+    uintptr_t pagesize, start, end;
+
+    if ((b->flags & CAML_BA_MANAGED_MASK) != CAML_BA_MAPPED_FILE
+	    || caml_ba_byte_size(b) == 0)
+	CAMLreturn(Val_unit);
+
+    pagesize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    start = (uintptr_t)b->data & ~(pagesize - 1);
+    end = (uintptr_t)b->data + caml_ba_byte_size(b);
+
+    if (msync((void *)start, end - start, MS_SYNC) == -1)
+	caml_failwith("Nvector.sync: msync failed");
+
+    CAMLreturn(Val_unit);
+}
+
+/* Serial nvectors in blocks.
+
+   The payloads of a block of serial nvectors are the columns of a single
+   RealArray2, so that their elements are consecutive in memory (see
+   Nvector_serial.wrap_block).  The content of these nvectors is extended
+   with an OCaml closure that returns the payload of a clone: the closure
+   hands out the successive columns of a block that it allocates whenever
+   the previous one is full, so that the arrays of vectors cloned by the
+   solvers (e.g., for sensitivities) are also blocks.  */
+
+struct block_content {
+    struct _N_VectorContent_Serial serial;
+    value alloc;	/* unit -> RealArray.t */
+};
+#define BLOCK_ALLOC(nvec) (((struct block_content *)(nvec)->content)->alloc)
+
+static N_Vector clone_serial_block(N_Vector w)
+{
+    CAMLparam0();
+    CAMLlocal1(v_payload);
+
+    N_Vector v;
+    N_VectorContent_Serial content;
+
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callback_exn (BLOCK_ALLOC(w), Val_unit);
+
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+				  "Nvector_serial block clone");
+	CAMLreturnT (N_Vector, NULL);
+    }
+    v_payload = r;
+    /* Done processing r.  Now it's OK to trigger GC.  */
+
+    v = sunml_clone_cnvec(sizeof(struct block_content), v_payload, w);
+    if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
+
+    content = (N_VectorContent_Serial) v->content;
+
+    /* Create content */
+    content->length   = NV_LENGTH_S(w);
+    content->own_data = 0;
+    content->data     = Caml_ba_data_val(v_payload);
+
+    BLOCK_ALLOC(v) = BLOCK_ALLOC(w);
+    sunml_nvec_register_root(&BLOCK_ALLOC(v));
+
+    CAMLreturnT(N_Vector, v);
+}
+
+static void free_block_cnvec(N_Vector v)
+{
+    sunml_nvec_remove_root(&BLOCK_ALLOC(v));
+    sunml_free_cnvec(v);
+}
+
+static void finalize_block_caml_nvec(value vnv)
+{
+    free_block_cnvec (NVEC_CVAL(vnv));
+}
+
+CAMLprim value sunml_nvec_wrap_serial_block(value valloc, value payload,
+					    value checkfn)
+{
+    CAMLparam3(valloc, payload, checkfn);
+    CAMLlocal1(vnvec);
+    N_Vector nv;
+
+    nv = alloc_serial(payload, sizeof(struct block_content));
+    nv->ops->nvclone   = clone_serial_block;
+    nv->ops->nvdestroy = free_block_cnvec;
+
+    BLOCK_ALLOC(nv) = valloc;
+    sunml_nvec_register_root(&BLOCK_ALLOC(nv));
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, finalize_block_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+/* Vector array operations over blocks.  When all of their array arguments
+   are blocks, they make a single pass over the consecutive elements.
+   Otherwise, they fall back to the standard serial operations.  */
+
+#if 400 <= SUNDIALS_LIB_VERSION
+
+/* Returns the data of the nvectors of X if they are consecutive in memory,
+   and NULL otherwise (also if there are none).  */
+static realtype *block_data(int nvec, N_Vector* X)
+{
+    realtype *d;
+    sundials_ml_index n;
+    int j;
+
+    if (nvec <= 0) return NULL;
+    d = NV_DATA_S(X[0]);
+    n = NV_LENGTH_S(X[0]);
+    for (j = 1; j < nvec; ++j)
+	if (NV_DATA_S(X[j]) != d + j * n || NV_LENGTH_S(X[j]) != n)
+	    return NULL;
+    return d;
+}
+
+/* Z[j] = a * X[j] + b * Y[j] */
+static int block_linearsumvectorarray(int nvec, realtype a, N_Vector* X,
+				      realtype b, N_Vector* Y, N_Vector* Z)
+{
+    realtype *xd = block_data(nvec, X);
+    realtype *yd = block_data(nvec, Y);
+    realtype *zd = block_data(nvec, Z);
+    sundials_ml_index n, i;
+
+    if (xd == NULL || yd == NULL || zd == NULL)
+	return N_VLinearSumVectorArray_Serial(nvec, a, X, b, Y, Z);
+
+    n = nvec * NV_LENGTH_S(Z[0]);
+    for (i = 0; i < n; ++i) zd[i] = a * xd[i] + b * yd[i];
+    return 0;
+}
+
+/* Z[j] = c[j] * X[j] */
+static int block_scalevectorarray(int nvec, realtype* c, N_Vector* X,
+				  N_Vector* Z)
+{
+    realtype *xd = block_data(nvec, X);
+    realtype *zd = block_data(nvec, Z);
+    sundials_ml_index n, i;
+    int j;
+
+    if (xd == NULL || zd == NULL)
+	return N_VScaleVectorArray_Serial(nvec, c, X, Z);
+
+    n = NV_LENGTH_S(Z[0]);
+    for (j = 0; j < nvec; ++j, xd += n, zd += n) {
+	realtype cj = c[j];
+	for (i = 0; i < n; ++i) zd[i] = cj * xd[i];
+    }
+    return 0;
+}
+
+/* Z[j] = c */
+static int block_constvectorarray(int nvec, realtype c, N_Vector* Z)
+{
+    realtype *zd = block_data(nvec, Z);
+    sundials_ml_index n, i;
+
+    if (zd == NULL)
+	return N_VConstVectorArray_Serial(nvec, c, Z);
+
+    n = nvec * NV_LENGTH_S(Z[0]);
+    for (i = 0; i < n; ++i) zd[i] = c;
+    return 0;
+}
+
+/* nrm[j] = sqrt(sum_i (X[j](i) * W[j](i))^2 / n) */
+static int block_wrmsnormvectorarray(int nvec, N_Vector* X, N_Vector* W,
+				     realtype* nrm)
+{
+    realtype *xd = block_data(nvec, X);
+    realtype *wd = block_data(nvec, W);
+    sundials_ml_index n, i;
+    int j;
+
+    if (xd == NULL || wd == NULL)
+	return N_VWrmsNormVectorArray_Serial(nvec, X, W, nrm);
+
+    n = NV_LENGTH_S(X[0]);
+    for (j = 0; j < nvec; ++j, xd += n, wd += n) {
+	realtype s = 0.0;
+	for (i = 0; i < n; ++i) s += (xd[i] * wd[i]) * (xd[i] * wd[i]);
+	nrm[j] = (n == 0) ? 0.0 : sqrt(s / n);
+    }
+    return 0;
+}
+
+/* Z[k] = sum_j c[j] * X[j][k] */
+static int block_linearcombinationvectorarray(int nvec, int nsum,
+					      realtype* c, N_Vector** X,
+					      N_Vector* Z)
+{
+    realtype *zd = block_data(nvec, Z);
+    realtype *xd;
+    sundials_ml_index n, i;
+    int j;
+
+    if (zd == NULL || nsum < 1) goto fallback;
+    for (j = 0; j < nsum; ++j) {
+	xd = block_data(nvec, X[j]);
+	/* Only the first term may alias the result */
+	if (xd == NULL || (j > 0 && xd == zd)) goto fallback;
+    }
+
+    n = nvec * NV_LENGTH_S(Z[0]);
+    xd = NV_DATA_S(X[0][0]);
+    for (i = 0; i < n; ++i) zd[i] = c[0] * xd[i];
+    for (j = 1; j < nsum; ++j) {
+	realtype cj = c[j];
+	xd = NV_DATA_S(X[j][0]);
+	for (i = 0; i < n; ++i) zd[i] += cj * xd[i];
+    }
+    return 0;
+
+fallback:
+    return N_VLinearCombinationVectorArray_Serial(nvec, nsum, c, X, Z);
+}
+
+#endif
+
+CAMLprim value sunml_nvec_ser_enableblockops(value vx)
+{
+    CAMLparam1(vx);
+#if 400 <= SUNDIALS_LIB_VERSION
+    N_Vector v = sunml_nvec_own_ops(NVEC_VAL(vx));
+
+    v->ops->nvlinearsumvectorarray         = block_linearsumvectorarray;
+    v->ops->nvscalevectorarray             = block_scalevectorarray;
+    v->ops->nvconstvectorarray             = block_constvectorarray;
+    v->ops->nvwrmsnormvectorarray          = block_wrmsnormvectorarray;
+    v->ops->nvlinearcombinationvectorarray =
+	block_linearcombinationvectorarray;
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
+/** Custom nvectors * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Layout nvectors (see below) keep their callback table in their content
+   structure.  */
+static void free_layout_cnvec(N_Vector v);
+struct layout_content {
+    value shared;	/* (clone, layout, ops) as in make_layout_wrap */
+    value segments;	/* Nvector_custom.segment array */
+};
+#define LNVEC_CONTENT(nvec) ((struct layout_content *)(nvec)->content)
+
+#define CNVEC_OP_TABLE(nvec)					\
+    (((nvec)->ops->nvdestroy == free_layout_cnvec)		\
+     ? Field(LNVEC_CONTENT(nvec)->shared, 2) : (value)(nvec)->content)
+
+#define GET_OP(nvec, x) (Field((value)CNVEC_OP_TABLE(nvec), x))
+
+#define HAS_OP(ops, x)	     (Field(ops, x) != Val_int(0))
+#define IS_SOME_OP(nvec, x)  (HAS_OP(CNVEC_OP_TABLE(nvec), x))
+#define GET_SOME_OP(nvec, x) (Field(Field(CNVEC_OP_TABLE(nvec), x), 0))
+
+static void free_custom_cnvec(N_Vector v)
+{
+    sunml_nvec_remove_root((value *)&v->content);
+    v->content = NULL;
+    sunml_free_cnvec(v);
+}
+
+static void finalize_custom_caml_nvec(value vnv)
+{
+    free_custom_cnvec (NVEC_CVAL(vnv));
+}
+
+#if SUNDIALS_LIB_VERSION >= 270
+static N_Vector_ID getvectorid_custom(N_Vector v)
+{
+      return SUNDIALS_NVEC_CUSTOM;
+}
+#endif
+
+// Custom operations
+static N_Vector callml_vclone(N_Vector w);
+static void callml_vspace(N_Vector v, sundials_ml_index *lrw, sundials_ml_index *liw);
+static void callml_vlinearsum(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z);
+static void callml_vconst(realtype c, N_Vector z);
+static void callml_vprod(N_Vector x, N_Vector y, N_Vector z);
+static void callml_vdiv(N_Vector x, N_Vector y, N_Vector z);
+static void callml_vscale(realtype c, N_Vector x, N_Vector z);
+static void callml_vabs(N_Vector x, N_Vector z);
+static void callml_vinv(N_Vector x, N_Vector z);
+static void callml_vaddconst(N_Vector x, realtype b, N_Vector z);
+static realtype callml_vdotprod(N_Vector x, N_Vector y);
+static realtype callml_vmaxnorm(N_Vector x);
+static realtype callml_vwrmsnorm(N_Vector x, N_Vector w);
+static realtype callml_vwrmsnormmask(N_Vector x, N_Vector w, N_Vector id);
+static realtype callml_vmin(N_Vector x);
+static realtype callml_vwl2norm(N_Vector x, N_Vector w);
+static realtype callml_vl1norm(N_Vector x);
+static void callml_vcompare(realtype c, N_Vector x, N_Vector z);
+static booleantype callml_vinvtest(N_Vector x, N_Vector z);
+static booleantype callml_vconstrmask(N_Vector c, N_Vector x, N_Vector m);
+static realtype callml_vminquotient(N_Vector num, N_Vector denom);
+
+/* Custom fused vector operations */
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vlinearcombination(int nvec, realtype* c,
+				     N_Vector* V, N_Vector z);
+static int callml_vscaleaddmulti(int nvec, realtype* a,
+			            N_Vector x, N_Vector* Y, N_Vector* Z);
+static int callml_vdotprodmulti(int nvec, N_Vector x, N_Vector *Y,
+				   realtype* dotprods);
+#endif
+
+/* Custom vector array operations */
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vlinearsumvectorarray(int nvec, realtype a, N_Vector* X,
+					realtype b, N_Vector* Y, N_Vector* Z);
+static int callml_vscalevectorarray(int nvec, realtype* c, N_Vector* X,
+				    N_Vector* Z);
+static int callml_vconstvectorarray(int nvecs, realtype c, N_Vector* Z);
+static int callml_vwrmsnormvectorarray(int nvecs, N_Vector* X,
+				       N_Vector* W, realtype* nrm);
+static int callml_vwrmsnormmaskvectorarray(int nvecs, N_Vector* X, N_Vector* W,
+					   N_Vector id, realtype* nrm);
+static int callml_vscaleaddmultivectorarray(int nvec, int nsum, realtype* a,
+					    N_Vector* X, N_Vector** Y,
+					    N_Vector** Z);
+static int callml_vlinearcombinationvectorarray(int nvec, int nsum, realtype* c,
+						N_Vector** X, N_Vector* Z);
+#endif
+
+/* Creation from OCaml. */
+CAMLprim value sunml_nvec_wrap_custom(value mlops, value payload, value checkfn)
+{
+    CAMLparam3(mlops, payload, checkfn);
+    CAMLlocal1(vcnvec);
+
+    N_Vector nv;
+    N_Vector_Ops ops;
+
+    /* Create vector */
+    nv = sunml_alloc_cnvec(0, payload);
+    if (nv == NULL) caml_raise_out_of_memory();
+    ops = (N_Vector_Ops) nv->ops;
+
+    /* Create vector operation structure */
+    ops->nvclone           = callml_vclone;
+    ops->nvcloneempty      = NULL;
+    ops->nvdestroy         = free_custom_cnvec;
+#if SUNDIALS_LIB_VERSION >= 270
+    ops->nvgetvectorid	   = getvectorid_custom;
+#endif
+
+    ops->nvspace = NULL;
+    if (HAS_OP(mlops, NVECTOR_OPS_NVSPACE))
+	ops->nvspace = callml_vspace;
+
+    ops->nvlinearsum       = callml_vlinearsum;
+    ops->nvconst           = callml_vconst;
+    ops->nvprod            = callml_vprod;
     ops->nvdiv             = callml_vdiv;
     ops->nvscale           = callml_vscale;
     ops->nvabs             = callml_vabs;
@@ -506,7 +1399,7 @@ CAMLprim value sunml_nvec_wrap_custom(value mlops, value payload, value checkfn)
 
     /* Create content */
     nv->content = (void *)mlops;
-    caml_register_generational_global_root((value *)&CNVEC_OP_TABLE(nv));
+    sunml_nvec_register_root((value *)&nv->content);
 
     vcnvec = caml_alloc_tuple(3);
     Store_field(vcnvec, 0, payload);
@@ -539,16 +1432,13 @@ N_Vector callml_vclone(N_Vector w)
     v_payload = r;
     /* Done processing r.  Now it's OK to trigger GC.  */
 
-    v = sunml_alloc_cnvec(0, v_payload);
+    v = sunml_clone_cnvec(0, v_payload, w);
     if (v == NULL)
 	CAMLreturnT (N_Vector, NULL);
 
-    /* Create vector operation structure */
-    sunml_clone_cnvec_ops(v, w);
-
     /* Create content */
     v->content = (void *) CNVEC_OP_TABLE(w);
-    caml_register_generational_global_root((value *)&CNVEC_OP_TABLE(v));
+    sunml_nvec_register_root((value *)&v->content);
 
     CAMLreturnT(N_Vector, v);
 }
@@ -1077,129 +1967,1260 @@ static int callml_vconstvectorarray(int nvec, realtype c, N_Vector* Z)
 
     if (nvec <= 0) CAMLreturnT(int, 1);
 
-    mlop = GET_SOME_OP(Z[0], NVECTOR_OPS_NVCONSTVECTORARRAY);
-    vc = caml_copy_double(c);
-    vz = wrap_to_nvector_table(nvec, Z);
+    mlop = GET_SOME_OP(Z[0], NVECTOR_OPS_NVCONSTVECTORARRAY);
+    vc = caml_copy_double(c);
+    vz = wrap_to_nvector_table(nvec, Z);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callback2_exn (mlop, vc, vz);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+					"user-defined n_vconstvectorarray");
+	CAMLreturnT(int, 0);
+    }
+    CAMLreturnT(int, 1);
+}
+#endif
+
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vwrmsnormvectorarray(int nvec, N_Vector* X,
+				       N_Vector* W, realtype* nrm)
+{
+    CAMLparam0();
+    CAMLlocal4(mlop, vx, vw, vnrm);
+    intnat n = nvec;
+
+    if (nvec <= 0) CAMLreturnT(int, 1);
+
+    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVWRMSNORMVECTORARRAY);
+    vx = wrap_to_nvector_table(nvec, X);
+    vw = wrap_to_nvector_table(nvec, W);
+    vnrm = caml_ba_alloc(BIGARRAY_FLOAT, 1, nrm, &n);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callback3_exn (mlop, vx, vw, vnrm);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+					"user-defined n_vwrmsnormvectorarray");
+	CAMLreturnT(int, 0);
+    }
+    CAMLreturnT(int, 1);
+}
+#endif
+
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vwrmsnormmaskvectorarray(int nvec, N_Vector* X, N_Vector* W,
+					   N_Vector id, realtype* nrm)
+{
+    CAMLparam0();
+    CAMLlocal1(mlop);
+    CAMLlocalN(args, 4);
+    intnat n = nvec;
+
+    if (nvec <= 0) CAMLreturnT(int, 1);
+
+    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVWRMSNORMMASKVECTORARRAY);
+    args[0] = wrap_to_nvector_table(nvec, X);
+    args[1] = wrap_to_nvector_table(nvec, W);
+    args[2] = NVEC_BACKLINK(id);
+    args[3] = caml_ba_alloc(BIGARRAY_FLOAT, 1, nrm, &n);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callbackN_exn (mlop, 4, args);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+				    "user-defined n_vwrmsnormmaskvectorarray");
+	CAMLreturnT(int, 0);
+    }
+    CAMLreturnT(int, 1);
+}
+#endif
+
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vscaleaddmultivectorarray(int nvec, int nsum, realtype* a,
+					       N_Vector* X, N_Vector** Y,
+					       N_Vector** Z)
+{
+    CAMLparam0();
+    CAMLlocal1(mlop);
+    CAMLlocalN(args, 4);
+    intnat n = nsum;
+
+    if (nvec <= 0) CAMLreturnT(int, 1);
+
+    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVSCALEADDMULTIVECTORARRAY);
+    args[0] = caml_ba_alloc(BIGARRAY_FLOAT, 1, a, &n);
+    args[1] = wrap_to_nvector_table(nvec, X);
+    args[2] = wrap_to_nvector_tables(nsum, nvec, Y);
+    args[3] = wrap_to_nvector_tables(nsum, nvec, Z);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callbackN_exn (mlop, 4, args);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+				    "user-defined n_vscaleaddmultivectorarray");
+	CAMLreturnT(int, 0);
+    }
+    CAMLreturnT(int, 1);
+}
+#endif
+
+#if 400 <= SUNDIALS_LIB_VERSION
+static int callml_vlinearcombinationvectorarray(int nvec, int nsum, realtype* c,
+						N_Vector** X, N_Vector* Z)
+{
+    CAMLparam0();
+    CAMLlocal4(mlop, vc, vxx, vz);
+    intnat n2 = nsum;
+
+    if ((nvec <= 0) || (nsum <= 0)) CAMLreturnT(int, 1);
+
+    mlop = GET_SOME_OP(Z[0], NVECTOR_OPS_NVLINEARCOMBINATIONVECTORARRAY);
+    vc = caml_ba_alloc(BIGARRAY_FLOAT, 1, c, &n2);
+    vxx = wrap_to_nvector_tables(nsum, nvec, X);
+    vz = wrap_to_nvector_table(nvec, Z);
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callback3_exn (mlop, vc, vxx, vz);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+			    "user-defined n_vlinearcombinationvectorarray");
+	CAMLreturnT(int, 0);
+    }
+    CAMLreturnT(int, 1);
+}
+#endif
+
+/** Layout nvectors * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* A layout nvector is a custom nvector whose payload describes, through a
+   Nvector_custom.segment array, the float Bigarray storage that holds its
+   elements.  The content field points to a struct layout_content whose
+   fields are registered as global roots.  The standard operations are
+   implemented by the C loops below, except for those selected in the mask
+   passed to sunml_nvec_wrap_custom_layout, which are forwarded to the OCaml
+   callbacks in the third component of shared exactly as for other custom
+   nvectors.  The fused and array operations are left to Sundials.
+
+   The loops never allocate in the OCaml heap, so the segments are read
+   directly without being registered as roots.  */
+
+/* Must match the fields of Nvector_custom.segment.  */
+enum layout_segment_index {
+    RECORD_LAYOUT_SEGMENT_DATA = 0,
+    RECORD_LAYOUT_SEGMENT_OFFSET,
+    RECORD_LAYOUT_SEGMENT_LENGTH,
+    RECORD_LAYOUT_SEGMENT_STRIDE,
+};
+
+/* Position within the segments of a layout nvector.  */
+struct layout_cursor {
+    value segs;
+    mlsize_t next, nsegs;
+    realtype *p;
+    intnat n, stride;
+};
+
+static void cursors_init(struct layout_cursor *c, int nc, ...)
+{
+    va_list ap;
+    int k;
+
+    va_start(ap, nc);
+    for (k = 0; k < nc; ++k) {
+	N_Vector v = va_arg(ap, N_Vector);
+	c[k].segs = LNVEC_CONTENT(v)->segments;
+	c[k].next = 0;
+	c[k].nsegs = Wosize_val(c[k].segs);
+	c[k].n = 0;
+    }
+    va_end(ap);
+}
+
+/* Returns the number of elements that can be visited in all of the vectors
+   before one of them moves to a new segment, or 0 at the end.  */
+static intnat cursors_chunk(struct layout_cursor *c, int nc)
+{
+    intnat m = 0;
+    int k;
+
+    for (k = 0; k < nc; ++k) {
+	while (c[k].n == 0) {
+	    value vs;
+	    if (c[k].next >= c[k].nsegs) return 0;
+	    vs = Field(c[k].segs, c[k].next++);
+	    c[k].p = REAL_ARRAY(Field(vs, RECORD_LAYOUT_SEGMENT_DATA))
+		     + Long_val(Field(vs, RECORD_LAYOUT_SEGMENT_OFFSET));
+	    c[k].n = Long_val(Field(vs, RECORD_LAYOUT_SEGMENT_LENGTH));
+	    c[k].stride = Long_val(Field(vs, RECORD_LAYOUT_SEGMENT_STRIDE));
+	}
+	if (k == 0 || c[k].n < m) m = c[k].n;
+    }
+    return m;
+}
+
+static void cursors_advance(struct layout_cursor *c, int nc, intnat m)
+{
+    int k;
+    for (k = 0; k < nc; ++k) {
+	c[k].p += m * c[k].stride;
+	c[k].n -= m;
+    }
+}
+
+/* Execute body for each element of nc vectors, accessed as EL(0), ... */
+#define LAYOUT_LOOP(nc, body)					\
+    do {							\
+	intnat m_, i_;						\
+	while ((m_ = cursors_chunk(c, (nc))) > 0) {		\
+	    for (i_ = 0; i_ < m_; ++i_) { body; }		\
+	    cursors_advance(c, (nc), m_);			\
+	}							\
+    } while (0)
+#define EL(k) (c[k].p[i_ * c[k].stride])
+
+static void layout_vlinearsum(realtype a, N_Vector x, realtype b, N_Vector y,
+			      N_Vector z)
+{
+    struct layout_cursor c[3];
+    cursors_init(c, 3, x, y, z);
+    LAYOUT_LOOP(3, EL(2) = a * EL(0) + b * EL(1));
+}
+
+static void layout_vconst(realtype a, N_Vector z)
+{
+    struct layout_cursor c[1];
+    cursors_init(c, 1, z);
+    LAYOUT_LOOP(1, EL(0) = a);
+}
+
+static void layout_vprod(N_Vector x, N_Vector y, N_Vector z)
+{
+    struct layout_cursor c[3];
+    cursors_init(c, 3, x, y, z);
+    LAYOUT_LOOP(3, EL(2) = EL(0) * EL(1));
+}
+
+static void layout_vdiv(N_Vector x, N_Vector y, N_Vector z)
+{
+    struct layout_cursor c[3];
+    cursors_init(c, 3, x, y, z);
+    LAYOUT_LOOP(3, EL(2) = EL(0) / EL(1));
+}
+
+static void layout_vscale(realtype a, N_Vector x, N_Vector z)
+{
+    struct layout_cursor c[2];
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, EL(1) = a * EL(0));
+}
+
+static void layout_vabs(N_Vector x, N_Vector z)
+{
+    struct layout_cursor c[2];
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, EL(1) = fabs(EL(0)));
+}
+
+static void layout_vinv(N_Vector x, N_Vector z)
+{
+    struct layout_cursor c[2];
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, EL(1) = 1.0 / EL(0));
+}
+
+static void layout_vaddconst(N_Vector x, realtype b, N_Vector z)
+{
+    struct layout_cursor c[2];
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, EL(1) = EL(0) + b);
+}
+
+static realtype layout_vdotprod(N_Vector x, N_Vector y)
+{
+    struct layout_cursor c[2];
+    realtype sum = 0.0;
+    cursors_init(c, 2, x, y);
+    LAYOUT_LOOP(2, sum += EL(0) * EL(1));
+    return sum;
+}
+
+static realtype layout_vmaxnorm(N_Vector x)
+{
+    struct layout_cursor c[1];
+    realtype max = 0.0;
+    cursors_init(c, 1, x);
+    LAYOUT_LOOP(1, if (fabs(EL(0)) > max) max = fabs(EL(0)));
+    return max;
+}
+
+static realtype layout_vwrmsnorm(N_Vector x, N_Vector w)
+{
+    struct layout_cursor c[2];
+    realtype sum = 0.0;
+    intnat n = 0;
+    cursors_init(c, 2, x, w);
+    LAYOUT_LOOP(2, realtype p = EL(0) * EL(1); sum += p * p; ++n);
+    return (n == 0) ? 0.0 : sqrt(sum / n);
+}
+
+static realtype layout_vwrmsnormmask(N_Vector x, N_Vector w, N_Vector id)
+{
+    struct layout_cursor c[3];
+    realtype sum = 0.0;
+    intnat n = 0;
+    cursors_init(c, 3, x, w, id);
+    LAYOUT_LOOP(3, if (EL(2) > 0.0) { realtype p = EL(0) * EL(1);
+				      sum += p * p; }
+		   ++n);
+    return (n == 0) ? 0.0 : sqrt(sum / n);
+}
+
+static realtype layout_vmin(N_Vector x)
+{
+    struct layout_cursor c[1];
+    realtype min = BIG_REAL;
+    cursors_init(c, 1, x);
+    LAYOUT_LOOP(1, if (EL(0) < min) min = EL(0));
+    return min;
+}
+
+static realtype layout_vwl2norm(N_Vector x, N_Vector w)
+{
+    struct layout_cursor c[2];
+    realtype sum = 0.0;
+    cursors_init(c, 2, x, w);
+    LAYOUT_LOOP(2, realtype p = EL(0) * EL(1); sum += p * p);
+    return sqrt(sum);
+}
+
+static realtype layout_vl1norm(N_Vector x)
+{
+    struct layout_cursor c[1];
+    realtype sum = 0.0;
+    cursors_init(c, 1, x);
+    LAYOUT_LOOP(1, sum += fabs(EL(0)));
+    return sum;
+}
+
+static void layout_vcompare(realtype a, N_Vector x, N_Vector z)
+{
+    struct layout_cursor c[2];
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, EL(1) = (fabs(EL(0)) >= a) ? 1.0 : 0.0);
+}
+
+static booleantype layout_vinvtest(N_Vector x, N_Vector z)
+{
+    struct layout_cursor c[2];
+    booleantype r = 1;
+    cursors_init(c, 2, x, z);
+    LAYOUT_LOOP(2, if (EL(0) == 0.0) r = 0; else EL(1) = 1.0 / EL(0));
+    return r;
+}
+
+/* As in the serial nvector: m(i) is set to 1 where the constraint c(i) on
+   x(i) fails.  */
+static booleantype layout_vconstrmask(N_Vector cv, N_Vector x, N_Vector m)
+{
+    struct layout_cursor c[3];
+    booleantype r = 1;
+    cursors_init(c, 3, cv, x, m);
+    LAYOUT_LOOP(3,
+	EL(2) = 0.0;
+	if (EL(0) == 0.0) continue;
+	if (EL(0) > 1.5 || EL(0) < -1.5) {
+	    if (EL(1) * EL(0) <= 0.0) { r = 0; EL(2) = 1.0; }
+	} else if (EL(1) * EL(0) < 0.0) { r = 0; EL(2) = 1.0; });
+    return r;
+}
+
+static realtype layout_vminquotient(N_Vector num, N_Vector denom)
+{
+    struct layout_cursor c[2];
+    realtype min = BIG_REAL;
+    cursors_init(c, 2, num, denom);
+    LAYOUT_LOOP(2, if (EL(1) != 0.0 && EL(0) / EL(1) < min)
+		       min = EL(0) / EL(1));
+    return min;
+}
+
+#undef EL
+#undef LAYOUT_LOOP
+
+static void layout_vspace(N_Vector v, sundials_ml_index *lrw,
+			  sundials_ml_index *liw)
+{
+    value segs = LNVEC_CONTENT(v)->segments;
+    mlsize_t i;
+
+    *lrw = 0;
+    for (i = 0; i < Wosize_val(segs); ++i)
+	*lrw += Long_val(Field(Field(segs, i), RECORD_LAYOUT_SEGMENT_LENGTH));
+    *liw = nvec_rough_size / sizeof(int);
+}
+
+static void free_layout_cnvec(N_Vector v)
+{
+    sunml_nvec_remove_root(&LNVEC_CONTENT(v)->shared);
+    sunml_nvec_remove_root(&LNVEC_CONTENT(v)->segments);
+    sunml_free_cnvec(v);
+}
+
+static void finalize_layout_caml_nvec(value vnv)
+{
+    free_layout_cnvec (NVEC_CVAL(vnv));
+}
+
+static N_Vector alloc_layout_cnvec(value payload, value shared, value segs)
+{
+    N_Vector nv = sunml_alloc_cnvec(sizeof(struct layout_content), payload);
+    if (nv == NULL) return NULL;
+
+    LNVEC_CONTENT(nv)->shared = shared;
+    LNVEC_CONTENT(nv)->segments = segs;
+    sunml_nvec_register_root(&LNVEC_CONTENT(nv)->shared);
+    sunml_nvec_register_root(&LNVEC_CONTENT(nv)->segments);
+
+    return nv;
+}
+
+static N_Vector layout_vclone(N_Vector w)
+{
+    CAMLparam0();
+    CAMLlocal3(shared, v_payload, segs);
+    N_Vector v;
+
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+    shared = LNVEC_CONTENT(w)->shared;
+
+    /* NB: Don't trigger GC while processing this return value!  */
+    value r = caml_callback_exn (Field(shared, 0), NVEC_BACKLINK(w));
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+				  "user-defined layout clone");
+	CAMLreturnT (N_Vector, NULL);
+    }
+    v_payload = r;
+
+    r = caml_callback_exn (Field(shared, 1), v_payload);
+    if (Is_exception_result (r)) {
+	sunml_warn_discarded_exn (Extract_exception (r),
+				  "user-defined layout");
+	CAMLreturnT (N_Vector, NULL);
+    }
+    segs = r;
+    /* Done processing r.  Now it's OK to trigger GC.  */
+
+    v = alloc_layout_cnvec(v_payload, shared, segs);
+    if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_clone_cnvec_ops(v, w);
+
+    CAMLreturnT(N_Vector, v);
+}
+
+#define OVERRIDE(mask, op) (Long_val(mask) & (1 << (op)))
+
+/* Creation from OCaml.  Bit i of vmask is set if the operation at index i
+   of enum nvector_ops_tag is to be forwarded to OCaml.  */
+CAMLprim value sunml_nvec_wrap_custom_layout(value vshared, value vmask,
+					     value payload, value vsegs,
+					     value checkfn)
+{
+    CAMLparam5(vshared, vmask, payload, vsegs, checkfn);
+    CAMLlocal1(vcnvec);
+
+    N_Vector nv;
+    N_Vector_Ops ops;
+
+    nv = alloc_layout_cnvec(payload, vshared, vsegs);
+    if (nv == NULL) caml_raise_out_of_memory();
+    ops = (N_Vector_Ops) nv->ops;
+
+    ops->nvclone           = layout_vclone;
+    ops->nvcloneempty      = NULL;
+    ops->nvdestroy         = free_layout_cnvec;
+#if SUNDIALS_LIB_VERSION >= 270
+    ops->nvgetvectorid	   = getvectorid_custom;
+#endif
+    ops->nvspace           = layout_vspace;
+    ops->nvgetarraypointer = NULL;
+    ops->nvsetarraypointer = NULL;
+
+#define SET_OP(field, tag, fn)						\
+    ops->field = OVERRIDE(vmask, NVECTOR_OPS_##tag) ? callml_##fn : layout_##fn
+    SET_OP(nvlinearsum,    NVLINEARSUM,    vlinearsum);
+    SET_OP(nvconst,        NVCONST,        vconst);
+    SET_OP(nvprod,         NVPROD,         vprod);
+    SET_OP(nvdiv,          NVDIV,          vdiv);
+    SET_OP(nvscale,        NVSCALE,        vscale);
+    SET_OP(nvabs,          NVABS,          vabs);
+    SET_OP(nvinv,          NVINV,          vinv);
+    SET_OP(nvaddconst,     NVADDCONST,     vaddconst);
+    SET_OP(nvmaxnorm,      NVMAXNORM,      vmaxnorm);
+    SET_OP(nvwrmsnorm,     NVWRMSNORM,     vwrmsnorm);
+    SET_OP(nvmin,          NVMIN,          vmin);
+    SET_OP(nvdotprod,      NVDOTPROD,      vdotprod);
+    SET_OP(nvcompare,      NVCOMPARE,      vcompare);
+    SET_OP(nvinvtest,      NVINVTEST,      vinvtest);
+    SET_OP(nvwl2norm,      NVWL2NORM,      vwl2norm);
+    SET_OP(nvl1norm,       NVL1NORM,       vl1norm);
+    SET_OP(nvwrmsnormmask, NVWRMSNORMMASK, vwrmsnormmask);
+    SET_OP(nvconstrmask,   NVCONSTRMASK,   vconstrmask);
+    SET_OP(nvminquotient,  NVMINQUOTIENT,  vminquotient);
+#undef SET_OP
+
+#if SUNDIALS_LIB_VERSION >= 400
+    /* fused vector operations */
+    ops->nvlinearcombination = NULL;
+    ops->nvscaleaddmulti     = NULL;
+    ops->nvdotprodmulti      = NULL;
+
+    /* vector array operations */
+    ops->nvlinearsumvectorarray         = NULL;
+    ops->nvscalevectorarray             = NULL;
+    ops->nvconstvectorarray             = NULL;
+    ops->nvwrmsnormvectorarray          = NULL;
+    ops->nvwrmsnormmaskvectorarray      = NULL;
+    ops->nvscaleaddmultivectorarray     = NULL;
+    ops->nvlinearcombinationvectorarray = NULL;
+#endif
+
+    vcnvec = caml_alloc_tuple(3);
+    Store_field(vcnvec, 0, payload);
+    Store_field(vcnvec, 1, sunml_alloc_caml_nvec(nv, finalize_layout_caml_nvec));
+    Store_field(vcnvec, 2, checkfn);
+
+    CAMLreturn(vcnvec);
+}
+
+/** Many-partition nvectors * * * * * * * * * * * * * * * * * * * * * * */
+
+/* The payload of a many-partition nvector is an array of Nvector_many.partition
+   values, each of which is a block containing an nvector triple.  The content
+   field points to a struct many_content followed by the N_Vectors of the
+   partitions and their lengths, which are cached when the vector is created.
+   The partitions are kept alive by the payload, which is registered as a
+   global root through the backlink.
+
+   The operations apply the corresponding operation of each partition.
+   Reductions are computed directly over the local elements of parallel
+   partitions, whose results are then combined with a single MPI_Allreduce
+   (see many_reduce) before being combined with those of the other
+   partitions, which are replicated on all processes.  The length of a
+   parallel partition is its local length; that of another partition is
+   its storage requirement in reals (N_VSpace).  The length of the whole
+   vector is the sum of the global lengths of its partitions.  */
+
+struct many_content {
+    int nparts;
+    int commpart;		/* first parallel partition, or -1 */
+    sundials_ml_index length;
+};
+
+#define MANY_CONTENT(v)   ((struct many_content *)(v)->content)
+#define MANY_NPARTS(v)    (MANY_CONTENT(v)->nparts)
+#define MANY_COMMPART(v)  (MANY_CONTENT(v)->commpart)
+#define MANY_LENGTH(v)    (MANY_CONTENT(v)->length)
+#define MANY_PARTS(v)     ((N_Vector *)(MANY_CONTENT(v) + 1))
+#define MANY_PART(v, k)   (MANY_PARTS(v)[k])
+#define MANY_PARTLEN(v, k) \
+    (((sundials_ml_index *)(MANY_PARTS(v) + MANY_NPARTS(v)))[k])
+
+#define MANY_PARTITION_NVEC(vp) (Field((vp), 0))
+
+static size_t many_content_size(int nparts)
+{
+    return sizeof(struct many_content)
+	   + nparts * (sizeof(N_Vector) + sizeof(sundials_ml_index));
+}
+
+/* Set once by sunml_nvector_parallel_init_module.  */
+static const struct sunml_many_parallel *many_parallel = NULL;
+
+void sunml_nvec_many_set_parallel(const struct sunml_many_parallel *p)
+{
+    many_parallel = p;
+}
+
+/* The local elements of partition k of v if it is parallel, or NULL.  */
+static realtype *many_local(N_Vector v, int k)
+{
+    sundials_ml_index loclen, globlen;
+
+    return (MANY_COMMPART(v) < 0) ? NULL
+	   : many_parallel->local(MANY_PART(v, k), &loclen, &globlen);
+}
+
+/* Combines par, the result for the local elements of the parallel
+   partitions, over their communicator, and then with rep, the result for
+   the other partitions.  */
+static realtype many_reduce(N_Vector x, realtype par, realtype rep,
+			    enum sunml_many_reduce op)
+{
+    if (MANY_COMMPART(x) >= 0)
+	par = many_parallel->allreduce(MANY_PART(x, MANY_COMMPART(x)), par, op);
+
+    switch (op) {
+    case SUNML_MANY_SUM:
+	return par + rep;
+    case SUNML_MANY_MAX:
+	return (par > rep) ? par : rep;
+    default:
+	return (par < rep) ? par : rep;
+    }
+}
+
+static void many_vlinearsum(realtype a, N_Vector x, realtype b, N_Vector y,
+			    N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VLinearSum(a, MANY_PART(x, k), b, MANY_PART(y, k), MANY_PART(z, k));
+}
+
+static void many_vconst(realtype c, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(z); ++k)
+	N_VConst(c, MANY_PART(z, k));
+}
+
+static void many_vprod(N_Vector x, N_Vector y, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VProd(MANY_PART(x, k), MANY_PART(y, k), MANY_PART(z, k));
+}
+
+static void many_vdiv(N_Vector x, N_Vector y, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VDiv(MANY_PART(x, k), MANY_PART(y, k), MANY_PART(z, k));
+}
+
+static void many_vscale(realtype c, N_Vector x, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VScale(c, MANY_PART(x, k), MANY_PART(z, k));
+}
+
+static void many_vabs(N_Vector x, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VAbs(MANY_PART(x, k), MANY_PART(z, k));
+}
+
+static void many_vinv(N_Vector x, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VInv(MANY_PART(x, k), MANY_PART(z, k));
+}
+
+static void many_vaddconst(N_Vector x, realtype b, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VAddConst(MANY_PART(x, k), b, MANY_PART(z, k));
+}
+
+static void many_vcompare(realtype c, N_Vector x, N_Vector z)
+{
+    int k;
+    for (k = 0; k < MANY_NPARTS(x); ++k)
+	N_VCompare(c, MANY_PART(x, k), MANY_PART(z, k));
+}
+
+static realtype many_vdotprod(N_Vector x, N_Vector y)
+{
+    realtype par = 0.0, rep = 0.0, *xd, *yd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	if ((xd = many_local(x, k)) != NULL) {
+	    yd = many_local(y, k);
+	    n = MANY_PARTLEN(x, k);
+	    for (i = 0; i < n; ++i) par += xd[i] * yd[i];
+	} else
+	    rep += N_VDotProd(MANY_PART(x, k), MANY_PART(y, k));
+    }
+    return many_reduce(x, par, rep, SUNML_MANY_SUM);
+}
+
+static realtype many_vmaxnorm(N_Vector x)
+{
+    realtype par = 0.0, rep = 0.0, m, *xd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	n = MANY_PARTLEN(x, k);
+	if ((xd = many_local(x, k)) != NULL) {
+	    for (i = 0; i < n; ++i)
+		if (fabs(xd[i]) > par) par = fabs(xd[i]);
+	} else if (n > 0) {
+	    m = N_VMaxNorm(MANY_PART(x, k));
+	    if (m > rep) rep = m;
+	}
+    }
+    return many_reduce(x, par, rep, SUNML_MANY_MAX);
+}
+
+/* The wrms norm of each replicated partition is scaled back to a sum of
+   squares.  */
+static realtype many_vwrmsnorm(N_Vector x, N_Vector w)
+{
+    realtype par = 0.0, rep = 0.0, m, *xd, *wd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	n = MANY_PARTLEN(x, k);
+	if ((xd = many_local(x, k)) != NULL) {
+	    wd = many_local(w, k);
+	    for (i = 0; i < n; ++i) {
+		m = xd[i] * wd[i];
+		par += m * m;
+	    }
+	} else if (n > 0) {
+	    m = N_VWrmsNorm(MANY_PART(x, k), MANY_PART(w, k));
+	    rep += m * m * n;
+	}
+    }
+    m = many_reduce(x, par, rep, SUNML_MANY_SUM);
+    return (MANY_LENGTH(x) == 0) ? 0.0 : sqrt(m / MANY_LENGTH(x));
+}
+
+static realtype many_vwrmsnormmask(N_Vector x, N_Vector w, N_Vector id)
+{
+    realtype par = 0.0, rep = 0.0, m, *xd, *wd, *idd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	n = MANY_PARTLEN(x, k);
+	if ((xd = many_local(x, k)) != NULL) {
+	    wd = many_local(w, k);
+	    idd = many_local(id, k);
+	    for (i = 0; i < n; ++i) {
+		if (idd[i] <= 0.0) continue;
+		m = xd[i] * wd[i];
+		par += m * m;
+	    }
+	} else if (n > 0) {
+	    m = N_VWrmsNormMask(MANY_PART(x, k), MANY_PART(w, k),
+				MANY_PART(id, k));
+	    rep += m * m * n;
+	}
+    }
+    m = many_reduce(x, par, rep, SUNML_MANY_SUM);
+    return (MANY_LENGTH(x) == 0) ? 0.0 : sqrt(m / MANY_LENGTH(x));
+}
+
+static realtype many_vmin(N_Vector x)
+{
+    realtype par = BIG_REAL, rep = BIG_REAL, m, *xd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	n = MANY_PARTLEN(x, k);
+	if ((xd = many_local(x, k)) != NULL) {
+	    for (i = 0; i < n; ++i)
+		if (xd[i] < par) par = xd[i];
+	} else if (n > 0) {
+	    m = N_VMin(MANY_PART(x, k));
+	    if (m < rep) rep = m;
+	}
+    }
+    return many_reduce(x, par, rep, SUNML_MANY_MIN);
+}
+
+static realtype many_vwl2norm(N_Vector x, N_Vector w)
+{
+    realtype par = 0.0, rep = 0.0, m, *xd, *wd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	if ((xd = many_local(x, k)) != NULL) {
+	    wd = many_local(w, k);
+	    n = MANY_PARTLEN(x, k);
+	    for (i = 0; i < n; ++i) {
+		m = xd[i] * wd[i];
+		par += m * m;
+	    }
+	} else {
+	    m = N_VWL2Norm(MANY_PART(x, k), MANY_PART(w, k));
+	    rep += m * m;
+	}
+    }
+    return sqrt(many_reduce(x, par, rep, SUNML_MANY_SUM));
+}
+
+static realtype many_vl1norm(N_Vector x)
+{
+    realtype par = 0.0, rep = 0.0, *xd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	if ((xd = many_local(x, k)) != NULL) {
+	    n = MANY_PARTLEN(x, k);
+	    for (i = 0; i < n; ++i) par += fabs(xd[i]);
+	} else
+	    rep += N_VL1Norm(MANY_PART(x, k));
+    }
+    return many_reduce(x, par, rep, SUNML_MANY_SUM);
+}
+
+/* The boolean reductions combine 1.0 (true) and 0.0 (false).  */
+static booleantype many_vinvtest(N_Vector x, N_Vector z)
+{
+    realtype par = 1.0, rep = 1.0, *xd, *zd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	if ((xd = many_local(x, k)) != NULL) {
+	    zd = many_local(z, k);
+	    n = MANY_PARTLEN(x, k);
+	    for (i = 0; i < n; ++i) {
+		if (xd[i] == 0.0) par = 0.0;
+		else zd[i] = 1.0 / xd[i];
+	    }
+	} else if (!N_VInvTest(MANY_PART(x, k), MANY_PART(z, k)))
+	    rep = 0.0;
+    }
+    return (many_reduce(x, par, rep, SUNML_MANY_MIN) == 1.0);
+}
+
+static booleantype many_vconstrmask(N_Vector c, N_Vector x, N_Vector m)
+{
+    realtype par = 1.0, rep = 1.0, *cd, *xd, *md;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(x); ++k) {
+	if ((xd = many_local(x, k)) != NULL) {
+	    cd = many_local(c, k);
+	    md = many_local(m, k);
+	    n = MANY_PARTLEN(x, k);
+	    for (i = 0; i < n; ++i) {
+		md[i] = 0.0;
+		if (cd[i] == 0.0) continue;
+		if ((fabs(cd[i]) > 1.5 && xd[i] * cd[i] <= 0.0)
+			|| (fabs(cd[i]) > 0.5 && xd[i] * cd[i] < 0.0)) {
+		    par = 0.0;
+		    md[i] = 1.0;
+		}
+	    }
+	} else if (!N_VConstrMask(MANY_PART(c, k), MANY_PART(x, k),
+				  MANY_PART(m, k)))
+	    rep = 0.0;
+    }
+    return (many_reduce(x, par, rep, SUNML_MANY_MIN) == 1.0);
+}
+
+static realtype many_vminquotient(N_Vector num, N_Vector denom)
+{
+    realtype par = BIG_REAL, rep = BIG_REAL, m, *nd, *dd;
+    sundials_ml_index i, n;
+    int k;
+
+    for (k = 0; k < MANY_NPARTS(num); ++k) {
+	n = MANY_PARTLEN(num, k);
+	if ((nd = many_local(num, k)) != NULL) {
+	    dd = many_local(denom, k);
+	    for (i = 0; i < n; ++i)
+		if (dd[i] != 0.0 && nd[i] / dd[i] < par) par = nd[i] / dd[i];
+	} else if (n > 0) {
+	    m = N_VMinQuotient(MANY_PART(num, k), MANY_PART(denom, k));
+	    if (m < rep) rep = m;
+	}
+    }
+    return many_reduce(num, par, rep, SUNML_MANY_MIN);
+}
+
+static void many_vspace(N_Vector v, sundials_ml_index *lrw,
+			sundials_ml_index *liw)
+{
+    sundials_ml_index r, i;
+    int k;
+
+    *lrw = 0;
+    *liw = nvec_rough_size / sizeof(int);
+    for (k = 0; k < MANY_NPARTS(v); ++k) {
+	N_VSpace(MANY_PART(v, k), &r, &i);
+	*lrw += r;
+	*liw += i;
+    }
+}
+
+/* Partitions cloned from C are owned by the OCaml values created for them in
+   many_vclone.  */
+static void finalize_many_partition(value vnv)
+{
+    N_VDestroy(NVEC_CVAL(vnv));
+}
+
+static N_Vector many_vclone(N_Vector w)
+{
+    CAMLparam0();
+    CAMLlocal4(w_payload, v_payload, vnvec, vpart);
+    N_Vector v, p;
+    int k, nparts;
+
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+    w_payload = NVEC_BACKLINK(w);
+    nparts = MANY_NPARTS(w);
+
+    v_payload = caml_alloc_tuple(nparts);
+    v = sunml_clone_cnvec(many_content_size(nparts), v_payload, w);
+    if (v == NULL) CAMLreturnT(N_Vector, NULL);
+    MANY_NPARTS(v) = nparts;
+    MANY_COMMPART(v) = MANY_COMMPART(w);
+    MANY_LENGTH(v) = MANY_LENGTH(w);
+
+    for (k = 0; k < nparts; ++k) {
+	p = N_VClone(MANY_PART(w, k));
+	if (p == NULL) {
+	    /* The partitions already cloned are reclaimed by the GC.  */
+	    sunml_free_cnvec(v);
+	    CAMLreturnT(N_Vector, NULL);
+	}
+	MANY_PART(v, k) = p;
+	MANY_PARTLEN(v, k) = MANY_PARTLEN(w, k);
+
+	vnvec = caml_alloc_tuple(3);
+	Store_field(vnvec, 0, NVEC_BACKLINK(p));
+	Store_field(vnvec, 1, sunml_alloc_caml_nvec(p, finalize_many_partition));
+	Store_field(vnvec, 2,
+		    Field(MANY_PARTITION_NVEC(Field(w_payload, k)), 2));
+
+	vpart = caml_alloc_tuple(1);
+	Store_field(vpart, 0, vnvec);
+	Store_field(v_payload, k, vpart);
+    }
+
+    CAMLreturnT(N_Vector, v);
+}
+
+/* Creation from OCaml.  */
+CAMLprim value sunml_nvec_wrap_many(value payload, value checkfn)
+{
+    CAMLparam2(payload, checkfn);
+    CAMLlocal1(vnvec);
+
+    N_Vector nv, p, commp = NULL;
+    N_Vector_Ops ops;
+    int k, nparts = Wosize_val(payload);
+    sundials_ml_index lrw, liw, loclen, globlen;
+
+    for (k = 0; k < nparts; ++k) {
+	p = NVEC_VAL(MANY_PARTITION_NVEC(Field(payload, k)));
+	if (many_parallel != NULL
+		&& many_parallel->local(p, &loclen, &globlen) != NULL) {
+	    if (commp == NULL)
+		commp = p;
+	    else if (!many_parallel->same_comm(commp, p))
+		caml_invalid_argument("Nvector_many.wrap: "
+				      "communicators differ");
+	} else if (p->ops->nvspace == NULL)
+	    caml_invalid_argument("Nvector_many.wrap: n_vspace is required");
+    }
+
+    nv = sunml_alloc_cnvec(many_content_size(nparts), payload);
+    if (nv == NULL) caml_raise_out_of_memory();
+    ops = (N_Vector_Ops) nv->ops;
+
+    MANY_NPARTS(nv) = nparts;
+    MANY_COMMPART(nv) = -1;
+    MANY_LENGTH(nv) = 0;
+    for (k = 0; k < nparts; ++k) {
+	p = NVEC_VAL(MANY_PARTITION_NVEC(Field(payload, k)));
+	MANY_PART(nv, k) = p;
+	if (many_parallel != NULL
+		&& many_parallel->local(p, &loclen, &globlen) != NULL) {
+	    if (MANY_COMMPART(nv) < 0) MANY_COMMPART(nv) = k;
+	    MANY_PARTLEN(nv, k) = loclen;
+	    MANY_LENGTH(nv) += globlen;
+	} else {
+	    N_VSpace(p, &lrw, &liw);
+	    MANY_PARTLEN(nv, k) = lrw;
+	    MANY_LENGTH(nv) += lrw;
+	}
+    }
+
+    ops->nvclone           = many_vclone;
+    ops->nvcloneempty      = NULL;
+    ops->nvdestroy         = sunml_free_cnvec;
+#if SUNDIALS_LIB_VERSION >= 270
+    ops->nvgetvectorid	   = getvectorid_custom;
+#endif
+    ops->nvspace           = many_vspace;
+    ops->nvgetarraypointer = NULL;
+    ops->nvsetarraypointer = NULL;
+    ops->nvlinearsum       = many_vlinearsum;
+    ops->nvconst           = many_vconst;
+    ops->nvprod            = many_vprod;
+    ops->nvdiv             = many_vdiv;
+    ops->nvscale           = many_vscale;
+    ops->nvabs             = many_vabs;
+    ops->nvinv             = many_vinv;
+    ops->nvaddconst        = many_vaddconst;
+    ops->nvdotprod         = many_vdotprod;
+    ops->nvmaxnorm         = many_vmaxnorm;
+    ops->nvwrmsnormmask    = many_vwrmsnormmask;
+    ops->nvwrmsnorm        = many_vwrmsnorm;
+    ops->nvmin             = many_vmin;
+    ops->nvwl2norm         = many_vwl2norm;
+    ops->nvl1norm          = many_vl1norm;
+    ops->nvcompare         = many_vcompare;
+    ops->nvinvtest         = many_vinvtest;
+    ops->nvconstrmask      = many_vconstrmask;
+    ops->nvminquotient     = many_vminquotient;
+
+#if SUNDIALS_LIB_VERSION >= 400
+    /* fused and array operations use the Sundials defaults */
+    ops->nvlinearcombination = NULL;
+    ops->nvscaleaddmulti     = NULL;
+    ops->nvdotprodmulti      = NULL;
+
+    ops->nvlinearsumvectorarray         = NULL;
+    ops->nvscalevectorarray             = NULL;
+    ops->nvconstvectorarray             = NULL;
+    ops->nvwrmsnormvectorarray          = NULL;
+    ops->nvwrmsnormmaskvectorarray      = NULL;
+    ops->nvscaleaddmultivectorarray     = NULL;
+    ops->nvlinearcombinationvectorarray = NULL;
+#endif
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+/* Two arrays of partitions are compatible if they have the same number of
+   partitions and if these are pairwise compatible.  */
+CAMLprim value sunml_nvec_many_check(value vparts1, value vparts2)
+{
+    CAMLparam2(vparts1, vparts2);
+    CAMLlocal3(vnv1, vnv2, r);
+    mlsize_t k, nparts = Wosize_val(vparts1);
+
+    if (Wosize_val(vparts2) != nparts) CAMLreturn(Val_false);
+
+    for (k = 0; k < nparts; ++k) {
+	vnv1 = MANY_PARTITION_NVEC(Field(vparts1, k));
+	vnv2 = MANY_PARTITION_NVEC(Field(vparts2, k));
+#if SUNDIALS_LIB_VERSION >= 270
+	if (N_VGetVectorID(NVEC_VAL(vnv1)) != N_VGetVectorID(NVEC_VAL(vnv2)))
+	    CAMLreturn(Val_false);
+#endif
+	r = caml_callback(Field(vnv1, 2), Field(vnv2, 0));
+	if (!Bool_val(r)) CAMLreturn(Val_false);
+    }
+
+    CAMLreturn(Val_true);
+}
+
+/* The local elements of serial, OpenMP, Pthreads, and parallel nvectors.  */
+CAMLprim value sunml_nvec_many_local_array(value vpart)
+{
+    CAMLparam1(vpart);
+    CAMLlocal2(vnv, r);
+#if SUNDIALS_LIB_VERSION >= 290
+    vnv = MANY_PARTITION_NVEC(vpart);
+
+    switch (N_VGetVectorID(NVEC_VAL(vnv))) {
+    case SUNDIALS_NVEC_SERIAL:
+    case SUNDIALS_NVEC_OPENMP:
+    case SUNDIALS_NVEC_PTHREADS:
+	r = Field(vnv, 0);
+	break;
+
+    case SUNDIALS_NVEC_PARALLEL:
+	r = Field(Field(vnv, 0), 0);
+	break;
+
+    default:
+	caml_invalid_argument("Nvector_many.local_array");
+    }
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn(r);
+}
+
+/* Operations from OCaml.  */
+
+CAMLprim value sunml_nvec_many_n_vclone(value vx)
+{
+    CAMLparam1(vx);
+    CAMLlocal1(vnvec);
+    N_Vector v = many_vclone(NVEC_VAL(vx));
+
+    if (v == NULL) caml_raise_out_of_memory();
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, NVEC_BACKLINK(v));
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(v, sunml_finalize_caml_nvec));
+    Store_field(vnvec, 2, Field(vx, 2));
+
+    CAMLreturn(vnvec);
+}
+
+CAMLprim value sunml_nvec_many_n_vlinearsum(value va, value vx, value vb,
+					    value vy, value vz)
+{
+    CAMLparam5(va, vx, vb, vy, vz);
+    many_vlinearsum(Double_val(va), NVEC_VAL(vx), Double_val(vb),
+		    NVEC_VAL(vy), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_many_n_vconst(value vc, value vz)
+{
+    CAMLparam2(vc, vz);
+    many_vconst(Double_val(vc), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_many_n_vprod(value vx, value vy, value vz)
+{
+    CAMLparam3(vx, vy, vz);
+    many_vprod(NVEC_VAL(vx), NVEC_VAL(vy), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_many_n_vdiv(value vx, value vy, value vz)
+{
+    CAMLparam3(vx, vy, vz);
+    many_vdiv(NVEC_VAL(vx), NVEC_VAL(vy), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_many_n_vscale(value vc, value vx, value vz)
+{
+    CAMLparam3(vc, vx, vz);
+    many_vscale(Double_val(vc), NVEC_VAL(vx), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value sunml_nvec_many_n_vabs(value vx, value vz)
+{
+    CAMLparam2(vx, vz);
+    many_vabs(NVEC_VAL(vx), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
 
-    /* NB: Don't trigger GC while processing this return value!  */
-    value r = caml_callback2_exn (mlop, vc, vz);
-    if (Is_exception_result (r)) {
-	sunml_warn_discarded_exn (Extract_exception (r),
-					"user-defined n_vconstvectorarray");
-	CAMLreturnT(int, 0);
-    }
-    CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vinv(value vx, value vz)
+{
+    CAMLparam2(vx, vz);
+    many_vinv(NVEC_VAL(vx), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
 }
-#endif
 
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vwrmsnormvectorarray(int nvec, N_Vector* X,
-				       N_Vector* W, realtype* nrm)
+CAMLprim value sunml_nvec_many_n_vaddconst(value vx, value vb, value vz)
 {
-    CAMLparam0();
-    CAMLlocal4(mlop, vx, vw, vnrm);
-    intnat n = nvec;
+    CAMLparam3(vx, vb, vz);
+    many_vaddconst(NVEC_VAL(vx), Double_val(vb), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
 
-    if (nvec <= 0) CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vdotprod(value vx, value vy)
+{
+    CAMLparam2(vx, vy);
+    CAMLreturn(caml_copy_double(many_vdotprod(NVEC_VAL(vx), NVEC_VAL(vy))));
+}
 
-    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVWRMSNORMVECTORARRAY);
-    vx = wrap_to_nvector_table(nvec, X);
-    vw = wrap_to_nvector_table(nvec, W);
-    vnrm = caml_ba_alloc(BIGARRAY_FLOAT, 1, nrm, &n);
+CAMLprim value sunml_nvec_many_n_vmaxnorm(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(many_vmaxnorm(NVEC_VAL(vx))));
+}
 
-    /* NB: Don't trigger GC while processing this return value!  */
-    value r = caml_callback3_exn (mlop, vx, vw, vnrm);
-    if (Is_exception_result (r)) {
-	sunml_warn_discarded_exn (Extract_exception (r),
-					"user-defined n_vwrmsnormvectorarray");
-	CAMLreturnT(int, 0);
-    }
-    CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vwrmsnorm(value vx, value vw)
+{
+    CAMLparam2(vx, vw);
+    CAMLreturn(caml_copy_double(many_vwrmsnorm(NVEC_VAL(vx), NVEC_VAL(vw))));
 }
-#endif
 
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vwrmsnormmaskvectorarray(int nvec, N_Vector* X, N_Vector* W,
-					   N_Vector id, realtype* nrm)
+CAMLprim value sunml_nvec_many_n_vwrmsnormmask(value vx, value vw, value vid)
 {
-    CAMLparam0();
-    CAMLlocal1(mlop);
-    CAMLlocalN(args, 4);
-    intnat n = nvec;
+    CAMLparam3(vx, vw, vid);
+    CAMLreturn(caml_copy_double(many_vwrmsnormmask(NVEC_VAL(vx), NVEC_VAL(vw),
+						   NVEC_VAL(vid))));
+}
 
-    if (nvec <= 0) CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vmin(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(many_vmin(NVEC_VAL(vx))));
+}
 
-    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVWRMSNORMMASKVECTORARRAY);
-    args[0] = wrap_to_nvector_table(nvec, X);
-    args[1] = wrap_to_nvector_table(nvec, W);
-    args[2] = NVEC_BACKLINK(id);
-    args[3] = caml_ba_alloc(BIGARRAY_FLOAT, 1, nrm, &n);
+CAMLprim value sunml_nvec_many_n_vwl2norm(value vx, value vw)
+{
+    CAMLparam2(vx, vw);
+    CAMLreturn(caml_copy_double(many_vwl2norm(NVEC_VAL(vx), NVEC_VAL(vw))));
+}
 
-    /* NB: Don't trigger GC while processing this return value!  */
-    value r = caml_callbackN_exn (mlop, 4, args);
-    if (Is_exception_result (r)) {
-	sunml_warn_discarded_exn (Extract_exception (r),
-				    "user-defined n_vwrmsnormmaskvectorarray");
-	CAMLreturnT(int, 0);
-    }
-    CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vl1norm(value vx)
+{
+    CAMLparam1(vx);
+    CAMLreturn(caml_copy_double(many_vl1norm(NVEC_VAL(vx))));
 }
-#endif
 
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vscaleaddmultivectorarray(int nvec, int nsum, realtype* a,
-					       N_Vector* X, N_Vector** Y,
-					       N_Vector** Z)
+CAMLprim value sunml_nvec_many_n_vcompare(value vc, value vx, value vz)
 {
-    CAMLparam0();
-    CAMLlocal1(mlop);
-    CAMLlocalN(args, 4);
-    intnat n = nsum;
+    CAMLparam3(vc, vx, vz);
+    many_vcompare(Double_val(vc), NVEC_VAL(vx), NVEC_VAL(vz));
+    CAMLreturn(Val_unit);
+}
 
-    if (nvec <= 0) CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vinvtest(value vx, value vz)
+{
+    CAMLparam2(vx, vz);
+    CAMLreturn(Val_bool(many_vinvtest(NVEC_VAL(vx), NVEC_VAL(vz))));
+}
 
-    mlop = GET_SOME_OP(X[0], NVECTOR_OPS_NVSCALEADDMULTIVECTORARRAY);
-    args[0] = caml_ba_alloc(BIGARRAY_FLOAT, 1, a, &n);
-    args[1] = wrap_to_nvector_table(nvec, X);
-    args[2] = wrap_to_nvector_tables(nsum, nvec, Y);
-    args[3] = wrap_to_nvector_tables(nsum, nvec, Z);
+CAMLprim value sunml_nvec_many_n_vconstrmask(value vc, value vx, value vm)
+{
+    CAMLparam3(vc, vx, vm);
+    CAMLreturn(Val_bool(many_vconstrmask(NVEC_VAL(vc), NVEC_VAL(vx),
+					 NVEC_VAL(vm))));
+}
 
-    /* NB: Don't trigger GC while processing this return value!  */
-    value r = caml_callbackN_exn (mlop, 4, args);
-    if (Is_exception_result (r)) {
-	sunml_warn_discarded_exn (Extract_exception (r),
-				    "user-defined n_vscaleaddmultivectorarray");
-	CAMLreturnT(int, 0);
-    }
-    CAMLreturnT(int, 1);
+CAMLprim value sunml_nvec_many_n_vminquotient(value vnum, value vdenom)
+{
+    CAMLparam2(vnum, vdenom);
+    CAMLreturn(caml_copy_double(many_vminquotient(NVEC_VAL(vnum),
+						  NVEC_VAL(vdenom))));
 }
-#endif
 
-#if 400 <= SUNDIALS_LIB_VERSION
-static int callml_vlinearcombinationvectorarray(int nvec, int nsum, realtype* c,
-						N_Vector** X, N_Vector* Z)
+CAMLprim value sunml_nvec_many_n_vspace(value vx)
 {
-    CAMLparam0();
-    CAMLlocal4(mlop, vc, vxx, vz);
-    intnat n2 = nsum;
+    CAMLparam1(vx);
+    CAMLlocal1(r);
+    sundials_ml_index lrw, liw;
 
-    if ((nvec <= 0) || (nsum <= 0)) CAMLreturnT(int, 1);
+    many_vspace(NVEC_VAL(vx), &lrw, &liw);
 
-    mlop = GET_SOME_OP(Z[0], NVECTOR_OPS_NVLINEARCOMBINATIONVECTORARRAY);
-    vc = caml_ba_alloc(BIGARRAY_FLOAT, 1, c, &n2);
-    vxx = wrap_to_nvector_tables(nsum, nvec, X);
-    vz = wrap_to_nvector_table(nvec, Z);
+    r = caml_alloc_tuple(2);
+    Store_field(r, 0, Val_index(lrw));
+    Store_field(r, 1, Val_index(liw));
 
-    /* NB: Don't trigger GC while processing this return value!  */
-    value r = caml_callback3_exn (mlop, vc, vxx, vz);
-    if (Is_exception_result (r)) {
-	sunml_warn_discarded_exn (Extract_exception (r),
-			    "user-defined n_vlinearcombinationvectorarray");
-	CAMLreturnT(int, 0);
-    }
-    CAMLreturnT(int, 1);
+    CAMLreturn(r);
 }
-#endif
 
 /** Interface to underlying serial nvector functions */
 
@@ -1462,6 +3483,52 @@ CAMLprim value sunml_nvec_ser_n_vminquotient(value vnum, value vdenom)
     CAMLreturn(caml_copy_double(r));
 }
 
+/* Native-code entry points for the reductions above.  They neither
+ * allocate nor raise, and are declared [@@noalloc] with unboxed results;
+ * the lengths are checked on the OCaml side (see Nvector_serial.Ops).  */
+
+CAMLprim double sunml_nvec_ser_n_vdotprod_unboxed(value vx, value vy)
+{
+    return N_VDotProd_Serial(NVEC_VAL(vx), NVEC_VAL(vy));
+}
+
+CAMLprim double sunml_nvec_ser_n_vmaxnorm_unboxed(value vx)
+{
+    return N_VMaxNorm_Serial(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_ser_n_vwrmsnorm_unboxed(value vx, value vw)
+{
+    return N_VWrmsNorm_Serial(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_ser_n_vwrmsnormmask_unboxed(value vx, value vw,
+						       value vid)
+{
+    return N_VWrmsNormMask_Serial(NVEC_VAL(vx), NVEC_VAL(vw),
+				  NVEC_VAL(vid));
+}
+
+CAMLprim double sunml_nvec_ser_n_vmin_unboxed(value vx)
+{
+    return N_VMin_Serial(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_ser_n_vwl2norm_unboxed(value vx, value vw)
+{
+    return N_VWL2Norm_Serial(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_ser_n_vl1norm_unboxed(value vx)
+{
+    return N_VL1Norm_Serial(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_ser_n_vminquotient_unboxed(value vnum, value vdenom)
+{
+    return N_VMinQuotient_Serial(NVEC_VAL(vnum), NVEC_VAL(vdenom));
+}
+
 CAMLprim value sunml_nvec_ser_n_vspace(value vx)
 {
     CAMLparam1(vx);
@@ -1869,7 +3936,8 @@ CAMLprim value sunml_nvec_ser_enablefusedops(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableFusedOps_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableFusedOps_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1880,7 +3948,8 @@ CAMLprim value sunml_nvec_ser_enablelinearcombination(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombination_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombination_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1891,7 +3960,8 @@ CAMLprim value sunml_nvec_ser_enablescaleaddmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMulti_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMulti_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1902,7 +3972,8 @@ CAMLprim value sunml_nvec_ser_enabledotprodmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableDotProdMulti_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableDotProdMulti_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1913,7 +3984,8 @@ CAMLprim value sunml_nvec_ser_enablelinearsumvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearSumVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearSumVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1924,7 +3996,8 @@ CAMLprim value sunml_nvec_ser_enablescalevectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1935,7 +4008,8 @@ CAMLprim value sunml_nvec_ser_enableconstvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableConstVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableConstVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1946,7 +4020,8 @@ CAMLprim value sunml_nvec_ser_enablewrmsnormvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1957,7 +4032,8 @@ CAMLprim value sunml_nvec_ser_enablewrmsnormmaskvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormMaskVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormMaskVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1968,7 +4044,8 @@ CAMLprim value sunml_nvec_ser_enablescaleaddmultivectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMultiVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMultiVectorArray_Serial(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1979,7 +4056,248 @@ CAMLprim value sunml_nvec_ser_enablelinearcombinationvectorarray(value vx, value
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombinationVectorArray_Serial(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombinationVectorArray_Serial(x, Bool_val(vv));
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
+
+/** Multi-vector kernels for serial nvectors */
+
+/* Replacements for five of the Sundials fused and array operations on
+   serial nvectors.  Each one makes a single pass over its operands, working
+   through blocks of SIMD_BLOCK elements so that the shared operand stays in
+   the L1 cache, and accumulates reductions in SIMD_LANES independent partial
+   sums so that the compiler can vectorize them without reassociating.
+
+   Where the compiler supports it, each kernel is compiled for AVX-512, AVX2
+   and the baseline instruction set, and the best version for the running
+   processor is selected when the library is loaded.  On AArch64, NEON is part
+   of the baseline and no dispatch is necessary.  */
+
+#if 400 <= SUNDIALS_LIB_VERSION
+
+#define SIMD_BLOCK 512
+#define SIMD_LANES 8
+
+#if defined(__has_attribute)
+#if __has_attribute(target_clones) \
+    && (defined(__x86_64__) || defined(__i386__)) && defined(__linux__)
+#define SIMD_DISPATCH \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef SIMD_DISPATCH
+#define SIMD_DISPATCH
+#endif
+
+#define SIMD_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* Linear combinations of at most SIMD_FIXED_MAX vectors, like those that
+   form the stages, the solution, and the error estimate of an explicit
+   Runge-Kutta method with up to seven stages (Dormand-Prince,
+   Bogacki-Shampine, etc.), are computed by kernels specialized for the
+   number of vectors.  Each element is then summed in a register, and each
+   operand is read once and z written once, without going through an
+   accumulator block.  Each element is computed from all of its operands
+   before it is stored, so z may be one of the X[j].  */
+#define SIMD_FIXED_MAX 8
+
+static inline void simd_linearcombination_fixed(const int nvec,
+						sundials_ml_index n,
+						realtype *c, realtype **xd,
+						realtype *zd)
+{
+    sundials_ml_index i;
+    int j;
+
+    for (i = 0; i < n; ++i) {
+	realtype s = c[0] * xd[0][i];
+	for (j = 1; j < nvec; ++j) s += c[j] * xd[j][i];
+	zd[i] = s;
+    }
+}
+
+/* z = sum_j c[j] * X[j] */
+SIMD_DISPATCH
+static int simd_linearcombination(int nvec, realtype* c, N_Vector* X,
+				  N_Vector z)
+{
+    sundials_ml_index n = NV_LENGTH_S(z), i0, i;
+    realtype *zd = NV_DATA_S(z);
+    realtype acc[SIMD_BLOCK];
+    int j;
+
+    if (nvec <= SIMD_FIXED_MAX) {
+	realtype *xd[SIMD_FIXED_MAX];
+
+	for (j = 0; j < nvec; ++j) xd[j] = NV_DATA_S(X[j]);
+	switch (nvec) {
+	case 1: simd_linearcombination_fixed(1, n, c, xd, zd); break;
+	case 2: simd_linearcombination_fixed(2, n, c, xd, zd); break;
+	case 3: simd_linearcombination_fixed(3, n, c, xd, zd); break;
+	case 4: simd_linearcombination_fixed(4, n, c, xd, zd); break;
+	case 5: simd_linearcombination_fixed(5, n, c, xd, zd); break;
+	case 6: simd_linearcombination_fixed(6, n, c, xd, zd); break;
+	case 7: simd_linearcombination_fixed(7, n, c, xd, zd); break;
+	case 8: simd_linearcombination_fixed(8, n, c, xd, zd); break;
+	}
+	return 0;
+    }
+
+    for (i0 = 0; i0 < n; i0 += SIMD_BLOCK) {
+	sundials_ml_index m = SIMD_MIN(SIMD_BLOCK, n - i0);
+	realtype *xd = NV_DATA_S(X[0]) + i0;
+
+	for (i = 0; i < m; ++i) acc[i] = c[0] * xd[i];
+	for (j = 1; j < nvec; ++j) {
+	    realtype cj = c[j];
+	    xd = NV_DATA_S(X[j]) + i0;
+	    for (i = 0; i < m; ++i) acc[i] += cj * xd[i];
+	}
+	for (i = 0; i < m; ++i) zd[i0 + i] = acc[i];
+    }
+    return 0;
+}
+
+/* Z[j] = a[j] * x + Y[j] */
+SIMD_DISPATCH
+static int simd_scaleaddmulti(int nvec, realtype* a, N_Vector x,
+			      N_Vector* Y, N_Vector* Z)
+{
+    sundials_ml_index n = NV_LENGTH_S(x), i0, i;
+    realtype xb[SIMD_BLOCK];
+    int j;
+
+    for (i0 = 0; i0 < n; i0 += SIMD_BLOCK) {
+	sundials_ml_index m = SIMD_MIN(SIMD_BLOCK, n - i0);
+	realtype *xd = NV_DATA_S(x) + i0;
+
+	/* copy first in case x is also one of the Z[j] */
+	for (i = 0; i < m; ++i) xb[i] = xd[i];
+	for (j = 0; j < nvec; ++j) {
+	    realtype aj = a[j];
+	    realtype *yd = NV_DATA_S(Y[j]) + i0;
+	    realtype *zd = NV_DATA_S(Z[j]) + i0;
+	    for (i = 0; i < m; ++i) zd[i] = aj * xb[i] + yd[i];
+	}
+    }
+    return 0;
+}
+
+/* Sum of the partial sums in acc, which are reset to zero. */
+static realtype simd_collect(realtype *acc)
+{
+    realtype r = 0.0;
+    int k;
+
+    for (k = 0; k < SIMD_LANES; ++k) {
+	r += acc[k];
+	acc[k] = 0.0;
+    }
+    return r;
+}
+
+/* dotprods[j] = x . Y[j] */
+SIMD_DISPATCH
+static int simd_dotprodmulti(int nvec, N_Vector x, N_Vector* Y,
+			     realtype* dotprods)
+{
+    sundials_ml_index n = NV_LENGTH_S(x), i0, i;
+    realtype acc[SIMD_LANES] = { 0.0 };
+    int j, k;
+
+    for (j = 0; j < nvec; ++j) dotprods[j] = 0.0;
+
+    for (i0 = 0; i0 < n; i0 += SIMD_BLOCK) {
+	sundials_ml_index m = SIMD_MIN(SIMD_BLOCK, n - i0);
+	sundials_ml_index mv = m - m % SIMD_LANES;
+	realtype *xd = NV_DATA_S(x) + i0;
+
+	for (j = 0; j < nvec; ++j) {
+	    realtype *yd = NV_DATA_S(Y[j]) + i0;
+	    for (i = 0; i < mv; i += SIMD_LANES)
+		for (k = 0; k < SIMD_LANES; ++k)
+		    acc[k] += xd[i + k] * yd[i + k];
+	    for (; i < m; ++i) acc[0] += xd[i] * yd[i];
+	    dotprods[j] += simd_collect(acc);
+	}
+    }
+    return 0;
+}
+
+/* Z[j] = a * X[j] + b * Y[j] */
+SIMD_DISPATCH
+static int simd_linearsumvectorarray(int nvec, realtype a, N_Vector* X,
+				     realtype b, N_Vector* Y, N_Vector* Z)
+{
+    sundials_ml_index n, i;
+    int j;
+
+    for (j = 0; j < nvec; ++j) {
+	realtype *xd = NV_DATA_S(X[j]);
+	realtype *yd = NV_DATA_S(Y[j]);
+	realtype *zd = NV_DATA_S(Z[j]);
+
+	n = NV_LENGTH_S(Z[j]);
+	for (i = 0; i < n; ++i) zd[i] = a * xd[i] + b * yd[i];
+    }
+    return 0;
+}
+
+/* nrm[j] = sqrt(sum_i (X[j](i) * W[j](i))^2 / n) */
+SIMD_DISPATCH
+static int simd_wrmsnormvectorarray(int nvec, N_Vector* X, N_Vector* W,
+				    realtype* nrm)
+{
+    realtype acc[SIMD_LANES] = { 0.0 };
+    sundials_ml_index n, nv, i;
+    int j, k;
+
+    for (j = 0; j < nvec; ++j) {
+	realtype *xd = NV_DATA_S(X[j]);
+	realtype *wd = NV_DATA_S(W[j]);
+
+	n = NV_LENGTH_S(X[j]);
+	nv = n - n % SIMD_LANES;
+	for (i = 0; i < nv; i += SIMD_LANES)
+	    for (k = 0; k < SIMD_LANES; ++k) {
+		realtype p = xd[i + k] * wd[i + k];
+		acc[k] += p * p;
+	    }
+	for (; i < n; ++i) acc[0] += (xd[i] * wd[i]) * (xd[i] * wd[i]);
+	nrm[j] = (n == 0) ? 0.0 : sqrt(simd_collect(acc) / n);
+    }
+    return 0;
+}
+
+#undef SIMD_MIN
+#undef SIMD_FIXED_MAX
+#endif
+
+CAMLprim value sunml_nvec_ser_enablesimdops(value vx, value vv)
+{
+    CAMLparam2(vx, vv);
+#if 400 <= SUNDIALS_LIB_VERSION
+    N_Vector v = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_Vector_Ops saved;
+
+    if (Bool_val(vv)) {
+	sunml_nvec_save_ops(v);
+	v->ops->nvlinearcombination     = simd_linearcombination;
+	v->ops->nvscaleaddmulti         = simd_scaleaddmulti;
+	v->ops->nvdotprodmulti          = simd_dotprodmulti;
+	v->ops->nvlinearsumvectorarray  = simd_linearsumvectorarray;
+	v->ops->nvwrmsnormvectorarray   = simd_wrmsnormvectorarray;
+    } else if ((saved = sunml_nvec_restore_ops(v)) != NULL) {
+	v->ops->nvlinearcombination     = saved->nvlinearcombination;
+	v->ops->nvscaleaddmulti         = saved->nvscaleaddmulti;
+	v->ops->nvdotprodmulti          = saved->nvdotprodmulti;
+	v->ops->nvlinearsumvectorarray  = saved->nvlinearsumvectorarray;
+	v->ops->nvwrmsnormvectorarray   = saved->nvwrmsnormvectorarray;
+    }
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -1993,7 +4311,7 @@ CAMLprim value sunml_nvec_custom_enablefusedops(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
 
     if (Bool_val(vv)) {
 	r =    IS_SOME_OP(x, NVECTOR_OPS_NVLINEARCOMBINATION)
@@ -2044,7 +4362,7 @@ CAMLprim value sunml_nvec_custom_enablelinearcombination(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVLINEARCOMBINATION)) {
 	    x->ops->nvlinearcombination = callml_vlinearcombination;
@@ -2065,7 +4383,7 @@ CAMLprim value sunml_nvec_custom_enablescaleaddmulti(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVSCALEADDMULTI)) {
 	    x->ops->nvscaleaddmulti = callml_vscaleaddmulti;
@@ -2086,7 +4404,7 @@ CAMLprim value sunml_nvec_custom_enabledotprodmulti(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVDOTPRODMULTI)) {
 	    x->ops->nvdotprodmulti = callml_vdotprodmulti;
@@ -2107,7 +4425,7 @@ CAMLprim value sunml_nvec_custom_enablelinearsumvectorarray(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVLINEARSUMVECTORARRAY)) {
 	    x->ops->nvlinearsumvectorarray = callml_vlinearsumvectorarray;
@@ -2128,7 +4446,7 @@ CAMLprim value sunml_nvec_custom_enablescalevectorarray(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVSCALEVECTORARRAY)) {
 	    x->ops->nvscalevectorarray = callml_vscalevectorarray;
@@ -2149,7 +4467,7 @@ CAMLprim value sunml_nvec_custom_enableconstvectorarray(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVCONSTVECTORARRAY)) {
 	    x->ops->nvconstvectorarray = callml_vconstvectorarray;
@@ -2170,7 +4488,7 @@ CAMLprim value sunml_nvec_custom_enablewrmsnormvectorarray(value vx, value vv)
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVWRMSNORMVECTORARRAY)) {
 	    x->ops->nvwrmsnormvectorarray = callml_vwrmsnormvectorarray;
@@ -2191,7 +4509,7 @@ CAMLprim value sunml_nvec_custom_enablewrmsnormmaskvectorarray(value vx, value v
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVWRMSNORMMASKVECTORARRAY)) {
 	    x->ops->nvwrmsnormmaskvectorarray = callml_vwrmsnormmaskvectorarray;
@@ -2212,7 +4530,7 @@ CAMLprim value sunml_nvec_custom_enablescaleaddmultivectorarray(value vx, value
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVSCALEADDMULTIVECTORARRAY)) {
 	    x->ops->nvscaleaddmultivectorarray =
@@ -2234,7 +4552,7 @@ CAMLprim value sunml_nvec_custom_enablelinearcombinationvectorarray(value vx, va
     CAMLparam2(vx, vv);
     booleantype r = 1;
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_Vector x = NVEC_VAL(vx);
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
     if (Bool_val(vv)) {
 	if (IS_SOME_OP(x, NVECTOR_OPS_NVLINEARCOMBINATIONVECTORARRAY)) {
 	    x->ops->nvlinearcombinationvectorarray =
@@ -116,6 +116,18 @@
       deleted by: explicit call to nvdestroy field of N_Vector_Ops,
                   GC never initiates destruction of any part of the structure.
 
+   A cloned nvector is created by sunml_clone_cnvec: it shares the ops
+   table of the nvector it is cloned from (tables are reference counted
+   and freed with their last c-nvec). A stub that changes the operations
+   of an nvector must first call sunml_nvec_own_ops, which gives the
+   nvector a private copy of a shared table, so that, as in Sundials,
+   enabling or disabling fused operations only affects later clones. The
+   memory of destroyed c-nvecs and of their contents (but not of their
+   ops tables or payloads) is kept in a small global pool, protected by a
+   mutex, and reused by later allocations with the same content size. A
+   new payload is always allocated since the old one may still be
+   referenced from OCaml.
+
 
    Serial nvectors
    ---------------
@@ -136,6 +148,12 @@
    global root.  The user must ensure the callbacks do not hold referenes to
    any particular nvector, for otherwise that nvector is never reclaimed.
 
+   Layout nvectors are custom nvectors whose content field instead points to
+   a struct containing the (clone, layout, callback table) triple and the
+   array of segments that hold the elements; both are registered as global
+   roots.  Operations not overridden by the user loop directly over the
+   segments.
+
    Parallel nvectors
    -----------------
    This is almost the same as serial nvectors, except the payload is a triple
@@ -203,6 +221,9 @@ enum nvector_id_tag {
 struct cnvec {
     struct _generic_N_Vector nvec;
     value backlink;
+    size_t content_size;	/* of the block at nvec.content */
+    int cloned;			/* by sunml_clone_cnvec */
+    size_t payload_size;	/* see sunml_nvec_account_payload */
 };
 
 // Return the OCaml version of the nvector payload
@@ -215,10 +236,33 @@ struct cnvec {
 // Internal functions
 N_Vector sunml_alloc_cnvec(size_t content_size, value backlink);
 void sunml_clone_cnvec_ops(N_Vector dst, N_Vector src);
+N_Vector sunml_clone_cnvec(size_t content_size, value backlink, N_Vector w);
 CAMLprim value sunml_alloc_caml_nvec(N_Vector nv, void (*finalizer)(value));
 void sunml_free_cnvec(N_Vector nv);
+N_Vector sunml_nvec_own_ops(N_Vector nv);
+
+/* Alternative implementations of operations (like those installed by
+   Nvector_serial.enable_simd_ops) are installed after sunml_nvec_save_ops,
+   which records the operations of nv unless they are already recorded.
+   They are removed by copying the slots that they replaced back from the
+   table returned by sunml_nvec_restore_ops, which is NULL if nothing was
+   recorded.  Both apply to tables made private by sunml_nvec_own_ops.  */
+void sunml_nvec_save_ops(N_Vector nv);
+N_Vector_Ops sunml_nvec_restore_ops(N_Vector nv);
 CAMLprim void sunml_finalize_caml_nvec(value vnv);
 
+/* Memory accounting (Nvector.get_memory).  The c-nvecs allocated by
+   sunml_alloc_cnvec and sunml_clone_cnvec are counted until they are
+   freed by sunml_free_cnvec.  The clone functions record the size of the
+   payloads that they allocate with sunml_nvec_account_payload; it is left
+   at zero where unknown (e.g., for custom nvectors).  The generational
+   global roots held by c-nvecs, including the backlinks, must be
+   registered and removed with sunml_nvec_register_root and
+   sunml_nvec_remove_root.  */
+void sunml_nvec_account_payload(N_Vector nv, size_t bytes);
+void sunml_nvec_register_root(value *r);
+void sunml_nvec_remove_root(value *r);
+
 #if 400 <= SUNDIALS_LIB_VERSION
 int sunml_arrays_of_nvectors(N_Vector *r[], int n, ...);
 void sunml_arrays_of_nvectors2(int* nrows, int *ncols, N_Vector **vv[], int n, ...);
@@ -227,6 +271,47 @@ void sunml_arrays_of_nvectors2(int* nrows, int *ncols, N_Vector **vv[], int n, .
 N_Vector *sunml_nvector_array_alloc(value vtable);
 void sunml_nvector_array_free(N_Vector *nvarr);
 
+/* The length of a vector with contiguous data, or -1 for other vectors.  */
+intnat sunml_nvec_data_length(N_Vector y);
+
+/* Quadrature forms (struct sunml_quadforms) over nvectors with contiguous
+   data.  sunml_quadforms_set raises Invalid_argument if an index is not
+   below n, the length of the vectors (as given by sunml_nvec_data_length),
+   without changing qf.  */
+void sunml_quadforms_set(struct sunml_quadforms *qf,
+			 value vrow, value va, value vb, value vw, intnat n);
+void sunml_quadforms_free(struct sunml_quadforms *qf);
+void sunml_quadforms_eval(struct sunml_quadforms *qf, N_Vector y, N_Vector q);
+void sunml_quadforms_eval_sens(struct sunml_quadforms *qf,
+			       N_Vector y, N_Vector ys, N_Vector qs);
+
+/* Structured error weights (struct sunml_ewtspec) over nvectors with
+   contiguous data.  sunml_ewtspec_set raises Invalid_argument if the array
+   lengths do not fit vectors of length n (as given by
+   sunml_nvec_data_length).  sunml_ewtspec_eval returns -1 if a weight is
+   not positive or if y has no array pointer, and 0 otherwise.  */
+void sunml_ewtspec_set(struct sunml_ewtspec *es, value vspec, intnat n);
+void sunml_ewtspec_free(struct sunml_ewtspec *es);
+int sunml_ewtspec_eval(struct sunml_ewtspec *es, N_Vector y, N_Vector ewt);
+
+/* The parallel partitions of many-partition nvectors (Nvector_many).  Since
+   this library does not depend on MPI, the parallel nvector library
+   provides these functions when it is initialized.  For a parallel
+   nvector, local returns its local elements and sets *loclen and *globlen
+   to its local and global lengths; it returns NULL for other nvectors.
+   allreduce combines d over the communicator of v and same_comm tells
+   whether two parallel nvectors have the same communicator.  */
+enum sunml_many_reduce { SUNML_MANY_SUM, SUNML_MANY_MAX, SUNML_MANY_MIN };
+
+struct sunml_many_parallel {
+    realtype *(*local)(N_Vector v, sundials_ml_index *loclen,
+		       sundials_ml_index *globlen);
+    realtype (*allreduce)(N_Vector v, realtype d, enum sunml_many_reduce op);
+    int (*same_comm)(N_Vector v, N_Vector w);
+};
+
+void sunml_nvec_many_set_parallel(const struct sunml_many_parallel *p);
+
 // Creation functions
 value ml_nvec_wrap_serial(value payload, value checkfn);
 value ml_nvec_wrap_custom(value mlops, value payload, value checkfn);
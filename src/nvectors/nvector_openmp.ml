@@ -37,6 +37,23 @@ let wrap ?(with_fused_ops=false) nthreads v =
   if with_fused_ops then c_enablefusedops_openmp nv true;
   nv
 
+type proc_bind =
+  | BindDefault
+  | BindMaster
+  | BindClose
+  | BindSpread
+
+external c_make_first_touch : int -> int -> float -> proc_bind
+                              -> (RealArray.t -> bool) -> t
+  = "sunml_nvec_make_openmp_first_touch"
+
+let make_first_touch ?(with_fused_ops=false) ?(proc_bind=BindDefault)
+                     nthreads n iv =
+  let nv = c_make_first_touch nthreads n iv proc_bind
+             (fun v' -> n = RealArray.length v') in
+  if with_fused_ops then c_enablefusedops_openmp nv true;
+  nv
+
 let unwrap = Nvector.unwrap
 
 let pp fmt v = RealArray.pp fmt (unwrap v)
@@ -88,6 +105,9 @@ let enable
     do_enable c_enablelinearcombinationvectorarray_openmp nv
               with_linear_combination_vector_array
 
+external enable_simd_ops : t -> bool -> unit
+  = "sunml_nvec_openmp_enablesimdops"
+
 module Ops = struct
   type t = (RealArray.t, kind) Nvector.t
 
@@ -119,26 +139,61 @@ module Ops = struct
   external n_vaddconst     : t -> float -> t -> unit
     = "sunml_nvec_openmp_n_vaddconst"
 
-  external n_vdotprod      : t -> t -> float
-    = "sunml_nvec_openmp_n_vdotprod"
+  (* The reductions are called without allocating or boxing their
+     results in native code; their lengths are checked here since
+     the native stubs cannot raise exceptions. *)
+  let check_lengths fn x y =
+    if RealArray.length (Nvector.unwrap x)
+       <> RealArray.length (Nvector.unwrap y)
+    then invalid_arg ("Nvector_openmp." ^ fn)
+
+  external c_n_vdotprod    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vdotprod" "sunml_nvec_openmp_n_vdotprod_unboxed"
+    [@@noalloc]
 
-  external n_vmaxnorm      : t -> float
-    = "sunml_nvec_openmp_n_vmaxnorm"
+  let n_vdotprod x y =
+    if Sundials_configuration.safe then check_lengths "n_vdotprod" x y;
+    c_n_vdotprod x y
 
-  external n_vwrmsnorm     : t -> t -> float
-    = "sunml_nvec_openmp_n_vwrmsnorm"
+  external n_vmaxnorm      : t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vmaxnorm" "sunml_nvec_openmp_n_vmaxnorm_unboxed"
+    [@@noalloc]
 
-  external n_vwrmsnormmask : t -> t -> t -> float
+  external c_n_vwrmsnorm   : t -> t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vwrmsnorm" "sunml_nvec_openmp_n_vwrmsnorm_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnorm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwrmsnorm" x w;
+    c_n_vwrmsnorm x w
+
+  external c_n_vwrmsnormmask : t -> t -> t -> (float [@unboxed])
     = "sunml_nvec_openmp_n_vwrmsnormmask"
+      "sunml_nvec_openmp_n_vwrmsnormmask_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnormmask x w id =
+    if Sundials_configuration.safe then begin
+      check_lengths "n_vwrmsnormmask" x w;
+      check_lengths "n_vwrmsnormmask" x id
+    end;
+    c_n_vwrmsnormmask x w id
 
-  external n_vmin          : t -> float
-    = "sunml_nvec_openmp_n_vmin"
+  external n_vmin          : t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vmin" "sunml_nvec_openmp_n_vmin_unboxed"
+    [@@noalloc]
 
-  external n_vwl2norm      : t -> t -> float
-    = "sunml_nvec_openmp_n_vwl2norm"
+  external c_n_vwl2norm    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vwl2norm" "sunml_nvec_openmp_n_vwl2norm_unboxed"
+    [@@noalloc]
 
-  external n_vl1norm       : t -> float
-    = "sunml_nvec_openmp_n_vl1norm"
+  let n_vwl2norm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwl2norm" x w;
+    c_n_vwl2norm x w
+
+  external n_vl1norm       : t -> (float [@unboxed])
+    = "sunml_nvec_openmp_n_vl1norm" "sunml_nvec_openmp_n_vl1norm_unboxed"
+    [@@noalloc]
 
   external n_vcompare      : float -> t -> t -> unit
     = "sunml_nvec_openmp_n_vcompare"
@@ -149,8 +204,15 @@ module Ops = struct
   external n_vconstrmask   : t -> t -> t -> bool
     = "sunml_nvec_openmp_n_vconstrmask"
 
-  external n_vminquotient  : t -> t -> float
+  external c_n_vminquotient : t -> t -> (float [@unboxed])
     = "sunml_nvec_openmp_n_vminquotient"
+      "sunml_nvec_openmp_n_vminquotient_unboxed"
+    [@@noalloc]
+
+  let n_vminquotient num denom =
+    if Sundials_configuration.safe then
+      check_lengths "n_vminquotient" num denom;
+    c_n_vminquotient num denom
 
   external n_vspace  : t -> int * int
     = "sunml_nvec_openmp_n_vspace"
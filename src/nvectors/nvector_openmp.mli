@@ -52,6 +52,33 @@ val make : ?with_fused_ops:bool -> int -> int -> float -> t
     @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
 val wrap : ?with_fused_ops:bool -> int -> RealArray.t -> t
 
+(** Thread binding for the initialization of first-touch nvectors.
+    See the [proc_bind] clause of OpenMP. [BindDefault] uses the
+    binding given by the [OMP_PROC_BIND] environment variable. The other
+    cases require OpenMP 4.0 and otherwise behave like [BindDefault]. *)
+type proc_bind =
+  | BindDefault
+  | BindMaster
+  | BindClose
+  | BindSpread
+
+(** [make_first_touch nthreads n iv] creates a new OpenMP nvector with
+    [nthreads] threads and [n] elements initialized to [iv], like {!make},
+    except that the elements are initialized in parallel with the same
+    static schedule as the vector operations. On NUMA systems, this places
+    each memory page near the thread that processes it. The clones of such
+    vectors, for instance those created by solvers, are initialized in the
+    same way.
+
+    The threads executing the vector operations are only placed
+    consistently if their binding is fixed, for instance by setting
+    [OMP_PROC_BIND], and [proc_bind] should then be left at its default
+    or chosen to match.
+
+    @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
+val make_first_touch : ?with_fused_ops:bool -> ?proc_bind:proc_bind
+                       -> int -> int -> float -> t
+
 (** Aliases {!Nvector.unwrap}. *)
 val unwrap : t -> RealArray.t
 
@@ -94,6 +121,21 @@ val enable :
   -> t
   -> unit
 
+(** [enable_simd_ops nv true] replaces the linear combination operation of
+    [nv] with kernels specialized for combinations of up to eight vectors,
+    as formed at each stage of the explicit Runge-Kutta methods of
+    {!Arkode.ERKStep}, that sum the terms of each element in a register in
+    a single pass over the operands. Vectors cloned from [nv] inherit the
+    setting. [enable_simd_ops nv false] reinstates the operation that was
+    replaced, which may be disabled.
+
+    Since these kernels override the settings made by {!enable}, they
+    should be activated after it.
+
+    @since 4.0.0
+    @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
+val enable_simd_ops : t -> bool -> unit
+
 (** Underlying nvector operations on OpenMP nvectors. *)
 module Ops : Nvector.NVECTOR_OPS with type t = t
 
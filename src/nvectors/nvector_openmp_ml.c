@@ -42,14 +42,13 @@ static N_Vector clone_openmp(N_Vector w)
     /* Create vector (we need not copy the data) */
     v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
 
-    v = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_OpenMP), v_payload);
+    v = sunml_clone_cnvec(sizeof(struct _N_VectorContent_OpenMP), v_payload, w);
     if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
 
     content = (N_VectorContent_OpenMP) v->content;
 
-    /* Create vector operation structure */
-    sunml_clone_cnvec_ops(v, w);
-
     /* Create content */
     content->length      = NV_LENGTH_OMP(w);
     content->num_threads = NV_NUM_THREADS_OMP(w);
@@ -88,19 +87,15 @@ static N_Vector clone_empty_openmp(N_Vector w)
 /* Creation from OCaml.  */
 /* Adapted from sundials-2.6.1/src/nvec_openmp/nvector_openmp.c:
    N_VNewEmpty_OpenMP */
-CAMLprim value sunml_nvec_wrap_openmp(value nthreads,
-				   value payload, value checkfn)
+static N_Vector alloc_openmp(value nthreads, value payload, size_t content_size)
 {
-    CAMLparam3(nthreads, payload, checkfn);
-    CAMLlocal1(vnvec);
-
     N_Vector nv;
     N_Vector_Ops ops;
     N_VectorContent_OpenMP content;
     long int length = (Caml_ba_array_val(payload))->dim[0];
 
     /* Create vector */
-    nv = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_OpenMP), payload);
+    nv = sunml_alloc_cnvec(content_size, payload);
     if (nv == NULL) caml_raise_out_of_memory();
     ops = (N_Vector_Ops) nv->ops;
     content = (N_VectorContent_OpenMP) nv->content;
@@ -159,6 +154,136 @@ CAMLprim value sunml_nvec_wrap_openmp(value nthreads,
     content->own_data    = 0;
     content->data        = Caml_ba_data_val(payload);
 
+    return nv;
+}
+
+CAMLprim value sunml_nvec_wrap_openmp(value nthreads,
+				   value payload, value checkfn)
+{
+    CAMLparam3(nthreads, payload, checkfn);
+    CAMLlocal1(vnvec);
+
+    N_Vector nv = alloc_openmp(nthreads, payload,
+			       sizeof(struct _N_VectorContent_OpenMP));
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+/** First-touch allocation */
+
+/* Memory pages are placed on the NUMA node of the thread that first writes
+   to them.  First-touch nvectors are initialized by the same static
+   schedule, and the same number of threads, as the Sundials OpenMP
+   operations, so that each page is placed near the thread that will
+   process it.  Their clones are initialized in the same way.  The content
+   is that of a standard OpenMP nvector followed by the requested thread
+   binding, which also applies to the clones.  */
+
+/* Must correspond with Nvector_openmp.proc_bind */
+enum nvector_openmp_proc_bind {
+    VARIANT_NVECTOR_OPENMP_PROC_BIND_DEFAULT = 0,
+    VARIANT_NVECTOR_OPENMP_PROC_BIND_MASTER,
+    VARIANT_NVECTOR_OPENMP_PROC_BIND_CLOSE,
+    VARIANT_NVECTOR_OPENMP_PROC_BIND_SPREAD,
+};
+
+struct first_touch_content {
+    struct _N_VectorContent_OpenMP base;
+    int proc_bind;
+};
+
+#define NV_PROC_BIND_OMP(v) \
+    (((struct first_touch_content *)(v)->content)->proc_bind)
+
+static void first_touch_fill(realtype *data, sundials_ml_index n,
+			     int nthreads, int proc_bind, realtype c)
+{
+    sundials_ml_index i;
+
+    switch (proc_bind) {
+#if defined(_OPENMP) && _OPENMP >= 201307
+    case VARIANT_NVECTOR_OPENMP_PROC_BIND_MASTER:
+#pragma omp parallel for default(none) private(i) shared(n,data,c) \
+	schedule(static) num_threads(nthreads) proc_bind(master)
+	for (i = 0; i < n; ++i) data[i] = c;
+	break;
+
+    case VARIANT_NVECTOR_OPENMP_PROC_BIND_CLOSE:
+#pragma omp parallel for default(none) private(i) shared(n,data,c) \
+	schedule(static) num_threads(nthreads) proc_bind(close)
+	for (i = 0; i < n; ++i) data[i] = c;
+	break;
+
+    case VARIANT_NVECTOR_OPENMP_PROC_BIND_SPREAD:
+#pragma omp parallel for default(none) private(i) shared(n,data,c) \
+	schedule(static) num_threads(nthreads) proc_bind(spread)
+	for (i = 0; i < n; ++i) data[i] = c;
+	break;
+#endif
+
+    default:
+#pragma omp parallel for default(none) private(i) shared(n,data,c) \
+	schedule(static) num_threads(nthreads)
+	for (i = 0; i < n; ++i) data[i] = c;
+	break;
+    }
+}
+
+static N_Vector clone_openmp_first_touch(N_Vector w)
+{
+    CAMLparam0();
+    CAMLlocal2(v_payload, w_payload);
+
+    N_Vector v;
+    N_VectorContent_OpenMP content;
+
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+    w_payload = NVEC_BACKLINK(w);
+    struct caml_ba_array *w_ba = Caml_ba_array_val(w_payload);
+
+    /* The data is not initialized by caml_ba_alloc.  */
+    v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
+
+    v = sunml_clone_cnvec(sizeof(struct first_touch_content), v_payload, w);
+    if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
+
+    content = (N_VectorContent_OpenMP) v->content;
+
+    content->length      = NV_LENGTH_OMP(w);
+    content->num_threads = NV_NUM_THREADS_OMP(w);
+    content->own_data    = 0;
+    content->data        = Caml_ba_data_val(v_payload);
+    NV_PROC_BIND_OMP(v)  = NV_PROC_BIND_OMP(w);
+
+    first_touch_fill(content->data, content->length, content->num_threads,
+		     NV_PROC_BIND_OMP(v), 0.0);
+
+    CAMLreturnT(N_Vector, v);
+}
+
+CAMLprim value sunml_nvec_make_openmp_first_touch(value nthreads, value vn,
+						  value viv, value vbind,
+						  value checkfn)
+{
+    CAMLparam5(nthreads, vn, viv, vbind, checkfn);
+    CAMLlocal2(vnvec, payload);
+    N_Vector nv;
+
+    payload = caml_ba_alloc_dims(BIGARRAY_FLOAT, 1, NULL, Long_val(vn));
+    first_touch_fill(REAL_ARRAY(payload), Long_val(vn), Int_val(nthreads),
+		     Int_val(vbind), Double_val(viv));
+
+    nv = alloc_openmp(nthreads, payload, sizeof(struct first_touch_content));
+    nv->ops->nvclone = clone_openmp_first_touch;
+    NV_PROC_BIND_OMP(nv) = Int_val(vbind);
+
     vnvec = caml_alloc_tuple(3);
     Store_field(vnvec, 0, payload);
     Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
@@ -441,6 +566,52 @@ CAMLprim value sunml_nvec_openmp_n_vminquotient(value vnum, value vdenom)
     CAMLreturn(caml_copy_double(r));
 }
 
+/* Native-code entry points for the reductions above.  They neither
+ * allocate nor raise, and are declared [@@noalloc] with unboxed results;
+ * the lengths are checked on the OCaml side (see Nvector_openmp.Ops).  */
+
+CAMLprim double sunml_nvec_openmp_n_vdotprod_unboxed(value vx, value vy)
+{
+    return N_VDotProd_OpenMP(NVEC_VAL(vx), NVEC_VAL(vy));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vmaxnorm_unboxed(value vx)
+{
+    return N_VMaxNorm_OpenMP(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vwrmsnorm_unboxed(value vx, value vw)
+{
+    return N_VWrmsNorm_OpenMP(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vwrmsnormmask_unboxed(value vx, value vw,
+						       value vid)
+{
+    return N_VWrmsNormMask_OpenMP(NVEC_VAL(vx), NVEC_VAL(vw),
+				  NVEC_VAL(vid));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vmin_unboxed(value vx)
+{
+    return N_VMin_OpenMP(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vwl2norm_unboxed(value vx, value vw)
+{
+    return N_VWL2Norm_OpenMP(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vl1norm_unboxed(value vx)
+{
+    return N_VL1Norm_OpenMP(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_openmp_n_vminquotient_unboxed(value vnum, value vdenom)
+{
+    return N_VMinQuotient_OpenMP(NVEC_VAL(vnum), NVEC_VAL(vdenom));
+}
+
 CAMLprim value sunml_nvec_openmp_n_vspace(value vx)
 {
     CAMLparam1(vx);
@@ -706,7 +877,8 @@ CAMLprim value sunml_nvec_openmp_enablefusedops(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableFusedOps_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableFusedOps_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -717,7 +889,8 @@ CAMLprim value sunml_nvec_openmp_enablelinearcombination(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombination_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombination_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -728,7 +901,8 @@ CAMLprim value sunml_nvec_openmp_enablescaleaddmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMulti_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMulti_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -739,7 +913,8 @@ CAMLprim value sunml_nvec_openmp_enabledotprodmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableDotProdMulti_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableDotProdMulti_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -750,7 +925,8 @@ CAMLprim value sunml_nvec_openmp_enablelinearsumvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearSumVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearSumVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -761,7 +937,8 @@ CAMLprim value sunml_nvec_openmp_enablescalevectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -772,7 +949,8 @@ CAMLprim value sunml_nvec_openmp_enableconstvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableConstVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableConstVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -783,7 +961,8 @@ CAMLprim value sunml_nvec_openmp_enablewrmsnormvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -795,7 +974,8 @@ CAMLprim value sunml_nvec_openmp_enablewrmsnormmaskvectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormMaskVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormMaskVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -807,7 +987,8 @@ CAMLprim value sunml_nvec_openmp_enablescaleaddmultivectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMultiVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMultiVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -819,10 +1000,83 @@ CAMLprim value sunml_nvec_openmp_enablelinearcombinationvectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombinationVectorArray_OpenMP(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombinationVectorArray_OpenMP(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
     CAMLreturn (Val_unit);
 }
 
+
+/** Specialized linear combinations for OpenMP nvectors */
+
+/* The linear combinations of at most LINCOMB_FIXED_MAX vectors, like those
+   that form the stages, the solution, and the error estimate of an explicit
+   Runge-Kutta method with up to seven stages, are computed by loops
+   specialized for the number of vectors.  Each element is summed in a
+   register from all of its operands before it is stored (so z may be one of
+   the X[j]), and the elements are shared among the threads by the same
+   static schedule as the Sundials operations.  Longer combinations are left
+   to N_VLinearCombination_OpenMP.  */
+
+#if 400 <= SUNDIALS_LIB_VERSION
+
+#define LINCOMB_FIXED_MAX 8
+
+#define LINCOMB_FIXED(nv)						\
+    _Pragma("omp parallel for private(j) schedule(static) num_threads(nt)") \
+    for (i = 0; i < n; ++i) {						\
+	realtype s = c[0] * xd[0][i];					\
+	for (j = 1; j < (nv); ++j) s += c[j] * xd[j][i];		\
+	zd[i] = s;							\
+    }
+
+static int lincomb_fixed_openmp(int nvec, realtype* c, N_Vector* X,
+				N_Vector z)
+{
+    sundials_ml_index n = NV_LENGTH_OMP(z), i;
+    int nt = NV_NUM_THREADS_OMP(z);
+    realtype *zd = NV_DATA_OMP(z);
+    realtype *xd[LINCOMB_FIXED_MAX];
+    int j;
+
+    if (nvec > LINCOMB_FIXED_MAX)
+	return N_VLinearCombination_OpenMP(nvec, c, X, z);
+
+    for (j = 0; j < nvec; ++j) xd[j] = NV_DATA_OMP(X[j]);
+    switch (nvec) {
+    case 1: LINCOMB_FIXED(1); break;
+    case 2: LINCOMB_FIXED(2); break;
+    case 3: LINCOMB_FIXED(3); break;
+    case 4: LINCOMB_FIXED(4); break;
+    case 5: LINCOMB_FIXED(5); break;
+    case 6: LINCOMB_FIXED(6); break;
+    case 7: LINCOMB_FIXED(7); break;
+    case 8: LINCOMB_FIXED(8); break;
+    }
+    return 0;
+}
+
+#undef LINCOMB_FIXED
+#undef LINCOMB_FIXED_MAX
+#endif
+
+CAMLprim value sunml_nvec_openmp_enablesimdops(value vx, value vv)
+{
+    CAMLparam2(vx, vv);
+#if 400 <= SUNDIALS_LIB_VERSION
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_Vector_Ops saved;
+
+    if (Bool_val(vv)) {
+	sunml_nvec_save_ops(x);
+	x->ops->nvlinearcombination = lincomb_fixed_openmp;
+    } else if ((saved = sunml_nvec_restore_ops(x)) != NULL) {
+	x->ops->nvlinearcombination = saved->nvlinearcombination;
+    }
+#else
+    caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
+#endif
+    CAMLreturn (Val_unit);
+}
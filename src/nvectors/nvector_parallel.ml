@@ -11,6 +11,15 @@ external c_wrap : (RealArray.t * int * Mpi.communicator)
                   -> t
   = "sunml_nvec_wrap_parallel"
 
+external c_wrap_hybrid : int
+                  -> (RealArray.t * int * Mpi.communicator)
+                  -> (RealArray.t * int * Mpi.communicator -> bool)
+                  -> t
+  = "sunml_nvec_wrap_parallel_hybrid"
+
+external num_threads : t -> int
+  = "sunml_nvec_par_num_threads"
+
 (* Selectively enable and disable fused and array operations *)
 external c_enablefusedops_parallel                          : t -> bool -> unit
   = "sunml_nvec_par_enablefusedops"
@@ -35,21 +44,32 @@ external c_enablescaleaddmultivectorarray_parallel          : t -> bool -> unit
 external c_enablelinearcombinationvectorarray_parallel      : t -> bool -> unit
   = "sunml_nvec_par_enablelinearcombinationvectorarray"
 
-let wrap ?(with_fused_ops=false) ((nl, ng, comm) as v) =
+let check_of (nl, ng, comm) =
   let nl_len = RealArray.length nl in
-  let check (nl', ng', comm') =
+  fun (nl', ng', comm') ->
     (nl_len = RealArray.length nl') && (ng <= ng') && (comm == comm')
-  in
-  let nv = c_wrap v check in
+
+let wrap ?(with_fused_ops=false) v =
+  let nv = c_wrap v (check_of v) in
   if with_fused_ops then c_enablefusedops_parallel nv true;
   nv
 
 let make ?with_fused_ops nl ng comm iv =
   wrap ?with_fused_ops (RealArray.make nl iv, ng, comm)
 
+let wrap_hybrid ?(with_fused_ops=false) nthreads v =
+  let nv = c_wrap_hybrid nthreads v (check_of v) in
+  if with_fused_ops then c_enablefusedops_parallel nv true;
+  nv
+
+let make_hybrid ?with_fused_ops nthreads nl ng comm iv =
+  wrap_hybrid ?with_fused_ops nthreads (RealArray.make nl iv, ng, comm)
+
 let clone nv =
   let loc, glen, comm = Nvector.unwrap nv in
-  wrap (RealArray.copy loc, glen, comm)
+  match num_threads nv with
+  | 1 -> wrap (RealArray.copy loc, glen, comm)
+  | n -> wrap_hybrid n (RealArray.copy loc, glen, comm)
 
 let unwrap = Nvector.unwrap
 
@@ -71,6 +91,11 @@ let communicator nv =
   let _, _, comm = Nvector.unwrap nv in
   comm
 
+external c_sync : RealArray.t -> unit
+  = "sunml_nvec_sync_array"
+
+let sync nv = c_sync (local_array nv)
+
 let do_enable f nv v =
   match v with
   | None -> ()
@@ -112,6 +137,59 @@ let enable
     do_enable c_enablelinearcombinationvectorarray_parallel nv
               with_linear_combination_vector_array
 
+let enable_fused_reductions nv v =
+  enable ~with_dot_prod_multi:v
+         ~with_wrms_norm_vector_array:v
+         ~with_wrms_norm_mask_vector_array:v
+         nv
+
+module Local = struct (* {{{ *)
+  external n_vdotprod      : t -> t -> float
+    = "sunml_nvec_par_n_vdotprodlocal"
+
+  external n_vmaxnorm      : t -> float
+    = "sunml_nvec_par_n_vmaxnormlocal"
+
+  external n_vmin          : t -> float
+    = "sunml_nvec_par_n_vminlocal"
+
+  external n_vl1norm       : t -> float
+    = "sunml_nvec_par_n_vl1normlocal"
+
+  external n_vwsqrsum      : t -> t -> float
+    = "sunml_nvec_par_n_vwsqrsumlocal"
+
+  external n_vwsqrsummask  : t -> t -> t -> float
+    = "sunml_nvec_par_n_vwsqrsummasklocal"
+
+  external n_vminquotient  : t -> t -> float
+    = "sunml_nvec_par_n_vminquotientlocal"
+
+  external n_vdotprodmulti : t -> t array -> RealArray.t -> unit
+    = "sunml_nvec_par_n_vdotprodmultilocal"
+
+  type op = Sum | Max | Min
+
+  type mpi_request
+
+  type request = {
+    req : mpi_request;
+    buf : RealArray.t;  (* must stay alive until the reduction completes *)
+  }
+
+  external c_start_allreduce : Mpi.communicator -> op -> RealArray.t
+                               -> mpi_request
+    = "sunml_nvec_par_start_allreduce"
+
+  external c_wait : mpi_request -> unit
+    = "sunml_nvec_par_wait_allreduce"
+
+  let start_allreduce comm op buf =
+    { req = c_start_allreduce comm op buf; buf }
+
+  let wait { req } = c_wait req
+end (* }}} *)
+
 module Ops = struct (* {{{ *)
   type t = (data, kind) Nvector.t
 
@@ -48,7 +48,8 @@ exception IncorrectGlobalSize
 val make : ?with_fused_ops:bool -> int -> int -> Mpi.communicator -> float -> t
 
 (** Creates an nvector with a distinct underlying array but that shares the
-    original global size and communicator. *)
+    original global size and communicator. The clone of a hybrid nvector
+    is hybrid with the same number of threads. *)
 val clone : t -> t
 
 (** [wrap a] creates a new parallel nvector from [a].
@@ -60,6 +61,37 @@ val clone : t -> t
     @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
 val wrap : ?with_fused_ops:bool -> data -> t
 
+(** [make_hybrid nt nl ng c iv] creates a new hybrid parallel nvector that
+    distributes its [nl] local elements over [nt] OpenMP threads. The other
+    arguments are as for {!make}.
+
+    Hybrid nvectors communicate across nodes like other parallel nvectors
+    (one MPI process per node, typically), but the local parts of the
+    vector operations, and of the reductions before their global
+    combination, are executed by a team of threads. They are otherwise
+    indistinguishable from parallel nvectors: their elements are accessed
+    through {!local_array}, and they may be passed to the parallel
+    preconditioners and to {!Ops}, whose functions are not multithreaded.
+    The vectors cloned from a hybrid nvector by the solvers are hybrid.
+
+    The library must be compiled with OpenMP for the operations to run in
+    parallel; otherwise the threads argument has no effect.
+
+    @raise Invalid_argument The number of threads is not positive. *)
+val make_hybrid : ?with_fused_ops:bool -> int -> int -> int
+                  -> Mpi.communicator -> float -> t
+
+(** [wrap_hybrid nt a] creates a new hybrid parallel nvector from [a]
+    whose operations use [nt] OpenMP threads (see {!make_hybrid}).
+
+    @raise Invalid_argument The number of threads is not positive. *)
+val wrap_hybrid : ?with_fused_ops:bool -> int -> data -> t
+
+(** Returns the number of threads used by the operations on a parallel
+    nvector: [1] unless it was created with {!make_hybrid} or
+    {!wrap_hybrid}. *)
+val num_threads : t -> int
+
 (** Aliases {!Nvector.unwrap}. *)
 val unwrap : t -> data
 
@@ -81,6 +113,16 @@ val global_length : t -> int
 (** Returns the communicator used for the parallel nvector. *)
 val communicator : t -> Mpi.communicator
 
+(** Writes the local elements of a parallel nvector back to the file from
+    which they are mapped, if any (see {!Nvector_serial.sync}). Each process
+    may thus checkpoint its part of a distributed state in its own file,
+    and restart from it by passing the array mapped from that file to
+    {!wrap}.
+
+    @raise Failure The elements could not be written.
+    @since 4.0.0 *)
+val sync : t -> unit
+
 (** Selectively enable or disable fused and array operations.
     The [with_fused_ops] argument enables or disables all such operations.
 
@@ -112,6 +154,88 @@ val enable :
   -> t
   -> unit
 
+(** [enable_fused_reductions nv v] enables ([v = true]) or disables the
+    fused operations that combine several global reductions into a single
+    [MPI_Allreduce]: the dot-product-multi, wrms-norm-vector-array, and
+    wrms-norm-mask-vector-array operations. Integrators use them, when they
+    are enabled, for Gram-Schmidt orthogonalization and error norms.
+
+    @since 4.0.0
+    @cvode <node5> N_VEnableDotProdMulti_Parallel
+    @cvode <node5> N_VEnableWrmsNormVectorArray_Parallel
+    @cvode <node5> N_VEnableWrmsNormMaskVectorArray_Parallel
+    @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
+val enable_fused_reductions : t -> bool -> unit
+
+(** Reductions over the local elements of parallel nvectors.
+
+    The functions in this module do not communicate. Their results can be
+    gathered into an array and combined across processes with a single
+    non-blocking reduction, which may be overlapped with other local work:
+{[
+    let buf = RealArray.make 2 0.0 in
+    buf.{0} <- Local.n_vdotprod x y;
+    buf.{1} <- Local.n_vwsqrsum x w;
+    let r = Local.start_allreduce (communicator x) Local.Sum buf in
+    (* ... other local work ... *)
+    Local.wait r;
+    let dot = buf.{0}
+    and wrms = sqrt (buf.{1} /. float (global_length x)) in
+    ...
+]}
+    They correspond to the local reduction operations introduced in
+    Sundials 5.0.0. *)
+module Local : sig (* {{{ *)
+
+  (** Returns the dot product of the local elements. *)
+  val n_vdotprod : t -> t -> float
+
+  (** Returns the largest absolute value of the local elements. *)
+  val n_vmaxnorm : t -> float
+
+  (** Returns the smallest local element. *)
+  val n_vmin : t -> float
+
+  (** Returns the sum of the absolute values of the local elements. *)
+  val n_vl1norm : t -> float
+
+  (** [n_vwsqrsum x w] returns the sum of the squares of [x(i) * w(i)] over
+      the local elements. *)
+  val n_vwsqrsum : t -> t -> float
+
+  (** [n_vwsqrsummask x w id] is like {!n_vwsqrsum}, but only for elements
+      where [id(i) > 0]. *)
+  val n_vwsqrsummask : t -> t -> t -> float
+
+  (** [n_vminquotient num denom] returns the minimum of [num(i) / denom(i)]
+      over the local elements for which [denom(i)] is not zero. *)
+  val n_vminquotient : t -> t -> float
+
+  (** [n_vdotprodmulti x ys d] sets [d.{j}] to the local dot product of [x]
+      and [ys.(j)], in a single pass over [x]. *)
+  val n_vdotprodmulti : t -> t array -> RealArray.t -> unit
+
+  (** The operation used to combine values across processes. *)
+  type op = Sum | Max | Min
+
+  (** An ongoing reduction. *)
+  type request
+
+  (** [start_allreduce comm op buf] starts to combine, in place, the
+      elements of [buf] across all processes of [comm]. The contents of
+      [buf] must not be accessed until {!wait} returns. Without MPI-3, the
+      reduction is completed before this function returns.
+
+      @raise Failure The reduction could not be started. *)
+  val start_allreduce : Mpi.communicator -> op -> RealArray.t -> request
+
+  (** Waits for a reduction to complete.
+
+      @raise Failure The reduction failed. *)
+  val wait : request -> unit
+
+end (* }}} *)
+
 (** Produce a set of parallel {!Nvector.NVECTOR_OPS} from basic
     operations on an underlying array. *)
 module MakeOps : functor (A : sig
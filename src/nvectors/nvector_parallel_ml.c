@@ -25,22 +25,27 @@
 
 #include <nvector/nvector_parallel.h>
 
+#include <math.h>
+
 /* Must correspond with camlmpi.h */
 #define Comm_val(comm) (*((MPI_Comm *) &Field(comm, 1)))
 
 /** Parallel nvectors * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+static const struct sunml_many_parallel many_parallel;
+
 CAMLprim value sunml_nvector_parallel_init_module (value exns)
 {
     CAMLparam1 (exns);
     REGISTER_EXNS (NVECTOR_PARALLEL, exns);
+    sunml_nvec_many_set_parallel(&many_parallel);
     CAMLreturn (Val_unit);
 }
 
 
 /* Adapted from sundials-2.5.0/src/nvec_par/nvector_parallel.c:
    N_VCloneEmpty_Parallel */
-static N_Vector clone_parallel(N_Vector w)
+static N_Vector clone_parallel_content(N_Vector w, size_t content_size)
 {
     CAMLparam0();
     CAMLlocal2(v_payload, w_payload);
@@ -59,13 +64,12 @@ static N_Vector clone_parallel(N_Vector w)
     Store_field(v_payload, 1, Field(w_payload, 1));
     Store_field(v_payload, 2, Field(w_payload, 2));
     
-    v = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_Parallel), v_payload);
+    v = sunml_clone_cnvec(content_size, v_payload, w);
     if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(Field(v_payload, 0))));
     content = (N_VectorContent_Parallel) v->content;
 
-    /* Create vector operation structure */
-    sunml_clone_cnvec_ops(v, w);
-
     /* Attach lengths and communicator */
     content->local_length  = NV_LOCLENGTH_P(w);
     content->global_length = NV_GLOBLENGTH_P(w);
@@ -76,12 +80,17 @@ static N_Vector clone_parallel(N_Vector w)
     CAMLreturnT(N_Vector, v);
 }
 
+static N_Vector clone_parallel(N_Vector w)
+{
+    return clone_parallel_content(w, sizeof(struct _N_VectorContent_Parallel));
+}
+
 /* Adapted from sundials-2.5.0/src/nvec_par/nvector_parallel.c:
    N_VNewEmpty_Parallel */
-CAMLprim value sunml_nvec_wrap_parallel(value payload, value checkfn)
+static N_Vector alloc_parallel(value payload, size_t content_size)
 {
-    CAMLparam2(payload, checkfn);
-    CAMLlocal2(vnvec, vlocalba);
+    CAMLparam1(payload);
+    CAMLlocal1(vlocalba);
 
     N_Vector nv;
     N_Vector_Ops ops;
@@ -106,7 +115,7 @@ CAMLprim value sunml_nvec_wrap_parallel(value payload, value checkfn)
 #endif
 
     /* Create vector */
-    nv = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_Parallel), payload);
+    nv = sunml_alloc_cnvec(content_size, payload);
     if (nv == NULL) caml_raise_out_of_memory();
     ops = (N_Vector_Ops) nv->ops;
     content = (N_VectorContent_Parallel) nv->content;
@@ -165,6 +174,17 @@ CAMLprim value sunml_nvec_wrap_parallel(value payload, value checkfn)
     content->own_data      = 0;
     content->data          = Caml_ba_data_val(vlocalba);
 
+    CAMLreturnT(N_Vector, nv);
+}
+
+CAMLprim value sunml_nvec_wrap_parallel(value payload, value checkfn)
+{
+    CAMLparam2(payload, checkfn);
+    CAMLlocal1(vnvec);
+    N_Vector nv;
+
+    nv = alloc_parallel(payload, sizeof(struct _N_VectorContent_Parallel));
+
     vnvec = caml_alloc_tuple(3);
     Store_field(vnvec, 0, payload);
     Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
@@ -173,6 +193,370 @@ CAMLprim value sunml_nvec_wrap_parallel(value payload, value checkfn)
     CAMLreturn(vnvec);
 }
 
+/** Hybrid parallel nvectors * * * * * * * * * * * * * * * * * * * * * * */
+
+/* The content of a hybrid nvector extends that of a parallel nvector, so
+   that the NV_*_P macros, and thus Nvector_parallel.Ops and the parallel
+   preconditioners, apply unchanged.  The operations distribute the local
+   elements over num_threads OpenMP threads, and reductions then combine
+   the per-node results with MPI_Allreduce.  Without OpenMP, the local
+   loops are executed sequentially.  */
+
+struct hybrid_content {
+    struct _N_VectorContent_Parallel par;
+    int num_threads;
+};
+
+#define HYBRID_NUM_THREADS(v) (((struct hybrid_content *)(v)->content)->num_threads)
+
+#ifdef _OPENMP
+#define HYBRID_PRAGMA(x) _Pragma(#x)
+#define HYBRID_FOR \
+    HYBRID_PRAGMA(omp parallel for schedule(static) num_threads(nt))
+#define HYBRID_REDUCE(r) \
+    HYBRID_PRAGMA(omp parallel for schedule(static) num_threads(nt) \
+		  reduction(r))
+#else
+#define HYBRID_FOR (void)nt;
+#define HYBRID_REDUCE(r) (void)nt;
+#endif
+
+static N_Vector clone_hybrid(N_Vector w)
+{
+    N_Vector v = clone_parallel_content(w, sizeof(struct hybrid_content));
+    if (v != NULL) HYBRID_NUM_THREADS(v) = HYBRID_NUM_THREADS(w);
+    return v;
+}
+
+static realtype hybrid_allreduce(N_Vector x, realtype d, MPI_Op op)
+{
+    realtype r;
+    MPI_Allreduce(&d, &r, 1, PVEC_REAL_MPI_TYPE, op, NV_COMM_P(x));
+    return r;
+}
+
+static void hybrid_linearsum(realtype a, N_Vector x, realtype b, N_Vector y,
+			     N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *yd = NV_DATA_P(y), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = a * xd[i] + b * yd[i];
+}
+
+static void hybrid_const(realtype c, N_Vector z)
+{
+    realtype *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(z);
+    int nt = HYBRID_NUM_THREADS(z);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = c;
+}
+
+static void hybrid_prod(N_Vector x, N_Vector y, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *yd = NV_DATA_P(y), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = xd[i] * yd[i];
+}
+
+static void hybrid_div(N_Vector x, N_Vector y, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *yd = NV_DATA_P(y), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = xd[i] / yd[i];
+}
+
+static void hybrid_scale(realtype c, N_Vector x, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = c * xd[i];
+}
+
+static void hybrid_abs(N_Vector x, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = fabs(xd[i]);
+}
+
+static void hybrid_inv(N_Vector x, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = 1.0 / xd[i];
+}
+
+static void hybrid_addconst(N_Vector x, realtype b, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = xd[i] + b;
+}
+
+static void hybrid_compare(realtype c, N_Vector x, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z);
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_FOR
+    for (i = 0; i < n; ++i) zd[i] = (fabs(xd[i]) >= c) ? 1.0 : 0.0;
+}
+
+static realtype hybrid_dotprod(N_Vector x, N_Vector y)
+{
+    realtype *xd = NV_DATA_P(x), *yd = NV_DATA_P(y), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(+:sum)
+    for (i = 0; i < n; ++i) sum += xd[i] * yd[i];
+
+    return hybrid_allreduce(x, sum, MPI_SUM);
+}
+
+static realtype hybrid_maxnorm(N_Vector x)
+{
+    realtype *xd = NV_DATA_P(x), max = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(max:max)
+    for (i = 0; i < n; ++i)
+	if (fabs(xd[i]) > max) max = fabs(xd[i]);
+
+    return hybrid_allreduce(x, max, MPI_MAX);
+}
+
+static realtype hybrid_wrmsnorm(N_Vector x, N_Vector w)
+{
+    realtype *xd = NV_DATA_P(x), *wd = NV_DATA_P(w), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(+:sum)
+    for (i = 0; i < n; ++i) sum += (xd[i] * wd[i]) * (xd[i] * wd[i]);
+
+    return sqrt(hybrid_allreduce(x, sum, MPI_SUM) / NV_GLOBLENGTH_P(x));
+}
+
+static realtype hybrid_wrmsnormmask(N_Vector x, N_Vector w, N_Vector id)
+{
+    realtype *xd = NV_DATA_P(x), *wd = NV_DATA_P(w), *idd = NV_DATA_P(id);
+    realtype sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(+:sum)
+    for (i = 0; i < n; ++i)
+	if (idd[i] > 0.0) sum += (xd[i] * wd[i]) * (xd[i] * wd[i]);
+
+    return sqrt(hybrid_allreduce(x, sum, MPI_SUM) / NV_GLOBLENGTH_P(x));
+}
+
+static realtype hybrid_min(N_Vector x)
+{
+    realtype *xd = NV_DATA_P(x), min = BIG_REAL;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(min:min)
+    for (i = 0; i < n; ++i)
+	if (xd[i] < min) min = xd[i];
+
+    return hybrid_allreduce(x, min, MPI_MIN);
+}
+
+static realtype hybrid_wl2norm(N_Vector x, N_Vector w)
+{
+    realtype *xd = NV_DATA_P(x), *wd = NV_DATA_P(w), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(+:sum)
+    for (i = 0; i < n; ++i) sum += (xd[i] * wd[i]) * (xd[i] * wd[i]);
+
+    return sqrt(hybrid_allreduce(x, sum, MPI_SUM));
+}
+
+static realtype hybrid_l1norm(N_Vector x)
+{
+    realtype *xd = NV_DATA_P(x), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(+:sum)
+    for (i = 0; i < n; ++i) sum += fabs(xd[i]);
+
+    return hybrid_allreduce(x, sum, MPI_SUM);
+}
+
+static booleantype hybrid_invtest(N_Vector x, N_Vector z)
+{
+    realtype *xd = NV_DATA_P(x), *zd = NV_DATA_P(z), val = 1.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(min:val)
+    for (i = 0; i < n; ++i) {
+	if (xd[i] == 0.0) val = 0.0;
+	else zd[i] = 1.0 / xd[i];
+    }
+
+    return (hybrid_allreduce(x, val, MPI_MIN) == 0.0) ? FALSE : TRUE;
+}
+
+static booleantype hybrid_constrmask(N_Vector c, N_Vector x, N_Vector m)
+{
+    realtype *cd = NV_DATA_P(c), *xd = NV_DATA_P(x), *md = NV_DATA_P(m);
+    realtype fail = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    int nt = HYBRID_NUM_THREADS(x);
+
+    HYBRID_REDUCE(max:fail)
+    for (i = 0; i < n; ++i) {
+	md[i] = 0.0;
+	if (cd[i] == 0.0) continue;
+	if ((fabs(cd[i]) > 1.5 && xd[i] * cd[i] <= 0.0)
+		|| (fabs(cd[i]) > 0.5 && xd[i] * cd[i] < 0.0)) {
+	    fail = 1.0;
+	    md[i] = 1.0;
+	}
+    }
+
+    return (hybrid_allreduce(x, fail, MPI_MAX) == 1.0) ? FALSE : TRUE;
+}
+
+static realtype hybrid_minquotient(N_Vector num, N_Vector denom)
+{
+    realtype *nd = NV_DATA_P(num), *dd = NV_DATA_P(denom), min = BIG_REAL;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(num);
+    int nt = HYBRID_NUM_THREADS(num);
+
+    HYBRID_REDUCE(min:min)
+    for (i = 0; i < n; ++i)
+	if (dd[i] != 0.0 && nd[i] / dd[i] < min) min = nd[i] / dd[i];
+
+    return hybrid_allreduce(num, min, MPI_MIN);
+}
+
+CAMLprim value sunml_nvec_wrap_parallel_hybrid(value vnthreads, value payload,
+					       value checkfn)
+{
+    CAMLparam3(vnthreads, payload, checkfn);
+    CAMLlocal1(vnvec);
+    N_Vector nv;
+    N_Vector_Ops ops;
+
+    if (Int_val(vnthreads) < 1)
+	caml_invalid_argument("Nvector_parallel.wrap_hybrid");
+
+    nv = alloc_parallel(payload, sizeof(struct hybrid_content));
+    HYBRID_NUM_THREADS(nv) = Int_val(vnthreads);
+
+    /* The other operations are those of a standard parallel N_Vector. */
+    ops = (N_Vector_Ops) nv->ops;
+    ops->nvclone           = clone_hybrid;
+    ops->nvlinearsum       = hybrid_linearsum;
+    ops->nvconst           = hybrid_const;
+    ops->nvprod            = hybrid_prod;
+    ops->nvdiv             = hybrid_div;
+    ops->nvscale           = hybrid_scale;
+    ops->nvabs             = hybrid_abs;
+    ops->nvinv             = hybrid_inv;
+    ops->nvaddconst        = hybrid_addconst;
+    ops->nvdotprod         = hybrid_dotprod;
+    ops->nvmaxnorm         = hybrid_maxnorm;
+    ops->nvwrmsnormmask    = hybrid_wrmsnormmask;
+    ops->nvwrmsnorm        = hybrid_wrmsnorm;
+    ops->nvmin             = hybrid_min;
+    ops->nvwl2norm         = hybrid_wl2norm;
+    ops->nvl1norm          = hybrid_l1norm;
+    ops->nvcompare         = hybrid_compare;
+    ops->nvinvtest         = hybrid_invtest;
+    ops->nvconstrmask      = hybrid_constrmask;
+    ops->nvminquotient     = hybrid_minquotient;
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, sunml_finalize_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+CAMLprim value sunml_nvec_par_num_threads(value vx)
+{
+    CAMLparam1(vx);
+    N_Vector x = NVEC_VAL(vx);
+    CAMLreturn(Val_int(x->ops->nvclone == clone_hybrid
+		       ? HYBRID_NUM_THREADS(x) : 1));
+}
+
+/** Parallel partitions of many-partition nvectors * * * * * * * * * * * */
+
+/* See struct sunml_many_parallel in nvector_ml.h.  */
+
+static realtype *many_local(N_Vector v, sundials_ml_index *loclen,
+			    sundials_ml_index *globlen)
+{
+    if (v->ops->nvclone != clone_parallel && v->ops->nvclone != clone_hybrid)
+	return NULL;
+
+    *loclen = NV_LOCLENGTH_P(v);
+    *globlen = NV_GLOBLENGTH_P(v);
+    return NV_DATA_P(v);
+}
+
+static realtype many_allreduce(N_Vector v, realtype d,
+			       enum sunml_many_reduce op)
+{
+    realtype r;
+    MPI_Op mpiop = (op == SUNML_MANY_SUM) ? MPI_SUM
+		 : (op == SUNML_MANY_MAX) ? MPI_MAX : MPI_MIN;
+
+    MPI_Allreduce(&d, &r, 1, PVEC_REAL_MPI_TYPE, mpiop, NV_COMM_P(v));
+    return r;
+}
+
+static int many_same_comm(N_Vector v, N_Vector w)
+{
+    int r;
+
+    MPI_Comm_compare(NV_COMM_P(v), NV_COMM_P(w), &r);
+    return (r == MPI_IDENT || r == MPI_CONGRUENT);
+}
+
+static const struct sunml_many_parallel many_parallel = {
+    many_local,
+    many_allreduce,
+    many_same_comm,
+};
+
+
 CAMLprim value sunml_nvec_par_n_vlinearsum(value va, value vx, value vb, value vy,
 					value vz)
 {
@@ -700,7 +1084,8 @@ CAMLprim value sunml_nvec_par_enablefusedops(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableFusedOps_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableFusedOps_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -711,7 +1096,8 @@ CAMLprim value sunml_nvec_par_enablelinearcombination(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombination_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombination_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -722,7 +1108,8 @@ CAMLprim value sunml_nvec_par_enablescaleaddmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMulti_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMulti_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -733,7 +1120,8 @@ CAMLprim value sunml_nvec_par_enabledotprodmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableDotProdMulti_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableDotProdMulti_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -744,7 +1132,8 @@ CAMLprim value sunml_nvec_par_enablelinearsumvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearSumVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearSumVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -755,7 +1144,8 @@ CAMLprim value sunml_nvec_par_enablescalevectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -766,7 +1156,8 @@ CAMLprim value sunml_nvec_par_enableconstvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableConstVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableConstVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -777,7 +1168,8 @@ CAMLprim value sunml_nvec_par_enablewrmsnormvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -789,7 +1181,8 @@ CAMLprim value sunml_nvec_par_enablewrmsnormmaskvectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormMaskVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormMaskVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -801,7 +1194,8 @@ CAMLprim value sunml_nvec_par_enablescaleaddmultivectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMultiVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMultiVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -813,10 +1207,222 @@ CAMLprim value sunml_nvec_par_enablelinearcombinationvectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombinationVectorArray_Parallel(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombinationVectorArray_Parallel(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
     CAMLreturn (Val_unit);
 }
 
+
+/** Local reductions on parallel nvectors */
+
+/* These compute the contribution of the local elements to a reduction,
+   without communicating, so that several contributions can be combined
+   into a single (possibly non-blocking) reduction.  They correspond to the
+   N_V*Local operations introduced in Sundials 5.0.0.  */
+
+CAMLprim value sunml_nvec_par_n_vdotprodlocal(value vx, value vy)
+{
+    CAMLparam2(vx, vy);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector y = NVEC_VAL(vy);
+    realtype *xd = NV_DATA_P(x), *yd = NV_DATA_P(y), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (NV_LOCLENGTH_P(y) != n)
+	caml_invalid_argument("Nvector_parallel.Local.n_vdotprod");
+#endif
+
+    for (i = 0; i < n; ++i) sum += xd[i] * yd[i];
+    CAMLreturn(caml_copy_double(sum));
+}
+
+CAMLprim value sunml_nvec_par_n_vmaxnormlocal(value vx)
+{
+    CAMLparam1(vx);
+    N_Vector x = NVEC_VAL(vx);
+    realtype *xd = NV_DATA_P(x), max = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+    for (i = 0; i < n; ++i)
+	if (fabs(xd[i]) > max) max = fabs(xd[i]);
+    CAMLreturn(caml_copy_double(max));
+}
+
+CAMLprim value sunml_nvec_par_n_vminlocal(value vx)
+{
+    CAMLparam1(vx);
+    N_Vector x = NVEC_VAL(vx);
+    realtype *xd = NV_DATA_P(x), min = BIG_REAL;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+    for (i = 0; i < n; ++i)
+	if (xd[i] < min) min = xd[i];
+    CAMLreturn(caml_copy_double(min));
+}
+
+CAMLprim value sunml_nvec_par_n_vl1normlocal(value vx)
+{
+    CAMLparam1(vx);
+    N_Vector x = NVEC_VAL(vx);
+    realtype *xd = NV_DATA_P(x), sum = 0.0;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+    for (i = 0; i < n; ++i) sum += fabs(xd[i]);
+    CAMLreturn(caml_copy_double(sum));
+}
+
+CAMLprim value sunml_nvec_par_n_vwsqrsumlocal(value vx, value vw)
+{
+    CAMLparam2(vx, vw);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector w = NVEC_VAL(vw);
+    realtype *xd = NV_DATA_P(x), *wd = NV_DATA_P(w), sum = 0.0, p;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (NV_LOCLENGTH_P(w) != n)
+	caml_invalid_argument("Nvector_parallel.Local.n_vwsqrsum");
+#endif
+
+    for (i = 0; i < n; ++i) {
+	p = xd[i] * wd[i];
+	sum += p * p;
+    }
+    CAMLreturn(caml_copy_double(sum));
+}
+
+CAMLprim value sunml_nvec_par_n_vwsqrsummasklocal(value vx, value vw,
+						  value vid)
+{
+    CAMLparam3(vx, vw, vid);
+    N_Vector x = NVEC_VAL(vx);
+    N_Vector w = NVEC_VAL(vw);
+    N_Vector id = NVEC_VAL(vid);
+    realtype *xd = NV_DATA_P(x), *wd = NV_DATA_P(w), *idd = NV_DATA_P(id);
+    realtype sum = 0.0, p;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (NV_LOCLENGTH_P(w) != n || NV_LOCLENGTH_P(id) != n)
+	caml_invalid_argument("Nvector_parallel.Local.n_vwsqrsummask");
+#endif
+
+    for (i = 0; i < n; ++i) {
+	if (idd[i] > 0.0) {
+	    p = xd[i] * wd[i];
+	    sum += p * p;
+	}
+    }
+    CAMLreturn(caml_copy_double(sum));
+}
+
+CAMLprim value sunml_nvec_par_n_vminquotientlocal(value vnum, value vdenom)
+{
+    CAMLparam2(vnum, vdenom);
+    N_Vector num = NVEC_VAL(vnum);
+    N_Vector denom = NVEC_VAL(vdenom);
+    realtype *nd = NV_DATA_P(num), *dd = NV_DATA_P(denom), min = BIG_REAL;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(num);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (NV_LOCLENGTH_P(denom) != n)
+	caml_invalid_argument("Nvector_parallel.Local.n_vminquotient");
+#endif
+
+    for (i = 0; i < n; ++i)
+	if (dd[i] != 0.0 && nd[i] / dd[i] < min) min = nd[i] / dd[i];
+    CAMLreturn(caml_copy_double(min));
+}
+
+/* One pass over x for all of the dot products.  */
+CAMLprim value sunml_nvec_par_n_vdotprodmultilocal(value vx, value vay,
+						   value vad)
+{
+    CAMLparam3(vx, vay, vad);
+    realtype *ad = REAL_ARRAY(vad);
+    N_Vector x = NVEC_VAL(vx);
+    realtype *xd = NV_DATA_P(x), xi;
+    sundials_ml_index i, n = NV_LOCLENGTH_P(x);
+    N_Vector *ay;
+    int j, nvec = sunml_arrays_of_nvectors(&ay, 1, vay);
+
+#if SUNDIALS_ML_SAFE == 1
+    if (ARRAY1_LEN(vad) < nvec) {
+	free(ay);
+	caml_invalid_argument("Nvector_parallel.Local.n_vdotprodmulti");
+    }
+    for (j = 0; j < nvec; ++j)
+	if (NV_LOCLENGTH_P(ay[j]) != n) {
+	    free(ay);
+	    caml_invalid_argument("Nvector_parallel.Local.n_vdotprodmulti");
+	}
+#endif
+
+    for (j = 0; j < nvec; ++j) ad[j] = 0.0;
+    for (i = 0; i < n; ++i) {
+	xi = xd[i];
+	for (j = 0; j < nvec; ++j)
+	    ad[j] += xi * NV_DATA_P(ay[j])[i];
+    }
+    free(ay);
+
+    CAMLreturn(Val_unit);
+}
+
+/* Non-blocking reductions over arrays of local results.  A request is an
+   abstract block holding an MPI_Request; the array is kept alive by the
+   OCaml record that pairs them.  Without MPI-3, the reduction is completed
+   immediately.  */
+
+#define Request_val(v) ((MPI_Request *) Data_abstract_val(v))
+
+enum nvector_parallel_reduction_op {
+    VARIANT_NVECTOR_PARALLEL_REDUCTION_SUM = 0,
+    VARIANT_NVECTOR_PARALLEL_REDUCTION_MAX,
+    VARIANT_NVECTOR_PARALLEL_REDUCTION_MIN,
+};
+
+CAMLprim value sunml_nvec_par_start_allreduce(value vcomm, value vop,
+					      value vbuf)
+{
+    CAMLparam3(vcomm, vop, vbuf);
+    CAMLlocal1(vreq);
+    MPI_Op op;
+    int r;
+
+    switch (Int_val(vop)) {
+    case VARIANT_NVECTOR_PARALLEL_REDUCTION_MAX: op = MPI_MAX; break;
+    case VARIANT_NVECTOR_PARALLEL_REDUCTION_MIN: op = MPI_MIN; break;
+    default: op = MPI_SUM; break;
+    }
+
+    vreq = caml_alloc((sizeof(MPI_Request) + sizeof(value) - 1)
+		      / sizeof(value), Abstract_tag);
+#if MPI_VERSION >= 3
+    r = MPI_Iallreduce(MPI_IN_PLACE, REAL_ARRAY(vbuf), ARRAY1_LEN(vbuf),
+		       PVEC_REAL_MPI_TYPE, op, Comm_val(vcomm),
+		       Request_val(vreq));
+#else
+    r = MPI_Allreduce(MPI_IN_PLACE, REAL_ARRAY(vbuf), ARRAY1_LEN(vbuf),
+		      PVEC_REAL_MPI_TYPE, op, Comm_val(vcomm));
+    *Request_val(vreq) = MPI_REQUEST_NULL;
+#endif
+    if (r != MPI_SUCCESS)
+	caml_failwith("Nvector_parallel.Local.start_allreduce");
+
+    CAMLreturn(vreq);
+}
+
+CAMLprim value sunml_nvec_par_wait_allreduce(value vreq)
+{
+    CAMLparam1(vreq);
+
+    if (MPI_Wait(Request_val(vreq), MPI_STATUS_IGNORE) != MPI_SUCCESS)
+	caml_failwith("Nvector_parallel.Local.wait");
+
+    CAMLreturn(Val_unit);
+}
@@ -35,6 +35,14 @@
    The N_Vector ops are identical to those of a standard parallel N_Vector,
    except for nvclone, nvcloneempty, and nvdestroy which are functions,
    implemented in nvector_ml.c, to create the arrangement described here.
+
+   Hybrid parallel nvectors
+   ------------------------
+   The payload and the content are as for parallel nvectors, except that
+   the content is followed by the number of OpenMP threads over which the
+   local elements are distributed.  The N_Vector ops for the standard
+   operations and reductions are implemented in nvector_parallel_ml.c; the
+   other ops, including nvdestroy, are those of parallel nvectors.
 */
 
 // Creation functions
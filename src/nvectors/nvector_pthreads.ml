@@ -37,6 +37,20 @@ let wrap ?(with_fused_ops=false) nthreads v =
   if with_fused_ops then c_enablefusedops_pthreads nv true;
   nv
 
+external c_wrap_pooled : bool -> int -> RealArray.t
+                           -> (RealArray.t -> bool) -> t
+  = "sunml_nvec_wrap_pthreads_pooled"
+
+let wrap_pooled ?(pin=false) nthreads v =
+  let len = RealArray.length v in
+  c_wrap_pooled pin nthreads v (fun v' -> len = RealArray.length v')
+
+let make_pooled ?pin nthreads n iv =
+  wrap_pooled ?pin nthreads (RealArray.make n iv)
+
+external c_wrap_like : t -> RealArray.t -> (RealArray.t -> bool) -> t
+  = "sunml_nvec_wrap_pthreads_like"
+
 let unwrap = Nvector.unwrap
 
 let pp fmt v = RealArray.pp fmt (unwrap v)
@@ -92,8 +106,9 @@ module Ops = struct
   type t = (RealArray.t, kind) Nvector.t
 
   let n_vclone nv =
-    let data = Nvector.unwrap nv in
-    wrap (num_threads nv) (RealArray.copy data)
+    let data = RealArray.copy (Nvector.unwrap nv) in
+    let len = RealArray.length data in
+    c_wrap_like nv data (fun v' -> len = RealArray.length v')
 
   external n_vlinearsum    : float -> t -> float -> t -> t -> unit
     = "sunml_nvec_pthreads_n_vlinearsum"
@@ -119,26 +134,62 @@ module Ops = struct
   external n_vaddconst     : t -> float -> t -> unit
     = "sunml_nvec_pthreads_n_vaddconst"
 
-  external n_vdotprod      : t -> t -> float
-    = "sunml_nvec_pthreads_n_vdotprod"
+  (* The reductions are called without allocating or boxing their
+     results in native code; their lengths are checked here since
+     the native stubs cannot raise exceptions. *)
+  let check_lengths fn x y =
+    if RealArray.length (Nvector.unwrap x)
+       <> RealArray.length (Nvector.unwrap y)
+    then invalid_arg ("Nvector_pthreads." ^ fn)
+
+  external c_n_vdotprod    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_pthreads_n_vdotprod" "sunml_nvec_pthreads_n_vdotprod_unboxed"
+    [@@noalloc]
 
-  external n_vmaxnorm      : t -> float
-    = "sunml_nvec_pthreads_n_vmaxnorm"
+  let n_vdotprod x y =
+    if Sundials_configuration.safe then check_lengths "n_vdotprod" x y;
+    c_n_vdotprod x y
 
-  external n_vwrmsnorm     : t -> t -> float
+  external n_vmaxnorm      : t -> (float [@unboxed])
+    = "sunml_nvec_pthreads_n_vmaxnorm" "sunml_nvec_pthreads_n_vmaxnorm_unboxed"
+    [@@noalloc]
+
+  external c_n_vwrmsnorm   : t -> t -> (float [@unboxed])
     = "sunml_nvec_pthreads_n_vwrmsnorm"
+      "sunml_nvec_pthreads_n_vwrmsnorm_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnorm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwrmsnorm" x w;
+    c_n_vwrmsnorm x w
 
-  external n_vwrmsnormmask : t -> t -> t -> float
+  external c_n_vwrmsnormmask : t -> t -> t -> (float [@unboxed])
     = "sunml_nvec_pthreads_n_vwrmsnormmask"
+      "sunml_nvec_pthreads_n_vwrmsnormmask_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnormmask x w id =
+    if Sundials_configuration.safe then begin
+      check_lengths "n_vwrmsnormmask" x w;
+      check_lengths "n_vwrmsnormmask" x id
+    end;
+    c_n_vwrmsnormmask x w id
 
-  external n_vmin          : t -> float
-    = "sunml_nvec_pthreads_n_vmin"
+  external n_vmin          : t -> (float [@unboxed])
+    = "sunml_nvec_pthreads_n_vmin" "sunml_nvec_pthreads_n_vmin_unboxed"
+    [@@noalloc]
 
-  external n_vwl2norm      : t -> t -> float
-    = "sunml_nvec_pthreads_n_vwl2norm"
+  external c_n_vwl2norm    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_pthreads_n_vwl2norm" "sunml_nvec_pthreads_n_vwl2norm_unboxed"
+    [@@noalloc]
 
-  external n_vl1norm       : t -> float
-    = "sunml_nvec_pthreads_n_vl1norm"
+  let n_vwl2norm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwl2norm" x w;
+    c_n_vwl2norm x w
+
+  external n_vl1norm       : t -> (float [@unboxed])
+    = "sunml_nvec_pthreads_n_vl1norm" "sunml_nvec_pthreads_n_vl1norm_unboxed"
+    [@@noalloc]
 
   external n_vcompare      : float -> t -> t -> unit
     = "sunml_nvec_pthreads_n_vcompare"
@@ -149,8 +200,15 @@ module Ops = struct
   external n_vconstrmask   : t -> t -> t -> bool
     = "sunml_nvec_pthreads_n_vconstrmask"
 
-  external n_vminquotient  : t -> t -> float
+  external c_n_vminquotient : t -> t -> (float [@unboxed])
     = "sunml_nvec_pthreads_n_vminquotient"
+      "sunml_nvec_pthreads_n_vminquotient_unboxed"
+    [@@noalloc]
+
+  let n_vminquotient num denom =
+    if Sundials_configuration.safe then
+      check_lengths "n_vminquotient" num denom;
+    c_n_vminquotient num denom
 
   external n_vspace  : t -> int * int
     = "sunml_nvec_pthreads_n_vspace"
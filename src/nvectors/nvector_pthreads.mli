@@ -52,6 +52,30 @@ val make : ?with_fused_ops:bool -> int -> int -> float -> t
     @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
 val wrap : ?with_fused_ops:bool -> int -> RealArray.t -> t
 
+(** [wrap_pooled nthreads a] creates a Pthreads nvector over the elements of
+    [a] whose operations are executed by a pool of [nthreads] threads,
+    including the calling one, that is created once and shared with all
+    vectors cloned from it. Idle workers spin briefly before sleeping, and
+    each one always processes the same cache-line aligned chunk of the
+    vectors. Vectors with fewer than 4096 elements are processed by the
+    calling thread alone. The pool is stopped when the last vector that
+    shares it is reclaimed.
+
+    Setting [pin] binds each worker to a processor (the calling thread is
+    not bound). Fused and array operations are provided by the Sundials
+    defaults in terms of the pooled operations. The operations of {!Ops}
+    also run on the pool, and its [n_vclone] shares it. Operations on
+    vectors that share a pool are serialized, so such vectors may be used
+    from several threads, but only one operation runs at a time.
+
+    @raise Failure The threads could not be created. *)
+val wrap_pooled : ?pin:bool -> int -> RealArray.t -> t
+
+(** [make_pooled nthreads n iv] creates a new pooled Pthreads nvector
+    ({!wrap_pooled}) with [nthreads] threads and [n] elements initialized to
+    [iv]. *)
+val make_pooled : ?pin:bool -> int -> int -> float -> t
+
 (** Aliases {!Nvector.unwrap}. *)
 val unwrap : t -> RealArray.t
 
@@ -11,6 +11,11 @@
  *                                                                     *
  ***********************************************************************/
 
+/* for CPU_SET and pthread_setaffinity_np */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "../sundials/sundials_ml.h"
 #include "nvector_ml.h"
 #include "nvector_pthreads_ml.h"
@@ -25,6 +30,11 @@
 
 #include <nvector/nvector_pthreads.h>
 
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <math.h>
+
 /* Adapted from sundials-2.6.1/src/nvec_pthreads/nvector_pthreads.c:
    N_VCloneEmpty_Pthreads */
 static N_Vector clone_pthreads(N_Vector w)
@@ -42,14 +52,13 @@ static N_Vector clone_pthreads(N_Vector w)
     /* Create vector (we need not copy the data) */
     v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
 
-    v = sunml_alloc_cnvec(sizeof(struct _N_VectorContent_Pthreads), v_payload);
+    v = sunml_clone_cnvec(sizeof(struct _N_VectorContent_Pthreads), v_payload, w);
     if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
 
     content = (N_VectorContent_Pthreads) v->content;
 
-    /* Create vector operation structure */
-    sunml_clone_cnvec_ops(v, w);
-
     /* Create content */
     content->length      = NV_LENGTH_PT(w);
     content->num_threads = NV_NUM_THREADS_PT(w);
@@ -149,8 +158,665 @@ CAMLprim value sunml_nvec_pthreads_num_threads(value va)
     CAMLreturn(Val_int(num_threads));
 }
 
+/** Pthreads nvectors with a persistent worker pool */
+
+/* The Sundials Pthreads nvector creates and joins its threads in every
+   operation.  A pooled nvector instead shares, with all of its clones, a
+   pool of workers that are created once and that wait, spinning briefly
+   before sleeping, for the next operation.  The calling thread processes
+   the first chunk of each operation.  Chunks are the same for all
+   operations and are aligned to cache lines, so that each worker always
+   touches the same part of every vector.
+
+   The content of a pooled nvector is a standard Pthreads content followed
+   by a pointer to the pool, so the NV_*_PT macros remain valid.  The pool
+   is reference-counted by its vectors.  Since vectors that share a pool
+   may be used by sessions in different threads, each operation is
+   submitted, run, and reduced under the pool's submit lock.  */
+
+#define POOL_CACHE_LINE	    64
+#define POOL_CHUNK_ALIGN    (POOL_CACHE_LINE / sizeof(realtype))
+#define POOL_SPIN	    (1 << 14)
+#define POOL_MIN_PARALLEL   4096
+
+enum pool_op {
+    POOL_LINEARSUM, POOL_CONST, POOL_PROD, POOL_DIV, POOL_SCALE, POOL_ABS,
+    POOL_INV, POOL_ADDCONST, POOL_COMPARE, POOL_DOTPROD, POOL_MAXNORM,
+    POOL_WSQRSUM, POOL_WSQRSUMMASK, POOL_MIN, POOL_L1NORM, POOL_INVTEST,
+    POOL_CONSTRMASK, POOL_MINQUOTIENT,
+};
+
+struct pool_job {
+    enum pool_op op;
+    realtype a, b;
+    realtype *x, *y, *z, *w;
+    sundials_ml_index n, chunk;
+    realtype r;			/* result of a reduction */
+    booleantype flag;		/* result of a test */
+};
+
+/* One per thread, on its own cache line.  */
+struct pool_slot {
+    realtype r;
+    int flag;
+} __attribute__((aligned(POOL_CACHE_LINE)));
+
+struct pool {
+    int nthreads;		/* including the calling thread */
+    int refcount;
+    int pin;
+    int shutdown;
+    unsigned long generation;
+    int pending;
+    pthread_mutex_t submit;	/* serializes pool_run */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t *threads;
+    struct pool_slot *slots;
+    struct pool_job job;
+};
+
+struct pool_worker {
+    struct pool *pool;
+    int id;
+};
+
+struct pooled_content {
+    struct _N_VectorContent_Pthreads base;
+    struct pool *pool;
+};
+
+#define NV_POOL_PT(v) (((struct pooled_content *)(v)->content)->pool)
+
+static void pool_run_chunk(struct pool *pool, int id)
+{
+    struct pool_job *j = &pool->job;
+    struct pool_slot *slot = &pool->slots[id];
+    sundials_ml_index i, lo = id * j->chunk, hi = lo + j->chunk;
+    realtype *x = j->x, *y = j->y, *z = j->z, *w = j->w;
+    realtype a = j->a, b = j->b, r, p;
+    int flag = 1;
+
+    if (hi > j->n) hi = j->n;
+
+    switch (j->op) {
+    case POOL_LINEARSUM:
+	for (i = lo; i < hi; ++i) z[i] = a * x[i] + b * y[i];
+	break;
+    case POOL_CONST:
+	for (i = lo; i < hi; ++i) z[i] = a;
+	break;
+    case POOL_PROD:
+	for (i = lo; i < hi; ++i) z[i] = x[i] * y[i];
+	break;
+    case POOL_DIV:
+	for (i = lo; i < hi; ++i) z[i] = x[i] / y[i];
+	break;
+    case POOL_SCALE:
+	for (i = lo; i < hi; ++i) z[i] = a * x[i];
+	break;
+    case POOL_ABS:
+	for (i = lo; i < hi; ++i) z[i] = fabs(x[i]);
+	break;
+    case POOL_INV:
+	for (i = lo; i < hi; ++i) z[i] = 1.0 / x[i];
+	break;
+    case POOL_ADDCONST:
+	for (i = lo; i < hi; ++i) z[i] = x[i] + a;
+	break;
+    case POOL_COMPARE:
+	for (i = lo; i < hi; ++i) z[i] = (fabs(x[i]) >= a) ? 1.0 : 0.0;
+	break;
+    case POOL_DOTPROD:
+	for (r = 0.0, i = lo; i < hi; ++i) r += x[i] * y[i];
+	slot->r = r;
+	break;
+    case POOL_MAXNORM:
+	for (r = 0.0, i = lo; i < hi; ++i) if (fabs(x[i]) > r) r = fabs(x[i]);
+	slot->r = r;
+	break;
+    case POOL_WSQRSUM:
+	for (r = 0.0, i = lo; i < hi; ++i) { p = x[i] * w[i]; r += p * p; }
+	slot->r = r;
+	break;
+    case POOL_WSQRSUMMASK:
+	for (r = 0.0, i = lo; i < hi; ++i)
+	    if (y[i] > 0.0) { p = x[i] * w[i]; r += p * p; }
+	slot->r = r;
+	break;
+    case POOL_MIN:
+	for (r = BIG_REAL, i = lo; i < hi; ++i) if (x[i] < r) r = x[i];
+	slot->r = r;
+	break;
+    case POOL_L1NORM:
+	for (r = 0.0, i = lo; i < hi; ++i) r += fabs(x[i]);
+	slot->r = r;
+	break;
+    case POOL_INVTEST:
+	for (i = lo; i < hi; ++i) {
+	    if (x[i] == 0.0) flag = 0;
+	    else z[i] = 1.0 / x[i];
+	}
+	slot->flag = flag;
+	break;
+    case POOL_CONSTRMASK:
+	/* x = c, y = x, z = m */
+	for (i = lo; i < hi; ++i) {
+	    z[i] = 0.0;
+	    if (x[i] == 0.0) continue;
+	    if (x[i] > 1.5 || x[i] < -1.5) {
+		if (y[i] * x[i] <= 0.0) { flag = 0; z[i] = 1.0; }
+	    } else if (y[i] * x[i] < 0.0) { flag = 0; z[i] = 1.0; }
+	}
+	slot->flag = flag;
+	break;
+    case POOL_MINQUOTIENT:
+	for (r = BIG_REAL, i = lo; i < hi; ++i)
+	    if (y[i] != 0.0 && x[i] / y[i] < r) r = x[i] / y[i];
+	slot->r = r;
+	break;
+    }
+}
+
+static void *pool_worker_main(void *arg)
+{
+    struct pool_worker *wk = (struct pool_worker *)arg;
+    struct pool *pool = wk->pool;
+    int id = wk->id, spin;
+    unsigned long seen = 0, gen;
+
+    free(wk);
+
+#ifdef __linux__
+    if (pool->pin) {
+	cpu_set_t set;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	CPU_ZERO(&set);
+	CPU_SET(id % (ncpus > 0 ? ncpus : 1), &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    for (;;) {
+	for (spin = 0;
+	     spin < POOL_SPIN
+	     && (gen = __atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE))
+		== seen;
+	     ++spin) ;
+	if (gen == seen) {
+	    pthread_mutex_lock(&pool->lock);
+	    while ((gen = __atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE))
+		   == seen)
+		pthread_cond_wait(&pool->wake, &pool->lock);
+	    pthread_mutex_unlock(&pool->lock);
+	}
+	seen = gen;
+
+	if (pool->shutdown) break;
+	pool_run_chunk(pool, id);
+	__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_RELEASE);
+    }
+
+    return NULL;
+}
+
+static void pool_stop(struct pool *pool, int nstarted)
+{
+    int k;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    __atomic_add_fetch(&pool->generation, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (k = 0; k < nstarted; ++k) pthread_join(pool->threads[k], NULL);
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit);
+    free(pool->slots);
+    free(pool->threads);
+    free(pool);
+}
+
+static struct pool *pool_create(int nthreads, int pin)
+{
+    struct pool *pool;
+    struct pool_worker *wk;
+    int k;
+
+    if (nthreads < 1) nthreads = 1;
+    pool = calloc(1, sizeof(struct pool));
+    if (pool == NULL) return NULL;
+
+    pool->nthreads = nthreads;
+    pool->refcount = 0;
+    pool->pin = pin;
+    pool->threads = calloc(nthreads, sizeof(pthread_t));
+    if (posix_memalign((void **)&pool->slots, POOL_CACHE_LINE,
+		       nthreads * sizeof(struct pool_slot)) != 0)
+	pool->slots = NULL;
+    if (pool->threads == NULL || pool->slots == NULL) {
+	free(pool->threads);
+	free(pool->slots);
+	free(pool);
+	return NULL;
+    }
+    pthread_mutex_init(&pool->submit, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    /* pool->threads[k] runs chunk k + 1 */
+    for (k = 0; k < nthreads - 1; ++k) {
+	wk = malloc(sizeof(struct pool_worker));
+	if (wk != NULL) {
+	    wk->pool = pool;
+	    wk->id = k + 1;
+	}
+	if (wk == NULL
+		|| pthread_create(&pool->threads[k], NULL, pool_worker_main, wk)) {
+	    free(wk);
+	    pool_stop(pool, k);
+	    return NULL;
+	}
+    }
+
+    return pool;
+}
+
+static void pool_release(struct pool *pool)
+{
+    int refs;
+
+    pthread_mutex_lock(&pool->submit);
+    refs = --pool->refcount;
+    pthread_mutex_unlock(&pool->submit);
+    if (refs == 0) pool_stop(pool, pool->nthreads - 1);
+}
+
+static void pool_retain(struct pool *pool)
+{
+    pthread_mutex_lock(&pool->submit);
+    pool->refcount++;
+    pthread_mutex_unlock(&pool->submit);
+}
+
+/* Combines the results of the nt chunks into job->r or job->flag.  */
+static void pool_reduce(struct pool *pool, int nt, struct pool_job *job)
+{
+    realtype r;
+    booleantype flag = 1;
+    int k;
+
+    switch (job->op) {
+    case POOL_DOTPROD:
+    case POOL_WSQRSUM:
+    case POOL_WSQRSUMMASK:
+    case POOL_L1NORM:
+	for (r = 0.0, k = 0; k < nt; ++k) r += pool->slots[k].r;
+	job->r = r;
+	break;
+    case POOL_MAXNORM:
+	for (r = pool->slots[0].r, k = 1; k < nt; ++k)
+	    if (pool->slots[k].r > r) r = pool->slots[k].r;
+	job->r = r;
+	break;
+    case POOL_MIN:
+    case POOL_MINQUOTIENT:
+	for (r = pool->slots[0].r, k = 1; k < nt; ++k)
+	    if (pool->slots[k].r < r) r = pool->slots[k].r;
+	job->r = r;
+	break;
+    case POOL_INVTEST:
+    case POOL_CONSTRMASK:
+	for (k = 0; k < nt; ++k) if (!pool->slots[k].flag) flag = 0;
+	job->flag = flag;
+	break;
+    default:
+	break;
+    }
+}
+
+/* Runs the job on all threads, or only on the calling thread for short
+   vectors, and stores the result of a reduction or test in the job.  */
+static void pool_run(struct pool *pool, struct pool_job *job)
+{
+    int nt = (job->n < POOL_MIN_PARALLEL) ? 1 : pool->nthreads;
+    sundials_ml_index chunk = (job->n + nt - 1) / nt;
+
+    pthread_mutex_lock(&pool->submit);
+    chunk = (chunk + POOL_CHUNK_ALIGN - 1) / POOL_CHUNK_ALIGN
+	    * POOL_CHUNK_ALIGN;
+    job->chunk = (nt == 1) ? job->n : chunk;
+    pool->job = *job;
+
+    if (nt > 1) {
+	unsigned int spin = 0;
+
+	__atomic_store_n(&pool->pending, nt - 1, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&pool->lock);
+	__atomic_add_fetch(&pool->generation, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	pool_run_chunk(pool, 0);
+	while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0)
+	    if (++spin % POOL_SPIN == 0) sched_yield();
+    } else {
+	pool_run_chunk(pool, 0);
+    }
+
+    pool_reduce(pool, nt, job);
+    pthread_mutex_unlock(&pool->submit);
+}
+
+#define POOL_JOB(oper, va, vb, vx, vy, vz, vw, vn)			\
+    struct pool_job job = { (oper), (va), (vb), (vx), (vy), (vz), (vw),	\
+			    (vn), 0, 0.0, 1 }
+
+static void pooled_linearsum(realtype a, N_Vector x, realtype b, N_Vector y,
+			     N_Vector z)
+{
+    POOL_JOB(POOL_LINEARSUM, a, b, NV_DATA_PT(x), NV_DATA_PT(y),
+	     NV_DATA_PT(z), NULL, NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_const(realtype c, N_Vector z)
+{
+    POOL_JOB(POOL_CONST, c, 0.0, NULL, NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(z));
+    pool_run(NV_POOL_PT(z), &job);
+}
+
+static void pooled_prod(N_Vector x, N_Vector y, N_Vector z)
+{
+    POOL_JOB(POOL_PROD, 0.0, 0.0, NV_DATA_PT(x), NV_DATA_PT(y),
+	     NV_DATA_PT(z), NULL, NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_div(N_Vector x, N_Vector y, N_Vector z)
+{
+    POOL_JOB(POOL_DIV, 0.0, 0.0, NV_DATA_PT(x), NV_DATA_PT(y),
+	     NV_DATA_PT(z), NULL, NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_scale(realtype c, N_Vector x, N_Vector z)
+{
+    POOL_JOB(POOL_SCALE, c, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_abs(N_Vector x, N_Vector z)
+{
+    POOL_JOB(POOL_ABS, 0.0, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_inv(N_Vector x, N_Vector z)
+{
+    POOL_JOB(POOL_INV, 0.0, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_addconst(N_Vector x, realtype b, N_Vector z)
+{
+    POOL_JOB(POOL_ADDCONST, b, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static void pooled_compare(realtype c, N_Vector x, N_Vector z)
+{
+    POOL_JOB(POOL_COMPARE, c, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+}
+
+static realtype pooled_dotprod(N_Vector x, N_Vector y)
+{
+    POOL_JOB(POOL_DOTPROD, 0.0, 0.0, NV_DATA_PT(x), NV_DATA_PT(y), NULL, NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.r;
+}
+
+static realtype pooled_maxnorm(N_Vector x)
+{
+    POOL_JOB(POOL_MAXNORM, 0.0, 0.0, NV_DATA_PT(x), NULL, NULL, NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.r;
+}
+
+static realtype pooled_wrmsnorm(N_Vector x, N_Vector w)
+{
+    sundials_ml_index n = NV_LENGTH_PT(x);
+    POOL_JOB(POOL_WSQRSUM, 0.0, 0.0, NV_DATA_PT(x), NULL, NULL, NV_DATA_PT(w),
+	     n);
+    pool_run(NV_POOL_PT(x), &job);
+    return (n == 0) ? 0.0 : sqrt(job.r / n);
+}
+
+static realtype pooled_wrmsnormmask(N_Vector x, N_Vector w, N_Vector id)
+{
+    sundials_ml_index n = NV_LENGTH_PT(x);
+    POOL_JOB(POOL_WSQRSUMMASK, 0.0, 0.0, NV_DATA_PT(x), NV_DATA_PT(id), NULL,
+	     NV_DATA_PT(w), n);
+    pool_run(NV_POOL_PT(x), &job);
+    return (n == 0) ? 0.0 : sqrt(job.r / n);
+}
+
+static realtype pooled_min(N_Vector x)
+{
+    POOL_JOB(POOL_MIN, 0.0, 0.0, NV_DATA_PT(x), NULL, NULL, NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.r;
+}
+
+static realtype pooled_wl2norm(N_Vector x, N_Vector w)
+{
+    POOL_JOB(POOL_WSQRSUM, 0.0, 0.0, NV_DATA_PT(x), NULL, NULL, NV_DATA_PT(w),
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return sqrt(job.r);
+}
+
+static realtype pooled_l1norm(N_Vector x)
+{
+    POOL_JOB(POOL_L1NORM, 0.0, 0.0, NV_DATA_PT(x), NULL, NULL, NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.r;
+}
+
+static booleantype pooled_invtest(N_Vector x, N_Vector z)
+{
+    POOL_JOB(POOL_INVTEST, 0.0, 0.0, NV_DATA_PT(x), NULL, NV_DATA_PT(z), NULL,
+	     NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.flag;
+}
+
+static booleantype pooled_constrmask(N_Vector c, N_Vector x, N_Vector m)
+{
+    POOL_JOB(POOL_CONSTRMASK, 0.0, 0.0, NV_DATA_PT(c), NV_DATA_PT(x),
+	     NV_DATA_PT(m), NULL, NV_LENGTH_PT(x));
+    pool_run(NV_POOL_PT(x), &job);
+    return job.flag;
+}
+
+static realtype pooled_minquotient(N_Vector num, N_Vector denom)
+{
+    POOL_JOB(POOL_MINQUOTIENT, 0.0, 0.0, NV_DATA_PT(num), NV_DATA_PT(denom),
+	     NULL, NULL, NV_LENGTH_PT(num));
+    pool_run(NV_POOL_PT(num), &job);
+    return job.r;
+}
+
+#undef POOL_JOB
+
+static void free_pooled_cnvec(N_Vector v)
+{
+    pool_release(NV_POOL_PT(v));
+    sunml_free_cnvec(v);
+}
+
+static void finalize_pooled_caml_nvec(value vnv)
+{
+    free_pooled_cnvec(NVEC_CVAL(vnv));
+}
+
+static N_Vector clone_pooled(N_Vector w)
+{
+    CAMLparam0();
+    CAMLlocal2(v_payload, w_payload);
+
+    N_Vector v;
+    N_VectorContent_Pthreads content;
+
+    if (w == NULL) CAMLreturnT(N_Vector, NULL);
+    w_payload = NVEC_BACKLINK(w);
+    struct caml_ba_array *w_ba = Caml_ba_array_val(w_payload);
+
+    v_payload = caml_ba_alloc(w_ba->flags, w_ba->num_dims, NULL, w_ba->dim);
+
+    v = sunml_clone_cnvec(sizeof(struct pooled_content), v_payload, w);
+    if (v == NULL) CAMLreturnT (N_Vector, NULL);
+    sunml_nvec_account_payload(v,
+	caml_ba_byte_size(Caml_ba_array_val(v_payload)));
+
+    content = (N_VectorContent_Pthreads) v->content;
+
+    content->length      = NV_LENGTH_PT(w);
+    content->num_threads = NV_NUM_THREADS_PT(w);
+    content->own_data    = 0;
+    content->data        = Caml_ba_data_val(v_payload);
+    NV_POOL_PT(v) = NV_POOL_PT(w);
+    pool_retain(NV_POOL_PT(v));
+
+    CAMLreturnT(N_Vector, v);
+}
+
+/* Wraps payload in a pooled nvector that runs its operations on pool and
+   holds a reference to it.  */
+static value wrap_pooled(struct pool *pool, value payload, value checkfn)
+{
+    CAMLparam2(payload, checkfn);
+    CAMLlocal1(vnvec);
+
+    N_Vector nv;
+    N_Vector_Ops ops;
+    N_VectorContent_Pthreads content;
+    long int length = (Caml_ba_array_val(payload))->dim[0];
+
+    nv = sunml_alloc_cnvec(sizeof(struct pooled_content), payload);
+    if (nv == NULL) {
+	if (pool->refcount == 0) pool_stop(pool, pool->nthreads - 1);
+	caml_raise_out_of_memory();
+    }
+    ops = (N_Vector_Ops) nv->ops;
+    content = (N_VectorContent_Pthreads) nv->content;
+
+    ops->nvclone           = clone_pooled;
+    ops->nvcloneempty      = NULL;
+    ops->nvdestroy         = free_pooled_cnvec;
+#if SUNDIALS_LIB_VERSION >= 270
+    ops->nvgetvectorid	   = N_VGetVectorID_Pthreads;
+#endif
+
+    ops->nvspace           = N_VSpace_Pthreads;
+    ops->nvgetarraypointer = N_VGetArrayPointer_Pthreads;
+    ops->nvsetarraypointer = N_VSetArrayPointer_Pthreads;
+    ops->nvlinearsum       = pooled_linearsum;
+    ops->nvconst           = pooled_const;
+    ops->nvprod            = pooled_prod;
+    ops->nvdiv             = pooled_div;
+    ops->nvscale           = pooled_scale;
+    ops->nvabs             = pooled_abs;
+    ops->nvinv             = pooled_inv;
+    ops->nvaddconst        = pooled_addconst;
+    ops->nvdotprod         = pooled_dotprod;
+    ops->nvmaxnorm         = pooled_maxnorm;
+    ops->nvwrmsnormmask    = pooled_wrmsnormmask;
+    ops->nvwrmsnorm        = pooled_wrmsnorm;
+    ops->nvmin             = pooled_min;
+    ops->nvwl2norm         = pooled_wl2norm;
+    ops->nvl1norm          = pooled_l1norm;
+    ops->nvcompare         = pooled_compare;
+    ops->nvinvtest         = pooled_invtest;
+    ops->nvconstrmask      = pooled_constrmask;
+    ops->nvminquotient     = pooled_minquotient;
+
+#if SUNDIALS_LIB_VERSION >= 400
+    /* fused and array operations use the Sundials defaults */
+    ops->nvlinearcombination = NULL;
+    ops->nvscaleaddmulti     = NULL;
+    ops->nvdotprodmulti      = NULL;
+
+    ops->nvlinearsumvectorarray         = NULL;
+    ops->nvscalevectorarray             = NULL;
+    ops->nvconstvectorarray             = NULL;
+    ops->nvwrmsnormvectorarray          = NULL;
+    ops->nvwrmsnormmaskvectorarray      = NULL;
+    ops->nvscaleaddmultivectorarray     = NULL;
+    ops->nvlinearcombinationvectorarray = NULL;
+#endif
+
+    content->length      = length;
+    content->num_threads = pool->nthreads;
+    content->own_data    = 0;
+    content->data        = Caml_ba_data_val(payload);
+    NV_POOL_PT(nv) = pool;
+    pool_retain(pool);
+
+    vnvec = caml_alloc_tuple(3);
+    Store_field(vnvec, 0, payload);
+    Store_field(vnvec, 1, sunml_alloc_caml_nvec(nv, finalize_pooled_caml_nvec));
+    Store_field(vnvec, 2, checkfn);
+
+    CAMLreturn(vnvec);
+}
+
+CAMLprim value sunml_nvec_wrap_pthreads_pooled(value vpin, value nthreads,
+					       value payload, value checkfn)
+{
+    CAMLparam4(vpin, nthreads, payload, checkfn);
+    struct pool *pool;
+
+    pool = pool_create(Int_val(nthreads), Bool_val(vpin));
+    if (pool == NULL)
+	caml_failwith("Nvector_pthreads.wrap_pooled: cannot create threads");
+
+    CAMLreturn(wrap_pooled(pool, payload, checkfn));
+}
+
+/* Wraps payload like vx: in a pooled nvector sharing the pool of vx if it
+   has one, and otherwise in a Pthreads nvector with as many threads.  */
+CAMLprim value sunml_nvec_wrap_pthreads_like(value vx, value payload,
+					     value checkfn)
+{
+    CAMLparam3(vx, payload, checkfn);
+    N_Vector x = NVEC_VAL(vx);
+
+    if (x->ops->nvclone == clone_pooled)
+	CAMLreturn(wrap_pooled(NV_POOL_PT(x), payload, checkfn));
+    CAMLreturn(sunml_nvec_wrap_pthreads(Val_int(NV_NUM_THREADS_PT(x)),
+					payload, checkfn));
+}
+
 /** Interface to underlying pthreads nvector functions */
 
+/* The operations are called through the ops table, so that those of a
+   pooled nvector are run by its pool.  */
+
 CAMLprim value sunml_nvec_pthreads_n_vlinearsum(value va, value vx, value vb,
 					     value vy, value vz)
 {
@@ -164,14 +830,14 @@ CAMLprim value sunml_nvec_pthreads_n_vlinearsum(value va, value vx, value vb,
 	caml_invalid_argument("Nvector_pthreads.n_vlinearsum");
 #endif
 
-    N_VLinearSum_Pthreads(Double_val(va), x, Double_val(vb), y, z);
+    N_VLinearSum(Double_val(va), x, Double_val(vb), y, z);
     CAMLreturn (Val_unit);
 }
 
 CAMLprim value sunml_nvec_pthreads_n_vconst(value vc, value vz)
 {
     CAMLparam2(vc, vz);
-    N_VConst_Pthreads(Double_val(vc), NVEC_VAL(vz));
+    N_VConst(Double_val(vc), NVEC_VAL(vz));
     CAMLreturn (Val_unit);
 }
 
@@ -187,7 +853,7 @@ CAMLprim value sunml_nvec_pthreads_n_vprod(value vx, value vy, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vprod");
 #endif
 
-    N_VProd_Pthreads(x, y, z);
+    N_VProd(x, y, z);
     CAMLreturn (Val_unit);
 }
 
@@ -203,7 +869,7 @@ CAMLprim value sunml_nvec_pthreads_n_vdiv(value vx, value vy, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vdiv");
 #endif
 
-    N_VDiv_Pthreads(x, y, z);
+    N_VDiv(x, y, z);
     CAMLreturn (Val_unit);
 }
 
@@ -218,7 +884,7 @@ CAMLprim value sunml_nvec_pthreads_n_vscale(value vc, value vx, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vscale");
 #endif
 
-    N_VScale_Pthreads(Double_val(vc), x, z);
+    N_VScale(Double_val(vc), x, z);
     CAMLreturn (Val_unit);
 }
 
@@ -233,7 +899,7 @@ CAMLprim value sunml_nvec_pthreads_n_vabs(value vx, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vabs");
 #endif
 
-    N_VAbs_Pthreads(x, z);
+    N_VAbs(x, z);
     CAMLreturn (Val_unit);
 }
 
@@ -248,7 +914,7 @@ CAMLprim value sunml_nvec_pthreads_n_vinv(value vx, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vinv");
 #endif
 
-    N_VInv_Pthreads(x, z);
+    N_VInv(x, z);
     CAMLreturn (Val_unit);
 }
 
@@ -263,7 +929,7 @@ CAMLprim value sunml_nvec_pthreads_n_vaddconst(value vx, value vb, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vaddconst");
 #endif
 
-    N_VAddConst_Pthreads(x, Double_val(vb), z);
+    N_VAddConst(x, Double_val(vb), z);
     CAMLreturn (Val_unit);
 }
 
@@ -278,14 +944,14 @@ CAMLprim value sunml_nvec_pthreads_n_vdotprod(value vx, value vy)
 	caml_invalid_argument("Nvector_pthreads.n_vdotprod");
 #endif
 
-    realtype r = N_VDotProd_Pthreads(x, y);
+    realtype r = N_VDotProd(x, y);
     CAMLreturn(caml_copy_double(r));
 }
 
 CAMLprim value sunml_nvec_pthreads_n_vmaxnorm(value vx)
 {
     CAMLparam1(vx);
-    realtype r = N_VMaxNorm_Pthreads(NVEC_VAL(vx));
+    realtype r = N_VMaxNorm(NVEC_VAL(vx));
     CAMLreturn(caml_copy_double(r));
 }
 
@@ -300,7 +966,7 @@ CAMLprim value sunml_nvec_pthreads_n_vwrmsnorm(value vx, value vw)
 	caml_invalid_argument("Nvector_pthreads.n_vwrmsnorm");
 #endif
 
-    realtype r = N_VWrmsNorm_Pthreads(x, w);
+    realtype r = N_VWrmsNorm(x, w);
     CAMLreturn(caml_copy_double(r));
 }
 
@@ -316,14 +982,14 @@ CAMLprim value sunml_nvec_pthreads_n_vwrmsnormmask(value vx, value vw, value vid
 	caml_invalid_argument("Nvector_pthreads.n_vwrmsnormmask");
 #endif
 
-    realtype r = N_VWrmsNormMask_Pthreads(x, w, id);
+    realtype r = N_VWrmsNormMask(x, w, id);
     CAMLreturn(caml_copy_double(r));
 }
 
 CAMLprim value sunml_nvec_pthreads_n_vmin(value vx)
 {
     CAMLparam1(vx);
-    realtype r = N_VMin_Pthreads(NVEC_VAL(vx));
+    realtype r = N_VMin(NVEC_VAL(vx));
     CAMLreturn(caml_copy_double(r));
 }
 
@@ -338,14 +1004,14 @@ CAMLprim value sunml_nvec_pthreads_n_vwl2norm(value vx, value vw)
 	caml_invalid_argument("Nvector_pthreads.n_vwl2norm");
 #endif
 
-    realtype r = N_VWL2Norm_Pthreads(x, w);
+    realtype r = N_VWL2Norm(x, w);
     CAMLreturn(caml_copy_double(r));
 }
 
 CAMLprim value sunml_nvec_pthreads_n_vl1norm(value vx)
 {
     CAMLparam1(vx);
-    realtype r = N_VL1Norm_Pthreads(NVEC_VAL(vx));
+    realtype r = N_VL1Norm(NVEC_VAL(vx));
     CAMLreturn(caml_copy_double(r));
 }
 
@@ -360,7 +1026,7 @@ CAMLprim value sunml_nvec_pthreads_n_vcompare(value vc, value vx, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vcompare");
 #endif
 
-    N_VCompare_Pthreads(Double_val(vc), x, z);
+    N_VCompare(Double_val(vc), x, z);
     CAMLreturn (Val_unit);
 }
 
@@ -375,7 +1041,7 @@ CAMLprim value sunml_nvec_pthreads_n_vinvtest(value vx, value vz)
 	caml_invalid_argument("Nvector_pthreads.n_vinvtest");
 #endif
 
-    booleantype r = N_VInvTest_Pthreads(x, z);
+    booleantype r = N_VInvTest(x, z);
     CAMLreturn(Val_bool(r));
 }
 
@@ -391,7 +1057,7 @@ CAMLprim value sunml_nvec_pthreads_n_vconstrmask(value vc, value vx, value vm)
 	caml_invalid_argument("Nvector_pthreads.n_vconstrmask");
 #endif
 
-    booleantype r = N_VConstrMask_Pthreads(c, x, m);
+    booleantype r = N_VConstrMask(c, x, m);
     CAMLreturn(Val_bool(r));
 }
 
@@ -406,17 +1072,62 @@ CAMLprim value sunml_nvec_pthreads_n_vminquotient(value vnum, value vdenom)
 	caml_invalid_argument("Nvector_pthreads.n_vminquotient");
 #endif
 
-    realtype r = N_VMinQuotient_Pthreads(num, denom);
+    realtype r = N_VMinQuotient(num, denom);
     CAMLreturn(caml_copy_double(r));
 }
 
+/* Native-code entry points for the reductions above.  They neither
+ * allocate nor raise, and are declared [@@noalloc] with unboxed results;
+ * the lengths are checked on the OCaml side (see Nvector_pthreads.Ops).  */
+
+CAMLprim double sunml_nvec_pthreads_n_vdotprod_unboxed(value vx, value vy)
+{
+    return N_VDotProd(NVEC_VAL(vx), NVEC_VAL(vy));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vmaxnorm_unboxed(value vx)
+{
+    return N_VMaxNorm(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vwrmsnorm_unboxed(value vx, value vw)
+{
+    return N_VWrmsNorm(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vwrmsnormmask_unboxed(value vx, value vw,
+						       value vid)
+{
+    return N_VWrmsNormMask(NVEC_VAL(vx), NVEC_VAL(vw), NVEC_VAL(vid));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vmin_unboxed(value vx)
+{
+    return N_VMin(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vwl2norm_unboxed(value vx, value vw)
+{
+    return N_VWL2Norm(NVEC_VAL(vx), NVEC_VAL(vw));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vl1norm_unboxed(value vx)
+{
+    return N_VL1Norm(NVEC_VAL(vx));
+}
+
+CAMLprim double sunml_nvec_pthreads_n_vminquotient_unboxed(value vnum, value vdenom)
+{
+    return N_VMinQuotient(NVEC_VAL(vnum), NVEC_VAL(vdenom));
+}
+
 CAMLprim value sunml_nvec_pthreads_n_vspace(value vx)
 {
     CAMLparam1(vx);
     CAMLlocal1(r);
     sundials_ml_index lrw, liw;
 
-    N_VSpace_Pthreads(NVEC_VAL(vx), &lrw, &liw);
+    N_VSpace(NVEC_VAL(vx), &lrw, &liw);
 
     r = caml_alloc_tuple(2);
     Store_field(r, 0, Val_index(lrw));
@@ -443,7 +1154,7 @@ CAMLprim value sunml_nvec_pthreads_n_vlinearcombination(value vac, value vax,
 	caml_invalid_argument("Nvector_pthreads.n_vlinearcombination");
 #endif
 
-    N_VLinearCombination_Pthreads(nvec, ac, ax, z);
+    N_VLinearCombination(nvec, ac, ax, z);
     free(ax);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -467,7 +1178,7 @@ CAMLprim value sunml_nvec_pthreads_n_vscaleaddmulti(value vac, value vx, value v
 	caml_invalid_argument("Nvector_pthreads.n_vscaleaddmulti");
 #endif
 
-    N_VScaleAddMulti_Pthreads(nvec, ac, x, a[0], a[1]);
+    N_VScaleAddMulti(nvec, ac, x, a[0], a[1]);
     free(*a);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -490,7 +1201,7 @@ CAMLprim value sunml_nvec_pthreads_n_vdotprodmulti(value vx, value vay, value va
 	caml_invalid_argument("Nvector_pthreads.n_vdotprodmulti");
 #endif
 
-    N_VDotProdMulti_Pthreads(nvec, x, ay, ad);
+    N_VDotProdMulti(nvec, x, ay, ad);
     free(ay);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -514,8 +1225,8 @@ CAMLprim value sunml_nvec_pthreads_n_vlinearsumvectorarray(value va, value vax,
     if (!nvec) caml_invalid_argument("Nvector_pthreads.n_vlinearsumvectorarray");
 #endif
 
-    N_VLinearSumVectorArray_Pthreads(nvec, Double_val(va), a[0],
-					 Double_val(vb), a[1], a[2]);
+    N_VLinearSumVectorArray(nvec, Double_val(va), a[0],
+			    Double_val(vb), a[1], a[2]);
     free(*a);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -537,7 +1248,7 @@ CAMLprim value sunml_nvec_pthreads_n_vscalevectorarray(value vac, value vax,
 	caml_invalid_argument("Nvector_pthreads.n_vscalevectorarray");
 #endif
 
-    N_VScaleVectorArray_Pthreads(nvec, ac, a[0], a[1]);
+    N_VScaleVectorArray(nvec, ac, a[0], a[1]);
     free(*a);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -556,7 +1267,7 @@ CAMLprim value sunml_nvec_pthreads_n_vconstvectorarray(value vc, value vaz)
     if (!nvec) caml_invalid_argument("Nvector_pthreads.n_vconstvectorarray");
 #endif
 
-    N_VConstVectorArray_Pthreads(nvec, Double_val(vc), az);
+    N_VConstVectorArray(nvec, Double_val(vc), az);
     free(az);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -578,7 +1289,7 @@ CAMLprim value sunml_nvec_pthreads_n_vwrmsnormvectorarray(value vax, value vaw,
 	caml_invalid_argument("Nvector_pthreads.n_vconstvectorarray");
 #endif
 
-    N_VWrmsNormVectorArray_Pthreads(nvec, a[0], a[1], an);
+    N_VWrmsNormVectorArray(nvec, a[0], a[1], an);
     free(*a);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -602,7 +1313,7 @@ CAMLprim value sunml_nvec_pthreads_n_vwrmsnormmaskvectorarray(value vax,
 	caml_invalid_argument("Nvector_pthreads.n_vconstvectorarray");
 #endif
 
-    N_VWrmsNormMaskVectorArray_Pthreads(nvec, a[0], a[1], i, an);
+    N_VWrmsNormMaskVectorArray(nvec, a[0], a[1], i, an);
     free(*a);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -630,7 +1341,7 @@ CAMLprim value sunml_nvec_pthreads_n_vscaleaddmultivectorarray(value vaa,
     }
 #endif
 
-    N_VScaleAddMultiVectorArray_Pthreads(nvec, nsum, aa, ax, ayz[0], ayz[1]);
+    N_VScaleAddMultiVectorArray(nvec, nsum, aa, ax, ayz[0], ayz[1]);
     free(ax);
     free(*ayz);
 #else
@@ -660,7 +1371,7 @@ CAMLprim value sunml_nvec_pthreads_n_vlinearcombinationvectorarray(value vac,
     }
 #endif
 
-    N_VLinearCombinationVectorArray_Pthreads(nvec, nsum, ac, aax, az);
+    N_VLinearCombinationVectorArray(nvec, nsum, ac, aax, az);
     free(aax);
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
@@ -675,7 +1386,8 @@ CAMLprim value sunml_nvec_pthreads_enablefusedops(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableFusedOps_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableFusedOps_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -686,7 +1398,8 @@ CAMLprim value sunml_nvec_pthreads_enablelinearcombination(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombination_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombination_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -697,7 +1410,8 @@ CAMLprim value sunml_nvec_pthreads_enablescaleaddmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMulti_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMulti_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -708,7 +1422,8 @@ CAMLprim value sunml_nvec_pthreads_enabledotprodmulti(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableDotProdMulti_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableDotProdMulti_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -719,7 +1434,8 @@ CAMLprim value sunml_nvec_pthreads_enablelinearsumvectorarray(value vx, value vv
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearSumVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearSumVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -730,7 +1446,8 @@ CAMLprim value sunml_nvec_pthreads_enablescalevectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -741,7 +1458,8 @@ CAMLprim value sunml_nvec_pthreads_enableconstvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableConstVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableConstVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -752,7 +1470,8 @@ CAMLprim value sunml_nvec_pthreads_enablewrmsnormvectorarray(value vx, value vv)
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -763,7 +1482,8 @@ CAMLprim value sunml_nvec_pthreads_enablewrmsnormmaskvectorarray(value vx, value
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableWrmsNormMaskVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableWrmsNormMaskVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -774,7 +1494,8 @@ CAMLprim value sunml_nvec_pthreads_enablescaleaddmultivectorarray(value vx, valu
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableScaleAddMultiVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableScaleAddMultiVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
@@ -785,7 +1506,8 @@ CAMLprim value sunml_nvec_pthreads_enablelinearcombinationvectorarray(value vx,
 {
     CAMLparam2(vx, vv);
 #if 400 <= SUNDIALS_LIB_VERSION
-    N_VEnableLinearCombinationVectorArray_Pthreads(NVEC_VAL(vx), Bool_val(vv));
+    N_Vector x = sunml_nvec_own_ops(NVEC_VAL(vx));
+    N_VEnableLinearCombinationVectorArray_Pthreads(x, Bool_val(vv));
 #else
     caml_raise_constant(SUNDIALS_EXN(NotImplementedBySundialsVersion));
 #endif
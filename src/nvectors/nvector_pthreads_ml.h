@@ -32,6 +32,12 @@
    The N_Vector ops are identical to those of a standard Pthreads N_Vector,
    except for nvclone, nvcloneempty, and nvdestroy which are functions,
    implemented in nvector_ml.c, to create the arrangement described here.
+
+   Pooled Pthreads nvectors
+   ------------------------
+   As above, except that the content is followed by a pointer to a pool of
+   worker threads shared by all clones, and that the standard operations
+   are implemented in nvector_pthreads_ml.c to run on that pool.
 */
 
 // Creation functions
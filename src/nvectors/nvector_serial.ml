@@ -41,6 +41,64 @@ let wrap ?(with_fused_ops=false) v =
 
 let make ?with_fused_ops n iv = wrap ?with_fused_ops (RealArray.make n iv)
 
+external c_init_scratch : unit -> unit
+  = "sunml_nvec_serial_init_scratch"
+
+let _ = c_init_scratch ()
+
+external c_wrap_scratch : string option ref -> RealArray.t
+                           -> (RealArray.t -> bool) -> t
+  = "sunml_nvec_wrap_serial_scratch"
+
+let wrap_with_scratch ?(with_fused_ops=false) dir v =
+  let len = RealArray.length v in
+  let nv = c_wrap_scratch (ref (Some dir)) v
+                          (fun v' -> len = RealArray.length v') in
+  if with_fused_ops then c_enablefusedops_serial nv true;
+  nv
+
+let make_with_scratch ?with_fused_ops dir n iv =
+  wrap_with_scratch ?with_fused_ops dir (RealArray.make n iv)
+
+external set_scratch_dir : t -> string option -> unit
+  = "sunml_nvec_serial_set_scratch_dir"
+
+external c_wrap_block : (unit -> RealArray.t) -> RealArray.t
+                         -> (RealArray.t -> bool) -> t
+  = "sunml_nvec_wrap_serial_block"
+
+external c_enableblockops : t -> unit
+  = "sunml_nvec_ser_enableblockops"
+
+(* Hands out the successive columns of blocks of ns vectors of length n. *)
+let block_allocator ns n =
+  let blk = ref RealArray2.empty and next = ref ns in
+  fun () ->
+    if !next >= ns then (blk := RealArray2.create n ns; next := 0);
+    let c = RealArray2.col !blk !next in
+    incr next;
+    c
+
+let wrap_block ?(with_fused_ops=false) a =
+  let n, ns = RealArray2.size a in
+  let alloc = block_allocator ns n in
+  let wrap_col j =
+    let nv = c_wrap_block alloc (RealArray2.col a j)
+                          (fun v' -> n = RealArray.length v') in
+    if with_fused_ops then c_enablefusedops_serial nv true;
+    c_enableblockops nv;
+    nv
+  in
+  Array.init ns wrap_col
+
+let make_block ?with_fused_ops ns n iv =
+  wrap_block ?with_fused_ops (RealArray2.make n ns iv)
+
+external c_sync : RealArray.t -> unit
+  = "sunml_nvec_sync_array"
+
+let sync nv = c_sync (Nvector.unwrap nv)
+
 let unwrap = Nvector.unwrap
 
 let pp fmt v = RealArray.pp fmt (unwrap v)
@@ -86,6 +144,9 @@ let enable
     do_enable c_enablelinearcombinationvectorarray_serial nv
               with_linear_combination_vector_array
 
+external enable_simd_ops : t -> bool -> unit
+  = "sunml_nvec_ser_enablesimdops"
+
 module Ops = struct
   type t = (RealArray.t, kind) Nvector.t
 
@@ -117,26 +178,60 @@ module Ops = struct
   external n_vaddconst     : t -> float -> t -> unit
     = "sunml_nvec_ser_n_vaddconst"
 
-  external n_vdotprod      : t -> t -> float
-    = "sunml_nvec_ser_n_vdotprod"
-
-  external n_vmaxnorm      : t -> float
-    = "sunml_nvec_ser_n_vmaxnorm"
-
-  external n_vwrmsnorm     : t -> t -> float
-    = "sunml_nvec_ser_n_vwrmsnorm"
-
-  external n_vwrmsnormmask : t -> t -> t -> float
-    = "sunml_nvec_ser_n_vwrmsnormmask"
-
-  external n_vmin          : t -> float
-    = "sunml_nvec_ser_n_vmin"
-
-  external n_vwl2norm      : t -> t -> float
-    = "sunml_nvec_ser_n_vwl2norm"
-
-  external n_vl1norm       : t -> float
-    = "sunml_nvec_ser_n_vl1norm"
+  (* The reductions are called without allocating or boxing their
+     results in native code; their lengths are checked here since
+     the native stubs cannot raise exceptions. *)
+  let check_lengths fn x y =
+    if RealArray.length (Nvector.unwrap x)
+       <> RealArray.length (Nvector.unwrap y)
+    then invalid_arg ("Nvector_serial." ^ fn)
+
+  external c_n_vdotprod    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vdotprod" "sunml_nvec_ser_n_vdotprod_unboxed"
+    [@@noalloc]
+
+  let n_vdotprod x y =
+    if Sundials_configuration.safe then check_lengths "n_vdotprod" x y;
+    c_n_vdotprod x y
+
+  external n_vmaxnorm      : t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vmaxnorm" "sunml_nvec_ser_n_vmaxnorm_unboxed"
+    [@@noalloc]
+
+  external c_n_vwrmsnorm   : t -> t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vwrmsnorm" "sunml_nvec_ser_n_vwrmsnorm_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnorm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwrmsnorm" x w;
+    c_n_vwrmsnorm x w
+
+  external c_n_vwrmsnormmask : t -> t -> t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vwrmsnormmask" "sunml_nvec_ser_n_vwrmsnormmask_unboxed"
+    [@@noalloc]
+
+  let n_vwrmsnormmask x w id =
+    if Sundials_configuration.safe then begin
+      check_lengths "n_vwrmsnormmask" x w;
+      check_lengths "n_vwrmsnormmask" x id
+    end;
+    c_n_vwrmsnormmask x w id
+
+  external n_vmin          : t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vmin" "sunml_nvec_ser_n_vmin_unboxed"
+    [@@noalloc]
+
+  external c_n_vwl2norm    : t -> t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vwl2norm" "sunml_nvec_ser_n_vwl2norm_unboxed"
+    [@@noalloc]
+
+  let n_vwl2norm x w =
+    if Sundials_configuration.safe then check_lengths "n_vwl2norm" x w;
+    c_n_vwl2norm x w
+
+  external n_vl1norm       : t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vl1norm" "sunml_nvec_ser_n_vl1norm_unboxed"
+    [@@noalloc]
 
   external n_vcompare      : float -> t -> t -> unit
     = "sunml_nvec_ser_n_vcompare"
@@ -147,8 +242,14 @@ module Ops = struct
   external n_vconstrmask   : t -> t -> t -> bool
     = "sunml_nvec_ser_n_vconstrmask"
 
-  external n_vminquotient  : t -> t -> float
-    = "sunml_nvec_ser_n_vminquotient"
+  external c_n_vminquotient : t -> t -> (float [@unboxed])
+    = "sunml_nvec_ser_n_vminquotient" "sunml_nvec_ser_n_vminquotient_unboxed"
+    [@@noalloc]
+
+  let n_vminquotient num denom =
+    if Sundials_configuration.safe then
+      check_lengths "n_vminquotient" num denom;
+    c_n_vminquotient num denom
 
   external n_vspace  : t -> int * int
     = "sunml_nvec_ser_n_vspace"
@@ -48,6 +48,17 @@ val make : ?with_fused_ops:bool -> int -> float -> t
 
 (** [wrap a] creates a new serial nvector over the elements of [a].
 
+    The array [a] may be mapped from a file, for example,
+{[
+let fd = Unix.openfile "state.bin" [Unix.O_RDWR; Unix.O_CREAT] 0o644 in
+let a = Bigarray.array1_of_genarray
+          (Unix.map_file fd RealArray.kind Bigarray.c_layout true [|n|]) in
+let y = Nvector_serial.wrap a
+]}
+    so that the state of a very large system need not fit in memory.
+    Saving such a state reduces to a call to {!sync}, and restarting from it
+    to mapping the same file again.
+
     The optional arguments permit to enable all the fused and array operations
     for a given nvector (they are disabled by default).
 
@@ -55,6 +66,77 @@ val make : ?with_fused_ops:bool -> int -> float -> t
     @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
 val wrap : ?with_fused_ops:bool -> RealArray.t -> t
 
+(** [wrap_with_scratch dir a] creates a new serial nvector over the elements
+    of [a], like {!wrap}, but the elements of the nvectors cloned from it
+    (for example, by a solver for its workspace) are stored in temporary
+    files, created in the directory [dir] and mapped into memory. The files
+    are unlinked immediately and their space is released when the clones are
+    reclaimed. A clone cannot be created if [dir] is not writable or full.
+
+    @raise Failure Scratch clones require OCaml >= 4.09.0.
+    @since 4.0.0 *)
+val wrap_with_scratch : ?with_fused_ops:bool -> string -> RealArray.t -> t
+
+(** [make_with_scratch dir n iv] creates a new serial nvector with [n]
+    elements, each initialized to [iv], whose clones are stored in
+    temporary files in [dir] (see {!wrap_with_scratch}).
+
+    @raise Failure Scratch clones require OCaml >= 4.09.0.
+    @since 4.0.0 *)
+val make_with_scratch : ?with_fused_ops:bool -> string -> int -> float -> t
+
+(** [set_scratch_dir nv (Some dir)] changes the directory in which the
+    clones of [nv], and of all the vectors cloned from the same original,
+    are stored. With [None], the clones created subsequently are allocated
+    in memory as usual. Existing clones are not moved.
+
+    This permits, in particular, to store only the checkpoints of an adjoint
+    problem in files, since they are cloned by {!Cvodes.Adjoint.forward_normal}
+    and {!Idas.Adjoint.forward_normal} (and the corresponding one-step
+    functions). Setting the directory just before the forward integration,
+    and clearing it just after, leaves the workspace of the solver in memory.
+
+    @raise Invalid_argument [nv] was not created with {!wrap_with_scratch}
+                            or cloned from such an nvector.
+    @since 4.0.0 *)
+val set_scratch_dir : t -> string option -> unit
+
+(** [wrap_block a] creates an array of serial nvectors over the columns of
+    [a], for example, for the sensitivities of {!Cvodes} and {!Idas}, or for
+    the sensitivities of their quadratures. The elements of these nvectors
+    are thus consecutive in memory. The vectors cloned from them are
+    allocated in blocks of the same size, so that the arrays of vectors
+    created by the solvers, like their sensitivity workspaces, are laid out
+    in the same way.
+
+    The linear sum, scale, const, weighted root-mean-square norm, and
+    linear combination vector array operations of the nvectors are
+    replaced by kernels that work through each block of vectors in a
+    single pass (they fall back to the standard Sundials operations for
+    arrays of vectors that are not blocks). The vector array operations
+    are otherwise as described in {!enable}.
+
+    @since 4.0.0
+    @raise Config.NotImplementedBySundialsVersion Vector array operations not available. *)
+val wrap_block : ?with_fused_ops:bool -> RealArray2.t -> t array
+
+(** [make_block ns n iv] creates an array of [ns] serial nvectors, each with
+    [n] elements initialized to [iv], whose elements are stored in a single
+    {!Sundials.RealArray2} (see {!wrap_block}).
+
+    @since 4.0.0
+    @raise Config.NotImplementedBySundialsVersion Vector array operations not available. *)
+val make_block : ?with_fused_ops:bool -> int -> int -> float -> t array
+
+(** Writes the elements of an nvector back to the file from which they are
+    mapped. The call returns once the data has reached the file, whose
+    contents then form a checkpoint of the vector. It has no effect if the
+    elements are not mapped from a file.
+
+    @raise Failure The elements could not be written.
+    @since 4.0.0 *)
+val sync : t -> unit
+
 (** Aliases {!Nvector.unwrap}. *)
 val unwrap : t -> RealArray.t
 
@@ -94,6 +176,26 @@ val enable :
   -> t
   -> unit
 
+(** [enable_simd_ops nv true] replaces the linear combination,
+    scale-add-multi, dot-product-multi, linear-sum-vector-array, and
+    wrms-norm-vector-array operations of [nv] with kernels that make a single
+    pass over their operands and that are vectorized for the running
+    processor (AVX-512 or AVX2 on x86-64, NEON on AArch64). Vectors cloned
+    from [nv] inherit the setting. [enable_simd_ops nv false] reinstates the
+    operations that were replaced, which may be disabled.
+
+    Linear combinations of up to eight vectors, like those formed at each
+    stage of the explicit Runge-Kutta methods of {!Arkode.ERKStep} with up
+    to seven stages, are computed by kernels specialized for the number of
+    vectors, which sum the terms of each element in a register.
+
+    Since these kernels override the settings made by {!enable}, they
+    should be activated after it.
+
+    @since 4.0.0
+    @raise Config.NotImplementedBySundialsVersion Fused and array operations not available. *)
+val enable_simd_ops : t -> bool -> unit
+
 (** Underlying nvector operations on serial nvectors. *)
 module Ops : Nvector.NVECTOR_OPS with type t = t
 
@@ -13,6 +13,7 @@
 module Config = Sundials_Config
 
 module Index = Sundials_Index
+module Precision = Sundials_Precision
 
 exception RecoverableFailure
 exception NonPositiveEwt
@@ -384,6 +385,68 @@ module RootDirs = struct (* {{{ *)
 
 end (* }}} *)
 
+module RootMask = struct (* {{{ *)
+  type t = {
+    active          : bool array;
+    last            : RealArray.t;
+    seeded          : bool array;
+    mutable indices : int array;
+    mutable dirty   : bool;
+  }
+
+  let create n = {
+    active  = Array.make n true;
+    last    = RealArray.create n;
+    seeded  = Array.make n false;
+    indices = [||];
+    dirty   = true;
+  }
+
+  let length m = Array.length m.active
+
+  let get m i = m.active.(i)
+
+  let set m i v =
+    if m.active.(i) <> v then begin
+      m.active.(i) <- v;
+      m.dirty <- true
+    end
+
+  let set_all m v =
+    Array.fill m.active 0 (Array.length m.active) v;
+    m.dirty <- true
+
+  let active_indices m =
+    if m.dirty then begin
+      let n = Array.fold_left (fun n b -> if b then n + 1 else n) 0 m.active in
+      let idx = Array.make n 0 in
+      let j = ref 0 in
+      Array.iteri (fun i b -> if b then (idx.(!j) <- i; incr j)) m.active;
+      m.indices <- idx;
+      m.dirty <- false
+    end;
+    m.indices
+
+  let eval m g gout =
+    let idx = active_indices m in
+    if Array.length idx < length m then
+      for i = 0 to length m - 1 do
+        if not m.active.(i) then begin
+          (* a function deactivated before it was ever evaluated *)
+          if not m.seeded.(i) then (m.last.{i} <- g i; m.seeded.(i) <- true);
+          gout.{i} <- m.last.{i}
+        end
+      done;
+    for k = 0 to Array.length idx - 1 do
+      let i = idx.(k) in
+      let v = g i in
+      gout.{i} <- v;
+      m.last.{i} <- v;
+      m.seeded.(i) <- true
+    done
+
+end (* }}} *)
+
 module Constraint = struct (* {{{ *)
   let unconstrained = 0.0
   let geq_zero =  1.0
@@ -414,6 +477,116 @@ module Constraint = struct (* {{{ *)
     | LtZero        -> -2.0
 end (* }}} *)
 
+type cfun
+
+type profile_counter = {
+  calls : int;
+  time : float;
+}
+
+type profile = {
+  solver : profile_counter;
+  rhs : profile_counter;
+  jac : profile_counter;
+  prec_setup : profile_counter;
+  prec_solve : profile_counter;
+  jac_times : profile_counter;
+}
+
+module Trace = struct (* {{{ *)
+
+  type category =
+    | Solver
+    | Rhs
+    | Jac
+    | PrecSetup
+    | PrecSolve
+    | JacTimes
+
+  type counter =
+    | StepSize
+    | Steps
+    | ErrTestFails
+    | NonlinIters
+
+  type event =
+    | Call of category * float * float
+    | Counter of counter * float * float
+    | RootsFound of float
+
+  let category_name = function
+    | Solver    -> "solver"
+    | Rhs       -> "rhs"
+    | Jac       -> "jac"
+    | PrecSetup -> "prec_setup"
+    | PrecSolve -> "prec_solve"
+    | JacTimes  -> "jac_times"
+
+  let counter_name = function
+    | StepSize     -> "step_size"
+    | Steps        -> "steps"
+    | ErrTestFails -> "err_test_fails"
+    | NonlinIters  -> "nonlin_iters"
+
+  let json_string s =
+    let b = Buffer.create (String.length s + 2) in
+    Buffer.add_char b '"';
+    String.iter (function
+        | '"'  -> Buffer.add_string b "\\\""
+        | '\\' -> Buffer.add_string b "\\\\"
+        | c when Char.code c < 0x20 ->
+            Buffer.add_string b (Printf.sprintf "\\u%04x" (Char.code c))
+        | c -> Buffer.add_char b c) s;
+    Buffer.add_char b '"';
+    Buffer.contents b
+
+  (* Timestamps are in microseconds.  *)
+  let us t = t *. 1e6
+
+  let write_chrome oc traces =
+    let first = ref true in
+    let emit fmt =
+      output_string oc (if !first then "\n" else ",\n");
+      first := false;
+      Printf.fprintf oc fmt
+    in
+    output_string oc "{\"traceEvents\":[";
+    List.iteri (fun i (name, events) ->
+        let tid = i + 1 in
+        emit "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\
+              \"args\":{\"name\":%s}}" tid (json_string name);
+        Array.iter (function
+            | Call (c, t, d) ->
+                emit "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\
+                      \"pid\":1,\"tid\":%d}"
+                  (category_name c) (us t) (us d) tid
+            | Counter (c, t, v) ->
+                emit "{\"name\":%s,\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\
+                      \"tid\":%d,\"args\":{\"value\":%.17g}}"
+                  (json_string (name ^ " " ^ counter_name c)) (us t) tid v
+            | RootsFound t ->
+                emit "{\"name\":\"roots_found\",\"ph\":\"i\",\"s\":\"t\",\
+                      \"ts\":%.3f,\"pid\":1,\"tid\":%d}" (us t) tid)
+          events)
+      traces;
+    output_string oc "\n]}\n"
+
+end (* }}} *)
+
+module Recorder = struct (* {{{ *)
+
+  type t
+
+  external c_create : string -> int -> bool -> t
+      = "sunml_recorder_create"
+
+  external close : t -> unit
+      = "sunml_recorder_close"
+
+  let create ?(chunk=4096) ?(steps=false) path = c_create path chunk steps
+
+end (* }}} *)
+
 module Logfile = Sundials_Logfile
 
 module Matrix = Sundials_Matrix
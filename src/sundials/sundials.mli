@@ -14,6 +14,14 @@
 (** Generic definitions, arrays, matrices, linear solvers, nonlinear solvers,
     and utility functions.
 
+    Distinct sessions are independent of one another, except through a
+    little process-wide state that is protected against concurrent use:
+    a pool of recycled nvector headers, the counters reported by
+    {!Nvector.get_memory}, and the thread budget of
+    {!LinearSolver.Direct.Superlumt.Pool}. A given session, and
+    the vectors, matrices, and solvers attached to it, must not be used by
+    more than one thread at a time.
+
  @version VERSION()
  @author Timothy Bourke (Inria/ENS)
  @author Jun Inoue (Inria/ENS)
@@ -26,6 +34,9 @@ module Config = Sundials_Config
 (** Index values for sparse matrices. *)
 module Index = Sundials_Index
 
+(** The precision of real values. *)
+module Precision = Sundials_Precision
+
 (** {2:exceptions Exceptions} *)
 
 (** Indicates a recoverable failure within a callback function.
@@ -241,6 +252,57 @@ module RootDirs : sig (* {{{ *)
   val to_array : t -> d array
 end (* }}} *)
 
+(** Masks that select the active root functions.
+
+    Models with many guard conditions typically monitor only a few of them
+    in any given mode. A mask records which root functions are active, so
+    that only those are evaluated, and may be updated between calls to the
+    solver. An inactive root function reports the value it had when it was
+    last evaluated (it is evaluated once if it never was), so it cannot
+    trigger a zero-crossing while inactive.
+
+    The solvers compare each new value of a root function with the one
+    they recorded at the end of the previous step. A root function should
+    thus only be reactivated just after a solver function has returned
+    [RootsFound], since the solver then evaluates the root functions
+    again before stepping, or else the session must be reinitialized
+    (e.g., with {!Cvode.reinit}). Otherwise, if its sign has changed while
+    it was inactive, a zero-crossing is reported within the next step.
+    The root directions ({!RootDirs}) still apply to the active root
+    functions.
+
+    See {!Cvode.masked_roots}, {!Ida.masked_roots}, and
+    {!Arkode.masked_roots}. *)
+module RootMask : sig (* {{{ *)
+  type t
+
+  (** [create n] returns a mask for [n] root functions, all active. *)
+  val create : int -> t
+
+  (** Returns the number of root functions. *)
+  val length : t -> int
+
+  (** [get m i] indicates whether the [i]th root function is active. *)
+  val get : t -> int -> bool
+
+  (** [set m i v] activates ([v = true]) or deactivates ([v = false]) the
+      [i]th root function. See above for when a root function may be
+      reactivated. *)
+  val set : t -> int -> bool -> unit
+
+  (** Activates or deactivates all root functions. *)
+  val set_all : t -> bool -> unit
+
+  (** Returns the indices of the active root functions in increasing order.
+      The array is shared with the mask and must not be modified. *)
+  val active_indices : t -> int array
+
+  (** [eval m g gout] sets [gout.{i}] to [g i] for every active [i], and
+      the other entries to their last values. An inactive entry that has
+      never been evaluated is evaluated once. *)
+  val eval : t -> (int -> float) -> RealArray.t -> unit
+end (* }}} *)
+
 (** {2:constraints Constraints} *)
 
 (** Symbolic names for variable constraints. These names describe
@@ -290,6 +352,166 @@ module LinearSolver = Sundials_LinearSolver
 
 module NonlinearSolver = Sundials_NonlinearSolver
 
+(** {2:cfun Native C functions} *)
+
+(** A function implemented in C, together with an opaque pointer to its
+    data. Values of this type are created by C stubs with
+    [value sunml_sundials_wrap_cfun(void *fn, void *data)] (declared in
+    [sundials_ml.h]) and passed to the functions that accept native callbacks, for example,
+    {!Cvode.init_cfun}. Native callbacks are invoked directly from the
+    solver without passing through the OCaml runtime. The expected C
+    signature of [fn] is given by the function receiving the value; the
+    [data] pointer is always passed in place of the [user_data] argument.
+    The data is not managed by OCaml and must remain valid for as long as
+    any session uses the function. *)
+type cfun
+
+(** {2:profile Profiling} *)
+
+(** The totals accumulated for one category of calls. *)
+type profile_counter = {
+  calls : int;    (** The number of calls. *)
+  time : float;   (** The total time spent in the calls, in seconds, as
+                      measured by a monotonic clock. *)
+}
+
+(** Profiling counters of a session. Profiling is enabled separately for
+    each session, for instance, with {!Cvode.set_profiling}, and the totals
+    are returned by the corresponding [get_profile] function. Only calls
+    through OCaml callbacks are counted; native callbacks (see {!cfun}) are
+    not instrumented. The time spent in callbacks is included in [solver],
+    so that the difference between [solver] and the sum of the other
+    categories approximates the time spent inside Sundials itself. *)
+type profile = {
+  solver : profile_counter;      (** Calls to the solver functions,
+                                     like {!Cvode.solve_normal}. *)
+  rhs : profile_counter;         (** Right-hand side, residual, or
+                                     system functions. *)
+  jac : profile_counter;         (** Jacobian and mass matrix functions. *)
+  prec_setup : profile_counter;  (** Preconditioner setup functions. *)
+  prec_solve : profile_counter;  (** Preconditioner solve functions. *)
+  jac_times : profile_counter;   (** Jacobian-times-vector and
+                                     mass-matrix-times-vector setup and
+                                     product functions. *)
+}
+
+(** Timelines of solver activity.
+
+    Tracing is enabled separately for each session, for instance, with
+    {!Cvode.set_tracing}, which gives the capacity of a ring buffer that
+    keeps the most recent events, and the events are returned by the
+    corresponding [get_trace] function. The calls that are counted by
+    profiling (see {!profile}) are recorded with their start times and
+    durations. After each call to a solver function, the step size and
+    the main counters of the session are sampled, and returns at roots are
+    marked. Calls are recorded when they finish, so they appear after the
+    callbacks they contain. Times are in seconds and are measured by a
+    monotonic clock whose origin is unspecified.
+
+    The events of one or more sessions can be written in the Trace Event
+    Format of Chrome, which is also read by Perfetto, to view them as
+    timelines. *)
+module Trace : sig (* {{{ *)
+
+  (** The categories of calls, as for {!profile}. *)
+  type category =
+    | Solver
+    | Rhs
+    | Jac
+    | PrecSetup
+    | PrecSolve
+    | JacTimes
+
+  (** The quantities sampled after each call to a solver function. Those
+      that an integrator does not provide are omitted. *)
+  type counter =
+    | StepSize      (** The size of the last step taken. *)
+    | Steps         (** The total number of steps. *)
+    | ErrTestFails  (** The total number of local error test failures. *)
+    | NonlinIters   (** The total number of nonlinear iterations. *)
+
+  (** An event in a trace. *)
+  type event =
+    | Call of category * float * float
+      (** A call with its start time and its duration. *)
+    | Counter of counter * float * float
+      (** A sample of a counter with its time and its value. *)
+    | RootsFound of float
+      (** A solver function returned at a root at the given time. *)
+
+  (** [write_chrome oc traces] writes the given traces, as returned by
+      the [get_trace] functions, to [oc] in the JSON Trace Event Format.
+      The string paired with each trace names it; each trace appears as
+      a separate thread. *)
+  val write_chrome : out_channel -> (string * event array) list -> unit
+
+end (* }}} *)
+
+(** Binary recordings of trajectories.
+
+    A recorder is attached to a session, for instance with
+    {!Cvode.set_recorder}, and, after each successful call to a solution
+    function, it appends the time reached and the solution vector, and
+    optionally the size and order of the last step. With [solve_one_step],
+    this records each internal step, and with [solve_normal] or
+    [solve_schedule], each output time. The solution is copied directly
+    from the payload of the serial, OpenMP, or Pthreads nvector, without
+    passing through OCaml, into a chunk that a background thread writes
+    once it is full. Several sessions may share a recorder, provided that
+    their vectors have the same length and that they run in the same
+    thread.
+
+    A recording is made of:
+    - a header of 64 bytes: the 8 characters [SUNMLTRJ], then the format
+      version ([1]) and the value [0x01020304] as 32-bit integers, then
+      the length of the vectors [n], the number of columns [c] ([n + 1],
+      or [n + 3] when steps are recorded), whether steps are recorded
+      ([0] or [1]), the number of chunks [m], and the offset of the index
+      as 64-bit integers, and padding;
+    - [m] chunks, each made of the 4 characters [CHNK], 4 bytes of padding,
+      the number [k] of rows as a 64-bit integer, and the first and last
+      times as doubles, followed by [c] columns of [k] doubles: the times,
+      the components of the solution, and, if recorded, the step sizes and
+      orders (zero for the ARKODE steppers, whose methods have a fixed
+      order);
+    - the index, giving for each chunk the first and last times as
+      doubles, and the offset of the chunk and its number of rows as
+      64-bit integers.
+
+    All values are in the native byte order, which the marker in the header
+    allows readers to check, and all columns start at multiples of 8, so
+    that a recording can be mapped into memory and its columns used in
+    place. The times are increasing for a forward integration, so the index
+    permits a binary search for the chunk containing a given time. The
+    header is only completed by {!close}; until then, the number of chunks
+    and the offset of the index are zero. *)
+module Recorder : sig (* {{{ *)
+
+  (** A recording in progress. *)
+  type t
+
+  (** [create ~chunk ~steps path] creates the file [path] for a recording
+      whose chunks hold [chunk] rows each (by default 4096), and which
+      includes the step sizes and orders if [steps] is [true] (by default
+      [false]). The length of the vectors is that of the first one
+      recorded. The writer thread is started by the first record.
+
+      @raise Sys_error The file cannot be created.
+      @raise Invalid_argument [chunk] is not positive. *)
+  val create : ?chunk:int -> ?steps:bool -> string -> t
+
+  (** Writes the rows still in memory, the index, and the header, and closes
+      the file. Sessions to which the recorder is still attached no longer
+      record. Closing a recorder again has no effect; a recorder that is
+      no longer referenced is closed by the garbage collector.
+
+      @raise Sys_error Writing the file failed.
+      @raise Invalid_argument Vectors of different lengths were recorded;
+                              they were ignored. *)
+  val close : t -> unit
+
+end (* }}} *)
+
 (** {2:results Solver results and error reporting} *)
 
 (** Files for error and diagnostic information. File values are passed
@@ -42,6 +42,9 @@ val nvecpthreads_enabled : bool
 (** Indicates whether openmp-based nvectors are available. *)
 val nvecopenmp_enabled : bool
 
+(** Indicates whether CUDA-based nvectors are available. *)
+val nveccuda_enabled : bool
+
 (** The largest value representable as a real.
 
     @cvode <node5#s:types> Data Types *)
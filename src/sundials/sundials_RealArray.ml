@@ -13,9 +13,10 @@
 
 open Bigarray
 
-let kind = float64
+type elt = Sundials_Precision.real_elt
+let kind = Sundials_Precision.kind
 let layout = c_layout
-type t = (float, float64_elt, c_layout) Array1.t
+type t = (float, elt, c_layout) Array1.t
 
 let create : int -> t = Array1.create kind layout
 let of_array : float array -> t = Array1.of_array kind layout
@@ -11,8 +11,16 @@
 (*                                                                     *)
 (***********************************************************************)
 
+(** The element type of real arrays: [Bigarray.float64_elt], or
+    [Bigarray.float32_elt] when Sundials is compiled in single precision
+    (see {!Sundials.Precision}). *)
+type elt = Sundials_Precision.real_elt
+
 (** A {{:OCAML_DOC_ROOT(Bigarray.Array1.html)} Bigarray} of floats. *)
-type t = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array1.t
+type t = (float, elt, Bigarray.c_layout) Bigarray.Array1.t
+
+(** The Bigarray kind of real arrays. *)
+val kind : (float, elt) Bigarray.kind
 
 (** [make n x] returns an array with [n] elements each set to [x]. *)
 val make : int -> float -> t
@@ -13,10 +13,10 @@
 
 open Bigarray
 
-let make_data = Array2.create float64 c_layout
+let make_data = Array2.create Sundials_Precision.kind c_layout
 
 type data =
-  (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array2.t
+  (float, Sundials_Precision.real_elt, Bigarray.c_layout) Bigarray.Array2.t
 
 type t = data * Obj.t
 
@@ -26,11 +26,11 @@ external wrap : data -> t
 let unwrap = fst
 
 let create nr nc =
-  let d = Array2.create float64 c_layout nc nr
+  let d = Array2.create Sundials_Precision.kind c_layout nc nr
   in wrap d
 
 let make nr nc v =
-  let d = Array2.create float64 c_layout nc nr
+  let d = Array2.create Sundials_Precision.kind c_layout nc nr
   in
   Array2.fill d v;
   wrap d
@@ -85,7 +85,7 @@ let copy a =
   let d = unwrap a in
   let c = Array2.dim1 d in
   let r = Array2.dim2 d in
-  let d' = Array2.create float64 c_layout c r in
+  let d' = Array2.create Sundials_Precision.kind c_layout c r in
   Array2.blit d d';
   wrap d'
 
@@ -20,8 +20,9 @@ type t
 
 (** An alias for two-dimensional
     {{:OCAML_DOC_ROOT(Bigarray.Array2.html)}Bigarray}s of floating-point
-    numbers. *)
-type data = (float, Bigarray.float64_elt, Bigarray.c_layout) Bigarray.Array2.t
+    numbers (see {!Sundials.Precision}). *)
+type data =
+  (float, Sundials_Precision.real_elt, Bigarray.c_layout) Bigarray.Array2.t
 
 (** [make nr nc v] returns an array with [nr] rows and [nc] columns, and
     with elements set to [v]. *)
@@ -14,6 +14,12 @@
 
 external crash : string -> 'a = "sunml_crash"
 
+(* Argument records and bigarray proxies reused by the callback trampolines
+   of a session (see sunml_argcache_block in sundials_ml.h). The contents
+   are only ever accessed from C. *)
+type arg_cache
+external make_arg_cache : unit -> arg_cache = "sunml_sundials_make_arg_cache"
+
 (* A simple way of sharing values between OCaml and C. *)
 module Vptr : sig
 
@@ -14,8 +14,12 @@
 /* Sundials interface functions that are common to CVODE and IDA. */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 
 #include <sundials/sundials_config.h>
 #include <sundials/sundials_types.h>
@@ -152,6 +156,12 @@ CAMLprim value sunml_sundials_realarray2_create(int nc, int nr)
     CAMLreturn(sunml_sundials_realarray2_wrap(vba));
 }
 
+void sunml_realarray2_set_col(value va, intnat j, value vsrc)
+{
+    memcpy(ARRAY2_ACOLS(va)[j], REAL_ARRAY(vsrc),
+	   ARRAY2_NROWS(va) * sizeof(realtype));
+}
+
 CAMLprim void sunml_crash (value msg)
 {
     CAMLparam1 (msg);
@@ -164,22 +174,694 @@ CAMLprim void sunml_crash (value msg)
 /* Functions for storing OCaml values in the C heap. */
 
 value *sunml_sundials_malloc_value(value v)
+{
+    return sunml_sundials_malloc_value_ext(v, 0);
+}
+
+value *sunml_sundials_malloc_value_ext(value v, size_t extsize)
 {
     header_t *block;
-    block = (header_t *)malloc(Bhsize_wosize(1));
+    block = (header_t *)malloc(Bhsize_wosize(1) + extsize);
     if (block == NULL) return NULL;
     *block = Make_header(1, 0, Caml_black);
     Field(Val_hp(block), 0) = v;
+    if (extsize > 0) memset(SUNML_HEAPREF_EXT(Op_hp(block)), 0, extsize);
     caml_register_generational_global_root (Op_hp(block));
     return Op_hp(block);
 }
 
+/* Native C functions. */
+
+value sunml_sundials_wrap_cfun(void *fn, void *data)
+{
+    CAMLparam0();
+    CAMLlocal1(vcf);
+
+    if (fn == NULL) caml_invalid_argument("Sundials.cfun: NULL function");
+
+    vcf = caml_alloc_final((sizeof(struct sunml_cfun) + sizeof(value) - 1)
+			       / sizeof(value), NULL, 0, 1);
+    CFUN_VAL(vcf)->fn = fn;
+    CFUN_VAL(vcf)->data = data;
+
+    CAMLreturn(vcf);
+}
+
 void sunml_sundials_free_value(value *pv)
 {
     caml_remove_generational_global_root (pv);
     free (Hp_op(pv));
 }
 
+/* Callback argument caches. */
+
+CAMLprim value sunml_sundials_make_arg_cache(value unit)
+{
+    CAMLparam1(unit);
+    CAMLreturn(caml_alloc_tuple(SUNML_ARGCACHE_SIZE));
+}
+
+value sunml_argcache_block(value vcache, int slot, mlsize_t size)
+{
+    CAMLparam1(vcache);
+    CAMLlocal1(vb);
+
+    vb = Field(vcache, slot);
+    if (Is_long(vb)) {
+	vb = caml_alloc_tuple(size);
+	Store_field(vcache, slot, vb);
+    }
+
+    CAMLreturn(vb);
+}
+
+value sunml_argcache_realarray(value vcache, int slot,
+			       realtype *data, intnat n)
+{
+    CAMLparam1(vcache);
+    CAMLlocal1(vba);
+
+    vba = Field(vcache, slot);
+    if (Is_long(vba)) {
+	vba = caml_ba_alloc(BIGARRAY_FLOAT, 1, data, &n);
+    } else {
+	Caml_ba_array_val(vba)->data = data;
+	Caml_ba_array_val(vba)->dim[0] = n;
+    }
+    /* Taken out of the cache until sunml_argcache_release_realarray.  */
+    Store_field(vcache, slot, Val_unit);
+
+    CAMLreturn(vba);
+}
+
+void sunml_argcache_release_realarray(value vcache, int slot, value vba)
+{
+    Caml_ba_array_val(vba)->data = NULL;
+    Caml_ba_array_val(vba)->dim[0] = 0;
+    Store_field(vcache, slot, vba);
+}
+
+/* Profiling counters. */
+
+#define PROFILE_VAL(v) (*(struct sunml_profile **)Data_custom_val(v))
+
+static void recorder_release(struct sunml_recorder *rec);
+
+static void finalize_profile(value vprof)
+{
+    struct sunml_profile *prof = PROFILE_VAL(vprof);
+
+    if (prof != NULL) {
+	free(prof->trace);
+	recorder_release(prof->recorder);
+    }
+    free(prof);
+}
+
+static long long profile_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct sunml_profile *sunml_profile_start(value vcache, long long *t0)
+{
+    value vprof = Field(vcache, SUNML_ARGCACHE_PROFILE);
+    struct sunml_profile *prof;
+
+    if (Is_long(vprof)) return NULL;
+    prof = PROFILE_VAL(vprof);
+    if (!prof->enabled && prof->trace == NULL) return NULL;
+
+    *t0 = profile_clock();
+    return prof;
+}
+
+static struct sunml_trace_event *trace_next(struct sunml_profile *prof)
+{
+    return &prof->trace[prof->trace_next++ % prof->trace_capacity];
+}
+
+void sunml_profile_stop(struct sunml_profile *prof, int category,
+			long long t0)
+{
+    long long t1;
+    struct sunml_trace_event *e;
+
+    if (prof == NULL) return;
+    t1 = profile_clock();
+
+    if (prof->enabled) {
+	prof->calls[category]++;
+	prof->nanoseconds[category] += t1 - t0;
+    }
+
+    if (prof->trace != NULL) {
+	e = trace_next(prof);
+	e->type = SUNML_TRACE_CALL;
+	e->id = category;
+	e->start = t0;
+	e->duration = t1 - t0;
+	e->value = 0.0;
+    }
+}
+
+void sunml_trace_counter(struct sunml_profile *prof, int counter,
+			 double value)
+{
+    struct sunml_trace_event *e;
+
+    if (!sunml_trace_enabled(prof)) return;
+    e = trace_next(prof);
+    e->type = SUNML_TRACE_COUNTER;
+    e->id = counter;
+    e->start = profile_clock();
+    e->duration = 0;
+    e->value = value;
+}
+
+void sunml_trace_roots(struct sunml_profile *prof)
+{
+    struct sunml_trace_event *e;
+
+    if (!sunml_trace_enabled(prof)) return;
+    e = trace_next(prof);
+    e->type = SUNML_TRACE_ROOTS;
+    e->id = 0;
+    e->start = profile_clock();
+    e->duration = 0;
+    e->value = 0.0;
+}
+
+/* The block is kept once created since a callback in progress may still
+   hold a pointer to it.  It is only stored in the cache once the counters
+   are allocated, so that the accessors never see a NULL pointer.  */
+static struct sunml_profile *profile_block(value vcache)
+{
+    CAMLparam1(vcache);
+    CAMLlocal1(vprof);
+    struct sunml_profile *prof;
+
+    vprof = Field(vcache, SUNML_ARGCACHE_PROFILE);
+    if (Is_long(vprof)) {
+	vprof = caml_alloc_final(1, &finalize_profile, 0, 1);
+	PROFILE_VAL(vprof) = NULL;
+	prof = calloc(1, sizeof(struct sunml_profile));
+	if (prof == NULL) caml_raise_out_of_memory();
+	PROFILE_VAL(vprof) = prof;
+	Store_field(vcache, SUNML_ARGCACHE_PROFILE, vprof);
+    }
+
+    CAMLreturnT(struct sunml_profile *, PROFILE_VAL(vprof));
+}
+
+/* Enabling profiling resets the counters.  */
+CAMLprim value sunml_sundials_set_profiling(value vcache, value venable)
+{
+    CAMLparam2(vcache, venable);
+    struct sunml_profile *prof;
+
+    if (Is_long(Field(vcache, SUNML_ARGCACHE_PROFILE))
+	    && !Bool_val(venable))
+	CAMLreturn(Val_unit);
+
+    prof = profile_block(vcache);
+    if (Bool_val(venable)) {
+	memset(prof->calls, 0, sizeof(prof->calls));
+	memset(prof->nanoseconds, 0, sizeof(prof->nanoseconds));
+    }
+    prof->enabled = Bool_val(venable);
+
+    CAMLreturn(Val_unit);
+}
+
+/* Replace the trace by an empty one holding up to vcapacity events, or
+   discard it if vcapacity is zero.  Calls that are in progress when the
+   trace is replaced record in the new one.  */
+CAMLprim value sunml_sundials_set_tracing(value vcache, value vcapacity)
+{
+    CAMLparam2(vcache, vcapacity);
+    struct sunml_profile *prof;
+    struct sunml_trace_event *trace = NULL;
+    long capacity = Long_val(vcapacity);
+
+    if (capacity < 0)
+	caml_invalid_argument("set_tracing: negative capacity");
+    if (Is_long(Field(vcache, SUNML_ARGCACHE_PROFILE)) && capacity == 0)
+	CAMLreturn(Val_unit);
+
+    prof = profile_block(vcache);
+    if (capacity > 0) {
+	trace = calloc(capacity, sizeof(struct sunml_trace_event));
+	if (trace == NULL) caml_raise_out_of_memory();
+    }
+
+    free(prof->trace);
+    prof->trace = trace;
+    prof->trace_capacity = capacity;
+    prof->trace_next = 0;
+
+    CAMLreturn(Val_unit);
+}
+
+/* Return the events of the trace, oldest first, as a
+   Sundials.Trace.event array.  */
+CAMLprim value sunml_sundials_get_trace(value vcache)
+{
+    CAMLparam1(vcache);
+    CAMLlocal3(vr, ve, vf);
+    struct sunml_profile *prof = NULL;
+    struct sunml_trace_event *e;
+    unsigned long i, n = 0, first = 0;
+
+    vf = Field(vcache, SUNML_ARGCACHE_PROFILE);
+    if (Is_block(vf)) prof = PROFILE_VAL(vf);
+
+    if (sunml_trace_enabled(prof)) {
+	n = prof->trace_next;
+	if (n > prof->trace_capacity) {
+	    first = n - prof->trace_capacity;
+	    n = prof->trace_capacity;
+	}
+    }
+
+    if (n == 0) CAMLreturn(Atom(0));
+
+    vr = caml_alloc_tuple(n);
+    for (i = 0; i < n; ++i) {
+	e = &prof->trace[(first + i) % prof->trace_capacity];
+	switch (e->type) {
+	case SUNML_TRACE_CALL:
+	    ve = caml_alloc_small(3, SUNML_TRACE_CALL);
+	    Field(ve, 0) = Val_int(e->id);
+	    Field(ve, 1) = Val_unit;
+	    Field(ve, 2) = Val_unit;
+	    vf = caml_copy_double(e->start * 1e-9);
+	    Store_field(ve, 1, vf);
+	    vf = caml_copy_double(e->duration * 1e-9);
+	    Store_field(ve, 2, vf);
+	    break;
+
+	case SUNML_TRACE_COUNTER:
+	    ve = caml_alloc_small(3, SUNML_TRACE_COUNTER);
+	    Field(ve, 0) = Val_int(e->id);
+	    Field(ve, 1) = Val_unit;
+	    Field(ve, 2) = Val_unit;
+	    vf = caml_copy_double(e->start * 1e-9);
+	    Store_field(ve, 1, vf);
+	    vf = caml_copy_double(e->value);
+	    Store_field(ve, 2, vf);
+	    break;
+
+	default:
+	    vf = caml_copy_double(e->start * 1e-9);
+	    ve = caml_alloc_small(1, SUNML_TRACE_ROOTS);
+	    Field(ve, 0) = vf;
+	    break;
+	}
+	Store_field(vr, i, ve);
+    }
+
+    CAMLreturn(vr);
+}
+
+CAMLprim value sunml_sundials_get_profile(value vcache)
+{
+    CAMLparam1(vcache);
+    CAMLlocal3(vr, vc, vprof);
+    struct sunml_profile *prof = NULL;
+    int i;
+
+    vprof = Field(vcache, SUNML_ARGCACHE_PROFILE);
+    if (Is_block(vprof)) prof = PROFILE_VAL(vprof);
+
+    vr = caml_alloc_tuple(SUNML_PROFILE_SIZE);
+    for (i = 0; i < SUNML_PROFILE_SIZE; ++i) {
+	vc = caml_alloc_tuple(2);
+	Store_field(vc, 0, Val_long(prof ? prof->calls[i] : 0));
+	Store_field(vc, 1,
+		    caml_copy_double(prof ? prof->nanoseconds[i] * 1e-9 : 0.0));
+	Store_field(vr, i, vc);
+    }
+
+    CAMLreturn(vr);
+}
+
+/* Trajectory recorders (Sundials.Recorder).
+
+   The file starts with a header of RECORDER_HEADER_SIZE bytes, which is
+   rewritten when the recorder is closed, followed by the chunks and then
+   by the index.  A chunk is a header of RECORDER_CHUNK_HEADER_SIZE bytes
+   followed by its columns: the times, each component of the solution,
+   and, optionally, the step sizes and orders, each as count doubles.
+   An index entry gives the first and last times, the offset, and the
+   count of each chunk.  All values are in native byte order and all
+   offsets are multiples of 8, so that the file can be mapped and read in
+   place.
+
+   Chunks are filled by the thread running the session and handed to a
+   writer thread through the pending field.  With two buffers, the session
+   only waits if it fills a chunk before the previous one is written.  The
+   index is only touched by the writer thread until it is joined.  */
+
+#define RECORDER_HEADER_SIZE 64
+#define RECORDER_CHUNK_HEADER_SIZE 32
+#define RECORDER_VERSION 1
+#define RECORDER_BYTE_ORDER 0x01020304
+
+struct recorder_entry {
+    double t_first;
+    double t_last;
+    int64_t offset;
+    int64_t count;
+};
+
+struct sunml_recorder {
+    int steps;			/* Record step sizes and orders.  */
+    int refs;			/* The OCaml value and the sessions.  */
+    int closed;
+    int started;		/* The writer thread is running.  */
+    int mismatch;		/* A vector of another length was given.  */
+    int error;			/* The errno of a failed write, or 0.  */
+
+    FILE *file;
+    long n;			/* The length of the vectors, or -1.  */
+    long ncols;
+    unsigned long capacity;	/* The number of rows of a chunk.  */
+
+    double *fill;		/* Filled by the session.  */
+    unsigned long fill_count;
+    double *spare;		/* NULL while being written.  */
+    double *pending;		/* Handed to the writer, or NULL.  */
+    unsigned long pending_count;
+    int stop;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    struct recorder_entry *index;
+    unsigned long nchunks;
+    unsigned long index_capacity;
+    int64_t offset;		/* Where the next chunk is written.  */
+};
+
+static int recorder_write(struct sunml_recorder *rec, const void *p,
+			  size_t size, size_t n)
+{
+    if (rec->error) return 0;
+    if (fwrite(p, size, n, rec->file) != n) {
+	rec->error = errno ? errno : EIO;
+	return 0;
+    }
+    return 1;
+}
+
+static void recorder_write_chunk(struct sunml_recorder *rec,
+				 const double *b, unsigned long count)
+{
+    struct recorder_entry *e;
+    unsigned char hd[RECORDER_CHUNK_HEADER_SIZE] = { 'C', 'H', 'N', 'K' };
+    int64_t c = count;
+    long j;
+
+    if (rec->nchunks == rec->index_capacity) {
+	unsigned long cap = rec->index_capacity ? 2 * rec->index_capacity : 64;
+	e = realloc(rec->index, cap * sizeof(struct recorder_entry));
+	if (e == NULL) { rec->error = ENOMEM; return; }
+	rec->index = e;
+	rec->index_capacity = cap;
+    }
+
+    e = &rec->index[rec->nchunks];
+    e->t_first = b[0];
+    e->t_last = b[count - 1];
+    e->offset = rec->offset;
+    e->count = c;
+
+    memcpy(hd + 8, &c, sizeof(c));
+    memcpy(hd + 16, &e->t_first, sizeof(double));
+    memcpy(hd + 24, &e->t_last, sizeof(double));
+    recorder_write(rec, hd, 1, sizeof(hd));
+    for (j = 0; j < rec->ncols; ++j)
+	recorder_write(rec, b + j * rec->capacity, sizeof(double), count);
+
+    if (!rec->error) {
+	rec->nchunks++;
+	rec->offset += RECORDER_CHUNK_HEADER_SIZE
+			+ (int64_t)rec->ncols * count * sizeof(double);
+    }
+}
+
+static void *recorder_writer(void *arg)
+{
+    struct sunml_recorder *rec = arg;
+    double *b;
+    unsigned long count;
+
+    pthread_mutex_lock(&rec->lock);
+    for (;;) {
+	while (rec->pending == NULL && !rec->stop)
+	    pthread_cond_wait(&rec->cond, &rec->lock);
+	if (rec->pending == NULL) break;
+
+	b = rec->pending;
+	count = rec->pending_count;
+	pthread_mutex_unlock(&rec->lock);
+
+	recorder_write_chunk(rec, b, count);
+
+	pthread_mutex_lock(&rec->lock);
+	rec->pending = NULL;
+	rec->spare = b;
+	pthread_cond_broadcast(&rec->cond);
+    }
+    pthread_mutex_unlock(&rec->lock);
+
+    return NULL;
+}
+
+/* Hand the filled chunk to the writer and continue in the spare one.  */
+static void recorder_hand_off(struct sunml_recorder *rec)
+{
+    pthread_mutex_lock(&rec->lock);
+    while (rec->pending != NULL || rec->spare == NULL)
+	pthread_cond_wait(&rec->cond, &rec->lock);
+    rec->pending = rec->fill;
+    rec->pending_count = rec->fill_count;
+    rec->fill = rec->spare;
+    rec->fill_count = 0;
+    rec->spare = NULL;
+    pthread_cond_broadcast(&rec->cond);
+    pthread_mutex_unlock(&rec->lock);
+}
+
+static int recorder_start(struct sunml_recorder *rec, long n)
+{
+    size_t size;
+
+    rec->n = n;
+    rec->ncols = 1 + n + (rec->steps ? 2 : 0);
+    size = rec->ncols * rec->capacity * sizeof(double);
+    rec->fill = malloc(size);
+    rec->spare = malloc(size);
+    if (rec->fill == NULL || rec->spare == NULL) {
+	rec->error = ENOMEM;
+	return 0;
+    }
+
+    if (pthread_create(&rec->writer, NULL, recorder_writer, rec) != 0) {
+	rec->error = EAGAIN;
+	return 0;
+    }
+    rec->started = 1;
+    return 1;
+}
+
+struct sunml_recorder *sunml_recorder_of(value vcache)
+{
+    value vprof = Field(vcache, SUNML_ARGCACHE_PROFILE);
+    struct sunml_recorder *rec;
+
+    if (Is_long(vprof)) return NULL;
+    rec = PROFILE_VAL(vprof)->recorder;
+    if (rec == NULL || rec->closed) return NULL;
+
+    return rec;
+}
+
+int sunml_recorder_steps(struct sunml_recorder *rec)
+{
+    return rec->steps;
+}
+
+void sunml_recorder_append(struct sunml_recorder *rec, double t,
+			   value vpayload, double h, double q)
+{
+    long n = Caml_ba_array_val(vpayload)->dim[0];
+    realtype *y = Caml_ba_data_val(vpayload);
+    unsigned long k, cap = rec->capacity;
+    double *b;
+    long j;
+
+    if (!rec->started) {
+	if (rec->error || !recorder_start(rec, n)) return;
+    } else if (n != rec->n) {
+	rec->mismatch = 1;
+	return;
+    }
+
+    b = rec->fill;
+    k = rec->fill_count;
+    b[k] = t;
+    for (j = 0; j < n; ++j)
+	b[(1 + j) * cap + k] = y[j];
+    if (rec->steps) {
+	b[(1 + n) * cap + k] = h;
+	b[(2 + n) * cap + k] = q;
+    }
+
+    if (++rec->fill_count == cap) recorder_hand_off(rec);
+}
+
+/* Write the last chunk, the index, and the header, and release the file
+   and the buffers.  The recorder itself remains until it is no longer
+   referenced.  Returns the errno of the first failure, or 0.  */
+static int recorder_finish(struct sunml_recorder *rec)
+{
+    unsigned char hd[RECORDER_HEADER_SIZE] = { 'S', 'U', 'N', 'M', 'L',
+					       'T', 'R', 'J' };
+    uint32_t u;
+    int64_t i;
+
+    if (rec->closed) return 0;
+    rec->closed = 1;
+
+    if (rec->started) {
+	if (rec->fill_count > 0) recorder_hand_off(rec);
+	pthread_mutex_lock(&rec->lock);
+	rec->stop = 1;
+	pthread_cond_broadcast(&rec->cond);
+	pthread_mutex_unlock(&rec->lock);
+	pthread_join(rec->writer, NULL);
+    }
+
+    recorder_write(rec, rec->index, sizeof(struct recorder_entry),
+		   rec->nchunks);
+
+    u = RECORDER_VERSION;	memcpy(hd + 8, &u, 4);
+    u = RECORDER_BYTE_ORDER;	memcpy(hd + 12, &u, 4);
+    i = rec->n < 0 ? 0 : rec->n;	memcpy(hd + 16, &i, 8);
+    i = rec->ncols;		memcpy(hd + 24, &i, 8);
+    i = rec->steps;		memcpy(hd + 32, &i, 8);
+    i = rec->nchunks;		memcpy(hd + 40, &i, 8);
+    i = rec->offset;		memcpy(hd + 48, &i, 8);
+    if (!rec->error && fseek(rec->file, 0, SEEK_SET) != 0) rec->error = errno;
+    recorder_write(rec, hd, 1, sizeof(hd));
+    if (fclose(rec->file) != 0 && !rec->error) rec->error = errno;
+    rec->file = NULL;
+
+    free(rec->fill);
+    free(rec->spare);
+    free(rec->index);
+    rec->fill = rec->spare = NULL;
+    rec->index = NULL;
+    pthread_mutex_destroy(&rec->lock);
+    pthread_cond_destroy(&rec->cond);
+
+    return rec->error;
+}
+
+static void recorder_release(struct sunml_recorder *rec)
+{
+    if (rec == NULL || --rec->refs > 0) return;
+    recorder_finish(rec);
+    free(rec);
+}
+
+#define RECORDER_VAL(v) (*(struct sunml_recorder **)Data_custom_val(v))
+
+static void finalize_recorder(value vrec)
+{
+    recorder_release(RECORDER_VAL(vrec));
+}
+
+CAMLprim value sunml_recorder_create(value vpath, value vcapacity,
+				     value vsteps)
+{
+    CAMLparam3(vpath, vcapacity, vsteps);
+    CAMLlocal1(vrec);
+    struct sunml_recorder *rec;
+    unsigned char hd[RECORDER_HEADER_SIZE] = { 0 };
+
+    if (Long_val(vcapacity) <= 0)
+	caml_invalid_argument("Recorder.create: chunk size must be positive");
+
+    rec = calloc(1, sizeof(struct sunml_recorder));
+    if (rec == NULL) caml_raise_out_of_memory();
+    rec->file = fopen(String_val(vpath), "wb");
+    if (rec->file == NULL) {
+	free(rec);
+	caml_raise_sys_error(caml_copy_string(strerror(errno)));
+    }
+    /* The header is completed by recorder_finish.  */
+    if (fwrite(hd, 1, sizeof(hd), rec->file) != sizeof(hd)) rec->error = EIO;
+
+    rec->steps = Bool_val(vsteps);
+    rec->refs = 1;
+    rec->n = -1;
+    rec->capacity = Long_val(vcapacity);
+    rec->offset = RECORDER_HEADER_SIZE;
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_cond_init(&rec->cond, NULL);
+
+    vrec = caml_alloc_final(1, &finalize_recorder, 0, 1);
+    RECORDER_VAL(vrec) = rec;
+
+    CAMLreturn(vrec);
+}
+
+CAMLprim value sunml_recorder_close(value vrec)
+{
+    CAMLparam1(vrec);
+    struct sunml_recorder *rec = RECORDER_VAL(vrec);
+    int mismatch = rec->mismatch;
+    int err;
+
+    if (rec->closed) CAMLreturn(Val_unit);
+    err = recorder_finish(rec);
+
+    if (err != 0)
+	caml_raise_sys_error(caml_copy_string(strerror(err)));
+    if (mismatch)
+	caml_invalid_argument("Recorder.close: vectors of different lengths");
+
+    CAMLreturn(Val_unit);
+}
+
+/* Attach a recorder to a session, or detach it with None.  */
+CAMLprim value sunml_sundials_set_recorder(value vcache, value vrec)
+{
+    CAMLparam2(vcache, vrec);
+    struct sunml_profile *prof;
+    struct sunml_recorder *rec = NULL;
+
+    if (Is_long(Field(vcache, SUNML_ARGCACHE_PROFILE)) && Is_long(vrec))
+	CAMLreturn(Val_unit);
+
+    prof = profile_block(vcache);
+    if (Is_block(vrec)) {
+	rec = RECORDER_VAL(Some_val(vrec));
+	rec->refs++;
+    }
+    recorder_release(prof->recorder);
+    prof->recorder = rec;
+
+    CAMLreturn(Val_unit);
+}
+
 /* Functions for sharing OCaml values with C. */
 
 static void sunml_finalize_vptr(value cptr)
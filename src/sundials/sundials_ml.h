@@ -63,7 +63,11 @@ typedef int sundials_ml_smat_index;
 #define INDEX_ARRAY(v) ((sundials_ml_index *)Caml_ba_data_val(v))
 
 /* Interfacing with OCaml's bigarray infrastructure.  */
+#ifdef SUNDIALS_ML_SINGLE_PRECISION
+#define BIGARRAY_FLOAT (CAML_BA_FLOAT32 | CAML_BA_C_LAYOUT)
+#else
 #define BIGARRAY_FLOAT (CAML_BA_FLOAT64 | CAML_BA_C_LAYOUT)
+#endif
 #define BIGARRAY_INDEX (CAML_BA_INDEX | CAML_BA_C_LAYOUT)
 
 #define INT_ARRAY(v) ((int *)Caml_ba_data_val(v))
@@ -97,12 +101,16 @@ value sundials_ml_weak_get (value ar, value n);
 #define ARRAY2_BA(v)    (Caml_ba_array_val(Field((v), 0)))
 #define ARRAY2_DATA(v)  ((realtype *)Caml_ba_data_val(Field((v), 0)))
 #define ARRAY2_ACOLS(v) ((realtype **) Data_custom_val(Field((v), 1)))
-#define ARRAY2_NCOLS(v) (ARRAY2_DATA(v)->dim[0])
-#define ARRAY2_NROWS(v) (ARRAY2_DATA(v)->dim[1])
+#define ARRAY2_NCOLS(v) (ARRAY2_BA(v)->dim[0])
+#define ARRAY2_NROWS(v) (ARRAY2_BA(v)->dim[1])
 
 // create a Sundials.RealArray2.t from C
 CAMLprim value sunml_sundials_realarray2_create(int nc, int nr);
 
+// copy a Sundials.RealArray.t of length nrows into column j of a
+// Sundials.RealArray2.t; does not allocate
+void sunml_realarray2_set_col(value va, intnat j, value vsrc);
+
 enum sundials_error_details_index {
   RECORD_SUNDIALS_ERROR_DETAILS_ERROR_CODE    = 0,
   RECORD_SUNDIALS_ERROR_DETAILS_MODULE_NAME,
@@ -124,6 +132,28 @@ enum sundials_error_details_index {
    are all initialized to 0 by sundials_ml.c and then populated on a need-
    basis by the initialization code of each module.
 
+   Global state: the process-wide values held by the stubs are
+     - this table, and the closures registered by
+       sunml_sundials_init_module (warn_discarded_exn, weak_get), which
+       are written once, while the OCaml modules are being initialized
+       and before any session exists, and are only read afterward;
+     - scratch_ba_ops and scratch_ba_ops_init (nvector_ml.c), written
+       once, under the runtime lock, by the first scratch clone;
+     - many_parallel (nvector_ml.c), written once by the initialization
+       code of Nvector_parallel;
+     - cnvec_pool and nvec_memory (nvector_ml.c), the pool of recycled
+       c-nvecs and the Nvector.get_memory counters, protected by
+       cnvec_lock;
+     - superlumt_pool_size and superlumt_pool_busy
+       (sundials_linearsolver_ml.c), the SuperLU_MT thread budget,
+       protected by superlumt_pool_lock.
+   All other state belongs to a session (its backref, C data, and
+   argument cache) or to an individual nvector, matrix, or solver, and
+   buffers used to format error messages live on the stack.  A session,
+   together with the vectors and solvers attached to it, must only be
+   used by one thread at a time: its callbacks reuse per-session argument
+   records.
+
    Note: C standard doesn't say 0 == (long)NULL, but this is a common
    assumption and is adopted by OCaml's runtime.  See e.g. caml_alloc.
  */
@@ -177,27 +207,6 @@ enum sundials_exn_index {
 /* Return the value that a vptr points to. See Sundials_impl.make_vptr. */
 #define VPTRCROOT(x) (*(value **)Data_custom_val(Field(x, 1)))
 
-/* Callback functions are passed from OCaml to C by basically the same
- * mechanism as exceptions, but since callbacks are very frequently
- * accessed, we register them each as a separate generational global
- * root.
- *
- * Each module defines a file-local variable named callbacks, of type
- * value[num_callbacks], and an enum type for indexing this array with
- * prefix IX_.
- */
-#define REGISTER_CALLBACKS(cbs)						\
-    do {								\
-	int _i;								\
-	assert (Wosize_val (cbs) == NUM_CALLBACKS);			\
-	for (_i = 0; _i < NUM_CALLBACKS; ++_i) {			\
-	    callbacks[_i] = Field (cbs, _i);				\
-	    caml_register_generational_global_root (&callbacks[_i]);	\
-	}								\
-    } while (0)
-
-#define CAML_FN(fcn) (callbacks[IX_ ## fcn])
-
 /* Accessing FILE* values */
 #define ML_CFILE(v) (*(FILE **)Data_custom_val(v))
 
@@ -207,6 +216,198 @@ enum sundials_exn_index {
 value *sunml_sundials_malloc_value(value);
 void sunml_sundials_free_value(value *heapref);
 
+/* As sunml_sundials_malloc_value, but reserve extsize zeroed bytes
+   immediately after the stored value for use by C code.  The reserved
+   space, which is freed by sunml_sundials_free_value, is accessed with
+   SUNML_HEAPREF_EXT.  */
+value *sunml_sundials_malloc_value_ext(value, size_t extsize);
+#define SUNML_HEAPREF_EXT(heapref) ((void *)((value *)(heapref) + 1))
+
+/* Native C functions (Sundials.cfun).
+ *
+ * A cfun value is a custom block carrying a C function pointer and an
+ * opaque client pointer.  Libraries and programs create them from their own
+ * C stubs with sunml_sundials_wrap_cfun and pass them to the OCaml
+ * functions that accept native callbacks.  Neither pointer is managed by
+ * the OCaml GC: the client must keep the data alive while any session uses
+ * the function.  The expected signature of fn depends on where the value is
+ * used, and it is always called with data in place of the user_data
+ * argument.  */
+struct sunml_cfun {
+    void *fn;
+    void *data;
+};
+
+#define CFUN_VAL(v) ((struct sunml_cfun *)Data_custom_val(v))
+
+value sunml_sundials_wrap_cfun(void *fn, void *data);
+
+/* Linear and quadratic forms over the entries of a vector, evaluated by
+ * sunml_quadforms_eval (see Cvodes.Quadrature.init_forms).  Term k adds
+ * w[k] * y[a[k]] to q[row[k]] if b[k] < 0, and w[k] * y[a[k]] * y[b[k]]
+ * otherwise.  The indices a[k] and b[k] are checked against the length
+ * of y when the forms are set.  */
+struct sunml_quadforms {
+    intnat nterms;
+    intnat *row;
+    intnat *a;
+    intnat *b;
+    realtype *w;
+};
+
+/* Structured error weights, evaluated by sunml_ewtspec_eval (see
+ * Cvode.STtolerances).  Component i belongs to group g = i / block and
+ * ewt[i] = 1 / min(cap[g], max(floor[g], rtol[g] * s + atol[g])), where s
+ * is |y[i]|, or the largest |y[j]| in the group if block > 1.  Arrays of
+ * length 1 apply to every group, and floor and cap may be NULL.  The
+ * arrays are those of the OCaml specification, which is held by a
+ * generational global root, so sessions share them rather than copying
+ * them.  rtol is non-NULL exactly when a specification is set.  */
+struct sunml_ewtspec {
+    value spec;
+    intnat block;
+    realtype *rtol, *atol, *floor, *cap;
+    intnat rtol_len, atol_len, floor_len, cap_len;
+};
+
+/* Callback argument caches (Sundials_impl.arg_cache).
+ *
+ * Each session holds a block of SUNML_ARGCACHE_SIZE slots in which the
+ * callback trampolines keep the argument records, tuples, and bigarray
+ * proxies that they pass to OCaml.  They are allocated on first use and
+ * then updated in place before each call, so that steady-state callbacks
+ * do not allocate them.  Float arguments are still boxed with
+ * caml_copy_double at every call.  The slot assignment is particular to
+ * each solver.
+ *
+ * sunml_argcache_block returns the block in the given slot, allocating a
+ * new one with size fields if necessary.  The caller must initialize all
+ * of its fields (with Store_field) before calling OCaml.
+ *
+ * sunml_argcache_realarray returns a one-dimensional float bigarray of
+ * length n that points at data, and which must be passed back to
+ * sunml_argcache_release_realarray once the callback returns.  The
+ * bigarray is taken out of the slot in between, so that a reentrant call
+ * allocates its own.  Since OCaml code may keep the bigarray, it is left
+ * empty (length 0) until it is reused by a later call.  */
+#define SUNML_ARGCACHE_SIZE 13
+
+/* The last slot of every argument cache is reserved for the profiling
+   counters (see sunml_profile_start), and the one before it for the saved
+   Jacobian (see sunml_jac_cache_restore in sundials_matrix_ml.h).  */
+#define SUNML_ARGCACHE_PROFILE (SUNML_ARGCACHE_SIZE - 1)
+#define SUNML_ARGCACHE_JACOBIAN (SUNML_ARGCACHE_SIZE - 2)
+
+value sunml_argcache_block(value vcache, int slot, mlsize_t size);
+value sunml_argcache_realarray(value vcache, int slot,
+			       realtype *data, intnat n);
+void sunml_argcache_release_realarray(value vcache, int slot, value vba);
+
+/* Profiling counters (Sundials.profile).
+ *
+ * Profiling is enabled per session with sunml_sundials_set_profiling,
+ * which places a custom block in the SUNML_ARGCACHE_PROFILE slot of the
+ * session's argument cache.  The block wraps a malloc'ed struct
+ * sunml_profile, so the pointer to it remains valid across callbacks into
+ * OCaml, and is only stored once that struct exists: a block in the slot
+ * never holds NULL.  The categories must be listed in the same order as the fields of
+ * Sundials.profile.
+ *
+ * sunml_profile_start returns NULL if profiling is disabled and otherwise
+ * reads the monotonic clock into *t0.  sunml_profile_stop does nothing when
+ * given NULL and otherwise adds a call and the time elapsed since t0 to the
+ * given category.  Neither function allocates in the OCaml heap, so they
+ * may be called while holding the unrooted result of a callback.  The
+ * SUNML_PROFILE_BEGIN and SUNML_PROFILE_END macros wrap them for use in
+ * the callback trampolines; BEGIN declares local variables and must appear
+ * at most once per block.
+ *
+ * The same block optionally holds a trace (Sundials.Trace): a ring buffer
+ * that is enabled with sunml_sundials_set_tracing and in which
+ * sunml_profile_stop also records each call with its start time and
+ * duration.  When the buffer is full, the oldest events are overwritten.
+ * The solver stubs add samples of the step size and of the main counters
+ * with sunml_trace_counter, and mark root returns with sunml_trace_roots,
+ * after each call to the solver.  Events are only ever added by the
+ * thread running the session, so no locking is needed.  None of these
+ * functions allocate in the OCaml heap.  The event types and the counters
+ * must be listed in the same order as the constructors of
+ * Sundials.Trace.event and Sundials.Trace.counter.  */
+enum sunml_profile_category {
+    SUNML_PROFILE_SOLVER = 0,
+    SUNML_PROFILE_RHS,
+    SUNML_PROFILE_JAC,
+    SUNML_PROFILE_PREC_SETUP,
+    SUNML_PROFILE_PREC_SOLVE,
+    SUNML_PROFILE_JAC_TIMES,
+    SUNML_PROFILE_SIZE		/* This has to come last.  */
+};
+
+enum sunml_trace_event_type {
+    SUNML_TRACE_CALL = 0,
+    SUNML_TRACE_COUNTER,
+    SUNML_TRACE_ROOTS
+};
+
+enum sunml_trace_counter {
+    SUNML_TRACE_STEP_SIZE = 0,
+    SUNML_TRACE_STEPS,
+    SUNML_TRACE_ERR_TEST_FAILS,
+    SUNML_TRACE_NONLIN_ITERS
+};
+
+struct sunml_trace_event {
+    long long start;		/* nanoseconds */
+    long long duration;		/* nanoseconds, for SUNML_TRACE_CALL */
+    double value;		/* for SUNML_TRACE_COUNTER */
+    int type;
+    int id;			/* category or counter */
+};
+
+struct sunml_recorder;
+
+struct sunml_profile {
+    int enabled;
+    long calls[SUNML_PROFILE_SIZE];
+    long long nanoseconds[SUNML_PROFILE_SIZE];
+
+    struct sunml_trace_event *trace;	/* NULL if tracing is disabled */
+    unsigned long trace_capacity;
+    unsigned long trace_next;		/* the number of events recorded */
+
+    struct sunml_recorder *recorder;	/* NULL if none is attached */
+};
+
+struct sunml_profile *sunml_profile_start(value vcache, long long *t0);
+void sunml_profile_stop(struct sunml_profile *prof, int category,
+			long long t0);
+
+#define sunml_trace_enabled(prof) ((prof) != NULL && (prof)->trace != NULL)
+void sunml_trace_counter(struct sunml_profile *prof, int counter,
+			 double value);
+void sunml_trace_roots(struct sunml_profile *prof);
+
+/* Trajectory recorders (Sundials.Recorder) are also attached to the
+ * profiling block, with sunml_sundials_set_recorder.  After each successful
+ * call to the solver, the stubs obtain the recorder with sunml_recorder_of,
+ * which returns NULL if none is attached or if it has been closed, and
+ * append the time and the payload of the solution vector, which must be a
+ * float bigarray, with sunml_recorder_append.  The step size and order are
+ * only needed if sunml_recorder_steps is true.  The data is copied into a
+ * chunk that a background thread writes once it is full.  Neither function
+ * allocates in the OCaml heap.  */
+struct sunml_recorder *sunml_recorder_of(value vcache);
+int sunml_recorder_steps(struct sunml_recorder *rec);
+void sunml_recorder_append(struct sunml_recorder *rec, double t,
+			   value vpayload, double h, double q);
+
+#define SUNML_PROFILE_BEGIN(vcache)					\
+    long long sunml_profile_t0;						\
+    struct sunml_profile *sunml_profile =				\
+	sunml_profile_start((vcache), &sunml_profile_t0)
+#define SUNML_PROFILE_END(category)					\
+    sunml_profile_stop(sunml_profile, (category), sunml_profile_t0)
+
 /* Generate trampolines needed for functions with >= 6 arguments.  */
 #define COMMA ,
 #define BYTE_STUB(fcn_name, extras)				\
@@ -0,0 +1,107 @@
+(***********************************************************************)
+(*                                                                     *)
+(*                   OCaml interface to Sundials                       *)
+(*                                                                     *)
+(*  Timothy Bourke (Inria), Jun Inoue (Inria), and Marc Pouzet (LIENS) *)
+(*                                                                     *)
+(*  Copyright 2020 Institut National de Recherche en Informatique et   *)
+(*  en Automatique.  All rights reserved.  This file is distributed    *)
+(*  under a New BSD License, refer to the file LICENSE.                *)
+(*                                                                     *)
+(***********************************************************************)
+
+open Sundials
+
+(* Repeated integrations with reinitialized sessions, shared by the
+   Ensemble and Parareal submodules of Cvode and of the Arkode
+   time-stepping modules.
+   A session is manipulated through two functions: reinit s t0 y restarts
+   it from y at t0, and solve_to s tout y integrates it to tout,
+   continuing past any roots.  *)
+
+let ensemble ~reinit ~solve_to ?(prepare=fun _ -> ()) ?failed
+             s ~t0 ~y0 ~tout y yout =
+  let yd = Nvector.unwrap y in
+  let nr, nc = RealArray2.size y0 in
+  if Sundials_configuration.safe
+     && (nr <> RealArray.length yd || RealArray2.size yout <> (nr, nc))
+  then invalid_arg "Ensemble.solve: array sizes do not match";
+  for i = 0 to nc - 1 do
+    RealArray.blit ~src:(RealArray2.col y0 i) ~dst:yd;
+    (try
+       prepare i;
+       reinit s t0 y;
+       solve_to s tout y
+     with e ->
+       match failed with
+       | None -> raise e
+       | Some f -> f i e);
+    RealArray.blit ~src:yd ~dst:(RealArray2.col yout i)
+  done
+
+let parareal_coarse ~reinit ~solve_to ~set_fixed_step ~steps s y t0 t1 v =
+  let yd = Nvector.unwrap y in
+  RealArray.blit ~src:v ~dst:yd;
+  reinit s t0 y;
+  set_fixed_step s (Some ((t1 -. t0) /. float_of_int steps));
+  solve_to s t1 y;
+  RealArray.blit ~src:yd ~dst:v
+
+let map_fine_sequentially y job k m =
+  for i = k to m - 1 do job i y done
+
+let parareal ~reinit ~solve_to ?max_iters ?map_fine ~coarse ~tol
+             fine ts y u =
+  let yd = Nvector.unwrap y in
+  let n = RealArray.length yd in
+  let m = RealArray.length ts - 1 in
+  if Sundials_configuration.safe
+     && (m < 1 || Array.length fine <> m || RealArray2.size u <> (n, m + 1))
+  then invalid_arg "Parareal.solve: array sizes do not match";
+  let max_iters = match max_iters with Some k -> k | None -> m in
+  let map_fine =
+    match map_fine with Some f -> f | None -> map_fine_sequentially y
+  in
+  (* g holds the coarse values, and f the fine values, of the slices
+     started from the last iterate.  *)
+  let g = RealArray2.create n m
+  and f = RealArray2.create n m in
+  for i = 0 to m - 1 do
+    let gi = RealArray2.col g i in
+    RealArray.blit ~src:(RealArray2.col u i) ~dst:gi;
+    coarse ts.{i} ts.{i + 1} gi;
+    RealArray.blit ~src:gi ~dst:(RealArray2.col u (i + 1))
+  done;
+  (* Each fine solve only reads column i of u and writes column i of f, so
+     that they may be run in any order, or in parallel.  *)
+  let fine_solve i yi =
+    let ydi = Nvector.unwrap yi in
+    if Sundials_configuration.safe && RealArray.length ydi <> n
+    then invalid_arg "Parareal.solve: array sizes do not match";
+    RealArray.blit ~src:(RealArray2.col u i) ~dst:ydi;
+    reinit fine.(i) ts.{i} yi;
+    solve_to fine.(i) ts.{i + 1} yi;
+    RealArray.blit ~src:ydi ~dst:(RealArray2.col f i)
+  in
+  (* After k iterations, the first k slices start from exact values and
+     need not be solved again.  *)
+  let rec iterate k =
+    map_fine fine_solve k m;
+    let delta = ref 0.0 in
+    for i = k to m - 1 do
+      let fi = RealArray2.col f i
+      and gi = RealArray2.col g i
+      and ui = RealArray2.col u (i + 1) in
+      RealArray.blit ~src:(RealArray2.col u i) ~dst:yd;
+      coarse ts.{i} ts.{i + 1} yd;
+      for j = 0 to n - 1 do
+        let v = yd.{j} +. fi.{j} -. gi.{j} in
+        delta := max !delta (abs_float (v -. ui.{j}));
+        ui.{j} <- v;
+        gi.{j} <- yd.{j}
+      done
+    done;
+    if !delta <= tol || k + 1 >= max_iters then k + 1, !delta
+    else iterate (k + 1)
+  in
+  iterate 0
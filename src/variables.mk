@@ -32,6 +32,7 @@ COBJ_MAIN = $(COBJ_COMMON) kinsol/kinsol_ml$(XO) $(ARKODE_COBJ_MAIN)
 MLOBJ_MAIN =	sundials/sundials_configuration.cmo	\
 		sundials/sundials_impl.cmo		\
 		sundials/sundials_Index.cmo		\
+		sundials/sundials_Precision.cmo		\
 		sundials/sundials_Config.cmo		\
 		sundials/sundials_RealArray.cmo		\
 		sundials/sundials_RealArray2.cmo	\
@@ -39,7 +40,9 @@ MLOBJ_MAIN =	sundials/sundials_configuration.cmo	\
 		sundials/sundials_Logfile.cmo		\
 	     	sundials/sundials.cmo			\
 		nvectors/nvector.cmo			\
+		sundials/sundials_sweep_impl.cmo	\
 		nvectors/nvector_serial.cmo		\
+		nvectors/nvector_dual.cmo		\
 		lsolvers/sundials_Matrix.cmo		\
 		lsolvers/sundials_LinearSolver_impl.cmo	\
 		lsolvers/sundials_LinearSolver.cmo	\
@@ -47,6 +50,7 @@ MLOBJ_MAIN =	sundials/sundials_configuration.cmo	\
 		lsolvers/sundials_NonlinearSolver.cmo	\
 		nvectors/nvector_custom.cmo		\
 		nvectors/nvector_array.cmo		\
+		nvectors/nvector_many.cmo		\
 		cvode/cvode_impl.cmo			\
 		ida/ida_impl.cmo			\
 		kinsol/kinsol_impl.cmo			\
@@ -118,6 +122,11 @@ COBJ_OPENMP =	nvectors/nvector_openmp_ml$(XO)
 MLOBJ_OPENMP =	nvectors/nvector_openmp.cmo
 CMI_OPENMP =	$(MLOBJ_OPENMP:.cmo=.cmi)
 
+### Objects specific to sundials_cuda.cma.
+COBJ_CUDA =	nvectors/nvector_cuda_ml$(XO)
+MLOBJ_CUDA =	nvectors/nvector_cuda.cmo
+CMI_CUDA =	$(MLOBJ_CUDA:.cmo=.cmi)
+
 ### Objects specific to sundials_top_*.cma.
 
 MLOBJ_TOP = sundials/sundials_top.cmo		\
@@ -152,14 +161,15 @@ CMA_TOP_ALL = sundials_top.cma sundials_top_mpi.cma		\
 # For `make clean'.  All object files, including ones that may not be
 # built/updated under the current configuration.  Duplicates OK.
 ALL_COBJ = $(COBJ_MAIN) $(COBJ_SENS) $(COBJ_NO_SENS) $(COBJ_MPI) \
-	   $(COBJ_OPENMP) $(COBJ_PTHREADS)
+	   $(COBJ_OPENMP) $(COBJ_PTHREADS) $(COBJ_CUDA)
 ALL_MLOBJ =doc/dochtml.cmo					\
 	   $(MLOBJ_MAIN)					\
 	   $(MLOBJ_SENS) $(MLOBJ_NO_SENS) $(MLOBJ_MPI)		\
-	   $(MLOBJ_OPENMP) $(MLOBJ_PTHREADS)			\
+	   $(MLOBJ_OPENMP) $(MLOBJ_PTHREADS) $(MLOBJ_CUDA)	\
 	   $(MLOBJ_TOP_ALL)
 ALL_CMA = sundials.cma sundials_no_sens.cma sundials_mpi.cma	\
 	  sundials_openmp.cma sundials_pthreads.cma		\
+	  sundials_cuda.cma					\
 	  sundials_docs.cma sundials_docs.cmxs			\
 	  $(CMA_TOP_ALL)
 
@@ -170,7 +180,8 @@ ALL_CMA = sundials.cma sundials_no_sens.cma sundials_mpi.cma	\
 CMA_OF_CMO_CMX_COBJ=sundials.cma sundials_no_sens.cma			\
 		    $(if $(MPI_ENABLED),sundials_mpi.cma)		\
 		    $(if $(OPENMP_ENABLED),sundials_openmp.cma)		\
-		    $(if $(PTHREADS_ENABLED),sundials_pthreads.cma)
+		    $(if $(PTHREADS_ENABLED),sundials_pthreads.cma)	\
+		    $(if $(CUDA_ENABLED),sundials_cuda.cma)
 
 # Libraries made by linking .cmo files, yielding foo.cma.
 # sundials_top_findlib.cma is built and installed only when the
@@ -191,13 +202,15 @@ INSTALL_CMI=$(CMI_MAIN) $(CMI_SENS)			\
 	    $(if $(TOP_ENABLED),$(CMI_TOP))		\
 	    $(if $(MPI_ENABLED),$(CMI_MPI))		\
 	    $(if $(PTHREADS_ENABLED),$(CMI_PTHREADS))	\
-	    $(if $(OPENMP_ENABLED),$(CMI_OPENMP))
+	    $(if $(OPENMP_ENABLED),$(CMI_OPENMP))	\
+	    $(if $(CUDA_ENABLED),$(CMI_CUDA))
 
 INSTALL_CMX=$(MLOBJ_MAIN:.cmo=.cmx) $(MLOBJ_SENS:.cmo=.cmx)	  \
 	    $(MLOBJ_NO_SENS:.cmo=.cmx)				  \
 	    $(if $(MPI_ENABLED),$(MLOBJ_MPI:.cmo=.cmx))		  \
 	    $(if $(PTHREADS_ENABLED),$(MLOBJ_PTHREADS:.cmo=.cmx)) \
-	    $(if $(OPENMP_ENABLED),$(MLOBJ_OPENMP:.cmo=.cmx))
+	    $(if $(OPENMP_ENABLED),$(MLOBJ_OPENMP:.cmo=.cmx))	  \
+	    $(if $(CUDA_ENABLED),$(MLOBJ_CUDA:.cmo=.cmx))
 
 INSTALL_MLI=$(CMI_MAIN:.cmi=.mli) $(CMI_SENS:.cmi=.mli)
 